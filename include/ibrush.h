@@ -81,6 +81,9 @@ public:
 
 	virtual const Plane3& getPlane3() const = 0;
 
+	// Replaces the plane of this face, the winding is rebuilt on the next brush evaluation
+	virtual void setPlane3(const Plane3& plane) = 0;
+
 	/**
 	 * Returns the 3x3 texture matrix for this face, containing shift, scale and rotation.
 	 *
@@ -88,6 +91,9 @@ public:
 	 * tx and ty hold the shift
 	 */
 	virtual Matrix4 getTexDefMatrix() const = 0;
+
+	// Replaces the texture matrix of this face, using the layout of getTexDefMatrix()
+	virtual void setTexDefMatrix(const Matrix4& matrix) = 0;
 };
 
 // Brush Interface
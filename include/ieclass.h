@@ -51,13 +51,14 @@ class AABB;
  */
 class EntityClassAttribute
 {
-private:
+public:
     /**
      * String references are shared_ptrs to save memory.
-     * The actual string might be owned by another entity class we're inheriting from.
+     * The actual string might be shared with other attributes and entity classes.
      */
     typedef std::shared_ptr<std::string> StringPtr;
 
+private:
     // Reference to the name string
     StringPtr _typeRef;
 
@@ -177,6 +178,21 @@ public:
       inherited(false)
     {}
 
+    /**
+     * Construct a non-inherited EntityClassAttribute referencing the given
+     * (possibly shared) strings.
+     */
+    EntityClassAttribute(const StringPtr& typeRef,
+                         const StringPtr& nameRef,
+                         const StringPtr& valueRef,
+                         const StringPtr& descRef)
+    : _typeRef(typeRef),
+      _nameRef(nameRef),
+      _valueRef(valueRef),
+      _descRef(descRef),
+      inherited(false)
+    {}
+
     /**
      * Construct a inherited EntityClassAttribute with a true inherited flag.
      * The strings are taken from the inherited attribute.
@@ -270,14 +286,17 @@ public:
      * The name of the EntityClassAttribute to find, interpreted case-insensitively.
      *
      * @return
-     * A reference to the named EntityClassAttribute. If the named attribute is
-     * not found, an empty EntityClassAttribute is returned.
+     * A reference to the named EntityClassAttribute. If this class doesn't
+     * define the attribute itself, the one of the closest parent class defining
+     * it is returned. If the named attribute is not found, an empty
+     * EntityClassAttribute is returned. The attributes of the parent classes
+     * are shared with all subclasses, so they can only be read.
      */
-    virtual EntityClassAttribute& getAttribute(const std::string& name) = 0;
     virtual const EntityClassAttribute& getAttribute(const std::string& name) const = 0;
 
     /**
-     * Enumerate the EntityClassAttibutes in turn.
+     * Enumerate the EntityClassAttibutes in turn, including the ones inherited
+     * from the parent classes, which are passed with their inherited flag set.
      *
      * \param visitor
      * Function that will be invoked for each EntityClassAttibute.
@@ -7,6 +7,7 @@
  */
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <list>
 #include <set>
@@ -89,6 +90,34 @@ struct FileInfo
     }
 };
 
+/// Identifies the version of a file in the virtual filesystem by the physical
+/// file it has been loaded from: either the PK4 containing it or the loose file.
+struct FileStamp
+{
+    /// Absolute path of the PK4 or the loose file, empty if the file doesn't exist
+    std::string physicalPath;
+
+    /// Size and modification time of the physical file
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+
+    bool empty() const
+    {
+        return physicalPath.empty();
+    }
+
+    bool operator== (const FileStamp& rhs) const
+    {
+        return physicalPath == rhs.physicalPath && size == rhs.size
+            && modificationTime == rhs.modificationTime;
+    }
+
+    bool operator!= (const FileStamp& rhs) const
+    {
+        return !operator==(rhs);
+    }
+};
+
 /**
  * Main interface for the virtual filesystem.
  *
@@ -186,6 +215,10 @@ public:
 	/// \brief Returns the absolute filename for a relative \p name, or "" if not found.
 	virtual std::string findFile(const std::string& name) = 0;
 
+	/// \brief Returns the stamp of the physical file the given relative \p filename
+	/// would be opened from. The stamp is empty if the file is not found.
+	virtual FileStamp getFileStamp(const std::string& filename) = 0;
+
 	/// \brief Returns the filesystem root for an absolute \p name, or "" if not found.
 	/// This can be used to convert an absolute name to a relative name.
 	virtual std::string findRoot(const std::string& name) = 0;
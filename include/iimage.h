@@ -76,6 +76,23 @@ public:
 	virtual bool isPrecompressed() const {
 		return false;
 	}
+
+	/**
+	 * \brief
+	 * Upload the pixel data into the existing GL texture object with the
+	 * given number, replacing its previous contents. This is used to fill
+	 * textures which have been handed out before the image was loaded.
+	 *
+	 * \param firstMipLevel
+	 * The mipmap to use as the base level of the texture, 0 uploads the image
+	 * at full resolution. Each level halves the width and height.
+	 *
+	 * \return
+	 * false if the image could not be uploaded, e.g. due to an unsupported
+	 * compression format.
+	 */
+	virtual bool uploadTexture(GLuint textureNum, const std::string& name,
+							   std::size_t firstMipLevel) const = 0;
 };
 typedef std::shared_ptr<Image> ImagePtr;
 
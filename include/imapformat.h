@@ -121,6 +121,21 @@ public:
 	// Patch export methods
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) = 0;
 	virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) = 0;
+
+	/**
+	 * Creates a writer of the same format for a part of the map, which can be
+	 * written to its own stream concurrently with other parts. The new writer
+	 * continues as if entityCount entities had been started before the part and
+	 * primitiveCount primitives had been written in the current entity, such
+	 * that concatenating the parts yields the same output as a single writer.
+	 *
+	 * Writers which can't split their output return an empty pointer (which is
+	 * the default), the map is then written by this instance in one go.
+	 */
+	virtual std::shared_ptr<IMapWriter> createPartWriter(std::size_t entityCount, std::size_t primitiveCount)
+	{
+		return std::shared_ptr<IMapWriter>();
+	}
 };
 typedef std::shared_ptr<IMapWriter> IMapWriterPtr;
 
@@ -86,6 +86,20 @@ public:
 	 * Returns the float values of the given frame index.
 	 */
 	virtual const FrameKeys& getFrameKeys(std::size_t index) const = 0;
+
+	/**
+	 * Returns true if the frames have been decoded into one key per joint,
+	 * which saves applying the animated components to the base frame.
+	 */
+	virtual bool hasDecodedFrames() const = 0;
+
+	/**
+	 * Returns the origin and the normalised orientation of the given joint
+	 * in the given frame, relative to its parent joint. The orientations of
+	 * consecutive frames lie in the same hemisphere, such that they can be
+	 * interpolated linearly. Only available if hasDecodedFrames() returns true.
+	 */
+	virtual Key getDecodedKey(std::size_t frame, std::size_t jointNum) const = 0;
 };
 typedef std::shared_ptr<IMD5Anim> IMD5AnimPtr;
 
@@ -98,6 +112,12 @@ public:
 	 * the file does not exist or the anim was found to be invalid.
 	 */
 	virtual IMD5AnimPtr getAnim(const std::string& vfsPath) = 0;
+
+	/**
+	 * Starts parsing the given animation on a worker thread, unless it is
+	 * cached already. A later getAnim() call picks up the result.
+	 */
+	virtual void prefetchAnim(const std::string& vfsPath) = 0;
 };
 
 const char* const MODULE_ANIMATIONCACHE("MD5AnimationCache");
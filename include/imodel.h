@@ -66,6 +66,11 @@ public:
 	 */
 	virtual int getPolyCount() const = 0;
 
+	/** Return the number of bytes the vertex and index data of this model's
+	 * surfaces occupy in the renderer's buffers.
+	 */
+	virtual std::size_t getRenderMemoryUsage() const = 0;
+
 	/**
      * \brief
      * Return a vector of strings listing the active materials used in this
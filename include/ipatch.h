@@ -138,6 +138,10 @@ public:
 	// Updates the patch tesselation matrix, call this everytime you're done with your PatchControl changes
 	virtual void controlPointsChanged() = 0;
 
+	// Saves the current state to the undo stack.
+	// Call this before manipulating the control points to make your action undo-able.
+	virtual void undoSave() = 0;
+
 	// Check if the patch has invalid control points or width/height are zero
 	virtual bool isValid() const = 0;
 
@@ -184,6 +184,15 @@ public:
     /// Return true if this light intersects the given AABB
 	virtual bool intersectsAABB(const AABB& aabb) const = 0;
 
+    /**
+     * \brief
+     * Return a world-space AABB enclosing the whole light volume.
+     *
+     * The renderer uses this to find the objects which might be touched by
+     * the light, intersectsAABB() performs the exact test.
+     */
+    virtual AABB getLightAABB() const = 0;
+
     /**
      * \brief
      * Return the light origin in world space.
@@ -230,6 +239,9 @@ public:
     /// Test if the given light intersects the LitObject
     virtual bool intersectsLight(const RendererLight& light) const = 0;
 
+    /// Return the world-space bounds used to find the lights near this object
+    virtual const AABB& getLitObjectAABB() const = 0;
+
     /// Add a light to the set of lights which do intersect this object
     virtual void insertLight(const RendererLight& light) {}
 
@@ -270,11 +282,14 @@ typedef std::function<void(const RendererLight&)> RendererLightCallback;
  * it invokes LightList::calculateIntersectingLights() on the stored LightList
  * reference.
  * 4. calculateIntersectingLights() first checks to see if the lights need
- * updating, which is true if EITHER this LightList's setDirty() method OR the
- * RenderSystem's lightChanged() has been called since the last calculation. If
- * no update is needed, it returns.
- * 5. If an update IS needed, the LightList iterates over all lights in the
- * scene, and tests if each one intersects its associated lit object (which is
+ * updating, which is true if EITHER this LightList's setDirty() method has
+ * been called OR the RenderSystem's lightChanged() has been called for a light
+ * whose previous or current volume (getLightAABB()) touches the object's
+ * getLitObjectAABB() since the last calculation. If no update is needed, it
+ * returns.
+ * 5. If an update IS needed, the LightList looks up the lights whose volume
+ * touches the object's bounds in the renderer's spatial light index, and tests
+ * if each one intersects its associated lit object (which is
  * the one that just invoked calculateIntersectingLights(), although nothing
  * enforces this). This intersection test is performed by passing the light to
  * the LitObject::intersectsLight() method.
@@ -112,6 +112,16 @@ public:
 	// Same as above, but culls any hidden nodes
 	virtual void foreachVisibleNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor) = 0;
 
+	/**
+	 * Visit the visible nodes in the given volume front to back, ordered by the nearest
+	 * normalised device depth [-1..1] of their bounds. Nodes with bounds outside the
+	 * volume are not visited at all. Before visiting the next node, the
+	 * depth functor is called with the depth no remaining node can be in front of.
+	 * The traversal stops as soon as either the walker or the depth functor returns false.
+	 */
+	virtual void foreachVisibleNodeFrontToBack(const VolumeTest& volume, Walker& walker,
+		const std::function<bool(double)>& continueAtDepth) = 0;
+
 	// Returns the associated spacepartition
 	virtual ISpacePartitionSystemPtr getSpacePartition() = 0;
 };
@@ -49,6 +49,11 @@ public:
 	{
 		return _depth;
 	}
+
+	float distance() const
+	{
+		return _distance;
+	}
 	
 	bool isValid() const
 	{
@@ -412,6 +412,20 @@ public:
      */
     virtual void setActiveShaderUpdates(bool val) = 0;
 
+    /**
+     * Signal emitted on the main thread when textures which have been loaded
+     * in the background are ready for uploadPendingTextures(). Views showing
+     * textures should redraw themselves.
+     */
+    virtual sigc::signal<void>& signal_texturesPending() = 0;
+
+    /**
+     * Upload a limited number of the textures loaded in the background,
+     * which are showing a placeholder image until then. This must be called
+     * with the GL context being current, e.g. at the beginning of a frame.
+     */
+    virtual void uploadPendingTextures() = 0;
+
   virtual void setLightingEnabled(bool enabled) = 0;
 
   virtual const char* getTexturePrefix() const = 0;
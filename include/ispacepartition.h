@@ -1,7 +1,6 @@
 #ifndef _ISPACE_PARTITION_H_
 #define _ISPACE_PARTITION_H_
 
-#include <list>
 #include <vector>
 #include "imodule.h"
 
@@ -43,8 +42,8 @@ public:
 	// The child nodes
 	typedef std::vector<ISPNodePtr> NodeList;
 
-	// The members
-	typedef std::list<INodePtr> MemberList;
+	// The members (in no particular order)
+	typedef std::vector<INodePtr> MemberList;
 
 	// Get the parent node (can be NULL for the root node)
 	virtual ISPNodePtr getParent() const = 0;
@@ -75,6 +74,7 @@ typedef std::shared_ptr<ISPNode> ISPNodePtr;
  * Note: It's not allowed to call link() for nodes which are already linked into the tree.
  * It's safe to call unlink() for any node at any time, even multiple times in a row.
  * The unlink() method will return true if the node had been linked before.
+ * After the bounds of a linked node changed, relink() moves it to the ISPNode it fits best.
  */
 class ISpacePartitionSystem
 {
@@ -88,6 +88,13 @@ public:
 	// (node had been linked before)
 	virtual bool unlink(const scene::INodePtr& sceneNode) = 0;
 
+	// Updates the position of a linked node after its bounds changed. Returns false
+	// if the node is not linked (in which case nothing happens)
+	virtual bool relink(const scene::INodePtr& sceneNode) = 0;
+
+	// Relinks a batch of nodes whose bounds changed, unlinked nodes are ignored
+	virtual void relink(const std::vector<scene::INodePtr>& sceneNodes) = 0;
+
 	// Returns the root node of this SP tree (the largest one, encompassing everything)
 	virtual ISPNodePtr getRoot() const = 0;
 };
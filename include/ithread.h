@@ -1,6 +1,100 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <future>
+#include <memory>
+
+/**
+ * \brief
+ * Snapshot of the counters maintained by the TaskScheduler.
+ */
+struct TaskStatistics
+{
+	// Number of worker threads of the pool
+	std::size_t numWorkers;
+
+	// Number of tasks waiting to be picked up by a worker
+	std::size_t queueDepth;
+
+	// Number of tasks executed so far
+	std::size_t tasksExecuted;
+
+	// Accumulated and maximum execution time of the executed tasks
+	std::chrono::microseconds totalTaskTime;
+	std::chrono::microseconds longestTaskTime;
+};
+
+/**
+ * \brief
+ * Process-wide task scheduler, distributing tasks over a fixed number of
+ * worker threads. Tasks queued by a worker are preferably executed by that
+ * same worker, idle workers are stealing tasks from the busy ones.
+ *
+ * Tasks may queue further tasks and wait for them, worker threads are
+ * executing other queued tasks while waiting instead of blocking the pool.
+ */
+class TaskScheduler
+{
+public:
+	typedef std::function<void()> Task;
+
+	virtual ~TaskScheduler() {}
+
+	/// Returns the number of worker threads
+	virtual std::size_t getNumWorkers() const = 0;
+
+	/// Queues the given task for execution on one of the worker threads.
+	/// Any exception thrown by the task is swallowed, use submit() to get hold of it.
+	virtual void enqueue(Task task) = 0;
+
+	/// Calls func(i) for every index i in [0, count), distributing the calls
+	/// over the worker threads and the calling thread. Returns when all calls
+	/// are done, the first exception thrown by func is re-thrown.
+	virtual void parallelFor(std::size_t count, const std::function<void(std::size_t)>& func) = 0;
+
+	/// Returns true if the calling thread is one of the workers of this scheduler
+	virtual bool isWorkerThread() const = 0;
+
+	/// Executes one of the queued tasks on the calling worker thread.
+	/// Returns false if no task was available or the caller is not a worker.
+	virtual bool executePendingTask() = 0;
+
+	/// Returns the current queue depth and the timing counters
+	virtual TaskStatistics getStatistics() const = 0;
+
+	/// Queues the given function and returns the future holding its result
+	template<typename ReturnType>
+	std::shared_future<ReturnType> submit(const std::function<ReturnType()>& func)
+	{
+		auto task = std::make_shared<std::packaged_task<ReturnType()>>(func);
+		std::shared_future<ReturnType> result = task->get_future().share();
+
+		enqueue([task]() { (*task)(); });
+
+		return result;
+	}
+
+	/// Waits for the given future to become ready. If called by a worker
+	/// thread, the worker executes other tasks in the meantime.
+	template<typename ReturnType>
+	void waitFor(const std::shared_future<ReturnType>& future)
+	{
+		if (!isWorkerThread())
+		{
+			future.wait();
+			return;
+		}
+
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (!executePendingTask())
+			{
+				future.wait_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+};
 
 /**
  * \brief
@@ -19,4 +113,7 @@ public:
 
 	// Returns true if the given thread is still running
 	virtual bool threadIsRunning(std::size_t threadId) = 0;
+
+	/// Returns the task scheduler shared by all modules
+	virtual TaskScheduler& getTaskScheduler() = 0;
 };
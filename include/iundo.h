@@ -19,6 +19,13 @@ class IUndoMemento
 {
 public:
     virtual ~IUndoMemento() {}
+
+	// Returns the approximate number of bytes occupied by this memento,
+	// used by the UndoSystem to keep the undo stack within its memory budget
+	virtual std::size_t getMemoryUsage() const
+	{
+		return sizeof(IUndoMemento);
+	}
 };
 typedef std::shared_ptr<IUndoMemento> IUndoMementoPtr;
 
@@ -30,6 +37,12 @@ typedef std::shared_ptr<IUndoMemento> IUndoMementoPtr;
  *
  * The importState() method should re-import the values saved in the
  * UndoMemento
+ *
+ * When the operation is finished, compactState() is called with the
+ * exported memento, giving the Undoable a chance to replace it with a
+ * smaller one only holding the parts that differ from its current state.
+ * Such a delta memento is only ever imported on top of that very state,
+ * since the operations are undone and redone in order.
  */
 class IUndoable
 {
@@ -37,6 +50,13 @@ public:
     virtual ~IUndoable() {}
 	virtual IUndoMementoPtr exportState() const = 0;
 	virtual void importState(const IUndoMementoPtr& state) = 0;
+
+	// Returns the memento to keep for the given exported state. An empty
+	// pointer indicates that nothing has changed and the state can be dropped.
+	virtual IUndoMementoPtr compactState(const IUndoMementoPtr& state) const
+	{
+		return state;
+	}
 };
 
 /**
@@ -67,6 +87,10 @@ public:
 
 	virtual std::size_t size() const = 0;
 	virtual void start() = 0;
+
+	// Returns true if an operation has been started and not finished yet
+	virtual bool operationStarted() const = 0;
+
 	virtual void finish(const std::string& command) = 0;
 	virtual void undo() = 0;
 	virtual void redo() = 0;
@@ -116,15 +140,26 @@ inline IUndoSystem& GlobalUndoSystem()
 class UndoableCommand
 {
 	const std::string _command;
+
+	// Commands nested in an already started operation become part of it
+	bool _shouldFinish;
 public:
 
 	UndoableCommand(const std::string& command) :
-		_command(command)
+		_command(command),
+		_shouldFinish(false)
 	{
-		GlobalUndoSystem().start();
+		if (!GlobalUndoSystem().operationStarted())
+		{
+			GlobalUndoSystem().start();
+			_shouldFinish = true;
+		}
 	}
 
 	~UndoableCommand() {
-		GlobalUndoSystem().finish(_command);
+		if (_shouldFinish)
+		{
+			GlobalUndoSystem().finish(_command);
+		}
 	}
 };
@@ -23,6 +23,11 @@ public:
 	{
 		return _data;
 	}
+
+	std::size_t getMemoryUsage() const override
+	{
+		return sizeof(*this);
+	}
 };
 
 } // namespace
@@ -3,7 +3,9 @@
 #include "igl.h"
 #include "iimage.h"
 #include "BasicTexture2D.h"
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "util/Noncopyable.h"
 
 struct RGBAPixel
@@ -67,30 +69,99 @@ public:
 
 		// Allocate a new texture number and store it into the Texture structure
 		glGenTextures(1, &textureNum);
+
+		uploadTexture(textureNum, name, 0);
+
+        // Construct texture object
+        BasicTexture2DPtr tex2DObject(new BasicTexture2D(textureNum, name));
+        tex2DObject->setWidth(getWidth(0));
+        tex2DObject->setHeight(getHeight(0));
+
+		return tex2DObject;
+	}
+
+	bool uploadTexture(GLuint textureNum, const std::string& name, std::size_t firstMipLevel) const
+	{
+		std::size_t levelWidth = width;
+		std::size_t levelHeight = height;
+		std::vector<RGBAPixel> reduced;
+
+		if (firstMipLevel > 0)
+		{
+			reduced = getReducedPixels(firstMipLevel, levelWidth, levelHeight);
+		}
+
 		glBindTexture(GL_TEXTURE_2D, textureNum);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
 
+		// The texture object might have held a shorter mip chain before
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+
 		// Download the image to OpenGL
 		gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGBA,
-			static_cast<GLint>(getWidth(0)), static_cast<GLint>(getHeight(0)),
+			static_cast<GLint>(levelWidth), static_cast<GLint>(levelHeight),
 			GL_RGBA, GL_UNSIGNED_BYTE,
-			getMipMapPixels(0)
+			reduced.empty() ? getMipMapPixels(0) : reinterpret_cast<const byte*>(reduced.data())
 		);
 
 		// Un-bind the texture
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-        // Construct texture object
-        BasicTexture2DPtr tex2DObject(new BasicTexture2D(textureNum, name));
-        tex2DObject->setWidth(getWidth(0));
-        tex2DObject->setHeight(getHeight(0));
-
         debug::assertNoGlErrors();
 
-		return tex2DObject;
+		return true;
+	}
+
+	/**
+	 * Returns the pixels of the given mip level, each texel is the average
+	 * of the corresponding block of the full image. The dimensions of the
+	 * level are stored in levelWidth and levelHeight.
+	 */
+	std::vector<RGBAPixel> getReducedPixels(std::size_t level,
+		std::size_t& levelWidth, std::size_t& levelHeight) const
+	{
+		std::size_t blockSize = std::size_t(1) << std::min<std::size_t>(level, 15);
+
+		levelWidth = std::max<std::size_t>(width / blockSize, 1);
+		levelHeight = std::max<std::size_t>(height / blockSize, 1);
+
+		std::size_t blockWidth = width / levelWidth;
+		std::size_t blockHeight = height / levelHeight;
+		std::size_t blockPixels = blockWidth * blockHeight;
+
+		std::vector<RGBAPixel> reduced(levelWidth * levelHeight);
+
+		for (std::size_t y = 0; y < levelHeight; ++y)
+		{
+			for (std::size_t x = 0; x < levelWidth; ++x)
+			{
+				std::size_t sum[4] = { 0, 0, 0, 0 };
+
+				for (std::size_t by = 0; by < blockHeight; ++by)
+				{
+					const RGBAPixel* row = pixels + (y * blockHeight + by) * width + x * blockWidth;
+
+					for (std::size_t bx = 0; bx < blockWidth; ++bx)
+					{
+						sum[0] += row[bx].red;
+						sum[1] += row[bx].green;
+						sum[2] += row[bx].blue;
+						sum[3] += row[bx].alpha;
+					}
+				}
+
+				RGBAPixel& out = reduced[y * levelWidth + x];
+				out.red = static_cast<unsigned char>(sum[0] / blockPixels);
+				out.green = static_cast<unsigned char>(sum[1] / blockPixels);
+				out.blue = static_cast<unsigned char>(sum[2] / blockPixels);
+				out.alpha = static_cast<unsigned char>(sum[3] / blockPixels);
+			}
+		}
+
+		return reduced;
 	}
 
 	bool isPrecompressed() const
@@ -2,12 +2,19 @@
 
 #include <future>
 #include <functional>
+#include <mutex>
+#include <vector>
+
+#include "iradiant.h"
+#include "ithread.h"
 
 namespace util
 {
 
 /**
  * Helper class used to asynchronically parse/load def files in a separate thread.
+ * The worker function is queued as task of the shared TaskScheduler, it can
+ * use the scheduler to split up its work further (see parseFilesInParallel()).
  *
  * The worker thread itself is ensured to be called in a thread-safe 
  * way (to prevent the worker from being invoked twice). Subsequent calls to 
@@ -27,11 +34,15 @@ class ThreadedDefLoader
     std::shared_future<ReturnType> _result;
     std::mutex _mutex;
 
+    // The scheduler the worker function has been queued to
+    TaskScheduler* _scheduler;
+
     bool _loadingStarted;
 
 public:
     ThreadedDefLoader(const LoadFunction& loadFunc) :
         _loadFunc(loadFunc),
+        _scheduler(nullptr),
         _loadingStarted(false)
     {}
 
@@ -64,7 +75,10 @@ public:
         // Make sure we already started the loader
         ensureLoaderStarted();
 
-        // Wait for the result or return if it's already done.
+        // Wait for the result or return if it's already done. Within a task
+        // the worker thread keeps executing other tasks while waiting.
+        _scheduler->waitFor(_result);
+
         return _result.get();
     }
 
@@ -96,9 +110,45 @@ private:
         if (!_loadingStarted)
         {
             _loadingStarted = true;
-            _result = std::async(std::launch::async, _loadFunc);
+            _scheduler = &GlobalRadiant().getThreadManager().getTaskScheduler();
+            _result = _scheduler->submit(_loadFunc);
         }
     }
 };
 
+/**
+ * Parses the given files concurrently on the given scheduler, then merges
+ * the results in the order of the files vector. The outcome is the same as
+ * when parsing the files one after the other.
+ *
+ * The parse function is invoked from several threads at once and must not
+ * touch any shared state, the merge function is invoked on the calling thread.
+ */
+template<typename FileType, typename ResultType>
+void parseFilesInParallel(TaskScheduler& scheduler, const std::vector<FileType>& files,
+                          const std::function<ResultType(const FileType&)>& parseFunc,
+                          const std::function<void(const FileType&, ResultType&)>& mergeFunc)
+{
+    std::vector<ResultType> results(files.size());
+
+    scheduler.parallelFor(files.size(), [&](std::size_t i)
+    {
+        results[i] = parseFunc(files[i]);
+    });
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        mergeFunc(files[i], results[i]);
+    }
+}
+
+// Overload using the application's shared task scheduler
+template<typename FileType, typename ResultType>
+void parseFilesInParallel(const std::vector<FileType>& files,
+                          const std::function<ResultType(const FileType&)>& parseFunc,
+                          const std::function<void(const FileType&, ResultType&)>& mergeFunc)
+{
+    parseFilesInParallel(GlobalRadiant().getThreadManager().getTaskScheduler(), files, parseFunc, mergeFunc);
+}
+
 }
@@ -3,6 +3,7 @@
 #include "itextstream.h"
 #include "fs.h"
 #include "debugging/debugging.h"
+#include <cstdint>
 
 /// \file
 /// \brief OS file-system querying and manipulation.
@@ -113,4 +114,24 @@ inline std::size_t getFileSize(const std::string& path)
 	}
 }
 
+// Retrieves the size and the modification time of the given file, returns false on failure.
+// The time is only meant to be compared against other values returned by this function.
+inline bool getFileSizeAndTime(const std::string& path, uint64_t& fileSize, int64_t& modificationTime)
+{
+	try
+	{
+		fileSize = static_cast<uint64_t>(fs::file_size(path));
+#ifdef DR_USE_STD_FILESYSTEM
+		modificationTime = static_cast<int64_t>(fs::last_write_time(path).time_since_epoch().count());
+#else
+		modificationTime = static_cast<int64_t>(fs::last_write_time(path));
+#endif
+		return true;
+	}
+	catch (fs::filesystem_error&)
+	{
+		return false;
+	}
+}
+
 } // namespace
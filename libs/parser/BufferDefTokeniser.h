@@ -0,0 +1,541 @@
+#pragma once
+
+#include "DefTokeniser.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <iterator>
+
+namespace parser
+{
+
+/**
+ * Non-owning reference to a token returned by a BufferDefTokeniser.
+ * Points either into the tokenised buffer or into a scratch buffer of the
+ * tokeniser (for quoted tokens containing escape sequences).
+ */
+struct TokenView
+{
+	const char* data;
+	std::size_t length;
+
+	TokenView() :
+		data(""),
+		length(0)
+	{}
+
+	TokenView(const char* data_, std::size_t length_) :
+		data(data_),
+		length(length_)
+	{}
+
+	std::size_t size() const
+	{
+		return length;
+	}
+
+	bool empty() const
+	{
+		return length == 0;
+	}
+
+	// Returns a copy of this token
+	std::string str() const
+	{
+		return std::string(data, length);
+	}
+
+	bool operator==(const char* other) const
+	{
+		return std::strncmp(data, other, length) == 0 && other[length] == '\0';
+	}
+
+	bool operator!=(const char* other) const
+	{
+		return !operator==(other);
+	}
+
+	bool operator==(const std::string& other) const
+	{
+		return other.length() == length && other.compare(0, length, data, length) == 0;
+	}
+
+	bool operator!=(const std::string& other) const
+	{
+		return !operator==(other);
+	}
+
+	/**
+	 * Converts the token to a floating point value, without heap allocation.
+	 * Behaves like std::atof(): returns 0 if the token is not a number.
+	 */
+	double toDouble() const
+	{
+		char buffer[64];
+
+		if (length >= sizeof(buffer))
+		{
+			return std::atof(str().c_str());
+		}
+
+		std::memcpy(buffer, data, length);
+		buffer[length] = '\0';
+
+		return std::atof(buffer);
+	}
+
+	float toFloat() const
+	{
+		return static_cast<float>(toDouble());
+	}
+};
+
+inline std::ostream& operator<<(std::ostream& os, const TokenView& tok)
+{
+	return os.write(tok.data, tok.length);
+}
+
+/**
+ * DefTokeniser working on a contiguous, fully buffered character range,
+ * e.g. the contents of a file read into a std::string.
+ *
+ * This splits the input exactly like the BasicDefTokeniser (same handling
+ * of delimiters, quotes, escape sequences and comments), but avoids the
+ * per-character overhead of stream iterators. Tokens are located in-place:
+ * the TokenView returned by nextTokenView() references the input buffer
+ * directly, only quoted tokens with escape sequences or continuations are
+ * copied into a scratch buffer. The std::string-based DefTokeniser
+ * interface is still available for existing parsing code.
+ *
+ * The character range must stay valid for the lifetime of the tokeniser.
+ */
+class BufferDefTokeniser :
+	public DefTokeniser
+{
+private:
+	const char* _next;
+	const char* _end;
+
+	enum CharClass : unsigned char
+	{
+		NORMAL = 0,
+		DELIMITER,
+		KEPT_DELIMITER,
+	};
+
+	unsigned char _charClass[256];
+
+	// The prefetched token and whether it is valid
+	TokenView _current;
+	bool _hasToken;
+
+	// Two scratch buffers used alternately for tokens that need to be
+	// assembled, such that the previously returned view stays valid
+	std::string _scratch[2];
+	std::size_t _scratchIndex;
+
+public:
+	/**
+	 * Construct a tokeniser on top of the character range [begin, end).
+	 *
+	 * @param delims
+	 * The list of characters to use as delimiters.
+	 *
+	 * @param keptDelims
+	 * String of characters to treat as delimiters but return as tokens in their
+	 * own right.
+	 */
+	BufferDefTokeniser(const char* begin, const char* end,
+					   const char* delims = WHITESPACE,
+					   const char* keptDelims = "{}()") :
+		_next(begin),
+		_end(end),
+		_hasToken(false),
+		_scratchIndex(0)
+	{
+		std::memset(_charClass, NORMAL, sizeof(_charClass));
+
+		for (const char* c = keptDelims; *c != 0; ++c)
+		{
+			_charClass[static_cast<unsigned char>(*c)] = KEPT_DELIMITER;
+		}
+
+		// Regular delimiters take precedence, like in the DefTokeniserFunc
+		for (const char* c = delims; *c != 0; ++c)
+		{
+			_charClass[static_cast<unsigned char>(*c)] = DELIMITER;
+		}
+
+		advance();
+	}
+
+	// Construct a tokeniser on the given string, which must outlive this instance
+	BufferDefTokeniser(const std::string& buffer,
+					   const char* delims = WHITESPACE,
+					   const char* keptDelims = "{}()") :
+		BufferDefTokeniser(buffer.data(), buffer.data() + buffer.size(), delims, keptDelims)
+	{}
+
+	bool hasMoreTokens() const override
+	{
+		return _hasToken;
+	}
+
+	std::string nextToken() override
+	{
+		return nextTokenView().str();
+	}
+
+	void assertNextToken(const std::string& val) override
+	{
+		TokenView tok = nextTokenView();
+
+		if (tok != val)
+		{
+			throw ParseException("DefTokeniser: Assertion failed: Required \""
+				+ val + "\", found \"" + tok.str() + "\"");
+		}
+	}
+
+	void skipTokens(unsigned int n) override
+	{
+		for (unsigned int i = 0; i < n; i++)
+		{
+			nextTokenView();
+		}
+	}
+
+	std::string peek() const override
+	{
+		return peekView().str();
+	}
+
+	/**
+	 * Returns the next token without copying it. The returned view stays
+	 * valid until the next-but-one token has been consumed.
+	 */
+	TokenView nextTokenView()
+	{
+		if (!_hasToken)
+		{
+			throw ParseException("DefTokeniser: no more tokens");
+		}
+
+		TokenView tok = _current;
+		advance();
+
+		return tok;
+	}
+
+	// Returns the next token without consuming it
+	TokenView peekView() const
+	{
+		if (!_hasToken)
+		{
+			throw ParseException("DefTokeniser: no more tokens");
+		}
+
+		return _current;
+	}
+
+	// Consumes the next token and converts it using atof() semantics
+	float nextFloat()
+	{
+		return nextTokenView().toFloat();
+	}
+
+	double nextDouble()
+	{
+		return nextTokenView().toDouble();
+	}
+
+private:
+	bool isDelim(char c) const
+	{
+		return _charClass[static_cast<unsigned char>(c)] == DELIMITER;
+	}
+
+	bool isKeptDelim(char c) const
+	{
+		return _charClass[static_cast<unsigned char>(c)] == KEPT_DELIMITER;
+	}
+
+	void advance()
+	{
+		_hasToken = scanToken(_current);
+	}
+
+	// Searches the next token, mirroring the states of the DefTokeniserFunc
+	bool scanToken(TokenView& tok)
+	{
+		const char* tokenStart = nullptr;
+
+		while (_next != _end)
+		{
+			char c = *_next;
+
+			if (tokenStart == nullptr)
+			{
+				// SEARCHING
+				if (isDelim(c))
+				{
+					++_next;
+					continue;
+				}
+
+				if (isKeptDelim(c))
+				{
+					tok = TokenView(_next++, 1);
+					return true;
+				}
+
+				if (c == '"')
+				{
+					return scanQuoted(tok);
+				}
+
+				tokenStart = _next;
+			}
+
+			// TOKEN_STARTED
+			if (isDelim(c) || isKeptDelim(c) || c == '"')
+			{
+				break;
+			}
+
+			if (c == '/')
+			{
+				if (_next + 1 == _end)
+				{
+					// A trailing slash is not part of the token
+					++_next;
+					tok = TokenView(tokenStart, _next - 1 - tokenStart);
+					return tok.length > 0;
+				}
+
+				if (_next[1] == '/' || _next[1] == '*')
+				{
+					const char* tokenEnd = _next;
+					skipComment();
+
+					if (tokenEnd != tokenStart)
+					{
+						tok = TokenView(tokenStart, tokenEnd - tokenStart);
+						return true;
+					}
+
+					// Nothing collected so far, continue searching
+					tokenStart = nullptr;
+					continue;
+				}
+			}
+
+			++_next;
+		}
+
+		if (tokenStart != nullptr && _next != tokenStart)
+		{
+			tok = TokenView(tokenStart, _next - tokenStart);
+			return true;
+		}
+
+		return false;
+	}
+
+	// Skips a comment starting at the current position
+	void skipComment()
+	{
+		if (_next[1] == '/')
+		{
+			// EOL comment, the line break is consumed too
+			for (_next += 2; _next != _end; ++_next)
+			{
+				if (*_next == '\r' || *_next == '\n')
+				{
+					++_next;
+					break;
+				}
+			}
+		}
+		else
+		{
+			// Delimited comment, search for the closing */
+			for (_next += 2; _next != _end; ++_next)
+			{
+				if (*_next == '*' && _next + 1 != _end && _next[1] == '/')
+				{
+					_next += 2;
+					break;
+				}
+			}
+		}
+	}
+
+	// Parses quoted content, the current character is the opening quote
+	bool scanQuoted(TokenView& tok)
+	{
+		++_next; // skip the quote
+
+		// Try to locate the closing quote without encountering an escape,
+		// in which case the token can reference the buffer directly
+		const char* start = _next;
+		const char* cur = start;
+
+		while (cur != _end && *cur != '"' && *cur != '\\')
+		{
+			++cur;
+		}
+
+		std::string* scratch = nullptr;
+
+		if (cur != _end && *cur == '"')
+		{
+			tok = TokenView(start, cur - start);
+			_next = cur + 1;
+		}
+		else
+		{
+			// Escape sequence or unterminated string, assemble a copy
+			scratch = &nextScratch();
+			scratch->assign(start, cur - start);
+			_next = cur;
+
+			if (!appendQuoted(*scratch))
+			{
+				// End of input without closing quote
+				tok = TokenView(scratch->data(), scratch->size());
+				return !scratch->empty();
+			}
+		}
+
+		// AFTER_CLOSING_QUOTE: check for a backslash continuing the string
+		while (true)
+		{
+			while (_next != _end && isDelim(*_next))
+			{
+				++_next;
+			}
+
+			if (_next == _end)
+			{
+				// An empty quoted string at the end of input doesn't count
+				if (scratch != nullptr)
+				{
+					tok = TokenView(scratch->data(), scratch->size());
+				}
+
+				return tok.length > 0;
+			}
+
+			if (*_next != '\\')
+			{
+				break;
+			}
+
+			// SEARCHING_FOR_QUOTE
+			++_next;
+
+			while (_next != _end && isDelim(*_next))
+			{
+				++_next;
+			}
+
+			if (_next == _end)
+			{
+				if (scratch != nullptr)
+				{
+					tok = TokenView(scratch->data(), scratch->size());
+				}
+
+				return tok.length > 0;
+			}
+
+			if (*_next != '"')
+			{
+				throw ParseException("Could not find opening double quote after backslash.");
+			}
+
+			++_next;
+
+			// The continued string needs to be assembled
+			if (scratch == nullptr)
+			{
+				scratch = &nextScratch();
+				scratch->assign(tok.data, tok.length);
+			}
+
+			if (!appendQuoted(*scratch))
+			{
+				tok = TokenView(scratch->data(), scratch->size());
+				return !scratch->empty();
+			}
+		}
+
+		if (scratch != nullptr)
+		{
+			tok = TokenView(scratch->data(), scratch->size());
+		}
+
+		return true;
+	}
+
+	// Appends quoted content up to the closing quote, resolving escape sequences.
+	// Returns false if the end of input has been reached before the closing quote.
+	bool appendQuoted(std::string& target)
+	{
+		while (_next != _end)
+		{
+			char c = *_next++;
+
+			if (c == '"')
+			{
+				return true;
+			}
+
+			if (c != '\\')
+			{
+				target += c;
+				continue;
+			}
+
+			if (_next == _end)
+			{
+				break;
+			}
+
+			switch (*_next)
+			{
+			case 'n': target += '\n'; break;
+			case 't': target += '\t'; break;
+			case '"': target += '"'; break;
+			default:
+				// No special escape sequence, keep the backslash
+				target += '\\';
+				target += *_next;
+			}
+
+			++_next;
+		}
+
+		return false;
+	}
+
+	std::string& nextScratch()
+	{
+		_scratchIndex ^= 1;
+		return _scratch[_scratchIndex];
+	}
+};
+
+/**
+ * Reads the remaining contents of the given stream into a string,
+ * to be tokenised by a BufferDefTokeniser.
+ */
+inline std::string readStreamContents(std::istream& stream)
+{
+	return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+}
@@ -0,0 +1,469 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "ifilesystem.h"
+#include "itextstream.h"
+#include "os/fs.h"
+#include "stream/utils.h"
+#include "DefTokeniser.h"
+
+namespace parser
+{
+
+/**
+ * Persistent cache of parsed declaration files, stored in a binary file in
+ * the user's settings folder. Each entry holds the declarations a decl manager
+ * parsed from a single VFS file, serialised through a DeclWriter. The layout
+ * of the record is up to the manager, it is read back with a DeclReader. An
+ * entry is valid as long as the stamp of the file (the PK4 or loose file it
+ * is loaded from) matches.
+ *
+ * Entries which haven't been looked up or stored since load() are dropped
+ * when the cache is saved. All methods are safe to call from several threads.
+ */
+class DeclFileCache
+{
+	static const uint32_t CACHE_VERSION = 2;
+
+	// The smallest possible size of a serialised entry, used to reject
+	// counts which cannot be satisfied by the rest of the file
+	static const std::size_t MIN_ENTRY_SIZE = 4 + 4 + 8 + 8 + 4;
+
+	static const char* getCacheMagic()
+	{
+		return "DRDC";
+	}
+
+	struct Entry
+	{
+		vfs::FileStamp stamp;
+		std::string data;
+	};
+	typedef std::map<std::string, Entry> Entries;
+
+	std::string _cacheFile;
+
+	// The entries read from the cache file
+	Entries _loadedEntries;
+
+	// The entries which have been used since load()
+	Entries _usedEntries;
+
+	bool _changed;
+
+	std::mutex _lock;
+
+public:
+	DeclFileCache(const std::string& cacheFile = std::string()) :
+		_changed(false)
+	{
+		setCacheFile(cacheFile);
+	}
+
+	// Sets the path of the file to load and save, an empty path disables the persistence
+	void setCacheFile(const std::string& cacheFile)
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_cacheFile = cacheFile;
+	}
+
+	// Reads the cache file, a missing or invalid file results in an empty cache
+	void load()
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		_loadedEntries.clear();
+		_usedEntries.clear();
+		_changed = false;
+
+		if (_cacheFile.empty())
+		{
+			return;
+		}
+
+		std::ifstream stream(_cacheFile, std::ios::binary);
+
+		if (!stream)
+		{
+			return; // no cache yet
+		}
+
+		char magic[4];
+		stream.read(magic, sizeof(magic));
+
+		uint32_t version = 0;
+		uint32_t numEntries = 0;
+
+		if (!stream || std::string(magic, sizeof(magic)) != getCacheMagic() ||
+			!readValue(stream, version) || version != CACHE_VERSION ||
+			!readValue(stream, numEntries) || !checkRemainingBytes(stream, numEntries, MIN_ENTRY_SIZE))
+		{
+			rWarning() << "Ignoring incompatible declaration cache " << _cacheFile << std::endl;
+			return;
+		}
+
+		for (uint32_t i = 0; i < numEntries; ++i)
+		{
+			std::string filename;
+			Entry entry;
+
+			if (!readString(stream, filename) || !readString(stream, entry.stamp.physicalPath) ||
+				!readValue(stream, entry.stamp.size) || !readValue(stream, entry.stamp.modificationTime) ||
+				!readString(stream, entry.data))
+			{
+				break;
+			}
+
+			_loadedEntries[filename] = std::move(entry);
+		}
+
+		if (!stream)
+		{
+			rWarning() << "Declaration cache " << _cacheFile << " is truncated, discarding it" << std::endl;
+			_loadedEntries.clear();
+		}
+	}
+
+	// Writes all entries used since load() back to the cache file, if anything changed
+	void save()
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		// Files which have been removed since the last run need to be dropped too
+		if (_cacheFile.empty() || (!_changed && _usedEntries.size() == _loadedEntries.size()))
+		{
+			return;
+		}
+
+		// Write to a temporary file first, a crash must not leave a corrupt cache behind
+		std::string tempFile = _cacheFile + ".tmp";
+
+		{
+			std::ofstream stream(tempFile, std::ios::binary);
+
+			if (!stream)
+			{
+				rError() << "Cannot write declaration cache " << tempFile << std::endl;
+				return;
+			}
+
+			stream.write(getCacheMagic(), 4);
+			stream::writeLittleEndian<uint32_t>(stream, CACHE_VERSION);
+			stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(_usedEntries.size()));
+
+			for (const Entries::value_type& pair : _usedEntries)
+			{
+				writeString(stream, pair.first);
+				writeString(stream, pair.second.stamp.physicalPath);
+				stream::writeLittleEndian<uint64_t>(stream, pair.second.stamp.size);
+				stream::writeLittleEndian<int64_t>(stream, pair.second.stamp.modificationTime);
+				writeString(stream, pair.second.data);
+			}
+
+			if (!stream)
+			{
+				rError() << "Failed to write declaration cache " << tempFile << std::endl;
+				return;
+			}
+		}
+
+		try
+		{
+			if (fs::exists(_cacheFile))
+			{
+				fs::remove(_cacheFile);
+			}
+
+			fs::rename(tempFile, _cacheFile);
+		}
+		catch (fs::filesystem_error& ex)
+		{
+			rError() << "Cannot replace declaration cache " << _cacheFile << ": " << ex.what() << std::endl;
+			return;
+		}
+
+		_loadedEntries = _usedEntries;
+		_changed = false;
+	}
+
+	// Fills in the cached record of the given VFS file and returns true if it is up to date
+	bool lookup(const std::string& filename, const vfs::FileStamp& stamp, std::string& data)
+	{
+		if (stamp.empty())
+		{
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(_lock);
+
+		Entries::const_iterator found = _loadedEntries.find(filename);
+
+		if (found == _loadedEntries.end() || found->second.stamp != stamp)
+		{
+			return false;
+		}
+
+		data = found->second.data;
+		_usedEntries[filename] = found->second;
+
+		return true;
+	}
+
+	// Stores the record of the declarations parsed from the given VFS file, to be written on save()
+	void store(const std::string& filename, const vfs::FileStamp& stamp, const std::string& data)
+	{
+		if (stamp.empty())
+		{
+			return;
+		}
+
+		Entry entry;
+		entry.stamp = stamp;
+		entry.data = data;
+
+		std::lock_guard<std::mutex> lock(_lock);
+
+		_usedEntries[filename] = std::move(entry);
+		_changed = true;
+	}
+
+private:
+	// Reads a little endian value, returns false if the stream ran out of data
+	template<typename ValueType>
+	static bool readValue(std::istream& stream, ValueType& value)
+	{
+		stream.read(reinterpret_cast<char*>(&value), sizeof(ValueType));
+
+#ifdef __BIG_ENDIAN__
+		std::reverse(reinterpret_cast<char*>(&value), reinterpret_cast<char*>(&value) + sizeof(ValueType));
+#endif
+
+		return !stream.fail();
+	}
+
+	// The number of bytes left in the given stream, 0 if the stream is in a failed state
+	static std::size_t getRemainingBytes(std::istream& stream)
+	{
+		std::istream::pos_type position = stream.tellg();
+
+		if (position == std::istream::pos_type(-1))
+		{
+			return 0;
+		}
+
+		stream.seekg(0, std::ios::end);
+		std::istream::pos_type end = stream.tellg();
+		stream.seekg(position);
+
+		return end > position ? static_cast<std::size_t>(end - position) : 0;
+	}
+
+	// Checks that the stream holds at least count elements of the given minimum size,
+	// the stream is put into a failed state otherwise
+	static bool checkRemainingBytes(std::istream& stream, std::size_t count, std::size_t elementSize)
+	{
+		if (count > getRemainingBytes(stream) / elementSize)
+		{
+			stream.setstate(std::ios::failbit);
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool readString(std::istream& stream, std::string& str)
+	{
+		uint32_t length = 0;
+
+		if (!readValue(stream, length) || !checkRemainingBytes(stream, length, 1))
+		{
+			return false;
+		}
+
+		str.resize(length);
+		stream.read(&str[0], length);
+
+		return !stream.fail();
+	}
+
+	static void writeString(std::ostream& stream, const std::string& str)
+	{
+		stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(str.length()));
+		stream.write(str.data(), str.length());
+	}
+};
+
+/**
+ * Serialises parsed declarations into the record of a DeclFileCache entry.
+ * Values are stored in little endian byte order.
+ */
+class DeclWriter
+{
+	std::string _data;
+
+public:
+	void writeUInt32(uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			_data.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+		}
+	}
+
+	void writeInt32(int32_t value)
+	{
+		writeUInt32(static_cast<uint32_t>(value));
+	}
+
+	void writeSize(std::size_t value)
+	{
+		writeUInt32(static_cast<uint32_t>(value));
+	}
+
+	void writeBool(bool value)
+	{
+		_data.push_back(value ? 1 : 0);
+	}
+
+	void writeFloat(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeUInt32(bits);
+	}
+
+	void writeDouble(double value)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeUInt32(static_cast<uint32_t>(bits & 0xffffffff));
+		writeUInt32(static_cast<uint32_t>(bits >> 32));
+	}
+
+	void writeString(const std::string& str)
+	{
+		writeSize(str.length());
+		_data.append(str);
+	}
+
+	// The serialised record
+	const std::string& getData() const
+	{
+		return _data;
+	}
+};
+
+/**
+ * Reads back the values written by a DeclWriter, in the same order. Reading
+ * beyond the end of the record throws a ParseException, the caller is then
+ * expected to discard the entry and parse the file itself.
+ */
+class DeclReader
+{
+	const std::string& _data;
+	std::size_t _pos;
+
+public:
+	DeclReader(const std::string& data) :
+		_data(data),
+		_pos(0)
+	{}
+
+	bool atEnd() const
+	{
+		return _pos == _data.length();
+	}
+
+	uint32_t readUInt32()
+	{
+		require(4);
+
+		uint32_t value = 0;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			value |= static_cast<uint32_t>(static_cast<unsigned char>(_data[_pos++])) << (i * 8);
+		}
+
+		return value;
+	}
+
+	int32_t readInt32()
+	{
+		return static_cast<int32_t>(readUInt32());
+	}
+
+	std::size_t readSize()
+	{
+		return readUInt32();
+	}
+
+	bool readBool()
+	{
+		require(1);
+		return _data[_pos++] != 0;
+	}
+
+	float readFloat()
+	{
+		uint32_t bits = readUInt32();
+
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+
+	double readDouble()
+	{
+		uint64_t bits = readUInt32();
+		bits |= static_cast<uint64_t>(readUInt32()) << 32;
+
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+
+	std::string readString()
+	{
+		std::size_t length = readSize();
+		require(length);
+
+		std::string str = _data.substr(_pos, length);
+		_pos += length;
+
+		return str;
+	}
+
+	// Reads a count of elements, each taking at least the given number of bytes
+	std::size_t readCount(std::size_t minElementSize)
+	{
+		std::size_t count = readSize();
+
+		if (count > (_data.length() - _pos) / std::max<std::size_t>(minElementSize, 1))
+		{
+			throw ParseException("DeclReader: element count exceeds the cached record");
+		}
+
+		return count;
+	}
+
+private:
+	void require(std::size_t numBytes)
+	{
+		if (numBytes > _data.length() - _pos)
+		{
+			throw ParseException("DeclReader: unexpected end of the cached record");
+		}
+	}
+};
+
+}
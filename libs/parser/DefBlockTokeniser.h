@@ -455,4 +455,253 @@ public:
     }
 };
 
+/**
+ * BlockTokeniser working on a contiguous, fully buffered character range,
+ * e.g. the contents of a file read into a std::string.
+ *
+ * The blocks are split exactly like the BasicDefBlockTokeniser does (the
+ * states of the DefBlockTokeniserFunc are mirrored), but the block contents
+ * are copied in one go instead of character by character. The character range
+ * must stay valid for the lifetime of the tokeniser.
+ */
+class BufferDefBlockTokeniser :
+	public BlockTokeniser
+{
+private:
+	const char* _next;
+	const char* _end;
+
+	const char* _delims;
+
+	const char _blockStartChar;
+	const char _blockEndChar;
+
+	// The prefetched block and whether it is valid
+	Block _current;
+	bool _hasBlock;
+
+	enum State
+	{
+		SEARCHING_NAME,
+		TOKEN_STARTED,
+		SEARCHING_BLOCK,
+		BLOCK_CONTENT,
+		FORWARDSLASH,
+		COMMENT_EOL,
+		COMMENT_DELIM,
+		STAR
+	};
+
+public:
+	BufferDefBlockTokeniser(const char* begin, const char* end,
+							const char* delims = " \t\n\v\r",
+							const char blockStartChar = '{',
+							const char blockEndChar = '}') :
+		_next(begin),
+		_end(end),
+		_delims(delims),
+		_blockStartChar(blockStartChar),
+		_blockEndChar(blockEndChar),
+		_hasBlock(false)
+	{
+		_hasBlock = scanBlock(_current);
+	}
+
+	// Construct a tokeniser on the given string, which must outlive this instance
+	BufferDefBlockTokeniser(const std::string& buffer,
+							const char* delims = " \t\n\v\r",
+							const char blockStartChar = '{',
+							const char blockEndChar = '}') :
+		BufferDefBlockTokeniser(buffer.data(), buffer.data() + buffer.size(),
+								delims, blockStartChar, blockEndChar)
+	{}
+
+	bool hasMoreBlocks() override
+	{
+		return _hasBlock;
+	}
+
+	Block nextBlock() override
+	{
+		if (!_hasBlock)
+		{
+			throw ParseException("BlockTokeniser: no more blocks");
+		}
+
+		Block block;
+		std::swap(block, _current);
+
+		_hasBlock = scanBlock(_current);
+
+		return block;
+	}
+
+private:
+	bool isDelim(char c) const
+	{
+		for (const char* curDelim = _delims; *curDelim != 0; ++curDelim)
+		{
+			if (*curDelim == c)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool scanBlock(Block& tok)
+	{
+		tok.clear();
+
+		State state = SEARCHING_NAME;
+		std::size_t blockLevel = 0;
+		const char* contentStart = nullptr;
+
+		while (_next != _end)
+		{
+			char ch = *_next;
+
+			switch (state)
+			{
+			case SEARCHING_NAME:
+				if (isDelim(ch))
+				{
+					++_next;
+					continue;
+				}
+
+				state = TOKEN_STARTED;
+				// Fall through
+
+			case TOKEN_STARTED:
+				if (isDelim(ch))
+				{
+					state = SEARCHING_BLOCK;
+					continue;
+				}
+
+				if (ch == '/')
+				{
+					state = FORWARDSLASH;
+					++_next;
+					continue;
+				}
+
+				tok.name += ch;
+				++_next;
+				continue;
+
+			case SEARCHING_BLOCK:
+				if (isDelim(ch))
+				{
+					++_next;
+					continue;
+				}
+
+				if (ch == _blockStartChar)
+				{
+					state = BLOCK_CONTENT;
+					blockLevel++;
+					contentStart = ++_next;
+					continue;
+				}
+
+				if (ch == '/')
+				{
+					state = FORWARDSLASH;
+					++_next;
+					continue;
+				}
+
+				// An "extension" for the name
+				tok.name += ' ';
+				tok.name += ch;
+				state = TOKEN_STARTED;
+				++_next;
+				continue;
+
+			case BLOCK_CONTENT:
+				// Braces are counted regardless of quotes or comments
+				if (ch == _blockEndChar)
+				{
+					if (--blockLevel == 0)
+					{
+						tok.contents.assign(contentStart, _next);
+						++_next;
+						return true;
+					}
+				}
+				else if (ch == _blockStartChar)
+				{
+					blockLevel++;
+				}
+
+				++_next;
+				continue;
+
+			case FORWARDSLASH:
+				if (ch == '*')
+				{
+					state = COMMENT_DELIM;
+					++_next;
+					continue;
+				}
+
+				if (ch == '/')
+				{
+					state = COMMENT_EOL;
+					++_next;
+					continue;
+				}
+
+				// False alarm, add the slash and carry on without advancing
+				state = TOKEN_STARTED;
+				tok.name += '/';
+				continue;
+
+			case COMMENT_DELIM:
+				if (ch == '*')
+				{
+					state = STAR;
+				}
+
+				++_next;
+				continue;
+
+			case COMMENT_EOL:
+				if (ch == '\r' || ch == '\n')
+				{
+					state = tok.name.empty() ? SEARCHING_NAME : SEARCHING_BLOCK;
+				}
+
+				++_next;
+				continue;
+
+			case STAR:
+				if (ch == '/')
+				{
+					state = tok.name.empty() ? SEARCHING_NAME : SEARCHING_BLOCK;
+				}
+				else if (ch != '*')
+				{
+					state = COMMENT_DELIM;
+				}
+
+				++_next;
+				continue;
+			}
+		}
+
+		// An unterminated block extends to the end of the buffer
+		if (state == BLOCK_CONTENT)
+		{
+			tok.contents.assign(contentStart, _end);
+		}
+
+		// Return true if we have found a named block
+		return !tok.name.empty();
+	}
+};
+
 } // namespace parser
@@ -90,6 +90,8 @@ namespace render
 template<> class VertexTraits<ArbitraryMeshVertex>
 {
 public:
+    typedef double ComponentType;
+
     static const void* VERTEX_OFFSET()
     {
         return reinterpret_cast<const void*>(
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+
+#include "VertexTraits.h"
+#include "math/Vector2.h"
+#include "math/Vector3.h"
+
+namespace render
+{
+
+/**
+ * Vertex of a polygon stored in a shared batch buffer. Single precision is
+ * plenty for rendering and halves the amount of data sent to the GPU
+ * compared to the double precision geometry of the scene.
+ */
+struct BatchVertex
+{
+	Vector3f vertex;
+	BasicVector2<float> texcoord;
+	Vector3f normal;
+	Vector3f tangent;
+	Vector3f bitangent;
+};
+
+/// VertexTraits specialisation for BatchVertex
+template<> class VertexTraits<BatchVertex>
+{
+public:
+	typedef float ComponentType;
+
+	static const void* VERTEX_OFFSET()
+	{
+		return reinterpret_cast<const void*>(offsetof(BatchVertex, vertex));
+	}
+
+	static bool hasNormal() { return true; }
+	static const void* NORMAL_OFFSET()
+	{
+		return reinterpret_cast<const void*>(offsetof(BatchVertex, normal));
+	}
+
+	static bool hasTexCoord() { return true; }
+	static const void* TEXCOORD_OFFSET()
+	{
+		return reinterpret_cast<const void*>(offsetof(BatchVertex, texcoord));
+	}
+
+	static bool hasTangents() { return true; }
+	static const void* TANGENT_OFFSET()
+	{
+		return reinterpret_cast<const void*>(offsetof(BatchVertex, tangent));
+	}
+	static const void* BITANGENT_OFFSET()
+	{
+		return reinterpret_cast<const void*>(offsetof(BatchVertex, bitangent));
+	}
+};
+
+/**
+ * A convex polygon which can be drawn as part of a batch instead of being
+ * submitted on its own. OpenGLRenderables implementing this interface (like
+ * brush face windings) get their vertices copied into a vertex buffer shared
+ * by all polygons of a shader, which is drawn with one call per batch.
+ */
+class IBatchablePolygon
+{
+public:
+	virtual ~IBatchablePolygon() {}
+
+	/**
+	 * Returns a number identifying the current geometry of this polygon. It
+	 * must change whenever the vertices change, polygons with the same
+	 * revision are assumed to be unchanged since they were last copied.
+	 */
+	virtual std::size_t getBatchRevision() const = 0;
+
+	/// The number of vertices of this polygon
+	virtual std::size_t getNumBatchVertices() const = 0;
+
+	/// Write the vertices to the given array, which has room for getNumBatchVertices() elements
+	virtual void writeBatchVertices(BatchVertex* vertices) const = 0;
+};
+
+}
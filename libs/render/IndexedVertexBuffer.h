@@ -2,11 +2,33 @@
 
 #include <GL/glew.h>
 
+#include <algorithm>
+#include <limits>
+
 #include "GLProgramAttributes.h"
+#include "render.h"
+#include "VBO.h"
+#include "VertexTraits.h"
 
 namespace render
 {
 
+namespace detail
+{
+    /// Maps the component type of a vertex to the GL type enum
+    template<typename T> struct GLComponentType;
+
+    template<> struct GLComponentType<double>
+    {
+        static const GLenum value = GL_DOUBLE;
+    };
+
+    template<> struct GLComponentType<float>
+    {
+        static const GLenum value = GL_FLOAT;
+    };
+}
+
 /**
  * \brief
  * Receiver of indexed vertex geometry for rendering
@@ -15,6 +37,10 @@ namespace render
  * indices into the vertex buffer which are rendered with glDrawElements. It
  * functions much like \a VertexBuffer except for indexed geometry rather than
  * raw vertex geometry.
+ *
+ * Changes to the data are uploaded to the VBOs the next time the buffer is
+ * bound. Vertices replaced in place are sent with glBufferSubData, the VBO is
+ * only reallocated if the data outgrew it.
  */
 template<typename Vertex_T>
 class IndexedVertexBuffer
@@ -27,14 +53,27 @@ private:
 
     typedef VertexTraits<Vertex_T> Traits;
 
+    static const GLenum COMPONENT_TYPE =
+        detail::GLComponentType<typename Traits::ComponentType>::value;
+
     // OpenGL VBO
     mutable GLuint _vertexVBO;
     mutable GLuint _indexVBO;
 
+    // Number of elements the VBOs have been allocated for
+    mutable std::size_t _vertexCapacity;
+    mutable std::size_t _indexCapacity;
+
     // Vertex and index storage
     Vertices _vertices;
     Indices _indices;
 
+    // Range of vertices changed since the last upload
+    mutable std::size_t _dirtyBegin;
+    mutable std::size_t _dirtyEnd;
+
+    mutable bool _indicesChanged;
+
     // Batches of indices (start index and count)
     struct Batch
     {
@@ -47,17 +86,80 @@ private:
 
 private:
 
-    void initialiseVBOs() const
+    void markVerticesChanged(std::size_t begin, std::size_t end)
     {
-        _vertexVBO = makeVBOFromArray(GL_ARRAY_BUFFER, _vertices);
-        _indexVBO = makeVBOFromArray(GL_ELEMENT_ARRAY_BUFFER, _indices);
+        _dirtyBegin = std::min(_dirtyBegin, begin);
+        _dirtyEnd = std::max(_dirtyEnd, end);
+    }
+
+    template<typename Array_T>
+    static void uploadData(GLenum target, GLuint& vboID, std::size_t& capacity,
+                           const Array_T& data, std::size_t begin, std::size_t end)
+    {
+        typedef typename Array_T::value_type Value;
+
+        if (vboID == 0)
+        {
+            glGenBuffers(1, &vboID);
+            capacity = 0;
+        }
+
+        glBindBuffer(target, vboID);
+
+        if (data.size() > capacity)
+        {
+            // Reallocate the whole store, with some room to grow
+            capacity = data.size() + data.size() / 2;
+            glBufferData(target, GLsizeiptr(capacity * sizeof(Value)), NULL, GL_DYNAMIC_DRAW);
+
+            begin = 0;
+            end = data.size();
+        }
+
+        end = std::min(end, data.size());
+
+        if (begin < end)
+        {
+            glBufferSubData(target, GLintptr(begin * sizeof(Value)),
+                            GLsizeiptr((end - begin) * sizeof(Value)), &data[begin]);
+        }
+    }
+
+    // Upload any changed data and bind the VBOs
+    void syncVBOs() const
+    {
+        if (_vertexVBO == 0 || _dirtyBegin < _dirtyEnd)
+        {
+            uploadData(GL_ARRAY_BUFFER, _vertexVBO, _vertexCapacity, _vertices, _dirtyBegin, _dirtyEnd);
+
+            _dirtyBegin = std::numeric_limits<std::size_t>::max();
+            _dirtyEnd = 0;
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, _vertexVBO);
+        }
+
+        if (_indexVBO == 0 || _indicesChanged)
+        {
+            uploadData(GL_ELEMENT_ARRAY_BUFFER, _indexVBO, _indexCapacity, _indices, 0, _indices.size());
+            _indicesChanged = false;
+        }
+        else
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexVBO);
+        }
     }
 
 public:
 
     /// Construct an empty IndexedVertexBuffer
     IndexedVertexBuffer()
-    : _vertexVBO(0), _indexVBO(0)
+    : _vertexVBO(0), _indexVBO(0),
+      _vertexCapacity(0), _indexCapacity(0),
+      _dirtyBegin(std::numeric_limits<std::size_t>::max()),
+      _dirtyEnd(0),
+      _indicesChanged(true)
     { }
 
     /// Destroy resources
@@ -77,7 +179,50 @@ public:
     template<typename Iter_T>
     void addVertices(Iter_T begin, Iter_T end)
     {
+        std::size_t first = _vertices.size();
+
         std::copy(begin, end, std::back_inserter(_vertices));
+
+        markVerticesChanged(first, _vertices.size());
+    }
+
+    /// Append the given number of default-constructed vertices, returns the index of the first one
+    std::size_t allocateVertices(std::size_t count)
+    {
+        std::size_t first = _vertices.size();
+
+        _vertices.resize(first + count);
+        markVerticesChanged(first, _vertices.size());
+
+        return first;
+    }
+
+    /**
+     * \brief
+     * Returns a pointer to the given range of vertices for modification.
+     *
+     * The range will be uploaded the next time the buffer is rendered.
+     */
+    Vertex_T* getModifiableVertices(std::size_t first, std::size_t count)
+    {
+        assert(first + count <= _vertices.size());
+
+        markVerticesChanged(first, first + count);
+
+        return &_vertices[first];
+    }
+
+    std::size_t getNumVertices() const
+    {
+        return _vertices.size();
+    }
+
+    /// Remove all vertices, the VBO storage is kept for reuse
+    void clearVertices()
+    {
+        _vertices.clear();
+        _dirtyBegin = std::numeric_limits<std::size_t>::max();
+        _dirtyEnd = 0;
     }
 
     /// Add a batch of indices
@@ -99,6 +244,21 @@ public:
         {
             _indices.push_back(*i);
         }
+
+        _indicesChanged = true;
+    }
+
+    std::size_t getNumBatches() const
+    {
+        return _batches.size();
+    }
+
+    /// Remove all index batches, leaving the vertices untouched
+    void clearBatches()
+    {
+        _indices.clear();
+        _batches.clear();
+        _indicesChanged = true;
     }
 
     /**
@@ -109,19 +269,17 @@ public:
      */
     void replaceData(const IndexedVertexBuffer& other)
     {
-        replaceVBODataIfPossible(GL_ARRAY_BUFFER, _vertexVBO,
-                                 _vertices, other._vertices);
-        replaceVBODataIfPossible(GL_ELEMENT_ARRAY_BUFFER, _indexVBO,
-                                 _indices, other._indices);
-
         _vertices = other._vertices;
         _indices = other._indices;
         _batches = other._batches;
+
+        markVerticesChanged(0, _vertices.size());
+        _indicesChanged = true;
     }
 
     /**
      * \brief
-     * Render all batches with given primitive type
+     * Upload pending changes, bind the VBOs and set the vertex pointers
      *
      * \param renderBump
      * True if tangent and bitangent vectors should be submitted for bump map
@@ -129,19 +287,13 @@ public:
      * all cases the pointers will only be set if carried by the particular
      * vertex type.
      */
-    void renderAllBatches(GLenum primitiveType, bool renderBump = false) const
+    void bind(bool renderBump = false) const
     {
-        if (_vertexVBO == 0 || _indexVBO == 0)
-        {
-            initialiseVBOs();
-        }
-
-        glBindBuffer(GL_ARRAY_BUFFER, _vertexVBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexVBO);
+        syncVBOs();
 
         // Vertex pointer includes whole vertex buffer
         const GLsizei STRIDE = sizeof(Vertex_T);
-        glVertexPointer(3, GL_DOUBLE, STRIDE, Traits::VERTEX_OFFSET());
+        glVertexPointer(3, COMPONENT_TYPE, STRIDE, Traits::VERTEX_OFFSET());
 
         // Set other pointers as necessary
         if (Traits::hasTexCoord())
@@ -149,13 +301,13 @@ public:
             if (renderBump)
             {
                 glVertexAttribPointer(
-                    ATTR_TEXCOORD, 2, GL_DOUBLE, GL_FALSE,
+                    ATTR_TEXCOORD, 2, COMPONENT_TYPE, GL_FALSE,
                     STRIDE, Traits::TEXCOORD_OFFSET()
                 );
             }
             else
             {
-                glTexCoordPointer(2, GL_DOUBLE, STRIDE,
+                glTexCoordPointer(2, COMPONENT_TYPE, STRIDE,
                                   Traits::TEXCOORD_OFFSET());
             }
         }
@@ -164,38 +316,66 @@ public:
             if (renderBump)
             {
                 glVertexAttribPointer(
-                    ATTR_NORMAL, 3, GL_DOUBLE, GL_FALSE,
+                    ATTR_NORMAL, 3, COMPONENT_TYPE, GL_FALSE,
                     STRIDE, Traits::NORMAL_OFFSET()
                 );
             }
             else
             {
-                glNormalPointer(GL_DOUBLE, STRIDE, Traits::NORMAL_OFFSET());
+                glNormalPointer(COMPONENT_TYPE, STRIDE, Traits::NORMAL_OFFSET());
             }
         }
         if (Traits::hasTangents() && renderBump)
         {
-            glVertexAttribPointer(ATTR_TANGENT, 3, GL_DOUBLE, GL_FALSE,
+            glVertexAttribPointer(ATTR_TANGENT, 3, COMPONENT_TYPE, GL_FALSE,
                                   STRIDE, Traits::TANGENT_OFFSET());
-            glVertexAttribPointer(ATTR_BITANGENT, 3, GL_DOUBLE, GL_FALSE,
+            glVertexAttribPointer(ATTR_BITANGENT, 3, COMPONENT_TYPE, GL_FALSE,
                                   STRIDE, Traits::BITANGENT_OFFSET());
         }
+    }
+
+    /// Unbind the VBOs after rendering
+    void unbind() const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    /// Render a single batch with the given primitive type, the buffer must be bound
+    void renderBatch(std::size_t index, GLenum primitiveType) const
+    {
+        const Batch& batch = _batches[index];
+
+        glDrawElements(
+            primitiveType, GLint(batch.size), RenderIndexTypeID,
+            reinterpret_cast<const GLvoid*>(
+                batch.start * sizeof(typename Indices::value_type)
+            )
+        );
+    }
+
+    /**
+     * \brief
+     * Render all batches with given primitive type
+     *
+     * \see bind()
+     */
+    void renderAllBatches(GLenum primitiveType, bool renderBump = false) const
+    {
+        if (_vertices.empty() || _indices.empty())
+        {
+            return;
+        }
+
+        bind(renderBump);
 
         // Render each batch of indices
-        for (typename std::vector<Batch>::const_iterator i = _batches.begin();
-             i != _batches.end();
-             ++i)
+        for (std::size_t i = 0; i < _batches.size(); ++i)
         {
-            glDrawElements(
-                primitiveType, GLint(i->size), RenderIndexTypeID,
-                reinterpret_cast<const GLvoid*>(
-                    i->start * sizeof(Indices::value_type)
-                )
-            );
+            renderBatch(i, primitiveType);
         }
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        unbind();
     }
 };
 
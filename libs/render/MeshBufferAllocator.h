@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "ArbitraryMeshVertex.h"
+#include "math/Vector2.h"
+#include "math/Vector3.h"
+
+namespace render
+{
+
+/**
+ * Compact vertex of a model surface, as stored in the shared mesh buffers.
+ * Positions and texture coordinates are single precision, the normal,
+ * tangent and bitangent vectors are packed into signed bytes (to be read as
+ * normalised values) and the colour into unsigned bytes, which results in
+ * 36 bytes per vertex instead of the 136 bytes of an ArbitraryMeshVertex.
+ */
+struct MeshVertex
+{
+	Vector3f vertex;
+	BasicVector2<float> texcoord;
+	int8_t normal[4];
+	int8_t tangent[4];
+	int8_t bitangent[4];
+	uint8_t colour[4];
+};
+
+/// Pack a unit vector into three signed bytes, the fourth one is zeroed
+inline void packNormal(const Vector3& normal, int8_t packed[4])
+{
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		double value = std::max(-1.0, std::min(1.0, static_cast<double>(normal[i])));
+		packed[i] = static_cast<int8_t>(std::lround(value * 127));
+	}
+
+	packed[3] = 0;
+}
+
+/// Return the vector stored by packNormal(), the way GL reads normalised bytes
+inline Vector3 unpackNormal(const int8_t packed[4])
+{
+	return Vector3(
+		std::max(-1.0, packed[0] / 127.0),
+		std::max(-1.0, packed[1] / 127.0),
+		std::max(-1.0, packed[2] / 127.0)
+	);
+}
+
+/// Convert the given vertex to its compact form
+inline MeshVertex packMeshVertex(const ArbitraryMeshVertex& v)
+{
+	MeshVertex packed;
+
+	packed.vertex = Vector3f(static_cast<float>(v.vertex.x()),
+		static_cast<float>(v.vertex.y()), static_cast<float>(v.vertex.z()));
+	packed.texcoord = BasicVector2<float>(static_cast<float>(v.texcoord.x()),
+		static_cast<float>(v.texcoord.y()));
+
+	packNormal(v.normal, packed.normal);
+	packNormal(v.tangent, packed.tangent);
+	packNormal(v.bitangent, packed.bitangent);
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		double value = std::max(0.0, std::min(1.0, v.colour[i]));
+		packed.colour[i] = static_cast<uint8_t>(std::lround(value * 255));
+	}
+
+	packed.colour[3] = 255;
+
+	return packed;
+}
+
+namespace detail
+{
+
+/**
+ * Hands out ranges of an array, reusing released ranges on a first-fit
+ * basis. Adjacent free ranges are merged, a free range at the end of the
+ * array shrinks it.
+ */
+class RangeAllocator
+{
+private:
+	// Free ranges, offset => size
+	std::map<std::size_t, std::size_t> _free;
+
+	// The number of elements in use, including free ranges in between
+	std::size_t _end;
+
+public:
+	RangeAllocator() :
+		_end(0)
+	{}
+
+	std::size_t getEnd() const
+	{
+		return _end;
+	}
+
+	std::size_t getNumFree() const
+	{
+		std::size_t count = 0;
+
+		for (const auto& range : _free)
+		{
+			count += range.second;
+		}
+
+		return count;
+	}
+
+	// Returns the offset of a range of the given size
+	std::size_t allocate(std::size_t count)
+	{
+		for (auto i = _free.begin(); i != _free.end(); ++i)
+		{
+			if (i->second < count) continue;
+
+			std::size_t offset = i->first;
+			std::size_t remaining = i->second - count;
+
+			_free.erase(i);
+
+			if (remaining > 0)
+			{
+				_free[offset + count] = remaining;
+			}
+
+			return offset;
+		}
+
+		std::size_t offset = _end;
+		_end += count;
+
+		return offset;
+	}
+
+	void release(std::size_t offset, std::size_t count)
+	{
+		if (count == 0) return;
+
+		auto next = _free.lower_bound(offset);
+
+		// Merge with the following free range
+		if (next != _free.end() && next->first == offset + count)
+		{
+			count += next->second;
+			next = _free.erase(next);
+		}
+
+		// Merge with the preceding free range
+		if (next != _free.begin())
+		{
+			auto previous = std::prev(next);
+
+			if (previous->first + previous->second == offset)
+			{
+				offset = previous->first;
+				count += previous->second;
+				_free.erase(previous);
+			}
+		}
+
+		if (offset + count == _end)
+		{
+			_end = offset;
+		}
+		else
+		{
+			_free[offset] = count;
+		}
+	}
+};
+
+/// An array with the range of elements changed since the last upload
+template<typename Element_T>
+struct MeshBufferStorage
+{
+	std::vector<Element_T> data;
+
+	std::size_t dirtyBegin = std::numeric_limits<std::size_t>::max();
+	std::size_t dirtyEnd = 0;
+
+	void markChanged(std::size_t begin, std::size_t end)
+	{
+		dirtyBegin = std::min(dirtyBegin, begin);
+		dirtyEnd = std::max(dirtyEnd, end);
+	}
+
+	void clearChanges()
+	{
+		dirtyBegin = std::numeric_limits<std::size_t>::max();
+		dirtyEnd = 0;
+	}
+
+	bool hasChanges() const
+	{
+		return dirtyBegin < dirtyEnd && dirtyBegin < data.size();
+	}
+
+	void resize(std::size_t size)
+	{
+		data.resize(size);
+	}
+
+	std::size_t getMemoryUsage() const
+	{
+		return data.capacity() * sizeof(Element_T);
+	}
+};
+
+}
+
+/**
+ * Storage of the vertices and indices of all model surfaces in shared
+ * arrays, which are uploaded to the GPU by the MeshBufferPool. Each mesh
+ * gets a range of the vertex array and a range of one of the index arrays:
+ * meshes with up to 65536 vertices use 16-bit indices, larger ones 32-bit
+ * indices. Indices are relative to the first vertex of their mesh.
+ *
+ * This class contains the bookkeeping only, it doesn't make any GL calls.
+ */
+class MeshBufferAllocator
+{
+public:
+	typedef std::size_t Handle;
+	static const Handle INVALID_HANDLE = static_cast<Handle>(-1);
+
+	// Meshes with more vertices use 32-bit indices
+	static const std::size_t MAX_SHORT_INDEXED_VERTICES = 65536;
+
+	struct Mesh
+	{
+		std::size_t firstVertex;
+		std::size_t numVertices;
+		std::size_t firstIndex;
+		std::size_t numIndices;
+		bool shortIndices;
+		bool hasColours;
+		bool used;
+	};
+
+protected:
+	detail::MeshBufferStorage<MeshVertex> _vertices;
+	detail::MeshBufferStorage<uint16_t> _shortIndices;
+	detail::MeshBufferStorage<uint32_t> _indices;
+
+	detail::RangeAllocator _vertexRanges;
+	detail::RangeAllocator _shortIndexRanges;
+	detail::RangeAllocator _indexRanges;
+
+	std::vector<Mesh> _meshes;
+	std::vector<Handle> _freeHandles;
+
+public:
+	/**
+	 * Add a mesh with the given vertices and triangle indices, returns the
+	 * handle to refer to it. If hasColours is false, the vertex colours are
+	 * not used when drawing the mesh.
+	 */
+	Handle allocate(const std::vector<ArbitraryMeshVertex>& vertices,
+					const std::vector<unsigned int>& indices,
+					bool hasColours)
+	{
+		Mesh mesh;
+
+		mesh.numVertices = vertices.size();
+		mesh.numIndices = indices.size();
+		mesh.shortIndices = vertices.size() <= MAX_SHORT_INDEXED_VERTICES;
+		mesh.hasColours = hasColours;
+		mesh.used = true;
+
+		mesh.firstVertex = _vertexRanges.allocate(mesh.numVertices);
+		_vertices.resize(_vertexRanges.getEnd());
+
+		if (mesh.shortIndices)
+		{
+			mesh.firstIndex = _shortIndexRanges.allocate(mesh.numIndices);
+			_shortIndices.resize(_shortIndexRanges.getEnd());
+
+			std::copy(indices.begin(), indices.end(), _shortIndices.data.begin() + mesh.firstIndex);
+			_shortIndices.markChanged(mesh.firstIndex, mesh.firstIndex + mesh.numIndices);
+		}
+		else
+		{
+			mesh.firstIndex = _indexRanges.allocate(mesh.numIndices);
+			_indices.resize(_indexRanges.getEnd());
+
+			std::copy(indices.begin(), indices.end(), _indices.data.begin() + mesh.firstIndex);
+			_indices.markChanged(mesh.firstIndex, mesh.firstIndex + mesh.numIndices);
+		}
+
+		Handle handle;
+
+		if (!_freeHandles.empty())
+		{
+			handle = _freeHandles.back();
+			_freeHandles.pop_back();
+			_meshes[handle] = mesh;
+		}
+		else
+		{
+			handle = _meshes.size();
+			_meshes.push_back(mesh);
+		}
+
+		updateVertices(handle, vertices);
+
+		return handle;
+	}
+
+	/// Replace the vertices of the given mesh, the vertex count must not change
+	void updateVertices(Handle handle, const std::vector<ArbitraryMeshVertex>& vertices)
+	{
+		const Mesh& mesh = getMesh(handle);
+		assert(vertices.size() == mesh.numVertices);
+
+		MeshVertex* target = _vertices.data.data() + mesh.firstVertex;
+
+		for (std::size_t i = 0; i < mesh.numVertices; ++i)
+		{
+			target[i] = packMeshVertex(vertices[i]);
+		}
+
+		_vertices.markChanged(mesh.firstVertex, mesh.firstVertex + mesh.numVertices);
+	}
+
+	/// Remove the mesh, its ranges are reused by later allocations
+	void release(Handle handle)
+	{
+		Mesh& mesh = _meshes[handle];
+		assert(mesh.used);
+
+		_vertexRanges.release(mesh.firstVertex, mesh.numVertices);
+		_vertices.resize(_vertexRanges.getEnd());
+
+		if (mesh.shortIndices)
+		{
+			_shortIndexRanges.release(mesh.firstIndex, mesh.numIndices);
+			_shortIndices.resize(_shortIndexRanges.getEnd());
+		}
+		else
+		{
+			_indexRanges.release(mesh.firstIndex, mesh.numIndices);
+			_indices.resize(_indexRanges.getEnd());
+		}
+
+		mesh.used = false;
+		_freeHandles.push_back(handle);
+	}
+
+	const Mesh& getMesh(Handle handle) const
+	{
+		assert(handle < _meshes.size() && _meshes[handle].used);
+		return _meshes[handle];
+	}
+
+	/// The vertices of the given mesh, as they are sent to the GPU
+	const MeshVertex* getVertices(Handle handle) const
+	{
+		return _vertices.data.data() + getMesh(handle).firstVertex;
+	}
+
+	/// The index of the given triangle corner, relative to the first vertex of the mesh
+	std::size_t getIndex(Handle handle, std::size_t i) const
+	{
+		const Mesh& mesh = getMesh(handle);
+
+		return mesh.shortIndices ? _shortIndices.data[mesh.firstIndex + i] :
+			_indices.data[mesh.firstIndex + i];
+	}
+
+	/// The number of bytes the vertices and indices of the mesh occupy
+	std::size_t getMemoryUsage(Handle handle) const
+	{
+		const Mesh& mesh = getMesh(handle);
+
+		return mesh.numVertices * sizeof(MeshVertex) +
+			mesh.numIndices * (mesh.shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+	}
+
+	/// The number of bytes allocated for all meshes, including unused ranges
+	std::size_t getTotalMemoryUsage() const
+	{
+		return _vertices.getMemoryUsage() + _shortIndices.getMemoryUsage() + _indices.getMemoryUsage();
+	}
+
+	/// The number of vertices in released ranges waiting to be reused
+	std::size_t getNumFreeVertices() const
+	{
+		return _vertexRanges.getNumFree();
+	}
+
+	std::size_t getNumVertices() const
+	{
+		return _vertices.data.size();
+	}
+};
+
+}
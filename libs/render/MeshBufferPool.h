@@ -0,0 +1,248 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include "irender.h"
+#include "GLProgramAttributes.h"
+#include "MeshBufferAllocator.h"
+#include "VBO.h"
+
+namespace render
+{
+
+/**
+ * The vertex and index buffers shared by all model surfaces. Surfaces store
+ * their geometry here instead of compiling display lists, the pool uploads
+ * changed ranges to VBOs the next time it is bound. Without VBO support the
+ * meshes are drawn from the client-side arrays.
+ *
+ * Drawing works like this: beginDraw() binds the buffers and sets up the
+ * arrays needed by the given render flags, draw() renders a single mesh
+ * (re-pointing the arrays to its vertex range) and endDraw() resets the
+ * state. Only one pool exists, it must be used from the main thread.
+ */
+class MeshBufferPool :
+	public MeshBufferAllocator
+{
+private:
+	// VBO identifier and the number of elements it has been allocated for
+	struct BufferObject
+	{
+		GLuint id = 0;
+		std::size_t capacity = 0;
+	};
+
+	BufferObject _vertexBuffer;
+	BufferObject _shortIndexBuffer;
+	BufferObject _indexBuffer;
+
+	bool _useVBOs;
+	unsigned int _drawFlags;
+
+	// The buffer bound to GL_ELEMENT_ARRAY_BUFFER during drawing
+	GLuint _boundIndexBuffer;
+
+	MeshBufferPool() :
+		_useVBOs(false),
+		_drawFlags(0),
+		_boundIndexBuffer(0)
+	{}
+
+	template<typename Element_T>
+	static void upload(GLenum target, BufferObject& buffer, detail::MeshBufferStorage<Element_T>& storage)
+	{
+		if (buffer.id == 0)
+		{
+			glGenBuffers(1, &buffer.id);
+		}
+
+		glBindBuffer(target, buffer.id);
+
+		const std::vector<Element_T>& data = storage.data;
+
+		if (data.size() > buffer.capacity)
+		{
+			// Reallocate with some room to grow
+			buffer.capacity = data.size() + data.size() / 2;
+			glBufferData(target, GLsizeiptr(buffer.capacity * sizeof(Element_T)), NULL, GL_STATIC_DRAW);
+
+			storage.markChanged(0, data.size());
+		}
+
+		if (storage.hasChanges())
+		{
+			std::size_t end = std::min(storage.dirtyEnd, data.size());
+
+			glBufferSubData(target, GLintptr(storage.dirtyBegin * sizeof(Element_T)),
+				GLsizeiptr((end - storage.dirtyBegin) * sizeof(Element_T)), &data[storage.dirtyBegin]);
+		}
+
+		storage.clearChanges();
+	}
+
+	// Bind the given index buffer if necessary, returns the start of the indices
+	template<typename Element_T>
+	const char* bindIndices(const BufferObject& buffer, const detail::MeshBufferStorage<Element_T>& storage)
+	{
+		if (!_useVBOs)
+		{
+			return reinterpret_cast<const char*>(storage.data.data());
+		}
+
+		if (_boundIndexBuffer != buffer.id)
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.id);
+			_boundIndexBuffer = buffer.id;
+		}
+
+		return NULL;
+	}
+
+	// Start of the vertex array in the bound buffer, or in client memory
+	const char* getVertexBase() const
+	{
+		return _useVBOs ? NULL : reinterpret_cast<const char*>(_vertices.data.data());
+	}
+
+	void setVertexPointers(const Mesh& mesh)
+	{
+		const GLsizei STRIDE = sizeof(MeshVertex);
+		const char* base = getVertexBase() + mesh.firstVertex * STRIDE;
+
+		glVertexPointer(3, GL_FLOAT, STRIDE, base + offsetof(MeshVertex, vertex));
+
+		if (_drawFlags & RENDER_BUMP)
+		{
+			glVertexAttribPointer(ATTR_TEXCOORD, 2, GL_FLOAT, GL_FALSE, STRIDE, base + offsetof(MeshVertex, texcoord));
+			glVertexAttribPointer(ATTR_NORMAL, 3, GL_BYTE, GL_TRUE, STRIDE, base + offsetof(MeshVertex, normal));
+			glVertexAttribPointer(ATTR_TANGENT, 3, GL_BYTE, GL_TRUE, STRIDE, base + offsetof(MeshVertex, tangent));
+			glVertexAttribPointer(ATTR_BITANGENT, 3, GL_BYTE, GL_TRUE, STRIDE, base + offsetof(MeshVertex, bitangent));
+		}
+		else
+		{
+			if (_drawFlags & RENDER_LIGHTING)
+			{
+				glNormalPointer(GL_BYTE, STRIDE, base + offsetof(MeshVertex, normal));
+			}
+
+			if (_drawFlags & RENDER_TEXTURE_2D)
+			{
+				glTexCoordPointer(2, GL_FLOAT, STRIDE, base + offsetof(MeshVertex, texcoord));
+			}
+		}
+
+		// Vertex colours are only applied by the GL programs
+		if ((_drawFlags & RENDER_PROGRAM) && (_drawFlags & RENDER_VERTEX_COLOUR) && mesh.hasColours)
+		{
+			glEnableClientState(GL_COLOR_ARRAY);
+			glColorPointer(4, GL_UNSIGNED_BYTE, STRIDE, base + offsetof(MeshVertex, colour));
+		}
+		else
+		{
+			glDisableClientState(GL_COLOR_ARRAY);
+		}
+	}
+
+public:
+	// The pool is never destroyed, surfaces held by other static objects
+	// may still release their meshes during static destruction
+	static MeshBufferPool& Instance()
+	{
+		static MeshBufferPool* _instance = new MeshBufferPool;
+		return *_instance;
+	}
+
+	/// Delete the buffer objects, must be called while the GL context is still valid.
+	/// The meshes are kept, they are uploaded again by the next beginDraw().
+	void shutdown()
+	{
+		deleteVBO(_vertexBuffer.id);
+		deleteVBO(_shortIndexBuffer.id);
+		deleteVBO(_indexBuffer.id);
+
+		_vertexBuffer.capacity = 0;
+		_shortIndexBuffer.capacity = 0;
+		_indexBuffer.capacity = 0;
+
+		_boundIndexBuffer = 0;
+	}
+
+	/// Upload pending changes, bind the buffers and enable the arrays used by the given flags
+	void beginDraw(unsigned int flags)
+	{
+		_drawFlags = flags;
+		_useVBOs = GLEW_VERSION_1_5 ? true : false;
+
+		if (_useVBOs)
+		{
+			upload(GL_ARRAY_BUFFER, _vertexBuffer, _vertices);
+			upload(GL_ELEMENT_ARRAY_BUFFER, _shortIndexBuffer, _shortIndices);
+			upload(GL_ELEMENT_ARRAY_BUFFER, _indexBuffer, _indices);
+
+			_boundIndexBuffer = _indexBuffer.id;
+		}
+
+		if (!(_drawFlags & RENDER_BUMP) && (_drawFlags & RENDER_TEXTURE_2D))
+		{
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+	}
+
+	/// Draw the triangles of the given mesh, must be called between beginDraw() and endDraw()
+	void draw(Handle handle)
+	{
+		const Mesh& mesh = getMesh(handle);
+
+		if (mesh.numIndices == 0)
+		{
+			return;
+		}
+
+		setVertexPointers(mesh);
+
+		if (mesh.shortIndices)
+		{
+			glDrawElements(GL_TRIANGLES, GLsizei(mesh.numIndices), GL_UNSIGNED_SHORT,
+				bindIndices(_shortIndexBuffer, _shortIndices) + mesh.firstIndex * sizeof(uint16_t));
+		}
+		else
+		{
+			glDrawElements(GL_TRIANGLES, GLsizei(mesh.numIndices), GL_UNSIGNED_INT,
+				bindIndices(_indexBuffer, _indices) + mesh.firstIndex * sizeof(uint32_t));
+		}
+	}
+
+	/// Reset the GL state changed by beginDraw() and draw()
+	void endDraw()
+	{
+		glDisableClientState(GL_COLOR_ARRAY);
+
+		if (!(_drawFlags & RENDER_BUMP) && (_drawFlags & RENDER_TEXTURE_2D))
+		{
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+
+		if (_useVBOs)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+			_boundIndexBuffer = 0;
+		}
+	}
+};
+
+/**
+ * An OpenGLRenderable whose geometry is stored in the MeshBufferPool.
+ * Shader passes draw all such renderables in one go, binding the pool
+ * only once.
+ */
+class IPooledMesh
+{
+public:
+	virtual ~IPooledMesh() {}
+
+	/// The mesh in MeshBufferPool::Instance(), INVALID_HANDLE if there's nothing to draw
+	virtual MeshBufferPool::Handle getPooledMesh() const = 0;
+};
+
+}
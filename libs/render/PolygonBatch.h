@@ -0,0 +1,221 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "render.h"
+#include "BatchablePolygon.h"
+
+namespace render
+{
+
+/**
+ * Packs convex polygons into a shared vertex buffer and collects them into
+ * index batches for drawing.
+ *
+ * Every polygon gets a persistent slot in the vertex buffer, which is only
+ * rewritten when the polygon reports a new revision. Slots of polygons which
+ * haven't been drawn for a while are released and reused by polygons of the
+ * same size, the buffer is compacted when too much of it is unused.
+ *
+ * The Buffer_T template parameter is the vertex storage, usually an
+ * IndexedVertexBuffer<BatchVertex>.
+ */
+template<typename Buffer_T>
+class PolygonBatch
+{
+public:
+	// Slots not used in this many calls to begin() are released
+	static const std::size_t MAX_UNUSED_GENERATIONS = 256;
+
+	// Compact the buffer if more vertices are unused than this (and half of the buffer)
+	static const std::size_t COMPACT_THRESHOLD = 4096;
+
+private:
+	Buffer_T _buffer;
+
+	struct Slot
+	{
+		std::size_t offset;
+		std::size_t count;
+		std::size_t revision;
+		std::size_t lastUsed;
+	};
+
+	typedef std::unordered_map<const IBatchablePolygon*, Slot> Slots;
+	Slots _slots;
+
+	// Offsets of released slots, by vertex count
+	std::map<std::size_t, std::vector<std::size_t>> _freeSlots;
+	std::size_t _numFreeVertices;
+
+	std::size_t _generation;
+
+	// Triangle indices of the batch being collected
+	std::vector<RenderIndex> _indices;
+
+public:
+	PolygonBatch() :
+		_numFreeVertices(0),
+		_generation(0)
+	{}
+
+	Buffer_T& getBuffer()
+	{
+		return _buffer;
+	}
+
+	const Buffer_T& getBuffer() const
+	{
+		return _buffer;
+	}
+
+	/// Number of polygons having a slot in the vertex buffer
+	std::size_t getNumSlots() const
+	{
+		return _slots.size();
+	}
+
+	/// Number of vertices in released slots waiting to be reused
+	std::size_t getNumFreeVertices() const
+	{
+		return _numFreeVertices;
+	}
+
+	/**
+	 * Start collecting a new set of batches, the ones of the previous set are
+	 * removed. Releases the slots of polygons which haven't been drawn lately.
+	 */
+	void begin()
+	{
+		_buffer.clearBatches();
+		_indices.clear();
+
+		if (++_generation % MAX_UNUSED_GENERATIONS == 0)
+		{
+			releaseUnusedSlots();
+		}
+
+		if (_numFreeVertices > COMPACT_THRESHOLD && _numFreeVertices > _buffer.getNumVertices() / 2)
+		{
+			// Start over, the polygons still in use get new slots as they're drawn
+			_slots.clear();
+			_freeSlots.clear();
+			_numFreeVertices = 0;
+			_buffer.clearVertices();
+		}
+	}
+
+	/**
+	 * Add the polygon to the current batch, its vertices are copied to the
+	 * vertex buffer if they changed. Polygons with less than three vertices
+	 * are ignored.
+	 */
+	void addPolygon(const IBatchablePolygon& polygon)
+	{
+		std::size_t count = polygon.getNumBatchVertices();
+
+		if (count < 3)
+		{
+			return;
+		}
+
+		std::size_t revision = polygon.getBatchRevision();
+
+		auto found = _slots.find(&polygon);
+
+		if (found == _slots.end())
+		{
+			Slot slot = { allocateSlot(count), count, revision, _generation };
+			found = _slots.emplace(&polygon, slot).first;
+
+			polygon.writeBatchVertices(_buffer.getModifiableVertices(slot.offset, count));
+		}
+		else if (found->second.revision != revision)
+		{
+			Slot& slot = found->second;
+
+			if (slot.count != count)
+			{
+				releaseSlot(slot);
+				slot.offset = allocateSlot(count);
+				slot.count = count;
+			}
+
+			slot.revision = revision;
+			polygon.writeBatchVertices(_buffer.getModifiableVertices(slot.offset, count));
+		}
+
+		found->second.lastUsed = _generation;
+
+		// Triangulate the polygon as a fan around the first vertex
+		RenderIndex first = static_cast<RenderIndex>(found->second.offset);
+
+		for (RenderIndex i = 1; i + 1 < count; ++i)
+		{
+			_indices.push_back(first);
+			_indices.push_back(first + i);
+			_indices.push_back(first + i + 1);
+		}
+	}
+
+	/**
+	 * Finish the current batch and add it to the buffer. Returns false if no
+	 * polygons have been added since the last call, in which case no batch
+	 * is created.
+	 */
+	bool endBatch()
+	{
+		if (_indices.empty())
+		{
+			return false;
+		}
+
+		_buffer.addIndexBatch(_indices.begin(), _indices.size());
+		_indices.clear();
+
+		return true;
+	}
+
+private:
+	std::size_t allocateSlot(std::size_t count)
+	{
+		auto found = _freeSlots.find(count);
+
+		if (found == _freeSlots.end() || found->second.empty())
+		{
+			return _buffer.allocateVertices(count);
+		}
+
+		std::size_t offset = found->second.back();
+		found->second.pop_back();
+		_numFreeVertices -= count;
+
+		return offset;
+	}
+
+	void releaseSlot(const Slot& slot)
+	{
+		_freeSlots[slot.count].push_back(slot.offset);
+		_numFreeVertices += slot.count;
+	}
+
+	void releaseUnusedSlots()
+	{
+		for (auto i = _slots.begin(); i != _slots.end();)
+		{
+			if (_generation - i->second.lastUsed >= MAX_UNUSED_GENERATIONS)
+			{
+				releaseSlot(i->second);
+				i = _slots.erase(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+};
+
+}
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace render
+{
+
+/**
+ * Accounting of the memory used by the GL textures which can be reloaded
+ * on demand, keeping it within a byte budget.
+ *
+ * The render backend marks the textures it binds as used. Once the budget
+ * is exceeded, selectChanges() picks the textures which haven't been drawn
+ * for the longest time. These are first reduced to their lower mip levels,
+ * which needs a sixteenth of the memory. If that is not enough, textures
+ * are evicted entirely. Textures drawn while not completely resident are
+ * reported by takeReloadRequests().
+ *
+ * This class contains the bookkeeping only, it doesn't make any GL calls.
+ * The texture manager carries out the changes and reports the new state
+ * through setResident() and setEvicted().
+ */
+class TextureResidency
+{
+public:
+	// The GL texture number
+	typedef unsigned int TextureId;
+
+	// Resident level of evicted textures
+	static const std::size_t EVICTED = std::numeric_limits<std::size_t>::max();
+
+	// Number of mip levels dropped from textures which haven't been drawn recently
+	static const std::size_t REDUCED_LEVEL = 2;
+
+	struct Change
+	{
+		TextureId texture;
+
+		// The first mip level to keep, EVICTED to drop all of them
+		std::size_t firstLevel;
+	};
+
+private:
+	struct Entry
+	{
+		// Memory used by the complete mip chain
+		std::size_t fullBytes;
+		std::size_t numLevels;
+
+		// First mip level in GL memory, EVICTED if none
+		std::size_t firstLevel;
+
+		// Frame this texture has been bound the last time
+		std::size_t lastUsed;
+
+		// True while a reload or reduction is on its way
+		bool changePending;
+	};
+
+	std::unordered_map<TextureId, Entry> _entries;
+
+	// Textures drawn while not completely resident
+	std::vector<TextureId> _reloadRequests;
+
+	std::size_t _budget;
+	std::size_t _frame;
+
+	// Memory used by the resident levels, pending reductions already subtracted
+	std::size_t _residentBytes;
+
+	std::size_t _numReductions;
+	std::size_t _numEvictions;
+	std::size_t _numReloads;
+
+public:
+	TextureResidency() :
+		_budget(0),
+		_frame(1),
+		_residentBytes(0),
+		_numReductions(0),
+		_numEvictions(0),
+		_numReloads(0)
+	{}
+
+	/// Memory used by the given level and the ones below it, each level needs a quarter of the previous one
+	static std::size_t getLevelBytes(std::size_t fullBytes, std::size_t firstLevel)
+	{
+		if (firstLevel == EVICTED) return 0;
+		if (firstLevel >= sizeof(std::size_t) * 4) return std::min<std::size_t>(fullBytes, 1);
+
+		return std::max<std::size_t>(fullBytes >> (2 * firstLevel), std::min<std::size_t>(fullBytes, 1));
+	}
+
+	/// Number of levels of a complete mip chain for an image of the given size
+	static std::size_t getNumLevels(std::size_t width, std::size_t height)
+	{
+		std::size_t numLevels = 1;
+
+		for (std::size_t size = std::max(width, height); size > 1; size >>= 1)
+		{
+			++numLevels;
+		}
+
+		return numLevels;
+	}
+
+	/// Set the budget in bytes, 0 disables the limit
+	void setBudget(std::size_t bytes)
+	{
+		_budget = bytes;
+	}
+
+	std::size_t getBudget() const
+	{
+		return _budget;
+	}
+
+	/// Start a new frame, textures used in the current frame are never reduced or evicted
+	void nextFrame()
+	{
+		++_frame;
+	}
+
+	/// Report the levels of the texture which have been uploaded to GL, adding it if necessary
+	void setResident(TextureId texture, std::size_t fullBytes, std::size_t numLevels, std::size_t firstLevel)
+	{
+		auto found = _entries.find(texture);
+
+		if (found == _entries.end())
+		{
+			found = _entries.emplace(texture, Entry{ fullBytes, numLevels, EVICTED, _frame, false }).first;
+		}
+
+		Entry& entry = found->second;
+
+		_residentBytes -= getLevelBytes(entry.fullBytes, entry.firstLevel);
+
+		entry.fullBytes = fullBytes;
+		entry.numLevels = numLevels;
+		entry.firstLevel = firstLevel;
+		entry.changePending = false;
+
+		_residentBytes += getLevelBytes(entry.fullBytes, entry.firstLevel);
+	}
+
+	/// Report that the texture has been replaced by a placeholder
+	void setEvicted(TextureId texture)
+	{
+		auto found = _entries.find(texture);
+
+		if (found == _entries.end()) return;
+
+		_residentBytes -= getLevelBytes(found->second.fullBytes, found->second.firstLevel);
+
+		found->second.firstLevel = EVICTED;
+		found->second.changePending = false;
+	}
+
+	/// Stop tracking the texture, e.g. before it is deleted
+	void remove(TextureId texture)
+	{
+		auto found = _entries.find(texture);
+
+		if (found == _entries.end()) return;
+
+		_residentBytes -= getLevelBytes(found->second.fullBytes, found->second.firstLevel);
+		_entries.erase(found);
+	}
+
+	/// Called by the render backend when binding the given texture
+	void markUsed(TextureId texture)
+	{
+		if (_entries.empty()) return;
+
+		auto found = _entries.find(texture);
+
+		if (found == _entries.end()) return;
+
+		Entry& entry = found->second;
+		entry.lastUsed = _frame;
+
+		if (entry.firstLevel != 0 && !entry.changePending)
+		{
+			entry.changePending = true;
+			_reloadRequests.push_back(texture);
+			++_numReloads;
+		}
+	}
+
+	/// Returns the textures to be reloaded at full resolution, clearing the list
+	std::vector<TextureId> takeReloadRequests()
+	{
+		std::vector<TextureId> requests;
+		requests.swap(_reloadRequests);
+
+		return requests;
+	}
+
+	/**
+	 * If the budget is exceeded, choose the textures to be reduced or
+	 * evicted, least recently used first. The chosen textures are expected
+	 * to be changed, they are accounted with their new size right away.
+	 */
+	std::vector<Change> selectChanges()
+	{
+		std::vector<Change> changes;
+
+		if (_budget == 0 || _residentBytes <= _budget)
+		{
+			return changes;
+		}
+
+		// Candidates are all resident textures not drawn in this frame
+		std::vector<std::pair<std::size_t, TextureId>> candidates;
+
+		for (const auto& pair : _entries)
+		{
+			const Entry& entry = pair.second;
+
+			if (entry.firstLevel != EVICTED && !entry.changePending && entry.lastUsed < _frame)
+			{
+				candidates.emplace_back(entry.lastUsed, pair.first);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+
+		// Reduce to the lower mip levels first, keeping something to display
+		for (const auto& candidate : candidates)
+		{
+			if (_residentBytes <= _budget) break;
+
+			Entry& entry = _entries[candidate.second];
+
+			if (entry.firstLevel >= REDUCED_LEVEL || entry.numLevels <= REDUCED_LEVEL) continue;
+
+			_residentBytes -= getLevelBytes(entry.fullBytes, entry.firstLevel);
+			_residentBytes += getLevelBytes(entry.fullBytes, REDUCED_LEVEL);
+
+			entry.firstLevel = REDUCED_LEVEL;
+			entry.changePending = true;
+
+			changes.push_back(Change{ candidate.second, REDUCED_LEVEL });
+			++_numReductions;
+		}
+
+		// Evict entirely if this wasn't enough
+		for (const auto& candidate : candidates)
+		{
+			if (_residentBytes <= _budget) break;
+
+			Entry& entry = _entries[candidate.second];
+
+			_residentBytes -= getLevelBytes(entry.fullBytes, entry.firstLevel);
+
+			entry.firstLevel = EVICTED;
+			entry.changePending = true;
+
+			// Replace a reduction chosen above
+			auto existing = std::find_if(changes.begin(), changes.end(),
+				[&](const Change& change) { return change.texture == candidate.second; });
+
+			if (existing != changes.end())
+			{
+				existing->firstLevel = EVICTED;
+				--_numReductions;
+			}
+			else
+			{
+				changes.push_back(Change{ candidate.second, EVICTED });
+			}
+
+			++_numEvictions;
+		}
+
+		return changes;
+	}
+
+	/// The number of bytes used by the tracked textures
+	std::size_t getResidentBytes() const
+	{
+		return _residentBytes;
+	}
+
+	std::size_t getNumTextures() const
+	{
+		return _entries.size();
+	}
+
+	/// The number of textures reduced to their lower mip levels so far
+	std::size_t getNumReductions() const
+	{
+		return _numReductions;
+	}
+
+	/// The number of textures evicted so far
+	std::size_t getNumEvictions() const
+	{
+		return _numEvictions;
+	}
+
+	/// The number of textures reloaded after being reduced or evicted
+	std::size_t getNumReloads() const
+	{
+		return _numReloads;
+	}
+
+	/// The instance used by the texture manager and the render backend
+	static TextureResidency& Instance()
+	{
+		static TextureResidency _instance;
+		return _instance;
+	}
+};
+
+}
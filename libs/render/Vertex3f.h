@@ -60,6 +60,8 @@ namespace render
 template<> class VertexTraits<Vertex3f>
 {
 public:
+    typedef double ComponentType;
+
     static const void* VERTEX_OFFSET()
     {
         return 0;
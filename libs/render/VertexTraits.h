@@ -10,7 +10,8 @@ namespace render
  * Specialisations of this class provide the VBO-related code with a mechanism
  * to determine what vertex properties a particular class provides (e.g.
  * normal, colour, texcoord etc), and to obtain the byte offsets of each
- * property within the class.
+ * property within the class. The ComponentType typedef names the scalar type
+ * of the vertex components (float or double).
  */
 template<typename V> class VertexTraits
 {
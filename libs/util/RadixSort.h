@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace util
+{
+
+/**
+ * Stable LSD radix sort of the given items by the unsigned integer returned
+ * by getKey(item), processing 8 bits per pass. Passes over key bytes which
+ * are the same for all items are skipped, so sorting items which are already
+ * grouped by a few distinct keys is cheap.
+ *
+ * The scratch vector is used as temporary storage, the contents of the two
+ * vectors may be swapped. Pass the same one for repeated sorts to avoid
+ * reallocations. Items need to be default-constructible.
+ */
+template<typename T, typename KeyFunc>
+void radixSort(std::vector<T>& items, std::vector<T>& scratch, KeyFunc getKey)
+{
+    typedef typename std::decay<decltype(getKey(items.front()))>::type Key;
+    static_assert(std::is_unsigned<Key>::value, "Radix sort keys must be unsigned integers");
+
+    const std::size_t NUM_BYTES = sizeof(Key);
+
+    if (items.size() < 2)
+    {
+        return;
+    }
+
+    // Count the occurrences of each byte value in all key positions at once
+    std::array<std::array<std::size_t, 256>, NUM_BYTES> histograms = {};
+
+    for (const T& item : items)
+    {
+        Key key = getKey(item);
+
+        for (std::size_t b = 0; b < NUM_BYTES; ++b)
+        {
+            ++histograms[b][(key >> (b * 8)) & 0xff];
+        }
+    }
+
+    Key firstKey = getKey(items.front());
+
+    for (std::size_t b = 0; b < NUM_BYTES; ++b)
+    {
+        std::array<std::size_t, 256>& histogram = histograms[b];
+
+        // All items share this byte, the pass wouldn't change the order
+        if (histogram[(firstKey >> (b * 8)) & 0xff] == items.size())
+        {
+            continue;
+        }
+
+        // Turn the counts into the start offset of each bucket
+        std::size_t offset = 0;
+
+        for (std::size_t& count : histogram)
+        {
+            std::size_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        scratch.resize(items.size());
+
+        for (T& item : items)
+        {
+            std::size_t bucket = (getKey(item) >> (b * 8)) & 0xff;
+            scratch[histogram[bucket]++] = std::move(item);
+        }
+
+        items.swap(scratch);
+    }
+}
+
+}
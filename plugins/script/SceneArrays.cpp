@@ -0,0 +1,307 @@
+#include "SceneArrays.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "ipatch.h"
+#include "ientity.h"
+#include "iundo.h"
+
+#include "math/Matrix4.h"
+#include "math/Plane3.h"
+
+namespace script
+{
+
+namespace arrays
+{
+
+namespace
+{
+	// Column layout of the patch control and winding vertex arrays
+	const std::size_t CONTROL_COLUMNS = 5;
+	const std::size_t VERTEX_COLUMNS = 3;
+
+	// Windings spanning less than this area don't define a plane
+	const double MIN_WINDING_AREA = 1e-6;
+
+	void checkRows(const char* name, std::size_t rows, std::size_t expected)
+	{
+		if (rows != expected)
+		{
+			std::ostringstream msg;
+			msg << name << ": expected " << expected << " rows, got " << rows;
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	Vector3 getVertex(const DoubleArrayView& vertices, std::size_t row)
+	{
+		const double* v = vertices.data + row * vertices.shape[1];
+		return Vector3(v[0], v[1], v[2]);
+	}
+
+	// Returns the plane of the given winding, using the largest triangle of the
+	// fan around its first vertex, this way collinear vertices don't matter
+	Plane3 getWindingPlane(const DoubleArrayView& vertices, std::size_t begin, std::size_t end, std::size_t face)
+	{
+		Vector3 first = getVertex(vertices, begin);
+		Vector3 second;
+		Vector3 third;
+		double largestArea = 0;
+
+		for (std::size_t i = begin + 1; i + 1 < end; ++i)
+		{
+			Vector3 a = getVertex(vertices, i);
+			Vector3 b = getVertex(vertices, i + 1);
+			double area = (a - first).crossProduct(b - first).getLength();
+
+			if (area > largestArea)
+			{
+				largestArea = area;
+				second = a;
+				third = b;
+			}
+		}
+
+		if (!(largestArea > MIN_WINDING_AREA))
+		{
+			std::ostringstream msg;
+			msg << "setWindings: the winding of face " << face << " doesn't span a plane";
+			throw std::invalid_argument(msg.str());
+		}
+
+		// Brush windings are wound clockwise when looking against the face normal
+		return Plane3(first, third, second);
+	}
+}
+
+std::size_t countFaces(const std::vector<scene::INodePtr>& nodes)
+{
+	std::size_t count = 0;
+
+	for (const scene::INodePtr& node : nodes)
+	{
+		IBrush* brush = Node_getIBrush(node);
+		count += brush != NULL ? brush->getNumFaces() : 0;
+	}
+
+	return count;
+}
+
+void setFacePlanes(const std::vector<scene::INodePtr>& nodes, const DoubleArrayView& planes)
+{
+	if (planes.ndim() != 2 || planes.shape[1] != 4)
+	{
+		throw std::invalid_argument("setFacePlanes: expected an array of shape [F,4]");
+	}
+
+	checkRows("setFacePlanes", planes.shape[0], countFaces(nodes));
+
+	UndoableCommand cmd("setFacePlanes");
+
+	foreachFace(nodes, [&](IFace& face, std::size_t row)
+	{
+		const double* in = planes.data + row * 4;
+		face.setPlane3(Plane3(in[0], in[1], in[2], in[3]));
+	});
+}
+
+void setTexDefMatrices(const std::vector<scene::INodePtr>& nodes, const DoubleArrayView& matrices)
+{
+	if (matrices.ndim() != 3 || matrices.shape[1] != 2 || matrices.shape[2] != 3)
+	{
+		throw std::invalid_argument("setTexDefMatrices: expected an array of shape [F,2,3]");
+	}
+
+	checkRows("setTexDefMatrices", matrices.shape[0], countFaces(nodes));
+
+	UndoableCommand cmd("setTexDefMatrices");
+
+	foreachFace(nodes, [&](IFace& face, std::size_t row)
+	{
+		const double* in = matrices.data + row * 6;
+		Matrix4 matrix = Matrix4::getIdentity();
+
+		matrix.xx() = in[0];
+		matrix.yx() = in[1];
+		matrix.tx() = in[2];
+		matrix.xy() = in[3];
+		matrix.yy() = in[4];
+		matrix.ty() = in[5];
+
+		face.setTexDefMatrix(matrix);
+	});
+}
+
+void setWindings(const std::vector<scene::INodePtr>& nodes, const DoubleArrayView& vertices,
+	const IndexArrayView& offsets)
+{
+	if (vertices.ndim() != 2 || (vertices.shape[1] != CONTROL_COLUMNS && vertices.shape[1] != VERTEX_COLUMNS))
+	{
+		throw std::invalid_argument("setWindings: expected vertices of shape [V,5] or [V,3]");
+	}
+
+	if (offsets.ndim() != 1)
+	{
+		throw std::invalid_argument("setWindings: expected offsets of shape [F+1]");
+	}
+
+	std::size_t numFaces = countFaces(nodes);
+	checkRows("setWindings", offsets.shape[0], numFaces + 1);
+
+	if (offsets.data[0] != 0 || offsets.data[numFaces] != static_cast<std::int64_t>(vertices.shape[0]))
+	{
+		throw std::invalid_argument("setWindings: the offsets need to start at 0 and end at the number of vertices");
+	}
+
+	// Offsets outside of [0,V] or going backwards would read outside of the vertex array
+	for (std::size_t i = 1; i < numFaces; ++i)
+	{
+		if (offsets.data[i] < offsets.data[i - 1] ||
+			offsets.data[i] > static_cast<std::int64_t>(vertices.shape[0]))
+		{
+			std::ostringstream msg;
+			msg << "setWindings: offset " << i << " needs to be within [" << offsets.data[i - 1]
+				<< "," << vertices.shape[0] << "], got " << offsets.data[i];
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	// Derive all planes before touching any face
+	std::vector<Plane3> planes;
+	planes.reserve(numFaces);
+
+	for (std::size_t face = 0; face < numFaces; ++face)
+	{
+		std::int64_t begin = offsets.data[face];
+		std::int64_t end = offsets.data[face + 1];
+
+		if (end - begin < 3)
+		{
+			std::ostringstream msg;
+			msg << "setWindings: the winding of face " << face << " needs at least 3 vertices";
+			throw std::invalid_argument(msg.str());
+		}
+
+		planes.push_back(getWindingPlane(vertices, begin, end, face));
+	}
+
+	UndoableCommand cmd("setWindings");
+
+	foreachFace(nodes, [&](IFace& face, std::size_t row)
+	{
+		face.setPlane3(planes[row]);
+	});
+}
+
+void setPatchControls(const std::vector<scene::INodePtr>& nodes, const std::vector<DoubleArrayView>& controls)
+{
+	checkRows("setPatchControls", controls.size(), nodes.size());
+
+	// Check all arrays before touching any patch
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		const DoubleArrayView& array = controls[i];
+		IPatch* patch = Node_getIPatch(nodes[i]);
+
+		if (array.data == NULL || patch == NULL) continue;
+
+		if (array.ndim() != 3 ||
+			array.shape[0] != patch->getHeight() || array.shape[1] != patch->getWidth() ||
+			(array.shape[2] != CONTROL_COLUMNS && array.shape[2] != VERTEX_COLUMNS))
+		{
+			std::ostringstream msg;
+			msg << "setPatchControls: expected an array of shape [" << patch->getHeight() << ","
+				<< patch->getWidth() << ",5] or [" << patch->getHeight() << ","
+				<< patch->getWidth() << ",3] at index " << i;
+			throw std::invalid_argument(msg.str());
+		}
+	}
+
+	UndoableCommand cmd("setPatchControls");
+
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		const DoubleArrayView& array = controls[i];
+		IPatch* patch = Node_getIPatch(nodes[i]);
+
+		if (array.data == NULL || patch == NULL) continue;
+
+		std::size_t columns = array.shape[2];
+		const double* in = array.data;
+
+		patch->undoSave();
+
+		for (std::size_t row = 0; row < patch->getHeight(); ++row)
+		{
+			for (std::size_t col = 0; col < patch->getWidth(); ++col, in += columns)
+			{
+				PatchControl& ctrl = patch->ctrlAt(row, col);
+
+				ctrl.vertex = Vector3(in[0], in[1], in[2]);
+
+				if (columns == CONTROL_COLUMNS)
+				{
+					ctrl.texcoord = Vector2(in[3], in[4]);
+				}
+			}
+		}
+
+		// Update the tesselation once per patch
+		patch->controlPointsChanged();
+	}
+}
+
+void setSpawnargs(const std::vector<scene::INodePtr>& nodes, const std::string& key,
+	const std::vector<std::string>& values)
+{
+	checkRows("setSpawnargs", values.size(), nodes.size());
+
+	UndoableCommand cmd("setSpawnargs");
+
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		Entity* entity = Node_getEntity(nodes[i]);
+
+		if (entity != NULL)
+		{
+			entity->setKeyValue(key, values[i]);
+		}
+	}
+}
+
+void setSpawnargVectors(const std::vector<scene::INodePtr>& nodes, const std::string& key,
+	const DoubleArrayView& values)
+{
+	if (values.ndim() != 1 && values.ndim() != 2)
+	{
+		throw std::invalid_argument("setSpawnargVectors: expected an array of shape [N] or [N,k]");
+	}
+
+	checkRows("setSpawnargVectors", values.shape[0], nodes.size());
+
+	std::size_t columns = values.ndim() == 2 ? values.shape[1] : 1;
+
+	UndoableCommand cmd("setSpawnargVectors");
+
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+	{
+		Entity* entity = Node_getEntity(nodes[i]);
+		if (entity == NULL) continue;
+
+		// Same format as a Vector3 written to a stream
+		std::ostringstream str;
+
+		for (std::size_t col = 0; col < columns; ++col)
+		{
+			str << (col > 0 ? " " : "") << values.data[i * columns + col];
+		}
+
+		entity->setKeyValue(key, str.str());
+	}
+}
+
+} // namespace arrays
+
+} // namespace script
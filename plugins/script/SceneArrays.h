@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "inode.h"
+#include "ibrush.h"
+
+namespace script
+{
+
+/**
+ * The node side of the SceneArrays script interface, working on plain
+ * C-contiguous buffers instead of numpy arrays.
+ *
+ * Each setter checks the shape and content of its whole input first and
+ * throws std::invalid_argument without touching any node if it doesn't
+ * fit. All changes of a setter are recorded in a single undo operation,
+ * or become part of the operation which is already running.
+ */
+namespace arrays
+{
+
+// Read-only view of a row-major array, a NULL data pointer stands for None
+template<typename Element>
+struct ArrayView
+{
+	const Element* data;
+	std::vector<std::size_t> shape;
+
+	std::size_t ndim() const
+	{
+		return shape.size();
+	}
+};
+
+typedef ArrayView<double> DoubleArrayView;
+typedef ArrayView<std::int64_t> IndexArrayView;
+
+// The number of faces of all brushes among the given nodes
+std::size_t countFaces(const std::vector<scene::INodePtr>& nodes);
+
+// Calls the functor for every face of the given nodes, in the order of the face arrays
+template<typename FaceFunctor>
+void foreachFace(const std::vector<scene::INodePtr>& nodes, const FaceFunctor& functor)
+{
+	std::size_t row = 0;
+
+	for (const scene::INodePtr& node : nodes)
+	{
+		IBrush* brush = Node_getIBrush(node);
+		if (brush == NULL) continue;
+
+		for (std::size_t i = 0; i < brush->getNumFaces(); ++i)
+		{
+			functor(brush->getFace(i), row++);
+		}
+	}
+}
+
+// [F,4] planes as (a, b, c, d)
+void setFacePlanes(const std::vector<scene::INodePtr>& nodes, const DoubleArrayView& planes);
+
+// [F,2,3] texture matrices as ((xx, yx, tx), (xy, yy, ty))
+void setTexDefMatrices(const std::vector<scene::INodePtr>& nodes, const DoubleArrayView& matrices);
+
+// [V,3] or [V,5] winding vertices plus the [F+1] offsets, as returned by getWindings().
+// Each face plane is rebuilt from its winding, the texture coordinates are ignored.
+void setWindings(const std::vector<scene::INodePtr>& nodes, const DoubleArrayView& vertices,
+	const IndexArrayView& offsets);
+
+// One [H,W,5] or [H,W,3] array per node, entries with NULL data are skipped
+void setPatchControls(const std::vector<scene::INodePtr>& nodes, const std::vector<DoubleArrayView>& controls);
+
+// One value per node, non-entities are skipped
+void setSpawnargs(const std::vector<scene::INodePtr>& nodes, const std::string& key,
+	const std::vector<std::string>& values);
+
+// [N] or [N,k], each row is written as space separated values
+void setSpawnargVectors(const std::vector<scene::INodePtr>& nodes, const std::string& key,
+	const DoubleArrayView& values);
+
+} // namespace arrays
+
+} // namespace script
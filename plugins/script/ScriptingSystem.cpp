@@ -30,6 +30,7 @@
 #include "interfaces/BrushInterface.h"
 #include "interfaces/PatchInterface.h"
 #include "interfaces/EntityInterface.h"
+#include "interfaces/SceneArrayInterface.h"
 #include "interfaces/MapInterface.h"
 #include "interfaces/CommandSystemInterface.h"
 #include "interfaces/GameInterface.h"
@@ -444,6 +445,7 @@ void ScriptingSystem::initialiseModule(const ApplicationContext& ctx)
 	addInterface("Brush", std::make_shared<BrushInterface>());
 	addInterface("Patch", std::make_shared<PatchInterface>());
 	addInterface("Entity", std::make_shared<EntityInterface>());
+	addInterface("SceneArrays", std::make_shared<SceneArrayInterface>());
 	addInterface("Radiant", std::make_shared<RadiantInterface>());
 	addInterface("Map", std::make_shared<MapInterface>());
 	addInterface("FileSystem", std::make_shared<FileSystemInterface>());
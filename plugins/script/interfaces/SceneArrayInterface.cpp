@@ -0,0 +1,317 @@
+#include "SceneArrayInterface.h"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "ibrush.h"
+#include "ipatch.h"
+#include "ientity.h"
+
+#include "math/Matrix4.h"
+#include "string/convert.h"
+
+#include "SceneGraphInterface.h"
+#include "../SceneArrays.h"
+
+namespace script
+{
+
+namespace
+{
+	// Column layout of the patch control arrays
+	const std::size_t PATCH_CONTROL_COLUMNS = 5;
+
+	// Wraps the buffer of the given numpy array, which needs to outlive the view
+	template<typename Element, int Flags>
+	arrays::ArrayView<Element> getView(const py::array_t<Element, Flags>& array)
+	{
+		return arrays::ArrayView<Element>{ array.data(),
+			std::vector<std::size_t>(array.shape(), array.shape() + array.ndim()) };
+	}
+}
+
+std::vector<scene::INodePtr> SceneArrayInterface::getNodes(const py::iterable& nodes)
+{
+	std::vector<scene::INodePtr> result;
+
+	for (auto item : nodes)
+	{
+		// Expired or NULL nodes are kept, to preserve the indices
+		result.push_back(static_cast<scene::INodePtr>(item.cast<ScriptSceneNode>()));
+	}
+
+	return result;
+}
+
+py::array_t<std::int64_t> SceneArrayInterface::getFaceCounts(const py::iterable& nodes)
+{
+	std::vector<scene::INodePtr> list = getNodes(nodes);
+
+	py::array_t<std::int64_t> counts(list.size());
+	auto out = counts.mutable_unchecked<1>();
+
+	for (std::size_t i = 0; i < list.size(); ++i)
+	{
+		IBrush* brush = Node_getIBrush(list[i]);
+		out(i) = brush != NULL ? brush->getNumFaces() : 0;
+	}
+
+	return counts;
+}
+
+SceneArrayInterface::DoubleArray SceneArrayInterface::getFacePlanes(const py::iterable& nodes)
+{
+	std::vector<scene::INodePtr> list = getNodes(nodes);
+
+	DoubleArray planes({ arrays::countFaces(list), std::size_t(4) });
+	auto out = planes.mutable_unchecked<2>();
+
+	arrays::foreachFace(list, [&](IFace& face, std::size_t row)
+	{
+		const Plane3& plane = face.getPlane3();
+
+		out(row, 0) = plane.normal().x();
+		out(row, 1) = plane.normal().y();
+		out(row, 2) = plane.normal().z();
+		out(row, 3) = plane.dist();
+	});
+
+	return planes;
+}
+
+void SceneArrayInterface::setFacePlanes(const py::iterable& nodes, const DoubleArray& planes)
+{
+	arrays::setFacePlanes(getNodes(nodes), getView(planes));
+}
+
+SceneArrayInterface::DoubleArray SceneArrayInterface::getTexDefMatrices(const py::iterable& nodes)
+{
+	std::vector<scene::INodePtr> list = getNodes(nodes);
+
+	DoubleArray matrices({ arrays::countFaces(list), std::size_t(2), std::size_t(3) });
+	auto out = matrices.mutable_unchecked<3>();
+
+	arrays::foreachFace(list, [&](IFace& face, std::size_t row)
+	{
+		Matrix4 matrix = face.getTexDefMatrix();
+
+		out(row, 0, 0) = matrix.xx();
+		out(row, 0, 1) = matrix.yx();
+		out(row, 0, 2) = matrix.tx();
+		out(row, 1, 0) = matrix.xy();
+		out(row, 1, 1) = matrix.yy();
+		out(row, 1, 2) = matrix.ty();
+	});
+
+	return matrices;
+}
+
+void SceneArrayInterface::setTexDefMatrices(const py::iterable& nodes, const DoubleArray& matrices)
+{
+	arrays::setTexDefMatrices(getNodes(nodes), getView(matrices));
+}
+
+py::tuple SceneArrayInterface::getWindings(const py::iterable& nodes)
+{
+	std::vector<scene::INodePtr> list = getNodes(nodes);
+
+	// Evaluating the bounds brings the windings of modified brushes up to date
+	for (const scene::INodePtr& node : list)
+	{
+		if (Node_getIBrush(node) != NULL)
+		{
+			node->localAABB();
+		}
+	}
+
+	std::size_t numVertices = 0;
+
+	arrays::foreachFace(list, [&](IFace& face, std::size_t)
+	{
+		numVertices += face.getWinding().size();
+	});
+
+	DoubleArray vertices({ numVertices, std::size_t(5) });
+	py::array_t<std::int64_t> offsets(arrays::countFaces(list) + 1);
+
+	auto vertexOut = vertices.mutable_unchecked<2>();
+	auto offsetOut = offsets.mutable_unchecked<1>();
+
+	std::size_t vertex = 0;
+	offsetOut(0) = 0;
+
+	arrays::foreachFace(list, [&](IFace& face, std::size_t row)
+	{
+		for (const WindingVertex& w : face.getWinding())
+		{
+			vertexOut(vertex, 0) = w.vertex.x();
+			vertexOut(vertex, 1) = w.vertex.y();
+			vertexOut(vertex, 2) = w.vertex.z();
+			vertexOut(vertex, 3) = w.texcoord.x();
+			vertexOut(vertex, 4) = w.texcoord.y();
+			++vertex;
+		}
+
+		offsetOut(row + 1) = vertex;
+	});
+
+	return py::make_tuple(vertices, offsets);
+}
+
+void SceneArrayInterface::setWindings(const py::iterable& nodes, const DoubleArray& vertices, const IndexArray& offsets)
+{
+	arrays::setWindings(getNodes(nodes), getView(vertices), getView(offsets));
+}
+
+py::list SceneArrayInterface::getPatchControls(const py::iterable& nodes)
+{
+	py::list result;
+
+	for (const scene::INodePtr& node : getNodes(nodes))
+	{
+		IPatch* patch = Node_getIPatch(node);
+
+		if (patch == NULL)
+		{
+			result.append(py::none());
+			continue;
+		}
+
+		DoubleArray controls({ patch->getHeight(), patch->getWidth(), PATCH_CONTROL_COLUMNS });
+		auto out = controls.mutable_unchecked<3>();
+
+		for (std::size_t row = 0; row < patch->getHeight(); ++row)
+		{
+			for (std::size_t col = 0; col < patch->getWidth(); ++col)
+			{
+				const PatchControl& ctrl = patch->ctrlAt(row, col);
+
+				out(row, col, 0) = ctrl.vertex.x();
+				out(row, col, 1) = ctrl.vertex.y();
+				out(row, col, 2) = ctrl.vertex.z();
+				out(row, col, 3) = ctrl.texcoord.x();
+				out(row, col, 4) = ctrl.texcoord.y();
+			}
+		}
+
+		result.append(controls);
+	}
+
+	return result;
+}
+
+void SceneArrayInterface::setPatchControls(const py::iterable& nodes, const py::sequence& controls)
+{
+	// Convert all arrays first, the views are referring to them
+	std::vector<DoubleArray> converted;
+	std::vector<arrays::DoubleArrayView> views;
+
+	converted.reserve(controls.size());
+	views.reserve(controls.size());
+
+	for (std::size_t i = 0; i < controls.size(); ++i)
+	{
+		py::object item = controls[i];
+
+		if (item.is_none())
+		{
+			views.push_back(arrays::DoubleArrayView{ NULL, std::vector<std::size_t>() });
+			continue;
+		}
+
+		converted.push_back(DoubleArray::ensure(item));
+
+		if (!converted.back())
+		{
+			throw std::invalid_argument("setPatchControls: expected a float array or None at index " + std::to_string(i));
+		}
+
+		views.push_back(getView(converted.back()));
+	}
+
+	arrays::setPatchControls(getNodes(nodes), views);
+}
+
+py::array SceneArrayInterface::getSpawnargs(const py::iterable& nodes, const std::string& key)
+{
+	py::list values;
+
+	for (const scene::INodePtr& node : getNodes(nodes))
+	{
+		Entity* entity = Node_getEntity(node);
+		values.append(py::str(entity != NULL ? entity->getKeyValue(key) : std::string()));
+	}
+
+	// Object arrays keep the Python strings, without padding them to a common length
+	return py::module::import("numpy").attr("array")(values, py::arg("dtype") = "object");
+}
+
+void SceneArrayInterface::setSpawnargs(const py::iterable& nodes, const std::string& key, const py::sequence& values)
+{
+	// Python's str() is applied to non-string values
+	std::vector<std::string> strings;
+	strings.reserve(values.size());
+
+	for (auto value : values)
+	{
+		strings.push_back(py::str(value).cast<std::string>());
+	}
+
+	arrays::setSpawnargs(getNodes(nodes), key, strings);
+}
+
+SceneArrayInterface::DoubleArray SceneArrayInterface::getSpawnargVectors(const py::iterable& nodes, const std::string& key)
+{
+	std::vector<scene::INodePtr> list = getNodes(nodes);
+
+	DoubleArray vectors({ list.size(), std::size_t(3) });
+	auto out = vectors.mutable_unchecked<2>();
+
+	const Vector3 unset(std::numeric_limits<double>::quiet_NaN(),
+		std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+
+	for (std::size_t i = 0; i < list.size(); ++i)
+	{
+		Entity* entity = Node_getEntity(list[i]);
+		std::string value = entity != NULL ? entity->getKeyValue(key) : std::string();
+
+		Vector3 vector = value.empty() ? unset : string::convert<Vector3>(value, unset);
+
+		out(i, 0) = vector.x();
+		out(i, 1) = vector.y();
+		out(i, 2) = vector.z();
+	}
+
+	return vectors;
+}
+
+void SceneArrayInterface::setSpawnargVectors(const py::iterable& nodes, const std::string& key, const DoubleArray& values)
+{
+	arrays::setSpawnargVectors(getNodes(nodes), key, getView(values));
+}
+
+void SceneArrayInterface::registerInterface(py::module& scope, py::dict& globals)
+{
+	// Add the SceneArrays module declaration to the given python namespace
+	py::class_<SceneArrayInterface> sceneArrays(scope, "SceneArrays");
+
+	sceneArrays.def("getFaceCounts", &SceneArrayInterface::getFaceCounts);
+	sceneArrays.def("getFacePlanes", &SceneArrayInterface::getFacePlanes);
+	sceneArrays.def("setFacePlanes", &SceneArrayInterface::setFacePlanes);
+	sceneArrays.def("getTexDefMatrices", &SceneArrayInterface::getTexDefMatrices);
+	sceneArrays.def("setTexDefMatrices", &SceneArrayInterface::setTexDefMatrices);
+	sceneArrays.def("getWindings", &SceneArrayInterface::getWindings);
+	sceneArrays.def("setWindings", &SceneArrayInterface::setWindings);
+	sceneArrays.def("getPatchControls", &SceneArrayInterface::getPatchControls);
+	sceneArrays.def("setPatchControls", &SceneArrayInterface::setPatchControls);
+	sceneArrays.def("getSpawnargs", &SceneArrayInterface::getSpawnargs);
+	sceneArrays.def("setSpawnargs", &SceneArrayInterface::setSpawnargs);
+	sceneArrays.def("getSpawnargVectors", &SceneArrayInterface::getSpawnargVectors);
+	sceneArrays.def("setSpawnargVectors", &SceneArrayInterface::setSpawnargVectors);
+
+	// Now point the Python variable "GlobalSceneArrays" to this instance
+	globals["GlobalSceneArrays"] = this;
+}
+
+} // namespace script
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "iscript.h"
+#include "inode.h"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+
+namespace script
+{
+
+/**
+ * Bulk access to the geometry and spawnargs of many scene nodes at once,
+ * exchanging numpy arrays instead of wrapping every face, control point
+ * and key one at a time. All methods take a sequence of SceneNodes.
+ *
+ * The face arrays of brushes are concatenated in the order of the passed
+ * nodes, getFaceCounts() returns how many rows each node contributes
+ * (nodes which are not brushes contribute none).
+ *
+ * The setters convert their input and pass it on to the functions in
+ * SceneArrays.h, which validate the whole input before changing anything
+ * and record all changes in a single undo operation (which is merged into
+ * the surrounding one, if a script is run from the editor).
+ */
+class SceneArrayInterface :
+	public IScriptInterface
+{
+public:
+	typedef py::array_t<double, py::array::c_style | py::array::forcecast> DoubleArray;
+	typedef py::array_t<std::int64_t, py::array::c_style | py::array::forcecast> IndexArray;
+
+	// int64 [N], the number of faces of each node
+	py::array_t<std::int64_t> getFaceCounts(const py::iterable& nodes);
+
+	// float64 [F,4], the face planes as (a, b, c, d) with the normal (a, b, c)
+	DoubleArray getFacePlanes(const py::iterable& nodes);
+	void setFacePlanes(const py::iterable& nodes, const DoubleArray& planes);
+
+	// float64 [F,2,3], the texture matrices as ((xx, yx, tx), (xy, yy, ty))
+	DoubleArray getTexDefMatrices(const py::iterable& nodes);
+	void setTexDefMatrices(const py::iterable& nodes, const DoubleArray& matrices);
+
+	// Returns a tuple of the float64 [V,5] winding vertices as (x, y, z, s, t) and
+	// the int64 [F+1] offsets, the winding of face i is vertices[offsets[i]:offsets[i+1]]
+	py::tuple getWindings(const py::iterable& nodes);
+
+	// Accepts the [V,5] or [V,3] vertices and [F+1] offsets returned by getWindings(),
+	// each face plane is rebuilt from its winding, the texture coordinates are ignored
+	void setWindings(const py::iterable& nodes, const DoubleArray& vertices, const IndexArray& offsets);
+
+	// Returns a list holding a float64 [H,W,5] array of the control points of
+	// each patch as (x, y, z, s, t), or None for nodes which are not patches
+	py::list getPatchControls(const py::iterable& nodes);
+
+	// Accepts the list returned by getPatchControls(), each [H,W,5] or [H,W,3] (vertices
+	// only) array must match the dimensions of its patch, None entries are skipped
+	void setPatchControls(const py::iterable& nodes, const py::sequence& controls);
+
+	// The value of the given key of each entity, empty for non-entities
+	py::array getSpawnargs(const py::iterable& nodes, const std::string& key);
+	void setSpawnargs(const py::iterable& nodes, const std::string& key, const py::sequence& values);
+
+	// float64 [N,3] parsed from the given key ("origin", "_color", ...), NaN where not set
+	DoubleArray getSpawnargVectors(const py::iterable& nodes, const std::string& key);
+
+	// Writes the rows of a [N] or [N,k] array as space separated values
+	void setSpawnargVectors(const py::iterable& nodes, const std::string& key, const DoubleArray& values);
+
+	// IScriptInterface implementation
+	void registerInterface(py::module& scope, py::dict& globals) override;
+
+private:
+	static std::vector<scene::INodePtr> getNodes(const py::iterable& nodes);
+};
+
+} // namespace script
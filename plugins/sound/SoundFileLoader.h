@@ -4,6 +4,7 @@
 
 #include "parser/DefBlockTokeniser.h"
 #include "parser/DefTokeniser.h"
+#include "parser/DeclFileCache.h"
 #include "ifilesystem.h"
 #include "iarchive.h"
 #include "imainframe.h"
@@ -24,6 +25,9 @@ class SoundFileLoader
     // Shader map to populate
 	SoundManager::ShaderMap& _shaders;
 
+	// Holds the sound shaders parsed from each file
+	parser::DeclFileCache& _cache;
+
 private:
 
 	std::string getShortened(const std::string& input, std::size_t maxLength)
@@ -40,9 +44,16 @@ private:
 		return input;
 	}
 
-    // Accept a stream of shaders to parse
-    void parseShadersFromStream(std::istream& contents,
-                                const std::string& modName)
+    // The sound shaders of a file, the block contents are parsed on demand
+    // by the SoundShader
+    struct ParsedShaders
+    {
+        std::string modName;
+        std::vector<std::pair<std::string, std::string>> blocks;
+    };
+
+    // Split a stream into the names and contents of the sound shader blocks
+    void readBlocks(std::istream& contents, ParsedShaders& shaders)
     {
         // Construct a DefTokeniser to tokenise the string into sound shader
         // decls
@@ -53,18 +64,62 @@ private:
             // Retrieve a named definition block from the parser
             parser::BlockTokeniser::Block block = tok.nextBlock();
 
+            shaders.blocks.emplace_back(std::move(block.name), std::move(block.contents));
+        }
+    }
+
+    std::string writeToCache(const ParsedShaders& shaders)
+    {
+        parser::DeclWriter writer;
+
+        writer.writeString(shaders.modName);
+        writer.writeSize(shaders.blocks.size());
+
+        for (const auto& block : shaders.blocks)
+        {
+            writer.writeString(block.first);
+            writer.writeString(block.second);
+        }
+
+        return writer.getData();
+    }
+
+    ParsedShaders readFromCache(const std::string& data)
+    {
+        parser::DeclReader reader(data);
+        ParsedShaders shaders;
+
+        shaders.modName = reader.readString();
+        shaders.blocks.resize(reader.readCount(8));
+
+        for (auto& block : shaders.blocks)
+        {
+            block.first = reader.readString();
+            block.second = reader.readString();
+        }
+
+        return shaders;
+    }
+
+    // Create the shaders from the given block names and contents
+    void addShaders(const ParsedShaders& shaders)
+    {
+        for (const auto& block : shaders.blocks)
+        {
+            const std::string& name = block.first;
+
             // Create a new shader with this name
             std::pair<SoundManager::ShaderMap::iterator, bool> result;
             result = _shaders.insert(
                 SoundManager::ShaderMap::value_type(
-                    block.name,
-                    std::make_shared<SoundShader>(block.name, block.contents, modName)
+                    name,
+                    std::make_shared<SoundShader>(name, block.second, shaders.modName)
                 )
             );
 
             if (!result.second) {
                 rError() << "[SoundManager]: SoundShader with name "
-                    << block.name << " already exists." << std::endl;
+                    << name << " already exists." << std::endl;
             }
         }
     }
@@ -72,10 +127,10 @@ private:
 public:
 
 	/**
-	 * Constructor. Set the sound manager reference.
+	 * Constructor. Set the sound manager reference and the cache to use.
 	 */
-	SoundFileLoader(SoundManager::ShaderMap& shaderMap)
-	: _shaders(shaderMap)
+	SoundFileLoader(SoundManager::ShaderMap& shaderMap, parser::DeclFileCache& cache)
+	: _shaders(shaderMap), _cache(cache)
 	{ }
 
 	/**
@@ -83,24 +138,49 @@ public:
 	 */
 	void operator()(const std::string& filename)
 	{
+		std::string path = SOUND_FOLDER + filename;
+
+		std::string data;
+		vfs::FileStamp stamp = GlobalFileSystem().getFileStamp(path);
+
+		try
+		{
+			if (_cache.lookup(path, stamp, data))
+			{
+				addShaders(readFromCache(data));
+				return;
+			}
+		}
+		catch (parser::ParseException& ex)
+		{
+			rWarning() << "[sound]: Discarding the cached shaders of " << filename <<
+				": " << ex.what() << std::endl;
+		}
+
 		// Open the .sndshd file and get its contents as a std::string
-		ArchiveTextFilePtr file =
-			GlobalFileSystem().openTextFile(SOUND_FOLDER + filename);
+		ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(path);
 
 		// Parse contents of file if it was opened successfully
 		if (file)
         {
 			std::istream is(&(file->getInputStream()));
+			ParsedShaders shaders;
+			shaders.modName = file->getModName();
 
 			try
             {
-				parseShadersFromStream(is, file->getModName());
+				readBlocks(is, shaders);
+
+				_cache.store(path, stamp, writeToCache(shaders));
 			}
 			catch (parser::ParseException& ex) 
             {
 				rError() << "[sound]: Error while parsing " << filename <<
 					": " << ex.what() << std::endl;
 			}
+
+			// Add the shaders up to a parse error, if any
+			addShaders(shaders);
 		}
 		else 
         {
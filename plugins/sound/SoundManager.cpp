@@ -125,8 +125,10 @@ void SoundManager::loadShadersFromFilesystem()
 {
     ShaderMapPtr foundShaders = std::make_shared<ShaderMap>();
 
+    _declCache.load();
+
 	// Pass a SoundFileLoader to the filesystem
-    SoundFileLoader loader(*foundShaders);
+    SoundFileLoader loader(*foundShaders, _declCache);
 
     GlobalFileSystem().forEachFile(
         SOUND_FOLDER,			// directory
@@ -135,6 +137,8 @@ void SoundManager::loadShadersFromFilesystem()
         99						// max depth
     );
 
+    _declCache.save();
+
     _shaders.swap(*foundShaders);
 
     rMessage() << _shaders.size() << " sound shaders found." << std::endl;
@@ -165,6 +169,8 @@ void SoundManager::initialiseModule(const ApplicationContext& ctx)
                              << std::endl;
     }
 
+    _declCache.setCacheFile(ctx.getSettingsPath() + "soundshaders.cache");
+
     _defLoader.start();
 }
 
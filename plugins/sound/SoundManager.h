@@ -6,6 +6,7 @@
 #include "isound.h"
 
 #include "ThreadedDefLoader.h"
+#include "parser/DeclFileCache.h"
 #include <map>
 
 namespace sound {
@@ -28,6 +29,9 @@ private: /* FIELDS */
     // takes care of the worker thread
     util::ThreadedDefLoader<void> _defLoader;
 
+    // Sound shaders parsed from the sound shader files, stored between sessions
+    parser::DeclFileCache _declCache;
+
 	SoundShaderPtr _emptyShader;
 
 	// The helper class for playing the sounds
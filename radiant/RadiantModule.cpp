@@ -42,6 +42,8 @@ sigc::signal<void> RadiantModule::signal_radiantShutdown() const
 
 ThreadManager& RadiantModule::getThreadManager()
 {
+    std::lock_guard<std::mutex> lock(_threadManagerLock);
+
     if (!_threadManager)
     {
         _threadManager.reset(new RadiantThreadManager);
@@ -51,7 +53,15 @@ ThreadManager& RadiantModule::getThreadManager()
 
 void RadiantModule::broadcastShutdownEvent()
 {
-	_threadManager.reset();
+	std::unique_ptr<RadiantThreadManager> threadManager;
+
+	{
+		std::lock_guard<std::mutex> lock(_threadManagerLock);
+		threadManager.swap(_threadManager);
+	}
+
+	// Destroy it outside the lock, pending tasks might still be asking for it
+	threadManager.reset();
 
     _radiantShutdown.emit();
     _radiantShutdown.clear();
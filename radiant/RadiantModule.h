@@ -2,6 +2,7 @@
 
 #include "iradiant.h"
 #include <memory>
+#include <mutex>
 
 namespace radiant
 {
@@ -19,6 +20,9 @@ class RadiantModule :
     // Thread manager instance
     mutable std::unique_ptr<RadiantThreadManager> _threadManager;
 
+    // The thread manager is requested by def loaders running in worker threads
+    std::mutex _threadManagerLock;
+
 public:
 
     /// Broadcast shutdwon signal and clear all listeners
@@ -1,99 +1,73 @@
 #include "RadiantThreadManager.h"
 
-#include <wx/thread.h>
-#include <algorithm>
+#include "itextstream.h"
+#include "WorkStealingScheduler.h"
+#include <limits>
 #include <stdexcept>
 
 namespace radiant
 {
 
-class RadiantThreadManager::DetachedThread : 
-	public wxThread
+RadiantThreadManager::RadiantThreadManager() :
+	_scheduler(new WorkStealingScheduler)
 {
-private:
-	std::size_t _threadId;
-	std::function<void()> _func;
-	RadiantThreadManager& _owner;
-
-public:
-	DetachedThread(std::size_t threadId, std::function<void()>& func, RadiantThreadManager& owner) :
-		wxThread(wxTHREAD_JOINABLE),
-		_threadId(threadId),
-		_func(func),
-		_owner(owner)
-	{}
-
-	void OnExit()
-	{
-		_owner.onThreadFinished(_threadId);
-	}
-
-	ExitCode Entry()
-	{
-		_func();
-
-		return static_cast<ExitCode>(0);
-	}
-};
+	rMessage() << "Task scheduler started with " << _scheduler->getNumWorkers() << " worker threads" << std::endl;
+}
 
 RadiantThreadManager::~RadiantThreadManager()
 {
-	std::for_each(_threads.begin(), _threads.end(), [] (const ThreadMap::value_type& pair)
-	{
-		if (pair.second->IsRunning())
-		{
-			pair.second->Delete();
-		}
-	});
+	TaskStatistics stats = _scheduler->getStatistics();
 
-	std::for_each(_threads.begin(), _threads.end(), [](const ThreadMap::value_type& pair)
-	{
-		if (pair.second->IsRunning())
-		{
-			pair.second->Wait();
-		}
-	});
+	rMessage() << "Task scheduler executed " << stats.tasksExecuted << " tasks in "
+		<< stats.totalTaskTime.count() / 1000 << " ms, the longest one took "
+		<< stats.longestTaskTime.count() / 1000 << " ms" << std::endl;
 
-	_threads.clear();
+	// The scheduler finishes all pending jobs before returning
+	_scheduler.reset();
+	_jobs.clear();
 }
 
 std::size_t RadiantThreadManager::execute(std::function<void()> func)
 {
 	std::size_t threadId = getFreeThreadId();
 
-	_threads[threadId] = DetachedThreadPtr(new DetachedThread(threadId, func, *this));
-	_threads[threadId]->Run();
+	_jobs[threadId] = _scheduler->submit(func);
 
 	return threadId;
 }
 
 bool RadiantThreadManager::threadIsRunning(std::size_t threadId)
 {
-	ThreadMap::const_iterator found = _threads.find(threadId);
+	JobMap::const_iterator found = _jobs.find(threadId);
 
-	if (found == _threads.end()) return false;
+	if (found == _jobs.end()) return false;
 
-	return found->second->IsRunning();
+	return found->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
 }
 
-void RadiantThreadManager::onThreadFinished(std::size_t threadId)
+TaskScheduler& RadiantThreadManager::getTaskScheduler()
 {
-	ThreadMap::iterator found = _threads.find(threadId);
-
-	assert(found != _threads.end());
-
-	// Don't delete the thread yet, it's stil used by wxWidgets
-	_finishedThreads.push_back(found->second);
-	_threads.erase(found);
+	return *_scheduler;
 }
 
 std::size_t RadiantThreadManager::getFreeThreadId()
 {
-	_finishedThreads.clear();
+	// Forget about the finished jobs
+	for (JobMap::iterator i = _jobs.begin(); i != _jobs.end();)
+	{
+		if (i->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			_jobs.erase(i++);
+		}
+		else
+		{
+			++i;
+		}
+	}
 
 	for (std::size_t i = 1; i < std::numeric_limits<std::size_t>::max(); ++i)
 	{
-		if (_threads.find(i) == _threads.end())
+		if (_jobs.find(i) == _jobs.end())
 		{
 			return i;
 		}
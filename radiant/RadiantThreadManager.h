@@ -1,34 +1,33 @@
 #pragma once
 
 #include "ithread.h"
+#include <future>
 #include <memory>
 #include <map>
-#include <vector>
 
 namespace radiant
 {
 
+class WorkStealingScheduler;
+
 /// ThreadManager implementation class
 class RadiantThreadManager : 
 	public ThreadManager
 {
-	class DetachedThread;
-	typedef std::shared_ptr<DetachedThread> DetachedThreadPtr;
-
-	typedef std::map<std::size_t, DetachedThreadPtr> ThreadMap;
-	ThreadMap _threads;
+	std::unique_ptr<WorkStealingScheduler> _scheduler;
 
-	std::vector<DetachedThreadPtr> _finishedThreads;
+	// The jobs started through execute(), running on the scheduler's workers
+	typedef std::map<std::size_t, std::shared_future<void>> JobMap;
+	JobMap _jobs;
 
 public:
+	RadiantThreadManager();
 	~RadiantThreadManager();
 
     // ThreadManager implementation
-	std::size_t execute(std::function<void()>);
-	bool threadIsRunning(std::size_t threadId);
-
-	// Called by the worker threads
-	void onThreadFinished(std::size_t threadId);
+	std::size_t execute(std::function<void()>) override;
+	bool threadIsRunning(std::size_t threadId) override;
+	TaskScheduler& getTaskScheduler() override;
 
 private:
 	std::size_t getFreeThreadId();
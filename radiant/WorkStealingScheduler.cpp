@@ -0,0 +1,314 @@
+#include "WorkStealingScheduler.h"
+
+#include <algorithm>
+
+namespace radiant
+{
+
+namespace
+{
+	// Set for the threads of a scheduler's pool
+	struct WorkerContext
+	{
+		const WorkStealingScheduler* scheduler;
+		std::size_t queueIndex;
+	};
+
+	thread_local WorkerContext currentWorker = { nullptr, 0 };
+
+	// Shared state of a parallelFor() call, worker tasks might
+	// still hold a reference after the call returned
+	struct ParallelForState
+	{
+		const std::function<void(std::size_t)>* func;
+
+		std::size_t count;
+		std::size_t chunkSize;
+		std::size_t numChunks;
+
+		std::atomic<std::size_t> nextChunk;
+		std::atomic<std::size_t> finishedChunks;
+
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::exception_ptr exception;
+
+		// Processes chunks until none are left
+		void processChunks()
+		{
+			for (std::size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+			{
+				std::size_t end = std::min((chunk + 1) * chunkSize, count);
+
+				try
+				{
+					for (std::size_t i = chunk * chunkSize; i < end; ++i)
+					{
+						(*func)(i);
+					}
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					if (!exception)
+					{
+						exception = std::current_exception();
+					}
+				}
+
+				if (++finishedChunks == numChunks)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.notify_all();
+				}
+			}
+		}
+	};
+}
+
+WorkStealingScheduler::WorkStealingScheduler(std::size_t numWorkers) :
+	_queueDepth(0),
+	_shutdown(false),
+	_tasksExecuted(0),
+	_totalTaskTime(0),
+	_longestTaskTime(0)
+{
+	if (numWorkers == 0)
+	{
+		// Always have a second worker, a long task shouldn't block all others
+		numWorkers = std::max(std::thread::hardware_concurrency(), 2u);
+	}
+
+	for (std::size_t i = 0; i <= numWorkers; ++i)
+	{
+		_queues.emplace_back(new WorkQueue);
+	}
+
+	for (std::size_t i = 0; i < numWorkers; ++i)
+	{
+		_workers.emplace_back(&WorkStealingScheduler::runWorker, this, i);
+	}
+}
+
+WorkStealingScheduler::~WorkStealingScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(_wakeMutex);
+		_shutdown = true;
+	}
+
+	_wakeCondition.notify_all();
+
+	for (std::thread& worker : _workers)
+	{
+		worker.join();
+	}
+}
+
+std::size_t WorkStealingScheduler::getNumWorkers() const
+{
+	return _workers.size();
+}
+
+void WorkStealingScheduler::enqueue(Task task)
+{
+	WorkQueue& queue = *_queues[getQueueIndex()];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+		++_queueDepth;
+	}
+
+	// Taking the mutex makes sure no worker is between checking the queue depth and going to sleep
+	{
+		std::lock_guard<std::mutex> lock(_wakeMutex);
+	}
+
+	_wakeCondition.notify_one();
+}
+
+void WorkStealingScheduler::parallelFor(std::size_t count, const std::function<void(std::size_t)>& func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	auto state = std::make_shared<ParallelForState>();
+
+	// A few chunks per thread, so that threads finishing early can help the others
+	state->func = &func;
+	state->count = count;
+	state->numChunks = std::min(count, (_workers.size() + 1) * 4);
+	state->chunkSize = (count + state->numChunks - 1) / state->numChunks;
+	state->numChunks = (count + state->chunkSize - 1) / state->chunkSize;
+	state->nextChunk = 0;
+	state->finishedChunks = 0;
+
+	std::size_t numHelpers = std::min(_workers.size(), state->numChunks - 1);
+
+	for (std::size_t i = 0; i < numHelpers; ++i)
+	{
+		enqueue([state]() { state->processChunks(); });
+	}
+
+	state->processChunks();
+
+	// Wait for the chunks processed by other threads
+	while (state->finishedChunks < state->numChunks)
+	{
+		if (executePendingTask())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->finished.wait_for(lock, std::chrono::milliseconds(1), [&]()
+		{
+			return state->finishedChunks == state->numChunks;
+		});
+	}
+
+	if (state->exception)
+	{
+		std::rethrow_exception(state->exception);
+	}
+}
+
+bool WorkStealingScheduler::isWorkerThread() const
+{
+	return currentWorker.scheduler == this;
+}
+
+bool WorkStealingScheduler::executePendingTask()
+{
+	if (!isWorkerThread())
+	{
+		return false;
+	}
+
+	Task task;
+
+	if (!tryPopTask(currentWorker.queueIndex, task))
+	{
+		return false;
+	}
+
+	execute(task);
+	return true;
+}
+
+TaskStatistics WorkStealingScheduler::getStatistics() const
+{
+	TaskStatistics stats;
+
+	stats.numWorkers = _workers.size();
+	stats.queueDepth = _queueDepth;
+	stats.tasksExecuted = _tasksExecuted;
+	stats.totalTaskTime = std::chrono::microseconds(_totalTaskTime);
+	stats.longestTaskTime = std::chrono::microseconds(_longestTaskTime);
+
+	return stats;
+}
+
+void WorkStealingScheduler::runWorker(std::size_t index)
+{
+	currentWorker.scheduler = this;
+	currentWorker.queueIndex = index;
+
+	while (true)
+	{
+		Task task;
+
+		if (tryPopTask(index, task))
+		{
+			execute(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_wakeMutex);
+
+		_wakeCondition.wait(lock, [this]() { return _shutdown || _queueDepth > 0; });
+
+		// Queued tasks are always finished before shutting down
+		if (_shutdown && _queueDepth == 0)
+		{
+			break;
+		}
+	}
+
+	currentWorker.scheduler = nullptr;
+}
+
+std::size_t WorkStealingScheduler::getQueueIndex() const
+{
+	return isWorkerThread() ? currentWorker.queueIndex : _workers.size();
+}
+
+bool WorkStealingScheduler::tryPopTask(std::size_t queueIndex, Task& task)
+{
+	if (_queueDepth == 0)
+	{
+		return false;
+	}
+
+	// The worker's own queue is used like a stack
+	{
+		WorkQueue& own = *_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(own.mutex);
+
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			--_queueDepth;
+			return true;
+		}
+	}
+
+	// Take the oldest tasks from the injection queue and the other workers
+	for (std::size_t i = 1; i < _queues.size(); ++i)
+	{
+		WorkQueue& other = *_queues[(queueIndex + i) % _queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+
+		if (!other.tasks.empty())
+		{
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			--_queueDepth;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void WorkStealingScheduler::execute(Task& task)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	try
+	{
+		task();
+	}
+	catch (...)
+	{
+		// Tasks queued via submit() store their exceptions in the future
+	}
+
+	int64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+
+	++_tasksExecuted;
+	_totalTaskTime += duration;
+
+	int64_t longest = _longestTaskTime;
+
+	while (duration > longest && !_longestTaskTime.compare_exchange_weak(longest, duration))
+	{}
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ithread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace radiant
+{
+
+/**
+ * TaskScheduler implementation using a fixed set of worker threads.
+ *
+ * Each worker owns a task queue. Tasks queued by a worker are pushed to
+ * its own queue and popped again in LIFO order, which keeps nested work
+ * (like the per-file tasks of a def loader) close together. Idle workers
+ * steal the oldest tasks from the other queues. Tasks queued by threads
+ * outside the pool go to a shared injection queue.
+ *
+ * On destruction all queued tasks are executed before the workers are
+ * joined, such that no pending future is left unfulfilled.
+ */
+class WorkStealingScheduler :
+	public TaskScheduler
+{
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	// One queue per worker, followed by the injection queue
+	std::vector<std::unique_ptr<WorkQueue>> _queues;
+	std::vector<std::thread> _workers;
+
+	std::mutex _wakeMutex;
+	std::condition_variable _wakeCondition;
+
+	std::atomic<std::size_t> _queueDepth;
+	std::atomic<bool> _shutdown;
+
+	// Statistics, times in microseconds
+	std::atomic<std::size_t> _tasksExecuted;
+	std::atomic<int64_t> _totalTaskTime;
+	std::atomic<int64_t> _longestTaskTime;
+
+public:
+	// Creates the given number of worker threads, 0 picks the number of hardware threads
+	WorkStealingScheduler(std::size_t numWorkers = 0);
+	~WorkStealingScheduler();
+
+	std::size_t getNumWorkers() const override;
+	void enqueue(Task task) override;
+	void parallelFor(std::size_t count, const std::function<void(std::size_t)>& func) override;
+	bool isWorkerThread() const override;
+	bool executePendingTask() override;
+	TaskStatistics getStatistics() const override;
+
+private:
+	void runWorker(std::size_t index);
+
+	// Returns the queue index of the calling worker thread, or the injection queue index
+	std::size_t getQueueIndex() const;
+
+	// Tries to get a task from the given queue, then from all the others
+	bool tryPopTask(std::size_t queueIndex, Task& task);
+
+	void execute(Task& task);
+};
+
+}
@@ -54,6 +54,7 @@ Brush::Brush(BrushNode& owner) :
     _uniqueEdgePoints(GL_POINTS),
     m_planeChanged(false),
     m_transformChanged(false),
+    _windingsClipped(false),
 	_detailFlag(Structural)
 {
     onFacePlaneChanged();
@@ -68,6 +69,7 @@ Brush::Brush(BrushNode& owner, const Brush& other) :
     _uniqueEdgePoints(GL_POINTS),
     m_planeChanged(false),
     m_transformChanged(false),
+    _windingsClipped(false),
 	_detailFlag(Structural)
 {
     copy(other);
@@ -223,6 +225,48 @@ void Brush::evaluateBRep() const {
     }
 }
 
+void Brush::evaluateBReps(const std::vector<Brush*>& brushes, TaskScheduler& scheduler)
+{
+    std::vector<Brush*> changed;
+    changed.reserve(brushes.size());
+
+    for (Brush* brush : brushes)
+    {
+        // Pending transforms are applied here, since they are notifying
+        // the scene about the changed bounds
+        brush->evaluateTransform();
+
+        if (brush->m_planeChanged)
+        {
+            changed.push_back(brush);
+        }
+    }
+
+    // Each brush must be handled by exactly one worker
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    // Clip the windings on the worker threads, a few brushes per
+    // call to keep the scheduling overhead small
+    const std::size_t BRUSHES_PER_BLOCK = 16;
+    std::size_t numBlocks = (changed.size() + BRUSHES_PER_BLOCK - 1) / BRUSHES_PER_BLOCK;
+
+    scheduler.parallelFor(numBlocks, [&](std::size_t block)
+    {
+        std::size_t end = std::min((block + 1) * BRUSHES_PER_BLOCK, changed.size());
+
+        for (std::size_t i = block * BRUSHES_PER_BLOCK; i < end; ++i)
+        {
+            changed[i]->clipWindings();
+        }
+    });
+
+    for (Brush* brush : changed)
+    {
+        brush->evaluateBRep();
+    }
+}
+
 void Brush::transformChanged() {
     m_transformChanged = true;
     onFacePlaneChanged();
@@ -329,6 +373,15 @@ IUndoMementoPtr Brush::exportState() const
     return IUndoMementoPtr(new BrushUndoMemento(m_faces, _detailFlag));
 }
 
+IUndoMementoPtr Brush::compactState(const IUndoMementoPtr& state) const
+{
+    // The faces are saving their own state, the brush only needs
+    // to be restored if the face list or the detail flag changed
+    const BrushUndoMemento& memento = *std::static_pointer_cast<BrushUndoMemento>(state);
+
+    return memento._faces == m_faces && memento._detailFlag == _detailFlag ? IUndoMementoPtr() : state;
+}
+
 void Brush::importState(const IUndoMementoPtr& state)
 {
     undoSave();
@@ -411,6 +464,7 @@ void Brush::reserve(std::size_t count) {
 
 void Brush::push_back(Faces::value_type face) {
     m_faces.push_back(face);
+    _windingBuilder.clear();
 
     if (_undoStateSaver)
     {
@@ -431,6 +485,8 @@ void Brush::pop_back()
     }
 
     m_faces.pop_back();
+    _windingBuilder.clear();
+
     for (Observers::iterator i = m_observers.begin(); i != m_observers.end(); ++i) {
         (*i)->pop_back();
         (*i)->DEBUG_verify();
@@ -445,6 +501,8 @@ void Brush::erase(std::size_t index)
     }
 
     m_faces.erase(m_faces.begin() + index);
+    _windingBuilder.clear();
+
     for (Observers::iterator i = m_observers.begin(); i != m_observers.end(); ++i) {
         (*i)->erase(index);
         (*i)->DEBUG_verify();
@@ -488,6 +546,7 @@ void Brush::clear()
     }
 
     m_faces.clear();
+    _windingBuilder.clear();
 
     for(Observers::iterator i = m_observers.begin(); i != m_observers.end(); ++i) {
         (*i)->clear();
@@ -533,37 +592,17 @@ void Brush::removeEmptyFaces() {
 
 /// \brief Constructs \p winding from the intersection of \p plane with the other planes of the brush.
 void Brush::windingForClipPlane(Winding& winding, const Plane3& plane) const {
-    FixedWinding buffer[2];
-    bool swap = false;
-
-    // get a poly that covers an effectively infinite area
-    buffer[swap].createInfinite(plane, m_maxWorldCoord + 1);
+    std::vector<Plane3> planes;
+    planes.reserve(m_faces.size());
 
-    // chop the poly by all of the other faces
-    {
-        for (std::size_t i = 0;  i < m_faces.size(); ++i) {
-            const Face& clip = *m_faces[i];
-
-            if (clip.plane3() == plane
-                || !clip.plane3().isValid() || !plane_unique(i)
-                || plane == -clip.plane3())
-            {
-                continue;
-            }
-
-            buffer[!swap].clear();
-
-            {
-                // flip the plane, because we want to keep the back side
-                Plane3 clipPlane(-clip.plane3().normal(), -clip.plane3().dist());
-                buffer[swap].clip(plane, clipPlane, i, buffer[!swap]);
-            }
-
-            swap = !swap;
-        }
+    for (const FacePtr& face : m_faces) {
+        planes.push_back(face->plane3());
     }
 
-    buffer[swap].writeToWinding(winding);
+    std::vector<bool> contributing;
+    BrushWindingBuilder::getContributingPlanes(planes, contributing);
+
+    BrushWindingBuilder::clipWinding(winding, plane, planes, contributing, m_maxWorldCoord);
 }
 
 void Brush::update_wireframe(RenderableWireframe& wire, const bool* faces_visible) const
@@ -950,17 +989,6 @@ void Brush::vertex_clear() {
     }
 }
 
-/// \brief Returns true if the face identified by \p index is preceded by another plane that takes priority over it.
-bool Brush::plane_unique(std::size_t index) const {
-    // duplicate plane
-    for (std::size_t i = 0; i < m_faces.size(); ++i) {
-        if (index != i && !plane3_inside(m_faces[index]->plane3(), m_faces[i]->plane3())) {
-            return false;
-        }
-    }
-    return true;
-}
-
 /// \brief Removes edges that are smaller than the tolerance used when generating brush windings.
 void Brush::removeDegenerateEdges() {
     for (std::size_t i = 0;  i < m_faces.size(); ++i) {
@@ -1089,20 +1117,43 @@ bool Brush::isBounded() {
     return true;
 }
 
+/// \brief Clips the windings of the changed faces, without touching anything outside this brush.
+void Brush::clipWindings() {
+    std::vector<Plane3> planes;
+    std::vector<IWinding*> windings;
+
+    planes.reserve(m_faces.size());
+    windings.reserve(m_faces.size());
+
+    for (const FacePtr& face : m_faces) {
+        planes.push_back(face->plane3());
+        windings.push_back(&face->getWinding());
+    }
+
+    _windingBuilder.build(planes, windings, m_maxWorldCoord);
+    _windingsClipped = true;
+}
+
 /// \brief Constructs the polygon windings for each face of the brush. Also updates the brush bounding-box and face texture-coordinates.
 bool Brush::buildWindings() {
+    // The windings might have been clipped by evaluateBReps() already
+    if (!_windingsClipped) {
+        clipWindings();
+    }
+
+    _windingsClipped = false;
+
+    // Only the clipped windings have new vertices, the texture coordinates
+    // and normals of the others are just checked for changes below
+    const std::vector<bool>& rebuilt = _windingBuilder.getRebuiltWindings();
+
     {
         m_aabb_local = AABB();
 
         for (std::size_t i = 0;  i < m_faces.size(); ++i) {
             Face& f = *m_faces[i];
 
-            if (!f.plane3().isValid() || !plane_unique(i)) {
-                f.getWinding().resize(0);
-            }
-            else {
-                windingForClipPlane(f.getWinding(), f.plane3());
-
+            if (!f.getWinding().empty()) {
                 // update brush bounds
                 const Winding& winding = f.getWinding();
 
@@ -1117,18 +1168,37 @@ bool Brush::buildWindings() {
 
             // greebo: Update the winding, now that it's constructed
             f.updateWinding();
+            f.updateWindingBounds();
+
+            if (rebuilt[i]) {
+                f.getWinding().markChanged();
+            }
         }
     }
 
     bool degenerate = !isBounded();
 
     if (!degenerate) {
+        std::vector<std::size_t> windingSizes;
+        windingSizes.reserve(m_faces.size());
+
+        for (const FacePtr& face : m_faces) {
+            windingSizes.push_back(face->getWinding().size());
+        }
+
         // clean up connectivity information.
         // these cleanups must be applied in a specific order.
         removeDegenerateEdges();
         removeDegenerateFaces();
         removeDuplicateEdges();
         verifyConnectivityGraph();
+
+        // The cleanups might have removed vertices
+        for (std::size_t i = 0; i < m_faces.size(); ++i) {
+            if (m_faces[i]->getWinding().size() != windingSizes[i]) {
+                m_faces[i]->getWinding().markChanged();
+            }
+        }
     }
 
     return degenerate;
@@ -1211,6 +1281,9 @@ void Brush::buildBRep() {
     {
       (*i)->getWinding().resize(0);
     }
+
+    // The windings need to be clipped again from scratch
+    _windingBuilder.clear();
   }
   else
   {
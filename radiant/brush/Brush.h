@@ -1,8 +1,10 @@
 #pragma once
 
 #include "editable.h"
+#include "ithread.h"
 
 #include "Face.h"
+#include "BrushWindingBuilder.h"
 #include "SelectableComponents.h"
 #include "RenderableWireFrame.h"
 #include "Translatable.h"
@@ -126,6 +128,12 @@ private:
 	mutable bool m_transformChanged; // transform evaluation required
 	// ----
 
+	// Clips the face windings, skipping the faces unaffected by plane changes
+	BrushWindingBuilder _windingBuilder;
+
+	// True if the windings have been clipped in advance by evaluateBReps()
+	bool _windingsClipped;
+
 	DetailFlag _detailFlag;
 	
 public:
@@ -151,6 +159,11 @@ public:
 
 		virtual ~BrushUndoMemento() {}
 
+		std::size_t getMemoryUsage() const override
+		{
+			return sizeof(*this) + _faces.capacity() * sizeof(FacePtr);
+		}
+
 		Faces _faces;
 		DetailFlag _detailFlag;
 	};
@@ -211,6 +224,13 @@ public:
 
 	void evaluateBRep() const;
 
+	/**
+	 * Evaluates the B-rep of all the given brushes which need it. The face
+	 * windings of the brushes are clipped in parallel on the given scheduler,
+	 * the rest of the B-rep construction happens on the calling thread.
+	 */
+	static void evaluateBReps(const std::vector<Brush*>& brushes, TaskScheduler& scheduler);
+
     void transformChanged();
     void evaluateTransform();
 
@@ -235,6 +255,7 @@ public:
 	void undoSave();
 	IUndoMementoPtr exportState() const;
 	void importState(const IUndoMementoPtr& state);
+	IUndoMementoPtr compactState(const IUndoMementoPtr& state) const;
 
 	/// \brief Appends a copy of \p face to the end of the face list.
 	FacePtr addFace(const Face& face);
@@ -313,9 +334,6 @@ private:
 
 	void vertex_clear();
 
-	/// \brief Returns true if the face identified by \p index is preceded by another plane that takes priority over it.
-	bool plane_unique(std::size_t index) const;
-
 	/// \brief Removes edges that are smaller than the tolerance used when generating brush windings.
 	void removeDegenerateEdges();
 
@@ -331,6 +349,9 @@ private:
 	/// \brief Returns true if the brush is a finite volume. A brush without a finite volume extends past the maximum world bounds and is not valid.
 	bool isBounded();
 
+	/// \brief Clips the polygon windings for each face of the brush. This doesn't touch anything but the faces of this brush.
+	void clipWindings();
+
 	/// \brief Constructs the polygon windings for each face of the brush. Also updates the brush bounding-box and face texture-coordinates.
 	bool buildWindings();
 
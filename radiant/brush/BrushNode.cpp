@@ -82,12 +82,24 @@ void BrushNode::snapComponents(float snap) {
 }
 
 void BrushNode::testSelect(Selector& selector, SelectionTest& test) {
-	test.BeginMesh(localToWorld());
+	const VolumeTest& volume = test.getVolume();
+
+	// Nothing to hit if the brush is outside of the selection volume
+	if (volume.TestAABB(worldAABB()) == VOLUME_OUTSIDE)
+	{
+		return;
+	}
+
+	const Matrix4& l2w = localToWorld();
+	test.BeginMesh(l2w);
 
 	SelectionIntersection best;
 	for (FaceInstances::iterator i = m_faceInstances.begin(); i != m_faceInstances.end(); ++i)
 	{
-		if (i->faceIsVisible())
+		// Every triangle of a winding gets clipped against the volume, 
+		// skip the faces which can't intersect it in the first place
+		if (i->faceIsVisible() &&
+			volume.TestAABB(i->getFace().getWindingBounds(), l2w) != VOLUME_OUTSIDE)
 		{
 			i->testSelect(test, best);
 		}
@@ -309,6 +321,10 @@ bool BrushNode::intersectsLight(const RendererLight& light) const {
 	return light.intersectsAABB(worldAABB());
 }
 
+const AABB& BrushNode::getLitObjectAABB() const {
+	return worldAABB();
+}
+
 void BrushNode::insertLight(const RendererLight& light) {
 	const Matrix4& l2w = localToWorld();
 	for (FaceInstances::iterator i = m_faceInstances.begin(); i != m_faceInstances.end(); ++i) {
@@ -138,6 +138,7 @@ public:
 
 	// LitObject implementation
 	bool intersectsLight(const RendererLight& light) const override;
+	const AABB& getLitObjectAABB() const override;
 	void insertLight(const RendererLight& light) override;
 	void clearLights() override;
 
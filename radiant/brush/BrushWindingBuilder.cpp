@@ -0,0 +1,169 @@
+#include "BrushWindingBuilder.h"
+
+#include "Brush.h"
+#include "FixedWinding.h"
+
+namespace
+{
+	// The vertices of a reused winding need to be at least this far behind
+	// a changed plane. This is larger than the tolerances used by the
+	// winding clipper and the degenerate edge removal.
+	const double UNAFFECTED_EPSILON = ON_EPSILON * 4;
+}
+
+BrushWindingBuilder::BrushWindingBuilder() :
+	_maxWorldCoord(0)
+{}
+
+void BrushWindingBuilder::clear()
+{
+	_planes.clear();
+	_contributing.clear();
+}
+
+std::size_t BrushWindingBuilder::build(const std::vector<Plane3>& planes,
+	const std::vector<IWinding*>& windings, double maxWorldCoord)
+{
+	assert(planes.size() == windings.size());
+
+	std::vector<bool> contributing;
+	getContributingPlanes(planes, contributing);
+
+	// Any change to the face set or the set of contributing planes invalidates everything
+	bool fullRebuild = planes.size() != _planes.size() ||
+		contributing != _contributing || maxWorldCoord != _maxWorldCoord;
+
+	_changedIndices.clear();
+
+	if (!fullRebuild)
+	{
+		for (std::size_t i = 0; i < planes.size(); ++i)
+		{
+			if (!(planes[i] == _planes[i]))
+			{
+				_changedIndices.push_back(i);
+			}
+		}
+	}
+
+	std::size_t numClipped = 0;
+	_rebuilt.assign(planes.size(), false);
+
+	for (std::size_t i = 0; i < planes.size(); ++i)
+	{
+		IWinding& winding = *windings[i];
+
+		if (!contributing[i])
+		{
+			_rebuilt[i] = !winding.empty();
+			winding.resize(0);
+			continue;
+		}
+
+		if (fullRebuild || faceIsAffected(i, planes, winding))
+		{
+			clipWinding(winding, planes[i], planes, contributing, maxWorldCoord);
+			_rebuilt[i] = true;
+			++numClipped;
+		}
+	}
+
+	_planes = planes;
+	_contributing.swap(contributing);
+	_maxWorldCoord = maxWorldCoord;
+
+	return numClipped;
+}
+
+const std::vector<bool>& BrushWindingBuilder::getRebuiltWindings() const
+{
+	return _rebuilt;
+}
+
+bool BrushWindingBuilder::faceIsAffected(std::size_t index, const std::vector<Plane3>& planes,
+	const IWinding& winding) const
+{
+	// Empty or degenerate windings don't carry enough adjacency information,
+	// they might be affected by any of the other planes
+	if (winding.size() < 3)
+	{
+		return !_changedIndices.empty();
+	}
+
+	for (std::size_t changed : _changedIndices)
+	{
+		if (changed == index)
+		{
+			return true;
+		}
+
+		for (const WindingVertex& vertex : winding)
+		{
+			// An edge of this winding is lying on the changed plane, or the
+			// changed plane is now cutting off (or touching) this vertex
+			if (vertex.adjacent == changed ||
+				planes[changed].distanceToPoint(vertex.vertex) > -UNAFFECTED_EPSILON)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void BrushWindingBuilder::getContributingPlanes(const std::vector<Plane3>& planes,
+	std::vector<bool>& contributing)
+{
+	contributing.assign(planes.size(), true);
+
+	for (std::size_t i = 0; i < planes.size(); ++i)
+	{
+		if (!planes[i].isValid())
+		{
+			contributing[i] = false;
+			continue;
+		}
+
+		// Duplicate planes
+		for (std::size_t j = 0; j < planes.size(); ++j)
+		{
+			if (i != j && !plane3_inside(planes[i], planes[j]))
+			{
+				contributing[i] = false;
+				break;
+			}
+		}
+	}
+}
+
+void BrushWindingBuilder::clipWinding(IWinding& winding, const Plane3& plane,
+	const std::vector<Plane3>& planes, const std::vector<bool>& contributing, double maxWorldCoord)
+{
+	FixedWinding buffer[2];
+	bool swap = false;
+
+	// get a poly that covers an effectively infinite area
+	buffer[swap].createInfinite(plane, maxWorldCoord + 1);
+
+	// chop the poly by all of the other faces
+	for (std::size_t i = 0; i < planes.size(); ++i)
+	{
+		const Plane3& clip = planes[i];
+
+		if (clip == plane || !contributing[i] || plane == -clip)
+		{
+			continue;
+		}
+
+		buffer[!swap].clear();
+
+		// flip the plane, because we want to keep the back side
+		Plane3 clipPlane(-clip.normal(), -clip.dist());
+		buffer[swap].clip(plane, clipPlane, i, buffer[!swap]);
+
+		swap = !swap;
+	}
+
+	buffer[swap].writeToWinding(winding);
+}
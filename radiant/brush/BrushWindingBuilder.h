@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ibrush.h"
+#include "math/Plane3.h"
+
+#include <vector>
+
+/**
+ * Constructs the polygon windings of a brush by clipping each
+ * face plane against all the other planes of the brush. This is the
+ * expensive part of the brush B-rep construction, it only works on the
+ * given planes and windings and doesn't touch any global state, such
+ * that the windings of different brushes can be built concurrently.
+ *
+ * The builder remembers the planes of its previous run. The next run only
+ * clips the faces which might be affected by the changed planes, the
+ * windings of the other faces are left untouched. A face is considered
+ * unaffected if its own plane didn't change, its winding is a polygon,
+ * none of the changed planes is adjacent to it and none of the changed
+ * planes is cutting into its current winding.
+ *
+ * The owner needs to call clear() whenever faces are added or removed,
+ * or if the windings have been modified from the outside.
+ */
+class BrushWindingBuilder
+{
+private:
+	// The planes used during the previous run
+	std::vector<Plane3> _planes;
+
+	// Whether the plane at the same index was used for clipping
+	std::vector<bool> _contributing;
+
+	double _maxWorldCoord;
+
+	// Temporary buffer re-used between runs
+	std::vector<std::size_t> _changedIndices;
+
+	// Whether the winding at the same index has been touched by the last run
+	std::vector<bool> _rebuilt;
+
+public:
+	BrushWindingBuilder();
+
+	// Discards the state of the previous run, the next build() will clip all faces
+	void clear();
+
+	/**
+	 * Updates the windings to match the given planes. The windings vector
+	 * holds one winding per plane, those of non-contributing faces are
+	 * cleared. Returns the number of faces which have been clipped.
+	 */
+	std::size_t build(const std::vector<Plane3>& planes, const std::vector<IWinding*>& windings,
+		double maxWorldCoord);
+
+	/**
+	 * Returns one flag per face of the last build(), telling whether its
+	 * winding has been clipped or cleared. The other windings are unchanged.
+	 */
+	const std::vector<bool>& getRebuiltWindings() const;
+
+	/**
+	 * Returns the flags telling which of the given planes take part in the
+	 * B-rep: the plane needs to be valid and not be preceded by another
+	 * plane taking priority over it (see plane3_inside()).
+	 */
+	static void getContributingPlanes(const std::vector<Plane3>& planes, std::vector<bool>& contributing);
+
+	/**
+	 * Constructs the winding of the given plane by clipping it against the
+	 * contributing planes (excluding planes equal or opposite to it).
+	 */
+	static void clipWinding(IWinding& winding, const Plane3& plane, const std::vector<Plane3>& planes,
+		const std::vector<bool>& contributing, double maxWorldCoord);
+
+private:
+	// Returns true if the given face needs to be clipped again
+	bool faceIsAffected(std::size_t index, const std::vector<Plane3>& planes, const IWinding& winding) const;
+};
@@ -7,6 +7,7 @@
 
 #include "shaderlib.h"
 #include "Winding.h"
+#include <algorithm>
 
 #include "Brush.h"
 #include "BrushNode.h"
@@ -35,6 +36,26 @@ public:
         face.setShader(_materialName);
         face.getProjection().assign(_texdefState);
     }
+
+    // True if the given face is exactly in this state
+    bool matches(const Face& face) const
+    {
+        const Plane3& plane = face.getPlane().getPlane();
+        const TextureMatrix& texdef = face.getProjection().matrix;
+
+        if (plane.normal() != _planeState.m_plane.normal() || plane.dist() != _planeState.m_plane.dist() ||
+            face.getShader() != _materialName)
+        {
+            return false;
+        }
+
+        return std::equal(&texdef.coords[0][0], &texdef.coords[0][0] + 6, &_texdefState.matrix.coords[0][0]);
+    }
+
+    std::size_t getMemoryUsage() const override
+    {
+        return sizeof(*this) + _materialName.capacity();
+    }
 };
 
 Face::Face(Brush& owner) :
@@ -180,6 +201,12 @@ IUndoMementoPtr Face::exportState() const
     return IUndoMementoPtr(new SavedState(*this));
 }
 
+IUndoMementoPtr Face::compactState(const IUndoMementoPtr& data) const
+{
+    // Faces untouched by the operation don't need to be restored
+    return std::static_pointer_cast<SavedState>(data)->matches(*this) ? IUndoMementoPtr() : data;
+}
+
 void Face::importState(const IUndoMementoPtr& data)
 {
     undoSave();
@@ -517,7 +544,9 @@ void Face::alignTexture(EAlignType align)
 }
 
 void Face::EmitTextureCoordinates() {
-    m_texdefTransformed.emitTextureCoordinates(m_winding, plane3().normal(), Matrix4::getIdentity());
+    if (m_texdefTransformed.emitTextureCoordinates(m_winding, plane3().normal(), Matrix4::getIdentity())) {
+        m_winding.markChanged();
+    }
 }
 
 void Face::applyDefaultTextureScale()
@@ -542,6 +571,14 @@ Winding& Face::getWinding() {
     return m_winding;
 }
 
+void Face::updateWindingBounds() {
+    _windingBounds = m_winding.aabb();
+}
+
+const AABB& Face::getWindingBounds() const {
+    return _windingBounds;
+}
+
 const Plane3& Face::plane3() const
 {
     _owner.onFaceEvaluateTransform();
@@ -553,6 +590,13 @@ const Plane3& Face::getPlane3() const
     return m_plane.getPlane();
 }
 
+void Face::setPlane3(const Plane3& plane)
+{
+    undoSave();
+    m_plane.setPlane(plane);
+    planeChanged();
+}
+
 FacePlane& Face::getPlane() {
     return m_plane;
 }
@@ -565,6 +609,13 @@ Matrix4 Face::getTexDefMatrix() const
     return _texdef.matrix.getTransform();
 }
 
+void Face::setTexDefMatrix(const Matrix4& matrix)
+{
+    undoSave();
+    _texdef.matrix = TextureMatrix(matrix);
+    texdefChanged();
+}
+
 SurfaceShader& Face::getFaceShader() {
     return _shader;
 }
@@ -7,6 +7,7 @@
 #include <sigc++/connection.h>
 
 #include "math/Vector3.h"
+#include "math/AABB.h"
 
 #include "TextureProjection.h"
 #include "SurfaceShader.h"
@@ -56,6 +57,9 @@ private:
 	Winding m_winding;
 	Vector3 m_centroid;
 
+	// Bounds of the winding, used to skip this face in selection tests
+	AABB _windingBounds;
+
 	IUndoStateSaver* _undoStateSaver;
 
 	// Cached visibility flag, queried during front end rendering
@@ -94,6 +98,7 @@ public:
 	// undoable
 	IUndoMementoPtr exportState() const;
 	void importState(const IUndoMementoPtr& data);
+	IUndoMementoPtr compactState(const IUndoMementoPtr& data) const;
 
     /// Translate the face by the given vector
     void translate(const Vector3& translation);
@@ -183,15 +188,21 @@ public:
 	const Winding& getWinding() const;
 	Winding& getWinding();
 
+	// Recalculates the bounds of the winding, called after the winding has been built
+	void updateWindingBounds();
+	const AABB& getWindingBounds() const;
+
 	const Plane3& plane3() const;
 
 	// Returns the Doom 3 plane
 	const Plane3& getPlane3() const;
+	void setPlane3(const Plane3& plane);
 
 	FacePlane& getPlane();
 	const FacePlane& getPlane() const;
 
 	Matrix4 getTexDefMatrix() const;
+	void setTexDefMatrix(const Matrix4& matrix);
 
 	SurfaceShader& getFaceShader();
 	const SurfaceShader& getFaceShader() const;
@@ -49,7 +49,7 @@ namespace {
 	}
 }
 
-void FixedWinding::writeToWinding(Winding& winding)
+void FixedWinding::writeToWinding(IWinding& winding)
 {
 	// First, set the target winding to the same size as <self>
 	winding.resize(size());
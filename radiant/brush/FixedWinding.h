@@ -1,12 +1,11 @@
 #pragma once
 
+#include "ibrush.h"
 #include "math/Vector3.h"
 #include "math/Plane3.h"
 
 #include <vector>
 
-class Winding;
-
 #define MAX_POINTS_ON_WINDING 64
 
 class DoubleLine {
@@ -51,7 +50,7 @@ public:
 	virtual ~FixedWinding() {}
 
 	// Writes the FixedWinding data into the given Winding
-	void writeToWinding(Winding& winding);
+	void writeToWinding(IWinding& winding);
 
 	/// \brief Keep the value of \p infinity as small as possible to improve precision in Winding_Clip.
 	void createInfinite(const Plane3& plane, double infinity);
@@ -334,11 +334,11 @@ Matrix4 TextureProjection::getWorldToTexture(const Vector3& normal, const Matrix
  *
  * Note: The matrix localToWorld is basically useless at the moment, as it is the identity matrix for faces, and this method
  * gets called on face operations only... */
-void TextureProjection::emitTextureCoordinates(Winding& w, const Vector3& normal, const Matrix4& localToWorld) const {
+bool TextureProjection::emitTextureCoordinates(Winding& w, const Vector3& normal, const Matrix4& localToWorld) const {
 
     // Quit, if we have less than three points (degenerate brushes?)
     if (w.size() < 3) {
-        return;
+        return false;
     }
 
     // Get the transformation matrix, that contains the shift, scale and rotation
@@ -369,16 +369,22 @@ void TextureProjection::emitTextureCoordinates(Winding& w, const Vector3& normal
 
     // Cycle through the winding vertices and apply the texture transformation matrix
     // onto each of them.
+    bool changed = false;
+
     for (Winding::iterator i = w.begin(); i != w.end(); ++i)
     {
         Vector3 texcoord = local2tex.transformPoint(i->vertex);
+        Vector2 st(texcoord[0], texcoord[1]);
+
+        changed |= i->texcoord != st || i->tangent != tangent || i->bitangent != bitangent;
 
         // Store the s,t coordinates into the winding texcoord vector
-        i->texcoord[0] = texcoord[0];
-        i->texcoord[1] = texcoord[1];
+        i->texcoord = st;
 
         // Save the tangent and bitangent vectors, they are the same for all the face vertices
         i->tangent = tangent;
         i->bitangent = bitangent;
     }
+
+    return changed;
 }
@@ -61,8 +61,9 @@ public:
     // Aligns this texture to the given edge of the winding
     void alignTexture(EAlignType align, const Winding& winding);
 
-    // greebo: Saves the texture definitions into the brush winding points
-    void emitTextureCoordinates(Winding& w, const Vector3& normal, const Matrix4& localToWorld) const;
+    // greebo: Saves the texture definitions into the brush winding points,
+    // returns true if any of the texture coordinates or tangents changed
+    bool emitTextureCoordinates(Winding& w, const Vector3& normal, const Matrix4& localToWorld) const;
 
     // greebo: This returns a matrix transforming world vertex coordinates into texture space
     Matrix4 getWorldToTexture(const Vector3& normal, const Matrix4& localToWorld) const;
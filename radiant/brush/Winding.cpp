@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "igl.h"
 #include "itextstream.h"
 #include <algorithm>
+#include <atomic>
 #include "FixedWinding.h"
 #include "math/Ray.h"
 #include "math/Plane3.h"
@@ -54,6 +55,49 @@ namespace {
 	}
 }
 
+namespace
+{
+	// Windings are modified by multiple threads when evaluating brushes
+	std::atomic<std::size_t> nextRevision(1);
+
+	inline Vector3f toFloat(const Vector3& v)
+	{
+		return Vector3f(static_cast<float>(v.x()), static_cast<float>(v.y()), static_cast<float>(v.z()));
+	}
+}
+
+Winding::Winding() :
+	_revision(nextRevision++)
+{}
+
+void Winding::markChanged()
+{
+	_revision = nextRevision++;
+}
+
+std::size_t Winding::getBatchRevision() const
+{
+	return _revision;
+}
+
+std::size_t Winding::getNumBatchVertices() const
+{
+	return size();
+}
+
+void Winding::writeBatchVertices(render::BatchVertex* vertices) const
+{
+	for (const WindingVertex& v : *this)
+	{
+		vertices->vertex = toFloat(v.vertex);
+		vertices->texcoord = BasicVector2<float>(static_cast<float>(v.texcoord.x()), static_cast<float>(v.texcoord.y()));
+		vertices->normal = toFloat(v.normal);
+		vertices->tangent = toFloat(v.tangent);
+		vertices->bitangent = toFloat(v.bitangent);
+		++vertices;
+	}
+}
+
 void Winding::drawWireframe() const
 {
 	if (!empty())
@@ -146,11 +190,19 @@ void Winding::testSelect(SelectionTest& test, SelectionIntersection& best)
 
 void Winding::updateNormals(const Vector3& normal)
 {
+	bool changed = false;
+
 	// Copy all normals into the winding vertices
 	for (iterator i = begin(); i != end(); ++i)
 	{
+		changed |= i->normal != normal;
 		i->normal = normal;
 	}
+
+	if (changed)
+	{
+		markChanged();
+	}
 }
 
 AABB Winding::aabb() const
@@ -192,19 +244,6 @@ BrushSplitType Winding::classifyPlane(const Plane3& plane) const
 	return split;
 }
 
-PlaneClassification Winding::classifyDistance(const float distance, const float epsilon)
-{
-	if (distance > epsilon) {
-		return ePlaneFront;
-	}
-
-	if (distance < -epsilon) {
-		return ePlaneBack;
-	}
-
-	return ePlaneOn;
-}
-
 bool Winding::planesConcave(const Winding& w1, const Winding& w2, const Plane3& plane1, const Plane3& plane2)
 {
 	return !w1.testPlane(plane2, false) || !w2.testPlane(plane1, false);
@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "math/Vector2.h"
 #include "math/Vector3.h"
+#include "render/BatchablePolygon.h"
 
 const double ON_EPSILON	= 1.0 / (1 << 8);
 
@@ -42,9 +43,25 @@ class SelectionIntersection;
 // by a few methods for rendering and selection tests.
 class Winding :
 	public IWinding,
-    public OpenGLRenderable
+    public OpenGLRenderable,
+	public render::IBatchablePolygon
 {
+private:
+	// Identifies the current geometry, see markChanged()
+	std::size_t _revision;
+
 public:
+	Winding();
+
+	// Assigns a new revision to this winding, this needs to be called after
+	// changing the vertices to get them re-uploaded by the render backend.
+	void markChanged();
+
+	// IBatchablePolygon implementation
+	std::size_t getBatchRevision() const override;
+	std::size_t getNumBatchVertices() const override;
+	void writeBatchVertices(render::BatchVertex* vertices) const override;
+
 	/** greebo: Calculates the AABB of this winding
 	 */
 	AABB aabb() const;
@@ -81,7 +98,18 @@ public:
 	// Returns the classification for the given plane
 	BrushSplitType classifyPlane(const Plane3& plane) const;
 
-	static PlaneClassification classifyDistance(const float distance, const float epsilon);
+	static PlaneClassification classifyDistance(const float distance, const float epsilon)
+	{
+		if (distance > epsilon) {
+			return ePlaneFront;
+		}
+
+		if (distance < -epsilon) {
+			return ePlaneBack;
+		}
+
+		return ePlaneOn;
+	}
 
 	/// \brief Returns true if
 	/// !flipped && winding is completely BACK or ON
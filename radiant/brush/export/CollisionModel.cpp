@@ -1,19 +1,13 @@
 #include "CollisionModel.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include "itextstream.h"
-#include "iselection.h"
-#include "ientity.h"
-#include "selectionlib.h"
-#include "gamelib.h"
-#include "brush/Brush.h"
-#include "brush/Winding.h"
 
 namespace cmutil {
 
 	namespace
 	{
-		const char* const GKEY_COLLISION_SHADER = "/defaults/collisionTexture";
-
 		const float MAX_PRECISION = 0.0001f;
 
 		// greebo: These are the empirical brush size factors (I think they work)
@@ -76,21 +70,89 @@ std::ostream& operator<< (std::ostream& st, const BrushStruc b) {
 	return st;
 }
 
-CollisionModel::CollisionModel() {
+namespace
+{
+	inline void combineHash(std::size_t& seed, std::size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	// Replicates the original edge comparison: every pair of equal (absolute)
+	// edge numbers counts, the lists match if the count reaches the edge count
+	bool edgesMatch(const EdgeList& edges, const EdgeList& otherEdges)
+	{
+		if (otherEdges.size() != edges.size()) {
+			return false;
+		}
+
+		std::size_t matches = 0;
+
+		for (std::size_t i = 0; i < edges.size(); i++) {
+			for (std::size_t j = 0; j < otherEdges.size(); j++) {
+				if (abs(edges[i]) == abs(otherEdges[j])) {
+					matches++;
+				}
+			}
+		}
+
+		return matches == otherEdges.size();
+	}
+
+	// Returns the sorted absolute edge numbers, these are the key of the polygon index
+	EdgeList getSortedEdges(const EdgeList& edges)
+	{
+		EdgeList sorted(edges.size());
+		std::transform(edges.begin(), edges.end(), sorted.begin(), [](int edge) { return abs(edge); });
+		std::sort(sorted.begin(), sorted.end());
+
+		return sorted;
+	}
+}
+
+std::size_t CollisionModel::VertexHash::operator()(const Vector3& vertex) const
+{
+	// The vertices are snapped to the MAX_PRECISION grid before they get here,
+	// so this is effectively a hash of the grid cell. -0 and 0 are equal, adding
+	// 0.0 makes sure they end up in the same bucket.
+	std::hash<double> hasher;
+	std::size_t seed = hasher(vertex.x() + 0.0);
+	combineHash(seed, hasher(vertex.y() + 0.0));
+	combineHash(seed, hasher(vertex.z() + 0.0));
+
+	return seed;
+}
+
+std::size_t CollisionModel::EdgeKeyHash::operator()(const EdgeKey& key) const
+{
+	std::size_t seed = std::hash<std::size_t>()(key.first);
+	combineHash(seed, std::hash<std::size_t>()(key.second));
+
+	return seed;
+}
+
+std::size_t CollisionModel::EdgeListHash::operator()(const EdgeList& edges) const
+{
+	std::size_t seed = edges.size();
+
+	for (int edge : edges) {
+		combineHash(seed, std::hash<int>()(edge));
+	}
+
+	return seed;
+}
+
+CollisionModel::CollisionModel(const std::string& polygonShader) :
+	_polygonShader(polygonShader)
+{
 	// Create the "NULL" edge (numVertices = 0)
 	_edges[0] = Edge(0);
+	_edgeIndices[EdgeKey(0, 0)] = 0;
 }
 
 int CollisionModel::findVertex(const Vector3& vertex) const {
-	for (VertexMap::const_iterator i = _vertices.begin();
-		i != _vertices.end();
-		++i)
-	{
-		if (i->second == vertex) {
-			return static_cast<int>(i->first);
-		}
-	}
-	return -1;
+	auto found = _vertexIndices.find(vertex);
+
+	return found != _vertexIndices.end() ? static_cast<int>(found->second) : -1;
 }
 
 std::size_t CollisionModel::addVertex(const Vector3& vertex)
@@ -104,7 +166,8 @@ std::size_t CollisionModel::addVertex(const Vector3& vertex)
 		// Insert the vertex at the end of the VertexMap
 		// The size of the map is the highest index + 1
 		std::size_t lastIndex = _vertices.size();
-		_vertices[lastIndex] = snapped;
+		_vertices.emplace_hint(_vertices.end(), lastIndex, snapped);
+		_vertexIndices.emplace(snapped, lastIndex);
 
 		return lastIndex;
 	}
@@ -115,20 +178,21 @@ std::size_t CollisionModel::addVertex(const Vector3& vertex)
 }
 
 int CollisionModel::findEdge(const Edge& edge) const {
-	for (EdgeMap::const_iterator i = _edges.begin();
-		 i != _edges.end();
-		 i++)
+	auto direct = _edgeIndices.find(EdgeKey(edge.from, edge.to));
+	auto opposite = _edgeIndices.find(EdgeKey(edge.to, edge.from));
+
+	// Direction match? This takes precedence if both match the same edge
+	if (direct != _edgeIndices.end() &&
+		(opposite == _edgeIndices.end() || direct->second <= opposite->second))
 	{
-		// Direction match?
-		if (i->second.from == edge.from && i->second.to == edge.to) {
-			return static_cast<int>(i->first);
-		}
+		return static_cast<int>(direct->second);
+	}
 
-		// Opposite direction match?
-		if (i->second.from == edge.to && i->second.to == edge.from) {
-			return -static_cast<int>(i->first);
-		}
+	// Opposite direction match?
+	if (opposite != _edgeIndices.end()) {
+		return -static_cast<int>(opposite->second);
 	}
+
 	return 0;
 }
 
@@ -139,7 +203,11 @@ std::size_t CollisionModel::addEdge(const Edge& edge) {
 	if (foundIndex == 0) {
 		// NULL edge found, insert the edge with a new index
 		std::size_t edgeIndex = _edges.size();
-		_edges[edgeIndex] = edge;
+		_edges.emplace_hint(_edges.end(), edgeIndex, edge);
+
+		// Only the first edge of a direction is ever found
+		_edgeIndices.emplace(EdgeKey(edge.from, edge.to), edgeIndex);
+
 		return edgeIndex;
 	}
 	else {
@@ -147,37 +215,60 @@ std::size_t CollisionModel::addEdge(const Edge& edge) {
 	}
 }
 
-int CollisionModel::findPolygon(const EdgeList& otherEdges) {
-	for (std::size_t p = 0; p < _polygons.size(); p++) {
-		// Check if the edge count matches
-		if (otherEdges.size() == _polygons[p].numEdges) {
-			// The match count
-			std::size_t matches = 0;
-
-			// See through the current polygon and count the matches
-			for (std::size_t i = 0; i < _polygons[p].edges.size(); i++) {
-				for (std::size_t j = 0; j < otherEdges.size(); j++) {
-					if (abs(_polygons[p].edges[i]) == abs(otherEdges[j])) {
-						matches++;
-					}
-				}
-			}
+bool CollisionModel::removeDuplicatePolygon(const EdgeList& otherEdges) {
+	EdgeList sorted = getSortedEdges(otherEdges);
+	bool distinct = std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
 
-			// If the polygons are the same, all the edge indices matched
-			if (matches == otherEdges.size()) {
-				// Remove the duplicate polygon
-				PolygonList::iterator i = _polygons.begin() + p;
-				_polygons.erase(i);
-				rMessage() << "CollisionModel: Removed duplicate polygon.\n";
-				return static_cast<int>(p);
+	// The lowest index of a matching polygon
+	std::size_t found = _polygons.size();
+
+	if (distinct) {
+		// Polygons with distinct edges only match if they have the same edge set
+		auto indexed = _polygonIndices.find(sorted);
+
+		if (indexed != _polygonIndices.end()) {
+			found = indexed->second;
+		}
+
+		// Polygons using an edge twice can match in other ways
+		for (std::size_t p : _irregularPolygons) {
+			if (p < found && edgesMatch(_polygons[p].edges, otherEdges)) {
+				found = p;
 			}
 		}
 	}
-	return -1;
+	else {
+		// An irregular polygon, go through them all
+		for (std::size_t p = 0; p < _polygons.size(); p++) {
+			if (!_removedPolygons[p] && edgesMatch(_polygons[p].edges, otherEdges)) {
+				found = p;
+				break;
+			}
+		}
+	}
+
+	if (found == _polygons.size()) {
+		return false;
+	}
+
+	// Remove the duplicate polygon
+	_removedPolygons[found] = true;
+
+	auto irregular = std::find(_irregularPolygons.begin(), _irregularPolygons.end(), found);
+
+	if (irregular != _irregularPolygons.end()) {
+		_irregularPolygons.erase(irregular);
+	}
+	else {
+		_polygonIndices.erase(getSortedEdges(_polygons[found].edges));
+	}
+
+	rMessage() << "CollisionModel: Removed duplicate polygon.\n";
+	return true;
 }
 
 void CollisionModel::addPolygon(
-	const Face& face,
+	const FaceGeometry& face,
 	const VertexList& vertexList)
 {
 	Polygon poly;
@@ -193,31 +284,46 @@ void CollisionModel::addPolygon(
 		poly.edges.push_back(findEdge(edge));
 	}
 
-	if (findPolygon(poly.edges) == -1) {
-		AABB faceAABB = face.getWinding().aabb();
+	if (!removeDuplicatePolygon(poly.edges)) {
+		AABB faceAABB;
+
+		for (const Vector3& vertex : face.winding) {
+			faceAABB.includePoint(vertex);
+		}
 
 		poly.numEdges = poly.edges.size();
-		poly.plane = face.plane3();
+		poly.plane = face.plane;
 		poly.min = faceAABB.origin - faceAABB.extents;
 		poly.max = faceAABB.origin + faceAABB.extents;
-		//poly.shader = face.GetShader();
-		poly.shader = game::current::getValue<std::string>(GKEY_COLLISION_SHADER);
+		poly.shader = _polygonShader;
+
+		// Index the new polygon for the duplicate lookups
+		std::size_t index = _polygons.size();
+		EdgeList sorted = getSortedEdges(poly.edges);
+
+		if (std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end()) {
+			_polygonIndices.emplace(std::move(sorted), index);
+		}
+		else {
+			_irregularPolygons.push_back(index);
+		}
 
 		_polygons.push_back(poly);
+		_removedPolygons.push_back(false);
 	}
 }
 
 VertexList CollisionModel::addWinding(
-	const Winding& winding)
+	const std::vector<Vector3>& winding)
 {
 	VertexList vertexList;
 
-	for (Winding::const_iterator i = winding.begin(); i != winding.end(); ++i) {
+	for (std::vector<Vector3>::const_iterator i = winding.begin(); i != winding.end(); ++i) {
 		// Create a vertexId and add it to the stack
-		vertexList.push_back(addVertex(i->vertex));
+		vertexList.push_back(addVertex(*i));
 	}
 	// Now add the first vertex a second time to the end of the list
-	vertexList.push_back(addVertex(winding.begin()->vertex));
+	vertexList.push_back(addVertex(winding.front()));
 
 	if (vertexList.size() > 1) {
 		Edge edge;
@@ -238,28 +344,30 @@ VertexList CollisionModel::addWinding(
 	return vertexList;
 }
 
-void CollisionModel::addBrush(Brush& brush) {
+void CollisionModel::addBrush(const BrushGeometry& brush) {
 	BrushStruc b;
 
 	// The number of faces
-	b.numFaces = brush.getNumFaces();
+	b.numFaces = brush.faces.size();
 
-	// Get the AABB of this brush
-	AABB brushAABB = brush.localAABB();
-
-	b.min = brushAABB.origin - brushAABB.extents;
-	b.max = brushAABB.origin + brushAABB.extents;
+	b.min = brush.bounds.origin - brush.bounds.extents;
+	b.max = brush.bounds.origin + brush.bounds.extents;
 
 	// Populate the FaceList
-	for (Brush::const_iterator i = brush.begin(); i != brush.end(); i++) {
+	for (const FaceGeometry& face : brush.faces) {
 		// Store the plane into the brush
-		b.planes.push_back((*i)->plane3());
+		b.planes.push_back(face.plane);
+
+		if (face.winding.empty()) {
+			rError() << "Warning: degenerate winding found.\n";
+			continue;
+		}
 
 		// Parse the winding of this Face for vertices/edges
-		VertexList vertexList = addWinding((*i)->getWinding());
+		VertexList vertexList = addWinding(face.winding);
 
 		// Pass the Face& and the VertexList to create the polygon
-		addPolygon(*(*i), vertexList);
+		addPolygon(face, vertexList);
 	}
 
 	// Store the BrushStruc into the list
@@ -318,7 +426,9 @@ std::ostream& operator<<(std::ostream& st, const CollisionModel& cm) {
 	// Export the polygons
 	st << "\tpolygons {\n";
 	for (std::size_t i = 0; i < cm._polygons.size(); i++) {
-		st << "\t" << cm._polygons[i] << "\n";
+		if (!cm._removedPolygons[i]) {
+			st << "\t" << cm._polygons[i] << "\n";
+		}
 	}
 	st << "\t}\n";
 
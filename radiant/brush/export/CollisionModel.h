@@ -2,10 +2,7 @@
 
 #include "Geometry.h"
 #include <memory>
-
-class Winding;
-class Brush;
-class Face;
+#include <unordered_map>
 
 namespace cmutil {
 
@@ -19,10 +16,45 @@ class CollisionModel
 
 	std::string _model;
 
+	// The shader assigned to all polygons
+	std::string _polygonShader;
+
+	// Hash of the snapped vertices, they are compared exactly
+	struct VertexHash
+	{
+		std::size_t operator()(const Vector3& vertex) const;
+	};
+	std::unordered_map<Vector3, std::size_t, VertexHash> _vertexIndices;
+
+	// Hash of the directed edges (from, to) => lowest edge index
+	typedef std::pair<std::size_t, std::size_t> EdgeKey;
+
+	struct EdgeKeyHash
+	{
+		std::size_t operator()(const EdgeKey& key) const;
+	};
+	std::unordered_map<EdgeKey, std::size_t, EdgeKeyHash> _edgeIndices;
+
+	// Polygons with distinct edges are indexed by their sorted absolute edge numbers
+	struct EdgeListHash
+	{
+		std::size_t operator()(const EdgeList& edges) const;
+	};
+	std::unordered_map<EdgeList, std::size_t, EdgeListHash> _polygonIndices;
+
+	// The (degenerate) polygons using an edge more than once, these are compared one by one
+	std::vector<std::size_t> _irregularPolygons;
+
+	// Polygons which turned out to be duplicates, these are skipped on export
+	std::vector<bool> _removedPolygons;
+
 public:
-	CollisionModel();
+	/** greebo: Constructs an empty CM, all polygons get the given shader
+	 * 			(usually the game's collision texture).
+	 */
+	CollisionModel(const std::string& polygonShader);
 
-	void addBrush(Brush& brush);
+	void addBrush(const BrushGeometry& brush);
 
 	/** greebo: Stream insertion operator, use this to write
 	 * the collision model into a file. Qualified as "friend" to allow the access
@@ -60,7 +92,7 @@ private:
 	 * @returns: the VertexList defining the Winding points in a
 	 * 			 closed loop (last vertexId = first vertexId)
 	 */
-	VertexList addWinding(const Winding& winding);
+	VertexList addWinding(const std::vector<Vector3>& winding);
 
 	/** greebo: Adds the given edge to the internal edge map
 	 * and returns its index. If the edge already exists,
@@ -72,26 +104,28 @@ private:
 
 	/** greebo: Tries to lookup the index of the given edge,
 	 * 			and returns the index with the factor +1/-1
-	 * 			according to the direction.
+	 * 			according to the direction. The edge with the
+	 * 			lowest index wins if there are several.
 	 *
 	 * @returns: +index / -index of the edge or 0 for the NULL edge
 	 */
 	int findEdge(const Edge& edge) const;
 
-	/** greebo: Tries to lookup the index of the matching polygon.
+	/** greebo: Tries to lookup the first polygon matching the given edges.
 	 * 			All the Edge indices are compared regardless of
-	 * 			their order.
+	 * 			their order. A matching polygon is removed, since
+	 * 			the two polygons cancel each other out.
 	 *
-	 * @returns: the index of the polygon or -1 if not found
+	 * @returns: true if a duplicate polygon has been found and removed
 	 */
-	int findPolygon(const EdgeList& otherEdges);
+	bool removeDuplicatePolygon(const EdgeList& otherEdges);
 
 	/** greebo: Adds a polygon basing on the given face & vertexlist.
 	 * 			Be sure to add the first vertex a second time
 	 * 			to the end of the pass a "closed" winding.
 	 * 			Duplicate polygons are not added.
 	 */
-	void addPolygon(const Face& face, const VertexList& vertexList);
+	void addPolygon(const FaceGeometry& face, const VertexList& vertexList);
 };
 
 typedef std::shared_ptr<CollisionModel> CollisionModelPtr;
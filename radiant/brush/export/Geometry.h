@@ -5,6 +5,7 @@
 #include <vector>
 #include "math/Vector3.h"
 #include "math/Plane3.h"
+#include "math/AABB.h"
 
 /** greebo: This contains all the geometry subtypes of a Doom3 CollisionModel.
  **/
@@ -68,6 +69,18 @@ struct BrushStruc {
 
 typedef std::vector<BrushStruc> BrushList;
 
+// The source geometry of a single brush face: its plane and the winding points
+struct FaceGeometry {
+	Plane3 plane;
+	std::vector<Vector3> winding;
+};
+
+// The source geometry of a brush, copied from the scene before building the CM
+struct BrushGeometry {
+	AABB bounds;
+	std::vector<FaceGeometry> faces;
+};
+
 } // namespace cmutil
 
 #endif /*CM_GEOMETRY_H_*/
@@ -0,0 +1,226 @@
+#include "AttributeTable.h"
+
+#include <algorithm>
+#include "string/string.h"
+
+namespace eclass
+{
+
+namespace
+{
+    // Same order as the HotKey enum
+    const char* const HOT_KEY_NAMES[AttributeTable::NUM_HOT_KEYS] =
+    {
+        "editor_mins",
+        "editor_maxs",
+        "model",
+        "spawnclass",
+        "inherit",
+    };
+
+    // Heap memory of a std::string, beyond the object itself
+    inline std::size_t getStringHeapUsage(const std::string& str)
+    {
+        return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+    }
+
+}
+
+StringPool::StringPtr StringPool::intern(const std::string& str)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    auto found = _strings.find(std::string_view(str));
+
+    if (found != _strings.end())
+    {
+        return found->second;
+    }
+
+    StringPtr pooled = std::make_shared<std::string>(str);
+    _strings.emplace(std::string_view(*pooled), pooled);
+
+    return pooled;
+}
+
+EntityClassAttribute StringPool::createAttribute(const std::string& type, const std::string& name,
+                                                 const std::string& value, const std::string& description)
+{
+    return EntityClassAttribute(intern(type), intern(name), intern(value), intern(description));
+}
+
+std::size_t StringPool::size() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _strings.size();
+}
+
+std::size_t StringPool::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // Every string lives in a block shared with its reference counts,
+    // the map adds a node per string and a bucket array
+    const std::size_t sharedBlock = sizeof(std::string) + 2 * sizeof(long) + sizeof(void*);
+    const std::size_t mapNode = sizeof(std::string_view) + sizeof(StringPtr) + 2 * sizeof(void*);
+
+    std::size_t bytes = _strings.bucket_count() * sizeof(void*);
+
+    for (const auto& pair : _strings)
+    {
+        bytes += sharedBlock + mapNode + getStringHeapUsage(*pair.second);
+    }
+
+    return bytes;
+}
+
+void StringPool::removeUnused()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    for (auto i = _strings.begin(); i != _strings.end(); )
+    {
+        if (i->second.use_count() == 1)
+        {
+            i = _strings.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void StringPool::clear()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _strings.clear();
+}
+
+StringPool& StringPool::Instance()
+{
+    static StringPool _instance;
+    return _instance;
+}
+
+AttributeTable::AttributeTable()
+{
+    _hotKeys.fill(-1);
+}
+
+std::size_t AttributeTable::findIndex(const std::string& name, unsigned int hash, bool& found) const
+{
+    std::size_t i = std::lower_bound(_hashes.begin(), _hashes.end(), hash) - _hashes.begin();
+
+    // Attributes with the same hash are ordered by name
+    for (; i < _hashes.size() && _hashes[i] == hash; ++i)
+    {
+        int comparison = string_compare_nocase(_attributes[i].getName().c_str(), name.c_str());
+
+        if (comparison >= 0)
+        {
+            found = comparison == 0;
+            return i;
+        }
+    }
+
+    found = false;
+    return i;
+}
+
+const EntityClassAttribute* AttributeTable::find(const std::string& name, unsigned int hash) const
+{
+    bool found;
+    std::size_t i = findIndex(name, hash, found);
+
+    return found ? &_attributes[i] : nullptr;
+}
+
+std::pair<EntityClassAttribute*, bool> AttributeTable::insert(const EntityClassAttribute& attribute)
+{
+    unsigned int hash = hashName(attribute.getName());
+
+    bool found;
+    std::size_t index = findIndex(attribute.getName(), hash, found);
+
+    if (found)
+    {
+        return std::make_pair(&_attributes[index], false);
+    }
+
+    _attributes.insert(_attributes.begin() + index, attribute);
+    _hashes.insert(_hashes.begin() + index, hash);
+
+    // Move the hot keys behind the inserted attribute
+    for (int& hotKey : _hotKeys)
+    {
+        if (hotKey >= static_cast<int>(index))
+        {
+            ++hotKey;
+        }
+    }
+
+    HotKey hotKey = getHotKey(attribute.getName());
+
+    if (hotKey != NO_HOT_KEY)
+    {
+        _hotKeys[hotKey] = static_cast<int>(index);
+    }
+
+    return std::make_pair(&_attributes[index], true);
+}
+
+void AttributeTable::clear()
+{
+    _attributes.clear();
+    _hashes.clear();
+    _hotKeys.fill(-1);
+}
+
+void AttributeTable::shrinkToFit()
+{
+    _attributes.shrink_to_fit();
+    _hashes.shrink_to_fit();
+}
+
+std::size_t AttributeTable::getMemoryUsage() const
+{
+    return sizeof(AttributeTable) + _attributes.capacity() * sizeof(EntityClassAttribute) +
+        _hashes.capacity() * sizeof(unsigned int);
+}
+
+AttributeTable::HotKey AttributeTable::getHotKey(const std::string& name)
+{
+    // Most names can be rejected by their length
+    switch (name.length())
+    {
+    case 5:
+        return string_equal_nocase(name.c_str(), HOT_KEY_NAMES[MODEL]) ? MODEL : NO_HOT_KEY;
+    case 7:
+        return string_equal_nocase(name.c_str(), HOT_KEY_NAMES[INHERIT]) ? INHERIT : NO_HOT_KEY;
+    case 10:
+        return string_equal_nocase(name.c_str(), HOT_KEY_NAMES[SPAWNCLASS]) ? SPAWNCLASS : NO_HOT_KEY;
+    case 11:
+        if (string_equal_nocase(name.c_str(), HOT_KEY_NAMES[EDITOR_MINS])) return EDITOR_MINS;
+        if (string_equal_nocase(name.c_str(), HOT_KEY_NAMES[EDITOR_MAXS])) return EDITOR_MAXS;
+        return NO_HOT_KEY;
+    default:
+        return NO_HOT_KEY;
+    }
+}
+
+unsigned int AttributeTable::hashName(const std::string& name)
+{
+    // FNV-1a of the lowercase characters
+    unsigned int hash = 2166136261u;
+
+    for (char c : name)
+    {
+        hash ^= static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+} // namespace
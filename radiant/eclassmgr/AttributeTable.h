@@ -0,0 +1,158 @@
+#pragma once
+
+#include "ieclass.h"
+
+#include <array>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace eclass
+{
+
+/**
+ * Pool of the strings used by entity class attributes. The same few
+ * types, key names and values are used by thousands of attributes, each
+ * distinct string is only stored once.
+ */
+class StringPool
+{
+public:
+    typedef EntityClassAttribute::StringPtr StringPtr;
+
+private:
+    // The keys are pointing to the strings owned by the values
+    std::unordered_map<std::string_view, StringPtr> _strings;
+
+    mutable std::mutex _lock;
+
+public:
+    /// Returns the shared instance of the given string
+    StringPtr intern(const std::string& str);
+
+    /// Construct an attribute using pooled strings
+    EntityClassAttribute createAttribute(const std::string& type, const std::string& name,
+                                         const std::string& value, const std::string& description);
+
+    /// The number of distinct strings
+    std::size_t size() const;
+
+    /// Approximate number of bytes used by the pooled strings
+    std::size_t getMemoryUsage() const;
+
+    /// Drop the strings which are no longer referenced by any attribute
+    void removeUnused();
+
+    /// Forget all strings, the ones still referenced stay valid
+    void clear();
+
+    /// The pool shared by all entity classes
+    static StringPool& Instance();
+};
+
+/**
+ * The attributes defined by a single entity class, without the inherited
+ * ones. The attributes are kept in a vector sorted by the hash of their
+ * lowercase name, such that they can be looked up with a binary search on
+ * integers, without allocating a temporary key. A lookup following the
+ * inheritance chain only needs to hash the name once.
+ *
+ * The frequently queried keys are looked up through a fixed index.
+ */
+class AttributeTable
+{
+public:
+    // Keys queried for almost every entity class
+    enum HotKey
+    {
+        EDITOR_MINS,
+        EDITOR_MAXS,
+        MODEL,
+        SPAWNCLASS,
+        INHERIT,
+        NUM_HOT_KEYS,
+        NO_HOT_KEY = NUM_HOT_KEYS
+    };
+
+    typedef std::vector<EntityClassAttribute> Attributes;
+    typedef Attributes::const_iterator const_iterator;
+
+private:
+    Attributes _attributes;
+
+    // The name hash of each attribute, in ascending order
+    std::vector<unsigned int> _hashes;
+
+    // Index of each hot key in the attribute vector, -1 if not defined
+    std::array<int, NUM_HOT_KEYS> _hotKeys;
+
+public:
+    AttributeTable();
+
+    /// Returns the attribute with the given name or NULL if it is not defined
+    const EntityClassAttribute* find(const std::string& name) const
+    {
+        return find(name, hashName(name));
+    }
+
+    EntityClassAttribute* find(const std::string& name)
+    {
+        return const_cast<EntityClassAttribute*>(find(name, hashName(name)));
+    }
+
+    /// Lookup using the result of hashName(name)
+    const EntityClassAttribute* find(const std::string& name, unsigned int hash) const;
+
+    const EntityClassAttribute* find(HotKey key) const
+    {
+        return _hotKeys[key] >= 0 ? &_attributes[_hotKeys[key]] : nullptr;
+    }
+
+    /**
+     * Insert the given attribute, unless there is one with the same name.
+     * Returns the attribute in the table and true if it has been inserted.
+     * This invalidates any pointers to the attributes of this table.
+     */
+    std::pair<EntityClassAttribute*, bool> insert(const EntityClassAttribute& attribute);
+
+    const_iterator begin() const
+    {
+        return _attributes.begin();
+    }
+
+    const_iterator end() const
+    {
+        return _attributes.end();
+    }
+
+    std::size_t size() const
+    {
+        return _attributes.size();
+    }
+
+    bool empty() const
+    {
+        return _attributes.empty();
+    }
+
+    void clear();
+
+    /// Release the spare capacity after parsing
+    void shrinkToFit();
+
+    /// Number of bytes used by the table itself, not counting the pooled strings
+    std::size_t getMemoryUsage() const;
+
+    /// Returns the hot key with the given name (ignoring case) or NO_HOT_KEY
+    static HotKey getHotKey(const std::string& name);
+
+    /// The hash of the lowercase name
+    static unsigned int hashName(const std::string& name);
+
+private:
+    // Index of the attribute with the given name or the position to insert it
+    std::size_t findIndex(const std::string& name, unsigned int hash, bool& found) const;
+};
+
+} // namespace
@@ -7,6 +7,7 @@
 
 #include "string/predicate.h"
 #include <fmt/format.h>
+#include <algorithm>
 #include <functional>
 
 namespace eclass
@@ -40,6 +41,21 @@ bool tryGetSuffixedKey(const std::string& key, const std::string& prefix, std::s
 	return false;
 }
 
+void writeVector3(parser::DeclWriter& writer, const Vector3& vector)
+{
+    writer.writeDouble(vector.x());
+    writer.writeDouble(vector.y());
+    writer.writeDouble(vector.z());
+}
+
+Vector3 readVector3(parser::DeclReader& reader)
+{
+    double x = reader.readDouble();
+    double y = reader.readDouble();
+
+    return Vector3(x, y, reader.readDouble());
+}
+
 } // namespace
 
 // Attachment helper object
@@ -193,6 +209,53 @@ public:
 			}
         }
     }
+
+    // Serialise the validated attachments for the DeclFileCache
+    void writeToCache(parser::DeclWriter& writer) const
+    {
+        writer.writeSize(_objects.size());
+
+        for (const AttachedObjects::value_type& pair : _objects)
+        {
+            writer.writeString(pair.first);
+            writer.writeString(pair.second.className);
+            writer.writeString(pair.second.name);
+            writer.writeString(pair.second.posName);
+        }
+
+        writer.writeSize(_positions.size());
+
+        for (const AttachPositions::value_type& pair : _positions)
+        {
+            writer.writeString(pair.first);
+            writer.writeString(pair.second.name);
+            writeVector3(writer, pair.second.origin);
+            writeVector3(writer, pair.second.angles);
+            writer.writeString(pair.second.joint);
+        }
+    }
+
+    void readFromCache(parser::DeclReader& reader)
+    {
+        clear();
+
+        for (std::size_t i = reader.readCount(16); i > 0; --i)
+        {
+            Attachment& attachment = _objects[reader.readString()];
+            attachment.className = reader.readString();
+            attachment.name = reader.readString();
+            attachment.posName = reader.readString();
+        }
+
+        for (std::size_t i = reader.readCount(60); i > 0; --i)
+        {
+            AttachPos& position = _positions[reader.readString()];
+            position.name = reader.readString();
+            position.origin = readVector3(reader);
+            position.angles = readVector3(reader);
+            position.joint = reader.readString();
+        }
+    }
 };
 
 const std::string Doom3EntityClass::DefaultWireShader("<0.3 0.3 1>");
@@ -214,7 +277,7 @@ Doom3EntityClass::Doom3EntityClass(const std::string& name, bool fixedSize)
   _skin(""),
   _inheritanceResolved(false),
   _modName("base"),
-  _emptyAttribute("", "", ""),
+  _emptyAttribute(StringPool::Instance().createAttribute("", "", "", "")),
   _attachments(new Attachments(name)),
   _parseStamp(0)
 {}
@@ -247,8 +310,8 @@ bool Doom3EntityClass::isFixedSize() const
     else {
         // Check for the existence of editor_mins/maxs attributes, and that
         // they do not contain only a question mark
-        return (getAttribute("editor_mins").getValue().size() > 1
-                && getAttribute("editor_maxs").getValue().size() > 1);
+        return (getAttributeValue(AttributeTable::EDITOR_MINS).size() > 1
+                && getAttributeValue(AttributeTable::EDITOR_MAXS).size() > 1);
     }
 }
 
@@ -257,8 +320,8 @@ AABB Doom3EntityClass::getBounds() const
     if (isFixedSize())
     {
         return AABB::createFromMinMax(
-            string::convert<Vector3>(getAttribute("editor_mins").getValue()),
-            string::convert<Vector3>(getAttribute("editor_maxs").getValue())
+            string::convert<Vector3>(getAttributeValue(AttributeTable::EDITOR_MINS)),
+            string::convert<Vector3>(getAttributeValue(AttributeTable::EDITOR_MAXS))
         );
     }
     else
@@ -321,13 +384,11 @@ const std::string& Doom3EntityClass::getFillShader() const
 void Doom3EntityClass::addAttribute(const EntityClassAttribute& attribute)
 {
     // Try to insert the class attribute
-    std::pair<EntityAttributeMap::iterator, bool> result = _attributes.insert(
-        EntityAttributeMap::value_type(attribute.getNameRef(), attribute)
-    );
+    std::pair<EntityClassAttribute*, bool> result = _attributes.insert(attribute);
 
     if (!result.second)
     {
-        EntityClassAttribute& existing = result.first->second;
+        EntityClassAttribute& existing = *result.first;
 
         // greebo: Attribute already existed, check if we have some
         // descriptive properties to be added to the existing one.
@@ -356,24 +417,79 @@ void Doom3EntityClass::forEachClassAttribute(
     std::function<void(const EntityClassAttribute&)> visitor,
     bool editorKeys) const
 {
-    for (EntityAttributeMap::const_iterator i = _attributes.begin();
-         i != _attributes.end();
-         ++i)
+    // Collect the attributes of the whole chain, the ones of the closer
+    // classes first, such that they are kept when dropping the duplicates
+    std::vector<const EntityClassAttribute*> attributes;
+    std::vector<bool> inherited;
+
+    for (const Doom3EntityClass* eclass = this; eclass != nullptr; eclass = eclass->_parent)
     {
+        for (const EntityClassAttribute& attribute : eclass->_attributes)
+        {
+            attributes.push_back(&attribute);
+            inherited.push_back(eclass != this);
+        }
+    }
+
+    std::vector<std::size_t> order(attributes.size());
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+    {
+        return string_compare_nocase(attributes[a]->getName().c_str(),
+                                     attributes[b]->getName().c_str()) < 0;
+    });
+
+    const EntityClassAttribute* previous = nullptr;
+
+    for (std::size_t i : order)
+    {
+        const EntityClassAttribute& attribute = *attributes[i];
+
+        // Skip the attributes overridden by a closer class
+        if (previous != nullptr &&
+            string_equal_nocase(previous->getName().c_str(), attribute.getName().c_str()))
+        {
+            continue;
+        }
+
+        previous = &attribute;
+
         // Visit if it is a non-editor key or we are visiting all keys
-        if (editorKeys || !string::istarts_with(*i->first, "editor_"))
+        if (editorKeys || !string::istarts_with(attribute.getName(), "editor_"))
         {
-            visitor(i->second);
+            if (inherited[i])
+            {
+                visitor(EntityClassAttribute(attribute, true));
+            }
+            else
+            {
+                visitor(attribute);
+            }
         }
     }
 }
 
-namespace
+void Doom3EntityClass::mergeInheritedDescriptions()
 {
-    void copyInheritedAttribute(Doom3EntityClass* target,
-                                const EntityClassAttribute& attr)
+    for (const EntityClassAttribute& own : _attributes)
     {
-        target->addAttribute(EntityClassAttribute(attr, true));
+        if (!own.getDescription().empty() && own.getType() != "text")
+        {
+            continue;
+        }
+
+        const EntityClassAttribute* inherited = _parent->findAttribute(own.getName());
+
+        if (inherited != nullptr)
+        {
+            // Uses the same rules as adding an attribute which already exists
+            addAttribute(*inherited);
+        }
     }
 }
 
@@ -387,7 +503,9 @@ void Doom3EntityClass::resolveInheritance(EntityClasses& classmap)
     // Lookup the parent name and return if it is not set. Also return if the
     // parent name is the same as our own classname, to avoid infinite
     // recursion.
-    std::string parName = getAttribute("inherit").getValue();
+    const EntityClassAttribute* inherit = _attributes.find(AttributeTable::INHERIT);
+    std::string parName = inherit != nullptr ? inherit->getValue() : std::string();
+
     if (parName.empty() || parName == _name)
         return;
 
@@ -398,13 +516,10 @@ void Doom3EntityClass::resolveInheritance(EntityClasses& classmap)
         // Recursively resolve inheritance of parent
         pIter->second->resolveInheritance(classmap);
 
-        // Copy attributes from the parent to the child, including editor keys
-        pIter->second->forEachClassAttribute(
-            std::bind(&copyInheritedAttribute, this, std::placeholders::_1), true
-        );
-
-        // Set our parent pointer
+        // Set our parent pointer, the attributes are looked up through it
         _parent = pIter->second.get();
+
+        mergeInheritedDescriptions();
     }
     else
     {
@@ -416,13 +531,15 @@ void Doom3EntityClass::resolveInheritance(EntityClasses& classmap)
     // Set the resolved flag
     _inheritanceResolved = true;
 
-    if (!getAttribute("model").getValue().empty())
+    const std::string& model = getAttributeValue(AttributeTable::MODEL);
+
+    if (!model.empty())
     {
         // We have a model path (probably an inherited one)
-        setModelPath(getAttribute("model").getValue());
+        setModelPath(model);
     }
 
-    if (getAttribute("editor_light").getValue() == "1" || getAttribute("spawnclass").getValue() == "idLight")
+    if (getAttribute("editor_light").getValue() == "1" || getAttributeValue(AttributeTable::SPAWNCLASS) == "idLight")
     {
         // We have a light
         setIsLight(true);
@@ -463,24 +580,59 @@ bool Doom3EntityClass::isOfType(const std::string& className)
 	return false;
 }
 
-// Find a single attribute
-EntityClassAttribute& Doom3EntityClass::getAttribute(const std::string& name)
+const EntityClassAttribute* Doom3EntityClass::findAttribute(const std::string& name) const
+{
+    AttributeTable::HotKey hotKey = AttributeTable::getHotKey(name);
+
+    if (hotKey != AttributeTable::NO_HOT_KEY)
+    {
+        return findAttribute(hotKey);
+    }
+
+    // The name is hashed once for the whole inheritance chain
+    unsigned int hash = AttributeTable::hashName(name);
+
+    for (const Doom3EntityClass* eclass = this; eclass != nullptr; eclass = eclass->_parent)
+    {
+        const EntityClassAttribute* attribute = eclass->_attributes.find(name, hash);
+
+        if (attribute != nullptr)
+        {
+            return attribute;
+        }
+    }
+
+    return nullptr;
+}
+
+const EntityClassAttribute* Doom3EntityClass::findAttribute(AttributeTable::HotKey key) const
 {
-    StringPtr ref(new std::string(name));
+    for (const Doom3EntityClass* eclass = this; eclass != nullptr; eclass = eclass->_parent)
+    {
+        const EntityClassAttribute* attribute = eclass->_attributes.find(key);
 
-    EntityAttributeMap::iterator f = _attributes.find(ref);
+        if (attribute != nullptr)
+        {
+            return attribute;
+        }
+    }
+
+    return nullptr;
+}
+
+const std::string& Doom3EntityClass::getAttributeValue(AttributeTable::HotKey key) const
+{
+    const EntityClassAttribute* attribute = findAttribute(key);
 
-    return (f != _attributes.end()) ? f->second : _emptyAttribute;
+    return attribute != nullptr ? attribute->getValue() : _emptyAttribute.getValue();
 }
 
 // Find a single attribute
 const EntityClassAttribute& Doom3EntityClass::getAttribute(const std::string& name) const
 {
-    StringPtr ref(new std::string(name));
+    const EntityClassAttribute* attribute = findAttribute(name);
 
-    EntityAttributeMap::const_iterator f = _attributes.find(ref);
-
-    return (f != _attributes.end()) ? f->second : _emptyAttribute;
+    return attribute != nullptr ? *attribute : _emptyAttribute;
 }
 
 void Doom3EntityClass::clear()
@@ -493,6 +645,10 @@ void Doom3EntityClass::clear()
 
     _fixedSize = false;
 
+    // The attributes are looked up through the parent, which is set again
+    // when resolving the inheritance
+    _parent = nullptr;
+
     _attributes.clear();
     _model.clear();
     _skin.clear();
@@ -533,7 +689,7 @@ void Doom3EntityClass::parseEditorSpawnarg(const std::string& key,
 
             // Construct an attribute with empty value, but with valid
             // description
-            addAttribute(EntityClassAttribute(type, attName, "", value));
+            addAttribute(StringPool::Instance().createAttribute(type, attName, "", value));
         }
     }
 }
@@ -578,18 +734,17 @@ void Doom3EntityClass::parseFromTokens(parser::DefTokeniser& tokeniser)
         _attachments->parseDefAttachKeys(key, value);
 
         // Add the EntityClassAttribute for this key/val
-        if (getAttribute(key).getType().empty())
+        EntityClassAttribute* existing = _attributes.find(key);
+
+        if (existing == nullptr)
         {
             // Following key-specific processing, add the keyvalue to the eclass
-            EntityClassAttribute attribute("text", key, value, "");
-
-            // Type is empty, attribute does not exist, add it.
-            addAttribute(attribute);
+            addAttribute(StringPool::Instance().createAttribute("text", key, value, ""));
         }
-        else if (getAttribute(key).getValue().empty())
+        else if (existing->getValue().empty())
         {
             // Attribute type is set, but value is empty, set the value.
-            getAttribute(key).setValue(value);
+            existing->setValue(StringPool::Instance().intern(value));
         }
         else
         {
@@ -601,6 +756,60 @@ void Doom3EntityClass::parseFromTokens(parser::DefTokeniser& tokeniser)
 
     _attachments->validateAttachments();
 
+    _attributes.shrinkToFit();
+
+    // Notify the observers
+    _changedSignal.emit();
+}
+
+void Doom3EntityClass::writeToCache(parser::DeclWriter& writer) const
+{
+    writer.writeBool(_isLight);
+    writeVector3(writer, _colour);
+    writer.writeString(_fillShader);
+    writer.writeString(_wireShader);
+    writer.writeBool(_fixedSize);
+    writer.writeString(_model);
+    writer.writeString(_skin);
+
+    writer.writeSize(_attributes.size());
+
+    for (const EntityClassAttribute& attribute : _attributes)
+    {
+        writer.writeString(attribute.getType());
+        writer.writeString(attribute.getName());
+        writer.writeString(attribute.getValue());
+        writer.writeString(attribute.getDescription());
+    }
+
+    _attachments->writeToCache(writer);
+}
+
+void Doom3EntityClass::readFromCache(parser::DeclReader& reader)
+{
+    clear();
+
+    _isLight = reader.readBool();
+    _colour = readVector3(reader);
+    _fillShader = reader.readString();
+    _wireShader = reader.readString();
+    _fixedSize = reader.readBool();
+    _model = reader.readString();
+    _skin = reader.readString();
+
+    for (std::size_t i = reader.readCount(16); i > 0; --i)
+    {
+        std::string type = reader.readString();
+        std::string name = reader.readString();
+        std::string value = reader.readString();
+
+        _attributes.insert(StringPool::Instance().createAttribute(type, name, value, reader.readString()));
+    }
+
+    _attachments->readFromCache(reader);
+
+    _attributes.shrinkToFit();
+
     // Notify the observers
     _changedSignal.emit();
 }
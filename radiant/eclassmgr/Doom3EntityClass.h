@@ -8,6 +8,9 @@
 #include "string/string.h"
 
 #include "parser/DefTokeniser.h"
+#include "parser/DeclFileCache.h"
+
+#include "AttributeTable.h"
 
 #include <vector>
 #include <map>
@@ -30,23 +33,11 @@ typedef std::shared_ptr<Doom3EntityClass> Doom3EntityClassPtr;
 class Doom3EntityClass
 : public IEntityClass
 {
-    typedef std::shared_ptr<std::string> StringPtr;
-
-    class StringCompareFunctor
-    {
-    public:
-        bool operator()(const StringPtr& lhs, const StringPtr& rhs) const
-        {
-            //return boost::algorithm::ilexicographical_compare(lhs, rhs); // this is slow!
-            return string_compare_nocase(lhs->c_str(), rhs->c_str()) < 0;
-        }
-    };
-
     // The name of this entity class
     std::string _name;
 
     // Parent class pointer (or NULL)
-    IEntityClass* _parent;
+    Doom3EntityClass* _parent;
 
     // Should this entity type be treated as a light?
     bool _isLight;
@@ -66,28 +57,22 @@ class Doom3EntityClass
     // Does this entity have a fixed size?
     bool _fixedSize;
 
-    // Map of named EntityAttribute structures. EntityAttributes are picked
-    // up from the DEF file during parsing. Ignores key case.
+    // The EntityAttributes defined by this class, picked up from the DEF file
+    // during parsing. Ignores key case.
 
-    // greebo: I've changed the EntityAttributeMap key type to StringPtr, to save
-    // more than 130 MB of string data used for just the keys. A default TDM installation
-    // has about 780k entity class attributes after resolving inheritance.
-    // However, the memory saving comes with a performance cost since we need 
-    // to convert the incoming std::string queries to StringRefs before passing
-    // them to std::map::find(). During a regular DarkRadiant startup 
-    // there are about 64k find() operations, a single idLight
-    // creation costs about 30-40 find() operations, which is ok I guess.
-
-    typedef std::map<StringPtr, EntityClassAttribute, StringCompareFunctor> EntityAttributeMap;
-    EntityAttributeMap _attributes;
+    // A default TDM installation used to have about 780k entity class
+    // attributes after copying the inherited ones into every class. Only the
+    // attributes of the class itself are stored now, lookups continue with
+    // the parent class. The strings are shared through the StringPool.
+    AttributeTable _attributes;
 
     // The model and skin for this entity class (if it has one)
     std::string _model;
     std::string _skin;
 
     // Flag to indicate inheritance resolved. An EntityClass resolves its
-    // inheritance by copying all values from the parent onto the child,
-    // after recursively instructing the parent to resolve its own inheritance.
+    // inheritance by looking up its parent class, after recursively
+    // instructing the parent to resolve its own inheritance.
     bool _inheritanceResolved;
 
     // Name of the mod owning this class
@@ -112,6 +97,17 @@ private:
     void parseEditorSpawnarg(const std::string& key, const std::string& value);
     void setIsLight(bool val);
 
+    // Find the named attribute in this class or the closest parent defining it
+    const EntityClassAttribute* findAttribute(const std::string& name) const;
+    const EntityClassAttribute* findAttribute(AttributeTable::HotKey key) const;
+
+    // The value of the given hot key, empty if it is not defined
+    const std::string& getAttributeValue(AttributeTable::HotKey key) const;
+
+    // Adopt the description and type of the inherited attributes, for
+    // attributes this class defines without them
+    void mergeInheritedDescriptions();
+
 public:
 
     /**
@@ -164,7 +160,6 @@ public:
     const Vector3& getColour() const;
     const std::string& getWireShader() const;
     const std::string& getFillShader() const;
-    EntityClassAttribute& getAttribute(const std::string& name);
     const EntityClassAttribute& getAttribute(const std::string& name) const;
     void forEachClassAttribute(std::function<void(const EntityClassAttribute&)>,
                                bool) const;
@@ -193,6 +188,18 @@ public:
     typedef std::map<std::string, Doom3EntityClassPtr> EntityClasses;
     void resolveInheritance(EntityClasses& classmap);
 
+    /// The number of attributes defined by this class itself
+    std::size_t getNumOwnAttributes() const
+    {
+        return _attributes.size();
+    }
+
+    /// Number of bytes used by the attribute table, not counting the pooled strings
+    std::size_t getAttributeMemoryUsage() const
+    {
+        return _attributes.getMemoryUsage();
+    }
+
     /**
      * Return the mod name.
      */
@@ -210,6 +217,12 @@ public:
     // Initialises this class from the given tokens
     void parseFromTokens(parser::DefTokeniser& tokeniser);
 
+    // Stores the state parseFromTokens() left behind in the DeclFileCache record
+    void writeToCache(parser::DeclWriter& writer) const;
+
+    // Restores the state written by writeToCache(), as if the tokens were parsed again
+    void readFromCache(parser::DeclReader& reader);
+
     void setParseStamp(std::size_t parseStamp)
     {
         _parseStamp = parseStamp;
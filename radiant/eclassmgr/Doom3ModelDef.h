@@ -3,6 +3,7 @@
 
 #include "ieclass.h"
 #include "parser/DefTokeniser.h"
+#include "parser/DeclFileCache.h"
 
 namespace eclass {
 
@@ -97,6 +98,37 @@ public:
 	        }
 	    }
 	}
+
+	// Stores the data parsed from the tokens in the DeclFileCache record
+	void writeToCache(parser::DeclWriter& writer) const
+	{
+		writer.writeString(mesh);
+		writer.writeString(skin);
+		writer.writeString(parent);
+		writer.writeSize(anims.size());
+
+		for (const Anims::value_type& pair : anims)
+		{
+			writer.writeString(pair.first);
+			writer.writeString(pair.second);
+		}
+	}
+
+	// Restores the data written by writeToCache()
+	void readFromCache(parser::DeclReader& reader)
+	{
+		clear();
+
+		mesh = reader.readString();
+		skin = reader.readString();
+		parent = reader.readString();
+
+		for (std::size_t i = reader.readCount(8); i > 0; --i)
+		{
+			std::string animName = reader.readString();
+			anims[animName] = reader.readString();
+		}
+	}
 };
 typedef std::shared_ptr<Doom3ModelDef> Doom3ModelDefPtr;
 
@@ -10,7 +10,7 @@
 #include "iradiant.h"
 #include "iuimanager.h"
 #include "ifilesystem.h"
-#include "parser/DefTokeniser.h"
+#include "parser/BufferDefTokeniser.h"
 
 #include "Doom3EntityClass.h"
 #include "Doom3ModelDef.h"
@@ -131,10 +131,15 @@ void EClassManager::parseDefFiles()
 
 	{
 		ScopedDebugTimer timer("EntityDefs parsed: ");
+
+		_declCache.load();
+
         GlobalFileSystem().forEachFile(
             "def/", "def",
             [&](const vfs::FileInfo& fileInfo) { parseFile(fileInfo.name); }
         );
+
+		_declCache.save();
 	}
 }
 
@@ -169,6 +174,21 @@ void EClassManager::resolveInheritance()
         }
     }
 
+	// Report the memory used by the attributes, the inherited ones are not stored
+	std::size_t numAttributes = 0;
+	std::size_t attributeBytes = 0;
+
+	for (const EntityClasses::value_type& pair : _entityClasses)
+	{
+		numAttributes += pair.second->getNumOwnAttributes();
+		attributeBytes += pair.second->getAttributeMemoryUsage();
+	}
+
+	rMessage() << "[eclassmgr] " << _entityClasses.size() << " entity classes with "
+		<< numAttributes << " attributes using " << (attributeBytes / 1024) << " kB, "
+		<< StringPool::Instance().size() << " distinct strings using "
+		<< (StringPool::Instance().getMemoryUsage() / 1024) << " kB" << std::endl;
+
 	// greebo: Override the eclass colours of two special entityclasses
     Vector3 worlspawnColour = ColourSchemes().getColour("default_brush");
     Vector3 lightColour = ColourSchemes().getColour("light_volumes");
@@ -278,6 +298,9 @@ void EClassManager::reloadDefs()
 	// Resolve the eclass inheritance again
 	resolveInheritance();
 
+	// Release the strings of the replaced attributes
+	StringPool::Instance().removeUnused();
+
     _defsReloadedSignal.emit();
 }
 
@@ -306,6 +329,8 @@ void EClassManager::initialiseModule(const ApplicationContext& ctx)
 {
 	rMessage() << "EntityClassDoom3::initialiseModule called." << std::endl;
 
+	_declCache.setCacheFile(ctx.getSettingsPath() + "eclass.cache");
+
 	GlobalFileSystem().addObserver(*this);
 	realise();
 
@@ -328,6 +353,8 @@ void EClassManager::shutdownModule()
 	// Clear member structures
 	_entityClasses.clear();
 	_models.clear();
+
+	StringPool::Instance().clear();
 }
 
 // This takes care of relading the entityDefs and refreshing the scenegraph
@@ -351,14 +378,73 @@ void EClassManager::onFileSystemShutdown()
 	unrealise();
 }
 
-// Parse the provided stream containing the contents of a single .def file.
-// Extract all entitydefs and create objects accordingly.
-void EClassManager::parse(TextInputStream& inStr, const std::string& modDir)
+Doom3EntityClassPtr EClassManager::insertParsedEntityClass(const std::string& name)
 {
-	// Construct a tokeniser for the stream
-	std::istream is(&inStr);
-    parser::BasicDefTokeniser<std::istream> tokeniser(is);
+	// Ensure that an Entity class with this name already exists
+	// When reloading entityDef declarations, most names will already be registered
+	EntityClasses::iterator i = _entityClasses.find(name);
 
+	if (i == _entityClasses.end())
+	{
+		// Not existing yet, allocate a new class
+		Doom3EntityClassPtr entityClass(new eclass::Doom3EntityClass(name));
+
+		std::pair<EntityClasses::iterator, bool> result = _entityClasses.insert(
+			EntityClasses::value_type(name, entityClass)
+		);
+
+		i = result.first;
+	}
+	else
+	{
+		// EntityDef already exists, compare the parse stamp
+		if (i->second->getParseStamp() == _curParseStamp)
+		{
+			rWarning() << "[eclassmgr]: EntityDef "
+				<< name << " redefined" << std::endl;
+		}
+	}
+
+	i->second->setParseStamp(_curParseStamp);
+
+	return i->second;
+}
+
+Doom3ModelDefPtr EClassManager::insertParsedModel(const std::string& name)
+{
+	Models::iterator i = _models.find(name);
+
+	if (i == _models.end())
+	{
+		// Does not exist yet, allocate an empty ModelDef
+		Doom3ModelDefPtr model(new Doom3ModelDef(name));
+
+		std::pair<Models::iterator, bool> result = _models.insert(
+			Models::value_type(name, model)
+		);
+
+		i = result.first;
+	}
+	else
+	{
+		// Model already exists, compare the parse stamp
+		if (i->second->getParseStamp() == _curParseStamp)
+		{
+			rWarning() << "[eclassmgr]: Model "
+				<< name << " redefined" << std::endl;
+		}
+	}
+
+	i->second->setParseStamp(_curParseStamp);
+
+	return i->second;
+}
+
+// Parse the tokens of a single .def file.
+// Extract all entitydefs and create objects accordingly.
+void EClassManager::parse(parser::DefTokeniser& tokeniser, const std::string& modDir,
+						  ParsedDecls& decls)
+{
     while (tokeniser.hasMoreTokens())
 	{
         std::string blockType = tokeniser.nextToken();
@@ -370,95 +456,116 @@ void EClassManager::parse(TextInputStream& inStr, const std::string& modDir)
 			const std::string sName =
     			string::to_lower_copy(tokeniser.nextToken());
 
-			// Ensure that an Entity class with this name already exists
-			// When reloading entityDef declarations, most names will already be registered
-			EntityClasses::iterator i = _entityClasses.find(sName);
-
-			if (i == _entityClasses.end())
-			{
-				// Not existing yet, allocate a new class
-        		Doom3EntityClassPtr entityClass(new eclass::Doom3EntityClass(sName));
-
-				std::pair<EntityClasses::iterator, bool> result = _entityClasses.insert(
-					EntityClasses::value_type(sName, entityClass)
-				);
-
-				i = result.first;
-			}
-			else
-			{
-				// EntityDef already exists, compare the parse stamp
-				if (i->second->getParseStamp() == _curParseStamp)
-				{
-					rWarning() << "[eclassmgr]: EntityDef "
-						<< sName << " redefined" << std::endl;
-				}
-			}
-
-			// At this point, i is pointing to a valid entityclass
-
-			i->second->setParseStamp(_curParseStamp);
+			Doom3EntityClassPtr entityClass = insertParsedEntityClass(sName);
 
         	// Parse the contents of the eclass (excluding name)
-			i->second->parseFromTokens(tokeniser);
+			entityClass->parseFromTokens(tokeniser);
 
 			// Set the mod directory
-        	i->second->setModName(modDir);
+        	entityClass->setModName(modDir);
+
+			decls.entityClasses.push_back(entityClass);
         }
         else if (blockType == "model")
 		{
 			// Read the name
 			std::string modelDefName = tokeniser.nextToken();
 
-			// Ensure that an Entity class with this name already exists
-			// When reloading entityDef declarations, most names will already be registered
-			Models::iterator i = _models.find(modelDefName);
+			Doom3ModelDefPtr model = insertParsedModel(modelDefName);
 
-			if (i == _models.end())
-			{
-				// Does not exist yet, allocate a new one
+        	model->parseFromTokens(tokeniser);
+			model->setModName(modDir);
 
-				// Allocate an empty ModelDef
-        		Doom3ModelDefPtr model(new Doom3ModelDef(modelDefName));
+			decls.models.push_back(model);
+        }
+    }
+}
 
-				std::pair<Models::iterator, bool> result = _models.insert(
-					Models::value_type(modelDefName, model)
-				);
+std::string EClassManager::writeToCache(const std::string& modDir, const ParsedDecls& decls)
+{
+	parser::DeclWriter writer;
 
-				i = result.first;
-			}
-			else
-			{
-				// Model already exists, compare the parse stamp
-				if (i->second->getParseStamp() == _curParseStamp)
-				{
-					rWarning() << "[eclassmgr]: Model "
-						<< modelDefName << " redefined" << std::endl;
-				}
-			}
+	writer.writeString(modDir);
+	writer.writeSize(decls.entityClasses.size());
 
-			// Model structure is allocated and in the map,
-            // invoke the parser routine
-			i->second->setParseStamp(_curParseStamp);
+	for (const Doom3EntityClassPtr& entityClass : decls.entityClasses)
+	{
+		writer.writeString(entityClass->getName());
+		entityClass->writeToCache(writer);
+	}
 
-        	i->second->parseFromTokens(tokeniser);
-			i->second->setModName(modDir);
-        }
-    }
+	writer.writeSize(decls.models.size());
+
+	for (const Doom3ModelDefPtr& model : decls.models)
+	{
+		writer.writeString(model->name);
+		model->writeToCache(writer);
+	}
+
+	return writer.getData();
+}
+
+void EClassManager::readFromCache(const std::string& data)
+{
+	parser::DeclReader reader(data);
+
+	std::string modDir = reader.readString();
+
+	for (std::size_t i = reader.readCount(4); i > 0; --i)
+	{
+		Doom3EntityClassPtr entityClass = insertParsedEntityClass(reader.readString());
+
+		entityClass->readFromCache(reader);
+		entityClass->setModName(modDir);
+	}
+
+	for (std::size_t i = reader.readCount(4); i > 0; --i)
+	{
+		Doom3ModelDefPtr model = insertParsedModel(reader.readString());
+
+		model->readFromCache(reader);
+		model->setModName(modDir);
+	}
 }
 
 void EClassManager::parseFile(const std::string& filename)
 {
 	const std::string fullname = "def/" + filename;
 
-	ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(fullname);
+	// The parsed classes and models are taken from the cache if the file is unchanged
+	std::string data;
+	vfs::FileStamp stamp = GlobalFileSystem().getFileStamp(fullname);
 
-	if (!file) return;
+	try
+    {
+		if (_declCache.lookup(fullname, stamp, data))
+		{
+			readFromCache(data);
+			return;
+		}
+	}
+	catch (parser::ParseException& e)
+	{
+		rWarning() << "[eclassmgr] discarding the cached defs of " << filename
+				   << " (" << e.what() << ")" << std::endl;
+	}
 
 	try
     {
-		// Parse entity defs from the file
-		parse(file->getInputStream(), file->getModName());
+		ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(fullname);
+
+		if (!file) return;
+
+		// Read the whole file into memory and tokenise it in place
+		std::istream is(&(file->getInputStream()));
+		std::string contents = parser::readStreamContents(is);
+		parser::BufferDefTokeniser tokeniser(contents);
+
+		// Parse entity defs from the tokens
+		ParsedDecls decls;
+		parse(tokeniser, file->getModName(), decls);
+
+		_declCache.store(fullname, stamp, writeToCache(file->getModName(), decls));
 	}
     catch (parser::ParseException& e)
     {
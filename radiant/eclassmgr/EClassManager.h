@@ -5,6 +5,7 @@
 #include "ifilesystem.h"
 #include "itextstream.h"
 #include "ThreadedDefLoader.h"
+#include "parser/DeclFileCache.h"
 
 #include "Doom3EntityClass.h"
 #include "Doom3ModelDef.h"
@@ -48,6 +49,16 @@ class EClassManager :
 	// definitions have been parsed
 	std::size_t _curParseStamp;
 
+	// Classes and models parsed from the def files, stored between sessions
+	parser::DeclFileCache _declCache;
+
+	// The classes and models defined by a single def file, in file order
+	struct ParsedDecls
+	{
+		std::vector<Doom3EntityClassPtr> entityClasses;
+		std::vector<Doom3ModelDefPtr> models;
+	};
+
     sigc::signal<void> _defsReloadedSignal;
 
 public:
@@ -96,8 +107,16 @@ private:
 	Doom3EntityClassPtr insertUnique(const Doom3EntityClassPtr& eclass);
     Doom3EntityClassPtr findInternal(const std::string& name);
 
-	// Parses the given inputstream for DEFs.
-	void parse(TextInputStream& inStr, const std::string& modDir);
+	// Returns the class or model of the given name, to be (re)defined in this parse pass
+	Doom3EntityClassPtr insertParsedEntityClass(const std::string& name);
+	Doom3ModelDefPtr insertParsedModel(const std::string& name);
+
+	// Parses the DEFs from the given tokeniser, adding the defined classes and models to decls
+	void parse(parser::DefTokeniser& tokeniser, const std::string& modDir, ParsedDecls& decls);
+
+	// Serialises the decls parsed from a def file for the cache, and defines them again from that record
+	static std::string writeToCache(const std::string& modDir, const ParsedDecls& decls);
+	void readFromCache(const std::string& data);
 
 	// Recursively resolves the inheritance of the model defs
 	void resolveModelInheritance(const std::string& name, const Doom3ModelDefPtr& model);
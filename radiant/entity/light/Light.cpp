@@ -739,49 +739,83 @@ bool Light::intersectsAABB(const AABB& other) const
 
     if (isProjected())
     {
-        // Update the projection, including the Frustum (we don't care about the
-        // projection matrix itself).
-        updateProjection();
-
-        // Construct a transformation with the rotation and translation of the
-        // frustum
-        Matrix4 transRot = Matrix4::getIdentity();
-        transRot.translateBy(worldOrigin());
-        transRot.multiplyBy(rotation());
-
-        // Transform the frustum with the rotate/translate matrix and test its
-        // intersection with the AABB
-		Frustum frustumTrans = _frustum.getTransformedBy(transRot);
-
-		VolumeIntersectionValue intersects = frustumTrans.testIntersection(other);
+        VolumeIntersectionValue intersects = getWorldFrustum().testIntersection(other);
 
         returnVal = intersects != VOLUME_OUTSIDE;
     }
     else
     {
         // test against an AABB which contains the rotated bounds of this light.
-        AABB bounds = localAABB();
-        bounds.origin += worldOrigin();
-
-        returnVal = other.intersects(AABB(
-            bounds.origin,
-            Vector3(
-                static_cast<float>(fabs(m_rotation[0] * bounds.extents[0])
-                                    + fabs(m_rotation[3] * bounds.extents[1])
-                                    + fabs(m_rotation[6] * bounds.extents[2])),
-                static_cast<float>(fabs(m_rotation[1] * bounds.extents[0])
-                                    + fabs(m_rotation[4] * bounds.extents[1])
-                                    + fabs(m_rotation[7] * bounds.extents[2])),
-                static_cast<float>(fabs(m_rotation[2] * bounds.extents[0])
-                                    + fabs(m_rotation[5] * bounds.extents[1])
-                                    + fabs(m_rotation[8] * bounds.extents[2]))
-            )
-        ));
+        returnVal = other.intersects(getLightAABB());
     }
 
     return returnVal;
 }
 
+Frustum Light::getWorldFrustum() const
+{
+    // Update the projection, including the Frustum (we don't care about the
+    // projection matrix itself).
+    updateProjection();
+
+    // Construct a transformation with the rotation and translation of the
+    // frustum
+    Matrix4 transRot = Matrix4::getIdentity();
+    transRot.translateBy(worldOrigin());
+    transRot.multiplyBy(rotation());
+
+    // Transform the frustum with the rotate/translate matrix
+    return _frustum.getTransformedBy(transRot);
+}
+
+AABB Light::getLightAABB() const
+{
+    if (isProjected())
+    {
+        Frustum frustum = getWorldFrustum();
+
+        // The frustum corners are the intersections of three of its planes
+        AABB bounds;
+
+        for (const Plane3* side : { &frustum.left, &frustum.right })
+        {
+            for (const Plane3* vertical : { &frustum.bottom, &frustum.top })
+            {
+                for (const Plane3* cap : { &frustum.back, &frustum.front })
+                {
+                    // A degenerate frustum has no corners, don't cull anything
+                    if (side->normal().dot(vertical->normal().crossProduct(cap->normal())) == 0)
+                    {
+                        return AABB::createInfinite();
+                    }
+
+                    bounds.includePoint(Plane3::intersect(*side, *vertical, *cap));
+                }
+            }
+        }
+
+        return bounds;
+    }
+
+    AABB bounds = localAABB();
+    bounds.origin += worldOrigin();
+
+    return AABB(
+        bounds.origin,
+        Vector3(
+            static_cast<float>(fabs(m_rotation[0] * bounds.extents[0])
+                                + fabs(m_rotation[3] * bounds.extents[1])
+                                + fabs(m_rotation[6] * bounds.extents[2])),
+            static_cast<float>(fabs(m_rotation[1] * bounds.extents[0])
+                                + fabs(m_rotation[4] * bounds.extents[1])
+                                + fabs(m_rotation[7] * bounds.extents[2])),
+            static_cast<float>(fabs(m_rotation[2] * bounds.extents[0])
+                                + fabs(m_rotation[5] * bounds.extents[1])
+                                + fabs(m_rotation[8] * bounds.extents[2]))
+        )
+    );
+}
+
 const Matrix4& Light::rotation() const {
     m_doom3Rotation = m_rotation.getMatrix4();
     return m_doom3Rotation;
@@ -257,6 +257,10 @@ public:
 
     Matrix4 getLightTextureTransformation() const;
   	bool intersectsAABB(const AABB& other) const;
+	AABB getLightAABB() const;
+
+	// The light frustum of a projected light in world space
+	Frustum getWorldFrustum() const;
 	const Matrix4& rotation() const;
 	Vector3 getLightOrigin() const;
 	const Vector3& colour() const;
@@ -499,6 +499,11 @@ bool LightNode::intersectsAABB(const AABB& aabb) const
 	return _light.intersectsAABB(aabb);
 }
 
+AABB LightNode::getLightAABB() const
+{
+	return _light.getLightAABB();
+}
+
 Vector3 LightNode::getLightOrigin() const {
 	return _light.getLightOrigin();
 }
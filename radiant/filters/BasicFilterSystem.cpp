@@ -1,10 +1,13 @@
 #include "BasicFilterSystem.h"
 
 #include <functional>
+#include <algorithm>
 
 #include "iradiant.h"
 #include "itextstream.h"
 #include "iscenegraph.h"
+#include "ientity.h"
+#include "ieclass.h"
 #include "iregistry.h"
 #include "igame.h"
 #include "ishaders.h"
@@ -41,9 +44,7 @@ void BasicFilterSystem::setAllFilterStates(bool state)
 		_activeFilters.clear();
 	}
 
-	// Invalidate the visibility cache to force new values to be
-	// loaded from the filters themselves
-	_visibilityCache.clear();
+	updateActiveMask();
 
 	// Update the scenegraph instances
 	update();
@@ -128,6 +129,8 @@ void BasicFilterSystem::initialiseModule(const ApplicationContext& ctx)
 	// user-defined filters
 	addFiltersFromXML(userFilters, false);
 
+	onFilterRulesChanged();
+
 	// Add the (de-)activate all commands
 	GlobalCommandSystem().addCommand("SetAllFilterStates", 
 		std::bind(&BasicFilterSystem::setAllFilterStatesCmd, this, std::placeholders::_1), { cmd::ARGTYPE_INT });
@@ -280,10 +283,10 @@ void BasicFilterSystem::shutdownModule()
 		}
 	}
 
-	_visibilityCache.clear();
 	_eventAdapters.clear();
 	_activeFilters.clear();
 	_availableFilters.clear();
+	onFilterRulesChanged();
 }
 
 sigc::signal<void> BasicFilterSystem::filtersChangedSignal() const
@@ -344,9 +347,8 @@ void BasicFilterSystem::setFilterState(const std::string& filter, bool state)
 		adapter->second->setFilterState(state);
 	}
 
-	// Invalidate the visibility cache to force new values to be
-	// loaded from the filters themselves
-	_visibilityCache.clear();
+	// The cached masks stay valid, only the active set has changed
+	updateActiveMask();
 
 	// Update the scenegraph instances
 	update();
@@ -397,7 +399,7 @@ bool BasicFilterSystem::addFilter(const std::string& filterName, const FilterRul
 	ensureEventAdapter(*filter);
 
 	// Clear the cache, the rules have changed
-	_visibilityCache.clear();
+	onFilterRulesChanged();
 
 	_filtersChangedSignal.emit();
 
@@ -428,7 +430,7 @@ bool BasicFilterSystem::removeFilter(const std::string& filter)
 	_availableFilters.erase(f);
 
 	// Clear the cache, the rules have changed
-	_visibilityCache.clear();
+	onFilterRulesChanged();
 
 	_filtersChangedSignal.emit();
 
@@ -501,56 +503,114 @@ bool BasicFilterSystem::renameFilter(const std::string& oldFilterName, const std
 // Query whether an item is visible or filtered out
 bool BasicFilterSystem::isVisible(const FilterRule::Type type, const std::string& name)
 {
-	// Check if this item is in the visibility cache, returning
-	// its cached value if found
-	auto cacheIter = _visibilityCache.find(name);
-	
-	if (cacheIter != _visibilityCache.end())
+	return !getItemMask(type, name).intersects(_activeMask);
+}
+
+bool BasicFilterSystem::isEntityVisible(const FilterRule::Type type, const Entity& entity)
+{
+	return !getEntityMask(type, entity).intersects(_activeMask);
+}
+
+const FilterMask& BasicFilterSystem::getItemMask(const FilterRule::Type type, const std::string& name)
+{
+	MaskCache& cache = _maskCache[type];
+
+	// Check if this item is in the cache, returning its mask if found
+	auto cacheIter = cache.find(name);
+
+	if (cacheIter != cache.end())
 	{
 		return cacheIter->second;
 	}
 
-	// Otherwise, walk the list of active filters to find a value for
-	// this item.
-	bool visFlag = true; // default if no filters modify it
+	// Otherwise ask every filter, active or not, about this item
+	FilterMask mask;
+
+	for (std::size_t i = 0; i < _maskFilters.size(); ++i)
+	{
+		if (!_maskFilters[i]->isVisible(type, name))
+		{
+			mask.set(i);
+		}
+	}
+
+	return cache.emplace(name, mask).first->second;
+}
+
+const FilterMask& BasicFilterSystem::getEntityMask(const FilterRule::Type type, const Entity& entity)
+{
+	// The cache key consists of everything the rules of this type are looking at
+	std::string key;
 
-	for (const auto& active : _activeFilters)
+	if (type == FilterRule::TYPE_ENTITYCLASS)
+	{
+		key = entity.getEntityClass()->getName();
+	}
+	else
 	{
-		// Delegate the check to the filter object. If a filter returns
-		// false for the visibility check, then the item is filtered
-		// and we don't need any more checks.
-		if (!active.second->isVisible(type, name))
+		for (const std::string& entityKey : _ruleEntityKeys)
 		{
-			visFlag = false;
-			break;
+			key += entity.getKeyValue(entityKey);
+			key += '\0';
 		}
 	}
 
-	// Cache the result and return to caller
-	_visibilityCache.emplace(name, visFlag);
+	MaskCache& cache = _maskCache[type];
+
+	auto cacheIter = cache.find(key);
 
-	return visFlag;
+	if (cacheIter != cache.end())
+	{
+		return cacheIter->second;
+	}
+
+	FilterMask mask;
+
+	for (std::size_t i = 0; i < _maskFilters.size(); ++i)
+	{
+		if (!_maskFilters[i]->isEntityVisible(type, entity))
+		{
+			mask.set(i);
+		}
+	}
+
+	return cache.emplace(key, mask).first->second;
 }
 
-bool BasicFilterSystem::isEntityVisible(const FilterRule::Type type, const Entity& entity)
+void BasicFilterSystem::onFilterRulesChanged()
 {
-	// Otherwise, walk the list of active filters to find a value for
-	// this item.
-	bool visFlag = true; // default if no filters modify it
+	_maskCache.clear();
+	_maskFilters.clear();
+	_ruleEntityKeys.clear();
 
-	for (const auto& active : _activeFilters)
+	for (const auto& pair : _availableFilters)
 	{
-		// Delegate the check to the filter object. If a filter returns
-		// false for the visibility check, then the item is filtered
-		// and we don't need any more checks.
-		if (!active.second->isEntityVisible(type, entity))
+		_maskFilters.push_back(pair.second);
+
+		for (const FilterRule& rule : pair.second->getRuleSet())
 		{
-			visFlag = false;
-			break;
+			if (rule.type == FilterRule::TYPE_ENTITYKEYVALUE &&
+				std::find(_ruleEntityKeys.begin(), _ruleEntityKeys.end(), rule.entityKey) == _ruleEntityKeys.end())
+			{
+				_ruleEntityKeys.push_back(rule.entityKey);
+			}
 		}
 	}
 
-	return visFlag;
+	updateActiveMask();
+}
+
+void BasicFilterSystem::updateActiveMask()
+{
+	_activeMask = FilterMask();
+
+	for (std::size_t i = 0; i < _maskFilters.size(); ++i)
+	{
+		if (getFilterState(_maskFilters[i]->getName()))
+		{
+			_activeMask.set(i);
+		}
+	}
 }
 
 FilterRules BasicFilterSystem::getRuleSet(const std::string& filter)
@@ -570,7 +630,7 @@ bool BasicFilterSystem::setFilterRules(const std::string& filter, const FilterRu
 		f->second->setRules(ruleSet);
 
 		// Clear the cache, the ruleset has changed
-		_visibilityCache.clear();
+		onFilterRulesChanged();
 
 		_filtersChangedSignal.emit();
 
@@ -5,12 +5,14 @@
 #include "icommandsystem.h"
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <iostream>
 
 #include "xmlutil/Node.h"
 #include "XMLFilter.h"
+#include "FilterMask.h"
 #include "XmlFilterEventAdapter.h"
 
 namespace filters
@@ -32,10 +34,23 @@ private:
 	// Second table containing just the active filters
 	FilterTable _activeFilters;
 
-	// Cache of visibility flags for item names, to avoid having to
-	// traverse the active filter list for each lookup
-	typedef std::map<std::string, bool> StringFlagCache;
-	StringFlagCache _visibilityCache;
+	// All available filters, the index is the filter's bit in the masks
+	std::vector<XMLFilter::Ptr> _maskFilters;
+
+	// The bits of the active filters
+	FilterMask _activeMask;
+
+	// Cache of the filters hiding an item, per rule type and item name, to
+	// avoid having to evaluate the filter rules for each lookup. Entities are
+	// looked up by their classname or by the values of the spawnargs used in
+	// the entitykeyvalue rules, so changing an entity leads to a different
+	// entry. The cache is only cleared when the filter rules change, toggling
+	// a filter just changes the active mask.
+	typedef std::unordered_map<std::string, FilterMask> MaskCache;
+	std::map<FilterRule::Type, MaskCache> _maskCache;
+
+	// The spawnargs checked by any of the entitykeyvalue rules
+	std::vector<std::string> _ruleEntityKeys;
 
     sigc::signal<void> _filtersChangedSignal;
 
@@ -52,6 +67,16 @@ private:
 
 	void updateEvents();
 
+	// Re-assigns the mask bits and clears the mask cache
+	void onFilterRulesChanged();
+
+	// Updates the mask bits of the active filters
+	void updateActiveMask();
+
+	// Returns the set of filters which would hide the given item
+	const FilterMask& getItemMask(const FilterRule::Type type, const std::string& name);
+	const FilterMask& getEntityMask(const FilterRule::Type type, const Entity& entity);
+
 	void addFiltersFromXML(const xml::NodeList& nodes, bool readOnly);
 
 	XmlFilterEventAdapter::Ptr ensureEventAdapter(XMLFilter& filter);
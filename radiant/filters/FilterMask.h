@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace filters
+{
+
+/**
+ * A set of filters, stored as a bitmask indexed by the filter number
+ * assigned by the filter system. Used to cache which filters are hiding
+ * an item, the item is visible if this set doesn't intersect with the
+ * set of active filters.
+ */
+class FilterMask
+{
+private:
+	std::vector<uint64_t> _bits;
+
+public:
+	void set(std::size_t index)
+	{
+		std::size_t word = index / 64;
+
+		if (word >= _bits.size())
+		{
+			_bits.resize(word + 1, 0);
+		}
+
+		_bits[word] |= uint64_t(1) << (index % 64);
+	}
+
+	bool test(std::size_t index) const
+	{
+		std::size_t word = index / 64;
+
+		return word < _bits.size() && (_bits[word] & (uint64_t(1) << (index % 64))) != 0;
+	}
+
+	// Returns true if any filter is contained in both sets
+	bool intersects(const FilterMask& other) const
+	{
+		std::size_t numWords = _bits.size() < other._bits.size() ? _bits.size() : other._bits.size();
+
+		for (std::size_t i = 0; i < numWords; ++i)
+		{
+			if ((_bits[i] & other._bits[i]) != 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+}
@@ -0,0 +1,94 @@
+#include "RuleMatcher.h"
+
+#include <cctype>
+#include "itextstream.h"
+
+namespace filters
+{
+
+namespace
+{
+	// Characters having a special meaning in ECMAScript regular expressions
+	inline bool isSpecialCharacter(char c)
+	{
+		switch (c)
+		{
+		case '^': case '$': case '\\': case '.': case '*': case '+': case '?':
+		case '(': case ')': case '[': case ']': case '{': case '}': case '|':
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
+RuleMatcher::RuleMatcher(const std::string& expression) :
+	_kind(Kind::Literal)
+{
+	// Try to reduce the expression to a literal string, optionally followed by ".*"
+	for (std::size_t i = 0; i < expression.size(); ++i)
+	{
+		char c = expression[i];
+
+		if (!isSpecialCharacter(c))
+		{
+			_literal += c;
+			continue;
+		}
+
+		// An escaped punctuation character stands for itself, "\d" and the like don't
+		if (c == '\\' && i + 1 < expression.size() && std::ispunct(static_cast<unsigned char>(expression[i + 1])))
+		{
+			_literal += expression[++i];
+			continue;
+		}
+
+		if (c == '.' && i + 2 == expression.size() && expression[i + 1] == '*')
+		{
+			_kind = Kind::Prefix;
+			break;
+		}
+
+		_kind = Kind::Regex;
+		break;
+	}
+
+	if (_kind != Kind::Regex)
+	{
+		return;
+	}
+
+	_literal.clear();
+
+	try
+	{
+		_regex = std::make_shared<std::regex>(expression);
+	}
+	catch (std::regex_error& ex)
+	{
+		rWarning() << "Invalid filter match expression " << expression << ": " << ex.what() << std::endl;
+		_kind = Kind::Invalid;
+	}
+}
+
+bool RuleMatcher::matches(const std::string& value) const
+{
+	switch (_kind)
+	{
+	case Kind::Literal:
+		return value == _literal;
+
+	case Kind::Prefix:
+		// The dot doesn't match line terminators
+		return value.compare(0, _literal.size(), _literal) == 0 &&
+			value.find_first_of("\r\n", _literal.size()) == std::string::npos;
+
+	case Kind::Regex:
+		return std::regex_match(value, *_regex);
+
+	default:
+		return false;
+	}
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <regex>
+#include <string>
+
+namespace filters
+{
+
+/**
+ * The compiled match expression of a filter rule. Expressions are
+ * regular expressions which need to match the whole string, like with
+ * std::regex_match. The common cases of plain strings ("func_static")
+ * and prefixes ("textures/common/.*") are matched without involving the
+ * regex engine, all other expressions are compiled only once.
+ */
+class RuleMatcher
+{
+private:
+	enum class Kind
+	{
+		Literal,	// the whole string equals _literal
+		Prefix,		// the string starts with _literal and contains no line break after it
+		Regex,		// std::regex_match against _regex
+		Invalid,	// the expression failed to compile, nothing matches
+	};
+
+	Kind _kind;
+
+	std::string _literal;
+
+	// Shared by copies of this matcher
+	std::shared_ptr<std::regex> _regex;
+
+public:
+	explicit RuleMatcher(const std::string& expression);
+
+	// Returns true if the given string matches the expression
+	bool matches(const std::string& value) const;
+};
+
+}
@@ -3,7 +3,6 @@
 #include "ientity.h"
 #include "ieclass.h"
 #include "ifilter.h"
-#include <regex>
 #include <algorithm>
 
 namespace filters
@@ -25,24 +24,20 @@ bool XMLFilter::isVisible(const FilterRule::Type type, const std::string& name)
 
 	bool visible = true; // default if unmodified by rules
 
-	for (FilterRules::const_iterator ruleIter = _rules.begin();
-		 ruleIter != _rules.end();
-		 ++ruleIter)
+	for (std::size_t i = 0; i < _rules.size(); ++i)
 	{
 		// Check the item type.
-		if (ruleIter->type != type)
+		if (_rules[i].type != type)
 		{
 			continue;
 		}
 
-		// If we have a rule for this item, use a regex to match the query name
-		// against the "match" parameter
-		std::regex ex(ruleIter->match);
-
-		if (std::regex_match(name, ex))
+		// If we have a rule for this item, match the query name against
+		// the compiled "match" expression
+		if (_matchers[i].matches(name))
 		{
 			// Overwrite the visible flag with the value from the rule.
-			visible = ruleIter->show;
+			visible = _rules[i].show;
 		}
 	}
 
@@ -56,31 +51,27 @@ bool XMLFilter::isEntityVisible(const FilterRule::Type type, const Entity& entit
 
 	IEntityClassConstPtr eclass = entity.getEntityClass();
 	
-	for (FilterRules::const_iterator ruleIter = _rules.begin();
-		 ruleIter != _rules.end();
-		 ++ruleIter)
+	for (std::size_t i = 0; i < _rules.size(); ++i)
 	{
-		if (ruleIter->type != type)
+		const FilterRule& rule = _rules[i];
+
+		if (rule.type != type)
 		{
 			continue;
 		}
 
 		if (type == FilterRule::TYPE_ENTITYCLASS)
 		{
-			std::regex ex(ruleIter->match);
-
-			if (std::regex_match(eclass->getName(), ex))
+			if (_matchers[i].matches(eclass->getName()))
 			{
-				visible = ruleIter->show;
+				visible = rule.show;
 			}
 		}
 		else if (type == FilterRule::TYPE_ENTITYKEYVALUE)
 		{
-			std::regex ex(ruleIter->match);
-
-			if (std::regex_match(entity.getKeyValue(ruleIter->entityKey), ex))
+			if (_matchers[i].matches(entity.getKeyValue(rule.entityKey)))
 			{
-				visible = ruleIter->show;
+				visible = rule.show;
 			}
 		}
 	}
@@ -116,6 +107,13 @@ const FilterRules& XMLFilter::getRuleSet() const
 
 void XMLFilter::setRules(const FilterRules& rules) {
 	_rules = rules;
+
+	_matchers.clear();
+
+	for (const FilterRule& rule : _rules)
+	{
+		_matchers.emplace_back(rule.match);
+	}
 }
 
 void XMLFilter::updateEventName() {
@@ -2,6 +2,7 @@
 
 #include "itextstream.h"
 #include "BasicTexture2D.h"
+#include <algorithm>
 
 TexturePtr DDSImage::bindTexture(const std::string& name) const
 {
@@ -11,6 +12,28 @@ TexturePtr DDSImage::bindTexture(const std::string& name) const
 
     // Allocate a new texture number and store it into the Texture structure
     glGenTextures(1, &textureNum);
+
+    if (!uploadTexture(textureNum, name, 0))
+    {
+        glDeleteTextures(1, &textureNum);
+        return TexturePtr();
+    }
+
+    // Create and return texture object
+    BasicTexture2DPtr texObj(new BasicTexture2D(textureNum, name));
+    texObj->setWidth(getWidth(0));
+    texObj->setHeight(getHeight(0));
+
+    return texObj;
+}
+
+bool DDSImage::uploadTexture(GLuint textureNum, const std::string& name, std::size_t firstMipLevel) const
+{
+    if (_mipMapInfo.empty()) return false;
+
+    // Keep at least the smallest mipmap, the levels are uploaded as they are
+    std::size_t firstLevel = std::min(firstMipLevel, _mipMapInfo.size() - 1);
+
     glBindTexture(GL_TEXTURE_2D, textureNum);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
@@ -18,13 +41,13 @@ TexturePtr DDSImage::bindTexture(const std::string& name) const
 
     glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
 
-    for (std::size_t i = 0; i < _mipMapInfo.size(); ++i)
+    for (std::size_t i = firstLevel; i < _mipMapInfo.size(); ++i)
     {
         const MipMapInfo& mipMap = _mipMapInfo[i];
 
         glCompressedTexImage2D(
             GL_TEXTURE_2D,
-            static_cast<GLint>(i),
+            static_cast<GLint>(i - firstLevel),
             _format,
             static_cast<GLsizei>(mipMap.width),
             static_cast<GLsizei>(mipMap.height),
@@ -40,25 +63,21 @@ TexturePtr DDSImage::bindTexture(const std::string& name) const
                       << name << "'; unsupported texture format"
                       << std::endl;
 
-            return TexturePtr();
+            glBindTexture(GL_TEXTURE_2D, 0);
+            return false;
         }
 
         debug::assertNoGlErrors();
     }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(_mipMapInfo.size() - 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(_mipMapInfo.size() - 1 - firstLevel));
 
     // Un-bind the texture
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    // Create and return texture object
-    BasicTexture2DPtr texObj(new BasicTexture2D(textureNum, name));
-    texObj->setWidth(getWidth(0));
-    texObj->setHeight(getHeight(0));
-
     debug::assertNoGlErrors();
 
-    return texObj;
+    return true;
 }
 
 void DDSImage::addMipMap(std::size_t mipWidth,
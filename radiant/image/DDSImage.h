@@ -119,6 +119,8 @@ public:
     /* BindableTexture implementation */
 	TexturePtr bindTexture(const std::string& name) const;
 
+	bool uploadTexture(GLuint textureNum, const std::string& name, std::size_t firstMipLevel) const;
+
 	bool isPrecompressed() const {
 		return true;
 	}
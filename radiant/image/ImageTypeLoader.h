@@ -1,6 +1,7 @@
 #pragma once
 
 #include "iimage.h"
+#include <list>
 
 namespace image
 {
@@ -0,0 +1,156 @@
+#include "AutoSaveWriter.h"
+
+#include <climits>
+#include <fstream>
+#include "itextstream.h"
+#include "os/file.h"
+#include "os/dir.h"
+#include "string/convert.h"
+
+namespace map
+{
+
+namespace
+{
+	const char* const TEMP_FILE_SUFFIX = ".tmp";
+
+	void removeTempFile(const fs::path& tempFile)
+	{
+		try
+		{
+			fs::remove(tempFile);
+		}
+		catch (fs::filesystem_error& ex)
+		{
+			rWarning() << "AutoSaver: could not remove " << tempFile.string() << ": " << ex.what() << std::endl;
+		}
+	}
+
+	// Writes the data to a temporary file next to the given one and renames it
+	bool writeFile(const std::string& data, const fs::path& filename)
+	{
+		fs::path tempFile = filename.string() + TEMP_FILE_SUFFIX;
+
+		{
+			// Text mode, like the regular map save
+			std::ofstream stream(tempFile.string());
+
+			if (!stream.is_open())
+			{
+				rError() << "AutoSaver: could not open " << tempFile.string() << " for writing" << std::endl;
+				return false;
+			}
+
+			stream.write(data.data(), data.size());
+			stream.close();
+
+			if (stream.fail())
+			{
+				rError() << "AutoSaver: failed to write " << tempFile.string() << std::endl;
+				removeTempFile(tempFile);
+				return false;
+			}
+		}
+
+		try
+		{
+			fs::rename(tempFile, filename);
+		}
+		catch (fs::filesystem_error& ex)
+		{
+			rError() << "AutoSaver: could not replace " << filename.string() << ": " << ex.what() << std::endl;
+			removeTempFile(tempFile);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+std::string AutoSaveWriter::constructSnapshotName(const fs::path& snapshotPath, const std::string& mapName,
+												  int num, const std::string& mapExtension)
+{
+	// Construct the base name without numbered extension
+	std::string filename = (snapshotPath / mapName).string();
+
+	// Now append the number and the map extension to the map name
+	filename += ".";
+	filename += string::to_string(num);
+	filename += ".";
+	filename += mapExtension;
+
+	return filename;
+}
+
+std::map<int, std::string> AutoSaveWriter::collectExistingSnapshots(const fs::path& snapshotPath,
+	const std::string& mapName, const std::string& mapExtension)
+{
+	std::map<int, std::string> existingSnapshots;
+
+	for (int num = 0; num < INT_MAX; num++)
+	{
+		std::string filename = constructSnapshotName(snapshotPath, mapName, num, mapExtension);
+
+		if (!os::fileOrDirExists(filename))
+		{
+			break; // We've found an unused filename, break the loop
+		}
+
+		existingSnapshots.insert(std::make_pair(num, filename));
+	}
+
+	return existingSnapshots;
+}
+
+bool AutoSaveWriter::write(const AutoSaveBuffer& buffer, const fs::path& filename, const std::string& infoFileExtension)
+{
+	if (!writeFile(buffer.mapData, filename))
+	{
+		return false;
+	}
+
+	if (buffer.hasInfoFile)
+	{
+		fs::path infoFile = filename;
+		infoFile.replace_extension(infoFileExtension);
+
+		return writeFile(buffer.infoFileData, infoFile);
+	}
+
+	return true;
+}
+
+AutoSaveWriter::SnapshotResult AutoSaveWriter::writeSnapshot(const AutoSaveBuffer& buffer, const fs::path& snapshotPath,
+	const std::string& mapName, const std::string& mapExtension, const std::string& infoFileExtension)
+{
+	SnapshotResult result;
+	result.success = false;
+	result.folderSize = 0;
+
+	// Check if the folder exists and create it if necessary
+	if (!os::fileOrDirExists(snapshotPath.string()) && !os::makeDirectory(snapshotPath.string()))
+	{
+		rError() << "Snapshot save failed.. unable to create directory " << snapshotPath.string() << std::endl;
+		return result;
+	}
+
+	std::map<int, std::string> existingSnapshots = collectExistingSnapshots(snapshotPath, mapName, mapExtension);
+
+	int highestNum = existingSnapshots.empty() ? 0 : existingSnapshots.rbegin()->first + 1;
+
+	result.filename = constructSnapshotName(snapshotPath, mapName, highestNum, mapExtension);
+
+	rMessage() << "Autosaving snapshot to " << result.filename << std::endl;
+
+	result.success = write(buffer, result.filename, infoFileExtension);
+
+	// Sum up the total folder size
+	for (const std::pair<const int, std::string>& pair : existingSnapshots)
+	{
+		result.folderSize += os::getFileSize(pair.second);
+	}
+
+	return result;
+}
+
+} // namespace map
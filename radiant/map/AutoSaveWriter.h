@@ -0,0 +1,69 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include "os/fs.h"
+
+namespace map
+{
+
+/**
+ * A map serialised into memory by the autosaver. The buffer is filled
+ * on the main thread and handed over to a worker thread for writing.
+ */
+struct AutoSaveBuffer
+{
+	std::string mapData;
+
+	// The contents of the info file, only written if hasInfoFile is set
+	std::string infoFileData;
+	bool hasInfoFile;
+
+	AutoSaveBuffer() :
+		hasInfoFile(false)
+	{}
+};
+
+/**
+ * The file side of the autosaver, writing serialised maps and managing
+ * the numbered snapshot files. None of these functions touch the scene,
+ * the registry or the UI, they can be called from any thread.
+ */
+class AutoSaveWriter
+{
+public:
+	// The outcome of a writeSnapshot() call
+	struct SnapshotResult
+	{
+		bool success;
+
+		// The path of the written snapshot file
+		std::string filename;
+
+		// The total size in bytes of the snapshots present before this one
+		std::size_t folderSize;
+	};
+
+	// Returns the name of the numbered snapshot, e.g. "<folder>/test.map.3.map"
+	static std::string constructSnapshotName(const fs::path& snapshotPath, const std::string& mapName,
+											 int num, const std::string& mapExtension);
+
+	// Maps the numbers of the existing snapshots to their paths, stopping at the first unused number
+	static std::map<int, std::string> collectExistingSnapshots(const fs::path& snapshotPath,
+		const std::string& mapName, const std::string& mapExtension);
+
+	/**
+	 * Writes the buffer to the given map file and its info file (if any), the
+	 * latter gets the given extension. The data goes to temporary files first,
+	 * which replace the target files once complete, such that an interrupted
+	 * write never leaves a truncated autosave behind. Returns false on failure.
+	 */
+	static bool write(const AutoSaveBuffer& buffer, const fs::path& filename, const std::string& infoFileExtension);
+
+	// Writes the buffer to the next free snapshot number in the given folder,
+	// which is created if necessary.
+	static SnapshotResult writeSnapshot(const AutoSaveBuffer& buffer, const fs::path& snapshotPath,
+		const std::string& mapName, const std::string& mapExtension, const std::string& infoFileExtension);
+};
+
+} // namespace map
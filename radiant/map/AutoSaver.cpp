@@ -9,6 +9,8 @@
 #include "iradiant.h"
 #include "imainframe.h"
 #include "ipreferencesystem.h"
+#include "ithread.h"
+#include "imapformat.h"
 
 #include "registry/registry.h"
 
@@ -18,10 +20,14 @@
 #include "os/fs.h"
 #include "gamelib.h"
 
-#include <limits.h>
+#include <chrono>
+#include <memory>
+#include <sstream>
 #include "string/string.h"
 #include "string/convert.h"
 #include "map/Map.h"
+#include "map/MapResource.h"
+#include "map/algorithm/Traverse.h"
 #include "modulesystem/ApplicationContextImpl.h"
 #include "modulesystem/StaticModule.h"
 #include "wxutil/dialog/MessageBox.h"
@@ -42,22 +48,6 @@ namespace
 	const char* RKEY_AUTOSAVE_MAX_SNAPSHOT_FOLDER_SIZE = "user/ui/map/maxSnapshotFolderSize";
 	const char* RKEY_AUTOSAVE_SNAPSHOT_FOLDER_SIZE_HISTORY = "user/ui/map/snapshotFolderSizeHistory";
 	const char* GKEY_MAP_EXTENSION = "/mapFormat/fileExtension";
-
-	std::string constructSnapshotName(const fs::path& snapshotPath, const std::string& mapName, int num)
-	{
-		std::string mapExt = game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
-
-		// Construct the base name without numbered extension
-		std::string filename = (snapshotPath / mapName).string();
-
-		// Now append the number and the map extension to the map name
-		filename += ".";
-		filename += string::to_string(num);
-		filename += ".";
-		filename += mapExt;
-
-		return filename;
-	}
 }
 
 AutoMapSaver::AutoMapSaver() :
@@ -107,6 +97,53 @@ void AutoMapSaver::stopTimer()
 	_timer->Stop();
 }
 
+bool AutoMapSaver::serialiseMap(AutoSaveBuffer& buffer, const std::string& filename)
+{
+	MapFormatPtr format = GlobalMapFormatManager().getMapFormatForFilename(filename);
+
+	if (!format || !GlobalSceneGraph().root())
+	{
+		rError() << "AutoSaver: cannot export the map to " << filename << std::endl;
+		return false;
+	}
+
+	// This is the only part of the autosave blocking the main thread
+	auto start = std::chrono::steady_clock::now();
+
+	std::ostringstream mapStream;
+	std::ostringstream auxStream;
+
+	buffer.hasInfoFile = format->allowInfoFileCreation();
+
+	MapResource::exportToStreams(*format, GlobalSceneGraph().root(), map::traverse,
+		mapStream, buffer.hasInfoFile ? &auxStream : nullptr);
+
+	buffer.mapData = mapStream.str();
+	buffer.infoFileData = auxStream.str();
+
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+	rMessage() << "AutoSaver: serialised the map in " << duration.count() << " ms, writing " <<
+		(buffer.mapData.size() + buffer.infoFileData.size()) << " bytes in the background" << std::endl;
+
+	return true;
+}
+
+bool AutoMapSaver::writeInProgress() const
+{
+	return _pendingWrite.valid() &&
+		_pendingWrite.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void AutoMapSaver::waitForPendingWrite()
+{
+	if (_pendingWrite.valid())
+	{
+		_pendingWrite.wait();
+		_pendingWrite = std::shared_future<void>();
+	}
+}
+
 void AutoMapSaver::saveSnapshot() 
 {
 	// Original GtkRadiant comments:
@@ -114,6 +151,7 @@ void AutoMapSaver::saveSnapshot()
 	// 1. make sure the snapshot directory exists (create it if it doesn't)
 	// 2. find out what the lastest save is based on number
 	// 3. inc that and save the map
+	// The numbering and writing is done on a worker thread
 
 	// Construct the fs::path class out of the full map path (throws on fail)
 	fs::path fullPath = GlobalMap().getMapName();
@@ -125,35 +163,58 @@ void AutoMapSaver::saveSnapshot()
 
 	// Retrieve the mapname
 	std::string mapName = fullPath.filename().string();
+	std::string mapExtension = game::current::getValue<std::string>(GKEY_MAP_EXTENSION);
+	std::string infoFileExtension = MapResource::getInfoFileExtension();
 
-	// Map existing snapshots (snapshot num => path)
-	std::map<int, std::string> existingSnapshots;
+	auto buffer = std::make_shared<AutoSaveBuffer>();
 
-	// Check if the folder exists and create it if necessary
-	if (os::fileOrDirExists(snapshotPath.string()) || os::makeDirectory(snapshotPath.string()))
+	// Snapshots are written in the format of the map file
+	if (!serialiseMap(*buffer, fullPath.string()))
 	{
-		collectExistingSnapshots(existingSnapshots, snapshotPath, mapName);
+		return;
+	}
 
-		int highestNum = existingSnapshots.empty() ? 0 : existingSnapshots.rbegin()->first + 1;
+	_pendingWrite = GlobalRadiant().getThreadManager().getTaskScheduler().submit<void>([=]()
+	{
+		AutoSaveWriter::SnapshotResult result;
 
-		std::string filename = constructSnapshotName(snapshotPath, mapName, highestNum);
+		try
+		{
+			result = AutoSaveWriter::writeSnapshot(*buffer, snapshotPath, mapName, mapExtension, infoFileExtension);
+		}
+		catch (fs::filesystem_error& f)
+		{
+			rError() << "AutoSaver::saveSnapshot: " << f.what() << std::endl;
+			return;
+		}
 
-		rMessage() << "Autosaving snapshot to " << filename << std::endl;
+		// The registry and the UI are only accessed on the main thread
+		CallAfter([=]()
+		{
+			handleSnapshotSizeLimit(result.folderSize, snapshotPath, mapName);
+		});
+	});
+}
 
-		// Dump to map to the next available filename
-		GlobalMap().saveDirect(filename);
+void AutoMapSaver::saveToFile(const std::string& filename)
+{
+	auto buffer = std::make_shared<AutoSaveBuffer>();
 
-		handleSnapshotSizeLimit(existingSnapshots, snapshotPath, mapName);
-	}
-	else 
+	if (!serialiseMap(*buffer, filename))
 	{
-		rError() << "Snapshot save failed.. unable to create directory";
-		rError() << snapshotPath << std::endl;
+		return;
 	}
+
+	std::string infoFileExtension = MapResource::getInfoFileExtension();
+
+	_pendingWrite = GlobalRadiant().getThreadManager().getTaskScheduler().submit<void>([=]()
+	{
+		AutoSaveWriter::write(*buffer, filename, infoFileExtension);
+	});
 }
 
-void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& existingSnapshots, 
-	const fs::path& snapshotPath, const std::string& mapName)
+void AutoMapSaver::handleSnapshotSizeLimit(std::size_t folderSize, const fs::path& snapshotPath,
+	const std::string& mapName)
 {
 	std::size_t maxSnapshotFolderSize =
 		registry::getValue<std::size_t>(RKEY_AUTOSAVE_MAX_SNAPSHOT_FOLDER_SIZE);
@@ -164,14 +225,6 @@ void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& exi
 		maxSnapshotFolderSize = 100;
 	}
 
-	// Sum up the total folder size
-	std::size_t folderSize = 0;
-
-	for (const std::pair<int, std::string>& pair : existingSnapshots)
-	{
-		folderSize += os::getFileSize(pair.second);
-	}
-
 	std::size_t maxSize = maxSnapshotFolderSize * 1024 * 1024;
 
 	// The key containing the previously calculated size
@@ -212,23 +265,6 @@ void AutoMapSaver::handleSnapshotSizeLimit(const std::map<int, std::string>& exi
 	}
 }
 
-void AutoMapSaver::collectExistingSnapshots(std::map<int, std::string>& existingSnapshots, 
-	const fs::path& snapshotPath, const std::string& mapName)
-{
-	for (int num = 0; num < INT_MAX; num++)
-	{
-		// Construct the base name without numbered extension
-		std::string filename = constructSnapshotName(snapshotPath, mapName, num);
-
-		if (!os::fileOrDirExists(filename))
-		{
-			return; // We've found an unused filename, break the loop
-		}
-
-		existingSnapshots.insert(std::make_pair(num, filename));
-	}
-}
-
 void AutoMapSaver::checkSave()
 {
 	if (!GlobalMainFrame().screenUpdatesEnabled())
@@ -253,6 +289,13 @@ void AutoMapSaver::checkSave()
 		return;
 	}
 
+	// Don't start another save while the previous files are still being written
+	if (writeInProgress())
+	{
+		rMessage() << "AutoSaver: previous autosave still being written, will wait for another period." << std::endl;
+		return;
+	}
+
 	// Check if the user is currently pressing a mouse button
 	// Don't start the save if the user is holding a mouse button
 	if (wxGetMouseState().ButtonIsDown(wxMOUSE_BTN_ANY)) 
@@ -295,8 +338,7 @@ void AutoMapSaver::checkSave()
 
 				rMessage() << "Autosaving unnamed map to " << autoSaveFilename << std::endl;
 
-				// Invoke the save call
-				GlobalMap().saveDirect(autoSaveFilename);
+				saveToFile(autoSaveFilename);
 			}
 			else
 			{
@@ -311,8 +353,7 @@ void AutoMapSaver::checkSave()
 
 				rMessage() << "Autosaving map to " << filename << std::endl;
 
-				// Invoke the save call
-				GlobalMap().saveDirect(filename);
+				saveToFile(filename);
 			}
 		}
 	}
@@ -374,6 +415,7 @@ const StringSet& AutoMapSaver::getDependencies() const
 	if (_dependencies.empty())
 	{
 		_dependencies.insert(MODULE_MAP);
+		_dependencies.insert(MODULE_MAPFORMATMANAGER);
 		_dependencies.insert(MODULE_PREFERENCESYSTEM);
 		_dependencies.insert(MODULE_XMLREGISTRY);
 		_dependencies.insert(MODULE_MAINFRAME);
@@ -425,6 +467,9 @@ void AutoMapSaver::shutdownModule()
 	_enabled = false;
 	stopTimer();
 
+	// Let the last autosave finish writing its files
+	waitForPendingWrite();
+
 	// Destroy the timer
 	_timer.reset();
 }
@@ -7,13 +7,18 @@
 #include "imap.h"
 
 #include <vector>
+#include <future>
 #include <sigc++/connection.h>
 #include <wx/timer.h>
 #include <wx/sharedptr.h>
 #include "os/fs.h"
+#include "AutoSaveWriter.h"
 
 /* greebo: The AutoMapSaver class lets itself being called in distinct intervals
  * and saves the map files either to snapshots or to a single yyyy.autosave.map file.
+ *
+ * The map is serialised into memory on the main thread, writing the files
+ * and maintaining the snapshot folder is done on a worker thread.
  */
 
 namespace map
@@ -39,6 +44,9 @@ class AutoMapSaver :
 
 	std::vector<sigc::connection> _signalConnections;
 
+	// The background write started by the last autosave, if any
+	std::shared_future<void> _pendingWrite;
+
 public:
 	// Constructor
 	AutoMapSaver();
@@ -73,14 +81,20 @@ private:
 	// Saves a snapshot of the currently active map (only named maps)
 	void saveSnapshot();
 
+	// Saves the map to the given file, overwriting any previous autosave
+	void saveToFile(const std::string& filename);
+
+	// Serialises the current map into the buffer, using the format matching the filename
+	bool serialiseMap(AutoSaveBuffer& buffer, const std::string& filename);
+
+	// True while the files of the previous autosave are still being written
+	bool writeInProgress() const;
+	void waitForPendingWrite();
+
 	// This gets called when the interval time is over
 	void onIntervalReached(wxTimerEvent& ev);
 
-	void collectExistingSnapshots(std::map<int, std::string>& existingSnapshots,
-		const fs::path& snapshotPath, const std::string& mapName);
-
-	void handleSnapshotSizeLimit(const std::map<int, std::string>& existingSnapshots,
-		const fs::path& snapshotPath, const std::string& mapName);
+	void handleSnapshotSizeLimit(std::size_t folderSize, const fs::path& snapshotPath, const std::string& mapName);
 
 }; // class AutoMapSaver
 
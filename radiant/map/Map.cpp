@@ -14,6 +14,7 @@
 #include "ifilter.h"
 #include "icounter.h"
 #include "iradiant.h"
+#include "ithread.h"
 #include "imainframe.h"
 #include "imapresource.h"
 #include "imapinfofile.h"
@@ -31,6 +32,7 @@
 #include "wxutil/ScopeTimer.h"
 
 #include "brush/BrushModule.h"
+#include "brush/Brush.h"
 #include "xyview/GlobalXYWnd.h"
 #include "camera/GlobalCamera.h"
 #include "scene/BasicRootNode.h"
@@ -98,6 +100,26 @@ void Map::loadMapResourceFromPath(const std::string& path)
         setMapName(_(MAP_UNNAMED_STRING));
     }
 
+    // Build the brush geometry of the whole map in one batch, before
+    // the nodes are asking for their bounds one by one during insertion
+    {
+        std::vector<Brush*> brushes;
+
+        _resource->getNode()->foreachNode([&](const scene::INodePtr& node)
+        {
+            Brush* brush = Node_getBrush(node);
+
+            if (brush != nullptr)
+            {
+                brushes.push_back(brush);
+            }
+
+            return true;
+        });
+
+        Brush::evaluateBReps(brushes, GlobalRadiant().getThreadManager().getTaskScheduler());
+    }
+
     // Take the new node and insert it as map root
     GlobalSceneGraph().setRoot(_resource->getNode());
 
@@ -90,6 +90,11 @@ MapResource::MapResource(const std::string& name) :
     _path = rootPath(_originalName);
 	_name = os::getRelativePath(_originalName, _path);
 
+	getInfoFileExtension();
+}
+
+const std::string& MapResource::getInfoFileExtension()
+{
 	if (_infoFileExt.empty())
 	{
 		_infoFileExt = game::current::getValue<std::string>(GKEY_INFO_FILE_EXTENSION);
@@ -99,6 +104,8 @@ MapResource::MapResource(const std::string& name) :
 	{
 		_infoFileExt = "." + _infoFileExt;
 	}
+
+	return _infoFileExt;
 }
 
 void MapResource::rename(const std::string& fullPath)
@@ -510,7 +517,7 @@ bool MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 	// Actual output file paths
 	fs::path outFile = filename;
 	fs::path auxFile = outFile;
-	auxFile.replace_extension(_infoFileExt);
+	auxFile.replace_extension(getInfoFileExtension());
 
 	// Check writeability of the primary output file
 	if (!checkIsWriteable(outFile)) return false;
@@ -538,34 +545,15 @@ bool MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 	{
 		rMessage() << "success" << std::endl;
 
-		// Check the total count of nodes to traverse
-		NodeCounter counter;
-		traverse(root, counter);
-		
-		// Acquire the MapWriter from the MapFormat class
-		IMapWriterPtr mapWriter = format.getMapWriter();
-
-		// Create our main MapExporter walker, and pass the desired 
-		// writer to it. The constructor will prepare the scene
-		// and the destructor will clean it up afterwards. That way
-		// we ensure a nice and tidy scene when exceptions are thrown.
-		MapExporterPtr exporter;
-		
-		if (format.allowInfoFileCreation())
-		{
-			exporter.reset(new MapExporter(*mapWriter, root, *outFileStream, *auxFileStream, counter.getCount()));
-		}
-		else
-		{
-			exporter.reset(new MapExporter(*mapWriter, root, *outFileStream, counter.getCount())); // no aux stream
-		}
-
 		bool cancelled = false;
 
 		try
 		{
-			// Pass the traversal function and the root of the subgraph to export
-			exporter->exportMap(root, traverse);
+			// Check the total count of nodes to traverse
+			NodeCounter counter;
+			traverse(root, counter);
+
+			exportToStreams(format, root, traverse, *outFileStream, auxFileStream.get(), counter.getCount());
 		}
 		catch (wxutil::ModalProgressDialog::OperationAbortedException&)
 		{
@@ -574,8 +562,6 @@ bool MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 			cancelled = true;
 		}
 
-		exporter.reset();
-
 		outFileStream->close();
 
 		if (auxFileStream)
@@ -594,4 +580,30 @@ bool MapResource::saveFile(const MapFormat& format, const scene::IMapRootNodePtr
 	}
 }
 
+void MapResource::exportToStreams(const MapFormat& format, const scene::IMapRootNodePtr& root,
+								  const GraphTraversalFunc& traverse, std::ostream& mapStream,
+								  std::ostream* auxStream, std::size_t nodeCount)
+{
+	// Acquire the MapWriter from the MapFormat class
+	IMapWriterPtr mapWriter = format.getMapWriter();
+
+	// Create our main MapExporter walker, and pass the desired 
+	// writer to it. The constructor will prepare the scene
+	// and the destructor will clean it up afterwards. That way
+	// we ensure a nice and tidy scene when exceptions are thrown.
+	MapExporterPtr exporter;
+
+	if (auxStream != nullptr)
+	{
+		exporter.reset(new MapExporter(*mapWriter, root, mapStream, *auxStream, nodeCount));
+	}
+	else
+	{
+		exporter.reset(new MapExporter(*mapWriter, root, mapStream, nodeCount)); // no aux stream
+	}
+
+	// Pass the traversal function and the root of the subgraph to export
+	exporter->exportMap(root, traverse);
+}
+
 } // namespace map
@@ -46,6 +46,15 @@ public:
 	static bool saveFile(const MapFormat& format, const scene::IMapRootNodePtr& root,
 						 const GraphTraversalFunc& traverse, const std::string& filename);
 
+	// Serialise the map contents into the given streams, the info file is only written
+	// if an aux stream is passed. The progress dialog is shown if nodeCount is non-zero.
+	static void exportToStreams(const MapFormat& format, const scene::IMapRootNodePtr& root,
+								const GraphTraversalFunc& traverse, std::ostream& mapStream,
+								std::ostream* auxStream, std::size_t nodeCount = 0);
+
+	// The file extension of the auxiliary info file, including the leading dot
+	static const std::string& getInfoFileExtension();
+
 private:
 	void mapSave();
 	void onMapChanged();
@@ -10,6 +10,8 @@
 #include "imap.h"
 #include "igroupnode.h"
 #include "imainframe.h"
+#include "iradiant.h"
+#include "ithread.h"
 #include "../../brush/Brush.h"
 
 #include "registry/registry.h"
@@ -29,6 +31,7 @@ namespace map
 MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root, std::ostream& mapStream, std::size_t nodeCount) :
 	_writer(writer),
 	_mapStream(mapStream),
+	_nodeWriter(writer, mapStream, &GlobalRadiant().getThreadManager().getTaskScheduler()),
 	_root(root),
 	_dialogEventLimiter(registry::getValue<int>(RKEY_MAP_SAVE_STATUS_INTERLEAVE)),
 	_totalNodeCount(nodeCount),
@@ -43,6 +46,7 @@ MapExporter::MapExporter(IMapWriter& writer, const scene::IMapRootNodePtr& root,
 				std::ostream& mapStream, std::ostream& auxStream, std::size_t nodeCount) :
 	_writer(writer),
 	_mapStream(mapStream),
+	_nodeWriter(writer, mapStream, &GlobalRadiant().getThreadManager().getTaskScheduler()),
 	_infoFileExporter(new InfoFileExporter(auxStream)),
 	_root(root),
 	_dialogEventLimiter(registry::getValue<int>(RKEY_MAP_SAVE_STATUS_INTERLEAVE)),
@@ -108,9 +112,15 @@ void MapExporter::exportMap(const scene::INodePtr& root, const GraphTraversalFun
 		rError() << "Failure exporting a node (pre): " << ex.what() << std::endl;
 	}
 
-	// Perform the actual map traversal
+	// Perform the actual map traversal, this is queueing the nodes
 	traverse(root, *this);
 
+	// Serialise the queued nodes and write them to the stream
+	_nodeWriter.flush([this](std::size_t numNodes)
+	{
+		onNodeProgress(numNodes);
+	});
+
 	try
 	{
 		auto mapRoot = std::dynamic_pointer_cast<scene::IMapRootNode>(root);
@@ -147,53 +157,37 @@ void MapExporter::disableProgressDialog()
 
 bool MapExporter::pre(const scene::INodePtr& node)
 {
-	try
-	{
-		auto entity = std::dynamic_pointer_cast<IEntityNode>(node);
+	auto entity = std::dynamic_pointer_cast<IEntityNode>(node);
 
-		if (entity)
-		{
-			// Progress dialog handling
-			onNodeProgress();
-			
-			_writer.beginWriteEntity(entity, _mapStream);
-
-			if (_infoFileExporter) _infoFileExporter->visitEntity(node, _entityNum);
-
-			return true;
-		}
+	if (entity)
+	{
+		_nodeWriter.beginWriteEntity(entity);
 
-		auto brush = std::dynamic_pointer_cast<IBrushNode>(node);
+		if (_infoFileExporter) _infoFileExporter->visitEntity(node, _entityNum);
 
-		if (brush && brush->getIBrush().hasContributingFaces())
-		{
-			// Progress dialog handling
-			onNodeProgress();
+		return true;
+	}
 
-			_writer.beginWriteBrush(brush, _mapStream);
+	auto brush = std::dynamic_pointer_cast<IBrushNode>(node);
 
-			if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
+	if (brush && brush->getIBrush().hasContributingFaces())
+	{
+		_nodeWriter.beginWriteBrush(brush);
 
-			return true;
-		}
+		if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
 
-		auto patch = std::dynamic_pointer_cast<IPatchNode>(node);
+		return true;
+	}
 
-		if (patch)
-		{
-			// Progress dialog handling
-			onNodeProgress();
+	auto patch = std::dynamic_pointer_cast<IPatchNode>(node);
 
-			_writer.beginWritePatch(patch, _mapStream);
+	if (patch)
+	{
+		_nodeWriter.beginWritePatch(patch);
 
-			if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
+		if (_infoFileExporter) _infoFileExporter->visitPrimitive(node, _entityNum, _primitiveNum);
 
-			return true;
-		}
-	}
-	catch (IMapWriter::FailureException& ex)
-	{
-		rError() << "Failure exporting a node (pre): " << ex.what() << std::endl;
+		return true;
 	}
 
 	return true; // full traversal
@@ -201,45 +195,38 @@ bool MapExporter::pre(const scene::INodePtr& node)
 
 void MapExporter::post(const scene::INodePtr& node)
 {
-	try
-	{
-		auto entity = std::dynamic_pointer_cast<IEntityNode>(node);
+	auto entity = std::dynamic_pointer_cast<IEntityNode>(node);
 
-		if (entity)
-		{
-			_writer.endWriteEntity(entity, _mapStream);
+	if (entity)
+	{
+		_nodeWriter.endWriteEntity(entity);
 
-			_entityNum++;
-			return;
-		}
+		_entityNum++;
+		return;
+	}
 
-		auto brush = std::dynamic_pointer_cast<IBrushNode>(node);
+	auto brush = std::dynamic_pointer_cast<IBrushNode>(node);
 
-		if (brush && brush->getIBrush().hasContributingFaces())
-		{
-			_writer.endWriteBrush(brush, _mapStream);
-			_primitiveNum++;
-			return;
-		}
+	if (brush && brush->getIBrush().hasContributingFaces())
+	{
+		_nodeWriter.endWriteBrush(brush);
+		_primitiveNum++;
+		return;
+	}
 
-		auto patch = std::dynamic_pointer_cast<IPatchNode>(node);
+	auto patch = std::dynamic_pointer_cast<IPatchNode>(node);
 
-		if (patch)
-		{
-			_writer.endWritePatch(patch, _mapStream);
-			_primitiveNum++;
-			return;
-		}
-	}
-	catch (IMapWriter::FailureException& ex)
+	if (patch)
 	{
-		rError() << "Failure exporting a node (post): " << ex.what() << std::endl;
+		_nodeWriter.endWritePatch(patch);
+		_primitiveNum++;
+		return;
 	}
 }
 
-void MapExporter::onNodeProgress()
+void MapExporter::onNodeProgress(std::size_t numNodes)
 {
-	_curNodeCount++;
+	_curNodeCount += numNodes;
 
 	// Update the dialog text. This will throw an exception if the cancel
 	// button is clicked, which we must catch and handle.
@@ -277,17 +264,22 @@ void MapExporter::finishScene()
 
 void MapExporter::recalculateBrushWindings()
 {
-	_root->foreachNode([] (const scene::INodePtr& child)->bool
+	std::vector<Brush*> brushes;
+
+	_root->foreachNode([&] (const scene::INodePtr& child)->bool
 	{
 		Brush* brush = Node_getBrush(child);
 
 		if (brush != NULL)
 		{
-			brush->evaluateBRep();
+			brushes.push_back(brush);
 		}
 
 		return true;
 	});
+
+	// Clip the windings of all brushes in parallel
+	Brush::evaluateBReps(brushes, GlobalRadiant().getThreadManager().getTaskScheduler());
 }
 
 } // namespace
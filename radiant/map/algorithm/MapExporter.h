@@ -7,6 +7,7 @@
 
 #include "wxutil/ModalProgressDialog.h"
 #include "../infofile/InfoFileExporter.h"
+#include "../format/ParallelMapWriter.h"
 #include "EventRateLimiter.h"
 
 #include <sigc++/signal.h>
@@ -21,8 +22,11 @@ namespace map
  * to dispatch various calls like beginWriteEntity(), 
  * beginMap(), endWriteBrush() during scene traversal etc.
  *
+ * The visited nodes are queued in a ParallelMapWriter, which serialises
+ * them after the traversal.
+ *
  * If the progress dialog is enabled (i.e. nodeCount > 0 in constructor)
- * a gtkutil::OperationAbortedException& might be thrown during traversal, 
+ * a gtkutil::OperationAbortedException& might be thrown during export, 
  * the calling code needs to be able to handle that.
  */
 class MapExporter :
@@ -35,6 +39,9 @@ private:
 	// The stream we're writing to
 	std::ostream& _mapStream;
 
+	// Queues the visited nodes, these are serialised after the traversal
+	ParallelMapWriter _nodeWriter;
+
 	// Optional info file exporter (is NULL if no info file should be written)
 	InfoFileExporterPtr _infoFileExporter;
 
@@ -81,7 +88,7 @@ private:
 	// Common code shared by the constructors
 	void construct();
 
-	void onNodeProgress();
+	void onNodeProgress(std::size_t numNodes);
 
 	// Is called before exporting the scene to prepare func_* groups.
 	void prepareScene();
@@ -8,6 +8,7 @@
 #include "igame.h"
 #include "iregistry.h"
 #include "igroupnode.h"
+#include "ipreferencesystem.h"
 
 #include "parser/DefTokeniser.h"
 
@@ -40,6 +41,7 @@ const StringSet& Doom3MapFormat::getDependencies() const
 		_dependencies.insert(MODULE_PATCHDEF3);
 		_dependencies.insert(MODULE_XMLREGISTRY);
 		_dependencies.insert(MODULE_MAPFORMATMANAGER);
+		_dependencies.insert(MODULE_PREFERENCESYSTEM);
 	}
 
 	return _dependencies;
@@ -52,6 +54,9 @@ void Doom3MapFormat::initialiseModule(const ApplicationContext& ctx)
 	// Register ourselves as map format for maps and regions
 	GlobalMapFormatManager().registerMapFormat("map", shared_from_this());
 	GlobalMapFormatManager().registerMapFormat("reg", shared_from_this());
+
+	IPreferencePage& page = GlobalPreferenceSystem().getPage(_("Settings/Map Files"));
+	page.appendCheckBox(_("Parse map files using multiple threads"), RKEY_MAP_LOAD_PARALLEL);
 }
 
 void Doom3MapFormat::shutdownModule()
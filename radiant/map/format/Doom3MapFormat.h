@@ -8,6 +8,9 @@ namespace map
 namespace
 {
 	const float MAP_VERSION_D3 = 2;
+
+	// Tokenise the entities on worker threads when loading maps
+	const char* const RKEY_MAP_LOAD_PARALLEL = "user/ui/map/parallelLoading";
 }
 
 class Doom3MapFormat :
@@ -1,12 +1,16 @@
 #include "Doom3MapReader.h"
 
 #include "itextstream.h"
+#include "iradiant.h"
+#include "ithread.h"
 #include "ieclass.h"
 #include "igame.h"
 #include "ientity.h"
 #include "string/string.h"
+#include "registry/registry.h"
 
 #include "Doom3MapFormat.h"
+#include "ParallelMapTokeniser.h"
 
 #include "i18n.h"
 #include <fmt/format.h>
@@ -29,6 +33,20 @@ void Doom3MapReader::readFromStream(std::istream& stream)
 	// Call the virtual method to initialise the primitve parser map (if not done yet)
 	initPrimitiveParsers();
 
+	if (registry::getValue<bool>(RKEY_MAP_LOAD_PARALLEL))
+	{
+		readFromStreamParallel(stream, GlobalRadiant().getThreadManager().getTaskScheduler());
+	}
+	else
+	{
+		readFromStreamSerial(stream);
+	}
+
+	// EOF reached, success
+}
+
+void Doom3MapReader::readFromStreamSerial(std::istream& stream)
+{
 	// The tokeniser used to split the stream into pieces
 	parser::BasicDefTokeniser<std::istream> tok(stream);
 
@@ -38,24 +56,61 @@ void Doom3MapReader::readFromStream(std::istream& stream)
 	// Read each entity in the map, until EOF is reached
 	while (tok.hasMoreTokens())
 	{
-		// Create an entity node by parsing from the stream. If there is an
-		// exception, display it and return
-		try
+		parseEntityAndCount(tok);
+	}
+}
+
+void Doom3MapReader::readFromStreamParallel(std::istream& stream, TaskScheduler& scheduler)
+{
+	// Phase one: split the map text into entity blocks, which are
+	// tokenised on worker threads in the background
+	ParallelMapTokeniser blocks(stream, scheduler);
+
+	// The whole stream has been consumed, clear the EOF state such that
+	// the import filter can still query the stream position
+	stream.clear();
+
+	parser::DefTokeniser& header = blocks.getHeaderTokeniser();
+
+	// Try to parse the map version (throws on failure)
+	parseMapVersion(header);
+
+	// Anything left after the version is handed to the entity parser,
+	// just like the serial reader would do
+	while (header.hasMoreTokens())
+	{
+		parseEntityAndCount(header);
+	}
+
+	// Phase two: create the nodes on this thread, in file order
+	while (blocks.hasMoreBlocks())
+	{
+		parser::DefTokeniser& tok = blocks.nextBlock();
+
+		while (tok.hasMoreTokens())
 		{
-			parseEntity(tok);
+			parseEntityAndCount(tok);
 		}
-		catch (FailureException& e)
-		{
-			std::string text = fmt::format(_("Failed parsing entity {0:d}:\n{1}"), _entityCount, e.what());
+	}
+}
 
-			// Re-throw with more text
-			throw FailureException(text);
-		}
+void Doom3MapReader::parseEntityAndCount(parser::DefTokeniser& tok)
+{
+	// Create an entity node by parsing from the stream. If there is an
+	// exception, display it and return
+	try
+	{
+		parseEntity(tok);
+	}
+	catch (FailureException& e)
+	{
+		std::string text = fmt::format(_("Failed parsing entity {0:d}:\n{1}"), _entityCount, e.what());
 
-		_entityCount++;
+		// Re-throw with more text
+		throw FailureException(text);
 	}
 
-	// EOF reached, success
+	_entityCount++;
 }
 
 void Doom3MapReader::initPrimitiveParsers()
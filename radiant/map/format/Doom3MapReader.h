@@ -4,6 +4,7 @@
 #include <map>
 #include "inode.h"
 #include "imapformat.h"
+#include "ithread.h"
 #include "parser/DefTokeniser.h"
 
 namespace map {
@@ -34,6 +35,17 @@ public:
 	virtual void readFromStream(std::istream& stream);
 
 protected:
+	// Reads the stream using a single tokeniser on the calling thread
+	void readFromStreamSerial(std::istream& stream);
+
+	// Tokenises the entity blocks on the workers of the given scheduler,
+	// the nodes are still created on the calling thread in file order
+	void readFromStreamParallel(std::istream& stream, TaskScheduler& scheduler);
+
+	// Parses the next entity and increases the entity counter, prepends
+	// the entity number to any FailureException message
+	void parseEntityAndCount(parser::DefTokeniser& tok);
+
 	// Set up our set of primitive parsers
 	virtual void initPrimitiveParsers();
 
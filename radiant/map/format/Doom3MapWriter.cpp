@@ -19,7 +19,7 @@ Doom3MapWriter::Doom3MapWriter() :
 void Doom3MapWriter::beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
 {
 	// Write the version tag
-    stream << "Version " << MAP_VERSION_D3 << std::endl;
+    stream << "Version " << MAP_VERSION_D3 << "\n";
 }
 
 void Doom3MapWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream)
@@ -30,10 +30,10 @@ void Doom3MapWriter::endWriteMap(const scene::IMapRootNodePtr& root, std::ostrea
 void Doom3MapWriter::beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
 {
 	// Write out the entity number comment
-	stream << "// entity " << _entityCount++ << std::endl;
+	stream << "// entity " << _entityCount++ << "\n";
 
 	// Entity opening brace
-	stream << "{" << std::endl;
+	stream << "{\n";
 
 	// Entity key values
 	writeEntityKeyValues(entity, stream);
@@ -44,14 +44,14 @@ void Doom3MapWriter::writeEntityKeyValues(const IEntityNodePtr& entity, std::ost
 	// Export the entity key values
     entity->getEntity().forEachKeyValue([&](const std::string& key, const std::string& value)
     {
-        stream << "\"" << key << "\" \"" << value << "\"" << std::endl;
+        stream << "\"" << key << "\" \"" << value << "\"\n";
     });
 }
 
 void Doom3MapWriter::endWriteEntity(const IEntityNodePtr& entity, std::ostream& stream)
 {
 	// Write the closing brace for the entity
-	stream << "}" << std::endl;
+	stream << "}\n";
 
 	// Reset the primitive count again
 	_primitiveCount = 0;
@@ -60,7 +60,7 @@ void Doom3MapWriter::endWriteEntity(const IEntityNodePtr& entity, std::ostream&
 void Doom3MapWriter::beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream)
 {
 	// Primitive count comment
-	stream << "// primitive " << _primitiveCount++ << std::endl;
+	stream << "// primitive " << _primitiveCount++ << "\n";
 
 	// Export brushDef3 definition to stream
 	BrushDef3Exporter::exportBrush(stream, brush);
@@ -74,7 +74,7 @@ void Doom3MapWriter::endWriteBrush(const IBrushNodePtr& brush, std::ostream& str
 void Doom3MapWriter::beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream)
 {
 	// Primitive count comment
-	stream << "// primitive " << _primitiveCount++ << std::endl;
+	stream << "// primitive " << _primitiveCount++ << "\n";
 
 	// Export patch here _mapStream
 	PatchDefExporter::exportPatch(stream, patch);
@@ -85,4 +85,10 @@ void Doom3MapWriter::endWritePatch(const IPatchNodePtr& patch, std::ostream& str
 	// nothing
 }
 
+IMapWriterPtr Doom3MapWriter::createPartWriter(std::size_t entityCount, std::size_t primitiveCount)
+{
+	// The counters are the only state of this writer
+	return createPartWriterOfType<Doom3MapWriter>(entityCount, primitiveCount);
+}
+
 } // namespace
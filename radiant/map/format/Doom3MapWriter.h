@@ -36,8 +36,22 @@ public:
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 	virtual void endWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override;
 
+	virtual IMapWriterPtr createPartWriter(std::size_t entityCount, std::size_t primitiveCount) override;
+
 protected:
 	void writeEntityKeyValues(const IEntityNodePtr& entity, std::ostream& stream);
+
+	// Creates a writer of the given subclass, continuing at the given counters
+	template<typename WriterType>
+	static IMapWriterPtr createPartWriterOfType(std::size_t entityCount, std::size_t primitiveCount)
+	{
+		auto writer = std::make_shared<WriterType>();
+
+		static_cast<Doom3MapWriter&>(*writer)._entityCount = entityCount;
+		static_cast<Doom3MapWriter&>(*writer)._primitiveCount = primitiveCount;
+
+		return writer;
+	}
 };
 
 } // namespace
@@ -0,0 +1,347 @@
+#include "ParallelMapTokeniser.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace map
+{
+
+namespace
+{
+	// Entity blocks are grouped into batches of roughly this many bytes
+	// before they are handed to a worker thread
+	const std::size_t BATCH_SIZE = 256 * 1024;
+
+	// The number of batches per worker that may be tokenised ahead
+	// of the consuming thread
+	const std::size_t BATCHES_IN_FLIGHT_PER_WORKER = 2;
+}
+
+ParallelMapTokeniser::BlockTokeniser::BlockTokeniser()
+{}
+
+void ParallelMapTokeniser::BlockTokeniser::reset(std::vector<parser::TokenView>::const_iterator begin,
+	std::vector<parser::TokenView>::const_iterator end)
+{
+	_cur = begin;
+	_end = end;
+}
+
+bool ParallelMapTokeniser::BlockTokeniser::hasMoreTokens() const
+{
+	return _cur != _end;
+}
+
+std::string ParallelMapTokeniser::BlockTokeniser::nextToken()
+{
+	if (hasMoreTokens())
+	{
+		return (_cur++)->str();
+	}
+
+	throw parser::ParseException("DefTokeniser: no more tokens");
+}
+
+void ParallelMapTokeniser::BlockTokeniser::assertNextToken(const std::string& val)
+{
+	// Compare in place, without copying the token
+	if (!hasMoreTokens())
+	{
+		throw parser::ParseException("DefTokeniser: no more tokens");
+	}
+
+	const parser::TokenView& tok = *(_cur++);
+
+	if (tok != val)
+	{
+		throw parser::ParseException("DefTokeniser: Assertion failed: Required \""
+			+ val + "\", found \"" + tok.str() + "\"");
+	}
+}
+
+void ParallelMapTokeniser::BlockTokeniser::skipTokens(unsigned int n)
+{
+	for (unsigned int i = 0; i < n; i++)
+	{
+		if (!hasMoreTokens())
+		{
+			throw parser::ParseException("DefTokeniser: no more tokens");
+		}
+
+		++_cur;
+	}
+}
+
+std::string ParallelMapTokeniser::BlockTokeniser::peek() const
+{
+	if (hasMoreTokens())
+	{
+		return _cur->str();
+	}
+
+	throw parser::ParseException("DefTokeniser: no more tokens");
+}
+
+ParallelMapTokeniser::ParallelMapTokeniser(std::istream& stream, TaskScheduler& scheduler) :
+	_content(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()),
+	_scheduler(scheduler)
+{
+	initialise();
+}
+
+ParallelMapTokeniser::ParallelMapTokeniser(const std::string& content, TaskScheduler& scheduler) :
+	_content(content),
+	_scheduler(scheduler)
+{
+	initialise();
+}
+
+ParallelMapTokeniser::~ParallelMapTokeniser()
+{
+	// The workers are referencing our content buffer, wait for them to finish
+	for (const auto& future : _pending)
+	{
+		_scheduler.waitFor(future);
+	}
+}
+
+void ParallelMapTokeniser::initialise()
+{
+	_maxBatchesInFlight = std::max(_scheduler.getNumWorkers(), std::size_t(1)) * BATCHES_IN_FLIGHT_PER_WORKER;
+	_nextBatchToSchedule = 0;
+	_currentBatchIndex = 0;
+	_currentBlockInBatch = 0;
+	_currentBatchValid = false;
+
+	std::size_t headerEnd = findBlocks(_content, _blocks);
+
+	// The header is small, tokenise it right here
+	tokeniseRange(_content.data(), _content.data() + headerEnd, _headerTokens, _headerTokenStorage);
+	_headerTokeniser.reset(_headerTokens.begin(), _headerTokens.end());
+
+	// Group the blocks into batches
+	std::size_t batchStart = 0;
+	std::size_t batchBytes = 0;
+
+	for (std::size_t i = 0; i < _blocks.size(); ++i)
+	{
+		batchBytes += _blocks[i].second - _blocks[i].first;
+
+		if (batchBytes >= BATCH_SIZE || i + 1 == _blocks.size())
+		{
+			_batches.emplace_back(batchStart, i + 1);
+			batchStart = i + 1;
+			batchBytes = 0;
+		}
+	}
+
+	scheduleBatches();
+}
+
+parser::DefTokeniser& ParallelMapTokeniser::getHeaderTokeniser()
+{
+	return _headerTokeniser;
+}
+
+std::size_t ParallelMapTokeniser::getNumBlocks() const
+{
+	return _blocks.size();
+}
+
+bool ParallelMapTokeniser::hasMoreBlocks() const
+{
+	if (_currentBatchValid && _currentBlockInBatch + 1 < _currentBatch->blockStarts.size())
+	{
+		return true;
+	}
+
+	// Current batch is exhausted (or not there yet), check the next ones
+	return (_currentBatchValid ? _currentBatchIndex + 1 : _currentBatchIndex) < _batches.size();
+}
+
+parser::DefTokeniser& ParallelMapTokeniser::nextBlock()
+{
+	if (!_currentBatchValid || _currentBlockInBatch + 1 >= _currentBatch->blockStarts.size())
+	{
+		fetchNextBatch();
+	}
+
+	const auto& starts = _currentBatch->blockStarts;
+	const auto& tokens = _currentBatch->tokens;
+
+	_blockTokeniser.reset(tokens.begin() + starts[_currentBlockInBatch],
+		tokens.begin() + starts[_currentBlockInBatch + 1]);
+
+	++_currentBlockInBatch;
+
+	return _blockTokeniser;
+}
+
+void ParallelMapTokeniser::fetchNextBatch()
+{
+	if (_currentBatchValid)
+	{
+		++_currentBatchIndex;
+	}
+
+	if (_pending.empty())
+	{
+		throw parser::ParseException("ParallelMapTokeniser: no more blocks");
+	}
+
+	// Block until the worker is done, this re-throws worker exceptions
+	_scheduler.waitFor(_pending.front());
+	_currentBatch = _pending.front().get();
+	_pending.pop_front();
+
+	_currentBatchValid = true;
+	_currentBlockInBatch = 0;
+
+	// Keep the workers busy
+	scheduleBatches();
+}
+
+void ParallelMapTokeniser::scheduleBatches()
+{
+	while (_pending.size() < _maxBatchesInFlight && _nextBatchToSchedule < _batches.size())
+	{
+		const Range& batch = _batches[_nextBatchToSchedule++];
+
+		_pending.emplace_back(_scheduler.submit<BatchPtr>([this, batch]()
+		{
+			auto result = std::make_shared<Batch>();
+			result->blockStarts.reserve(batch.second - batch.first + 1);
+
+			for (std::size_t b = batch.first; b < batch.second; ++b)
+			{
+				result->blockStarts.push_back(result->tokens.size());
+
+				tokeniseRange(_content.data() + _blocks[b].first,
+					_content.data() + _blocks[b].second, result->tokens, result->storage);
+			}
+
+			result->blockStarts.push_back(result->tokens.size());
+
+			return result;
+		}));
+	}
+}
+
+void ParallelMapTokeniser::tokeniseRange(const char* begin, const char* end,
+	std::vector<parser::TokenView>& tokens, TokenStorage& storage)
+{
+	parser::BufferDefTokeniser tok(begin, end);
+
+	while (tok.hasMoreTokens())
+	{
+		parser::TokenView token = tok.nextTokenView();
+
+		// Tokens pointing into the tokeniser's scratch buffer need to be copied
+		if (token.data < begin || token.data >= end)
+		{
+			storage.emplace_back(token.data, token.length);
+			token = parser::TokenView(storage.back().data(), storage.back().size());
+		}
+
+		tokens.push_back(token);
+	}
+}
+
+std::size_t ParallelMapTokeniser::findBlocks(const std::string& content, std::vector<std::pair<std::size_t, std::size_t>>& blocks)
+{
+	// This follows the quoting and comment rules of the DefTokeniserFunc,
+	// to be sure that no brace inside a string or a comment is counted
+	const std::size_t length = content.length();
+
+	std::size_t headerEnd = std::string::npos;
+	std::size_t blockStart = 0;
+	std::size_t depth = 0;
+
+	std::size_t i = 0;
+
+	while (i < length)
+	{
+		switch (content[i])
+		{
+		case '"':
+			// Skip the quoted text, honouring backslash escapes
+			for (++i; i < length; ++i)
+			{
+				if (content[i] == '\\')
+				{
+					++i;
+				}
+				else if (content[i] == '"')
+				{
+					break;
+				}
+			}
+			break;
+
+		case '/':
+			if (i + 1 < length && content[i + 1] == '/')
+			{
+				// Line comment, continue at the line break
+				i = content.find_first_of("\r\n", i + 2);
+				i = i == std::string::npos ? length : i;
+				continue;
+			}
+			else if (i + 1 < length && content[i + 1] == '*')
+			{
+				// Delimited comment, continue after the closing sequence
+				i = content.find("*/", i + 2);
+				i = i == std::string::npos ? length : i + 2;
+				continue;
+			}
+			break;
+
+		case '{':
+			if (headerEnd == std::string::npos)
+			{
+				headerEnd = i;
+				blockStart = i;
+			}
+
+			++depth;
+			break;
+
+		case '}':
+			if (headerEnd == std::string::npos)
+			{
+				// A stray closing brace in front of the first entity
+				headerEnd = i;
+				blockStart = i;
+			}
+
+			if (depth > 0)
+			{
+				--depth;
+			}
+
+			if (depth == 0)
+			{
+				blocks.emplace_back(blockStart, i + 1);
+				blockStart = i + 1;
+			}
+			break;
+		};
+
+		++i;
+	}
+
+	if (headerEnd == std::string::npos)
+	{
+		// No blocks at all, everything is header
+		return length;
+	}
+
+	// Any text after the last block is handed out as separate block
+	if (blockStart < length)
+	{
+		blocks.emplace_back(blockStart, length);
+	}
+
+	return headerEnd;
+}
+
+} // namespace
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <istream>
+#include "ithread.h"
+#include "parser/BufferDefTokeniser.h"
+
+namespace map
+{
+
+/**
+ * Tokeniser front-end for the two-phase map loader.
+ *
+ * The map text is read into memory and split at its top-level entity
+ * boundaries ("{ ... }" blocks at brace depth zero, respecting quotes and
+ * comments). The entity blocks are grouped into batches which are tokenised
+ * by the workers of a TaskScheduler, while the calling thread walks through the blocks in
+ * file order using nextBlock(). The tokens reference the map text in memory
+ * wherever possible. The token sequence seen by the caller is
+ * exactly the one a BasicDefTokeniser<std::istream> would produce for the
+ * same input, so the regular entity and primitive parsers can consume it
+ * unchanged (and create their scene nodes on the calling thread).
+ *
+ * Only a limited number of batches is kept in flight at any time, which
+ * bounds the memory used by the token lists of large maps.
+ */
+class ParallelMapTokeniser
+{
+public:
+	// DefTokeniser implementation walking over the tokens of a single block
+	class BlockTokeniser :
+		public parser::DefTokeniser
+	{
+	private:
+		std::vector<parser::TokenView>::const_iterator _cur;
+		std::vector<parser::TokenView>::const_iterator _end;
+
+	public:
+		BlockTokeniser();
+
+		void reset(std::vector<parser::TokenView>::const_iterator begin,
+				   std::vector<parser::TokenView>::const_iterator end);
+
+		bool hasMoreTokens() const override;
+		std::string nextToken() override;
+		void assertNextToken(const std::string& val) override;
+		void skipTokens(unsigned int n) override;
+		std::string peek() const override;
+	};
+
+private:
+	// The full map text
+	std::string _content;
+
+	// Character range [first, second) of each entity block
+	typedef std::pair<std::size_t, std::size_t> Range;
+	std::vector<Range> _blocks;
+
+	// Storage for tokens which can't reference the content buffer directly
+	// (quoted strings with escape sequences). Element addresses are stable.
+	typedef std::deque<std::string> TokenStorage;
+
+	// The tokenised map header (everything before the first entity)
+	std::vector<parser::TokenView> _headerTokens;
+	TokenStorage _headerTokenStorage;
+	BlockTokeniser _headerTokeniser;
+
+	// The result of one worker task, covering a consecutive set of blocks
+	struct Batch
+	{
+		// The tokens, referencing either the content buffer or the storage
+		std::vector<parser::TokenView> tokens;
+		TokenStorage storage;
+
+		// Index into tokens where each block starts (plus the end index)
+		std::vector<std::size_t> blockStarts;
+	};
+	typedef std::shared_ptr<Batch> BatchPtr;
+
+	TaskScheduler& _scheduler;
+
+	// The first and one-past-last block index of each batch
+	std::vector<Range> _batches;
+
+	// Pending worker results in batch order, the front one is the current batch
+	std::deque<std::shared_future<BatchPtr>> _pending;
+	std::size_t _nextBatchToSchedule;
+
+	std::size_t _maxBatchesInFlight;
+
+	BatchPtr _currentBatch;
+	std::size_t _currentBatchIndex;
+	std::size_t _currentBlockInBatch;
+	bool _currentBatchValid;
+
+	BlockTokeniser _blockTokeniser;
+
+public:
+	// Reads the entire stream and starts tokenising on the given scheduler
+	ParallelMapTokeniser(std::istream& stream, TaskScheduler& scheduler);
+
+	// Construct from a string in memory
+	ParallelMapTokeniser(const std::string& content, TaskScheduler& scheduler);
+
+	// Waits for any workers still in flight
+	~ParallelMapTokeniser();
+
+	// Tokeniser over the text in front of the first entity block (e.g. "Version 2")
+	parser::DefTokeniser& getHeaderTokeniser();
+
+	// Returns the number of top-level blocks found in the map text
+	std::size_t getNumBlocks() const;
+
+	// True if nextBlock() can be called at least once more
+	bool hasMoreBlocks() const;
+
+	// Returns a tokeniser for the next entity block in file order. The
+	// reference stays valid until the next call to nextBlock().
+	// Any exception thrown by the worker is re-thrown here.
+	parser::DefTokeniser& nextBlock();
+
+	// Splits the given map text into its header and top-level blocks.
+	// Returns the offset where the first block starts.
+	static std::size_t findBlocks(const std::string& content, std::vector<std::pair<std::size_t, std::size_t>>& blocks);
+
+private:
+	void initialise();
+	void scheduleBatches();
+	void fetchNextBatch();
+
+	static void tokeniseRange(const char* begin, const char* end,
+		std::vector<parser::TokenView>& tokens, TokenStorage& storage);
+};
+
+} // namespace
@@ -0,0 +1,261 @@
+#include "ParallelMapWriter.h"
+
+#include <sstream>
+#include "itextstream.h"
+#include "ithread.h"
+
+namespace map
+{
+
+namespace
+{
+	// The maximum number of primitives written by a single part writer
+	const std::size_t MAX_PART_NODES = 256;
+
+	// The number of nodes serialised before the buffers are written to the stream
+	const std::size_t BATCH_NODES = 8192;
+}
+
+ParallelMapWriter::ParallelMapWriter(IMapWriter& writer, std::ostream& stream, TaskScheduler* scheduler) :
+	_writer(writer),
+	_stream(stream),
+	_scheduler(scheduler),
+	_entityCount(0),
+	_primitiveCount(0)
+{}
+
+void ParallelMapWriter::beginWriteEntity(const IEntityNodePtr& entity)
+{
+	// Every entity starts a new part
+	beginPart();
+
+	addCall(CallType::BeginEntity, entity, IBrushNodePtr(), IPatchNodePtr());
+	_parts.back().numNodes++;
+
+	_entityCount++;
+}
+
+void ParallelMapWriter::endWriteEntity(const IEntityNodePtr& entity)
+{
+	addCall(CallType::EndEntity, entity, IBrushNodePtr(), IPatchNodePtr());
+
+	_primitiveCount = 0;
+}
+
+void ParallelMapWriter::beginWriteBrush(const IBrushNodePtr& brush)
+{
+	beginPrimitive();
+	addCall(CallType::BeginBrush, IEntityNodePtr(), brush, IPatchNodePtr());
+}
+
+void ParallelMapWriter::endWriteBrush(const IBrushNodePtr& brush)
+{
+	addCall(CallType::EndBrush, IEntityNodePtr(), brush, IPatchNodePtr());
+}
+
+void ParallelMapWriter::beginWritePatch(const IPatchNodePtr& patch)
+{
+	beginPrimitive();
+	addCall(CallType::BeginPatch, IEntityNodePtr(), IBrushNodePtr(), patch);
+}
+
+void ParallelMapWriter::endWritePatch(const IPatchNodePtr& patch)
+{
+	addCall(CallType::EndPatch, IEntityNodePtr(), IBrushNodePtr(), patch);
+}
+
+void ParallelMapWriter::flush(const std::function<void(std::size_t)>& progress)
+{
+	if (_calls.empty())
+	{
+		return;
+	}
+
+	// Writers which can't be split write everything to the target stream
+	if (!_writer.createPartWriter(0, 0))
+	{
+		writeCalls(_writer, _stream, 0, _calls.size(), progress);
+
+		_calls.clear();
+		_parts.clear();
+		return;
+	}
+
+	// The stream settings are shared by all part buffers
+	std::ios_base::fmtflags flags = _stream.flags();
+	std::streamsize precision = _stream.precision();
+	std::locale locale = _stream.getloc();
+
+	for (std::size_t batchStart = 0; batchStart < _parts.size();)
+	{
+		// Collect the parts of the next batch
+		std::size_t batchEnd = batchStart;
+		std::size_t batchNodes = 0;
+
+		while (batchEnd < _parts.size() && batchNodes < BATCH_NODES)
+		{
+			batchNodes += _parts[batchEnd++].numNodes;
+		}
+
+		std::vector<IMapWriterPtr> writers;
+
+		for (std::size_t i = batchStart; i < batchEnd; ++i)
+		{
+			writers.push_back(_writer.createPartWriter(_parts[i].entityCount, _parts[i].primitiveCount));
+		}
+
+		std::vector<std::string> buffers(writers.size());
+
+		auto writePart = [&](std::size_t index)
+		{
+			const Part& part = _parts[batchStart + index];
+
+			std::ostringstream buffer;
+			buffer.flags(flags);
+			buffer.precision(precision);
+			buffer.imbue(locale);
+
+			writeCalls(*writers[index], buffer, part.firstCall, part.endCall, std::function<void(std::size_t)>());
+
+			buffers[index] = buffer.str();
+		};
+
+		if (_scheduler != nullptr)
+		{
+			_scheduler->parallelFor(buffers.size(), writePart);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < buffers.size(); ++i)
+			{
+				writePart(i);
+			}
+		}
+
+		// Concatenate the buffers for a single write
+		std::size_t batchSize = 0;
+
+		for (const std::string& buffer : buffers)
+		{
+			batchSize += buffer.size();
+		}
+
+		std::string batch;
+		batch.reserve(batchSize);
+
+		for (const std::string& buffer : buffers)
+		{
+			batch.append(buffer);
+		}
+
+		_stream.write(batch.data(), batch.size());
+
+		if (progress)
+		{
+			progress(batchNodes);
+		}
+
+		batchStart = batchEnd;
+	}
+
+	_calls.clear();
+	_parts.clear();
+}
+
+void ParallelMapWriter::addCall(CallType type, const IEntityNodePtr& entity, const IBrushNodePtr& brush,
+								const IPatchNodePtr& patch)
+{
+	// Primitives outside any entity end up in a part of their own
+	if (_parts.empty())
+	{
+		beginPart();
+	}
+
+	Call call;
+	call.type = type;
+	call.entity = entity;
+	call.brush = brush;
+	call.patch = patch;
+
+	_calls.push_back(call);
+	_parts.back().endCall = _calls.size();
+}
+
+void ParallelMapWriter::beginPart()
+{
+	Part part;
+
+	part.firstCall = _calls.size();
+	part.endCall = _calls.size();
+	part.entityCount = _entityCount;
+	part.primitiveCount = _primitiveCount;
+	part.numNodes = 0;
+
+	_parts.push_back(part);
+}
+
+void ParallelMapWriter::beginPrimitive()
+{
+	// Split large entities into several parts
+	if (_parts.empty() || _parts.back().numNodes >= MAX_PART_NODES)
+	{
+		beginPart();
+	}
+
+	_parts.back().numNodes++;
+	_primitiveCount++;
+}
+
+void ParallelMapWriter::writeCalls(IMapWriter& writer, std::ostream& stream, std::size_t first, std::size_t end,
+								   const std::function<void(std::size_t)>& progress)
+{
+	for (std::size_t i = first; i < end; ++i)
+	{
+		const Call& call = _calls[i];
+
+		writeCall(writer, stream, call);
+
+		if (progress && (call.type == CallType::BeginEntity ||
+			call.type == CallType::BeginBrush || call.type == CallType::BeginPatch))
+		{
+			progress(1);
+		}
+	}
+}
+
+void ParallelMapWriter::writeCall(IMapWriter& writer, std::ostream& stream, const Call& call)
+{
+	try
+	{
+		switch (call.type)
+		{
+		case CallType::BeginEntity:
+			writer.beginWriteEntity(call.entity, stream);
+			break;
+		case CallType::EndEntity:
+			writer.endWriteEntity(call.entity, stream);
+			break;
+		case CallType::BeginBrush:
+			writer.beginWriteBrush(call.brush, stream);
+			break;
+		case CallType::EndBrush:
+			writer.endWriteBrush(call.brush, stream);
+			break;
+		case CallType::BeginPatch:
+			writer.beginWritePatch(call.patch, stream);
+			break;
+		case CallType::EndPatch:
+			writer.endWritePatch(call.patch, stream);
+			break;
+		}
+	}
+	catch (IMapWriter::FailureException& ex)
+	{
+		bool isEnd = call.type == CallType::EndEntity || call.type == CallType::EndBrush ||
+			call.type == CallType::EndPatch;
+
+		rError() << "Failure exporting a node (" << (isEnd ? "post" : "pre") << "): " << ex.what() << std::endl;
+	}
+}
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <vector>
+#include "imapformat.h"
+
+class TaskScheduler;
+
+namespace map
+{
+
+/**
+ * Write front-end for the map exporter.
+ *
+ * The IMapWriter calls issued during the scene traversal are queued
+ * and serialised in one go by flush(). The queue is split into parts at
+ * the entity boundaries (large entities like the worldspawn are split
+ * into chunks of primitives), each part is written by its own writer
+ * instance (see IMapWriter::createPartWriter) into a memory buffer. The
+ * parts of a batch are serialised concurrently on the task scheduler,
+ * their buffers are then written to the target stream in their original
+ * order with a single write call per batch. The output is exactly the one
+ * the writer would produce if it was called directly.
+ *
+ * Writers not supporting parts are called directly on the target stream.
+ */
+class ParallelMapWriter
+{
+private:
+	enum class CallType
+	{
+		BeginEntity,
+		EndEntity,
+		BeginBrush,
+		EndBrush,
+		BeginPatch,
+		EndPatch,
+	};
+
+	// A queued writer call, only the pointer matching the type is set
+	struct Call
+	{
+		CallType type;
+		IEntityNodePtr entity;
+		IBrushNodePtr brush;
+		IPatchNodePtr patch;
+	};
+
+	// A range of calls written by the same part writer
+	struct Part
+	{
+		std::size_t firstCall;
+		std::size_t endCall;
+
+		// The writer counters at the beginning of this part
+		std::size_t entityCount;
+		std::size_t primitiveCount;
+
+		// The number of entities and primitives in this part
+		std::size_t numNodes;
+	};
+
+	IMapWriter& _writer;
+	std::ostream& _stream;
+	TaskScheduler* _scheduler;
+
+	std::vector<Call> _calls;
+	std::vector<Part> _parts;
+
+	// The writer counters at the end of the queue
+	std::size_t _entityCount;
+	std::size_t _primitiveCount;
+
+public:
+	// Without a scheduler, the parts are serialised on the calling thread
+	ParallelMapWriter(IMapWriter& writer, std::ostream& stream, TaskScheduler* scheduler = nullptr);
+
+	// Queue the writer calls for the visited nodes, in traversal order
+	void beginWriteEntity(const IEntityNodePtr& entity);
+	void endWriteEntity(const IEntityNodePtr& entity);
+	void beginWriteBrush(const IBrushNodePtr& brush);
+	void endWriteBrush(const IBrushNodePtr& brush);
+	void beginWritePatch(const IPatchNodePtr& patch);
+	void endWritePatch(const IPatchNodePtr& patch);
+
+	/**
+	 * Serialises the queued calls and writes them to the stream, the queue is
+	 * empty afterwards. The progress function is invoked on the calling thread
+	 * with the number of nodes written since the last invocation, it may throw
+	 * to cancel the operation.
+	 */
+	void flush(const std::function<void(std::size_t)>& progress = std::function<void(std::size_t)>());
+
+private:
+	void addCall(CallType type, const IEntityNodePtr& entity, const IBrushNodePtr& brush,
+				 const IPatchNodePtr& patch);
+	void beginPart();
+	void beginPrimitive();
+
+	// Writes the queued calls on the given writer, one by one
+	void writeCalls(IMapWriter& writer, std::ostream& stream, std::size_t first, std::size_t end,
+					const std::function<void(std::size_t)>& progress);
+
+	void writeCall(IMapWriter& writer, std::ostream& stream, const Call& call);
+};
+
+}
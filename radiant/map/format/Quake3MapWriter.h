@@ -18,13 +18,13 @@ public:
 	virtual void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
 	{
 		// Write an empty line at the beginning of the file
-		stream << std::endl;
+		stream << "\n";
 	}
 
 	virtual void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
 	{
 		// Primitive count comment
-		stream << "// brush " << _primitiveCount++ << std::endl;
+		stream << "// brush " << _primitiveCount++ << "\n";
 
 		// Export brushDef definition to stream
 		BrushDefExporter::exportBrush(stream, brush);
@@ -33,11 +33,16 @@ public:
 	virtual void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
 	{
 		// Primitive count comment, not a typo, patches also seem to have "brush" in their comments
-		stream << "// brush " << _primitiveCount++ << std::endl;
+		stream << "// brush " << _primitiveCount++ << "\n";
 
 		// Export patchDef2 to stream (patchDef3 is not supported)
 		PatchDefExporter::exportQ3PatchDef2(stream, patch);
 	}
+
+	virtual IMapWriterPtr createPartWriter(std::size_t entityCount, std::size_t primitiveCount) override
+	{
+		return createPartWriterOfType<Quake3MapWriter>(entityCount, primitiveCount);
+	}
 };
 
 } // namespace
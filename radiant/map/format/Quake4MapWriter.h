@@ -17,17 +17,22 @@ public:
 	virtual void beginWriteMap(const scene::IMapRootNodePtr& root, std::ostream& stream) override
 	{
 		// Write the version tag
-		stream << "Version " << MAP_VERSION_Q4 << std::endl;
+		stream << "Version " << MAP_VERSION_Q4 << "\n";
 	}
 
 	virtual void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
 	{
 		// Primitive count comment
-		stream << "// primitive " << _primitiveCount++ << std::endl;
+		stream << "// primitive " << _primitiveCount++ << "\n";
 
 		// Export brushDef3 definition to stream, but without contents flags
 		BrushDef3Exporter::exportBrush(stream, brush, false);
 	}
+
+	virtual IMapWriterPtr createPartWriter(std::size_t entityCount, std::size_t primitiveCount) override
+	{
+		return createPartWriterOfType<Quake4MapWriter>(entityCount, primitiveCount);
+	}
 };
 
 } // namespace
@@ -3,34 +3,11 @@
 #include "ibrush.h"
 #include "math/Plane3.h"
 #include "math/Matrix4.h"
+#include "DoubleWriter.h"
 
 namespace map
 {
 
-namespace
-{
-	// Writes a double to the given stream and checks for NaN and infinity
-	inline void writeDoubleSafe(const double d, std::ostream& os)
-	{
-		if (isValid(d))
-		{
-			if (d == -0.0)
-			{
-				os << 0; // convert -0 to 0
-			}
-			else
-			{
-				os << d;
-			}
-		}
-		else
-		{
-			// Is infinity or NaN, write 0
-			os << "0";
-		}
-	}
-}
-
 class BrushDef3Exporter
 {
 public:
@@ -41,9 +18,9 @@ public:
 		const IBrush& brush = brushNode->getIBrush();
 
 		// Brush decl header
-		stream << "{" << std::endl;
-		stream << "brushDef3" << std::endl;
-		stream << "{" << std::endl;
+		stream << "{\n";
+		stream << "brushDef3\n";
+		stream << "{\n";
 
 		// Iterate over each brush face, exporting the tokens from all faces
 		for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
@@ -52,7 +29,7 @@ public:
 		}
 
 		// Close brush contents and header
-		stream << "}" << std::endl << "}" << std::endl;
+		stream << "}\n}\n";
 	}
 
 private:
@@ -117,7 +94,7 @@ private:
 			stream << detailFlag << " 0 0";
 		}
 
-		stream << std::endl;
+		stream << "\n";
 	}
 };
 
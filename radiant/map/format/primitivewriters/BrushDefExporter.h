@@ -3,6 +3,7 @@
 #include "ibrush.h"
 #include "math/Plane3.h"
 #include "math/Matrix4.h"
+#include "DoubleWriter.h"
 #include "shaderlib.h"
 
 #include "string/predicate.h"
@@ -10,30 +11,6 @@
 namespace map
 {
 
-namespace
-{
-	// Writes a double to the given stream and checks for NaN and infinity
-	inline void writeDoubleSafe(const double d, std::ostream& os)
-	{
-		if (isValid(d))
-		{
-			if (d == -0.0)
-			{
-				os << 0; // convert -0 to 0
-			}
-			else
-			{
-				os << d;
-			}
-		}
-		else
-		{
-			// Is infinity or NaN, write 0
-			os << "0";
-		}
-	}
-}
-
 class BrushDefExporter
 {
 public:
@@ -44,9 +21,9 @@ public:
 		const IBrush& brush = brushNode->getIBrush();
 
 		// Brush decl header
-		stream << "{" << std::endl;
-		stream << "brushDef" << std::endl;
-		stream << "{" << std::endl;
+		stream << "{\n";
+		stream << "brushDef\n";
+		stream << "{\n";
 
 		// Iterate over each brush face, exporting the tokens from all faces
 		for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
@@ -55,7 +32,7 @@ public:
 		}
 
 		// Close brush contents and header
-		stream << "}" << std::endl << "}" << std::endl;
+		stream << "}\n}\n";
 	}
 
 	/* 
@@ -156,7 +133,7 @@ private:
 		// Export (dummy) contents/flags
 		stream << detailFlag << " 0 0";
 		
-		stream << std::endl;
+		stream << "\n";
 	}
 };
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include "math/FloatTools.h"
+
+namespace map
+{
+
+/**
+ * Writes a double to the given stream and checks for NaN and infinity,
+ * these are written as 0, and so is -0.
+ *
+ * The output is the same as the one of os << d for map streams (default
+ * float format using the stream's precision, classic locale), but the
+ * number is formatted without going through the iostreams facets.
+ * Integral values, which make up most of the numbers in a map, are
+ * converted without any floating point formatting at all.
+ */
+inline void writeDoubleSafe(const double d, std::ostream& os)
+{
+	if (!isValid(d) || d == 0)
+	{
+		// Is infinity, NaN or (-)0
+		os.put('0');
+		return;
+	}
+
+	char buffer[32];
+	std::streamsize precision = os.precision();
+
+	// The default float format switches to exponents at 10^precision, integral
+	// values below 1e15 are written as plain integers for any precision >= 15
+	if (precision >= 15 && std::fabs(d) < 1e15 && d == std::floor(d))
+	{
+		char* end = buffer + sizeof(buffer);
+		char* start = end;
+
+		int64_t value = static_cast<int64_t>(d);
+		uint64_t digits = value < 0 ? static_cast<uint64_t>(-value) : static_cast<uint64_t>(value);
+
+		do
+		{
+			*--start = static_cast<char>('0' + digits % 10);
+			digits /= 10;
+		}
+		while (digits > 0);
+
+		if (value < 0)
+		{
+			*--start = '-';
+		}
+
+		os.write(start, end - start);
+		return;
+	}
+
+	int length = snprintf(buffer, sizeof(buffer), "%.*g", static_cast<int>(precision), d);
+
+	if (length > 0 && length < static_cast<int>(sizeof(buffer)))
+	{
+		os.write(buffer, length);
+	}
+	else
+	{
+		os << d;
+	}
+}
+
+}
@@ -3,6 +3,8 @@
 #include "itextstream.h"
 #include "string/convert.h"
 
+#include <cmath>
+
 namespace md5
 {
 
@@ -195,4 +197,118 @@ void MD5Anim::parseFromTokens(parser::DefTokeniser& tok)
 	}
 }
 
+namespace
+{
+	const float QUANTISATION_SCALE = 32767.0f;
+	const float DEQUANTISATION_SCALE = 1.0f / QUANTISATION_SCALE;
+
+	inline int16_t quantise(double value)
+	{
+		return static_cast<int16_t>(std::lround(std::max(-1.0, std::min(value, 1.0)) * QUANTISATION_SCALE));
+	}
+}
+
+void MD5Anim::decodeFrames()
+{
+	_decodedFrames.resize(_frames.size() * _joints.size());
+
+	for (std::size_t frame = 0; frame < _frames.size(); ++frame)
+	{
+		const FrameKeys& keys = _frames[frame];
+
+		for (std::size_t i = 0; i < _joints.size(); ++i)
+		{
+			const Joint& joint = _joints[i];
+			const Key& baseKey = _baseFrame[joint.id];
+
+			Vector3 origin = baseKey.origin;
+			Vector3 rotation = baseKey.orientation.getVector3();
+
+			// The components are applied in the same order as in MD5Skeleton
+			std::size_t key = joint.firstKey;
+			const std::size_t components[6] = { Joint::X, Joint::Y, Joint::Z, Joint::YAW, Joint::PITCH, Joint::ROLL };
+
+			for (std::size_t c = 0; c < 6; ++c)
+			{
+				if (!(joint.animComponents & components[c])) continue;
+
+				float value = key < keys.size() ? keys[key] : 0.0f;
+				key++;
+
+				if (c < 3)
+				{
+					origin[c] = value;
+				}
+				else
+				{
+					rotation[c - 3] = value;
+				}
+			}
+
+			Quaternion orientation = baseKey.orientation;
+
+			if (joint.animComponents & (Joint::YAW | Joint::PITCH | Joint::ROLL))
+			{
+				float lSq = rotation.getLengthSquared();
+				float w = -sqrt(1.0f - lSq);
+
+				orientation = Quaternion(rotation, isNaN(w) ? 0 : w);
+			}
+
+			orientation = orientation.getNormalised();
+
+			// q and -q are the same rotation, pick the one closer to the previous
+			// frame, which allows for linear interpolation between the frames
+			if (frame > 0)
+			{
+				const int16_t* prev = _decodedFrames[(frame - 1) * _joints.size() + i].orientation;
+
+				if (prev[0] * orientation.x() + prev[1] * orientation.y() +
+					prev[2] * orientation.z() + prev[3] * orientation.w() < 0)
+				{
+					orientation = Quaternion(-orientation.x(), -orientation.y(), -orientation.z(), -orientation.w());
+				}
+			}
+
+			DecodedKey& decoded = _decodedFrames[frame * _joints.size() + i];
+
+			decoded.origin[0] = static_cast<float>(origin.x());
+			decoded.origin[1] = static_cast<float>(origin.y());
+			decoded.origin[2] = static_cast<float>(origin.z());
+
+			decoded.orientation[0] = quantise(orientation.x());
+			decoded.orientation[1] = quantise(orientation.y());
+			decoded.orientation[2] = quantise(orientation.z());
+			decoded.orientation[3] = quantise(orientation.w());
+		}
+	}
+}
+
+IMD5Anim::Key MD5Anim::getDecodedKey(std::size_t frame, std::size_t jointNum) const
+{
+	const DecodedKey& decoded = _decodedFrames[frame * _joints.size() + jointNum];
+
+	Key key;
+
+	key.origin = Vector3(decoded.origin[0], decoded.origin[1], decoded.origin[2]);
+	key.orientation = Quaternion(decoded.orientation[0] * DEQUANTISATION_SCALE,
+		decoded.orientation[1] * DEQUANTISATION_SCALE,
+		decoded.orientation[2] * DEQUANTISATION_SCALE,
+		decoded.orientation[3] * DEQUANTISATION_SCALE);
+
+	return key;
+}
+
+std::size_t MD5Anim::getMemoryUsage() const
+{
+	std::size_t bytes = _decodedFrames.size() * sizeof(DecodedKey);
+
+	for (const FrameKeys& keys : _frames)
+	{
+		bytes += keys.size() * sizeof(float);
+	}
+
+	return bytes;
+}
+
 } // namespace
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "imd5anim.h"
+#include <cstdint>
 #include <vector>
 #include "parser/DefTokeniser.h"
 #include "math/AABB.h"
@@ -34,6 +35,16 @@ private:
 	// Each frame has <numAnimatedComponents> float values
 	std::vector<FrameKeys> _frames;
 
+	// A joint key of a decoded frame, the orientation is quantised to 16 bits per component
+	struct DecodedKey
+	{
+		float origin[3];
+		int16_t orientation[4];
+	};
+
+	// One key per joint and frame, empty unless decodeFrames() has been called
+	std::vector<DecodedKey> _decodedFrames;
+
 public:
 	MD5Anim();
 
@@ -72,6 +83,20 @@ public:
 		return _frames[index];
 	}
 
+	bool hasDecodedFrames() const
+	{
+		return !_decodedFrames.empty();
+	}
+
+	Key getDecodedKey(std::size_t frame, std::size_t jointNum) const;
+
+	// Apply the animated components of each frame to the base frame,
+	// storing one key per joint and frame
+	void decodeFrames();
+
+	// Returns the number of bytes used by the frame data
+	std::size_t getMemoryUsage() const;
+
 	void parseFromStream(std::istream& stream);
 
 private:
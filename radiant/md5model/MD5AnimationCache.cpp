@@ -1,30 +1,101 @@
 #include "MD5AnimationCache.h"
 
+#include "i18n.h"
 #include "iarchive.h"
 #include "ifilesystem.h"
+#include "ipreferencesystem.h"
+#include "iradiant.h"
+#include "iregistry.h"
+#include "ithread.h"
 #include "itextstream.h"
+#include "registry/registry.h"
 #include "parser/DefTokeniser.h"
 
+#include "MD5PoseCache.h"
+
 namespace md5
 {
 
+namespace
+{
+	const char* const RKEY_DECODE_ANIMATION_FRAMES = "user/ui/md5/decodeAnimationFrames";
+}
+
 IMD5AnimPtr MD5AnimationCache::getAnim(const std::string& vfsPath)
 {
-	// Check the cache first
-	AnimationMap::iterator found = _animations.find(vfsPath);
+	std::shared_future<MD5AnimPtr> result;
+	std::packaged_task<MD5AnimPtr()> task;
+
+	// The registry is not thread-safe, the flag is read here and passed on
+	bool decodeFrames = registry::getValue<bool>(RKEY_DECODE_ANIMATION_FRAMES);
 
-	if (found != _animations.end())
 	{
-		return found->second;
+		std::lock_guard<std::mutex> lock(_lock);
+
+		// Check the cache first, the anim might still be parsed by a worker
+		AnimationMap::iterator found = _animations.find(vfsPath);
+
+		if (found != _animations.end())
+		{
+			result = found->second;
+		}
+		else
+		{
+			// Not found, parse it on this thread
+			task = std::packaged_task<MD5AnimPtr()>(std::bind(&MD5AnimationCache::loadAnim, vfsPath, decodeFrames));
+			result = task.get_future().share();
+
+			_animations.insert(AnimationMap::value_type(vfsPath, result));
+		}
+	}
+
+	if (task.valid())
+	{
+		task();
+	}
+	else
+	{
+		GlobalRadiant().getThreadManager().getTaskScheduler().waitFor(result);
 	}
 
-	// Not found, construct new animation with the given path
+	MD5AnimPtr anim = result.get();
+
+	if (!anim)
+	{
+		// Don't remember missing files, they might show up later
+		std::lock_guard<std::mutex> lock(_lock);
+		_animations.erase(vfsPath);
+	}
+
+	return anim;
+}
+
+void MD5AnimationCache::prefetchAnim(const std::string& vfsPath)
+{
+	// The anim is parsed on a worker thread, which must not access the registry
+	bool decodeFrames = registry::getValue<bool>(RKEY_DECODE_ANIMATION_FRAMES);
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (_animations.find(vfsPath) != _animations.end())
+	{
+		return;
+	}
+
+	_animations.insert(AnimationMap::value_type(vfsPath,
+		GlobalRadiant().getThreadManager().getTaskScheduler().submit<MD5AnimPtr>(
+			std::bind(&MD5AnimationCache::loadAnim, vfsPath, decodeFrames))));
+}
+
+MD5AnimPtr MD5AnimationCache::loadAnim(const std::string& vfsPath, bool decodeFrames)
+{
+	// Construct new animation with the given path
 	ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(vfsPath);
 
 	if (file == NULL)
 	{
 		rWarning() << "Animation file " << vfsPath << " does not exist." << std::endl;
-		return IMD5AnimPtr();
+		return MD5AnimPtr();
 	}
 
 	std::istream inputStream(&file->getInputStream());
@@ -33,8 +104,11 @@ IMD5AnimPtr MD5AnimationCache::getAnim(const std::string& vfsPath)
 	MD5AnimPtr anim(new MD5Anim);
 	anim->parseFromStream(inputStream);
 
-	// Store the anim in our cache
-	_animations.insert(AnimationMap::value_type(vfsPath, anim));
+	// Decoded frames save applying the packed components on every update
+	if (decodeFrames)
+	{
+		anim->decodeFrames();
+	}
 
 	return anim;
 }
@@ -52,6 +126,9 @@ const StringSet& MD5AnimationCache::getDependencies() const
 	if (_dependencies.empty())
 	{
 		_dependencies.insert(MODULE_VIRTUALFILESYSTEM);
+		_dependencies.insert(MODULE_XMLREGISTRY);
+		_dependencies.insert(MODULE_PREFERENCESYSTEM);
+		_dependencies.insert(MODULE_RADIANT);
 	}
 
 	return _dependencies;
@@ -60,11 +137,29 @@ const StringSet& MD5AnimationCache::getDependencies() const
 void MD5AnimationCache::initialiseModule(const ApplicationContext& ctx)
 {
 	rMessage() << getName() << "::initialiseModule called." << std::endl;
+
+	constructPreferences();
 }
 
 void MD5AnimationCache::shutdownModule()
 {
+	// Wait for the anims being parsed before clearing the cache
+	for (AnimationMap::value_type& pair : _animations)
+	{
+		pair.second.wait();
+	}
+
 	_animations.clear();
+
+	MD5PoseCache::Instance().clear();
+}
+
+void MD5AnimationCache::constructPreferences()
+{
+	IPreferencePage& page = GlobalPreferenceSystem().getPage(_("Settings/Model"));
+
+	page.appendCheckBox(_("Decode animation frames when loading (faster playback, more memory)"),
+		RKEY_DECODE_ANIMATION_FRAMES);
 }
 
 } // namespace
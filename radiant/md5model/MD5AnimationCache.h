@@ -1,7 +1,9 @@
 #pragma once
 
 #include "imd5anim.h"
+#include <future>
 #include <map>
+#include <mutex>
 
 #include "MD5Anim.h"
 
@@ -12,19 +14,29 @@ class MD5AnimationCache :
 	public IAnimationCache
 {
 private:
-	// The path => anim mapping
-	typedef std::map<std::string, MD5AnimPtr> AnimationMap;
+	// The path => anim mapping, anims which are still being parsed have a pending future
+	typedef std::map<std::string, std::shared_future<MD5AnimPtr>> AnimationMap;
 	AnimationMap _animations;
 
+	std::mutex _lock;
+
 public:
 	// IAnimationCache implementation
 	IMD5AnimPtr getAnim(const std::string& vfsPath);
+	void prefetchAnim(const std::string& vfsPath);
 
 	// RegisterableModule implementation
 	const std::string& getName() const;
 	const StringSet& getDependencies() const;
 	void initialiseModule(const ApplicationContext& ctx);
 	void shutdownModule();
+
+private:
+	// Parses the given file, returns NULL if it doesn't exist.
+	// Runs on worker threads, so the registry settings are passed in.
+	static MD5AnimPtr loadAnim(const std::string& vfsPath, bool decodeFrames);
+
+	void constructPreferences();
 };
 typedef std::shared_ptr<MD5AnimationCache> MD5AnimationCachePtr;
 
@@ -4,6 +4,7 @@
 #include "ishaders.h"
 #include "texturelib.h"
 #include "ifilter.h"
+#include "ithread.h"
 #include "string/convert.h"
 #include "math/Quaternion.h"
 #include "math/Ray.h"
@@ -177,6 +178,18 @@ int MD5Model::getPolyCount() const
 	return static_cast<int>(_polyCount);
 }
 
+std::size_t MD5Model::getRenderMemoryUsage() const
+{
+	std::size_t sum = 0;
+
+	for (const Surface& s : _surfaces)
+	{
+		sum += s.surface->getRenderMemoryUsage();
+	}
+
+	return sum;
+}
+
 void MD5Model::updateMaterialList()
 {
 	_surfaceNames.clear();
@@ -384,9 +397,31 @@ void MD5Model::updateAnim(std::size_t time)
 	// Update our joint hierarchy first
 	_skeleton.update(_anim, time);
 
+	// The joint matrices are shared by all surfaces
+	const MD5Pose& pose = _skeleton.getPose();
+
+	// Deform the surfaces, models with many vertices are spread over the workers
+	TaskScheduler* scheduler = skinning::getTaskScheduler();
+
+	if (scheduler != NULL && _surfaces.size() > 1 && _vertexCount >= skinning::MIN_PARALLEL_VERTICES)
+	{
+		scheduler->parallelFor(_surfaces.size(), [&](std::size_t i)
+		{
+			_surfaces[i].surface->updateToPose(pose);
+		});
+	}
+	else
+	{
+		for (SurfaceList::iterator i = _surfaces.begin(); i != _surfaces.end(); ++i)
+		{
+			i->surface->updateToPose(pose);
+		}
+	}
+
+	// The mesh buffers are not thread-safe
 	for (SurfaceList::iterator i = _surfaces.begin(); i != _surfaces.end(); ++i)
 	{
-		i->surface->updateToSkeleton(_skeleton);
+		i->surface->updateGeometry();
 	}
 }
 
@@ -131,6 +131,8 @@ public:
 	 */
 	virtual int getPolyCount() const;
 
+	virtual std::size_t getRenderMemoryUsage() const;
+
 	/** Return a vector of strings listing the active materials used in this
 	 * model, after any skin remaps. The list is owned by the model instance.
 	 */
@@ -96,6 +96,11 @@ bool MD5ModelNode::intersectsLight(const RendererLight& light) const
 	return light.intersectsAABB(worldAABB());
 }
 
+const AABB& MD5ModelNode::getLitObjectAABB() const
+{
+	return worldAABB();
+}
+
 void MD5ModelNode::insertLight(const RendererLight& light) {
 	const Matrix4& l2w = localToWorld();
 
@@ -0,0 +1,141 @@
+#include "MD5PoseCache.h"
+
+#include <cstring>
+
+namespace md5
+{
+
+namespace
+{
+	// Enough for a few hundred animated models in distinct poses
+	const std::size_t DEFAULT_CAPACITY = 512;
+
+	inline void combineHash(std::size_t& seed, std::size_t value)
+	{
+		seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+}
+
+std::size_t MD5PoseCache::KeyHash::operator()(const Key& key) const
+{
+	std::uint32_t fractionBits;
+	std::memcpy(&fractionBits, &key.fraction, sizeof(fractionBits));
+
+	std::size_t seed = std::hash<const IMD5Anim*>()(key.anim);
+
+	combineHash(seed, key.curFrame);
+	combineHash(seed, key.nextFrame);
+	combineHash(seed, fractionBits);
+
+	return seed;
+}
+
+MD5PoseCache::MD5PoseCache() :
+	_capacity(DEFAULT_CAPACITY),
+	_numHits(0),
+	_numMisses(0)
+{}
+
+MD5AnimPosePtr MD5PoseCache::get(const IMD5AnimPtr& anim, std::size_t curFrame, std::size_t nextFrame,
+								 float fraction, const EvaluateFunc& evaluate)
+{
+	// Positive and negative zero are the same fraction
+	Key key{ anim.get(), curFrame, nextFrame, fraction == 0 ? 0.0f : fraction };
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		auto found = _entries.find(key);
+
+		if (found != _entries.end())
+		{
+			_usage.splice(_usage.begin(), _usage, found->second.usage);
+			++_numHits;
+
+			return found->second.pose;
+		}
+
+		++_numMisses;
+
+		if (_capacity == 0)
+		{
+			return evaluate();
+		}
+	}
+
+	// Evaluate without holding the lock, other threads may be evaluating the same pose
+	MD5AnimPosePtr pose = evaluate();
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	auto found = _entries.find(key);
+
+	if (found != _entries.end())
+	{
+		return found->second.pose;
+	}
+
+	_usage.push_front(key);
+	_entries.emplace(key, Entry{ anim, pose, _usage.begin() });
+
+	trimToCapacity();
+
+	return pose;
+}
+
+void MD5PoseCache::setCapacity(std::size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_capacity = capacity;
+	trimToCapacity();
+}
+
+std::size_t MD5PoseCache::getCapacity() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _capacity;
+}
+
+std::size_t MD5PoseCache::size() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _entries.size();
+}
+
+std::size_t MD5PoseCache::getNumHits() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _numHits;
+}
+
+std::size_t MD5PoseCache::getNumMisses() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _numMisses;
+}
+
+void MD5PoseCache::clear()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_entries.clear();
+	_usage.clear();
+}
+
+void MD5PoseCache::trimToCapacity()
+{
+	while (_entries.size() > _capacity)
+	{
+		_entries.erase(_usage.back());
+		_usage.pop_back();
+	}
+}
+
+MD5PoseCache& MD5PoseCache::Instance()
+{
+	static MD5PoseCache _instance;
+	return _instance;
+}
+
+} // namespace
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "imd5anim.h"
+#include "MD5Skinning.h"
+
+namespace md5
+{
+
+/**
+ * The joints of an animation at a certain point in time, in model space.
+ */
+struct MD5AnimPose
+{
+	std::vector<IMD5Anim::Key> keys;
+
+	// The same joints as matrices, used for skinning
+	MD5Pose matrices;
+};
+typedef std::shared_ptr<const MD5AnimPose> MD5AnimPosePtr;
+
+/**
+ * Evaluated poses shared by all models playing the same animation at the
+ * same point in time. Twenty models in the same idle animation need to
+ * evaluate their skeleton only once.
+ *
+ * A pose is identified by the animation, the two frames it is interpolated
+ * from and the interpolation fraction. The least recently used poses are
+ * dropped once the capacity is exceeded. The cached poses keep their
+ * animation alive.
+ */
+class MD5PoseCache
+{
+public:
+	typedef std::function<MD5AnimPosePtr()> EvaluateFunc;
+
+private:
+	struct Key
+	{
+		const IMD5Anim* anim;
+		std::size_t curFrame;
+		std::size_t nextFrame;
+		float fraction;
+
+		bool operator==(const Key& other) const
+		{
+			return anim == other.anim && curFrame == other.curFrame &&
+				nextFrame == other.nextFrame && fraction == other.fraction;
+		}
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const;
+	};
+
+	typedef std::list<Key> UsageList;
+
+	struct Entry
+	{
+		IMD5AnimPtr anim;
+		MD5AnimPosePtr pose;
+
+		// Position in the usage list, most recently used first
+		UsageList::iterator usage;
+	};
+
+	std::unordered_map<Key, Entry, KeyHash> _entries;
+	UsageList _usage;
+
+	std::size_t _capacity;
+
+	std::size_t _numHits;
+	std::size_t _numMisses;
+
+	mutable std::mutex _lock;
+
+public:
+	MD5PoseCache();
+
+	/**
+	 * Returns the pose of the given animation between the two frames,
+	 * calling evaluate() to create it if it is not in the cache yet.
+	 */
+	MD5AnimPosePtr get(const IMD5AnimPtr& anim, std::size_t curFrame, std::size_t nextFrame,
+					   float fraction, const EvaluateFunc& evaluate);
+
+	/// The maximum number of cached poses, 0 disables the cache
+	void setCapacity(std::size_t capacity);
+	std::size_t getCapacity() const;
+
+	std::size_t size() const;
+
+	std::size_t getNumHits() const;
+	std::size_t getNumMisses() const;
+
+	/// Drops all poses, releasing the animations they belong to
+	void clear();
+
+	/// The cache used by all MD5 skeletons
+	static MD5PoseCache& Instance();
+
+private:
+	void trimToCapacity();
+};
+
+} // namespace
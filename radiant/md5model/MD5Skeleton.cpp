@@ -69,16 +69,6 @@ void MD5Skeleton::update(const IMD5AnimPtr& anim, std::size_t time)
 {
 	_anim = anim;
 
-	// Update the joint positions, recursively, starting from the first
-	// Only root nodes need to be processed, the children are reached through them
-	std::size_t numJoints = _anim ? _anim->getNumJoints() : 0;
-
-	// Ensure the correct size
-	if (_skeleton.size() != numJoints)
-	{
-		_skeleton.resize(numJoints);
-	}
-
 	// Calculate the current frame number
 	float timePerFrameMsec = 1000 / static_cast<float>(_anim->getFrameRate());
 	
@@ -86,101 +76,162 @@ void MD5Skeleton::update(const IMD5AnimPtr& anim, std::size_t time)
 
 	// Pre-calculate the weighting of each frame
 	float nextFrameFrac = float_mod(frameTime, 1.0f);
-	float curFrameFrac = 1.0f - nextFrameFrac;
 
 	std::size_t curFrame = static_cast<std::size_t>(std::floor(frameTime)) % _anim->getNumFrames();
 	std::size_t nextFrame = curFrame == _anim->getNumFrames() -1 ? curFrame : (curFrame + 1) % _anim->getNumFrames();
 
-	// Apply the current frame keys to the base frame
-	for (std::size_t i = 0; i < numJoints; ++i)
+	// Other models playing this animation at the same time share the pose
+	_pose = MD5PoseCache::Instance().get(_anim, curFrame, nextFrame, nextFrameFrac, [&]()
 	{
-		const Joint& joint = _anim->getJoint(i);
-		const IMD5Anim::Key& baseKey = _anim->getBaseFrameKey(joint.id);
+		return evaluate(curFrame, nextFrame, nextFrameFrac);
+	});
+}
 
-		// Apply base frame
-		_skeleton[i].origin = baseKey.origin;
-		_skeleton[i].orientation = baseKey.orientation;
-		
-		// Apply actual frame data
-		const IMD5Anim::FrameKeys& cur = _anim->getFrameKeys(curFrame);
-		const IMD5Anim::FrameKeys& next = _anim->getFrameKeys(nextFrame);
+const MD5Pose& MD5Skeleton::getPose() const
+{
+	static MD5Pose _emptyPose;
+	return _pose ? _pose->matrices : _emptyPose;
+}
 
-		// The joint.firstKey member holds the offset into the frame data array
-		std::size_t key = joint.firstKey;
+MD5AnimPosePtr MD5Skeleton::evaluate(std::size_t curFrame, std::size_t nextFrame, float nextFrameFrac) const
+{
+	std::shared_ptr<MD5AnimPose> pose = std::make_shared<MD5AnimPose>();
+	std::vector<IMD5Anim::Key>& keys = pose->keys;
 
-		// Shortcuts for handling the rotations
-		Quaternion& orientation = _skeleton[i].orientation;
-		Quaternion nextOrientation = baseKey.orientation;
+	std::size_t numJoints = _anim->getNumJoints();
+	keys.resize(numJoints);
 
-		// Animate each vector component, interpolating values in between frames
+	float curFrameFrac = 1.0f - nextFrameFrac;
 
-		if (joint.animComponents & Joint::X)
+	if (_anim->hasDecodedFrames())
+	{
+		// Decoded frames contain the complete joint keys, only the interpolation is left
+		for (std::size_t i = 0; i < numJoints; ++i)
 		{
-			_skeleton[i].origin.x() = cur[key]*curFrameFrac + next[key]*nextFrameFrac;
-			key++;
-		}
+			IMD5Anim::Key cur = _anim->getDecodedKey(curFrame, i);
 
-		if (joint.animComponents & Joint::Y)
-		{
-			_skeleton[i].origin.y() = cur[key]*curFrameFrac + next[key]*nextFrameFrac;
-			key++;
-		}
+			if (nextFrameFrac == 0 || nextFrame == curFrame)
+			{
+				keys[i] = cur;
+				continue;
+			}
 
-		if (joint.animComponents & Joint::Z)
-		{
-			_skeleton[i].origin.z() = cur[key]*curFrameFrac + next[key]*nextFrameFrac;
-			key++;
-		}
+			IMD5Anim::Key next = _anim->getDecodedKey(nextFrame, i);
 
-		if (joint.animComponents & Joint::YAW)
-		{
-			orientation.x() = cur[key];
-			nextOrientation.x() = next[key];
-			key++;
-		}
+			keys[i].origin = cur.origin * curFrameFrac + next.origin * nextFrameFrac;
 
-		if (joint.animComponents & Joint::PITCH)
-		{
-			orientation.y() = cur[key];
-			nextOrientation.y() = next[key];
-			key++;
-		}
+			// Consecutive decoded frames are close and in the same hemisphere,
+			// the normalised linear interpolation is accurate enough and avoids
+			// the trigonometry of slerp()
+			const Quaternion& a = cur.orientation;
+			const Quaternion& b = next.orientation;
 
-		if (joint.animComponents & Joint::ROLL)
-		{
-			orientation.z() = cur[key];
-			nextOrientation.z() = next[key];
-			key++;
+			keys[i].orientation = Quaternion(
+				a.x() * curFrameFrac + b.x() * nextFrameFrac,
+				a.y() * curFrameFrac + b.y() * nextFrameFrac,
+				a.z() * curFrameFrac + b.z() * nextFrameFrac,
+				a.w() * curFrameFrac + b.w() * nextFrameFrac).getNormalised();
 		}
-
-		if (joint.animComponents & (Joint::YAW | Joint::PITCH | Joint::ROLL))
+	}
+	else
+	{
+		// Apply the current frame keys to the base frame
+		for (std::size_t i = 0; i < numJoints; ++i)
 		{
-			float lSq = orientation.getVector3().getLengthSquared();
-			float w = -sqrt(1.0f - lSq);
-
-			orientation.w() = isNaN(w) ? 0 : w;
-
-			lSq = nextOrientation.getVector3().getLengthSquared();
-			w = -sqrt(1.0f - lSq);
+			const Joint& joint = _anim->getJoint(i);
+			const IMD5Anim::Key& baseKey = _anim->getBaseFrameKey(joint.id);
 
-			nextOrientation.w() = isNaN(w) ? 0 : w;
-
-			orientation = slerp(orientation, nextOrientation, nextFrameFrac).getNormalised();
+			// Apply base frame
+			keys[i].origin = baseKey.origin;
+			keys[i].orientation = baseKey.orientation;
+			
+			// Apply actual frame data
+			const IMD5Anim::FrameKeys& cur = _anim->getFrameKeys(curFrame);
+			const IMD5Anim::FrameKeys& next = _anim->getFrameKeys(nextFrame);
+
+			// The joint.firstKey member holds the offset into the frame data array
+			std::size_t key = joint.firstKey;
+
+			// Shortcuts for handling the rotations
+			Quaternion& orientation = keys[i].orientation;
+			Quaternion nextOrientation = baseKey.orientation;
+
+			// Animate each vector component, interpolating values in between frames
+
+			if (joint.animComponents & Joint::X)
+			{
+				keys[i].origin.x() = cur[key]*curFrameFrac + next[key]*nextFrameFrac;
+				key++;
+			}
+
+			if (joint.animComponents & Joint::Y)
+			{
+				keys[i].origin.y() = cur[key]*curFrameFrac + next[key]*nextFrameFrac;
+				key++;
+			}
+
+			if (joint.animComponents & Joint::Z)
+			{
+				keys[i].origin.z() = cur[key]*curFrameFrac + next[key]*nextFrameFrac;
+				key++;
+			}
+
+			if (joint.animComponents & Joint::YAW)
+			{
+				orientation.x() = cur[key];
+				nextOrientation.x() = next[key];
+				key++;
+			}
+
+			if (joint.animComponents & Joint::PITCH)
+			{
+				orientation.y() = cur[key];
+				nextOrientation.y() = next[key];
+				key++;
+			}
+
+			if (joint.animComponents & Joint::ROLL)
+			{
+				orientation.z() = cur[key];
+				nextOrientation.z() = next[key];
+				key++;
+			}
+
+			if (joint.animComponents & (Joint::YAW | Joint::PITCH | Joint::ROLL))
+			{
+				float lSq = orientation.getVector3().getLengthSquared();
+				float w = -sqrt(1.0f - lSq);
+
+				orientation.w() = isNaN(w) ? 0 : w;
+
+				lSq = nextOrientation.getVector3().getLengthSquared();
+				w = -sqrt(1.0f - lSq);
+
+				nextOrientation.w() = isNaN(w) ? 0 : w;
+
+				orientation = slerp(orientation, nextOrientation, nextFrameFrac).getNormalised();
+			}
 		}
 	}
 
+	// Update the joint positions, recursively, starting from the first
+	// Only root nodes need to be processed, the children are reached through them
 	for (std::size_t i = 0; i < numJoints; ++i)
 	{
 		const Joint& joint = _anim->getJoint(i);
 
 		if (joint.parentId == -1)
 		{
-			updateJointRecursively(i);
+			updateJointRecursively(keys, i);
 		}
 	}
+
+	pose->matrices.setFromKeys(keys);
+
+	return pose;
 }
 
-void MD5Skeleton::updateJointRecursively(std::size_t jointId)
+void MD5Skeleton::updateJointRecursively(std::vector<IMD5Anim::Key>& keys, std::size_t jointId) const
 {
 	// Reset info to base first
 	const Joint& joint = _anim->getJoint(jointId);
@@ -188,19 +239,19 @@ void MD5Skeleton::updateJointRecursively(std::size_t jointId)
 	if (joint.parentId >= 0)
 	{
 		// Joint has a parent, update this position and rotation
-		_skeleton[joint.id].orientation.preMultiplyBy(_skeleton[joint.parentId].orientation);
+		keys[joint.id].orientation.preMultiplyBy(keys[joint.parentId].orientation);
 
 		// Transform the origin of this joint using the rotation of the parent joint
-		_skeleton[joint.id].origin = _skeleton[joint.parentId].orientation.transformPoint(_skeleton[joint.id].origin);
+		keys[joint.id].origin = keys[joint.parentId].orientation.transformPoint(keys[joint.id].origin);
 			
 		// Apply the parent joint's translation to this child bone
-		_skeleton[joint.id].origin += _skeleton[joint.parentId].origin;
+		keys[joint.id].origin += keys[joint.parentId].origin;
 	}
 
 	// Update all children as well
 	for (std::vector<int>::const_iterator i = joint.children.begin(); i != joint.children.end(); ++i)
 	{
-		updateJointRecursively(*i);
+		updateJointRecursively(keys, *i);
 	}
 }
 
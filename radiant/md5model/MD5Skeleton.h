@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "imd5anim.h"
+#include "MD5PoseCache.h"
 
 namespace md5
 {
@@ -14,8 +15,9 @@ namespace md5
 class MD5Skeleton
 {
 protected:
-	// The position and orientation of the animated joints at the current time
-	std::vector<IMD5Anim::Key> _skeleton;
+	// The position and orientation of the animated joints at the current time,
+	// shared with the other skeletons playing the same animation
+	MD5AnimPosePtr _pose;
 
 	// The current animation, needed to get joint information etc.
 	IMD5AnimPtr _anim;
@@ -26,12 +28,12 @@ public:
 
 	std::size_t size() const
 	{
-		return _skeleton.size();
+		return _pose ? _pose->keys.size() : 0;
 	}
 
 	const IMD5Anim::Key& getKey(std::size_t jointIndex) const
 	{
-		return _skeleton[jointIndex];
+		return _pose->keys[jointIndex];
 	}
 
 	const Joint& getJoint(std::size_t index) const
@@ -39,8 +41,14 @@ public:
 		return _anim->getJoint(index);
 	}
 
+	// The joint matrices of the current pose, used for skinning
+	const MD5Pose& getPose() const;
+
 private:
-	void updateJointRecursively(std::size_t jointId);
+	// Calculates the pose between the two frames
+	MD5AnimPosePtr evaluate(std::size_t curFrame, std::size_t nextFrame, float nextFrameFrac) const;
+
+	void updateJointRecursively(std::vector<IMD5Anim::Key>& keys, std::size_t jointId) const;
 };
 
 } // namespace
@@ -0,0 +1,516 @@
+#include "MD5Skinning.h"
+
+#include "ithread.h"
+#include "MD5Skeleton.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MD5_SKINNING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace md5
+{
+
+namespace
+{
+	std::atomic<TaskScheduler*> _scheduler(NULL);
+	std::atomic<bool> _vectorised(true);
+
+	// Number of vertices or triangles processed by a single task
+	const std::size_t ITEMS_PER_BLOCK = 2048;
+
+	// Normal, tangent and bitangent of a triangle, each padded to four floats
+	const std::size_t FLOATS_PER_TRIANGLE = 12;
+
+	inline std::size_t getNumBlocks(std::size_t count)
+	{
+		return (count + ITEMS_PER_BLOCK - 1) / ITEMS_PER_BLOCK;
+	}
+
+	// Calls func(block, first, end) for consecutive ranges covering [0, count),
+	// distributed over the worker threads if the mesh is large enough
+	template<typename Func>
+	void forEachBlock(std::size_t count, std::size_t numVertices, const Func& func)
+	{
+		TaskScheduler* scheduler = _scheduler;
+		std::size_t numBlocks = getNumBlocks(count);
+
+		if (scheduler == NULL || numVertices < skinning::MIN_PARALLEL_VERTICES || numBlocks < 2)
+		{
+			for (std::size_t block = 0; block < numBlocks; ++block)
+			{
+				func(block, block * ITEMS_PER_BLOCK, std::min((block + 1) * ITEMS_PER_BLOCK, count));
+			}
+			return;
+		}
+
+		scheduler->parallelFor(numBlocks, [&](std::size_t block)
+		{
+			func(block, block * ITEMS_PER_BLOCK, std::min((block + 1) * ITEMS_PER_BLOCK, count));
+		});
+	}
+
+	// Normalises the given vector, leaving zero vectors untouched
+	inline Vector3 normalised(float x, float y, float z)
+	{
+		float lengthSquared = x * x + y * y + z * z;
+
+		if (lengthSquared <= 0)
+		{
+			return Vector3(0, 0, 0);
+		}
+
+		float invLength = 1.0f / std::sqrt(lengthSquared);
+
+		return Vector3(x * invLength, y * invLength, z * invLength);
+	}
+}
+
+void MD5Pose::setFromJoints(const MD5Joints& joints)
+{
+	_matrices.resize(joints.size() * FLOATS_PER_JOINT);
+
+	for (std::size_t i = 0; i < joints.size(); ++i)
+	{
+		setJoint(i, joints[i].rotation, joints[i].position);
+	}
+}
+
+void MD5Pose::setFromSkeleton(const MD5Skeleton& skeleton)
+{
+	_matrices.resize(skeleton.size() * FLOATS_PER_JOINT);
+
+	for (std::size_t i = 0; i < skeleton.size(); ++i)
+	{
+		const IMD5Anim::Key& key = skeleton.getKey(i);
+		setJoint(i, key.orientation, key.origin);
+	}
+}
+
+void MD5Pose::setFromKeys(const std::vector<IMD5Anim::Key>& keys)
+{
+	_matrices.resize(keys.size() * FLOATS_PER_JOINT);
+
+	for (std::size_t i = 0; i < keys.size(); ++i)
+	{
+		setJoint(i, keys[i].orientation, keys[i].origin);
+	}
+}
+
+void MD5Pose::setJoint(std::size_t joint, const Quaternion& rotation, const Vector3& origin)
+{
+	// The same terms as in Quaternion::transformPoint(), which doesn't
+	// require the quaternion to be normalised
+	double xx = rotation.x() * rotation.x();
+	double yy = rotation.y() * rotation.y();
+	double zz = rotation.z() * rotation.z();
+	double ww = rotation.w() * rotation.w();
+
+	double xy2 = rotation.x() * rotation.y() * 2;
+	double xz2 = rotation.x() * rotation.z() * 2;
+	double xw2 = rotation.x() * rotation.w() * 2;
+	double yz2 = rotation.y() * rotation.z() * 2;
+	double yw2 = rotation.y() * rotation.w() * 2;
+	double zw2 = rotation.z() * rotation.w() * 2;
+
+	const double columns[4][3] =
+	{
+		{ ww + xx - zz - yy, xy2 + zw2, xz2 - yw2 },
+		{ xy2 - zw2, yy - zz + ww - xx, yz2 + xw2 },
+		{ yw2 + xz2, yz2 - xw2, zz - yy - xx + ww },
+		{ origin.x(), origin.y(), origin.z() },
+	};
+
+	float* matrix = _matrices.data() + joint * FLOATS_PER_JOINT;
+
+	for (std::size_t column = 0; column < 4; ++column)
+	{
+		matrix[column * 4 + 0] = static_cast<float>(columns[column][0]);
+		matrix[column * 4 + 1] = static_cast<float>(columns[column][1]);
+		matrix[column * 4 + 2] = static_cast<float>(columns[column][2]);
+		matrix[column * 4 + 3] = 0;
+	}
+}
+
+MD5SkinningData::MD5SkinningData(const MD5Mesh& mesh) :
+	_numVertices(mesh.vertices.size()),
+	_numTriangles(mesh.triangles.size())
+{
+	_firstWeight.reserve(_numVertices + 1);
+	_texcoords.reserve(_numVertices * 2);
+
+	for (const MD5Vert& vert : mesh.vertices)
+	{
+		_firstWeight.push_back(static_cast<unsigned int>(_weight.size()));
+
+		_texcoords.push_back(vert.u);
+		_texcoords.push_back(vert.v);
+
+		for (std::size_t k = 0; k < vert.weight_count; ++k)
+		{
+			std::size_t index = vert.weight_index + k;
+
+			if (index >= mesh.weights.size()) break;
+
+			const MD5Weight& weight = mesh.weights[index];
+
+			_weightX.push_back(static_cast<float>(weight.v.x() * weight.t));
+			_weightY.push_back(static_cast<float>(weight.v.y() * weight.t));
+			_weightZ.push_back(static_cast<float>(weight.v.z() * weight.t));
+			_weight.push_back(weight.t);
+			_weightJoint.push_back(static_cast<unsigned int>(
+				std::min<std::size_t>(weight.joint, std::numeric_limits<unsigned int>::max())));
+		}
+	}
+
+	_firstWeight.push_back(static_cast<unsigned int>(_weight.size()));
+
+	// Triangles and the texture space of each of them
+	_indices.reserve(_numTriangles * 3);
+	_tangentFactors.reserve(_numTriangles * 4);
+
+	std::vector<unsigned int> numVertexTriangles(_numVertices, 0);
+
+	for (const MD5Tri& tri : mesh.triangles)
+	{
+		std::size_t corners[3] = { tri.a, tri.b, tri.c };
+
+		for (std::size_t& corner : corners)
+		{
+			// Point invalid indices to the first vertex instead of reading out of bounds
+			if (corner >= _numVertices) corner = 0;
+
+			_indices.push_back(static_cast<unsigned int>(corner));
+
+			if (_numVertices > 0)
+			{
+				++numVertexTriangles[corner];
+			}
+		}
+
+		if (_numVertices == 0)
+		{
+			_tangentFactors.insert(_tangentFactors.end(), 4, 0.0f);
+			continue;
+		}
+
+		const float* a = &_texcoords[corners[0] * 2];
+		const float* b = &_texcoords[corners[1] * 2];
+		const float* c = &_texcoords[corners[2] * 2];
+
+		float du1 = b[0] - a[0];
+		float dv1 = b[1] - a[1];
+		float du2 = c[0] - a[0];
+		float dv2 = c[1] - a[1];
+
+		// Degenerate texture coordinates don't contribute to the tangents
+		float determinant = du1 * dv2 - dv1 * du2;
+		float invDeterminant = std::abs(determinant) > 0.000001f ? 1.0f / determinant : 0.0f;
+
+		_tangentFactors.push_back(du1 * invDeterminant);
+		_tangentFactors.push_back(dv1 * invDeterminant);
+		_tangentFactors.push_back(du2 * invDeterminant);
+		_tangentFactors.push_back(dv2 * invDeterminant);
+	}
+
+	// The triangles using each vertex, a triangle is listed once per corner
+	_firstTriangle.resize(_numVertices + 1, 0);
+
+	for (std::size_t i = 0; i < _numVertices; ++i)
+	{
+		_firstTriangle[i + 1] = _firstTriangle[i] + numVertexTriangles[i];
+	}
+
+	_vertexTriangles.resize(_numVertices > 0 ? _firstTriangle[_numVertices] : 0);
+
+	std::vector<unsigned int> fill(_firstTriangle.begin(), _firstTriangle.end() - (_numVertices > 0 ? 1 : 0));
+
+	for (std::size_t i = 0; _numVertices > 0 && i < _indices.size(); ++i)
+	{
+		_vertexTriangles[fill[_indices[i]]++] = static_cast<unsigned int>(i / 3);
+	}
+}
+
+void MD5SkinningData::skinVertices(const MD5Pose& pose, float* positions, float* blockBounds,
+								   std::size_t first, std::size_t end) const
+{
+	const std::size_t numJoints = pose.getNumJoints();
+	const float* matrices = pose.getMatrix(0);
+
+#ifdef MD5_SKINNING_SSE2
+	if (_vectorised)
+	{
+		__m128 minimum = _mm_set1_ps(std::numeric_limits<float>::max());
+		__m128 maximum = _mm_set1_ps(-std::numeric_limits<float>::max());
+
+		for (std::size_t i = first; i < end; ++i)
+		{
+			__m128 sum = _mm_setzero_ps();
+
+			for (std::size_t w = _firstWeight[i]; w < _firstWeight[i + 1]; ++w)
+			{
+				std::size_t joint = _weightJoint[w];
+
+				if (joint >= numJoints) continue;
+
+				const float* matrix = matrices + joint * MD5Pose::FLOATS_PER_JOINT;
+
+				__m128 xy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(matrix), _mm_set1_ps(_weightX[w])),
+									   _mm_mul_ps(_mm_loadu_ps(matrix + 4), _mm_set1_ps(_weightY[w])));
+				__m128 zt = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(matrix + 8), _mm_set1_ps(_weightZ[w])),
+									   _mm_mul_ps(_mm_loadu_ps(matrix + 12), _mm_set1_ps(_weight[w])));
+
+				sum = _mm_add_ps(sum, _mm_add_ps(xy, zt));
+			}
+
+			_mm_storeu_ps(positions + i * 4, sum);
+
+			minimum = _mm_min_ps(minimum, sum);
+			maximum = _mm_max_ps(maximum, sum);
+		}
+
+		float bounds[8];
+		_mm_storeu_ps(bounds, minimum);
+		_mm_storeu_ps(bounds + 4, maximum);
+
+		std::copy(bounds, bounds + 3, blockBounds);
+		std::copy(bounds + 4, bounds + 7, blockBounds + 3);
+		return;
+	}
+#endif
+
+	float minimum[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	float maximum[3] = { -minimum[0], -minimum[1], -minimum[2] };
+
+	for (std::size_t i = first; i < end; ++i)
+	{
+		float sum[3] = { 0, 0, 0 };
+
+		for (std::size_t w = _firstWeight[i]; w < _firstWeight[i + 1]; ++w)
+		{
+			std::size_t joint = _weightJoint[w];
+
+			if (joint >= numJoints) continue;
+
+			const float* matrix = matrices + joint * MD5Pose::FLOATS_PER_JOINT;
+
+			for (std::size_t c = 0; c < 3; ++c)
+			{
+				sum[c] += (matrix[c] * _weightX[w] + matrix[4 + c] * _weightY[w]) +
+					(matrix[8 + c] * _weightZ[w] + matrix[12 + c] * _weight[w]);
+			}
+		}
+
+		for (std::size_t c = 0; c < 3; ++c)
+		{
+			positions[i * 4 + c] = sum[c];
+			minimum[c] = std::min(minimum[c], sum[c]);
+			maximum[c] = std::max(maximum[c], sum[c]);
+		}
+
+		positions[i * 4 + 3] = 0;
+	}
+
+	std::copy(minimum, minimum + 3, blockBounds);
+	std::copy(maximum, maximum + 3, blockBounds + 3);
+}
+
+void MD5SkinningData::calculateTriangleVectors(const float* positions, float* triangleVectors,
+											   std::size_t first, std::size_t end) const
+{
+#ifdef MD5_SKINNING_SSE2
+	if (_vectorised)
+	{
+		for (std::size_t t = first; t < end; ++t)
+		{
+			__m128 a = _mm_loadu_ps(positions + _indices[t * 3 + 0] * 4);
+			__m128 e1 = _mm_sub_ps(_mm_loadu_ps(positions + _indices[t * 3 + 1] * 4), a);
+			__m128 e2 = _mm_sub_ps(_mm_loadu_ps(positions + _indices[t * 3 + 2] * 4), a);
+
+			const float* factors = &_tangentFactors[t * 4];
+			float* out = triangleVectors + t * FLOATS_PER_TRIANGLE;
+
+			// The area weighted normal (c-a) x (b-a), the fourth lanes are zero
+			__m128 e1yzx = _mm_shuffle_ps(e1, e1, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 e2yzx = _mm_shuffle_ps(e2, e2, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 normal = _mm_sub_ps(_mm_mul_ps(e2, e1yzx), _mm_mul_ps(e2yzx, e1));
+
+			_mm_storeu_ps(out, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(3, 0, 2, 1)));
+			_mm_storeu_ps(out + 4, _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(factors[3]), e1),
+											  _mm_mul_ps(_mm_set1_ps(factors[1]), e2)));
+			_mm_storeu_ps(out + 8, _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(factors[0]), e2),
+											  _mm_mul_ps(_mm_set1_ps(factors[2]), e1)));
+		}
+
+		return;
+	}
+#endif
+
+	for (std::size_t t = first; t < end; ++t)
+	{
+		const float* a = positions + _indices[t * 3 + 0] * 4;
+		const float* b = positions + _indices[t * 3 + 1] * 4;
+		const float* c = positions + _indices[t * 3 + 2] * 4;
+
+		float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+		const float* factors = &_tangentFactors[t * 4];
+		float* out = triangleVectors + t * FLOATS_PER_TRIANGLE;
+
+		// The area weighted normal (c-a) x (b-a)
+		out[0] = e2[1] * e1[2] - e2[2] * e1[1];
+		out[1] = e2[2] * e1[0] - e2[0] * e1[2];
+		out[2] = e2[0] * e1[1] - e2[1] * e1[0];
+
+		// Tangent and bitangent, see ArbitraryMeshTriangle_calcTangents()
+		for (std::size_t k = 0; k < 3; ++k)
+		{
+			out[4 + k] = factors[3] * e1[k] - factors[1] * e2[k];
+			out[8 + k] = factors[0] * e2[k] - factors[2] * e1[k];
+		}
+
+		out[3] = out[7] = out[11] = 0;
+	}
+}
+
+void MD5SkinningData::gatherVertices(const float* positions, const float* triangleVectors,
+									 std::vector<ArbitraryMeshVertex>& vertices,
+									 std::size_t first, std::size_t end) const
+{
+	for (std::size_t i = first; i < end; ++i)
+	{
+		float sums[FLOATS_PER_TRIANGLE];
+
+#ifdef MD5_SKINNING_SSE2
+		if (_vectorised)
+		{
+			__m128 normal = _mm_setzero_ps();
+			__m128 tangent = _mm_setzero_ps();
+			__m128 bitangent = _mm_setzero_ps();
+
+			for (std::size_t j = _firstTriangle[i]; j < _firstTriangle[i + 1]; ++j)
+			{
+				const float* vectors = triangleVectors + _vertexTriangles[j] * FLOATS_PER_TRIANGLE;
+
+				normal = _mm_add_ps(normal, _mm_loadu_ps(vectors));
+				tangent = _mm_add_ps(tangent, _mm_loadu_ps(vectors + 4));
+				bitangent = _mm_add_ps(bitangent, _mm_loadu_ps(vectors + 8));
+			}
+
+			_mm_storeu_ps(sums, normal);
+			_mm_storeu_ps(sums + 4, tangent);
+			_mm_storeu_ps(sums + 8, bitangent);
+		}
+		else
+#endif
+		{
+			std::fill(sums, sums + FLOATS_PER_TRIANGLE, 0.0f);
+
+			for (std::size_t j = _firstTriangle[i]; j < _firstTriangle[i + 1]; ++j)
+			{
+				const float* vectors = triangleVectors + _vertexTriangles[j] * FLOATS_PER_TRIANGLE;
+
+				for (std::size_t k = 0; k < FLOATS_PER_TRIANGLE; ++k)
+				{
+					sums[k] += vectors[k];
+				}
+			}
+		}
+
+		ArbitraryMeshVertex& vertex = vertices[i];
+
+		vertex.vertex = Vertex3f(positions[i * 4], positions[i * 4 + 1], positions[i * 4 + 2]);
+		vertex.texcoord = TexCoord2f(_texcoords[i * 2], _texcoords[i * 2 + 1]);
+		vertex.normal = Normal3f(normalised(sums[0], sums[1], sums[2]));
+		vertex.tangent = Normal3f(normalised(sums[4], sums[5], sums[6]));
+		vertex.bitangent = Normal3f(normalised(sums[8], sums[9], sums[10]));
+	}
+}
+
+void MD5SkinningData::skin(const MD5Pose& pose, MD5SkinningBuffers& buffers,
+						   std::vector<ArbitraryMeshVertex>& vertices, AABB& bounds) const
+{
+	if (vertices.size() != _numVertices)
+	{
+		vertices.resize(_numVertices);
+	}
+
+	bounds = AABB();
+
+	if (_numVertices == 0) return;
+
+	buffers.positions.resize(_numVertices * 4);
+	buffers.triangleVectors.resize(_numTriangles * FLOATS_PER_TRIANGLE);
+	buffers.blockBounds.resize(getNumBlocks(_numVertices) * 6);
+
+	float* positions = buffers.positions.data();
+	float* triangleVectors = buffers.triangleVectors.data();
+	float* blockBounds = buffers.blockBounds.data();
+
+	forEachBlock(_numVertices, _numVertices, [&](std::size_t block, std::size_t first, std::size_t end)
+	{
+		skinVertices(pose, positions, blockBounds + block * 6, first, end);
+	});
+
+	forEachBlock(_numTriangles, _numVertices, [&](std::size_t, std::size_t first, std::size_t end)
+	{
+		calculateTriangleVectors(positions, triangleVectors, first, end);
+	});
+
+	forEachBlock(_numVertices, _numVertices, [&](std::size_t, std::size_t first, std::size_t end)
+	{
+		gatherVertices(positions, triangleVectors, vertices, first, end);
+	});
+
+	// Merge the bounds of the blocks
+	Vector3 minimum(blockBounds[0], blockBounds[1], blockBounds[2]);
+	Vector3 maximum(blockBounds[3], blockBounds[4], blockBounds[5]);
+
+	for (std::size_t block = 1; block < buffers.blockBounds.size() / 6; ++block)
+	{
+		for (std::size_t c = 0; c < 3; ++c)
+		{
+			minimum[c] = std::min<double>(minimum[c], blockBounds[block * 6 + c]);
+			maximum[c] = std::max<double>(maximum[c], blockBounds[block * 6 + 3 + c]);
+		}
+	}
+
+	bounds = AABB::createFromMinMax(minimum, maximum);
+}
+
+namespace skinning
+{
+
+void setTaskScheduler(TaskScheduler* scheduler)
+{
+	_scheduler = scheduler;
+}
+
+TaskScheduler* getTaskScheduler()
+{
+	return _scheduler;
+}
+
+void setVectorised(bool vectorised)
+{
+	_vectorised = vectorised;
+}
+
+bool isVectorised()
+{
+#ifdef MD5_SKINNING_SSE2
+	return _vectorised;
+#else
+	return false;
+#endif
+}
+
+} // namespace
+
+} // namespace
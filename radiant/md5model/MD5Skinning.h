@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "math/AABB.h"
+#include "render/ArbitraryMeshVertex.h"
+#include "imd5anim.h"
+#include "MD5DataStructures.h"
+
+class TaskScheduler;
+
+namespace md5
+{
+
+class MD5Skeleton;
+
+/**
+ * The joint transforms of a skeleton pose as 3x4 float matrices, which
+ * are shared by all surfaces of a model. The quaternions are expanded
+ * only once per joint instead of once per vertex weight.
+ */
+class MD5Pose
+{
+public:
+	// Each joint uses the three rotation columns followed by the translation,
+	// every column is padded to four floats
+	static const std::size_t FLOATS_PER_JOINT = 16;
+
+private:
+	std::vector<float> _matrices;
+
+public:
+	/// Set up the pose defined by the joints of the .md5mesh file
+	void setFromJoints(const MD5Joints& joints);
+
+	/// Set up the current pose of the given animated skeleton
+	void setFromSkeleton(const MD5Skeleton& skeleton);
+
+	/// Set up the pose from the given model space joint keys
+	void setFromKeys(const std::vector<IMD5Anim::Key>& keys);
+
+	std::size_t getNumJoints() const
+	{
+		return _matrices.size() / FLOATS_PER_JOINT;
+	}
+
+	const float* getMatrix(std::size_t joint) const
+	{
+		return _matrices.data() + joint * FLOATS_PER_JOINT;
+	}
+
+private:
+	void setJoint(std::size_t joint, const Quaternion& rotation, const Vector3& origin);
+};
+
+/**
+ * Scratch memory used while skinning a surface. Every surface owns its
+ * buffers, which allows for skinning several surfaces at the same time.
+ */
+struct MD5SkinningBuffers
+{
+	// Four floats per vertex
+	std::vector<float> positions;
+
+	// Normal, tangent and bitangent of each triangle
+	std::vector<float> triangleVectors;
+
+	// Minimum and maximum of each block of vertices
+	std::vector<float> blockBounds;
+};
+
+/**
+ * The bind pose data of an MD5 mesh, rearranged for skinning.
+ *
+ * The weights are stored as struct of arrays in float precision, with the
+ * offsets already multiplied by the weight. The per-triangle texture
+ * coordinate deltas needed for the tangents don't change between frames
+ * and are calculated once, as is the list of triangles using each vertex.
+ * This allows the normals to be gathered per vertex, such that large
+ * meshes can be split into blocks processed by the worker threads.
+ */
+class MD5SkinningData
+{
+private:
+	std::size_t _numVertices;
+	std::size_t _numTriangles;
+
+	// The weights of vertex i are in the range [_firstWeight[i], _firstWeight[i+1])
+	std::vector<unsigned int> _firstWeight;
+
+	std::vector<float> _weightX;
+	std::vector<float> _weightY;
+	std::vector<float> _weightZ;
+	std::vector<float> _weight;
+	std::vector<unsigned int> _weightJoint;
+
+	std::vector<float> _texcoords;
+
+	// Three vertex indices per triangle
+	std::vector<unsigned int> _indices;
+
+	// Texture coordinate deltas of the triangle edges, divided by their determinant
+	std::vector<float> _tangentFactors;
+
+	// The triangles using vertex i are in the range [_firstTriangle[i], _firstTriangle[i+1])
+	std::vector<unsigned int> _firstTriangle;
+	std::vector<unsigned int> _vertexTriangles;
+
+public:
+	MD5SkinningData(const MD5Mesh& mesh);
+
+	std::size_t getNumVertices() const
+	{
+		return _numVertices;
+	}
+
+	std::size_t getNumTriangles() const
+	{
+		return _numTriangles;
+	}
+
+	std::size_t getNumWeights() const
+	{
+		return _weight.size();
+	}
+
+	/**
+	 * Deform the mesh to the given pose, writing the positions, texture
+	 * coordinates, normals and tangents of the vertices, which are resized
+	 * if necessary. The bounds are set to the extents of the skinned mesh.
+	 *
+	 * Weights referring to joints missing in the pose are ignored.
+	 */
+	void skin(const MD5Pose& pose, MD5SkinningBuffers& buffers,
+			  std::vector<ArbitraryMeshVertex>& vertices, AABB& bounds) const;
+
+private:
+	void skinVertices(const MD5Pose& pose, float* positions, float* blockBounds,
+					  std::size_t first, std::size_t end) const;
+	void calculateTriangleVectors(const float* positions, float* triangleVectors,
+								  std::size_t first, std::size_t end) const;
+	void gatherVertices(const float* positions, const float* triangleVectors,
+						std::vector<ArbitraryMeshVertex>& vertices,
+						std::size_t first, std::size_t end) const;
+};
+typedef std::shared_ptr<const MD5SkinningData> MD5SkinningDataPtr;
+
+namespace skinning
+{
+
+/// Meshes with fewer vertices are skinned on the calling thread
+const std::size_t MIN_PARALLEL_VERTICES = 4096;
+
+/// Set the scheduler used to split large meshes, NULL to skin all
+/// meshes on the calling thread
+void setTaskScheduler(TaskScheduler* scheduler);
+
+TaskScheduler* getTaskScheduler();
+
+/// Switch between the SSE2 and the plain float path (used for testing),
+/// the SSE2 path is only available if the build supports it
+void setVectorised(bool vectorised);
+
+bool isVectorised();
+
+} // namespace
+
+} // namespace
@@ -1,9 +1,9 @@
 #include "MD5Surface.h"
 
 #include "ivolumetest.h"
-#include "GLProgramAttributes.h"
 #include "string/convert.h"
 #include "MD5Model.h"
+#include "MD5Skeleton.h"
 #include "math/Ray.h"
 
 namespace md5
@@ -18,139 +18,81 @@ inline VertexPointer vertexpointer_arbitrarymeshvertex(const ArbitraryMeshVertex
 MD5Surface::MD5Surface() : 
 	_originalShaderName(""),
 	_mesh(new MD5Mesh),
-	_normalList(0),
-	_lightingList(0)
+	_meshBuffer(render::MeshBufferPool::INVALID_HANDLE)
 {}
 
 MD5Surface::MD5Surface(const MD5Surface& other) :
 	_aabb_local(other._aabb_local),
 	_originalShaderName(other._originalShaderName),
 	_mesh(other._mesh),
-	_normalList(0),
-	_lightingList(0)
+	_skinningData(other._skinningData),
+	_meshBuffer(render::MeshBufferPool::INVALID_HANDLE)
 {}
 
 // Destructor
 MD5Surface::~MD5Surface()
 {
-    releaseDisplayLists();
+    releaseMeshBuffer();
 }
 
 // Update geometry
 void MD5Surface::updateGeometry()
 {
-	_aabb_local = AABB();
-
-	for (Vertices::const_iterator i = _vertices.begin(); i != _vertices.end(); ++i)
-	{
-		_aabb_local.includePoint(i->vertex);
-	}
+	// Store the geometry for rendering
+	updateMeshBuffer();
+}
 
-	for (Indices::iterator i = _indices.begin();
-		 i != _indices.end();
-		 i += 3)
+// Back-end render
+void MD5Surface::render(const RenderInfo& info) const
+{
+	if (_meshBuffer == render::MeshBufferPool::INVALID_HANDLE)
 	{
-		ArbitraryMeshVertex& a = _vertices[*(i + 0)];
-		ArbitraryMeshVertex& b = _vertices[*(i + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(i + 2)];
-
-		ArbitraryMeshTriangle_sumTangents(a, b, c);
+		return;
 	}
 
-	for (Vertices::iterator i = _vertices.begin();
-		 i != _vertices.end();
-		 ++i)
-	{
-		i->tangent.normalise();
-		i->bitangent.normalise();
-	}
+	render::MeshBufferPool& pool = render::MeshBufferPool::Instance();
 
-	// Build the display lists
-	createDisplayLists();
+	pool.beginDraw(info.getFlags());
+	pool.draw(_meshBuffer);
+	pool.endDraw();
 }
 
-// Back-end render
-void MD5Surface::render(const RenderInfo& info) const
+render::MeshBufferPool::Handle MD5Surface::getPooledMesh() const
 {
-	if (info.checkFlag(RENDER_BUMP))
-    {
-		glCallList(_lightingList);
-	}
-	else
-    {
-		glCallList(_normalList);
-	}
+	return _meshBuffer;
 }
 
-// Construct the display lists
-void MD5Surface::createDisplayLists()
+std::size_t MD5Surface::getRenderMemoryUsage() const
 {
-    // Release old display lists first
-    releaseDisplayLists();
+	return _meshBuffer != render::MeshBufferPool::INVALID_HANDLE ?
+		render::MeshBufferPool::Instance().getMemoryUsage(_meshBuffer) : 0;
+}
 
-	// Create the list for lighting mode
-	_lightingList = glGenLists(1);
-	assert(_lightingList != 0);
-	glNewList(_lightingList, GL_COMPILE);
+void MD5Surface::updateMeshBuffer()
+{
+	render::MeshBufferPool& pool = render::MeshBufferPool::Instance();
 
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+	// Animated meshes keep their vertex count, only the positions are replaced
+	if (_meshBuffer != render::MeshBufferPool::INVALID_HANDLE &&
+		pool.getMesh(_meshBuffer).numVertices == _vertices.size() &&
+		pool.getMesh(_meshBuffer).numIndices == _indices.size())
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
-
-		// Submit the vertex attributes and coordinate
-		if (GLEW_ARB_vertex_program) {
-			// Submit the vertex attributes and coordinate
-			glVertexAttrib2dvARB(ATTR_TEXCOORD, v.texcoord);
-			glVertexAttrib3dvARB(ATTR_TANGENT, v.tangent);
-			glVertexAttrib3dvARB(ATTR_BITANGENT, v.bitangent);
-			glVertexAttrib3dvARB(ATTR_NORMAL, v.normal);
-		}
-		glVertex3dv(v.vertex);
+		pool.updateVertices(_meshBuffer, _vertices);
+		return;
 	}
-	glEnd();
-
-	glEndList();
 
-	// Generate the list for flat-shaded (unlit) mode
-	_normalList = glGenLists(1);
-	assert(_normalList != 0);
-	glNewList(_normalList, GL_COMPILE);
+	releaseMeshBuffer();
 
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
-	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
-
-		// Submit attributes
-		glNormal3dv(v.normal);
-		glTexCoord2dv(v.texcoord);
-		glVertex3dv(v.vertex);
-	}
-	glEnd();
-
-	glEndList();
+	// MD5 meshes don't define vertex colours
+	_meshBuffer = pool.allocate(_vertices, _indices, false);
 }
 
-void MD5Surface::releaseDisplayLists()
+void MD5Surface::releaseMeshBuffer()
 {
-    // Release GL display lists if applicable
-    if (_normalList != 0)
+    if (_meshBuffer != render::MeshBufferPool::INVALID_HANDLE)
     {
-        glDeleteLists(_normalList, 1);
-        _normalList = 0;
-    }
-
-    if (_lightingList != 0)
-    {
-        glDeleteLists(_lightingList, 1);
-        _lightingList = 0;
+        render::MeshBufferPool::Instance().release(_meshBuffer);
+        _meshBuffer = render::MeshBufferPool::INVALID_HANDLE;
     }
 }
 
@@ -279,103 +221,34 @@ void MD5Surface::setActiveMaterial(const std::string& activeMaterial)
 
 void MD5Surface::updateToDefaultPose(const MD5Joints& joints)
 {
-	if (_vertices.size() != _mesh->vertices.size())
-	{
-		_vertices.resize(_mesh->vertices.size());
-	}
-
-	for (std::size_t j = 0; j < _mesh->vertices.size(); ++j)
-	{
-		MD5Vert& vert = _mesh->vertices[j];
-
-		Vector3 skinned(0, 0, 0);
-
-		for (std::size_t k = 0; k != vert.weight_count; ++k)
-		{
-			MD5Weight& weight = _mesh->weights[vert.weight_index + k];
-			const MD5Joint& joint = joints[weight.joint];
-
-			Vector3 rotatedPoint = joint.rotation.transformPoint(weight.v);
-			skinned += (rotatedPoint + joint.position) * weight.t;
-		}
-
-		_vertices[j].vertex = skinned;
-		_vertices[j].texcoord = TexCoord2f(vert.u, vert.v);
-		_vertices[j].normal = Normal3f(0,0,0);
-	}
-
-	// Ensure the index array is ok
-	if (_indices.empty())
-	{
-		buildIndexArray();
-	}
-
-	buildVertexNormals();
+	MD5Pose pose;
+	pose.setFromJoints(joints);
 
+	updateToPose(pose);
 	updateGeometry();
 }
 
 void MD5Surface::updateToSkeleton(const MD5Skeleton& skeleton)
 {
-	// Ensure we have all vertices allocated
-	if (_vertices.size() != _mesh->vertices.size())
-	{
-		_vertices.resize(_mesh->vertices.size());
-	}
-
-	// Deform vertices to fit the skeleton
-	for (std::size_t j = 0; j < _mesh->vertices.size(); ++j)
-	{
-		MD5Vert& vert = _mesh->vertices[j];
-
-		Vector3 skinned(0, 0, 0);
-
-		for (std::size_t k = 0; k != vert.weight_count; ++k)
-		{
-			MD5Weight& weight = _mesh->weights[vert.weight_index + k];
-			const IMD5Anim::Key& key = skeleton.getKey(weight.joint);
-			//const Joint& joint = skeleton.getJoint(weight.joint);
-
-			Vector3 rotatedPoint = key.orientation.transformPoint(weight.v);
-			skinned += (rotatedPoint + key.origin) * weight.t;
-		}
-
-		_vertices[j].vertex = skinned;
-		_vertices[j].texcoord = TexCoord2f(vert.u, vert.v);
-		_vertices[j].normal = Normal3f(0,0,0);
-	}
-    
-	// Ensure the index array is ok
-	if (_indices.empty())
-	{
-		buildIndexArray();
-	}
-
-	buildVertexNormals();
-
+	updateToPose(skeleton.getPose());
 	updateGeometry();
 }
 
-void MD5Surface::buildVertexNormals()
+void MD5Surface::updateToPose(const MD5Pose& pose)
 {
-	for (Indices::iterator j = _indices.begin(); j != _indices.end(); j += 3)
+	// Surfaces which haven't been parsed prepare their (empty) mesh on first use
+	if (!_skinningData)
 	{
-		ArbitraryMeshVertex& a = _vertices[*(j + 0)];
-		ArbitraryMeshVertex& b = _vertices[*(j + 1)];
-		ArbitraryMeshVertex& c = _vertices[*(j + 2)];
-
-		Vector3 weightedNormal((c.vertex - a.vertex).crossProduct(b.vertex - a.vertex));
-
-		a.normal += weightedNormal;
-		b.normal += weightedNormal;
-		c.normal += weightedNormal;
+		_skinningData = std::make_shared<MD5SkinningData>(*_mesh);
 	}
 
-	// Normalise all normal vectors
-	for (Vertices::iterator j = _vertices.begin(); j != _vertices.end(); ++j)
+	// Ensure the index array is ok
+	if (_indices.empty())
 	{
-		j->normal = Normal3f(j->normal.getNormalised());
+		buildIndexArray();
 	}
+
+	_skinningData->skin(pose, _skinningBuffers, _vertices, _aabb_local);
 }
 
 void MD5Surface::buildIndexArray()
@@ -487,6 +360,9 @@ void MD5Surface::parseFromTokens(parser::DefTokeniser& tok)
 	// ----- END OF MESH DECL -----
 
 	tok.assertNextToken("}");
+
+	// Rearrange the weights for skinning, this is shared by all copies of this surface
+	_skinningData = std::make_shared<MD5SkinningData>(mesh);
 }
 
 } // namespace md5
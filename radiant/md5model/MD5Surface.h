@@ -8,8 +8,10 @@
 #include "iselectiontest.h"
 #include "modelskin.h"
 #include "imodelsurface.h"
+#include "render/MeshBufferPool.h"
 
 #include "MD5DataStructures.h"
+#include "MD5Skinning.h"
 #include "parser/DefTokeniser.h"
 
 class Ray;
@@ -21,7 +23,8 @@ class MD5Skeleton;
 
 class MD5Surface :
 	public model::IIndexedModelSurface,
-	public OpenGLRenderable
+	public OpenGLRenderable,
+	public render::IPooledMesh
 {
 public:
 	typedef std::vector<ArbitraryMeshVertex> Vertices;
@@ -40,24 +43,24 @@ private:
 	// Several MD5Surfaces can share the same mesh
 	MD5MeshPtr _mesh;
 
+	// The weights of the mesh prepared for skinning, shared like the mesh
+	MD5SkinningDataPtr _skinningData;
+	MD5SkinningBuffers _skinningBuffers;
+
 	// Our render data
 	Vertices _vertices;
 	Indices _indices;
 
-	// The GL display lists for this surface's geometry
-	GLuint _normalList;
-	GLuint _lightingList;
+	// The geometry of this surface in the shared mesh buffers
+	render::MeshBufferPool::Handle _meshBuffer;
 
 private:
 
-	// Create the display lists
-	void createDisplayLists();
-
-    // Frees any display list in use
-    void releaseDisplayLists();
+	// Copy the geometry to the shared mesh buffers
+	void updateMeshBuffer();
 
-	// Re-calculate the normal vectors
-	void buildVertexNormals();
+    // Frees the mesh buffer ranges in use
+    void releaseMeshBuffer();
 
 public:
 
@@ -80,7 +83,8 @@ public:
 	void setDefaultMaterial(const std::string& name);
 	
 	/**
-	 * Calculate the AABB and build the display lists for rendering.
+	 * Update the mesh buffers for rendering, after the vertices have been
+	 * deformed by updateToPose().
 	 */
 	void updateGeometry();
 
@@ -91,12 +95,23 @@ public:
 	// Updates this mesh to the state of the given skeleton
 	void updateToSkeleton(const MD5Skeleton& skeleton);
 
+	// Deforms the vertices and calculates the normals, tangents and the AABB,
+	// without touching the mesh buffers. Different surfaces can be updated
+	// at the same time, call updateGeometry() afterwards.
+	void updateToPose(const MD5Pose& pose);
+
 	// Applies the given Skin to this surface.
 	void applySkin(const ModelSkin& skin);
 
     // Back-end render function
     void render(const RenderInfo& info) const;
 
+	// IPooledMesh implementation
+	render::MeshBufferPool::Handle getPooledMesh() const override;
+
+	// The number of bytes the geometry occupies in the mesh buffers
+	std::size_t getRenderMemoryUsage() const;
+
 	const AABB& localAABB() const;
 
 	// Test for selection
@@ -1,7 +1,10 @@
 #include "imodule.h"
+#include "iradiant.h"
+#include "ithread.h"
 
 #include "MD5ModelLoader.h"
 #include "MD5AnimationCache.h"
+#include "MD5Skinning.h"
 
 #include "modulesystem/StaticModule.h"
 
@@ -26,6 +29,7 @@ public:
 		if (_dependencies.empty())
 		{
 			_dependencies.insert(MODULE_MODELFORMATMANAGER);
+			_dependencies.insert(MODULE_RADIANT);
 		}
 
 		return _dependencies;
@@ -34,6 +38,14 @@ public:
 	void initialiseModule(const ApplicationContext& ctx)
 	{
 		GlobalModelFormatManager().registerImporter(std::make_shared<md5::MD5ModelLoader>());
+
+		// Large meshes and models with many surfaces are skinned by the worker threads
+		skinning::setTaskScheduler(&GlobalRadiant().getThreadManager().getTaskScheduler());
+	}
+
+	void shutdownModule()
+	{
+		skinning::setTaskScheduler(NULL);
 	}
 };
 
@@ -51,6 +51,17 @@ scene::INodePtr ModelCache::getModelNode(const std::string& modelPath)
 	// Get a suitable model loader
 	IModelImporterPtr modelLoader = GlobalModelFormatManager().getImporter(type);
 
+	if (modelDef)
+	{
+		// Let the idle animation be parsed by a worker while the mesh is loaded
+		IModelDef::Anims::const_iterator idle = modelDef->anims.find("idle");
+
+		if (idle != modelDef->anims.end())
+		{
+			GlobalAnimationCache().prefetchAnim(idle->second);
+		}
+	}
+
 	// Try to construct a model node using the suitable loader
 	scene::INodePtr node = modelLoader->loadModel(actualModelPath);
 
@@ -87,6 +87,10 @@ int NullModel::getPolyCount() const {
 	return 0;
 }
 
+std::size_t NullModel::getRenderMemoryUsage() const {
+	return 0;
+}
+
 const IModelSurface& NullModel::getSurface(unsigned surfaceNum) const
 {
 	throw new std::runtime_error("NullModel::getSurface: invalid call, no surfaces.");
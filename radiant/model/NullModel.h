@@ -40,6 +40,7 @@ public:
 	virtual int getSurfaceCount() const;
 	virtual int getVertexCount() const;
 	virtual int getPolyCount() const;
+	virtual std::size_t getRenderMemoryUsage() const;
 	virtual const IModelSurface& getSurface(unsigned surfaceNum) const;
 
 	virtual const std::vector<std::string>& getActiveMaterials() const;
@@ -94,6 +94,11 @@ bool PicoModelNode::intersectsLight(const RendererLight& light) const
 	return light.intersectsAABB(worldAABB());
 }
 
+const AABB& PicoModelNode::getLitObjectAABB() const
+{
+	return worldAABB();
+}
+
 // Add a light to this model instance
 void PicoModelNode::insertLight(const RendererLight& light)
 {
@@ -207,6 +207,18 @@ int RenderablePicoModel::getPolyCount() const
 	return sum;
 }
 
+std::size_t RenderablePicoModel::getRenderMemoryUsage() const
+{
+	std::size_t sum = 0;
+
+	for (const Surface& s : _surfVec)
+	{
+		sum += s.surface->getRenderMemoryUsage();
+	}
+
+	return sum;
+}
+
 const IModelSurface& RenderablePicoModel::getSurface(unsigned surfaceNum) const
 {
 	assert(surfaceNum >= 0 && surfaceNum < _surfVec.size());
@@ -157,6 +157,7 @@ public:
 	 */
 
 	int getPolyCount() const override;
+	std::size_t getRenderMemoryUsage() const override;
 
 	const IModelSurface& getSurface(unsigned surfaceNum) const override;
 
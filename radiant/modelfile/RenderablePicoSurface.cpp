@@ -15,9 +15,7 @@ namespace model {
 RenderablePicoSurface::RenderablePicoSurface(picoSurface_t* surf,
 											 const std::string& fExt)
 : _defaultMaterial(""),
-  _dlRegular(0),
-  _dlProgramVcol(0),
-  _dlProgramNoVCol(0)
+  _mesh(render::MeshBufferPool::INVALID_HANDLE)
 {
 	// Get the shader from the picomodel struct. If this is a LWO model, use
 	// the material name to select the shader, while for an ASE model the
@@ -90,8 +88,8 @@ RenderablePicoSurface::RenderablePicoSurface(picoSurface_t* surf,
 	// Calculate the tangent and bitangent vectors
 	calculateTangents();
 
-	// Construct the DLs
-	createDisplayLists();
+	// Store the geometry for rendering
+	updateMeshBuffer();
 }
 
 RenderablePicoSurface::RenderablePicoSurface(const RenderablePicoSurface& other) :
@@ -100,11 +98,9 @@ RenderablePicoSurface::RenderablePicoSurface(const RenderablePicoSurface& other)
 	_indices(other._indices),
 	_nIndices(other._nIndices),
 	_localAABB(other._localAABB),
-	_dlRegular(0),
-	_dlProgramVcol(0),
-	_dlProgramNoVCol(0)
+	_mesh(render::MeshBufferPool::INVALID_HANDLE)
 {
-	createDisplayLists();
+	updateMeshBuffer();
 }
 
 std::string RenderablePicoSurface::cleanupShaderName(const std::string& inName)
@@ -149,12 +145,13 @@ std::string RenderablePicoSurface::cleanupShaderName(const std::string& inName)
 	}
 }
 
-// Destructor. Release the GL display lists.
+// Destructor. Release the geometry in the mesh buffers.
 RenderablePicoSurface::~RenderablePicoSurface()
 {
-	glDeleteLists(_dlRegular, 1);
-	glDeleteLists(_dlProgramNoVCol, 1);
-	glDeleteLists(_dlProgramVcol, 1);
+	if (_mesh != render::MeshBufferPool::INVALID_HANDLE)
+	{
+		render::MeshBufferPool::Instance().release(_mesh);
+	}
 }
 
 // Convert byte pointers to colour vector
@@ -197,92 +194,36 @@ void RenderablePicoSurface::calculateTangents() {
 // Back-end render function
 void RenderablePicoSurface::render(const RenderInfo& info) const
 {
-	// Invoke appropriate display list
-	if (info.checkFlag(RENDER_PROGRAM))
-    {
-        if (info.checkFlag(RENDER_VERTEX_COLOUR))
-        {
-            glCallList(_dlProgramVcol);
-        }
-        else
-        {
-            glCallList(_dlProgramNoVCol);
-        }
-	}
-	else
-    {
-		glCallList(_dlRegular);
-	}
+	render::MeshBufferPool& pool = render::MeshBufferPool::Instance();
+
+	pool.beginDraw(info.getFlags());
+	pool.draw(_mesh);
+	pool.endDraw();
 }
 
-// Construct a list for GLProgram mode, either with or without vertex colour
-GLuint RenderablePicoSurface::compileProgramList(bool includeColour)
+render::MeshBufferPool::Handle RenderablePicoSurface::getPooledMesh() const
 {
-    GLuint list = glGenLists(1);
-	assert(list != 0); // check if we run out of display lists
-    glNewList(list, GL_COMPILE);
-
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
-	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
-
-		// Submit the vertex attributes and coordinate
-		if (GLEW_ARB_vertex_program)
-        {
-			glVertexAttrib2dvARB(ATTR_TEXCOORD, v.texcoord);
-			glVertexAttrib3dvARB(ATTR_TANGENT, v.tangent);
-			glVertexAttrib3dvARB(ATTR_BITANGENT, v.bitangent);
-			glVertexAttrib3dvARB(ATTR_NORMAL, v.normal);
-		}
-
-        // Optional vertex colour
-        if (includeColour)
-        {
-            glColor3dv(v.colour);
-        }
-
-        // Submit the vertex itself
-		glVertex3dv(v.vertex);
-	}
-	glEnd();
-
-	glEndList();
-
-    return list;
+	return _mesh;
 }
 
-// Construct the two display lists
-void RenderablePicoSurface::createDisplayLists()
+std::size_t RenderablePicoSurface::getRenderMemoryUsage() const
 {
-	// Generate the lists for lighting mode
-    _dlProgramNoVCol = compileProgramList(false);
-    _dlProgramVcol = compileProgramList(true);
+	return render::MeshBufferPool::Instance().getMemoryUsage(_mesh);
+}
 
-	// Generate the list for flat-shaded (unlit) mode
-	_dlRegular = glGenLists(1);
-	assert(_dlRegular != 0); // check if we run out of display lists
-	glNewList(_dlRegular, GL_COMPILE);
+void RenderablePicoSurface::updateMeshBuffer()
+{
+	render::MeshBufferPool& pool = render::MeshBufferPool::Instance();
 
-	glBegin(GL_TRIANGLES);
-	for (Indices::const_iterator i = _indices.begin();
-		 i != _indices.end();
-		 ++i)
+	if (_mesh == render::MeshBufferPool::INVALID_HANDLE)
 	{
-		// Get the vertex for this index
-		ArbitraryMeshVertex& v = _vertices[*i];
-
-		// Submit attributes
-		glNormal3dv(v.normal);
-		glTexCoord2dv(v.texcoord);
-		glVertex3dv(v.vertex);
+		// Picomodels carry vertex colours
+		_mesh = pool.allocate(_vertices, _indices, true);
+	}
+	else
+	{
+		pool.updateVertices(_mesh, _vertices);
 	}
-	glEnd();
-
-	glEndList();
 }
 
 // Perform selection test for this surface
@@ -440,11 +381,7 @@ void RenderablePicoSurface::applyScale(const Vector3& scale, const RenderablePic
 
 	calculateTangents();
 
-	glDeleteLists(_dlRegular, 1);
-	glDeleteLists(_dlProgramNoVCol, 1);
-	glDeleteLists(_dlProgramVcol, 1);
-
-	createDisplayLists();
+	updateMeshBuffer();
 }
 
 } // namespace model
@@ -1,8 +1,8 @@
 #pragma once
 
-#include "GLProgramAttributes.h"
 #include "picomodel/picomodel.h"
 #include "render.h"
+#include "render/MeshBufferPool.h"
 #include "math/AABB.h"
 
 #include "ishaders.h"
@@ -26,7 +26,8 @@ namespace model
 
 class RenderablePicoSurface :
 	public IIndexedModelSurface,
-	public OpenGLRenderable
+	public OpenGLRenderable,
+	public render::IPooledMesh
 {
 	// Name of the material this surface is using by default (without any skins)
 	std::string _defaultMaterial;
@@ -51,10 +52,8 @@ class RenderablePicoSurface :
 	// The AABB containing this surface, in local object space.
 	AABB _localAABB;
 
-	// The GL display lists for this surface's geometry
-	GLuint _dlRegular;
-	GLuint _dlProgramVcol;
-    GLuint _dlProgramNoVCol;
+	// The geometry of this surface in the shared mesh buffers
+	render::MeshBufferPool::Handle _mesh;
 
 private:
 
@@ -64,9 +63,8 @@ private:
 	// Calculate tangent and bitangent vectors for all vertices.
 	void calculateTangents();
 
-	// Create the display lists
-    GLuint compileProgramList(bool includeColour);
-	void createDisplayLists();
+	// Copy the geometry to the shared mesh buffers
+	void updateMeshBuffer();
 
 	std::string cleanupShaderName(const std::string& mapName);
 
@@ -92,6 +90,12 @@ public:
 	 */
 	void render(const RenderInfo& info) const;
 
+	// IPooledMesh implementation
+	render::MeshBufferPool::Handle getPooledMesh() const override;
+
+	// The number of bytes the geometry occupies in the mesh buffers
+	std::size_t getRenderMemoryUsage() const;
+
 	/** Get the containing AABB for this surface.
 	 */
 	const AABB& getAABB() const {
@@ -95,4 +95,32 @@ void ParticleDef::parseFromTokens(parser::DefTokeniser& tok)
     _changedSignal.emit();
 }
 
+void ParticleDef::writeToCache(parser::DeclWriter& writer) const
+{
+    writer.writeFloat(_depthHack);
+    writer.writeSize(_stages.size());
+
+    for (const StageDefPtr& stage : _stages)
+    {
+        stage->writeToCache(writer);
+    }
+}
+
+void ParticleDef::readFromCache(parser::DeclReader& reader)
+{
+    clear();
+
+    setDepthHack(reader.readFloat());
+
+    for (std::size_t i = reader.readCount(100); i > 0; --i)
+    {
+        StageDefPtr stage = std::make_shared<StageDef>();
+        stage->readFromCache(reader);
+
+        appendStage(stage);
+    }
+
+    _changedSignal.emit();
+}
+
 }
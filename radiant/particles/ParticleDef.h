@@ -136,6 +136,12 @@ public:
 
 	void parseFromTokens(parser::DefTokeniser& tok);
 
+	// Stores the depth hack and the stages in the DeclFileCache record
+	void writeToCache(parser::DeclWriter& writer) const;
+
+	// Restores the definition written by writeToCache()
+	void readFromCache(parser::DeclReader& reader);
+
 	// Stream insertion operator, writing the entire particle def to the given stream
 	friend std::ostream& operator<< (std::ostream& stream, const ParticleDef& def);
 };
@@ -150,20 +150,50 @@ void ParticlesManager::ensureDefsLoaded()
     _defLoader.ensureFinished();
 }
 
-// Parse particle defs from string
-void ParticlesManager::parseStream(std::istream& contents, const std::string& filename)
+// Parse particle defs from the given tokens
+void ParticlesManager::parseDefs(parser::DefTokeniser& tok, const std::string& filename,
+                                 std::vector<ParticleDefPtr>& defs)
 {
-	// Usual ritual, get a parser::DefTokeniser and start tokenising the DEFs
-	parser::BasicDefTokeniser<std::istream> tok(contents);
-
 	while (tok.hasMoreTokens())
 	{
-		parseParticleDef(tok, filename);
+		ParticleDefPtr def = parseParticleDef(tok, filename);
+
+		if (def)
+		{
+			defs.push_back(def);
+		}
+	}
+}
+
+std::string ParticlesManager::writeToCache(const std::vector<ParticleDefPtr>& defs)
+{
+	parser::DeclWriter writer;
+	writer.writeSize(defs.size());
+
+	for (const ParticleDefPtr& def : defs)
+	{
+		writer.writeString(def->getName());
+		def->writeToCache(writer);
+	}
+
+	return writer.getData();
+}
+
+void ParticlesManager::readFromCache(const std::string& data, const std::string& filename)
+{
+	parser::DeclReader reader(data);
+
+	for (std::size_t i = reader.readCount(8); i > 0; --i)
+	{
+		ParticleDefPtr pdef = findOrInsertParticleDefInternal(reader.readString());
+
+		pdef->setFilename(filename);
+		pdef->readFromCache(reader);
 	}
 }
 
 // Parse a single particle def
-void ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::string& filename)
+ParticleDefPtr ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::string& filename)
 {
 	// Standard DEF, starts with "particle <name> {"
 	std::string declName = tok.nextToken();
@@ -189,7 +219,7 @@ void ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::st
 			}
 		}
 
-		return;
+		return ParticleDefPtr();
 	}
 
 	// Valid particle declaration, go ahead parsing the name
@@ -203,6 +233,8 @@ void ParticlesManager::parseParticleDef(parser::DefTokeniser& tok, const std::st
 
 	// Let the particle construct itself from the token stream
 	pdef->parseFromTokens(tok);
+
+	return pdef;
 }
 
 const std::string& ParticlesManager::getName() const
@@ -229,6 +261,8 @@ void ParticlesManager::initialiseModule(const ApplicationContext& ctx)
 {
 	rMessage() << "ParticlesManager::initialiseModule called" << std::endl;
 
+	_declCache.setCacheFile(ctx.getSettingsPath() + "particles.cache");
+
 	// Load the .prt files in a new thread, public methods will block until
     // this has been completed
     _defLoader.start();
@@ -242,35 +276,62 @@ void ParticlesManager::reloadParticleDefs()
 {
 	ScopedDebugTimer timer("Particle definitions parsed: ");
 
+    _declCache.load();
+
     GlobalFileSystem().forEachFile(
         PARTICLES_DIR, PARTICLES_EXT,
         [&](const vfs::FileInfo& fileInfo)
         {
-            // Attempt to open the file in text mode
-            ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(PARTICLES_DIR + fileInfo.name);
+            std::string path = PARTICLES_DIR + fileInfo.name;
+
+            // The cached particle defs are used if the file is unchanged
+            std::string data;
+            vfs::FileStamp stamp = GlobalFileSystem().getFileStamp(path);
 
-            if (file != NULL)
+            try
             {
-                // File is open, so parse the tokens
-                try 
+                if (_declCache.lookup(path, stamp, data))
                 {
-                    std::istream is(&(file->getInputStream()));
-                    parseStream(is, fileInfo.name);
+                    readFromCache(data, fileInfo.name);
+                    return;
                 }
-                catch (parser::ParseException& e)
+            }
+            catch (parser::ParseException& e)
+            {
+                rWarning() << "[particles] Discarding the cached definitions of " << fileInfo.name
+                    << ": " << e.what() << std::endl;
+            }
+
+            try 
+            {
+                // Attempt to open the file in text mode
+                ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(path);
+
+                if (!file)
                 {
-                    rError() << "[particles] Failed to parse " << fileInfo.name
-                        << ": " << e.what() << std::endl;
+                    rError() << "[particles] Unable to open " << fileInfo.name << std::endl;
+                    return;
                 }
+
+                std::istream is(&(file->getInputStream()));
+                parser::BasicDefTokeniser<std::istream> tok(is);
+
+                std::vector<ParticleDefPtr> defs;
+                parseDefs(tok, fileInfo.name, defs);
+
+                _declCache.store(path, stamp, writeToCache(defs));
             }
-            else
+            catch (parser::ParseException& e)
             {
-                rError() << "[particles] Unable to open " << fileInfo.name << std::endl;
+                rError() << "[particles] Failed to parse " << fileInfo.name
+                    << ": " << e.what() << std::endl;
             }
         },
         1 // depth == 1: don't search subdirectories
     );
 
+    _declCache.save();
+
     rMessage() << "Found " << _particleDefs.size() << " particle definitions." << std::endl;
 
 	// Notify observers about this event
@@ -6,6 +6,7 @@
 #include "ThreadedDefLoader.h"
 #include "iparticles.h"
 #include "parser/DefTokeniser.h"
+#include "parser/DeclFileCache.h"
 
 #include <map>
 
@@ -29,6 +30,9 @@ class ParticlesManager :
 
     util::ThreadedDefLoader<void> _defLoader;
 
+    // Particle defs parsed from the particle files, stored between sessions
+    parser::DeclFileCache _declCache;
+
     // Reloaded signal
     sigc::signal<void> _particlesReloadedSignal;
 
@@ -90,13 +94,18 @@ private:
     void ensureDefsLoaded();
 
     /**
-    * Accept a stream containing particle definitions to parse and add to the
-    * list.
+    * Accept a tokeniser returning particle definitions to parse and add to the
+    * list. The parsed definitions are added to defs as well.
     */
-    void parseStream(std::istream& s, const std::string& filename);
+    void parseDefs(parser::DefTokeniser& tok, const std::string& filename,
+                   std::vector<ParticleDefPtr>& defs);
+
+	// Recursive-descent parse functions, returns NULL for non-particle decls
+	ParticleDefPtr parseParticleDef(parser::DefTokeniser& tok, const std::string& filename);
 
-	// Recursive-descent parse functions
-	void parseParticleDef(parser::DefTokeniser& tok, const std::string& filename);
+	// Serialises the particle defs parsed from a file for the cache, and defines them again from that record
+	static std::string writeToCache(const std::vector<ParticleDefPtr>& defs);
+	void readFromCache(const std::string& data, const std::string& filename);
 
 	static void stripParticleDefFromStream(std::istream& input, std::ostream& output, const std::string& particleName);
 };
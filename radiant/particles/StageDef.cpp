@@ -54,6 +54,32 @@ namespace
 		stream << vec.x() << " " << vec.y() << " " << vec.z();
 		return stream;
 	}
+
+	inline void writeParameter(parser::DeclWriter& writer, const ParticleParameter& param)
+	{
+		writer.writeFloat(param.getFrom());
+		writer.writeFloat(param.getTo());
+	}
+
+	inline void readParameter(parser::DeclReader& reader, ParticleParameter& param)
+	{
+		param.setFrom(reader.readFloat());
+		param.setTo(reader.readFloat());
+	}
+
+	// Reads an enum value written as integer, rejecting values beyond the last one
+	template<typename EnumType>
+	inline EnumType readEnum(parser::DeclReader& reader, EnumType last)
+	{
+		int32_t value = reader.readInt32();
+
+		if (value < 0 || value > static_cast<int32_t>(last))
+		{
+			throw parser::ParseException("Invalid enum value in the cached particle stage");
+		}
+
+		return static_cast<EnumType>(value);
+	}
 }
 
 StageDef::StageDef() :
@@ -203,6 +229,160 @@ void StageDef::copyFrom(const IStageDef& other)
 	*_rotationSpeed = other.getRotationSpeed();
 }
 
+void StageDef::writeToCache(parser::DeclWriter& writer) const
+{
+	writer.writeString(getMaterialName());
+	writer.writeInt32(getCount());
+	writer.writeFloat(getDuration());
+	writer.writeFloat(getCycles());
+	writer.writeFloat(getBunching());
+	writer.writeFloat(getTimeOffset());
+	writer.writeFloat(getDeadTime());
+
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		writer.writeDouble(getColour()[i]);
+	}
+
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		writer.writeDouble(getFadeColour()[i]);
+	}
+
+	writer.writeFloat(getFadeInFraction());
+	writer.writeFloat(getFadeOutFraction());
+	writer.writeFloat(getFadeIndexFraction());
+	writer.writeInt32(getAnimationFrames());
+	writer.writeFloat(getAnimationRate());
+	writer.writeFloat(getInitialAngle());
+	writer.writeFloat(getBoundsExpansion());
+	writer.writeBool(getRandomDistribution());
+	writer.writeBool(getUseEntityColour());
+	writer.writeFloat(getGravity());
+	writer.writeBool(getWorldGravityFlag());
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		writer.writeDouble(getOffset()[i]);
+	}
+
+	writer.writeInt32(getOrientationType());
+
+	for (int i = 0; i < 4; ++i)
+	{
+		writer.writeFloat(getOrientationParm(i));
+	}
+
+	writer.writeInt32(getDistributionType());
+
+	for (int i = 0; i < 4; ++i)
+	{
+		writer.writeFloat(getDistributionParm(i));
+	}
+
+	writer.writeInt32(getDirectionType());
+
+	for (int i = 0; i < 4; ++i)
+	{
+		writer.writeFloat(getDirectionParm(i));
+	}
+
+	writer.writeInt32(getCustomPathType());
+
+	for (int i = 0; i < 8; ++i)
+	{
+		writer.writeFloat(getCustomPathParm(i));
+	}
+
+	writeParameter(writer, getSize());
+	writeParameter(writer, getAspect());
+	writeParameter(writer, getSpeed());
+	writeParameter(writer, getRotationSpeed());
+}
+
+void StageDef::readFromCache(parser::DeclReader& reader)
+{
+	reset();
+
+	setMaterialName(reader.readString());
+	setCount(reader.readInt32());
+	setDuration(reader.readFloat());
+	setCycles(reader.readFloat());
+	setBunching(reader.readFloat());
+	setTimeOffset(reader.readFloat());
+	setDeadTime(reader.readFloat());
+
+	Vector4 colour;
+
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		colour[i] = reader.readDouble();
+	}
+
+	setColour(colour);
+
+	for (std::size_t i = 0; i < 4; ++i)
+	{
+		colour[i] = reader.readDouble();
+	}
+
+	setFadeColour(colour);
+
+	setFadeInFraction(reader.readFloat());
+	setFadeOutFraction(reader.readFloat());
+	setFadeIndexFraction(reader.readFloat());
+	setAnimationFrames(reader.readInt32());
+	setAnimationRate(reader.readFloat());
+	setInitialAngle(reader.readFloat());
+	setBoundsExpansion(reader.readFloat());
+	setRandomDistribution(reader.readBool());
+	setUseEntityColour(reader.readBool());
+	setGravity(reader.readFloat());
+	setWorldGravityFlag(reader.readBool());
+
+	Vector3 offset;
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		offset[i] = reader.readDouble();
+	}
+
+	setOffset(offset);
+
+	setOrientationType(readEnum(reader, ORIENTATION_Z));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		setOrientationParm(i, reader.readFloat());
+	}
+
+	setDistributionType(readEnum(reader, DISTRIBUTION_SPHERE));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		setDistributionParm(i, reader.readFloat());
+	}
+
+	setDirectionType(readEnum(reader, DIRECTION_OUTWARD));
+
+	for (int i = 0; i < 4; ++i)
+	{
+		setDirectionParm(i, reader.readFloat());
+	}
+
+	setCustomPathType(readEnum(reader, PATH_DRIP));
+
+	for (int i = 0; i < 8; ++i)
+	{
+		setCustomPathParm(i, reader.readFloat());
+	}
+
+	readParameter(reader, getSize());
+	readParameter(reader, getAspect());
+	readParameter(reader, getSpeed());
+	readParameter(reader, getRotationSpeed());
+}
+
 void StageDef::parseFromTokens(parser::DefTokeniser& tok)
 {
 	reset();
@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include "parser/DefTokeniser.h"
+#include "parser/DeclFileCache.h"
 
 #include "ParticleParameter.h"
 
@@ -554,6 +555,11 @@ public:
     // The routine will continue parsing until the matching closing } is encountered.
     void parseFromTokens(parser::DefTokeniser& tok);
 
+    // Stores all stage parameters in the DeclFileCache record
+    void writeToCache(parser::DeclWriter& writer) const;
+
+    // Restores the parameters written by writeToCache()
+    void readFromCache(parser::DeclReader& reader);
 };
 typedef std::shared_ptr<StageDef> StageDefPtr;
 
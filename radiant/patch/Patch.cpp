@@ -7,6 +7,7 @@
 #include "irenderable.h"
 #include "itextstream.h"
 #include "iselectiontest.h"
+#include "ivolumetest.h"
 
 #include "registry/registry.h"
 #include "math/Frustum.h"
@@ -261,11 +262,19 @@ void Patch::testSelect(Selector& selector, SelectionTest& test)
 	// The updateTesselation routine might have produced a degenerate patch, catch this
 	if (_mesh.vertices.empty()) return;
 
+	const VolumeTest& volume = test.getVolume();
+	const Matrix4& localToWorld = _node.localToWorld();
+
 	SelectionIntersection best;
 	IndexPointer::index_type* pIndex = &_mesh.indices.front();
 
 	for (std::size_t s=0; s<_mesh.numStrips; s++) {
-		test.TestQuadStrip(vertexpointer_arbitrarymeshvertex(&_mesh.vertices.front()), IndexPointer(pIndex, _mesh.lenStrips), best);
+		// Only clip the quads of the strips reaching into the selection volume
+		if (volume.TestAABB(_mesh.stripBounds[s], localToWorld) != VOLUME_OUTSIDE)
+		{
+			test.TestQuadStrip(vertexpointer_arbitrarymeshvertex(&_mesh.vertices.front()), IndexPointer(pIndex, _mesh.lenStrips), best);
+		}
+
 		pIndex += _mesh.lenStrips;
 	}
 
@@ -437,11 +446,65 @@ IUndoMementoPtr Patch::exportState() const
 	return IUndoMementoPtr(new SavedState(_width, _height, _ctrl, _patchDef3, _subDivisions.x(), _subDivisions.y(), _shader.getMaterialName()));
 }
 
+IUndoMementoPtr Patch::compactState(const IUndoMementoPtr& state) const
+{
+	const SavedState& saved = *std::static_pointer_cast<SavedState>(state);
+
+	// The full state is needed if anything else than the control points changed
+	if (saved.m_width != _width || saved.m_height != _height || saved.m_ctrl.size() != _ctrl.size() ||
+		saved.m_patchDef3 != _patchDef3 || saved.m_subdivisions_x != _subDivisions.x() ||
+		saved.m_subdivisions_y != _subDivisions.y() || saved._materialName != _shader.getMaterialName())
+	{
+		return state;
+	}
+
+	auto changes = std::make_shared<SavedControlPoints>();
+
+	for (std::size_t i = 0; i < _ctrl.size(); ++i)
+	{
+		if (saved.m_ctrl[i].vertex != _ctrl[i].vertex || saved.m_ctrl[i].texcoord != _ctrl[i].texcoord)
+		{
+			changes->m_changedCtrl.push_back(SavedControlPoints::IndexedControl(i, saved.m_ctrl[i]));
+		}
+	}
+
+	if (changes->m_changedCtrl.empty())
+	{
+		return IUndoMementoPtr(); // nothing to restore
+	}
+
+	// If most of the points changed, the indices make the delta larger than the full copy
+	if (changes->getMemoryUsage() >= saved.getMemoryUsage())
+	{
+		return state;
+	}
+
+	changes->m_changedCtrl.shrink_to_fit();
+
+	return changes;
+}
+
 // Revert the state of this patch to the one that has been saved in the UndoMemento
 void Patch::importState(const IUndoMementoPtr& state)
 {
 	undoSave();
 
+	auto changes = std::dynamic_pointer_cast<SavedControlPoints>(state);
+
+	if (changes)
+	{
+		// Only the changed control points are stored, the rest is already in place
+		for (const SavedControlPoints::IndexedControl& pair : changes->m_changedCtrl)
+		{
+			assert(pair.first < _ctrl.size());
+			_ctrl[pair.first] = pair.second;
+		}
+
+		textureChanged();
+		controlPointsChanged();
+		return;
+	}
+
 	const SavedState& other = *(std::static_pointer_cast<SavedState>(state));
 
 	// begin duplicate of SavedState copy constructor, needs refactoring
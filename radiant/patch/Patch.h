@@ -325,7 +325,7 @@ public:
 	void createThickenedWall(const Patch& sourcePatch, const Patch& targetPatch, const int wallIndex);
 
 	// called just before an action to save the undo state
-	void undoSave();
+	void undoSave() override;
 
 	// Save the current patch state into a new UndoMemento instance (allocated on heap) and return it to the undo observer
 	IUndoMementoPtr exportState() const override;
@@ -333,6 +333,9 @@ public:
 	// Revert the state of this patch to the one that has been saved in the UndoMemento
 	void importState(const IUndoMementoPtr& state) override;
 
+	// Reduce the saved state to the control points that changed since then, if possible
+	IUndoMementoPtr compactState(const IUndoMementoPtr& state) const override;
+
 	/** greebo: Gets whether this patch is a patchDef3 (fixed tesselation)
 	 */
 	bool subdivisionsFixed() const override;
@@ -127,6 +127,10 @@ void PatchNode::testSelect(Selector& selector, SelectionTest& test) {
 	if (!isVisible())
 		return;
 
+	// Nothing to hit if the patch is outside of the selection volume
+	if (test.getVolume().TestAABB(worldAABB()) == VOLUME_OUTSIDE)
+		return;
+
     test.BeginMesh(localToWorld(), true);
     // Pass the selection test call to the patch
     m_patch.testSelect(selector, test);
@@ -277,6 +281,10 @@ bool PatchNode::intersectsLight(const RendererLight& light) const {
 	return light.intersectsAABB(worldAABB());
 }
 
+const AABB& PatchNode::getLitObjectAABB() const {
+	return worldAABB();
+}
+
 void PatchNode::renderSolid(RenderableCollector& collector, const VolumeTest& volume) const
 {
 	// Don't render invisible shaders
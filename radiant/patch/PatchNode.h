@@ -124,6 +124,7 @@ public:
 
 	// LitObject implementation
 	bool intersectsLight(const RendererLight& light) const override;
+	const AABB& getLitObjectAABB() const override;
 
 	// Renderable implementation
 
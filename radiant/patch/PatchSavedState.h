@@ -36,4 +36,28 @@ public:
 		m_subdivisions_y(subdivisions_y),
         _materialName(materialName)
     {}
+
+	std::size_t getMemoryUsage() const override
+	{
+		return sizeof(*this) + m_ctrl.capacity() * sizeof(PatchControl) + _materialName.capacity();
+	}
+};
+
+/* The control points of a patch which have been changed by an undo operation.
+ * This replaces the full SavedState if nothing but a few control points have
+ * been modified, it can only be imported into the patch state left behind by
+ * that operation.
+ */
+class SavedControlPoints :
+	public IUndoMemento
+{
+public:
+	// Control point indices paired with their saved values
+	typedef std::pair<std::size_t, PatchControl> IndexedControl;
+	std::vector<IndexedControl> m_changedCtrl;
+
+	std::size_t getMemoryUsage() const override
+	{
+		return sizeof(*this) + m_changedCtrl.capacity() * sizeof(IndexedControl);
+	}
 };
@@ -835,6 +835,21 @@ void PatchTesselation::generateIndices()
 	}
 }
 
+void PatchTesselation::generateStripBounds()
+{
+	stripBounds.assign(numStrips, AABB());
+
+	for (std::size_t strip = 0; strip < numStrips; ++strip)
+	{
+		const RenderIndex* stripIndices = &indices[strip * lenStrips];
+
+		for (std::size_t i = 0; i < lenStrips; ++i)
+		{
+			stripBounds[strip].includePoint(vertices[stripIndices[i]].vertex);
+		}
+	}
+}
+
 void PatchTesselation::generate(std::size_t patchWidth, std::size_t patchHeight, 
 	const PatchControlArray& controlPoints, bool subdivionsFixed, const Subdivisions& subdivs)
 {
@@ -879,6 +894,7 @@ void PatchTesselation::generate(std::size_t patchWidth, std::size_t patchHeight,
 
 	// Build the strip indices for rendering the quads
 	generateIndices();
+	generateStripBounds();
 
 	// With indices in place we can derive the tangent/bitangent vectors
 	deriveTangents();
@@ -2,6 +2,7 @@
 
 #include "render.h"
 #include "PatchControl.h"
+#include "math/AABB.h"
 
 struct FaceTangents;
 
@@ -20,6 +21,9 @@ public:
 	std::size_t numStrips;
 	std::size_t lenStrips;
 
+	// The bounds of each strip, used to skip strips during selection tests
+	std::vector<AABB> stripBounds;
+
 	// Geometry of the tesselated mesh
 	std::size_t width;
 	std::size_t height;
@@ -51,6 +55,7 @@ public:
 private:
 	// Private methods used for tesselation, modeled after the patch subdivision code found in idTech4
 	void generateIndices();
+	void generateStripBounds();
 	void generateNormals();
 	void subdivideMesh();
 	void subdivideMeshFixed(std::size_t subdivX, std::size_t subdivY);
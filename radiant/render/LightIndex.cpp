@@ -0,0 +1,116 @@
+#include "LightIndex.h"
+
+#include <algorithm>
+
+namespace render
+{
+
+LightIndex::LightIndex() :
+	_treeNeedsRebuild(false)
+{}
+
+void LightIndex::insert(RendererLight& light, const AABB& bounds)
+{
+	_lights[&light] = bounds;
+	_treeNeedsRebuild = true;
+}
+
+AABB LightIndex::remove(RendererLight& light)
+{
+	AABB previous;
+
+	LightBounds::iterator found = _lights.find(&light);
+
+	if (found != _lights.end())
+	{
+		previous = found->second;
+		_lights.erase(found);
+		_treeNeedsRebuild = true;
+	}
+
+	return previous;
+}
+
+AABB LightIndex::update(RendererLight& light, const AABB& bounds)
+{
+	AABB& stored = _lights[&light];
+	AABB previous = stored;
+
+	stored = bounds;
+	_treeNeedsRebuild = true;
+
+	return previous;
+}
+
+bool LightIndex::contains(RendererLight& light) const
+{
+	return _lights.find(&light) != _lights.end();
+}
+
+void LightIndex::rebuild() const
+{
+	_treeNeedsRebuild = false;
+
+	_entries.clear();
+	_nodes.clear();
+
+	for (const LightBounds::value_type& pair : _lights)
+	{
+		// Lights without a volume can't touch anything
+		if (pair.second.isValid())
+		{
+			_entries.push_back(Entry{ pair.first, pair.second });
+		}
+	}
+
+	if (!_entries.empty())
+	{
+		buildNode(0, _entries.size());
+	}
+}
+
+std::size_t LightIndex::buildNode(std::size_t first, std::size_t count) const
+{
+	std::size_t index = _nodes.size();
+	_nodes.push_back(Node{ AABB(), first, count, 0 });
+
+	AABB bounds;
+	AABB centres;
+
+	for (std::size_t i = first; i < first + count; ++i)
+	{
+		bounds.includeAABB(_entries[i].bounds);
+		centres.includePoint(_entries[i].bounds.origin);
+	}
+
+	_nodes[index].bounds = bounds;
+
+	if (count <= MAX_LEAF_SIZE)
+	{
+		return index;
+	}
+
+	// Split at the median along the axis with the largest spread of centres
+	int axis = 0;
+
+	if (centres.extents.y() > centres.extents[axis]) axis = 1;
+	if (centres.extents.z() > centres.extents[axis]) axis = 2;
+
+	std::size_t half = count / 2;
+
+	std::nth_element(_entries.begin() + first, _entries.begin() + first + half,
+		_entries.begin() + first + count, [axis](const Entry& a, const Entry& b)
+	{
+		return a.bounds.origin[axis] < b.bounds.origin[axis];
+	});
+
+	buildNode(first, half);
+
+	// The node vector might have been reallocated
+	std::size_t secondChild = buildNode(first + half, count - half);
+	_nodes[index].secondChild = secondChild;
+
+	return index;
+}
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "irender.h"
+#include "math/AABB.h"
+
+namespace render
+{
+
+/**
+ * Spatial index of the light sources known to the renderer. The lights are
+ * kept in a bounding volume hierarchy over their world-space volumes, which
+ * allows to find the lights possibly touching an object without testing all
+ * of them. The hierarchy is rebuilt on the next query after a light has been
+ * added, removed or changed, which is cheap for the light counts of a map.
+ */
+class LightIndex
+{
+private:
+	// The bounds of each light as of the last update
+	typedef std::map<RendererLight*, AABB> LightBounds;
+	LightBounds _lights;
+
+	struct Entry
+	{
+		RendererLight* light;
+		AABB bounds;
+	};
+
+	// A node covers the entries [first, first + count), inner nodes have
+	// their first child following them and the second one at secondChild.
+	struct Node
+	{
+		AABB bounds;
+		std::size_t first;
+		std::size_t count;
+		std::size_t secondChild;
+	};
+
+	mutable std::vector<Entry> _entries;
+	mutable std::vector<Node> _nodes;
+	mutable bool _treeNeedsRebuild;
+
+	mutable std::vector<std::size_t> _stack;
+
+public:
+	// The number of lights in a leaf of the hierarchy
+	static const std::size_t MAX_LEAF_SIZE = 4;
+
+	LightIndex();
+
+	void insert(RendererLight& light, const AABB& bounds);
+
+	// Remove the light from the index, returns the bounds it had
+	AABB remove(RendererLight& light);
+
+	// Set the new bounds of the light, returns the previous ones
+	AABB update(RendererLight& light, const AABB& bounds);
+
+	bool contains(RendererLight& light) const;
+
+	std::size_t size() const
+	{
+		return _lights.size();
+	}
+
+	/**
+	 * Invoke the given functor with every light whose bounds intersect the
+	 * given AABB. The lights still need to be tested in detail.
+	 */
+	template<typename Func>
+	void forEachIntersectingLight(const AABB& aabb, Func func) const
+	{
+		if (_treeNeedsRebuild)
+		{
+			rebuild();
+		}
+
+		if (_nodes.empty() || !aabb.isValid())
+		{
+			return;
+		}
+
+		_stack.clear();
+		_stack.push_back(0);
+
+		while (!_stack.empty())
+		{
+			std::size_t nodeIndex = _stack.back();
+			_stack.pop_back();
+
+			const Node& node = _nodes[nodeIndex];
+
+			if (!node.bounds.intersects(aabb))
+			{
+				continue;
+			}
+
+			if (node.secondChild == 0)
+			{
+				for (std::size_t i = node.first; i < node.first + node.count; ++i)
+				{
+					if (_entries[i].bounds.intersects(aabb))
+					{
+						func(*_entries[i].light);
+					}
+				}
+			}
+			else
+			{
+				_stack.push_back(node.secondChild);
+				_stack.push_back(nodeIndex + 1);
+			}
+		}
+	}
+
+private:
+	void rebuild() const;
+
+	// Build the subtree of the given entry range, returns the node index
+	std::size_t buildNode(std::size_t first, std::size_t count) const;
+};
+
+}
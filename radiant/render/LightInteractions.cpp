@@ -0,0 +1,124 @@
+#include "LightInteractions.h"
+
+#include "debugging/debugging.h"
+
+namespace render
+{
+
+LightList& LightInteractions::attachLitObject(LitObject& object)
+{
+	return _lightLists.insert(
+		LightLists::value_type(
+			&object,
+			LinearLightList(
+				object,
+				_lightIndex,
+				std::bind(&LightInteractions::updateDirtyLists, this)
+			)
+		)
+	).first->second;
+}
+
+void LightInteractions::detachLitObject(LitObject& object)
+{
+	_lightLists.erase(&object);
+}
+
+void LightInteractions::litObjectChanged(LitObject& object)
+{
+	LightLists::iterator i = _lightLists.find(&object);
+	assert(i != _lightLists.end());
+
+	i->second.setDirty();
+}
+
+void LightInteractions::attachLight(RendererLight& light)
+{
+	ASSERT_MESSAGE(!_lightIndex.contains(light), "light could not be attached");
+
+	// The volume is determined on the next update
+	_lightIndex.insert(light, AABB());
+	_changedLights.insert(&light);
+}
+
+void LightInteractions::detachLight(RendererLight& light)
+{
+	ASSERT_MESSAGE(_lightIndex.contains(light), "light could not be detached");
+
+	_changedVolumes.push_back(_lightIndex.remove(light));
+	_changedLights.erase(&light);
+}
+
+void LightInteractions::lightChanged(RendererLight& light)
+{
+	// Lights not (yet) attached to the renderer don't light anything
+	if (_lightIndex.contains(light))
+	{
+		_changedLights.insert(&light);
+	}
+}
+
+bool LightInteractions::containsLight(RendererLight& light) const
+{
+	return _lightIndex.contains(light);
+}
+
+void LightInteractions::updateDirtyLists()
+{
+	if (_changedLights.empty() && _changedVolumes.empty())
+	{
+		return;
+	}
+
+	// The objects touching the old or the new volume of a light need an update
+	for (RendererLight* light : _changedLights)
+	{
+		AABB bounds = light->getLightAABB();
+
+		_changedVolumes.push_back(_lightIndex.update(*light, bounds));
+		_changedVolumes.push_back(bounds);
+	}
+
+	_changedLights.clear();
+
+	if (_changedVolumes.size() > MAX_CHANGED_VOLUMES)
+	{
+		// Testing every object against every volume doesn't pay off
+		setAllListsDirty();
+	}
+	else
+	{
+		for (const AABB& volume : _changedVolumes)
+		{
+			setListsDirty(volume);
+		}
+	}
+
+	_changedVolumes.clear();
+}
+
+void LightInteractions::setListsDirty(const AABB& volume)
+{
+	if (!volume.isValid())
+	{
+		return;
+	}
+
+	for (LightLists::value_type& pair : _lightLists)
+	{
+		if (pair.first->getLitObjectAABB().intersects(volume))
+		{
+			pair.second.setDirty();
+		}
+	}
+}
+
+void LightInteractions::setAllListsDirty()
+{
+	for (LightLists::value_type& pair : _lightLists)
+	{
+		pair.second.setDirty();
+	}
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "irender.h"
+#include "LightIndex.h"
+#include "LinearLightList.h"
+
+namespace render
+{
+
+/**
+ * Keeps track of the lights and lit objects known to the renderer and of
+ * the light lists associating them. Changed lights are collected and
+ * processed on the next light list calculation: only the lists of objects
+ * touching the previous or the current volume of a changed light are
+ * marked as dirty, instead of invalidating every list in the scene.
+ */
+class LightInteractions
+{
+private:
+	LightIndex _lightIndex;
+
+	typedef std::map<LitObject*, LinearLightList> LightLists;
+	LightLists _lightLists;
+
+	// Lights which changed since the last update
+	std::set<RendererLight*> _changedLights;
+
+	// Volumes of lights which have been removed since the last update
+	std::vector<AABB> _changedVolumes;
+
+public:
+	// Above this number of changed light volumes all lists are invalidated
+	static const std::size_t MAX_CHANGED_VOLUMES = 64;
+
+	LightList& attachLitObject(LitObject& object);
+	void detachLitObject(LitObject& object);
+	void litObjectChanged(LitObject& object);
+
+	void attachLight(RendererLight& light);
+	void detachLight(RendererLight& light);
+	void lightChanged(RendererLight& light);
+
+	bool containsLight(RendererLight& light) const;
+
+	/**
+	 * Process the light changes since the last call, setting the light lists
+	 * affected by them to dirty. This is invoked by each light list before
+	 * calculating its intersecting lights.
+	 */
+	void updateDirtyLists();
+
+private:
+	void setListsDirty(const AABB& volume);
+	void setAllListsDirty();
+};
+
+}
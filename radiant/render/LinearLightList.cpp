@@ -15,15 +15,16 @@ void LinearLightList::calculateIntersectingLights() const
         _activeLights.clear();
         _litObject.clearLights();
 
-        // Determine which lights intersect object
-        for (RendererLight* light : _allLights)
+        // Determine which of the lights near the object intersect it
+        _allLights.forEachIntersectingLight(_litObject.getLitObjectAABB(),
+            [&](RendererLight& light)
         {
-            if (_litObject.intersectsLight(*light))
+            if (_litObject.intersectsLight(light))
             {
-                _activeLights.push_back(light);
-                _litObject.insertLight(*light);
+                _activeLights.push_back(&light);
+                _litObject.insertLight(light);
             }
-        }
+        });
     }
 }
 
@@ -1,14 +1,13 @@
 #pragma once
 
 #include "irender.h"
+#include "LightIndex.h"
 #include <list>
 #include <functional>
 
 namespace render
 {
 
-typedef std::set<RendererLight*> RendererLights;
-
 /**
  * \brief
  * Main renderer implementation of LightList interface.
@@ -27,8 +26,8 @@ private:
     // Target object
 	LitObject& _litObject;
 
-    // Set of all available lights
-	RendererLights& _allLights;
+    // Spatial index of all available lights
+	const LightIndex& _allLights;
 
     // Update callback
 	VoidCallback _testDirtyFunc;
@@ -50,14 +49,15 @@ public:
      * The illuminatable object whose lit status we are tracking.
      *
      * \param lights
-     * Entire set of available light sources provided by the renderer.
+     * Index of all available light sources provided by the renderer, only
+     * the lights whose volume touches the object's bounds are tested.
      *
      * \param testFunc
      * A callback function to request the renderer check if the light list
      * needs to recalculate its intersections, and call setDirty() if necessary.
      */
     LinearLightList(LitObject& object,
-                    RendererLights& lights,
+                    const LightIndex& lights,
                     VoidCallback testFunc)
     : _litObject(object), _allLights(lights), _testDirtyFunc(testFunc)
 	{
@@ -7,6 +7,8 @@
 #include "modulesystem/StaticModule.h"
 #include "backend/GLProgramFactory.h"
 #include "debugging/debugging.h"
+#include "render/MeshBufferPool.h"
+#include "render/TextureResidency.h"
 
 #include <functional>
 
@@ -42,7 +44,6 @@ OpenGLRenderSystem::OpenGLRenderSystem() :
     _glProgramFactory(std::make_shared<GLProgramFactory>()),
 	_currentShaderProgram(SHADER_PROGRAM_NONE),
 	_time(0),
-	m_lightsChanged(true),
 	m_traverseRenderablesMutex(false)
 {
 	// For the static default rendersystem, the MaterialManager is not existent yet,
@@ -120,6 +121,12 @@ void OpenGLRenderSystem::render(RenderStateFlags globalstate,
                                const Matrix4& projection,
                                const Vector3& viewer)
 {
+	// Fill the textures which have been loaded in the meantime
+	GlobalMaterialManager().uploadPendingTextures();
+
+	// Textures bound from now on are protected from being evicted in the next frame
+	render::TextureResidency::Instance().nextFrame();
+
 	glPushAttrib(GL_ALL_ATTRIB_BITS);
 
 	// Set the projection and modelview matrices
@@ -421,65 +428,32 @@ sigc::signal<void> OpenGLRenderSystem::signal_extensionsInitialised()
 
 LightList& OpenGLRenderSystem::attachLitObject(LitObject& object)
 {
-	return m_lightLists.insert(
-		LightLists::value_type(
-			&object,
-			LinearLightList(
-                object,
-                m_lights,
-                std::bind(
-                    &OpenGLRenderSystem::propagateLightChangedFlagToAllLights,
-                    this
-                )
-            )
-        )
-    ).first->second;
+	return _lightInteractions.attachLitObject(object);
 }
 
 void OpenGLRenderSystem::detachLitObject(LitObject& object) 
 {
-	m_lightLists.erase(&object);
+	_lightInteractions.detachLitObject(object);
 }
 
 void OpenGLRenderSystem::litObjectChanged(LitObject& object) 
 {
-	LightLists::iterator i = m_lightLists.find(&object);
-    assert(i != m_lightLists.end());
-
-	i->second.setDirty();
+	_lightInteractions.litObjectChanged(object);
 }
 
 void OpenGLRenderSystem::attachLight(RendererLight& light)
 {
-    ASSERT_MESSAGE(m_lights.find(&light) == m_lights.end(), "light could not be attached");
-    m_lights.insert(&light);
-    lightChanged(light);
+    _lightInteractions.attachLight(light);
 }
 
 void OpenGLRenderSystem::detachLight(RendererLight& light)
 {
-    ASSERT_MESSAGE(m_lights.find(&light) != m_lights.end(), "light could not be detached");
-    m_lights.erase(&light);
-    lightChanged(light);
+    _lightInteractions.detachLight(light);
 }
 
 void OpenGLRenderSystem::lightChanged(RendererLight& light)
 {
-    m_lightsChanged = true;
-}
-
-void OpenGLRenderSystem::propagateLightChangedFlagToAllLights()
-{
-    if (m_lightsChanged)
-    {
-    	m_lightsChanged = false;
-    	for (LightLists::iterator i = m_lightLists.begin();
-             i != m_lightLists.end();
-             ++i) 
-        {
-    		i->second.setDirty();
-    	}
-	}
+    _lightInteractions.lightChanged(light);
 }
 
 void OpenGLRenderSystem::insertSortedState(const OpenGLStates::value_type& val) {
@@ -555,6 +529,13 @@ void OpenGLRenderSystem::shutdownModule()
 {
 	_materialDefsLoaded.disconnect();
 	_materialDefsUnloaded.disconnect();
+
+	// The pooled model geometry lives in buffers of the shared context,
+	// they are gone already if the context has been destroyed before
+	if (GlobalOpenGL().wxContextValid())
+	{
+		MeshBufferPool::Instance().shutdown();
+	}
 }
 
 // Define the static ShaderCache module
@@ -6,7 +6,7 @@
 #include "imodule.h"
 #include "backend/OpenGLStateManager.h"
 #include "backend/OpenGLShader.h"
-#include "LinearLightList.h"
+#include "LightInteractions.h"
 #include "render/backend/OpenGLStateLess.h"
 
 namespace render
@@ -43,20 +43,14 @@ private:
 	// Render time
 	std::size_t _time;
 
-	// Lights
-	RendererLights m_lights;
-	bool m_lightsChanged;
-	typedef std::map<LitObject*, LinearLightList> LightLists;
-	LightLists m_lightLists;
+	// Lights, lit objects and their light lists
+	LightInteractions _lightInteractions;
 
 	sigc::signal<void> _sigExtensionsInitialised;
 
 	sigc::connection _materialDefsLoaded;
 	sigc::connection _materialDefsUnloaded;
 
-private:
-	void propagateLightChangedFlagToAllLights();
-
 public:
 
 	/**
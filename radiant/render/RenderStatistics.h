@@ -1,7 +1,8 @@
 #pragma once
 
 #include <wx/stopwatch.h>
-#include "string/string.h"
+#include "string/convert.h"
+#include "render/TextureResidency.h"
 
 namespace render
 {
@@ -13,6 +14,7 @@ class RenderStatistics
 	std::size_t _countPrims;
 	std::size_t _countStates;
 	std::size_t _countTransforms;
+	std::size_t _countDrawCalls;
 
 	wxStopWatch _timer;
 public:
@@ -21,16 +23,51 @@ public:
         _statStr = "prims: " + string::to_string(_countPrims) +
 				  " | states: " + string::to_string(_countStates) +
 				  " | transforms: "	+ string::to_string(_countTransforms) +
+				  " | draws: " + string::to_string(_countDrawCalls) +
 				  " | msec: " + string::to_string(_timer.Time());
 
+		const TextureResidency& residency = TextureResidency::Instance();
+
+		if (residency.getBudget() > 0)
+		{
+			_statStr += " | textures: " + string::to_string(residency.getResidentBytes() >> 20) + " MB" +
+				" | reduced: " + string::to_string(residency.getNumReductions()) +
+				" | evicted: " + string::to_string(residency.getNumEvictions());
+		}
+
 		return _statStr;
 	}
 
+	// Renderables submitted to the backend
+	void increasePrimitives(std::size_t count = 1)
+	{
+		_countPrims += count;
+	}
+
+	// Shader pass states applied
+	void increaseStates()
+	{
+		_countStates++;
+	}
+
+	// Modelview matrices loaded
+	void increaseTransforms()
+	{
+		_countTransforms++;
+	}
+
+	// Draw calls issued
+	void increaseDrawCalls(std::size_t count = 1)
+	{
+		_countDrawCalls += count;
+	}
+
 	void resetStats() 
     {
 		_countPrims = 0;
 		_countStates = 0;
 		_countTransforms = 0;
+		_countDrawCalls = 0;
 
 		_timer.Start();
 	}
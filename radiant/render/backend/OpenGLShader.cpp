@@ -51,10 +51,21 @@ OpenGLRenderSystem& OpenGLShader::getRenderSystem()
     return _renderSystem;
 }
 
+PolygonBatchBuffer& OpenGLShader::getPolygonBatch()
+{
+    if (!_polygonBatch)
+    {
+        _polygonBatch.reset(new PolygonBatchBuffer);
+    }
+
+    return *_polygonBatch;
+}
+
 void OpenGLShader::destroy()
 {
     _material.reset();
     _shaderPasses.clear();
+    _polygonBatch.reset();
 }
 
 void OpenGLShader::addRenderable(const OpenGLRenderable& renderable,
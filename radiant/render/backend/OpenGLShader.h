@@ -7,6 +7,7 @@
 #include "string/string.h"
 
 #include <list>
+#include <memory>
 
 namespace render
 {
@@ -38,6 +39,9 @@ class OpenGLShader :
 	typedef std::set<Observer*> Observers;
 	Observers _observers;
 
+	// Vertex buffer shared by the passes for drawing brush faces, created on demand
+	std::unique_ptr<PolygonBatchBuffer> _polygonBatch;
+
 private:
 
     // Start point for constructing shader passes from the shader name
@@ -78,6 +82,9 @@ public:
     // Returns the owning render system
     OpenGLRenderSystem& getRenderSystem();
 
+    // Returns the buffer the passes use to draw batchable polygons
+    PolygonBatchBuffer& getPolygonBatch();
+
     // Shader implementation
 	void addRenderable(const OpenGLRenderable& renderable,
 					   const Matrix4& modelview,
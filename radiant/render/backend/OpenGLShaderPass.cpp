@@ -9,6 +9,11 @@
 #include "iglprogram.h"
 
 #include "debugging/render.h"
+#include "util/RadixSort.h"
+#include "render/TextureResidency.h"
+#include "../RenderStatistics.h"
+
+#include <cstdint>
 
 namespace render
 {
@@ -23,6 +28,12 @@ inline void setTextureState(GLint& current,
                             GLenum textureUnit,
                             GLenum textureMode)
 {
+    if (texture != 0)
+    {
+        // Reloads the texture if it has been reduced or evicted
+        render::TextureResidency::Instance().markUsed(texture);
+    }
+
     if (texture != current)
     {
         glActiveTexture(textureUnit);
@@ -38,6 +49,11 @@ inline void setTextureState(GLint& current,
                             const GLint& texture,
                             GLenum textureMode)
 {
+    if (texture != 0)
+    {
+        render::TextureResidency::Instance().markUsed(texture);
+    }
+
     if (texture != current)
     {
         glBindTexture(textureMode, texture);
@@ -327,6 +343,8 @@ void OpenGLShaderPass::applyState(OpenGLState& current,
         globalStateMask |= RENDER_FILL | RENDER_DEPTHWRITE;
     }
 
+    RenderStatistics::Instance().increaseStates();
+
     // Apply the global state mask to our own desired render flags to determine
     // the final set of flags that must bet set
     const unsigned requiredState = _glState.getRenderFlags() & globalStateMask;
@@ -571,7 +589,7 @@ void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
                                       const Matrix4& modelview,
                                       const RendererLight* light)
 {
-    _renderablesWithoutEntity.push_back(TransformedRenderable(renderable, modelview, light, NULL));
+    _renderables.push_back(TransformedRenderable(renderable, modelview, light, NULL));
 }
 
 void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
@@ -579,14 +597,32 @@ void OpenGLShaderPass::addRenderable(const OpenGLRenderable& renderable,
                                       const IRenderEntity& entity,
                                       const RendererLight* light)
 {
-    RenderablesByEntity::iterator i = _renderables.find(&entity);
+    _renderables.push_back(TransformedRenderable(renderable, modelview, light, &entity));
+}
+
+bool OpenGLShaderPass::stateDependsOnEntity() const
+{
+    return _glState.stage0 || _glState.stage1 || _glState.stage2 ||
+           _glState.stage3 || _glState.stage4;
+}
 
-    if (i == _renderables.end())
+void OpenGLShaderPass::sortRenderables()
+{
+    // The sorts are stable, sorting by light first leaves the renderables of
+    // each entity ordered by light
+    if (_glState.testRenderFlag(RENDER_BUMP))
     {
-        i = _renderables.insert(RenderablesByEntity::value_type(&entity, Renderables())).first;
+        util::radixSort(_renderables, _sortBuffer, [](const TransformedRenderable& r)
+        {
+            return reinterpret_cast<std::uintptr_t>(r.light);
+        });
     }
 
-    i->second.push_back(TransformedRenderable(renderable, modelview, light, &entity));
+    // Renderables without entity come first
+    util::radixSort(_renderables, _sortBuffer, [](const TransformedRenderable& r)
+    {
+        return reinterpret_cast<std::uintptr_t>(r.entity);
+    });
 }
 
 // Render the bucket contents
@@ -604,27 +640,42 @@ void OpenGLShaderPass::render(OpenGLState& current,
     // Apply our state to the current state object
     applyState(current, flagsMask, viewer, time, NULL);
 
-    if (!_renderablesWithoutEntity.empty())
-    {
-        renderAllContained(_renderablesWithoutEntity, current, viewer, time);
-    }
+    _polygonBatchStarted = false;
+
+    sortRenderables();
+
+    RenderStatistics::Instance().increasePrimitives(_renderables.size());
+
+    // Without stages there is nothing to re-evaluate for each entity
+    bool applyStatePerEntity = stateDependsOnEntity();
 
-    for (RenderablesByEntity::const_iterator i = _renderables.begin();
-         i != _renderables.end();
-         ++i)
+    Renderables::const_iterator group = _renderables.begin();
+
+    while (group != _renderables.end())
     {
-        // Apply our state to the current state object
-        applyState(current, flagsMask, viewer, time, i->first);
+        const IRenderEntity* entity = group->entity;
+
+        Renderables::const_iterator groupEnd = group;
 
-        if (!stateIsActive())
+        while (groupEnd != _renderables.end() && groupEnd->entity == entity)
         {
-            continue;
+            ++groupEnd;
+        }
+
+        if (entity != NULL && applyStatePerEntity)
+        {
+            // Apply our state to the current state object
+            applyState(current, flagsMask, viewer, time, entity);
         }
 
-        renderAllContained(i->second, current, viewer, time);
+        if (entity == NULL || stateIsActive())
+        {
+            renderAllContained(group, groupEnd, current, viewer, time);
+        }
+
+        group = groupEnd;
     }
 
-    _renderablesWithoutEntity.clear();
     _renderables.clear();
 }
 
@@ -690,42 +741,251 @@ void OpenGLShaderPass::setUpLightingCalculation(OpenGLState& current,
     current.glProgram->applyRenderParams(osViewer, objTransform, parms);
 }
 
+bool OpenGLShaderPass::canBatchPolygons(const OpenGLState& current) const
+{
+    // In line mode the triangulation would be visible
+    return current.testRenderFlag(RENDER_FILL) && GLEW_VERSION_1_5;
+}
+
+void OpenGLShaderPass::applyTransform(const Matrix4*& transform,
+                                      const Matrix4& newTransform,
+                                      const OpenGLState& current)
+{
+    // If the transform matrix is different from the last one, apply it and
+    // store it for the next call
+    if (transform == NULL ||
+        (transform != &newTransform && !transform->isAffineEqual(newTransform)))
+    {
+        transform = &newTransform;
+        RenderStatistics::Instance().increaseTransforms();
+
+        glPopMatrix();
+        glPushMatrix();
+        glMultMatrixd(*transform);
+
+        // Determine the face direction
+        if (current.testRenderFlag(RENDER_CULLFACE)
+            && transform->getHandedness() == Matrix4::RIGHTHANDED)
+        {
+            glFrontFace(GL_CW);
+        }
+        else
+        {
+            glFrontFace(GL_CCW);
+        }
+    }
+}
+
 // Flush renderables
-void OpenGLShaderPass::renderAllContained(const Renderables& renderables,
+void OpenGLShaderPass::renderAllContained(Renderables::const_iterator begin,
+                                          Renderables::const_iterator end,
                                           OpenGLState& current,
                                           const Vector3& viewer,
                                           std::size_t time)
 {
-    // Keep a pointer to the last transform matrix and render entity used
-    const Matrix4* transform = 0;
+    bool batchPolygons = canBatchPolygons(current);
 
-    glPushMatrix();
+    _batchRuns.clear();
+    _batchable.clear();
+    _pooledMeshes.clear();
+    _unbatched.clear();
 
-    // Iterate over each transformed renderable in the vector
-    for (const TransformedRenderable& r : renderables)
+    // Lit renderables have been sorted by light, which gives longer batches
+    for (Renderables::const_iterator r = begin; r != end; ++r)
     {
-        // If the current iteration's transform matrix was different from the
-        // last, apply it and store for the next iteration
-        if (transform == NULL ||
-            (transform != r.transform && !transform->isAffineEqual(*r.transform)))
+        if (batchPolygons && r->polygon != NULL)
+        {
+            _batchable.push_back(&(*r));
+        }
+        else if (r->mesh != NULL)
         {
-            transform = r.transform;
-            glPopMatrix();
-            glPushMatrix();
-            glMultMatrixd(*transform);
+            _pooledMeshes.push_back(&(*r));
+        }
+        else
+        {
+            _unbatched.push_back(*r);
+        }
+    }
 
-            // Determine the face direction
-            if (current.testRenderFlag(RENDER_CULLFACE)
-                && transform->getHandedness() == Matrix4::RIGHTHANDED)
-            {
-                glFrontFace(GL_CW);
-            }
-            else
+    if (!_batchable.empty())
+    {
+        renderBatchablePolygons(current, viewer, time);
+    }
+
+    if (!_pooledMeshes.empty())
+    {
+        renderPooledMeshes(current, viewer, time);
+    }
+
+    if (!_unbatched.empty())
+    {
+        renderIndividually(_unbatched.begin(), _unbatched.end(), current, viewer, time);
+    }
+}
+
+void OpenGLShaderPass::renderBatchablePolygons(OpenGLState& current,
+                                             const Vector3& viewer,
+                                             std::size_t time)
+{
+    PolygonBatchBuffer& batch = _owner.getPolygonBatch();
+
+    // The batches of the previous render() call are discarded once
+    if (!_polygonBatchStarted)
+    {
+        batch.begin();
+        _polygonBatchStarted = true;
+    }
+
+    // Collect the polygons into batches, a new batch is started whenever the
+    // transform or the light changes
+    const TransformedRenderable* runStart = NULL;
+
+    for (const TransformedRenderable* r : _batchable)
+    {
+        if (runStart != NULL && (runStart->light != r->light ||
+            (runStart->transform != r->transform && !runStart->transform->isAffineEqual(*r->transform))))
+        {
+            if (batch.endBatch())
             {
-                glFrontFace(GL_CCW);
+                _batchRuns.push_back(BatchRun{ runStart, batch.getBuffer().getNumBatches() - 1 });
             }
+
+            runStart = NULL;
         }
 
+        if (runStart == NULL)
+        {
+            runStart = r;
+        }
+
+        batch.addPolygon(*r->polygon);
+    }
+
+    if (runStart != NULL && batch.endBatch())
+    {
+        _batchRuns.push_back(BatchRun{ runStart, batch.getBuffer().getNumBatches() - 1 });
+    }
+
+    if (!_batchRuns.empty())
+    {
+        renderPolygonBatches(batch, current, viewer, time);
+    }
+}
+
+void OpenGLShaderPass::renderPooledMeshes(OpenGLState& current,
+                                          const Vector3& viewer,
+                                          std::size_t time)
+{
+    MeshBufferPool& pool = MeshBufferPool::Instance();
+
+    // The pool is bound once, each mesh only re-points the arrays
+    pool.beginDraw(current.getRenderFlags());
+
+    const Matrix4* transform = NULL;
+    std::size_t numDrawCalls = 0;
+
+    glPushMatrix();
+
+    for (const TransformedRenderable* r : _pooledMeshes)
+    {
+        MeshBufferPool::Handle handle = r->mesh->getPooledMesh();
+
+        if (handle == MeshBufferPool::INVALID_HANDLE)
+        {
+            continue;
+        }
+
+        applyTransform(transform, *r->transform, current);
+
+        if (current.glProgram && r->light)
+        {
+            setUpLightingCalculation(current, r->light, viewer, *transform, time);
+        }
+
+        pool.draw(handle);
+        ++numDrawCalls;
+    }
+
+    RenderStatistics::Instance().increaseDrawCalls(numDrawCalls);
+
+    glPopMatrix();
+
+    pool.endDraw();
+}
+
+void OpenGLShaderPass::renderPolygonBatches(const PolygonBatchBuffer& batch,
+                                            OpenGLState& current,
+                                            const Vector3& viewer,
+                                            std::size_t time)
+{
+    // Set up the same arrays as Winding::render() would
+    glDisableClientState(GL_COLOR_ARRAY);
+
+    if (current.testRenderFlag(RENDER_VERTEX_COLOUR))
+    {
+        glColor3f(1, 1, 1);
+    }
+
+    const IndexedVertexBuffer<BatchVertex>& buffer = batch.getBuffer();
+
+    bool renderBump = current.testRenderFlag(RENDER_BUMP) && !current.testRenderFlag(RENDER_TEXTURE_CUBEMAP);
+    buffer.bind(renderBump);
+
+    if (current.testRenderFlag(RENDER_TEXTURE_CUBEMAP))
+    {
+        // The vertex coordinate is used as cube map texture coordinate
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(3, GL_FLOAT, sizeof(BatchVertex),
+                          VertexTraits<BatchVertex>::VERTEX_OFFSET());
+    }
+    else if (!renderBump && current.testRenderFlag(RENDER_TEXTURE_2D))
+    {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    }
+
+    const Matrix4* transform = NULL;
+
+    glPushMatrix();
+
+    for (const BatchRun& run : _batchRuns)
+    {
+        applyTransform(transform, *run.renderable->transform, current);
+
+        if (current.glProgram && run.renderable->light)
+        {
+            setUpLightingCalculation(current, run.renderable->light, viewer, *transform, time);
+        }
+
+        buffer.renderBatch(run.batch, GL_TRIANGLES);
+    }
+
+    RenderStatistics::Instance().increaseDrawCalls(_batchRuns.size());
+
+    glPopMatrix();
+
+    buffer.unbind();
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+void OpenGLShaderPass::renderIndividually(Renderables::const_iterator begin,
+                                          Renderables::const_iterator end,
+                                          OpenGLState& current,
+                                          const Vector3& viewer,
+                                          std::size_t time)
+{
+    // Keep a pointer to the last transform matrix and render entity used
+    const Matrix4* transform = 0;
+
+    glPushMatrix();
+
+    // Iterate over each transformed renderable in the range
+    for (Renderables::const_iterator i = begin; i != end; ++i)
+    {
+        const TransformedRenderable& r = *i;
+
+        applyTransform(transform, *r.transform, current);
+
         // If we are using a lighting program and this renderable is lit, set
         // up the lighting calculation
         const RendererLight* light = r.light;
@@ -739,6 +999,8 @@ void OpenGLShaderPass::renderAllContained(const Renderables& renderables,
         r.renderable->render(info);
     }
 
+    RenderStatistics::Instance().increaseDrawCalls(end - begin);
+
     // Cleanup
     glPopMatrix();
 }
@@ -2,9 +2,11 @@
 
 #include "math/Vector3.h"
 #include "iglrender.h"
+#include "render/IndexedVertexBuffer.h"
+#include "render/MeshBufferPool.h"
+#include "render/PolygonBatch.h"
 
 #include <vector>
-#include <map>
 
 /* FORWARD DECLS */
 class Matrix4;
@@ -16,6 +18,9 @@ namespace render
     
 class OpenGLShader;
 
+// Vertex buffer holding the brush faces of a shader
+typedef PolygonBatch< IndexedVertexBuffer<BatchVertex> > PolygonBatchBuffer;
+
 /**
  * @brief A single component pass of an OpenGL shader.
  *
@@ -48,6 +53,21 @@ class OpenGLShaderPass
 		// The entity attached to this renderable
 		const IRenderEntity* entity;
 
+		// Non-NULL if the renderable can be drawn as part of a polygon batch
+		const IBatchablePolygon* polygon;
+
+		// Non-NULL if the renderable's geometry is stored in the MeshBufferPool
+		const IPooledMesh* mesh;
+
+		TransformedRenderable() :
+			renderable(NULL),
+			transform(NULL),
+			light(NULL),
+			entity(NULL),
+			polygon(NULL),
+			mesh(NULL)
+		{}
+
 		// Constructor
 		TransformedRenderable(const OpenGLRenderable& r,
 							  const Matrix4& t,
@@ -56,18 +76,35 @@ class OpenGLShaderPass
 		: renderable(&r),
 		  transform(&t),
 		  light(l),
-		  entity(e)
+		  entity(e),
+		  polygon(dynamic_cast<const IBatchablePolygon*>(&r)),
+		  mesh(dynamic_cast<const IPooledMesh*>(&r))
 		{}
 	};
 
-	// Vector of transformed renderables using this state
+	// The renderables submitted this frame. They are sorted by entity before
+	// rendering, the vectors keep their capacity between frames.
 	typedef std::vector<TransformedRenderable> Renderables;
-	Renderables _renderablesWithoutEntity;
-	
-	// Renderables sorted by RenderEntity
-	typedef std::map<const IRenderEntity*, Renderables> RenderablesByEntity;
+	Renderables _renderables;
 
-	RenderablesByEntity _renderables;
+	// Scratch space for sorting
+	Renderables _sortBuffer;
+
+	// A batch of polygons sharing the transform and light of the given renderable
+	struct BatchRun
+	{
+		const TransformedRenderable* renderable;
+		std::size_t batch;
+	};
+
+	// Working storage of renderAllContained(), kept to avoid reallocations
+	std::vector<BatchRun> _batchRuns;
+	std::vector<const TransformedRenderable*> _batchable;
+	std::vector<const TransformedRenderable*> _pooledMeshes;
+	Renderables _unbatched;
+
+	// True once the polygon batch has been reset during the current render() call
+	bool _polygonBatchStarted;
 
 private:
 
@@ -85,12 +122,49 @@ private:
 
 	void setupTextureMatrix(GLenum textureUnit, const ShaderLayerPtr& stage);
 
+	// Returns true if the stages have expressions which might depend on the entity
+	bool stateDependsOnEntity() const;
+
+	// Sort the renderables by entity, and by light within each entity in lit passes
+	void sortRenderables();
+
 	// Render all of the given TransformedRenderables
-	void renderAllContained(const Renderables& renderables,
+	void renderAllContained(Renderables::const_iterator begin,
+							Renderables::const_iterator end,
 							OpenGLState& current,
 						    const Vector3& viewer,
 							std::size_t time);
 
+	// Render the given TransformedRenderables one by one
+	void renderIndividually(Renderables::const_iterator begin,
+							Renderables::const_iterator end,
+							OpenGLState& current,
+							const Vector3& viewer,
+							std::size_t time);
+
+	// Collect the polygons in _batchable into batches of the shader and draw them
+	void renderBatchablePolygons(OpenGLState& current,
+								 const Vector3& viewer,
+								 std::size_t time);
+
+	// Draw the batches collected in _batchRuns from the given buffer
+	void renderPolygonBatches(const PolygonBatchBuffer& batch,
+							  OpenGLState& current,
+							  const Vector3& viewer,
+							  std::size_t time);
+
+	// Draw the renderables collected in _pooledMeshes from the MeshBufferPool
+	void renderPooledMeshes(OpenGLState& current,
+							const Vector3& viewer,
+							std::size_t time);
+
+	// Polygons are only batched when filled, as they are drawn as triangles
+	bool canBatchPolygons(const OpenGLState& current) const;
+
+	// Load the transform of the given renderable if it differs from the current one
+	void applyTransform(const Matrix4*& transform, const Matrix4& newTransform,
+						const OpenGLState& current);
+
     /* Helper functions to enable/disable particular GL states */
 
     void setTexture0();
@@ -122,7 +196,8 @@ private:
 public:
 
 	OpenGLShaderPass(OpenGLShader& owner) :
-		_owner(owner)
+		_owner(owner),
+		_polygonBatchStarted(false)
 	{}
 
 	/**
@@ -184,7 +259,7 @@ public:
 	 */
 	bool empty() const
 	{
-		return _renderables.empty() && _renderablesWithoutEntity.empty();
+		return _renderables.empty();
 	}
 
 	friend std::ostream& operator<<(std::ostream& st, const OpenGLShaderPass& self);
@@ -0,0 +1,124 @@
+#include "DepthSortedTraversal.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "ivolumetest.h"
+#include "math/AABB.h"
+#include "math/Vector4.h"
+
+namespace scene
+{
+
+DepthSortedTraversal::DepthSortedTraversal(const VolumeTest& volume) :
+	_volume(volume),
+	_viewProjection(volume.GetProjection().getMultipliedBy(volume.GetModelview())),
+	_visitedSPNodes(0),
+	_skippedSPNodes(0)
+{}
+
+bool DepthSortedTraversal::traverse(const ISPNode& root, const INode::VisitorFunc& functor,
+									const DepthFunc& continueAtDepth, bool visitHidden)
+{
+	_queue = Queue();
+
+	// The root node is entered in any case, its members are not
+	// necessarily contained in its bounds
+	_queue.push(Entry{ -1, &root, nullptr });
+
+	while (!_queue.empty())
+	{
+		Entry entry = _queue.top();
+		_queue.pop();
+
+		// Everything left in the queue is at this depth or behind it
+		if (!continueAtDepth(entry.depth))
+		{
+			return false;
+		}
+
+		if (entry.member != nullptr)
+		{
+			// We're done, as soon as the walker returns FALSE
+			if (!functor(*entry.member))
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		_visitedSPNodes++;
+
+		pushChildren(*entry.spNode, visitHidden);
+	}
+
+	return true;
+}
+
+void DepthSortedTraversal::pushChildren(const ISPNode& node, bool visitHidden)
+{
+	for (const INodePtr& member : node.getMembers())
+	{
+		// Skip hidden nodes, if specified
+		if (!visitHidden && !member->visible())
+		{
+			continue;
+		}
+
+		const AABB& bounds = member->worldAABB();
+
+		// Members with valid bounds outside the volume can't be hit
+		if (bounds.isValid() && _volume.TestAABB(bounds) == VOLUME_OUTSIDE)
+		{
+			continue;
+		}
+
+		_queue.push(Entry{ getNearestDepth(_viewProjection, bounds), nullptr, &member });
+	}
+
+	for (const ISPNodePtr& child : node.getChildNodes())
+	{
+		if (_volume.TestAABB(child->getBounds()) == VOLUME_OUTSIDE)
+		{
+			// Skip this node, not visible
+			_skippedSPNodes++;
+			continue;
+		}
+
+		// The members of the child node are contained in its bounds
+		_queue.push(Entry{ getNearestDepth(_viewProjection, child->getBounds()), child.get(), nullptr });
+	}
+}
+
+double DepthSortedTraversal::getNearestDepth(const Matrix4& viewProjection, const AABB& aabb)
+{
+	if (!aabb.isValid())
+	{
+		return -1;
+	}
+
+	Vector3 corners[8];
+	aabb.getCorners(corners);
+
+	// The depth is monotonic along the view direction, so the
+	// nearest point of the box is one of its corners
+	double nearest = std::numeric_limits<double>::max();
+
+	for (const Vector3& corner : corners)
+	{
+		Vector4 clipped = viewProjection.transform(Vector4(corner, 1));
+
+		if (clipped.w() <= 0)
+		{
+			// Reaches behind the viewer, this gets clipped at the near plane
+			return -1;
+		}
+
+		nearest = std::min(nearest, clipped.z() / clipped.w());
+	}
+
+	return std::max(nearest, -1.0);
+}
+
+} // namespace
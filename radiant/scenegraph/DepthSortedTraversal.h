@@ -0,0 +1,91 @@
+#pragma once
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "inode.h"
+#include "ispacepartition.h"
+#include "math/Matrix4.h"
+
+class VolumeTest;
+class AABB;
+
+namespace scene
+{
+
+/**
+ * Traverses a space partition front to back as seen through a volume. The
+ * members and the partition nodes are visited in the order of the nearest
+ * normalised device depth [-1..1] of their bounds, the members of a
+ * partition node are sorted in between its child nodes. Unlike the plain
+ * traversal, members with bounds outside of the volume are skipped too.
+ *
+ * Before visiting the next member or entering the next partition node, the
+ * depth functor is asked whether to continue, passing the depth nothing
+ * remaining in the traversal can be in front of. Selection uses this to stop
+ * as soon as the best candidate so far has been hit in front of that depth.
+ */
+class DepthSortedTraversal
+{
+public:
+	// Returns false to stop the traversal at the given depth
+	typedef std::function<bool(double)> DepthFunc;
+
+private:
+	const VolumeTest& _volume;
+
+	// Projection of the volume, without the scissor (which doesn't affect the depth)
+	Matrix4 _viewProjection;
+
+	struct Entry
+	{
+		double depth;
+
+		// Either a partition node or one of its members
+		const ISPNode* spNode;
+		const INodePtr* member;
+	};
+
+	// Puts the nearest entry on top of the queue
+	struct FurtherAway
+	{
+		bool operator()(const Entry& a, const Entry& b) const
+		{
+			return a.depth > b.depth;
+		}
+	};
+
+	typedef std::priority_queue<Entry, std::vector<Entry>, FurtherAway> Queue;
+	Queue _queue;
+
+	std::size_t _visitedSPNodes;
+	std::size_t _skippedSPNodes;
+
+public:
+	DepthSortedTraversal(const VolumeTest& volume);
+
+	// Visits the members of the partition below the given root node, returns false
+	// if the traversal has been stopped by either the visitor or the depth functor
+	bool traverse(const ISPNode& root, const INode::VisitorFunc& functor,
+				  const DepthFunc& continueAtDepth, bool visitHidden);
+
+	std::size_t getNumVisitedSPNodes() const
+	{
+		return _visitedSPNodes;
+	}
+
+	std::size_t getNumSkippedSPNodes() const
+	{
+		return _skippedSPNodes;
+	}
+
+	// The nearest normalised device depth of the given box, -1 if the box is
+	// invalid or reaches behind the viewer
+	static double getNearestDepth(const Matrix4& viewProjection, const AABB& aabb);
+
+private:
+	void pushChildren(const ISPNode& node, bool visitHidden);
+};
+
+} // namespace
@@ -17,7 +17,7 @@ namespace
 
 Octree::Octree()
 {
-	_root = OctreeNodePtr(new OctreeNode(*this, START_AABB));
+	_root = OctreeNode::Create(*this, START_AABB);
 }
 
 Octree::~Octree()
@@ -29,7 +29,7 @@ Octree::~Octree()
 void Octree::link(const scene::INodePtr& sceneNode)
 {
 	// Make sure we don't do double-links
-	assert(_nodeMapping.find(sceneNode) == _nodeMapping.end());
+	assert(_nodeMapping.find(sceneNode.get()) == _nodeMapping.end());
 
 	// Make sure the root node is large enough
 	ensureRootSize(sceneNode);
@@ -58,7 +58,7 @@ void Octree::ensureRootSize(const scene::INodePtr& sceneNode)
 		}
 
 		// Allocate a new root node and subdivide it once
-		OctreeNodePtr newRootPtr(new OctreeNode(*this, newBounds));
+		OctreeNodePtr newRootPtr = OctreeNode::Create(*this, newBounds);
 
 		OctreeNode& newRoot = *newRootPtr;
 		OctreeNode& oldRoot = *_root;
@@ -108,28 +108,91 @@ void Octree::ensureRootSize(const scene::INodePtr& sceneNode)
 // Unlink this node from the SP tree
 bool Octree::unlink(const scene::INodePtr& sceneNode)
 {
-	NodeMapping::iterator found = _nodeMapping.find(sceneNode);
+	NodeMapping::iterator found = _nodeMapping.find(sceneNode.get());
 
 	if (found != _nodeMapping.end())
 	{
-		// Lookup successful, unlink the node (will fire notifyUnlink())
-		found->second->unlink(sceneNode);
+		// Lookup successful, remove the mapping first, the swap-remove
+		// will update the entry of the member moving into the slot
+		MemberSlot slot = found->second;
+		_nodeMapping.erase(found);
+
+		slot.node->removeMember(slot.index);
 		return true;
 	}
 
 	return false;
 }
 
+bool Octree::relink(const scene::INodePtr& sceneNode)
+{
+	// Acquire the bounds before looking at the mapping, in case
+	// the evaluation is triggering another relink
+	const AABB& bounds = sceneNode->worldAABB();
+
+	NodeMapping::iterator found = _nodeMapping.find(sceneNode.get());
+
+	if (found == _nodeMapping.end())
+	{
+		return false;
+	}
+
+	MemberSlot slot = found->second;
+
+	// Most of the time the node is still fitting into its octant
+	if (slot.node->isBestFitFor(bounds))
+	{
+		return true;
+	}
+
+	_nodeMapping.erase(found);
+	slot.node->removeMember(slot.index);
+
+	// Walk up to the first octant encompassing the new bounds
+	OctreeNode* start = slot.node;
+
+	if (bounds.isValid())
+	{
+		while (start->getParentNode() != nullptr && !start->getBounds().contains(bounds))
+		{
+			start = start->getParentNode();
+		}
+
+		if (!start->getBounds().contains(bounds))
+		{
+			// Not even the root is large enough
+			ensureRootSize(sceneNode);
+			start = _root.get();
+		}
+	}
+	else
+	{
+		start = _root.get();
+	}
+
+	start->linkRecursively(sceneNode);
+
+	return true;
+}
+
+void Octree::relink(const std::vector<scene::INodePtr>& sceneNodes)
+{
+	for (const scene::INodePtr& node : sceneNodes)
+	{
+		relink(node);
+	}
+}
+
 // Returns the root node of this SP tree
 ISPNodePtr Octree::getRoot() const
 {
 	return _root;
 }
 
-void Octree::notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node)
+void Octree::notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node, std::size_t index)
 {
 	std::pair<NodeMapping::iterator, bool> result =
-		_nodeMapping.insert(NodeMapping::value_type(sceneNode, node));
+		_nodeMapping.insert(NodeMapping::value_type(sceneNode.get(), MemberSlot{ node, index }));
 
 	assert(result.second);
 }
@@ -137,20 +200,31 @@ void Octree::notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node)
 void Octree::notifyUnlink(const scene::INodePtr& sceneNode, OctreeNode* node)
 {
 	// Remove the node from the lookup table, if found
-	NodeMapping::iterator found = _nodeMapping.find(sceneNode);
+	NodeMapping::iterator found = _nodeMapping.find(sceneNode.get());
 
 	assert(found != _nodeMapping.end());
+	assert(found->second.node == node);
 
 	_nodeMapping.erase(found);
 }
 
+void Octree::notifyRelocate(const scene::INodePtr& sceneNode, OctreeNode* node, std::size_t index)
+{
+	NodeMapping::iterator found = _nodeMapping.find(sceneNode.get());
+
+	assert(found != _nodeMapping.end());
+
+	found->second.node = node;
+	found->second.index = index;
+}
+
 #ifdef _DEBUG
 void Octree::notifyErase(OctreeNode* node)
 {
 	// Remove the node from the lookup table, if found
 	for (NodeMapping::iterator i = _nodeMapping.begin(); i != _nodeMapping.end(); ++i)
 	{
-		assert(i->second != node);
+		assert(i->second.node != node);
 	}
 }
 #endif
@@ -2,7 +2,8 @@
 #define _OCTREE_H_
 
 #include "ispacepartition.h"
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace scene
 {
@@ -36,7 +37,13 @@ typedef std::shared_ptr<OctreeNode> OctreeNodePtr;
  * The Octree maintains a lookup table (NodeMapping) to implement a fast unlink()
  * algorithm. The scene::INodes don't know or care where they are linked to, so
  * it needs a fast lookup to avoid having to traverse the entire tree to find and
- * remove a single node.
+ * remove a single node. The table is hashed on the node address and stores the
+ * member index too, such that unlinking is a constant-time swap-remove.
+ *
+ * When a node's bounds change, relink() only touches the tree if the node
+ * doesn't fit its current OctreeNode anymore (or fits into one of its children)
+ * and re-inserts it starting at the nearest ancestor which is large enough,
+ * instead of descending from the root again.
  */
 class Octree :
 	public ISpacePartitionSystem
@@ -45,8 +52,17 @@ private:
 	// The root node of this SP
 	OctreeNodePtr _root;
 
-	// Maps scene nodes against octree nodes, for fast lookup during unlink
-	typedef std::map<INodePtr, OctreeNode*> NodeMapping;
+	// The position of a scene node in the tree: the octree node and the
+	// index in that node's member list
+	struct MemberSlot
+	{
+		OctreeNode* node;
+		std::size_t index;
+	};
+
+	// Maps scene nodes against octree nodes, for fast lookup during unlink.
+	// The scene nodes are kept alive by the member lists of the octree nodes.
+	typedef std::unordered_map<const INode*, MemberSlot> NodeMapping;
 	NodeMapping _nodeMapping;
 
 public:
@@ -60,13 +76,23 @@ public:
 	// Unlink this node from the SP tree, returns true if found
 	bool unlink(const scene::INodePtr& sceneNode);
 
+	// Moves the node to the correct octant after its bounds changed,
+	// returns false if the node is not linked
+	bool relink(const scene::INodePtr& sceneNode);
+
+	// Relinks all the given nodes, unlinked ones are ignored
+	void relink(const std::vector<scene::INodePtr>& sceneNodes);
+
 	// Returns the root node of this SP tree
 	ISPNodePtr getRoot() const;
 
 	// Callback used by the OctreeNodes to let the tree update its caching structures
-	void notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node);
+	void notifyLink(const scene::INodePtr& sceneNode, OctreeNode* node, std::size_t index);
 	void notifyUnlink(const scene::INodePtr& sceneNode, OctreeNode* node);
 
+	// Called when a member has been moved to a different node or index
+	void notifyRelocate(const scene::INodePtr& sceneNode, OctreeNode* node, std::size_t index);
+
 #ifdef _DEBUG
 	// In debug builds, this ensures that no octree node is deleted
 	// while it is still mapped in the NodeMapping table
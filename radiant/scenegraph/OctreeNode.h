@@ -15,6 +15,7 @@ namespace scene
 
 class OctreeNode;
 typedef std::shared_ptr<OctreeNode> OctreeNodePtr;
+typedef std::weak_ptr<OctreeNode> OctreeNodeWeakPtr;
 
 /**
  * greebo: An OctreeNode is the atomic unit part of an Octree.
@@ -30,20 +31,25 @@ typedef std::shared_ptr<OctreeNode> OctreeNodePtr;
  *
  * Once a leaf OctreeNode exceeds a given amount of members (SUBDIVISION_THRESHOLD)
  * it will subdivide itself and re-link its members into its children.
+ *
+ * The 8 children of a node are allocated as one contiguous block, the
+ * shared pointers in the child list are all referring to that block.
  */
 class OctreeNode :
-	public ISPNode,
-	public std::enable_shared_from_this<OctreeNode>
+	public ISPNode
 {
 protected:
 	// The owning octree
-	Octree& _owner;
+	Octree* _owner;
 
 	// Our bounds (which should be valid at all times
 	AABB _bounds;
 
-	// The parent node
-	ISPNodeWeakPtr _parent;
+	// The parent node (NULL for the root node)
+	OctreeNode* _parent;
+
+	// Weak reference to ourselves, used to hand out the parent pointer
+	OctreeNodeWeakPtr _self;
 
 	// The child nodes (8 or 0)
 	NodeList _children;
@@ -52,35 +58,51 @@ protected:
 	MemberList _members;
 
 public:
-	// Construct a node using bounds, owning Octree and parent node
-	OctreeNode(Octree& owner, const AABB& bounds, const OctreeNodePtr& parent = OctreeNodePtr()) :
-		_owner(owner),
+	// Default constructor, used for the child blocks, see initialise()
+	OctreeNode() :
+		_owner(nullptr),
+		_parent(nullptr)
+	{}
+
+	// Construct a node using bounds and owning Octree (without parent)
+	OctreeNode(Octree& owner, const AABB& bounds) :
+		_owner(&owner),
 		_bounds(bounds),
-		_parent(parent)
+		_parent(nullptr)
 	{
 		assert(_bounds.isValid()); // require valid bounds
 	}
 
-	// Construct a node using AABB components
-	OctreeNode(Octree& owner, const Vector3& origin, const Vector3& extents,
-			   const OctreeNodePtr& parent = OctreeNodePtr()) :
-		_owner(owner),
-		_bounds(origin, extents),
-		_parent(parent)
-	{}
-
 #ifdef _DEBUG
 	// In debug builds, notify the owning octree about our deletion
 	~OctreeNode()
 	{
-		_owner.notifyErase(this);
+		if (_owner != nullptr)
+		{
+			_owner->notifyErase(this);
+		}
 	}
 #endif
 
+	// Creates a new parentless node, to be used as root of the given Octree
+	static OctreeNodePtr Create(Octree& owner, const AABB& bounds)
+	{
+		OctreeNodePtr node(new OctreeNode(owner, bounds));
+		node->_self = node;
+
+		return node;
+	}
+
 	// Get the parent node (can be NULL for the root node)
 	ISPNodePtr getParent() const
 	{
-		return _parent.lock();
+		return _parent != nullptr ? _parent->_self.lock() : ISPNodePtr();
+	}
+
+	// The parent as OctreeNode (NULL for the root node)
+	OctreeNode* getParentNode() const
+	{
+		return _parent;
 	}
 
 	// The maximum bounds of this node
@@ -110,8 +132,13 @@ public:
 	// Subdivide this octree node (adding 8 child nodes)
 	void subdivide()
 	{
-		// Allocate 8 nodes
-		_children.resize(8);
+		// Allocate 8 nodes in one go, together with their reference count
+		struct ChildBlock
+		{
+			OctreeNode nodes[8];
+		};
+
+		std::shared_ptr<ChildBlock> block = std::make_shared<ChildBlock>();
 
 		// Each child node has half the extents of this node
 		Vector3 childExtents = _bounds.extents * 0.5;
@@ -125,16 +152,27 @@ public:
 		Vector3 baseLower = _bounds.origin - z;
 
 		// Upper half of the cube
-		_children[0] = OctreeNodePtr(new OctreeNode(_owner, baseUpper + x + y, childExtents, shared_from_this()));
-		_children[1] = OctreeNodePtr(new OctreeNode(_owner, baseUpper + x - y, childExtents, shared_from_this()));
-		_children[2] = OctreeNodePtr(new OctreeNode(_owner, baseUpper - x - y, childExtents, shared_from_this()));
-		_children[3] = OctreeNodePtr(new OctreeNode(_owner, baseUpper - x + y, childExtents, shared_from_this()));
+		block->nodes[0].initialise(*_owner, baseUpper + x + y, childExtents, this);
+		block->nodes[1].initialise(*_owner, baseUpper + x - y, childExtents, this);
+		block->nodes[2].initialise(*_owner, baseUpper - x - y, childExtents, this);
+		block->nodes[3].initialise(*_owner, baseUpper - x + y, childExtents, this);
 
 		// Lower half of the cube
-		_children[4] = OctreeNodePtr(new OctreeNode(_owner, baseLower + x + y, childExtents, shared_from_this()));
-		_children[5] = OctreeNodePtr(new OctreeNode(_owner, baseLower + x - y, childExtents, shared_from_this()));
-		_children[6] = OctreeNodePtr(new OctreeNode(_owner, baseLower - x - y, childExtents, shared_from_this()));
-		_children[7] = OctreeNodePtr(new OctreeNode(_owner, baseLower - x + y, childExtents, shared_from_this()));
+		block->nodes[4].initialise(*_owner, baseLower + x + y, childExtents, this);
+		block->nodes[5].initialise(*_owner, baseLower + x - y, childExtents, this);
+		block->nodes[6].initialise(*_owner, baseLower - x - y, childExtents, this);
+		block->nodes[7].initialise(*_owner, baseLower - x + y, childExtents, this);
+
+		_children.resize(8);
+
+		for (std::size_t i = 0; i < 8; ++i)
+		{
+			// The child pointers share the ownership of the block
+			OctreeNodePtr child(block, &block->nodes[i]);
+			child->_self = child;
+
+			_children[i] = child;
+		}
 	}
 
 	// Indexing operator to retrieve a certain child
@@ -149,14 +187,13 @@ public:
 	// This method moves all the contents (members) of this node to the "other" target node
 	void relocateMembersTo(OctreeNode& target)
 	{
-		// Copy all members from here to the target
-		target._members.insert(target._members.end(), _members.begin(), _members.end());
+		target._members.reserve(target._members.size() + _members.size());
 
-		// Notify the Octree about the relocation
+		// Move all members from here to the target and notify the Octree about the relocation
 		for (ISPNode::MemberList::iterator i = _members.begin(); i != _members.end(); ++i)
 		{
-			_owner.notifyUnlink(*i, this);
-			_owner.notifyLink(*i, &target);
+			target._members.push_back(*i);
+			_owner->notifyRelocate(*i, &target, target._members.size() - 1);
 		}
 
 		// Clear our own member list
@@ -178,13 +215,51 @@ public:
 
 	void addMember(const scene::INodePtr& sceneNode)
 	{
-		assert(std::find(_members.begin(), _members.end(), sceneNode) == _members.end());
-
 		// Add to the internal list
 		_members.push_back(sceneNode);
 
 		// Notify the Octree to update lookup caches
-		_owner.notifyLink(sceneNode, this);
+		_owner->notifyLink(sceneNode, this, _members.size() - 1);
+	}
+
+	// Removes the member at the given index, by moving the last member into its place
+	void removeMember(std::size_t index)
+	{
+		assert(index < _members.size());
+
+		if (index + 1 < _members.size())
+		{
+			_members[index] = std::move(_members.back());
+			_owner->notifyRelocate(_members[index], this, index);
+		}
+
+		_members.pop_back();
+	}
+
+	// Returns true if linkRecursively() would add a scene node with the given
+	// bounds as member of this very node
+	bool isBestFitFor(const AABB& bounds) const
+	{
+		if (!bounds.isValid())
+		{
+			// Nodes with invalid bounds are stored in the root
+			return _parent == nullptr;
+		}
+
+		if (!_bounds.contains(bounds))
+		{
+			return false;
+		}
+
+		for (std::size_t i = 0, size = _children.size(); i < size; ++i)
+		{
+			if (_children[i]->getBounds().contains(bounds))
+			{
+				return false;
+			}
+		}
+
+		return true;
 	}
 
 	// Links the given scene object into the tree
@@ -250,7 +325,7 @@ public:
 			for (ISPNode::MemberList::iterator i = oldList.begin(); i != oldList.end(); ++i)
 			{
 				// Notify the owner about the re-link
-				_owner.notifyUnlink(*i, this);
+				_owner->notifyUnlink(*i, this);
 
 				// Call ourselves. The fact that we have 8 children now ensures that we won't be
 				// going down the same code path here again
@@ -261,30 +336,20 @@ public:
 		return this;
 	}
 
-	void unlink(const scene::INodePtr& sceneNode)
+private:
+	void initialise(Octree& owner, const Vector3& origin, const Vector3& extents, OctreeNode* parent)
 	{
-		// Lookup the node in the members list (rather slow lookup)
-		ISPNode::MemberList::iterator found =
-			std::find(_members.begin(), _members.end(), sceneNode);
-
-		if (found != _members.end())
-		{
-			_members.erase(found);
-		}
-
-		// Let the Octree know about this, regardless whether we found it or not (the Octree relies on this)
-		_owner.notifyUnlink(sceneNode, this);
+		_owner = &owner;
+		_bounds = AABB(origin, extents);
+		_parent = parent;
 	}
 
-private:
 	// Tells each children who their parent is
 	void reparentChildren()
 	{
-		ISPNodePtr self = shared_from_this();
-
 		for (std::size_t i = 0; i < _children.size(); ++i)
 		{
-			static_cast<OctreeNode&>(*_children[i])._parent = self;
+			static_cast<OctreeNode&>(*_children[i])._parent = this;
 		}
 	}
 };
@@ -1,5 +1,7 @@
 #include "SceneGraph.h"
 
+#include <unordered_set>
+
 #include "ivolumetest.h"
 #include "itextstream.h"
 
@@ -8,6 +10,7 @@
 
 #include "math/AABB.h"
 #include "Octree.h"
+#include "DepthSortedTraversal.h"
 #include "SceneGraphFactory.h"
 #include "util/ScopedBoolLock.h"
 #include "modulesystem/StaticModule.h"
@@ -162,11 +165,8 @@ void SceneGraph::nodeBoundsChanged(const INodePtr& node)
         return;
     }
 
-	if (_spacePartition->unlink(node))
-	{
-		// unlink returned true, so the given node was linked before => re-link it
-		_spacePartition->link(node);
-	}
+	// Nodes which are not linked are ignored
+	_spacePartition->relink(node);
 }
 
 void SceneGraph::foreachNode(const INode::VisitorFunc& functor)
@@ -250,6 +250,27 @@ void SceneGraph::foreachVisibleNodeInVolume(const VolumeTest& volume, Walker& wa
 		false); // don't visit hidden
 }
 
+void SceneGraph::foreachVisibleNodeFrontToBack(const VolumeTest& volume, Walker& walker,
+    const std::function<bool(double)>& continueAtDepth)
+{
+    // Update the bounds before the traversal, see foreachNodeInVolume()
+    if (_root != nullptr) _root->worldAABB();
+
+    {
+        // Buffer any calls that might happen in between
+        util::ScopedBoolLock traversal(_traversalOngoing);
+
+        DepthSortedTraversal depthSorted(volume);
+
+        depthSorted.traverse(*_spacePartition->getRoot(),
+            [&] (const INodePtr& node) { return walker.visit(node); },
+            continueAtDepth, false); // don't visit hidden
+    }
+
+    // Traversal finished, flush the action buffer
+    flushActionBuffer();
+}
+
 bool SceneGraph::foreachNodeInVolume_r(const ISPNode& node, const VolumeTest& volume, 
 									   const INode::VisitorFunc& functor, bool visitHidden)
 {
@@ -305,7 +326,13 @@ ISpacePartitionSystemPtr SceneGraph::getSpacePartition()
 
 void SceneGraph::flushActionBuffer()
 {
-    // Do any actions now, in the same order they came in
+    // The bounds changes are collected and relinked in one go, after the
+    // insertions and removals. Relinking reads the current bounds of each node,
+    // so the position of the change within the sequence doesn't matter.
+    std::vector<INodePtr> changedNodes;
+    std::unordered_set<INode*> visited;
+
+    // Do any other actions now, in the same order they came in
     for (NodeAction& action : _actionBuffer)
     {
         switch (action.first)
@@ -317,12 +344,20 @@ void SceneGraph::flushActionBuffer()
             erase(action.second);
             break;
         case BoundsChange:
-            nodeBoundsChanged(action.second);
+            if (visited.insert(action.second.get()).second)
+            {
+                changedNodes.push_back(action.second);
+            }
             break;
         };
     }
 
     _actionBuffer.clear();
+
+    if (!changedNodes.empty())
+    {
+        _spacePartition->relink(changedNodes);
+    }
 }
 
 // RegisterableModule implementation
@@ -91,6 +91,9 @@ public:
     void foreachNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor) override;
     void foreachVisibleNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor) override;
 
+    void foreachVisibleNodeFrontToBack(const VolumeTest& volume, Walker& walker,
+        const std::function<bool(double)>& continueAtDepth) override;
+
     ISpacePartitionSystemPtr getSpacePartition() override;
 private:
 	void foreachNodeInVolume(const VolumeTest& volume, const INode::VisitorFunc& functor, bool visitHidden);
@@ -5,6 +5,7 @@
 #include "igrid.h"
 #include "iselectiongroup.h"
 #include "iradiant.h"
+#include "ithread.h"
 #include "ieventmanager.h"
 #include "ipreferencesystem.h"
 #include "imousetoolmanager.h"
@@ -30,6 +31,27 @@
 namespace selection
 {
 
+namespace
+{
+    // Visits the visible nodes in the given view. If only the nearest candidate is of
+    // interest, the nodes are visited front to back and the traversal ends as soon as
+    // none of the remaining nodes can beat the best candidate of the given pool.
+    void foreachCandidateNode(const render::View& view, scene::Graph::Walker& walker,
+                              const SelectionPool& pool, bool nearestOnly)
+    {
+        if (!nearestOnly)
+        {
+            GlobalSceneGraph().foreachVisibleNodeInVolume(view, walker);
+            return;
+        }
+
+        GlobalSceneGraph().foreachVisibleNodeFrontToBack(view, walker, [&](double depth)
+        {
+            return !pool.hasBestInFrontOf(depth);
+        });
+    }
+}
+
 // --------- RadiantSelectionSystem Implementation ------------------------------------------
 
 RadiantSelectionSystem::RadiantSelectionSystem() :
@@ -71,7 +93,8 @@ void RadiantSelectionSystem::notifyObservers(const scene::INodePtr& node, bool i
 
 void RadiantSelectionSystem::testSelectScene(SelectablesList& targetList, SelectionTest& test,
                                              const render::View& view, SelectionSystem::EMode mode,
-                                             SelectionSystem::EComponentMode componentMode)
+                                             SelectionSystem::EComponentMode componentMode,
+                                             bool nearestOnly)
 {
     // The (temporary) storage pool
     SelectionPool selector;
@@ -83,7 +106,7 @@ void RadiantSelectionSystem::testSelectScene(SelectablesList& targetList, Select
         {
             // Instantiate a walker class which is specialised for selecting entities
             EntitySelector entityTester(selector, test);
-            GlobalSceneGraph().foreachVisibleNodeInVolume(view, entityTester);
+            foreachCandidateNode(view, entityTester, selector, nearestOnly);
 
             for (SelectionPool::const_iterator i = selector.begin(); i != selector.end(); ++i)
             {
@@ -99,7 +122,7 @@ void RadiantSelectionSystem::testSelectScene(SelectablesList& targetList, Select
             {
                 // Test for any visible elements (primitives, entities), but don't select child primitives
                 AnySelector anyTester(selector, test);
-                GlobalSceneGraph().foreachVisibleNodeInVolume(view, anyTester);
+                foreachCandidateNode(view, anyTester, selector, nearestOnly);
             }
             else
             {
@@ -107,11 +130,15 @@ void RadiantSelectionSystem::testSelectScene(SelectablesList& targetList, Select
 
                 // First, obtain all the selectable entities
                 EntitySelector entityTester(selector, test);
-                GlobalSceneGraph().foreachVisibleNodeInVolume(view, entityTester);
-
-                // Now retrieve all the selectable primitives
-                PrimitiveSelector primitiveTester(sel2, test);
-                GlobalSceneGraph().foreachVisibleNodeInVolume(view, primitiveTester);
+                foreachCandidateNode(view, entityTester, selector, nearestOnly);
+
+                // Now retrieve all the selectable primitives, these are only
+                // preferred if there is no entity candidate
+                if (!nearestOnly || selector.empty())
+                {
+                    PrimitiveSelector primitiveTester(sel2, test);
+                    foreachCandidateNode(view, primitiveTester, sel2, nearestOnly);
+                }
             }
 
             // Add the first selection crop to the target vector
@@ -138,7 +165,7 @@ void RadiantSelectionSystem::testSelectScene(SelectablesList& targetList, Select
         {
             // Retrieve all the selectable primitives of group nodes
             GroupChildPrimitiveSelector primitiveTester(selector, test);
-            GlobalSceneGraph().foreachVisibleNodeInVolume(view, primitiveTester);
+            foreachCandidateNode(view, primitiveTester, selector, nearestOnly);
 
             // Add the selection crop to the target vector
             for (SelectionPool::const_iterator i = selector.begin(); i != selector.end(); ++i)
@@ -571,12 +598,15 @@ void RadiantSelectionSystem::SelectPoint(const render::View& view,
         // The possible candidates are stored in the SelectablesSet
         SelectablesList candidates;
 
+        // Cycling needs all the candidates, the other modes only the nearest one
+        bool nearestOnly = modifier == eToggle || modifier == eReplace;
+
         if (face)
         {
             SelectionPool selector;
 
             ComponentSelector selectionTester(selector, volume, eFace);
-            GlobalSceneGraph().foreachVisibleNodeInVolume(scissored, selectionTester);
+            foreachCandidateNode(scissored, selectionTester, selector, nearestOnly);
 
             // Load them all into the vector
             for (SelectionPool::const_iterator i = selector.begin(); i != selector.end(); ++i)
@@ -585,7 +615,7 @@ void RadiantSelectionSystem::SelectPoint(const render::View& view,
             }
         }
         else {
-            testSelectScene(candidates, volume, scissored, Mode(), ComponentMode());
+            testSelectScene(candidates, volume, scissored, Mode(), ComponentMode(), nearestOnly);
         }
 
         // Was the selection test successful (have we found anything to select)?
@@ -754,6 +784,13 @@ void RadiantSelectionSystem::onManipulationStart()
 
 void RadiantSelectionSystem::onManipulationChanged()
 {
+	// Rebuild the transformed brushes in one batch, rather than one by one
+	// when they are rendered or asked for their bounds
+	std::vector<Brush*> brushes;
+	foreachBrush([&](Brush& brush) { brushes.push_back(&brush); });
+
+	Brush::evaluateBReps(brushes, GlobalRadiant().getThreadManager().getTaskScheduler());
+
 	_requestWorkZoneRecalculation = true;
 	_requestSceneGraphChange = false;
 
@@ -170,9 +170,11 @@ protected:
 	virtual void onIdle() override;
 
 	// Traverses the scene and adds any selectable nodes matching the given SelectionTest to the "targetList".
+	// With nearestOnly set, only the first element of the list is of interest, the traversal
+	// stops as soon as no remaining node can be closer than the best candidate so far.
 	void testSelectScene(SelectablesList& targetList, SelectionTest& test,
 						 const render::View& view, SelectionSystem::EMode mode,
-						 SelectionSystem::EComponentMode componentMode);
+						 SelectionSystem::EComponentMode componentMode, bool nearestOnly = false);
 
 private:
 	void notifyObservers(const scene::INodePtr& node, bool isComponent);
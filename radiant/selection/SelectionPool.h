@@ -118,8 +118,19 @@ public:
 		return _pool.end();
 	}
 
-	bool empty()
+	bool empty() const
 	{
 		return _pool.empty();
 	}
+
+	/**
+	 * Returns true if nothing at the given depth or behind it can be a better
+	 * candidate than the best one in this pool. This is the case once the best
+	 * candidate has been hit directly (at zero distance) in front of that depth.
+	 */
+	bool hasBestInFrontOf(double depth) const
+	{
+		return !_pool.empty() && _pool.begin()->first.distance() == 0 &&
+			_pool.begin()->first.depth() < depth;
+	}
 };
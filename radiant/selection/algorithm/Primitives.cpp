@@ -5,6 +5,8 @@
 #include "i18n.h"
 #include "igroupnode.h"
 #include "ientity.h"
+#include "iradiant.h"
+#include "ithread.h"
 #include "itextstream.h"
 #include "iundo.h"
 #include "imainframe.h"
@@ -41,6 +43,7 @@ namespace algorithm
 namespace
 {
 	const char* const GKEY_CM_EXT = "/defaults/collisionModelExt";
+	const char* const GKEY_COLLISION_SHADER = "/defaults/collisionTexture";
 	const char* const GKEY_NODRAW_SHADER = "/defaults/nodrawShader";
 	const char* const GKEY_VISPORTAL_SHADER = "/defaults/visportalShader";
 	const char* const GKEY_MONSTERCLIP_SHADER = "/defaults/monsterClipShader";
@@ -130,89 +133,156 @@ FacePtrVector getSelectedFaces()
 	return vector;
 }
 
-// Try to create a CM from the selected entity
+namespace
+{
+	// Copies the geometry of the given brush, the windings must have been evaluated
+	cmutil::BrushGeometry getCollisionGeometry(const Brush& brush)
+	{
+		cmutil::BrushGeometry geometry;
+		geometry.bounds = brush.localAABB();
+
+		for (Brush::const_iterator i = brush.begin(); i != brush.end(); ++i)
+		{
+			cmutil::FaceGeometry face;
+			face.plane = (*i)->plane3();
+
+			for (const WindingVertex& vertex : (*i)->getWinding())
+			{
+				face.winding.push_back(vertex.vertex);
+			}
+
+			geometry.faces.push_back(face);
+		}
+
+		return geometry;
+	}
+
+	void saveCollisionModel(const cmutil::CollisionModel& cm, const std::string& modelPath)
+	{
+		std::string newExtension = "." + game::current::getValue<std::string>(GKEY_CM_EXT);
+
+		try {
+			// create the new autosave filename by changing the extension
+			fs::path cmPath = os::replaceExtension(modelPath, newExtension);
+
+			// Open the stream to the output file
+			std::ofstream outfile(cmPath.string().c_str());
+
+			if (outfile.is_open()) {
+				// Insert the CollisionModel into the stream
+				outfile << cm;
+				// Close the file
+				outfile.close();
+
+				rMessage() << "CollisionModel saved to " << cmPath.string() << std::endl;
+			}
+			else {
+				wxutil::Messagebox::ShowError(
+					fmt::format("Couldn't save to file: {0}", cmPath.string()));
+			}
+		}
+		catch (const fs::filesystem_error& f) {
+			rError() << "CollisionModel: " << f.what() << std::endl;
+		}
+	}
+}
+
+// Try to create a CM from each selected entity
 void createCMFromSelection(const cmd::ArgumentList& args) {
 	// Check the current selection state
 	const SelectionInfo& info = GlobalSelectionSystem().getSelectionInfo();
 
-	if (info.totalCount == info.entityCount && info.totalCount == 1) {
-		// Retrieve the node, instance and entity
-		const scene::INodePtr& entityNode = GlobalSelectionSystem().ultimateSelected();
+	if (info.totalCount != info.entityCount || info.totalCount == 0) {
+		wxutil::Messagebox::ShowError(
+			_(ERRSTR_WRONG_SELECTION.c_str()));
+		return;
+	}
 
-		// Try to retrieve the group node
-		scene::GroupNodePtr groupNode = Node_getGroupNode(entityNode);
+	std::vector<scene::INodePtr> entityNodes;
 
-		// Remove the entity origin from the brushes
-		if (groupNode != NULL) {
-			groupNode->removeOriginFromChildren();
+	GlobalSelectionSystem().foreachSelected([&](const scene::INodePtr& node)
+	{
+		// Only group nodes can contain the collision hull brushes
+		if (Node_getGroupNode(node))
+		{
+			entityNodes.push_back(node);
+		}
+	});
 
-			// Deselect the node
-			Node_setSelected(entityNode, false);
+	if (entityNodes.empty()) {
+		wxutil::Messagebox::ShowError(
+			_(ERRSTR_WRONG_SELECTION.c_str()));
+		return;
+	}
 
-			// Select all the child nodes
-			entityNode->foreachNode([] (const scene::INodePtr& child)->bool
-			{
-				Node_setSelected(child, true);
-				return true;
-			});
+	// Copy the brush geometry of each entity, relative to the entity origin
+	std::vector<std::vector<cmutil::BrushGeometry>> geometry(entityNodes.size());
 
-			BrushPtrVector brushes = algorithm::getSelectedBrushes();
+	for (std::size_t e = 0; e < entityNodes.size(); ++e) {
+		scene::GroupNodePtr groupNode = Node_getGroupNode(entityNodes[e]);
 
-			// Create a new collisionmodel on the heap using a shared_ptr
-			cmutil::CollisionModelPtr cm(new cmutil::CollisionModel());
+		// Remove the entity origin from the brushes
+		groupNode->removeOriginFromChildren();
+
+		std::vector<Brush*> brushes;
+
+		entityNodes[e]->foreachNode([&] (const scene::INodePtr& child)->bool
+		{
+			Brush* brush = Node_getBrush(child);
 
-			// Add all the brushes to the collision model
-			for (std::size_t i = 0; i < brushes.size(); i++) {
-				cm->addBrush(brushes[i]->getBrush());
+			if (brush != NULL) {
+				brushes.push_back(brush);
 			}
 
-			ui::ModelSelectorResult modelAndSkin = ui::ModelSelector::chooseModel("", false, false);
-			std::string basePath = GlobalGameManager().getModPath();
+			return true;
+		});
+
+		Brush::evaluateBReps(brushes, GlobalRadiant().getThreadManager().getTaskScheduler());
 
-			std::string modelPath = basePath + modelAndSkin.model;
+		for (Brush* brush : brushes) {
+			geometry[e].push_back(getCollisionGeometry(*brush));
+		}
 
-			std::string newExtension = "." + game::current::getValue<std::string>(GKEY_CM_EXT);
+		// Re-add the origin to the brushes
+		groupNode->addOriginToChildren();
+	}
 
-			// Set the model string to correctly associate the clipmodel
-			cm->setModel(modelAndSkin.model);
+	// Building the collision models only involves the copied geometry,
+	// the entities can be processed in parallel
+	std::string polygonShader = game::current::getValue<std::string>(GKEY_COLLISION_SHADER);
+	std::vector<cmutil::CollisionModelPtr> collisionModels(entityNodes.size());
 
-			try {
-				// create the new autosave filename by changing the extension
-				fs::path cmPath = os::replaceExtension(modelPath, newExtension);
+	GlobalRadiant().getThreadManager().getTaskScheduler().parallelFor(entityNodes.size(),
+		[&](std::size_t e)
+	{
+		collisionModels[e] = std::make_shared<cmutil::CollisionModel>(polygonShader);
 
-				// Open the stream to the output file
-				std::ofstream outfile(cmPath.string().c_str());
+		// Add all the brushes to the collision model
+		for (const cmutil::BrushGeometry& brush : geometry[e]) {
+			collisionModels[e]->addBrush(brush);
+		}
+	});
 
-				if (outfile.is_open()) {
-					// Insert the CollisionModel into the stream
-					outfile << *cm;
-					// Close the file
-					outfile.close();
+	std::string basePath = GlobalGameManager().getModPath();
 
-					rMessage() << "CollisionModel saved to " << cmPath.string() << std::endl;
-				}
-				else {
-					wxutil::Messagebox::ShowError(
-						fmt::format("Couldn't save to file: {0}", cmPath.string()));
-				}
-			}
-			catch (const fs::filesystem_error& f) {
-				rError() << "CollisionModel: " << f.what() << std::endl;
-			}
+	for (std::size_t e = 0; e < entityNodes.size(); ++e) {
+		// The dialog is shown once per entity, tell the user which one it is for
+		std::string title;
 
-			// De-select the child brushes
-			GlobalSelectionSystem().setSelectedAll(false);
+		if (entityNodes.size() > 1) {
+			title = fmt::format(_("Choose Model for the Collision Model of {0}"), entityNodes[e]->name());
+		}
 
-			// Re-add the origin to the brushes
-			groupNode->addOriginToChildren();
+		ui::ModelSelectorResult modelAndSkin = ui::ModelSelector::chooseModel("", false, false, title);
 
-			// Re-select the node
-			Node_setSelected(entityNode, true);
+		if (modelAndSkin.model.empty()) {
+			continue; // dialog cancelled
 		}
-	}
-	else {
-		wxutil::Messagebox::ShowError(
-			_(ERRSTR_WRONG_SELECTION.c_str()));
+
+		// Set the model string to correctly associate the clipmodel
+		collisionModels[e]->setModel(modelAndSkin.model);
+
+		saveCollisionModel(*collisionModels[e], basePath + modelAndSkin.model);
 	}
 }
 
@@ -50,8 +50,10 @@ TexturePtr CShader::getEditorImage()
 {
     if (!_editorTexture)
     {
-        // Pass the call to the GLTextureManager to realise this image
-        _editorTexture = GetTextureManager().getBinding(
+        // Pass the call to the GLTextureManager to realise this image. It
+        // is loaded right away, the texture dimensions are needed to
+        // calculate texture coordinates.
+        _editorTexture = GetTextureManager().getImmediateBinding(
             _template->getEditorTexture()
         );
     }
@@ -17,14 +17,17 @@
 
 #include "ShaderDefinition.h"
 #include "ShaderExpression.h"
+#include "textures/TextureManipulator.h"
 
 #include "debugging/ScopedDebugTimer.h"
+#include "registry/registry.h"
 #include "modulesystem/StaticModule.h"
 
 #include "string/predicate.h"
 #include "string/replace.h"
 #include "parser/DefBlockTokeniser.h"
 #include <functional>
+#include <wx/app.h>
 
 namespace {
     const char* TEXTURE_PREFIX = "textures/";
@@ -40,6 +43,9 @@ in game descriptor";
     const std::string IMAGE_FLAT = "_flat.bmp";
     const std::string IMAGE_BLACK = "_black.bmp";
 
+    // Texture memory budget in MB, 0 disables the limit
+    const std::string RKEY_TEXTURE_MEMORY_BUDGET = "user/ui/textures/memoryBudget";
+
 }
 
 namespace shaders
@@ -57,15 +63,49 @@ void Doom3ShaderSystem::construct()
     _library = std::make_shared<ShaderLibrary>();
     _textureManager = std::make_shared<GLTextureManager>();
 
+    // Map expressions are evaluated by the workers, make sure the
+    // TextureManipulator singleton is constructed on the main thread
+    TextureManipulator::instance();
+
+    _textureManager->setTaskScheduler(&GlobalRadiant().getThreadManager().getTaskScheduler());
+    _textureManager->setTexturesPendingCallback([this]()
+    {
+        // Called by a worker thread, the views are redrawn by the main thread
+        if (wxTheApp == NULL) return;
+
+        wxTheApp->CallAfter([this]()
+        {
+            GlobalMainFrame().updateAllWindows();
+            _signalTexturesPending.emit();
+        });
+    });
+
+    _memoryBudgetChanged = GlobalRegistry().signalForKey(RKEY_TEXTURE_MEMORY_BUDGET).connect(
+        sigc::mem_fun(this, &Doom3ShaderSystem::memoryBudgetChanged)
+    );
+    memoryBudgetChanged();
+
     // Register this class as VFS observer
     GlobalFileSystem().addObserver(*this);
 }
 
+void Doom3ShaderSystem::memoryBudgetChanged()
+{
+    int megaBytes = registry::getValue<int>(RKEY_TEXTURE_MEMORY_BUDGET);
+
+    _textureManager->setMemoryBudget(static_cast<std::size_t>(std::max(megaBytes, 0)) << 20);
+}
+
 void Doom3ShaderSystem::destroy()
 {
     // De-register this class as VFS Observer
     GlobalFileSystem().removeObserver(*this);
 
+    _memoryBudgetChanged.disconnect();
+
+    // No more redraws once the main loop is gone
+    _textureManager->setTexturesPendingCallback(std::function<void()>());
+
     // Free the shaders if we're in realised state
     if (_realised) 
     {
@@ -101,9 +141,16 @@ ShaderLibraryPtr Doom3ShaderSystem::loadMaterialFiles()
     // Load each file from the global filesystem
     {
         ScopedDebugTimer timer("ShaderFiles parsed: ");
+
+        _declCache.load();
+
         ShaderFileLoader<ShaderLibrary> loader(GlobalFileSystem(), *library,
-                                               sPath, extension);
+                                               sPath, extension,
+                                               &GlobalRadiant().getThreadManager().getTaskScheduler(),
+                                               &_declCache);
         loader.parseFiles();
+
+        _declCache.save();
     }
 
     rMessage() << library->getNumDefinitions() << " shader definitions found." << std::endl;
@@ -265,6 +312,16 @@ TexturePtr Doom3ShaderSystem::getDefaultInteractionTexture(ShaderLayer::Type typ
     return defaultTex;
 }
 
+sigc::signal<void>& Doom3ShaderSystem::signal_texturesPending()
+{
+    return _signalTexturesPending;
+}
+
+void Doom3ShaderSystem::uploadPendingTextures()
+{
+    _textureManager->uploadPendingTextures();
+}
+
 sigc::signal<void> Doom3ShaderSystem::signal_activeShadersChanged() const
 {
     return _signalActiveShadersChanged;
@@ -345,6 +402,8 @@ void Doom3ShaderSystem::initialiseModule(const ApplicationContext& ctx)
 {
     rMessage() << getName() << "::initialiseModule called" << std::endl;
 
+    _declCache.setCacheFile(ctx.getSettingsPath() + "materials.cache");
+
     GlobalCommandSystem().addCommand("RefreshShaders", 
         std::bind(&Doom3ShaderSystem::refreshShadersCmd, this, std::placeholders::_1));
     GlobalEventManager().addCommand("RefreshShaders", "RefreshShaders");
@@ -12,6 +12,7 @@
 #include "TableDefinition.h"
 #include "textures/GLTextureManager.h"
 #include "ThreadedDefLoader.h"
+#include "parser/DeclFileCache.h"
 
 namespace shaders 
 {
@@ -31,6 +32,9 @@ class Doom3ShaderSystem :
     // The ShaderFileLoader will provide a new ShaderLibrary once complete
     util::ThreadedDefLoader<ShaderLibraryPtr> _defLoader;
 
+    // Tables and materials parsed from the material files, stored between sessions
+    parser::DeclFileCache _declCache;
+
 	// The manager that handles the texture caching.
 	GLTextureManagerPtr _textureManager;
 
@@ -46,6 +50,9 @@ class Doom3ShaderSystem :
 	// Signals for module subscribers
 	sigc::signal<void> _signalDefsLoaded;
 	sigc::signal<void> _signalDefsUnloaded;
+	sigc::signal<void> _signalTexturesPending;
+
+	sigc::connection _memoryBudgetChanged;
 
 public:
 
@@ -87,6 +94,9 @@ public:
 		_enableActiveUpdates = v;
 	}
 
+	sigc::signal<void>& signal_texturesPending() override;
+	void uploadPendingTextures() override;
+
     void setLightingEnabled(bool enabled) override;
 
     const char* getTexturePrefix() const override;
@@ -125,6 +135,9 @@ private:
     void construct();
     void destroy();
 
+    // Passes the texture memory budget from the registry to the texture manager
+    void memoryBudgetChanged();
+
     // For methods accessing the ShaderLibrary the parser thread must be done
     void ensureDefsLoaded();
 
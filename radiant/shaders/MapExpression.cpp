@@ -2,17 +2,17 @@
 
 #include "itextstream.h"
 #include "ifilesystem.h"
+#include "iregistry.h"
+#include "imodule.h"
 
 #include <iostream>
+#include <map>
 
 #include "os/path.h"
 #include "string/convert.h"
-#include "math/FloatTools.h" // contains float_to_integer() helper
-#include "math/Vector3.h"
 
 #include "RGBAImage.h"
-#include "textures/HeightmapCreator.h"
-#include "textures/TextureManipulator.h"
+#include "textures/ImageKernels.h"
 #include "string/predicate.h"
 
 /* CONSTANTS */
@@ -95,12 +95,8 @@ ImagePtr MapExpression::getResampled(const ImagePtr& input, std::size_t width, s
 		ImagePtr resampled (new RGBAImage(width, height));
 
 		// Resample the texture to match the dimensions of the first image
-		TextureManipulator::instance().resampleTexture(
-			input->getMipMapPixels(0),
-			input->getWidth(0), input->getHeight(0),
-			resampled->getMipMapPixels(0),
-			width, height, 4
-		);
+		kernels::resample(input->getMipMapPixels(0), input->getWidth(0), input->getHeight(0),
+						  resampled->getMipMapPixels(0), width, height);
 		return resampled;
 	}
 	else {
@@ -129,8 +125,14 @@ ImagePtr HeightMapExpression::getImage() const {
 		return heightMap;
 	}
 
+	std::size_t width = heightMap->getWidth(0);
+	std::size_t height = heightMap->getHeight(0);
+
 	// Convert the heightmap into a normalmap
-	ImagePtr normalMap = createNormalmapFromHeightmap(heightMap, scale);
+	ImagePtr normalMap (new RGBAImage(width, height));
+
+	kernels::heightMapToNormals(heightMap->getMipMapPixels(0), normalMap->getMipMapPixels(0),
+								width, height, scale);
 	return normalMap;
 }
 
@@ -171,40 +173,10 @@ ImagePtr AddNormalsExpression::getImage() const {
 
     ImagePtr result (new RGBAImage(width, height));
 
-    byte* pixOne = imgOne->getMipMapPixels(0);
-    byte* pixTwo = imgTwo->getMipMapPixels(0);
-    byte* pixOut = result->getMipMapPixels(0);
+    // Take the mean value of the two vectors
+    kernels::average(imgOne->getMipMapPixels(0), imgTwo->getMipMapPixels(0),
+                     result->getMipMapPixels(0), width * height, true);
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++ )
-	{
-		for( std::size_t x = 0; x < width; x++ )
-		{
-			// create the two vectors
-			Vector3 vectorOne(
-    			static_cast<double>(pixOne[0]),
-    			static_cast<double>(pixOne[1]),
-    			static_cast<double>(pixOne[2])
-			);
-			Vector3 vectorTwo(
-    			static_cast<double>(pixTwo[0]),
-    			static_cast<double>(pixTwo[1]),
-    			static_cast<double>(pixTwo[2])
-			);
-			// Take the mean value of the two vectors
-			Vector3 vectorOut = (vectorOne + vectorTwo) * 0.5;
-
-			pixOut[0] = static_cast<byte>(float_to_integer(vectorOut.x()));
-			pixOut[1] = static_cast<byte>(float_to_integer(vectorOut.y()));
-			pixOut[2] = static_cast<byte>(float_to_integer(vectorOut.z()));
-			pixOut[3] = 255;
-
-			// advance the pixel pointer
-			pixOne += 4;
-			pixTwo += 4;
-			pixOut += 4;
-		}
-    }
     return result;
 }
 
@@ -237,56 +209,9 @@ ImagePtr SmoothNormalsExpression::getImage() const {
 
 	ImagePtr result (new RGBAImage(width, height));
 
-	byte* in = normalMap->getMipMapPixels(0);
-	byte* out = result->getMipMapPixels(0);
-
-	struct KernelElement {
-		// offset to the current pixel
-		int dx, dy;
-	};
-
-	// a 3x3 kernel with the surrounding pixels including the pixel itself
-	const int kernelSize = 9;
-	KernelElement kernel[kernelSize] = {
-		{-1, -1 },
-		{ 0, -1 },
-		{ 1, -1 },
-		{ 1,  0 },
-		{ 1,  1 },
-		{ 0,  1 },
-		{-1,  1 },
-		{-1,  0 },
-		{ 0,  0 }
-	};
-	const float perKernelSize = 1.0f/kernelSize;
-
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; y++) {
-		for( std::size_t x = 0; x < width; x++) {
-			//the new normal vector for this pixel
-			Vector3 smoothVector(0,0,0);
-
-			// calculate the average direction of the surrounding vectors
-			for (KernelElement* i = kernel; i != kernel + kernelSize; ++i) {
-				// temporary vector to represent one of the surrounding pixels
-				byte* pixel = getPixel(in, width, height, x + i->dx, y + i->dy);
-				Vector3 temp(pixel[0], pixel[1], pixel[2]);
-
-				smoothVector += temp;
-			}
-
-			// Take the average normal vector as result
-			smoothVector *= perKernelSize;
-
-			out[0] = static_cast<byte>(float_to_integer(smoothVector.x()));
-			out[1] = static_cast<byte>(float_to_integer(smoothVector.y()));
-			out[2] = static_cast<byte>(float_to_integer(smoothVector.z()));
-			out[3] = 255;
-
-			// advance the pixel pointer
-			out += 4;
-	    }
-	}
+	// Calculate the average direction of the surrounding vectors
+	kernels::smoothNormals(normalMap->getMipMapPixels(0), result->getMipMapPixels(0), width, height);
+
     return result;
 }
 
@@ -327,27 +252,10 @@ ImagePtr AddExpression::getImage() const {
 
     ImagePtr result (new RGBAImage(width, height));
 
-    byte* pixOne = imgOne->getMipMapPixels(0);
-    byte* pixTwo = imgTwo->getMipMapPixels(0);
-    byte* pixOut = result->getMipMapPixels(0);
+    // add the colors
+    kernels::average(imgOne->getMipMapPixels(0), imgTwo->getMipMapPixels(0),
+                     result->getMipMapPixels(0), width * height, false);
 
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; y++)
-	{
-		for( std::size_t x = 0; x < width; x++)
-		{
-			// add the colors
-			pixOut[0] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[0]) + pixTwo[0]) * 0.5f));
-			pixOut[1] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[1]) + pixTwo[1]) * 0.5f));
-			pixOut[2] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[2]) + pixTwo[2]) * 0.5f));
-			pixOut[3] = static_cast<byte>(float_to_integer((static_cast<float>(pixOne[3]) + pixTwo[3]) * 0.5f));
-
-			//advance the pixel pointer
-			pixOne += 4;
-			pixTwo += 4;
-			pixOut += 4;
-		}
-    }
 	return result;
 }
 
@@ -398,32 +306,9 @@ ImagePtr ScaleExpression::getImage() const {
 
     ImagePtr result (new RGBAImage(width, height));
 
-    byte* in = img->getMipMapPixels(0);
-    byte* out = result->getMipMapPixels(0);
-
-    // iterate through the pixels
-    for( std::size_t y = 0; y < height; ++y)
-	{
-		for( std::size_t x = 0; x < width; ++x)
-		{
-			// prevent negative values and check for values >255
-			int red = float_to_integer(static_cast<float>(in[0]) * scaleRed);
-			out[0] = (red>255) ? 255 : static_cast<byte>(red);
-
-			int green = float_to_integer(static_cast<float>(in[1]) * scaleGreen);
-			out[1] = (green>255) ? 255 : static_cast<byte>(green);
-
-			int blue = float_to_integer(static_cast<float>(in[2]) * scaleBlue);
-			out[2] = (blue>255) ? 255 : static_cast<byte>(blue);
-
-			int alpha = float_to_integer(static_cast<float>(in[3]) * scaleAlpha);
-			out[3] = (alpha>255) ? 255 : static_cast<byte>(alpha);
+    const float factors[4] = { scaleRed, scaleGreen, scaleBlue, scaleAlpha };
+    kernels::scale(img->getMipMapPixels(0), result->getMipMapPixels(0), width * height, factors);
 
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-    }
 	return result;
 }
 
@@ -455,24 +340,7 @@ ImagePtr InvertAlphaExpression::getImage() const {
 
 	ImagePtr result (new RGBAImage(width, height));
 
-	byte* in = img->getMipMapPixels(0);
-	byte* out = result->getMipMapPixels(0);
-
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; ++y)
-	{
-		for( std::size_t x = 0; x < width; ++x)
-		{
-			out[0] = in[0];
-			out[1] = in[1];
-			out[2] = in[2];
-			out[3] = 255 - in[3];
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	kernels::invert(img->getMipMapPixels(0), result->getMipMapPixels(0), width * height, false, true);
 
 	return result;
 }
@@ -505,22 +373,7 @@ ImagePtr InvertColorExpression::getImage() const {
 
 	ImagePtr result (new RGBAImage(width, height));
 
-	byte* in = img->getMipMapPixels(0);
-	byte* out = result->getMipMapPixels(0);
-
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; y++) {
-		for( std::size_t x = 0; x < width; x++) {
-			out[0] = 255 - in[0];
-			out[1] = 255 - in[1];
-			out[2] = 255 - in[2];
-			out[3] = in[3];
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	kernels::invert(img->getMipMapPixels(0), result->getMipMapPixels(0), width * height, true, false);
 
 	return result;
 }
@@ -553,24 +406,7 @@ ImagePtr MakeIntensityExpression::getImage() const {
 
 	ImagePtr result (new RGBAImage(width, height));
 
-	byte* in = img->getMipMapPixels(0);
-	byte* out = result->getMipMapPixels(0);
-
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; ++y)
-	{
-		for( std::size_t x = 0; x < width; ++x)
-		{
-			out[0] = in[0];
-			out[1] = in[0];
-			out[2] = in[0];
-			out[3] = in[0];
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	kernels::makeIntensity(img->getMipMapPixels(0), result->getMipMapPixels(0), width * height);
 
 	return result;
 }
@@ -603,24 +439,7 @@ ImagePtr MakeAlphaExpression::getImage() const {
 
 	ImagePtr result (new RGBAImage(width, height));
 
-	byte* in = img->getMipMapPixels(0);
-	byte* out = result->getMipMapPixels(0);
-
-	// iterate through the pixels
-	for( std::size_t y = 0; y < height; y++)
-	{
-		for( std::size_t x = 0; x < width; x++)
-		{
-			out[0] = 255;
-			out[1] = 255;
-			out[2] = 255;
-			out[3] = (in[0] + in[1] + in[2])/3;
-
-			// advance the pixel pointer
-			in += 4;
-			out += 4;
-		}
-	}
+	kernels::makeAlpha(img->getMipMapPixels(0), result->getMipMapPixels(0), width * height);
 
 	return result;
 }
@@ -633,92 +452,64 @@ std::string MakeAlphaExpression::getIdentifier() const {
 
 /* ImageExpression */
 
+namespace
+{
+	// Returns the file in the bitmaps folder to load for the given image
+	// keyword, or an empty string if the name doesn't refer to a keyword image
+	const std::string& getKeywordImageFile(const std::string& imgName)
+	{
+		static const std::map<std::string, std::string> keywordImages =
+		{
+			{ "_black", IMAGE_BLACK },
+			{ "_cubiclight", IMAGE_CUBICLIGHT },
+			{ "_currentRender", IMAGE_CURRENTRENDER },
+			{ "_default", IMAGE_DEFAULT },
+			{ "_flat", IMAGE_FLAT },
+			{ "_fog", IMAGE_FOG },
+			{ "_nofalloff", IMAGE_NOFALLOFF },
+			{ "_pointlight1", IMAGE_POINTLIGHT1 },
+			{ "_pointlight2", IMAGE_POINTLIGHT2 },
+			{ "_pointlight3", IMAGE_POINTLIGHT3 },
+			{ "_quadratic", IMAGE_QUADRATIC },
+			{ "_scratch", IMAGE_SCRATCH },
+			{ "_spotlight", IMAGE_SPOTLIGHT },
+			{ "_white", IMAGE_WHITE },
+		};
+		static const std::string noFile;
+
+		auto found = keywordImages.find(imgName);
+
+		return found != keywordImages.end() ? found->second : noFile;
+	}
+}
+
 ImageExpression::ImageExpression(const std::string& imgName)
 {
 	// Replace backslashes with forward slashes and strip of
 	// the file extension of the provided token, and store
 	// the result in the provided string.
 	_imgName = os::standardPath(imgName).substr(0, imgName.rfind("."));
+
+	// getImage() is called by the texture decoding workers, which must not
+	// access the registry, so the path of keyword images is resolved here
+	const std::string& keywordFile = getKeywordImageFile(_imgName);
+
+	if (!keywordFile.empty())
+	{
+		_bitmapPath = GlobalRegistry().get(RKEY_BITMAPS_PATH) + keywordFile;
+	}
 }
 
 ImagePtr ImageExpression::getImage() const
 {
 	// Check for some image keywords and load the correct file
-	if (_imgName == "_black") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_BLACK
-        );
-	}
-	else if (_imgName == "_cubiclight") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_CUBICLIGHT
-        );
-	}
-	else if (_imgName == "_currentRender") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_CURRENTRENDER
-        );
-	}
-	else if (_imgName == "_default") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_DEFAULT
-        );
-	}
-	else if (_imgName == "_flat") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_FLAT
-        );
-	}
-	else if (_imgName == "_fog") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_FOG
-        );
-	}
-	else if (_imgName == "_nofalloff") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_NOFALLOFF
-        );
-	}
-	else if (_imgName == "_pointlight1") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_POINTLIGHT1
-        );
-	}
-	else if (_imgName == "_pointlight2") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_POINTLIGHT2
-        );
-	}
-	else if (_imgName == "_pointlight3") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_POINTLIGHT3
-        );
-	}
-	else if (_imgName == "_quadratic") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_QUADRATIC
-        );
-	}
-	else if (_imgName == "_scratch") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_SCRATCH
-        );
-	}
-	else if (_imgName == "_spotlight") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_SPOTLIGHT
-        );
-	}
-	else if (_imgName == "_white") {
-		return GlobalImageLoader().imageFromFile(
-            GlobalRegistry().get("user/paths/bitmapsPath") + IMAGE_WHITE
-        );
-	}
-	else
-    {
-        // this is a normal material image, so we load the image from VFS
-		return GlobalImageLoader().imageFromVFS(_imgName);
+	if (!_bitmapPath.empty())
+	{
+		return GlobalImageLoader().imageFromFile(_bitmapPath);
 	}
+
+	// this is a normal material image, so we load the image from VFS
+	return GlobalImageLoader().imageFromVFS(_imgName);
 }
 
 std::string ImageExpression::getIdentifier() const
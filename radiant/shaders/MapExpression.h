@@ -173,6 +173,9 @@ class ImageExpression
 {
 	std::string _imgName;
 
+	// The file in the bitmaps folder for image keywords like "_white"
+	std::string _bitmapPath;
+
 public:
 
     /* MapExpression interface */
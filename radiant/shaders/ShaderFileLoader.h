@@ -4,19 +4,26 @@
 
 #include "iarchive.h"
 #include "ifilesystem.h"
+#include "ithread.h"
 
 #include "TableDefinition.h"
 #include "ShaderTemplate.h"
 #include "ShaderDefinition.h"
 
+#include "parser/BufferDefTokeniser.h"
 #include "parser/DefBlockTokeniser.h"
+#include "parser/DeclFileCache.h"
 #include "string/replace.h"
 #include "string/predicate.h"
+#include "ThreadedDefLoader.h"
 
 namespace shaders
 {
 
 // VFS functor class which loads material (mtr) files.
+// The files are read and tokenised concurrently if a TaskScheduler is passed,
+// the resulting definitions are added to the library in VFS order afterwards.
+// If a DeclFileCache is passed, the declarations of unchanged files are taken from it.
 template<typename ShaderLibrary_T> class ShaderFileLoader
 {
     // The VFS module to provide shader files
@@ -24,16 +31,30 @@ template<typename ShaderLibrary_T> class ShaderFileLoader
 
     ShaderLibrary_T& _library;
 
+    // Optional scheduler to parse the files with
+    TaskScheduler* _scheduler;
+
+    // Optional cache holding the declarations of each file
+    parser::DeclFileCache* _cache;
+
     // List of shader definition files to parse
     std::vector<vfs::FileInfo> _files;
 
+    // A table or material declaration, in the order found in a file
+    struct ParsedDecl
+    {
+        TableDefinitionPtr table;
+        ShaderTemplatePtr shaderTemplate;
+    };
+    typedef std::vector<ParsedDecl> ParsedDecls;
+
 private:
 
-    bool parseTable(const parser::BlockTokeniser::Block& block, const vfs::FileInfo& fileInfo)
+    static TableDefinitionPtr parseTable(const std::string& name, const std::string& contents)
     {
-        if (block.name.length() <= 5 || !string::starts_with(block.name, "table"))
+        if (name.length() <= 5 || !string::starts_with(name, "table"))
         {
-            return false; // definitely not a table decl
+            return TableDefinitionPtr(); // definitely not a table decl
         }
 
         // Look closer by trying to split up the table name from the decl
@@ -41,62 +62,183 @@ private:
         std::regex expr("^table\\s+(.+)$");
         std::smatch matches;
 
-        if (std::regex_match(block.name, matches, expr))
+        if (std::regex_match(name, matches, expr))
         {
-            auto tableName = matches[1].str();
+            return std::make_shared<TableDefinition>(matches[1].str(), contents);
+        }
 
-            auto table = std::make_shared<TableDefinition>(tableName, block.contents);
+        return TableDefinitionPtr();
+    }
 
-            if (!_library.addTableDefinition(table))
-            {
-                rError() << "[shaders] " << fileInfo.name << ": table " << tableName << " already defined." << std::endl;
-            }
+    // Creates the table or material declaration of the given block, returns false
+    // for the skin and particle declarations found in some material files
+    static bool createDecl(const std::string& name, const std::string& contents, ParsedDecl& decl)
+    {
+        // Try to parse tables
+        decl.table = parseTable(name, contents);
 
-            return true;
+        if (decl.table)
+        {
+            return true; // table successfully parsed
         }
 
-        return false;
+        if (name.substr(0, 5) == "skin ")
+        {
+            return false; // skip skin definition
+        }
+
+        if (name.substr(0, 9) == "particle ")
+        {
+            return false; // skip particle definition
+        }
+
+        // use forward slashes
+        decl.shaderTemplate = std::make_shared<ShaderTemplate>(string::replace_all_copy(name, "\\", "/"), contents);
+        return true;
     }
 
-    // Parse a shader file with the given contents and filename
-    void parseShaderFile(std::istream& inStr, const vfs::FileInfo& fileInfo)
+    // Splits the given shader file into blocks and creates the declarations.
+    // This is not touching the library, such that several files can be
+    // parsed at the same time. The block contents are parsed on demand by
+    // the TableDefinition and ShaderTemplate.
+    static ParsedDecls readDecls(std::istream& inStr)
     {
-        // Parse the file with a blocktokeniser, the actual block contents
-        // will be parsed separately.
-        parser::BasicDefBlockTokeniser<std::istream> tokeniser(inStr);
+        ParsedDecls decls;
+
+        // Read the file into memory, tokenising a string is much faster
+        // than going through the stream iterators character by character
+        std::string contents = parser::readStreamContents(inStr);
+
+        // Only the block boundaries are located here
+        parser::BufferDefBlockTokeniser tokeniser(contents);
 
         while (tokeniser.hasMoreBlocks())
         {
-            // Get the next block
             parser::BlockTokeniser::Block block = tokeniser.nextBlock();
+            ParsedDecl decl;
 
-            // Try to parse tables
-            if (parseTable(block, fileInfo))
+            if (createDecl(block.name, block.contents, decl))
             {
-                continue; // table successfully parsed
+                decls.push_back(decl);
             }
-            
-            if (block.name.substr(0, 5) == "skin ")
+        }
+
+        return decls;
+    }
+
+    // Serialises the declarations of a file for the DeclFileCache, each being
+    // the table flag followed by the name and the unparsed block contents
+    static std::string writeToCache(const ParsedDecls& decls)
+    {
+        parser::DeclWriter writer;
+        writer.writeSize(decls.size());
+
+        for (const ParsedDecl& decl : decls)
+        {
+            writer.writeBool(decl.table != nullptr);
+
+            if (decl.table)
             {
-                continue; // skip skin definition
+                writer.writeString(decl.table->getName());
+                writer.writeString(decl.table->getBlockContents());
             }
-            
-            if (block.name.substr(0, 9) == "particle ")
+            else
             {
-                continue; // skip particle definition
+                writer.writeString(decl.shaderTemplate->getName());
+                writer.writeString(decl.shaderTemplate->getBlockContents());
             }
+        }
 
-            string::replace_all(block.name, "\\", "/"); // use forward slashes
+        return writer.getData();
+    }
 
-            auto shaderTemplate = std::make_shared<ShaderTemplate>(block.name, block.contents);
+    static ParsedDecls readFromCache(const std::string& data)
+    {
+        parser::DeclReader reader(data);
+        ParsedDecls decls(reader.readCount(9));
+
+        for (ParsedDecl& decl : decls)
+        {
+            bool isTable = reader.readBool();
+            std::string name = reader.readString();
+
+            if (isTable)
+            {
+                decl.table = std::make_shared<TableDefinition>(name, reader.readString());
+            }
+            else
+            {
+                decl.shaderTemplate = std::make_shared<ShaderTemplate>(name, reader.readString());
+            }
+        }
+
+        return decls;
+    }
+
+    static ParsedDecls parseShaderFile(vfs::VirtualFileSystem& vfs, const vfs::FileInfo& fileInfo,
+                                       parser::DeclFileCache* cache)
+    {
+        std::string path = fileInfo.fullPath();
+
+        std::string data;
+        vfs::FileStamp stamp = cache != nullptr ? vfs.getFileStamp(path) : vfs::FileStamp();
+
+        try
+        {
+            if (cache != nullptr && cache->lookup(path, stamp, data))
+            {
+                return readFromCache(data);
+            }
+        }
+        catch (parser::ParseException& e)
+        {
+            rWarning() << "[shaders] Discarding the cached declarations of " << fileInfo.name
+                << ": " << e.what() << std::endl;
+        }
+
+        // Open the file
+        auto file = vfs.openTextFile(path);
+
+        if (!file)
+        {
+            throw std::runtime_error("Unable to read shaderfile: " + fileInfo.name);
+        }
+
+        std::istream is(&(file->getInputStream()));
+        ParsedDecls decls = readDecls(is);
+
+        if (cache != nullptr)
+        {
+            cache->store(path, stamp, writeToCache(decls));
+        }
+
+        return decls;
+    }
+
+    // Adds the declarations of the given file to the library, the first definition of a name wins
+    void addDecls(const ParsedDecls& decls, const vfs::FileInfo& fileInfo)
+    {
+        for (const ParsedDecl& decl : decls)
+        {
+            if (decl.table)
+            {
+                if (!_library.addTableDefinition(decl.table))
+                {
+                    rError() << "[shaders] " << fileInfo.name << ": table " << decl.table->getName() << " already defined." << std::endl;
+                }
+
+                continue;
+            }
+
+            const std::string& name = decl.shaderTemplate->getName();
 
             // Construct the ShaderDefinition wrapper class
-            ShaderDefinition def(shaderTemplate, fileInfo);
+            ShaderDefinition def(decl.shaderTemplate, fileInfo);
 
             // Insert into the definitions map, if not already present
-            if (!_library.addDefinition(block.name, def))
+            if (!_library.addDefinition(name, def))
             {
-                rError() << "[shaders] " << fileInfo.name << ": shader " << block.name << " already defined." << std::endl;
+                rError() << "[shaders] " << fileInfo.name << ": shader " << name << " already defined." << std::endl;
             }
         }
     }
@@ -106,8 +248,10 @@ public:
     /// Construct and initialise the ShaderFileLoader
     ShaderFileLoader(vfs::VirtualFileSystem& fs, ShaderLibrary_T& library,
                      const std::string& basedir,
-                     const std::string& extension = "mtr")
-    : _vfs(fs), _library(library)
+                     const std::string& extension = "mtr",
+                     TaskScheduler* scheduler = nullptr,
+                     parser::DeclFileCache* cache = nullptr)
+    : _vfs(fs), _library(library), _scheduler(scheduler), _cache(cache)
     {
         _files.reserve(200);
 
@@ -121,21 +265,21 @@ public:
 
     void parseFiles()
     {
-        for (const vfs::FileInfo& fileInfo: _files)
+        if (!_scheduler)
         {
-            // Open the file
-            auto file = _vfs.openTextFile(fileInfo.fullPath());
-
-            if (file)
+            for (const vfs::FileInfo& fileInfo: _files)
             {
-                std::istream is(&(file->getInputStream()));
-                parseShaderFile(is, fileInfo);
-            }
-            else
-            {
-                throw std::runtime_error("Unable to read shaderfile: " + fileInfo.name);
+                addDecls(parseShaderFile(_vfs, fileInfo, _cache), fileInfo);
             }
+
+            return;
         }
+
+        // Merging in file order keeps the override semantics of the sequential parse
+        util::parseFilesInParallel<vfs::FileInfo, ParsedDecls>(*_scheduler, _files,
+            [this](const vfs::FileInfo& fileInfo) { return parseShaderFile(_vfs, fileInfo, _cache); },
+            [this](const vfs::FileInfo& fileInfo, ParsedDecls& decls) { addDecls(decls, fileInfo); }
+        );
     }
 };
 
@@ -6,7 +6,7 @@
 
 #include "os/path.h"
 #include "string/convert.h"
-#include "parser/DefTokeniser.h"
+#include "parser/BufferDefTokeniser.h"
 
 #include "string/case_conv.h"
 #include "string/trim.h"
@@ -1146,7 +1146,7 @@ bool ShaderTemplate::saveLayer()
 void ShaderTemplate::parseDefinition()
 {
     // Construct a local deftokeniser to parse the unparsed block
-    parser::BasicDefTokeniser<std::string> tokeniser(
+    parser::BufferDefTokeniser tokeniser(
         _blockContents,
 		parser::WHITESPACE, // delimiters (whitespace)
         "{}(),"  // add the comma character to the kept delimiters
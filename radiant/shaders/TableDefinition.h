@@ -39,6 +39,11 @@ public:
 		return _name;
 	}
 
+	const std::string& getBlockContents() const
+	{
+		return _blockContents;
+	}
+
 	// Retrieve a value from this table, respecting the clamp and snap flags
 	float getValue(float index);
 
@@ -6,15 +6,98 @@
 #include "igl.h"
 #include "../MapExpression.h"
 #include "TextureManipulator.h"
+#include "BasicTexture2D.h"
+#include "ImageKernels.h"
+#include "render/TextureResidency.h"
 #include "parser/DefTokeniser.h"
 
 namespace
 {
     const std::string SHADER_NOT_FOUND = "notex.bmp";
+    const std::string PLACEHOLDER = "_white.bmp";
+
+    // Decoded images held in memory until they are uploaded
+    const std::size_t MAX_QUEUED_IMAGES = 64;
+
+    // Number of textures uploaded by a single uploadPendingTextures() call
+    const std::size_t MAX_UPLOADS_PER_FRAME = 16;
+
+    // Approximate GL memory used by the complete mip chain of the image.
+    // Precompressed images are assumed to use a byte per pixel (DXT3/5).
+    std::size_t estimateTextureMemory(const Image& image)
+    {
+        std::size_t pixels = image.getWidth(0) * image.getHeight(0);
+        std::size_t baseLevel = image.isPrecompressed() ? pixels : pixels * 4;
+
+        return baseLevel + baseLevel / 3;
+    }
 }
 
 namespace shaders {
 
+GLTextureManager::GLTextureManager() :
+    _decodeQueue(MAX_QUEUED_IMAGES)
+{}
+
+void GLTextureManager::setTaskScheduler(TaskScheduler* scheduler)
+{
+    _decodeQueue.setTaskScheduler(scheduler);
+
+    // Large images created by map expressions are split across the workers
+    kernels::setTaskScheduler(scheduler);
+}
+
+void GLTextureManager::setTexturesPendingCallback(const std::function<void()>& callback)
+{
+    _decodeQueue.setImagesAvailableCallback(callback);
+}
+
+void GLTextureManager::setMemoryBudget(std::size_t bytes)
+{
+    render::TextureResidency::Instance().setBudget(bytes);
+}
+
+void GLTextureManager::uploadPendingTextures()
+{
+    _decodeQueue.processDecodedImages(MAX_UPLOADS_PER_FRAME);
+
+    updateResidency();
+}
+
+void GLTextureManager::updateResidency()
+{
+    render::TextureResidency& residency = render::TextureResidency::Instance();
+
+    // Textures drawn since they have been reduced or evicted
+    for (GLuint textureNum : residency.takeReloadRequests())
+    {
+        queueDecode(textureNum, 0);
+    }
+
+    for (const render::TextureResidency::Change& change : residency.selectChanges())
+    {
+        if (change.firstLevel != render::TextureResidency::EVICTED)
+        {
+            queueDecode(change.texture, change.firstLevel);
+            continue;
+        }
+
+        // Show the placeholder until the texture is drawn again
+        auto found = _reloadableTextures.find(change.texture);
+        TexturePtr texture = found != _reloadableTextures.end() ? found->second.texture.lock() : TexturePtr();
+
+        if (texture && _placeholderImage->uploadTexture(change.texture, texture->getName(), 0))
+        {
+            residency.setEvicted(change.texture);
+        }
+    }
+}
+
+std::size_t GLTextureManager::getNumPendingTextures() const
+{
+    return _decodeQueue.getNumPendingImages();
+}
+
 void GLTextureManager::checkBindings() {
     // Check the TextureMap for unique pointers and release them
     // as they aren't used by anyone else than this class.
@@ -24,6 +107,14 @@ void GLTextureManager::checkBindings() {
     {
         // If the std::shared_ptr is unique (i.e. refcount==1), remove it
         if (i->second.unique()) {
+            // The texture number is going to be reused by GL
+            GLuint textureNum = i->second->getGLTexNum();
+
+            if (_reloadableTextures.erase(textureNum) > 0)
+            {
+                render::TextureResidency::Instance().remove(textureNum);
+            }
+
             // Be sure to increment the iterator with a postfix ++,
             // so that the iterator is incremented right before deletion
             _textures.erase(i++);
@@ -51,21 +142,72 @@ TexturePtr GLTextureManager::getBinding(NamedBindablePtr bindable)
         // Found, return
         return i->second;
     }
-    else
+
+    // Map expressions don't need the GL context to be evaluated, let the
+    // workers do this and return a placeholder in the meantime
+    MapExpressionPtr expression = std::dynamic_pointer_cast<MapExpression>(bindable);
+
+    if (expression && !expression->isCubeMap() && _decodeQueue.hasTaskScheduler())
     {
-        // Create and insert texture object, if it is valid
-        TexturePtr texture = bindable->bindTexture(identifier);
+        TexturePtr texture = createPlaceholder(expression, identifier);
+
         if (texture)
         {
             _textures.insert(TextureMap::value_type(identifier, texture));
             return texture;
         }
-        else
-        {
-            rError() << "[shaders] Unable to load texture: "
-                                << identifier << std::endl;
-            return getShaderNotFound();
-        }
+    }
+
+    return loadBinding(bindable, identifier);
+}
+
+TexturePtr GLTextureManager::getImmediateBinding(NamedBindablePtr bindable)
+{
+    if (!bindable)
+    {
+        return getShaderNotFound();
+    }
+
+    std::string identifier = bindable->getIdentifier();
+    TextureMap::iterator i = _textures.find(identifier);
+
+    if (i == _textures.end())
+    {
+        return loadBinding(bindable, identifier);
+    }
+
+    // The texture might have been created by getBinding(), in which case
+    // it could still be showing the placeholder image
+    TexturePtr texture = i->second;
+    auto reloadable = _reloadableTextures.find(texture->getGLTexNum());
+
+    if (reloadable == _reloadableTextures.end() || !reloadable->second.pending)
+    {
+        return texture;
+    }
+
+    // Evaluate the expression right away, the queued request is dropped when it arrives
+    MapExpressionPtr expression = reloadable->second.expression;
+    uploadDecodedImage(expression->getImage(), texture, 0);
+
+    // Textures failing to load are not kept, like in loadBinding()
+    return _textures.find(identifier) != _textures.end() ? texture : getShaderNotFound();
+}
+
+TexturePtr GLTextureManager::loadBinding(const NamedBindablePtr& bindable, const std::string& identifier)
+{
+    // Create and insert texture object, if it is valid
+    TexturePtr texture = bindable->bindTexture(identifier);
+    if (texture)
+    {
+        _textures.insert(TextureMap::value_type(identifier, texture));
+        return texture;
+    }
+    else
+    {
+        rError() << "[shaders] Unable to load texture: "
+                            << identifier << std::endl;
+        return getShaderNotFound();
     }
 }
 
@@ -110,15 +252,140 @@ TexturePtr GLTextureManager::getShaderNotFound()
     return _shaderNotFound;
 }
 
-TexturePtr GLTextureManager::loadStandardTexture(const std::string& filename)
+TexturePtr GLTextureManager::createPlaceholder(const MapExpressionPtr& expression,
+                                              const std::string& identifier)
+{
+    if (!_placeholderImage)
+    {
+        _placeholderImage = loadStandardImage(PLACEHOLDER);
+
+        if (!_placeholderImage) return TexturePtr();
+    }
+
+    TexturePtr texture = _placeholderImage->bindTexture(identifier);
+
+    if (!texture) return TexturePtr();
+
+    ReloadableTexture& reloadable = _reloadableTextures[texture->getGLTexNum()];
+    reloadable.texture = texture;
+    reloadable.expression = expression;
+    reloadable.pending = true;
+
+    queueDecode(texture->getGLTexNum(), 0);
+
+    return texture;
+}
+
+void GLTextureManager::queueDecode(GLuint textureNum, std::size_t firstLevel)
+{
+    auto found = _reloadableTextures.find(textureNum);
+
+    if (found == _reloadableTextures.end()) return;
+
+    // Textures released before their image is decoded are skipped
+    std::weak_ptr<Texture> weakTexture = found->second.texture;
+    MapExpressionPtr expression = found->second.expression;
+
+    // The first image of a placeholder might be loaded by getImmediateBinding() in the meantime
+    bool initialImage = found->second.pending;
+
+    _decodeQueue.add([expression, weakTexture]()
+    {
+        return weakTexture.expired() ? ImagePtr() : expression->getImage();
+    },
+    [this, weakTexture, firstLevel, initialImage](const ImagePtr& image)
+    {
+        TexturePtr target = weakTexture.lock();
+
+        if (target && (!initialImage || isPending(target->getGLTexNum())))
+        {
+            uploadDecodedImage(image, target, firstLevel);
+        }
+    });
+}
+
+void GLTextureManager::uploadDecodedImage(const ImagePtr& image, const TexturePtr& texture,
+                                          std::size_t firstLevel)
+{
+    render::TextureResidency& residency = render::TextureResidency::Instance();
+    GLuint textureNum = texture->getGLTexNum();
+
+    ImagePtr uploaded = image;
+
+    if (uploaded && uploaded->uploadTexture(textureNum, texture->getName(), firstLevel))
+    {
+        auto reloadable = _reloadableTextures.find(textureNum);
+
+        if (reloadable != _reloadableTextures.end())
+        {
+            reloadable->second.pending = false;
+        }
+
+        residency.setResident(textureNum, estimateTextureMemory(*uploaded),
+            render::TextureResidency::getNumLevels(uploaded->getWidth(0), uploaded->getHeight(0)),
+            firstLevel);
+    }
+    else
+    {
+        rError() << "[shaders] Unable to load texture: " << texture->getName() << std::endl;
+
+        // Show the "shader not found" image instead, there's no point in reloading it
+        residency.remove(textureNum);
+        _reloadableTextures.erase(textureNum);
+
+        // Don't hand out the broken texture again, getBinding() will retry loading it
+        TextureMap::iterator existing = _textures.find(texture->getName());
+
+        if (existing != _textures.end() && existing->second == texture)
+        {
+            _textures.erase(existing);
+        }
+
+        if (!_shaderNotFoundImage)
+        {
+            _shaderNotFoundImage = loadStandardImage(SHADER_NOT_FOUND);
+        }
+
+        uploaded = _shaderNotFoundImage;
+
+        if (!uploaded || !uploaded->uploadTexture(textureNum, texture->getName(), 0))
+        {
+            return;
+        }
+    }
+
+    // The placeholder had the dimensions of the placeholder image, reduced
+    // textures keep reporting the size of the full image
+    BasicTexture2DPtr texture2D = std::dynamic_pointer_cast<BasicTexture2D>(texture);
+
+    if (texture2D)
+    {
+        texture2D->setWidth(uploaded->getWidth(0));
+        texture2D->setHeight(uploaded->getHeight(0));
+    }
+}
+
+bool GLTextureManager::isPending(GLuint textureNum) const
+{
+    auto found = _reloadableTextures.find(textureNum);
+
+    return found != _reloadableTextures.end() && found->second.pending;
+}
+
+ImagePtr GLTextureManager::loadStandardImage(const std::string& filename)
 {
     // Create the texture path
     std::string fullpath = GlobalRegistry().get("user/paths/bitmapsPath") + filename;
 
+    // load the image with the ImageFileLoader (which can handle .bmp)
+    return GlobalImageLoader().imageFromFile(fullpath);
+}
+
+TexturePtr GLTextureManager::loadStandardTexture(const std::string& filename)
+{
     TexturePtr returnValue;
 
-    // load the image with the ImageFileLoader (which can handle .bmp)
-    ImagePtr img = GlobalImageLoader().imageFromFile(fullpath);
+    ImagePtr img = loadStandardImage(filename);
 
     if (img != ImagePtr()) {
         // Bind the (processed) texture and get the OpenGL id
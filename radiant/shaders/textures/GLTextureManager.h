@@ -4,11 +4,21 @@
 #include "ishaders.h"
 #include <map>
 #include "../MapExpression.h"
+#include "TextureDecodeQueue.h"
 #include "texturelib.h"
 
 namespace shaders
 {
 
+/**
+ * Creates the GL textures of the material stages and caches them by name.
+ *
+ * Once a TaskScheduler has been set, textures created from map expressions
+ * by getBinding() are returned right away, showing a placeholder image. The images are
+ * loaded and the expressions evaluated on the worker threads, the results
+ * are uploaded into the existing GL texture by uploadPendingTextures(), so
+ * the texture numbers handed out stay valid.
+ */
 class GLTextureManager
 {
 	// The mapping between texturekeys and Texture instances
@@ -18,12 +28,92 @@ class GLTextureManager
 	// The fallback textures in case a texture is empty or broken
 	TexturePtr _shaderNotFound;
 
+	// Images shown by textures waiting for their decoded image,
+	// and by textures whose image failed to load
+	ImagePtr _placeholderImage;
+	ImagePtr _shaderNotFoundImage;
+
+	// Textures created from map expressions, which can be reduced to their
+	// lower mip levels or evicted to stay within the memory budget, and are
+	// reloaded when drawn again. Mapped by GL texture number.
+	struct ReloadableTexture
+	{
+		std::weak_ptr<Texture> texture;
+		MapExpressionPtr expression;
+
+		// True until the first decoded image has been uploaded
+		bool pending = false;
+	};
+	std::map<GLuint, ReloadableTexture> _reloadableTextures;
+
+	// Evaluates the map expressions of the placeholder textures
+	TextureDecodeQueue _decodeQueue;
+
 private:
 
+	// Loads one of the fallback images from the bitmaps folder
+	ImagePtr loadStandardImage(const std::string& filename);
+
+	// Creates the texture of the given bindable right away and caches it
+	TexturePtr loadBinding(const NamedBindablePtr& bindable, const std::string& identifier);
+
+	// Returns true if the texture is still showing its placeholder image
+	bool isPending(GLuint textureNum) const;
+
 	// Constructs the fallback textures like "Shader Image Missing"
 	TexturePtr loadStandardTexture(const std::string& filename);
 
+	// Returns a texture showing the placeholder image, and queues the
+	// expression for evaluation. Returns an empty pointer on failure.
+	TexturePtr createPlaceholder(const MapExpressionPtr& expression,
+								 const std::string& identifier);
+
+	// Queues the expression of the given texture for evaluation, the image
+	// is uploaded starting at the given mip level
+	void queueDecode(GLuint textureNum, std::size_t firstLevel);
+
+	// Replaces the contents of the given texture with the decoded image
+	void uploadDecodedImage(const ImagePtr& image, const TexturePtr& texture,
+							std::size_t firstLevel);
+
+	// Reloads, reduces or evicts textures as requested by the TextureResidency
+	void updateResidency();
+
 public:
+	GLTextureManager();
+
+	/**
+	 * \brief
+	 * Set the scheduler evaluating map expressions in the background. If no
+	 * scheduler is set, textures are loaded before getBinding() returns.
+	 */
+	void setTaskScheduler(TaskScheduler* scheduler);
+
+	/**
+	 * \brief
+	 * Set the function to be invoked when decoded textures are waiting for
+	 * uploadPendingTextures(). It is called on a worker thread.
+	 */
+	void setTexturesPendingCallback(const std::function<void()>& callback);
+
+	/**
+	 * \brief
+	 * Set the GL memory to be used by the textures created from map
+	 * expressions, 0 disables the limit. Textures which haven't been drawn
+	 * recently are reduced or evicted when it is exceeded.
+	 */
+	void setMemoryBudget(std::size_t bytes);
+
+	/**
+	 * \brief
+	 * Upload a limited number of the textures decoded in the background,
+	 * and apply the memory budget. Must be called with the GL context
+	 * being current.
+	 */
+	void uploadPendingTextures();
+
+	/// The number of textures still showing their placeholder image
+	std::size_t getNumPendingTextures() const;
 
     /**
      * \brief
@@ -31,6 +121,15 @@ public:
      */
 	TexturePtr getBinding(NamedBindablePtr bindable);
 
+	/**
+	 * \brief
+	 * Like getBinding(), but the image is always loaded before returning,
+	 * such that the texture reports the dimensions of the actual image.
+	 * Used for the editor images, which are the base of texture coordinate
+	 * calculations.
+	 */
+	TexturePtr getImmediateBinding(NamedBindablePtr bindable);
+
 	/** greebo: This loads a texture directly from the disk using the
 	 * 			specified <fullPath>.
 	 *
@@ -0,0 +1,1064 @@
+#include "ImageKernels.h"
+
+#include "ithread.h"
+#include "math/FloatTools.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 paths are compiled for the target only, they are picked at runtime
+#if defined(IMAGE_KERNELS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define IMAGE_KERNELS_AVX2
+#include <immintrin.h>
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+namespace shaders
+{
+
+namespace kernels
+{
+
+namespace
+{
+	std::atomic<int> _requestedSet(static_cast<int>(InstructionSet::AVX2));
+	std::atomic<TaskScheduler*> _scheduler(NULL);
+
+	// Images with fewer pixels are processed on the calling thread
+	const std::size_t MIN_PARALLEL_PIXELS = 128 * 1024;
+
+	// Number of pixels processed by a single task
+	const std::size_t PIXELS_PER_BLOCK = 32 * 1024;
+
+	const std::size_t NO_ROW = std::numeric_limits<std::size_t>::max();
+
+	// Calls func(first, end) for consecutive ranges covering [0, count),
+	// distributed over the worker threads if the image is large enough
+	template<typename Func>
+	void forEachBlock(std::size_t count, std::size_t pixelsPerItem, const Func& func)
+	{
+		TaskScheduler* scheduler = _scheduler;
+
+		std::size_t itemsPerBlock = std::max<std::size_t>(PIXELS_PER_BLOCK / std::max<std::size_t>(pixelsPerItem, 1), 1);
+		std::size_t numBlocks = (count + itemsPerBlock - 1) / itemsPerBlock;
+
+		if (scheduler == NULL || count * pixelsPerItem < MIN_PARALLEL_PIXELS || numBlocks < 2)
+		{
+			func(0, count);
+			return;
+		}
+
+		scheduler->parallelFor(numBlocks, [&](std::size_t block)
+		{
+			func(block * itemsPerBlock, std::min((block + 1) * itemsPerBlock, count));
+		});
+	}
+
+	// (a + b) * 0.5 rounded to the nearest even integer like lrint() does
+	inline byte averageToEven(byte a, byte b)
+	{
+		unsigned int sum = a + b;
+		unsigned int half = sum >> 1;
+
+		return static_cast<byte>(half + (sum & half & 1));
+	}
+
+	// The mean of the 3x3 neighbourhood, rounded. A ninth of an integer is
+	// never closer than 1/18 to a half, so this is the same as rounding
+	// the floating point result.
+	inline byte ninthRounded(unsigned int sum)
+	{
+		return static_cast<byte>((sum + 4) / 9);
+	}
+
+	// Linear interpolation with a 16 bit fraction, rounding down
+	inline byte lerpByte(unsigned int a, unsigned int b, unsigned int lerp)
+	{
+		return static_cast<byte>((a * (65536 - lerp) + b * lerp) >> 16);
+	}
+
+	void heightMapPixel(const float* above, const float* current, const float* below,
+						float scale, byte* out)
+	{
+		// The pointers are referring to the left neighbour, the sums are
+		// evaluated in the same order as the Prewitt kernels always were
+		float du = 0;
+		du -= below[0];
+		du -= current[0];
+		du -= above[0];
+		du += below[2];
+		du += current[2];
+		du += above[2];
+
+		float dv = 0;
+		dv += below[0];
+		dv += below[1];
+		dv += below[2];
+		dv -= above[0];
+		dv -= above[1];
+		dv -= above[2];
+
+		float nx = -du * scale;
+		float ny = -dv * scale;
+		float nz = 1.0f;
+
+		// Normalize, the reciprocal length is calculated in double precision
+		float norm = static_cast<float>(1.0 / std::sqrt(static_cast<double>(nx * nx + ny * ny + nz * nz)));
+
+		out[0] = static_cast<byte>(float_to_integer(((nx * norm) + 1) * 127.5));
+		out[1] = static_cast<byte>(float_to_integer(((ny * norm) + 1) * 127.5));
+		out[2] = static_cast<byte>(float_to_integer(((nz * norm) + 1) * 127.5));
+		out[3] = 255;
+	}
+
+#ifdef IMAGE_KERNELS_SSE2
+
+	// The SSE2 and AVX2 functions process as many pixels as fit into
+	// their registers, starting at the given index, and return the index
+	// of the first pixel left for the narrower implementations
+
+	inline __m128i loadPixels(const byte* pixels, std::size_t index)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + index * 4));
+	}
+
+	inline void storePixels(byte* pixels, std::size_t index, __m128i value)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + index * 4), value);
+	}
+
+	// lerpByte() on 16 bit lanes holding bytes
+	inline __m128i lerpWords(__m128i a, __m128i b, __m128i lerp)
+	{
+		__m128i highA = _mm_mulhi_epu16(a, lerp);
+		__m128i highB = _mm_mulhi_epu16(b, lerp);
+		__m128i lowA = _mm_mullo_epi16(a, lerp);
+		__m128i lowB = _mm_mullo_epi16(b, lerp);
+
+		// a + floor((b * lerp - a * lerp) / 65536), borrowing if the low word of a * lerp is larger
+		__m128i noBorrow = _mm_cmpeq_epi16(_mm_subs_epu16(lowA, lowB), _mm_setzero_si128());
+		__m128i borrow = _mm_andnot_si128(noBorrow, _mm_set1_epi16(-1));
+
+		return _mm_add_epi16(_mm_add_epi16(a, _mm_sub_epi16(highB, highA)), borrow);
+	}
+
+	std::size_t averageSSE2(const byte* one, const byte* two, byte* out,
+							std::size_t i, std::size_t end, bool opaque)
+	{
+		const __m128i lowBit = _mm_set1_epi8(1);
+		const __m128i alpha = opaque ? _mm_set1_epi32(static_cast<int>(0xff000000)) : _mm_setzero_si128();
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i a = loadPixels(one, i);
+			__m128i b = loadPixels(two, i);
+
+			// Rounds halves up, take one off where this gives an odd number
+			__m128i rounded = _mm_avg_epu8(a, b);
+			__m128i odd = _mm_and_si128(_mm_and_si128(_mm_xor_si128(a, b), rounded), lowBit);
+
+			storePixels(out, i, _mm_or_si128(_mm_sub_epi8(rounded, odd), alpha));
+		}
+
+		return i;
+	}
+
+	inline __m128i scaleChannels(__m128i channels, __m128 factors, __m128 limit)
+	{
+		// Clamp before the conversion, NaNs end up as 0 like in the scalar version
+		__m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(channels), factors);
+		return _mm_cvtps_epi32(_mm_min_ps(limit, scaled));
+	}
+
+	std::size_t scaleSSE2(const byte* in, byte* out, std::size_t i, std::size_t end, const float factors[4])
+	{
+		const __m128 factors4 = _mm_loadu_ps(factors);
+		const __m128 limit = _mm_set1_ps(255.0f);
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i pixels = loadPixels(in, i);
+			__m128i low = _mm_unpacklo_epi8(pixels, zero);
+			__m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+			__m128i first = _mm_packs_epi32(
+				scaleChannels(_mm_unpacklo_epi16(low, zero), factors4, limit),
+				scaleChannels(_mm_unpackhi_epi16(low, zero), factors4, limit));
+			__m128i second = _mm_packs_epi32(
+				scaleChannels(_mm_unpacklo_epi16(high, zero), factors4, limit),
+				scaleChannels(_mm_unpackhi_epi16(high, zero), factors4, limit));
+
+			storePixels(out, i, _mm_packus_epi16(first, second));
+		}
+
+		return i;
+	}
+
+	std::size_t invertSSE2(const byte* in, byte* out, std::size_t i, std::size_t end, std::uint32_t mask)
+	{
+		const __m128i mask4 = _mm_set1_epi32(static_cast<int>(mask));
+
+		for (; i + 4 <= end; i += 4)
+		{
+			storePixels(out, i, _mm_xor_si128(loadPixels(in, i), mask4));
+		}
+
+		return i;
+	}
+
+	std::size_t makeIntensitySSE2(const byte* in, byte* out, std::size_t i, std::size_t end)
+	{
+		const __m128i red = _mm_set1_epi32(0xff);
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i value = _mm_and_si128(loadPixels(in, i), red);
+			value = _mm_or_si128(value, _mm_slli_epi32(value, 8));
+			value = _mm_or_si128(value, _mm_slli_epi32(value, 16));
+
+			storePixels(out, i, value);
+		}
+
+		return i;
+	}
+
+	std::size_t makeAlphaSSE2(const byte* in, byte* out, std::size_t i, std::size_t end)
+	{
+		const __m128i channel = _mm_set1_epi32(0xff);
+		const __m128i white = _mm_set1_epi32(0x00ffffff);
+		const __m128i third = _mm_set1_epi32(0xaaab);
+
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128i pixels = loadPixels(in, i);
+
+			__m128i sum = _mm_add_epi32(_mm_and_si128(pixels, channel),
+				_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(pixels, 8), channel),
+							  _mm_and_si128(_mm_srli_epi32(pixels, 16), channel)));
+
+			// sum / 3 is (sum * 0xaaab) >> 17 for sums up to 765, the upper words are zero
+			__m128i mean = _mm_srli_epi16(_mm_mulhi_epu16(sum, third), 1);
+
+			storePixels(out, i, _mm_or_si128(_mm_slli_epi32(mean, 24), white));
+		}
+
+		return i;
+	}
+
+	std::size_t sumRowsSSE2(const byte* above, const byte* row, const byte* below,
+							std::uint16_t* sums, std::size_t i, std::size_t end)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 16 <= end; i += 16)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + i));
+			__m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + i));
+
+			__m128i low = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(r, zero)),
+										_mm_unpacklo_epi8(b, zero));
+			__m128i high = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(r, zero)),
+										 _mm_unpackhi_epi8(b, zero));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i), low);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(sums + i + 8), high);
+		}
+
+		return i;
+	}
+
+	// x / 9 is (x * 7282) >> 16 for the sums of up to nine bytes
+	inline __m128i ninthRoundedWords(__m128i sum)
+	{
+		return _mm_mulhi_epu16(_mm_add_epi16(sum, _mm_set1_epi16(4)), _mm_set1_epi16(7282));
+	}
+
+	std::size_t smoothPixelsSSE2(const std::uint16_t* columnSums, byte* out, std::size_t x, std::size_t width)
+	{
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+		for (; x + 2 <= width; x += 2)
+		{
+			const std::uint16_t* sums = columnSums + x * 4;
+
+			__m128i sum = _mm_add_epi16(
+				_mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums)),
+							  _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + 4))),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + 8)));
+
+			__m128i mean = ninthRoundedWords(sum);
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4),
+				_mm_or_si128(_mm_packus_epi16(mean, mean), alpha));
+		}
+
+		return x;
+	}
+
+	std::size_t heightsSSE2(const byte* in, float* heights, std::size_t x, std::size_t width)
+	{
+		const __m128i red = _mm_set1_epi32(0xff);
+		const __m128 divisor = _mm_set1_ps(255.0f);
+
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i value = _mm_and_si128(loadPixels(in, x), red);
+			_mm_storeu_ps(heights + x, _mm_div_ps(_mm_cvtepi32_ps(value), divisor));
+		}
+
+		return x;
+	}
+
+	// 1 / sqrt(length) in double precision, rounded to float
+	inline __m128 reciprocalLength(__m128 squaredLength)
+	{
+		const __m128d one = _mm_set1_pd(1.0);
+
+		__m128 low = _mm_cvtpd_ps(_mm_div_pd(one, _mm_sqrt_pd(_mm_cvtps_pd(squaredLength))));
+		__m128 high = _mm_cvtpd_ps(_mm_div_pd(one,
+			_mm_sqrt_pd(_mm_cvtps_pd(_mm_movehl_ps(squaredLength, squaredLength)))));
+
+		return _mm_movelh_ps(low, high);
+	}
+
+	// ((n * norm) + 1) * 127.5 is evaluated in double precision as well
+	inline __m128i normalToBytes(__m128 biased)
+	{
+		const __m128d factor = _mm_set1_pd(127.5);
+
+		__m128i low = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(biased), factor));
+		__m128i high = _mm_cvtpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(biased, biased)), factor));
+
+		return _mm_unpacklo_epi64(low, high);
+	}
+
+	std::size_t heightMapSSE2(const float* above, const float* current, const float* below,
+							  float scale, byte* out, std::size_t x, std::size_t width)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		const __m128 scale4 = _mm_set1_ps(scale);
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128 aboveLeft = _mm_loadu_ps(above + x);
+			__m128 aboveCentre = _mm_loadu_ps(above + x + 1);
+			__m128 aboveRight = _mm_loadu_ps(above + x + 2);
+			__m128 currentLeft = _mm_loadu_ps(current + x);
+			__m128 currentRight = _mm_loadu_ps(current + x + 2);
+			__m128 belowLeft = _mm_loadu_ps(below + x);
+			__m128 belowCentre = _mm_loadu_ps(below + x + 1);
+			__m128 belowRight = _mm_loadu_ps(below + x + 2);
+
+			__m128 du = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(zero, belowLeft), currentLeft), aboveLeft);
+			du = _mm_add_ps(_mm_add_ps(_mm_add_ps(du, belowRight), currentRight), aboveRight);
+
+			__m128 dv = _mm_add_ps(_mm_add_ps(_mm_add_ps(zero, belowLeft), belowCentre), belowRight);
+			dv = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(dv, aboveLeft), aboveCentre), aboveRight);
+
+			__m128 nx = _mm_mul_ps(_mm_xor_ps(du, signBit), scale4);
+			__m128 ny = _mm_mul_ps(_mm_xor_ps(dv, signBit), scale4);
+
+			__m128 norm = reciprocalLength(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), one));
+
+			__m128i r = normalToBytes(_mm_add_ps(_mm_mul_ps(nx, norm), one));
+			__m128i g = normalToBytes(_mm_add_ps(_mm_mul_ps(ny, norm), one));
+			__m128i b = normalToBytes(_mm_add_ps(norm, one));
+
+			__m128i pixels = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+										  _mm_or_si128(_mm_slli_epi32(b, 16), alpha));
+
+			storePixels(out, x, pixels);
+		}
+
+		return x;
+	}
+
+	std::size_t resampleRowSSE2(const byte* in, byte* out, std::size_t j, std::size_t outWidth,
+								std::size_t fstep, std::size_t endx)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; j + 2 <= outWidth; j += 2)
+		{
+			std::size_t f0 = j * fstep;
+			std::size_t f1 = f0 + fstep;
+
+			// The last input pixel has no neighbour to interpolate with
+			if ((f1 >> 16) >= endx) break;
+
+			// Each load contains the pixel and its right neighbour
+			__m128i first = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + (f0 >> 16) * 4)), zero);
+			__m128i second = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + (f1 >> 16) * 4)), zero);
+
+			short lerp0 = static_cast<short>(f0 & 0xffff);
+			short lerp1 = static_cast<short>(f1 & 0xffff);
+
+			__m128i result = lerpWords(_mm_unpacklo_epi64(first, second), _mm_unpackhi_epi64(first, second),
+				_mm_set_epi16(lerp1, lerp1, lerp1, lerp1, lerp0, lerp0, lerp0, lerp0));
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + j * 4), _mm_packus_epi16(result, result));
+		}
+
+		return j;
+	}
+
+	std::size_t lerpRowsSSE2(const byte* row1, const byte* row2, byte* out,
+							 std::size_t i, std::size_t numBytes, unsigned int lerp)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lerp8 = _mm_set1_epi16(static_cast<short>(lerp));
+
+		for (; i + 16 <= numBytes; i += 16)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row2 + i));
+
+			__m128i low = lerpWords(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), lerp8);
+			__m128i high = lerpWords(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), lerp8);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+		}
+
+		return i;
+	}
+
+#endif
+
+#ifdef IMAGE_KERNELS_AVX2
+
+	AVX2_FUNCTION inline __m256i loadPixels8(const byte* pixels, std::size_t index)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + index * 4));
+	}
+
+	AVX2_FUNCTION inline void storePixels8(byte* pixels, std::size_t index, __m256i value)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + index * 4), value);
+	}
+
+	AVX2_FUNCTION inline __m256i lerpWords16(__m256i a, __m256i b, __m256i lerp)
+	{
+		__m256i highA = _mm256_mulhi_epu16(a, lerp);
+		__m256i highB = _mm256_mulhi_epu16(b, lerp);
+		__m256i lowA = _mm256_mullo_epi16(a, lerp);
+		__m256i lowB = _mm256_mullo_epi16(b, lerp);
+
+		__m256i noBorrow = _mm256_cmpeq_epi16(_mm256_subs_epu16(lowA, lowB), _mm256_setzero_si256());
+		__m256i borrow = _mm256_andnot_si256(noBorrow, _mm256_set1_epi16(-1));
+
+		return _mm256_add_epi16(_mm256_add_epi16(a, _mm256_sub_epi16(highB, highA)), borrow);
+	}
+
+	AVX2_FUNCTION std::size_t averageAVX2(const byte* one, const byte* two, byte* out,
+										  std::size_t i, std::size_t end, bool opaque)
+	{
+		const __m256i lowBit = _mm256_set1_epi8(1);
+		const __m256i alpha = opaque ? _mm256_set1_epi32(static_cast<int>(0xff000000)) : _mm256_setzero_si256();
+
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256i a = loadPixels8(one, i);
+			__m256i b = loadPixels8(two, i);
+
+			__m256i rounded = _mm256_avg_epu8(a, b);
+			__m256i odd = _mm256_and_si256(_mm256_and_si256(_mm256_xor_si256(a, b), rounded), lowBit);
+
+			storePixels8(out, i, _mm256_or_si256(_mm256_sub_epi8(rounded, odd), alpha));
+		}
+
+		return i;
+	}
+
+	AVX2_FUNCTION std::size_t invertAVX2(const byte* in, byte* out, std::size_t i, std::size_t end,
+										 std::uint32_t mask)
+	{
+		const __m256i mask8 = _mm256_set1_epi32(static_cast<int>(mask));
+
+		for (; i + 8 <= end; i += 8)
+		{
+			storePixels8(out, i, _mm256_xor_si256(loadPixels8(in, i), mask8));
+		}
+
+		return i;
+	}
+
+	AVX2_FUNCTION std::size_t sumRowsAVX2(const byte* above, const byte* row, const byte* below,
+										  std::uint16_t* sums, std::size_t i, std::size_t end)
+	{
+		for (; i + 16 <= end; i += 16)
+		{
+			__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(above + i)));
+			__m256i r = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)));
+			__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(below + i)));
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(sums + i),
+				_mm256_add_epi16(_mm256_add_epi16(a, r), b));
+		}
+
+		return i;
+	}
+
+	AVX2_FUNCTION std::size_t smoothPixelsAVX2(const std::uint16_t* columnSums, byte* out,
+											   std::size_t x, std::size_t width)
+	{
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+		const __m256i rounding = _mm256_set1_epi16(4);
+		const __m256i ninth = _mm256_set1_epi16(7282);
+
+		for (; x + 4 <= width; x += 4)
+		{
+			const std::uint16_t* sums = columnSums + x * 4;
+
+			__m256i sum = _mm256_add_epi16(
+				_mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums)),
+								 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + 4))),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + 8)));
+
+			__m256i mean = _mm256_mulhi_epu16(_mm256_add_epi16(sum, rounding), ninth);
+
+			// Packing works per 128 bit lane, gather the two halves
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(mean, mean), 0x08);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4),
+				_mm_or_si128(_mm256_castsi256_si128(packed), alpha));
+		}
+
+		return x;
+	}
+
+	AVX2_FUNCTION inline __m256 reciprocalLength8(__m256 squaredLength)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+
+		__m128 low = _mm256_cvtpd_ps(_mm256_div_pd(one,
+			_mm256_sqrt_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(squaredLength)))));
+		__m128 high = _mm256_cvtpd_ps(_mm256_div_pd(one,
+			_mm256_sqrt_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(squaredLength, 1)))));
+
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+	}
+
+	AVX2_FUNCTION inline __m256i normalToBytes8(__m256 biased)
+	{
+		const __m256d factor = _mm256_set1_pd(127.5);
+
+		__m128i low = _mm256_cvtpd_epi32(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(biased)), factor));
+		__m128i high = _mm256_cvtpd_epi32(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(biased, 1)), factor));
+
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+	}
+
+	AVX2_FUNCTION std::size_t heightMapAVX2(const float* above, const float* current, const float* below,
+											float scale, byte* out, std::size_t x, std::size_t width)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 signBit = _mm256_set1_ps(-0.0f);
+		const __m256 scale8 = _mm256_set1_ps(scale);
+		const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+
+		for (; x + 8 <= width; x += 8)
+		{
+			__m256 aboveLeft = _mm256_loadu_ps(above + x);
+			__m256 aboveCentre = _mm256_loadu_ps(above + x + 1);
+			__m256 aboveRight = _mm256_loadu_ps(above + x + 2);
+			__m256 currentLeft = _mm256_loadu_ps(current + x);
+			__m256 currentRight = _mm256_loadu_ps(current + x + 2);
+			__m256 belowLeft = _mm256_loadu_ps(below + x);
+			__m256 belowCentre = _mm256_loadu_ps(below + x + 1);
+			__m256 belowRight = _mm256_loadu_ps(below + x + 2);
+
+			__m256 du = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(zero, belowLeft), currentLeft), aboveLeft);
+			du = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(du, belowRight), currentRight), aboveRight);
+
+			__m256 dv = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(zero, belowLeft), belowCentre), belowRight);
+			dv = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(dv, aboveLeft), aboveCentre), aboveRight);
+
+			__m256 nx = _mm256_mul_ps(_mm256_xor_ps(du, signBit), scale8);
+			__m256 ny = _mm256_mul_ps(_mm256_xor_ps(dv, signBit), scale8);
+
+			__m256 norm = reciprocalLength8(
+				_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), one));
+
+			__m256i r = normalToBytes8(_mm256_add_ps(_mm256_mul_ps(nx, norm), one));
+			__m256i g = normalToBytes8(_mm256_add_ps(_mm256_mul_ps(ny, norm), one));
+			__m256i b = normalToBytes8(_mm256_add_ps(norm, one));
+
+			__m256i pixels = _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+											 _mm256_or_si256(_mm256_slli_epi32(b, 16), alpha));
+
+			storePixels8(out, x, pixels);
+		}
+
+		return x;
+	}
+
+	AVX2_FUNCTION std::size_t lerpRowsAVX2(const byte* row1, const byte* row2, byte* out,
+										   std::size_t i, std::size_t numBytes, unsigned int lerp)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i lerp16 = _mm256_set1_epi16(static_cast<short>(lerp));
+
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + i));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row2 + i));
+
+			// Unpacking and packing both work per 128 bit lane, the order is preserved
+			__m256i low = lerpWords16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero), lerp16);
+			__m256i high = lerpWords16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero), lerp16);
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_packus_epi16(low, high));
+		}
+
+		return i;
+	}
+
+#endif
+
+	void averagePixels(const byte* one, const byte* two, byte* out, std::size_t i, std::size_t end,
+					   bool opaque, InstructionSet set)
+	{
+#ifdef IMAGE_KERNELS_AVX2
+		if (set == InstructionSet::AVX2) i = averageAVX2(one, two, out, i, end, opaque);
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) i = averageSSE2(one, two, out, i, end, opaque);
+#endif
+		for (; i < end; ++i)
+		{
+			const byte* a = one + i * 4;
+			const byte* b = two + i * 4;
+			byte* result = out + i * 4;
+
+			result[0] = averageToEven(a[0], b[0]);
+			result[1] = averageToEven(a[1], b[1]);
+			result[2] = averageToEven(a[2], b[2]);
+			result[3] = opaque ? 255 : averageToEven(a[3], b[3]);
+		}
+	}
+
+	void scalePixels(const byte* in, byte* out, std::size_t i, std::size_t end,
+					 const float factors[4], InstructionSet set)
+	{
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) i = scaleSSE2(in, out, i, end, factors);
+#endif
+		for (; i < end; ++i)
+		{
+			for (std::size_t channel = 0; channel < 4; ++channel)
+			{
+				int value = float_to_integer(static_cast<float>(in[i * 4 + channel]) * factors[channel]);
+				out[i * 4 + channel] = value > 255 ? 255 : static_cast<byte>(value);
+			}
+		}
+	}
+
+	void invertPixels(const byte* in, byte* out, std::size_t i, std::size_t end,
+					  const byte mask[4], InstructionSet set)
+	{
+		std::uint32_t mask32;
+		std::memcpy(&mask32, mask, sizeof(mask32));
+
+#ifdef IMAGE_KERNELS_AVX2
+		if (set == InstructionSet::AVX2) i = invertAVX2(in, out, i, end, mask32);
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) i = invertSSE2(in, out, i, end, mask32);
+#endif
+		for (; i < end; ++i)
+		{
+			for (std::size_t channel = 0; channel < 4; ++channel)
+			{
+				out[i * 4 + channel] = in[i * 4 + channel] ^ mask[channel];
+			}
+		}
+	}
+
+	void makeIntensityPixels(const byte* in, byte* out, std::size_t i, std::size_t end, InstructionSet set)
+	{
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) i = makeIntensitySSE2(in, out, i, end);
+#endif
+		for (; i < end; ++i)
+		{
+			std::memset(out + i * 4, in[i * 4], 4);
+		}
+	}
+
+	void makeAlphaPixels(const byte* in, byte* out, std::size_t i, std::size_t end, InstructionSet set)
+	{
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) i = makeAlphaSSE2(in, out, i, end);
+#endif
+		for (; i < end; ++i)
+		{
+			const byte* pixel = in + i * 4;
+
+			out[i * 4 + 0] = 255;
+			out[i * 4 + 1] = 255;
+			out[i * 4 + 2] = 255;
+			out[i * 4 + 3] = static_cast<byte>((pixel[0] + pixel[1] + pixel[2]) / 3);
+		}
+	}
+
+	void smoothNormalsRows(const byte* in, byte* out, std::size_t width, std::size_t height,
+						   std::size_t first, std::size_t end, InstructionSet set)
+	{
+		std::size_t rowSize = width * 4;
+
+		// Per channel sums of the three rows around the current one. The
+		// first and the last entry are the neighbours of the border pixels.
+		std::vector<std::uint16_t> columnSums((width + 2) * 4);
+		std::uint16_t* sums = columnSums.data() + 4;
+
+		for (std::size_t y = first; y < end; ++y)
+		{
+			const byte* above = in + ((y + height - 1) % height) * rowSize;
+			const byte* row = in + y * rowSize;
+			const byte* below = in + ((y + 1) % height) * rowSize;
+
+			std::size_t i = 0;
+#ifdef IMAGE_KERNELS_AVX2
+			if (set == InstructionSet::AVX2) i = sumRowsAVX2(above, row, below, sums, i, rowSize);
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+			if (set >= InstructionSet::SSE2) i = sumRowsSSE2(above, row, below, sums, i, rowSize);
+#endif
+			for (; i < rowSize; ++i)
+			{
+				sums[i] = above[i] + row[i] + below[i];
+			}
+
+			// Wrap around at the borders
+			std::copy(sums + rowSize - 4, sums + rowSize, columnSums.data());
+			std::copy(sums, sums + 4, sums + rowSize);
+
+			byte* outRow = out + y * rowSize;
+			std::size_t x = 0;
+#ifdef IMAGE_KERNELS_AVX2
+			if (set == InstructionSet::AVX2) x = smoothPixelsAVX2(columnSums.data(), outRow, x, width);
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+			if (set >= InstructionSet::SSE2) x = smoothPixelsSSE2(columnSums.data(), outRow, x, width);
+#endif
+			for (; x < width; ++x)
+			{
+				const std::uint16_t* neighbours = columnSums.data() + x * 4;
+
+				for (std::size_t channel = 0; channel < 3; ++channel)
+				{
+					outRow[x * 4 + channel] = ninthRounded(
+						neighbours[channel] + neighbours[channel + 4] + neighbours[channel + 8]);
+				}
+
+				outRow[x * 4 + 3] = 255;
+			}
+		}
+	}
+
+	// Converts the red channel of the given row to heights in [0..1], the
+	// first and the last entry are the neighbours of the border pixels
+	void loadHeights(const byte* row, float* heights, std::size_t width, InstructionSet set)
+	{
+		float* inner = heights + 1;
+		std::size_t x = 0;
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) x = heightsSSE2(row, inner, x, width);
+#endif
+		for (; x < width; ++x)
+		{
+			inner[x] = row[x * 4] / 255.0f;
+		}
+
+		heights[0] = inner[width - 1];
+		inner[width] = inner[0];
+	}
+
+	void heightMapRows(const byte* in, byte* out, std::size_t width, std::size_t height, float scale,
+					   std::size_t first, std::size_t end, InstructionSet set)
+	{
+		std::size_t rowSize = width * 4;
+
+		// Three rows of heights, rotated while moving down the image
+		std::vector<float> buffer((width + 2) * 3);
+		float* above = buffer.data();
+		float* current = above + width + 2;
+		float* below = current + width + 2;
+
+		loadHeights(in + ((first + height - 1) % height) * rowSize, above, width, set);
+		loadHeights(in + first * rowSize, current, width, set);
+
+		for (std::size_t y = first; y < end; ++y)
+		{
+			if (y > first)
+			{
+				std::swap(above, current);
+				std::swap(current, below);
+			}
+
+			loadHeights(in + ((y + 1) % height) * rowSize, below, width, set);
+
+			byte* outRow = out + y * rowSize;
+			std::size_t x = 0;
+#ifdef IMAGE_KERNELS_AVX2
+			if (set == InstructionSet::AVX2) x = heightMapAVX2(above, current, below, scale, outRow, x, width);
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+			if (set >= InstructionSet::SSE2) x = heightMapSSE2(above, current, below, scale, outRow, x, width);
+#endif
+			for (; x < width; ++x)
+			{
+				heightMapPixel(above + x, current + x, below + x, scale, outRow + x * 4);
+			}
+		}
+	}
+
+	void resampleRow(const byte* in, std::size_t inWidth, byte* out, std::size_t outWidth, InstructionSet set)
+	{
+		std::size_t fstep = static_cast<std::size_t>(inWidth * 65536.0f / outWidth);
+		std::size_t endx = inWidth - 1;
+
+		std::size_t j = 0;
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) j = resampleRowSSE2(in, out, j, outWidth, fstep, endx);
+#endif
+		for (; j < outWidth; ++j)
+		{
+			std::size_t f = j * fstep;
+			std::size_t xi = f >> 16;
+
+			const byte* pixel = in + xi * 4;
+			byte* result = out + j * 4;
+
+			if (xi < endx)
+			{
+				unsigned int lerp = static_cast<unsigned int>(f & 0xffff);
+
+				for (std::size_t channel = 0; channel < 4; ++channel)
+				{
+					result[channel] = lerpByte(pixel[channel], pixel[channel + 4], lerp);
+				}
+			}
+			else // last pixel of the line has no pixel to lerp to
+			{
+				std::memcpy(result, pixel, 4);
+			}
+		}
+	}
+
+	void lerpRows(const byte* row1, const byte* row2, byte* out, std::size_t numBytes,
+				  unsigned int lerp, InstructionSet set)
+	{
+		std::size_t i = 0;
+#ifdef IMAGE_KERNELS_AVX2
+		if (set == InstructionSet::AVX2) i = lerpRowsAVX2(row1, row2, out, i, numBytes, lerp);
+#endif
+#ifdef IMAGE_KERNELS_SSE2
+		if (set >= InstructionSet::SSE2) i = lerpRowsSSE2(row1, row2, out, i, numBytes, lerp);
+#endif
+		for (; i < numBytes; ++i)
+		{
+			out[i] = lerpByte(row1[i], row2[i], lerp);
+		}
+	}
+
+	void resampleRows(const byte* in, std::size_t inWidth, std::size_t inHeight,
+					  byte* out, std::size_t outWidth, std::size_t outHeight,
+					  std::size_t first, std::size_t end, InstructionSet set)
+	{
+		std::size_t inRowSize = inWidth * 4;
+		std::size_t outRowSize = outWidth * 4;
+
+		// The horizontally resampled input rows to interpolate between
+		std::vector<byte> buffer(outRowSize * 2);
+		byte* row1 = buffer.data();
+		byte* row2 = row1 + outRowSize;
+		std::size_t row1Index = NO_ROW;
+		std::size_t row2Index = NO_ROW;
+
+		std::size_t fstep = static_cast<int>(inHeight * 65536.0f / outHeight);
+		std::size_t endy = inHeight - 1;
+
+		for (std::size_t i = first; i < end; ++i)
+		{
+			std::size_t f = i * fstep;
+			std::size_t yi = std::min(f >> 16, endy);
+
+			if (row1Index != yi)
+			{
+				if (row2Index == yi)
+				{
+					std::swap(row1, row2);
+					std::swap(row1Index, row2Index);
+				}
+				else
+				{
+					resampleRow(in + yi * inRowSize, inWidth, row1, outWidth, set);
+					row1Index = yi;
+				}
+			}
+
+			byte* outRow = out + i * outRowSize;
+
+			if (yi < endy)
+			{
+				if (row2Index != yi + 1)
+				{
+					resampleRow(in + (yi + 1) * inRowSize, inWidth, row2, outWidth, set);
+					row2Index = yi + 1;
+				}
+
+				lerpRows(row1, row2, outRow, outRowSize, static_cast<unsigned int>(f & 0xffff), set);
+			}
+			else
+			{
+				std::memcpy(outRow, row1, outRowSize);
+			}
+		}
+	}
+}
+
+InstructionSet getSupportedInstructionSet()
+{
+#ifdef IMAGE_KERNELS_AVX2
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2") != 0;
+
+	if (hasAVX2)
+	{
+		return InstructionSet::AVX2;
+	}
+#endif
+
+#ifdef IMAGE_KERNELS_SSE2
+	return InstructionSet::SSE2;
+#else
+	return InstructionSet::Scalar;
+#endif
+}
+
+InstructionSet getInstructionSet()
+{
+	return std::min(static_cast<InstructionSet>(_requestedSet.load()), getSupportedInstructionSet());
+}
+
+void setInstructionSet(InstructionSet set)
+{
+	_requestedSet = static_cast<int>(set);
+}
+
+void setTaskScheduler(TaskScheduler* scheduler)
+{
+	_scheduler = scheduler;
+}
+
+void average(const byte* one, const byte* two, byte* out, std::size_t numPixels, bool opaque)
+{
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(numPixels, 1, [&](std::size_t first, std::size_t end)
+	{
+		averagePixels(one, two, out, first, end, opaque, set);
+	});
+}
+
+void scale(const byte* in, byte* out, std::size_t numPixels, const float factors[4])
+{
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(numPixels, 1, [&](std::size_t first, std::size_t end)
+	{
+		scalePixels(in, out, first, end, factors, set);
+	});
+}
+
+void invert(const byte* in, byte* out, std::size_t numPixels, bool colour, bool alpha)
+{
+	InstructionSet set = getInstructionSet();
+
+	byte colourMask = colour ? 255 : 0;
+	const byte mask[4] = { colourMask, colourMask, colourMask, static_cast<byte>(alpha ? 255 : 0) };
+
+	forEachBlock(numPixels, 1, [&](std::size_t first, std::size_t end)
+	{
+		invertPixels(in, out, first, end, mask, set);
+	});
+}
+
+void makeIntensity(const byte* in, byte* out, std::size_t numPixels)
+{
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(numPixels, 1, [&](std::size_t first, std::size_t end)
+	{
+		makeIntensityPixels(in, out, first, end, set);
+	});
+}
+
+void makeAlpha(const byte* in, byte* out, std::size_t numPixels)
+{
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(numPixels, 1, [&](std::size_t first, std::size_t end)
+	{
+		makeAlphaPixels(in, out, first, end, set);
+	});
+}
+
+void smoothNormals(const byte* in, byte* out, std::size_t width, std::size_t height)
+{
+	if (width == 0 || height == 0) return;
+
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(height, width, [&](std::size_t first, std::size_t end)
+	{
+		smoothNormalsRows(in, out, width, height, first, end, set);
+	});
+}
+
+void heightMapToNormals(const byte* in, byte* out, std::size_t width, std::size_t height, float scale)
+{
+	if (width == 0 || height == 0) return;
+
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(height, width, [&](std::size_t first, std::size_t end)
+	{
+		heightMapRows(in, out, width, height, scale, first, end, set);
+	});
+}
+
+void resample(const byte* in, std::size_t inWidth, std::size_t inHeight,
+			  byte* out, std::size_t outWidth, std::size_t outHeight)
+{
+	if (inWidth == 0 || inHeight == 0 || outWidth == 0 || outHeight == 0) return;
+
+	InstructionSet set = getInstructionSet();
+
+	forEachBlock(outHeight, outWidth, [&](std::size_t first, std::size_t end)
+	{
+		resampleRows(in, inWidth, inHeight, out, outWidth, outHeight, first, end, set);
+	});
+}
+
+} // namespace
+
+} // namespace
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include "iimage.h"
+
+class TaskScheduler;
+
+namespace shaders
+{
+
+/**
+ * Pixel kernels used by the map expressions, operating on 32 bit RGBA
+ * buffers. The results match the original per-pixel implementations
+ * exactly, regardless of the instruction set being used.
+ *
+ * Each kernel has a scalar implementation and vectorised SSE2 and AVX2
+ * paths, the best one supported by the CPU is picked at runtime. Large
+ * images are split into blocks of rows which are processed by the worker
+ * threads of the task scheduler, if one has been set.
+ */
+namespace kernels
+{
+
+enum class InstructionSet
+{
+	Scalar,
+	SSE2,
+	AVX2,
+};
+
+/// The most capable instruction set supported by this build and CPU
+InstructionSet getSupportedInstructionSet();
+
+/// The instruction set used by the kernels
+InstructionSet getInstructionSet();
+
+/// Restrict the kernels to the given instruction set (used for testing),
+/// sets which are not supported fall back to the best supported one
+void setInstructionSet(InstructionSet set);
+
+/// Set the scheduler to split large images with, NULL to process all
+/// images on the calling thread
+void setTaskScheduler(TaskScheduler* scheduler);
+
+/// Mean of the two images, rounding halves to even. If opaque is true,
+/// the alpha channel of the result is set to 255 instead.
+void average(const byte* one, const byte* two, byte* out, std::size_t numPixels, bool opaque);
+
+/// Multiply the RGBA channels with the given non-negative factors, clamping at 255
+void scale(const byte* in, byte* out, std::size_t numPixels, const float factors[4]);
+
+/// Invert the colour and/or the alpha channels
+void invert(const byte* in, byte* out, std::size_t numPixels, bool colour, bool alpha);
+
+/// Copy the red channel to all other channels
+void makeIntensity(const byte* in, byte* out, std::size_t numPixels);
+
+/// White image with the mean of the colour channels as alpha channel
+void makeAlpha(const byte* in, byte* out, std::size_t numPixels);
+
+/// Average the colour of each pixel with its eight neighbours, wrapping
+/// around at the borders. The alpha channel is set to 255.
+void smoothNormals(const byte* in, byte* out, std::size_t width, std::size_t height);
+
+/// Create a normal map from the red channel of the given heightmap,
+/// using a 3x3 Prewitt filter and wrapping around at the borders
+void heightMapToNormals(const byte* in, byte* out, std::size_t width, std::size_t height, float scale);
+
+/// Bilinear resampling to the given output size, matching
+/// TextureManipulator::resampleTexture()
+void resample(const byte* in, std::size_t inWidth, std::size_t inHeight,
+			  byte* out, std::size_t outWidth, std::size_t outHeight);
+
+} // namespace
+
+} // namespace
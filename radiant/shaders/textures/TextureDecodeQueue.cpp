@@ -0,0 +1,194 @@
+#include "TextureDecodeQueue.h"
+
+#include "itextstream.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace shaders
+{
+
+TextureDecodeQueue::TextureDecodeQueue(std::size_t maxQueuedImages) :
+	_scheduler(NULL),
+	_maxQueuedImages(std::max<std::size_t>(maxQueuedImages, 1)),
+	_numDecoding(0)
+{}
+
+TextureDecodeQueue::~TextureDecodeQueue()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	// The workers are referring to this instance
+	_decodingFinished.wait(lock, [this]() { return _numDecoding == 0; });
+}
+
+void TextureDecodeQueue::setTaskScheduler(TaskScheduler* scheduler)
+{
+	_scheduler = scheduler;
+}
+
+void TextureDecodeQueue::setImagesAvailableCallback(const std::function<void()>& callback)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_imagesAvailable = callback;
+}
+
+void TextureDecodeQueue::add(const DecodeFunction& decode, const UploadFunction& upload)
+{
+	Request request{ decode, upload };
+
+	if (_scheduler == NULL)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			++_numDecoding;
+		}
+
+		decodeRequest(request);
+		processDecodedImages(1);
+		return;
+	}
+
+	_requests.push_back(request);
+	dispatchRequests();
+}
+
+std::size_t TextureDecodeQueue::processDecodedImages(std::size_t maxImages)
+{
+	std::size_t numUploaded = 0;
+
+	while (numUploaded < maxImages)
+	{
+		DecodedImage decoded;
+
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+
+			if (_decoded.empty()) break;
+
+			decoded = std::move(_decoded.front());
+			_decoded.pop_front();
+		}
+
+		decoded.upload(decoded.image);
+		++numUploaded;
+	}
+
+	dispatchRequests();
+
+	std::function<void()> imagesAvailable;
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		// Images left for later need another call
+		if (!_decoded.empty())
+		{
+			imagesAvailable = _imagesAvailable;
+		}
+	}
+
+	if (imagesAvailable)
+	{
+		imagesAvailable();
+	}
+
+	return numUploaded;
+}
+
+void TextureDecodeQueue::flush()
+{
+	while (getNumPendingImages() > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+
+			_decodingFinished.wait(lock, [this]()
+			{
+				return !_decoded.empty() || _numDecoding == 0;
+			});
+		}
+
+		std::size_t numDecoded = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			numDecoded = _decoded.size();
+		}
+
+		processDecodedImages(numDecoded);
+	}
+}
+
+std::size_t TextureDecodeQueue::getNumPendingImages() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _requests.size() + _decoded.size() + _numDecoding;
+}
+
+std::size_t TextureDecodeQueue::getNumQueuedImages() const
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _decoded.size() + _numDecoding;
+}
+
+void TextureDecodeQueue::dispatchRequests()
+{
+	if (_scheduler == NULL) return;
+
+	while (!_requests.empty())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+
+			if (_decoded.size() + _numDecoding >= _maxQueuedImages) return;
+
+			++_numDecoding;
+		}
+
+		Request request = std::move(_requests.front());
+		_requests.pop_front();
+
+		_scheduler->enqueue([this, request]()
+		{
+			decodeRequest(request);
+		});
+	}
+}
+
+void TextureDecodeQueue::decodeRequest(const Request& request)
+{
+	ImagePtr image;
+
+	try
+	{
+		image = request.decode();
+	}
+	catch (std::exception& ex)
+	{
+		rError() << "[shaders] Failed to decode texture: " << ex.what() << std::endl;
+	}
+
+	std::function<void()> imagesAvailable;
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		if (_decoded.empty() && _scheduler != NULL)
+		{
+			imagesAvailable = _imagesAvailable;
+		}
+
+		_decoded.push_back(DecodedImage{ image, request.upload });
+		--_numDecoding;
+
+		// Notify while holding the lock, the destructor may be waiting for this
+		_decodingFinished.notify_all();
+	}
+
+	if (imagesAvailable)
+	{
+		imagesAvailable();
+	}
+}
+
+}
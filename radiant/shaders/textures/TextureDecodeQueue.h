@@ -0,0 +1,115 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "iimage.h"
+#include "ithread.h"
+
+namespace shaders
+{
+
+/**
+ * Decodes images on the worker threads of a TaskScheduler and holds the
+ * results until the main thread takes them for uploading to OpenGL.
+ *
+ * The number of images being decoded or waiting for their upload is bounded,
+ * further requests are held back until uploads have made room. This keeps
+ * the memory used by decoded pixel data in check when a large number of
+ * textures is realised at once (e.g. when loading a map).
+ *
+ * Requests are added and uploads are processed on the main thread only.
+ * Without a scheduler, images are decoded and uploaded immediately.
+ */
+class TextureDecodeQueue
+{
+public:
+	// Produces the image, is called on a worker thread
+	typedef std::function<ImagePtr()> DecodeFunction;
+
+	// Receives the decoded image on the main thread, which is empty if decoding failed
+	typedef std::function<void(const ImagePtr&)> UploadFunction;
+
+private:
+	struct Request
+	{
+		DecodeFunction decode;
+		UploadFunction upload;
+	};
+
+	struct DecodedImage
+	{
+		ImagePtr image;
+		UploadFunction upload;
+	};
+
+	TaskScheduler* _scheduler;
+
+	// Maximum number of images being decoded or waiting for their upload
+	std::size_t _maxQueuedImages;
+
+	// Requests waiting for a free slot, only accessed by the main thread
+	std::deque<Request> _requests;
+
+	// Guards the members below, which are modified by the workers
+	mutable std::mutex _lock;
+	std::condition_variable _decodingFinished;
+
+	std::deque<DecodedImage> _decoded;
+	std::size_t _numDecoding;
+
+	// Invoked by a worker when decoded images become available
+	std::function<void()> _imagesAvailable;
+
+public:
+	TextureDecodeQueue(std::size_t maxQueuedImages);
+
+	// Waits for the images being decoded, they are not uploaded
+	~TextureDecodeQueue();
+
+	/// Set the scheduler to decode the images with, NULL to decode them immediately
+	void setTaskScheduler(TaskScheduler* scheduler);
+
+	/// Returns true if images are decoded by the worker threads of a scheduler
+	bool hasTaskScheduler() const
+	{
+		return _scheduler != NULL;
+	}
+
+	/**
+	 * Set the function to call when decoded images are waiting for their
+	 * upload. It is called on a worker thread, once for each time the list
+	 * of decoded images is no longer empty, and by processDecodedImages()
+	 * when it leaves images for later.
+	 */
+	void setImagesAvailableCallback(const std::function<void()>& callback);
+
+	/// Queue an image for decoding
+	void add(const DecodeFunction& decode, const UploadFunction& upload);
+
+	/**
+	 * Pass up to maxImages decoded images to their upload functions and
+	 * start decoding the requests which have been waiting for room in the
+	 * queue. Returns the number of uploaded images.
+	 */
+	std::size_t processDecodedImages(std::size_t maxImages);
+
+	/// Decode and upload everything which is queued, blocking the calling thread
+	void flush();
+
+	/// The number of images not yet uploaded, including the ones being decoded
+	std::size_t getNumPendingImages() const;
+
+	/// The number of images being decoded or waiting for their upload
+	std::size_t getNumQueuedImages() const;
+
+private:
+	// Start decoding waiting requests while there is room in the queue
+	void dispatchRequests();
+
+	void decodeRequest(const Request& request);
+};
+
+}
@@ -11,13 +11,15 @@
 
 namespace 
 {
-	static byte *row1 = NULL, *row2 = NULL;
-	static std::size_t rowsize = 0;
+	// Scratch rows of resampleTexture(), images are resampled on worker threads as well
+	thread_local byte *row1 = NULL, *row2 = NULL;
+	thread_local std::size_t rowsize = 0;
 
 	const std::size_t MAX_TEXTURE_QUALITY = 3;
 
 	const std::string RKEY_TEXTURES_QUALITY = "user/ui/textures/quality";
 	const std::string RKEY_TEXTURES_GAMMA = "user/ui/textures/gamma";
+	const std::string RKEY_TEXTURES_MEMORY_BUDGET = "user/ui/textures/memoryBudget";
 }
 
 namespace shaders {
@@ -560,6 +562,9 @@ void TextureManipulator::constructPreferences()
 
 	// Texture Gamma Settings
 	page.appendSpinner("Texture Gamma", RKEY_TEXTURES_GAMMA, 0.0f, 1.0f, 10);
+
+	// Memory used by the material textures, 0 for no limit
+	page.appendSpinner("Texture Memory Budget (MB)", RKEY_TEXTURES_MEMORY_BUDGET, 0, 65536, 0);
 }
 
 } // namespace shaders
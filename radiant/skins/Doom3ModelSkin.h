@@ -1,6 +1,7 @@
 #pragma once
 
 #include "modelskin.h"
+#include "parser/DeclFileCache.h"
 
 #include <string>
 #include <map>
@@ -57,6 +58,30 @@ public:
 		_remaps.insert(StringMap::value_type(src, dst));
 	}
 
+	// Stores the remaps in the DeclFileCache record
+	void writeToCache(parser::DeclWriter& writer) const
+	{
+		writer.writeSize(_remaps.size());
+
+		for (const StringMap::value_type& pair : _remaps)
+		{
+			writer.writeString(pair.first);
+			writer.writeString(pair.second);
+		}
+	}
+
+	// Restores the remaps written by writeToCache()
+	void readFromCache(parser::DeclReader& reader)
+	{
+		_remaps.clear();
+
+		for (std::size_t i = reader.readCount(8); i > 0; --i)
+		{
+			std::string src = reader.readString();
+			addRemap(src, reader.readString());
+		}
+	}
+
 };
 typedef std::shared_ptr<Doom3ModelSkin> Doom3ModelSkinPtr;
 
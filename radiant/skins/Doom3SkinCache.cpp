@@ -66,27 +66,64 @@ void Doom3SkinCache::loadSkinFiles()
 	// exceptions that may be thrown
 	try
 	{
+        std::vector<vfs::FileInfo> skinFiles;
+
         GlobalFileSystem().forEachFile(
             SKINS_FOLDER, "skin",
+            [&] (const vfs::FileInfo& fileInfo) { skinFiles.push_back(fileInfo); }
+        );
+
+        _declCache.load();
+
+        // Parse the files concurrently, then add the skins in file order
+        util::parseFilesInParallel<vfs::FileInfo, ParsedSkins>(skinFiles,
             [&] (const vfs::FileInfo& fileInfo)
             {
-                // Open the .skin file and get its contents as a std::string
-                ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(SKINS_FOLDER + fileInfo.name);
-                assert(file);
+                std::string path = SKINS_FOLDER + fileInfo.name;
 
-                std::istream is(&(file->getInputStream()));
+                // Parse the .skin file, unless it is unchanged since the last run
+                std::string data;
+                vfs::FileStamp stamp = GlobalFileSystem().getFileStamp(path);
+
+                try
+                {
+                    if (_declCache.lookup(path, stamp, data))
+                    {
+                        return readFromCache(data, fileInfo.name);
+                    }
+                }
+                catch (parser::ParseException& e)
+                {
+                    rWarning() << "[skins]: discarding the cached skins of " << fileInfo.name
+                        << ": " << e.what() << std::endl;
+                }
 
                 try 
                 {
-                    // Pass the contents back to the SkinCache module for parsing
-                    parseFile(is, fileInfo.name);
+                    ArchiveTextFilePtr file = GlobalFileSystem().openTextFile(path);
+                    assert(file);
+
+                    std::istream is(&(file->getInputStream()));
+                    parser::BasicDefTokeniser<std::istream> tok(is);
+
+                    ParsedSkins skins = parseFile(tok, fileInfo.name);
+                    _declCache.store(path, stamp, writeToCache(skins));
+
+                    return skins;
                 }
                 catch (parser::ParseException& e)
                 {
                     rError() << "[skins]: in " << fileInfo.name << ": " << e.what() << std::endl;
+                    return ParsedSkins();
                 }
+            },
+            [&] (const vfs::FileInfo& fileInfo, ParsedSkins& skins)
+            {
+                addSkins(skins, fileInfo.name);
             }
         );
+
+        _declCache.save();
 	}
 	catch (parser::ParseException& e)
 	{
@@ -99,11 +136,10 @@ void Doom3SkinCache::loadSkinFiles()
 	_sigSkinsReloaded.emit();
 }
 
-// Parse the contents of a .skin file
-void Doom3SkinCache::parseFile(std::istream& contents, const std::string& filename)
+// Parse the tokens of a .skin file
+Doom3SkinCache::ParsedSkins Doom3SkinCache::parseFile(parser::DefTokeniser& tok, const std::string& filename)
 {
-    // Construct a DefTokeniser to parse the file
-	parser::BasicDefTokeniser<std::istream> tok(contents);
+    ParsedSkins skins;
 
 	// Call the parseSkin() function for each skin decl
 	while (tok.hasMoreTokens())
@@ -111,38 +147,98 @@ void Doom3SkinCache::parseFile(std::istream& contents, const std::string& filena
 		try
         {
 			// Try to parse the skin
-			Doom3ModelSkinPtr modelSkin = parseSkin(tok);
-			std::string skinName = modelSkin->getName();
-
-			modelSkin->setSkinFileName(filename);
-
-			NamedSkinMap::iterator found = _namedSkins.find(skinName);
+            ParsedSkin parsed;
+			parsed.skin = parseSkin(tok, parsed.models);
+			parsed.skin->setSkinFileName(filename);
 
-			// Is this already defined?
-			if (found != _namedSkins.end()) 
-            {
-                rConsole() << "[skins] in " << filename << ": skin " + skinName +
-						     " previously defined in " +
-							 found->second->getSkinFileName() + "!" << std::endl;
-				// Don't insert the skin into the list
-			}
-			else
-            {
-				// Add the populated Doom3ModelSkin to the hashtable and the name to the
-				// list of all skins
-				_namedSkins.insert(NamedSkinMap::value_type(skinName, modelSkin));
-				_allSkins.push_back(skinName);
-			}
+            skins.push_back(parsed);
 		}
 		catch (parser::ParseException& e)
         {
             rConsole() << "[skins]: in " << filename << ": " << e.what() << std::endl;
 		}
 	}
+
+    return skins;
+}
+
+std::string Doom3SkinCache::writeToCache(const ParsedSkins& skins)
+{
+    parser::DeclWriter writer;
+    writer.writeSize(skins.size());
+
+    for (const ParsedSkin& parsed : skins)
+    {
+        writer.writeString(parsed.skin->getName());
+        parsed.skin->writeToCache(writer);
+
+        writer.writeSize(parsed.models.size());
+
+        for (const std::string& model : parsed.models)
+        {
+            writer.writeString(model);
+        }
+    }
+
+    return writer.getData();
+}
+
+Doom3SkinCache::ParsedSkins Doom3SkinCache::readFromCache(const std::string& data, const std::string& filename)
+{
+    parser::DeclReader reader(data);
+    ParsedSkins skins(reader.readCount(12));
+
+    for (ParsedSkin& parsed : skins)
+    {
+        parsed.skin = std::make_shared<Doom3ModelSkin>(reader.readString());
+        parsed.skin->readFromCache(reader);
+        parsed.skin->setSkinFileName(filename);
+
+        parsed.models.resize(reader.readCount(4));
+
+        for (std::string& model : parsed.models)
+        {
+            model = reader.readString();
+        }
+    }
+
+    return skins;
+}
+
+void Doom3SkinCache::addSkins(ParsedSkins& skins, const std::string& filename)
+{
+    for (ParsedSkin& parsed : skins)
+    {
+        std::string skinName = parsed.skin->getName();
+
+        // The model associations are kept even for duplicate skins
+        for (const std::string& model : parsed.models)
+        {
+            _modelSkins[model].push_back(skinName);
+        }
+
+        NamedSkinMap::iterator found = _namedSkins.find(skinName);
+
+        // Is this already defined?
+        if (found != _namedSkins.end()) 
+        {
+            rConsole() << "[skins] in " << filename << ": skin " + skinName +
+                         " previously defined in " +
+                         found->second->getSkinFileName() + "!" << std::endl;
+            // Don't insert the skin into the list
+        }
+        else
+        {
+            // Add the populated Doom3ModelSkin to the hashtable and the name to the
+            // list of all skins
+            _namedSkins.insert(NamedSkinMap::value_type(skinName, parsed.skin));
+            _allSkins.push_back(skinName);
+        }
+    }
 }
 
 // Parse an individual skin declaration
-Doom3ModelSkinPtr Doom3SkinCache::parseSkin(parser::DefTokeniser& tok) 
+Doom3ModelSkinPtr Doom3SkinCache::parseSkin(parser::DefTokeniser& tok, std::vector<std::string>& models)
 {
 	// [ "skin" ] <name> "{"
 	//			[ "model" <modelname> ]
@@ -180,7 +276,7 @@ Doom3ModelSkinPtr Doom3SkinCache::parseSkin(parser::DefTokeniser& tok)
 		// this is a remap declaration
 		if (key == "model")
         {
-			_modelSkins[value].push_back(skinName);
+			models.push_back(value);
 		}
 		else
         {
@@ -227,6 +323,8 @@ void Doom3SkinCache::initialiseModule(const ApplicationContext& ctx)
 {
 	rMessage() << "Doom3SkinCache::initialiseModule called" << std::endl;
 
+    _declCache.setCacheFile(ctx.getSettingsPath() + "skins.cache");
+
     // Load the skins in a new thread
     refresh();
 }
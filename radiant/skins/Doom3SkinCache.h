@@ -5,6 +5,7 @@
 #include "imodule.h"
 #include "modelskin.h"
 #include "parser/DefTokeniser.h"
+#include "parser/DeclFileCache.h"
 
 #include <future>
 #include <map>
@@ -36,11 +37,22 @@ class Doom3SkinCache :
     // Helper which will invoke loadSkinFiles() in a separate thread
     util::ThreadedDefLoader<void> _defLoader;
 
+    // Skins parsed from the skin files, stored between sessions
+    parser::DeclFileCache _declCache;
+
 	// Empty Doom3ModelSkin to return if a named skin is not found
 	Doom3ModelSkin _nullSkin;
 
 	sigc::signal<void> _sigSkinsReloaded;
 
+	// A skin as parsed from a file, together with the models it is listed for
+	struct ParsedSkin
+	{
+		Doom3ModelSkinPtr skin;
+		std::vector<std::string> models;
+	};
+	typedef std::vector<ParsedSkin> ParsedSkins;
+
 public:
 	/* Constructor.
 	 */
@@ -81,15 +93,24 @@ private:
     // Iterates over each skin file in the VFS skins/ folder
     void loadSkinFiles();
 
-    // Parse an individual skin declaration and add return the skin object
-    Doom3ModelSkinPtr parseSkin(parser::DefTokeniser& tokeniser);
+    // Parse an individual skin declaration and return the skin object,
+    // the names of the models listed in the declaration are added to models
+    static Doom3ModelSkinPtr parseSkin(parser::DefTokeniser& tokeniser, std::vector<std::string>& models);
 
-    /* Parse the provided istream as a .skin file, and add all skins found within
-    * to the internal data structures.
+    /* Parse the tokens of a .skin file and return all skins found
+    * within. This doesn't touch the internal data structures, such that
+    * several files can be parsed concurrently.
     *
     * @filename: This is for informational purposes only (error message display).
     */
-    void parseFile(std::istream& contents, const std::string& filename);
+    static ParsedSkins parseFile(parser::DefTokeniser& tok, const std::string& filename);
+
+    // Serialises the skins parsed from a file for the cache, and restores them from that record
+    static std::string writeToCache(const ParsedSkins& skins);
+    static ParsedSkins readFromCache(const std::string& data, const std::string& filename);
+
+    // Adds the skins parsed from the given file to the internal data structures
+    void addSkins(ParsedSkins& skins, const std::string& filename);
 };
 typedef std::shared_ptr<Doom3SkinCache> Doom3SkinCachePtr;
 
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/brush/BrushWindingBuilder.h"
+#include "radiant/brush/export/CollisionModel.h"
+#include "math/pi.h"
+#include "math/AABB.h"
+
+// Brush planes, windings and geometry shared by the brush tests and benchmarks
+namespace brushtest
+{
+
+const double MAX_WORLD_COORD = 65536;
+
+// The planes and windings of a single brush, plus its builder
+struct TestBrush
+{
+    std::vector<Plane3> planes;
+    std::vector<IWinding> windings;
+    BrushWindingBuilder builder;
+
+    std::size_t build()
+    {
+        std::vector<IWinding*> windingPtrs;
+
+        windings.resize(planes.size());
+
+        for (IWinding& winding : windings)
+        {
+            windingPtrs.push_back(&winding);
+        }
+
+        return builder.build(planes, windingPtrs, MAX_WORLD_COORD);
+    }
+};
+
+inline void addCuboidPlanes(std::vector<Plane3>& planes, const AABB& bounds)
+{
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        Vector3 normal(0, 0, 0);
+        normal[axis] = 1;
+
+        planes.push_back(Plane3(normal, bounds.origin[axis] + bounds.extents[axis]));
+        planes.push_back(Plane3(-normal, -(bounds.origin[axis] - bounds.extents[axis])));
+    }
+}
+
+// Generates cuboids, cylinders and cuboids with bevelled corners
+inline std::vector<TestBrush> generateBrushes(std::size_t count)
+{
+    std::vector<TestBrush> brushes(count);
+    std::mt19937 rng(2718);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Vector3 origin(int(rng() % 32768) - 16384, int(rng() % 32768) - 16384, int(rng() % 4096) - 2048);
+        Vector3 extents(8 + rng() % 128, 8 + rng() % 128, 8 + rng() % 128);
+
+        std::vector<Plane3>& planes = brushes[i].planes;
+
+        switch (i % 3)
+        {
+        case 0:
+            addCuboidPlanes(planes, AABB(origin, extents));
+            break;
+
+        case 1:
+        {
+            // An 8-sided cylinder along the z axis
+            planes.push_back(Plane3(0, 0, 1, origin.z() + extents.z()));
+            planes.push_back(Plane3(0, 0, -1, -(origin.z() - extents.z())));
+
+            for (int side = 0; side < 8; ++side)
+            {
+                double angle = side * c_pi / 4;
+                Vector3 normal(cos(angle), sin(angle), 0);
+
+                planes.push_back(Plane3(normal, normal.dot(origin) + extents.x()));
+            }
+            break;
+        }
+
+        case 2:
+            addCuboidPlanes(planes, AABB(origin, extents));
+
+            // Cut off some corners
+            for (int cut = 0; cut < 3; ++cut)
+            {
+                Vector3 normal(rng() % 2 ? 1 : -1, rng() % 2 ? 1 : -1, rng() % 2 ? 1 : -1);
+                normal.normalise();
+
+                Vector3 corner = origin + Vector3(normal.x() * extents.x(), normal.y() * extents.y(), normal.z() * extents.z());
+                planes.push_back(Plane3(normal, normal.dot(corner) - 4 - rng() % 8));
+            }
+            break;
+        }
+    }
+
+    return brushes;
+}
+
+// Windings are compared as polygons, a reused winding might start at a different vertex
+inline void checkSameWindings(const std::vector<IWinding>& a, const std::vector<IWinding>& b)
+{
+    BOOST_TEST_REQUIRE(a.size() == b.size());
+
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        BOOST_TEST_REQUIRE(a[i].size() == b[i].size());
+
+        if (a[i].empty()) continue;
+
+        std::size_t offset = 0;
+
+        while (offset < b[i].size() && b[i][offset].adjacent != a[i][0].adjacent)
+        {
+            ++offset;
+        }
+
+        BOOST_TEST_REQUIRE(offset < b[i].size());
+
+        for (std::size_t v = 0; v < a[i].size(); ++v)
+        {
+            const WindingVertex& other = b[i][(v + offset) % b[i].size()];
+
+            BOOST_TEST_REQUIRE(a[i][v].adjacent == other.adjacent);
+            BOOST_TEST_REQUIRE(a[i][v].vertex.isEqual(other.vertex, 0.001));
+        }
+    }
+}
+
+const char* const COLLISION_SHADER = "textures/common/collision";
+
+// Adds a face with the given points, which are expected in clockwise order
+inline void addFace(cmutil::BrushGeometry& brush, const std::vector<Vector3>& points)
+{
+    cmutil::FaceGeometry face;
+    face.plane = Plane3(points[0], points[1], points[2]);
+    face.winding = points;
+
+    for (const Vector3& point : points)
+    {
+        brush.bounds.includePoint(point);
+    }
+
+    brush.faces.push_back(face);
+}
+
+// A prism with the given number of sides, rotated around the z axis
+inline cmutil::BrushGeometry createPrism(const Vector3& origin, double radius, double height,
+                                         std::size_t sides, double angle)
+{
+    cmutil::BrushGeometry brush;
+    std::vector<Vector3> bottom;
+    std::vector<Vector3> top;
+
+    for (std::size_t i = 0; i < sides; ++i)
+    {
+        double a = angle + 2 * c_pi * i / sides;
+        Vector3 offset(cos(a) * radius, sin(a) * radius, 0);
+
+        bottom.push_back(origin + offset);
+        top.push_back(origin + offset + Vector3(0, 0, height));
+    }
+
+    addFace(brush, std::vector<Vector3>(top.rbegin(), top.rend()));
+    addFace(brush, bottom);
+
+    for (std::size_t i = 0; i < sides; ++i)
+    {
+        std::size_t next = (i + 1) % sides;
+        addFace(brush, { bottom[i], top[i], top[next], bottom[next] });
+    }
+
+    return brush;
+}
+
+// A grid of touching cuboids, sharing their vertices, edges and inner faces
+inline std::vector<cmutil::BrushGeometry> generateGrid(std::size_t size)
+{
+    std::vector<cmutil::BrushGeometry> brushes;
+
+    for (std::size_t x = 0; x < size; ++x)
+    {
+        for (std::size_t y = 0; y < size; ++y)
+        {
+            for (std::size_t z = 0; z < 2; ++z)
+            {
+                Vector3 origin(x * 32.0 + 16, y * 32.0 + 16, z * 32.0 + 16);
+                brushes.push_back(createPrism(origin - Vector3(0, 0, 16), sqrt(2.0) * 16, 32, 4, c_pi / 4));
+            }
+        }
+    }
+
+    return brushes;
+}
+
+// Randomly placed prisms, with off-grid vertices and a few degenerate faces
+inline std::vector<cmutil::BrushGeometry> generateRandomBrushes(std::size_t count)
+{
+    std::vector<cmutil::BrushGeometry> brushes;
+    std::mt19937 rng(1337);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Vector3 origin(int(rng() % 2048) - 1024, int(rng() % 2048) - 1024, int(rng() % 512));
+        double radius = 8 + rng() % 64 + (rng() % 1000) / 1000.0;
+        double height = 8 + rng() % 64;
+        std::size_t sides = 3 + rng() % 8;
+
+        brushes.push_back(createPrism(origin, radius, height, sides, (rng() % 360) * c_pi / 180));
+
+        if (i % 10 == 0)
+        {
+            // A face with a vertex closer to its neighbour than the export precision,
+            // creating an edge from a vertex to itself and a polygon using it twice
+            cmutil::FaceGeometry& face = brushes.back().faces.front();
+            face.winding.insert(face.winding.begin() + 1, face.winding[1] + Vector3(0.00001, 0, 0));
+        }
+    }
+
+    // A winding running back and forth over the same vertices
+    cmutil::BrushGeometry degenerate;
+    Vector3 a(0, 0, 0), b(64, 0, 0), c(64, 64, 0);
+    addFace(degenerate, { a, b, c });
+    addFace(degenerate, { a, a, b, c });
+    addFace(degenerate, { a, b, a, b });
+    addFace(degenerate, { b, a, b, a });
+    brushes.insert(brushes.begin(), degenerate);
+
+    return brushes;
+}
+
+inline std::string exportModel(const std::vector<cmutil::BrushGeometry>& brushes)
+{
+    cmutil::CollisionModel cm(COLLISION_SHADER);
+
+    for (const cmutil::BrushGeometry& brush : brushes)
+    {
+        cm.addBrush(brush);
+    }
+
+    cm.setModel("models/test.lwo");
+
+    std::ostringstream stream;
+    stream << cm;
+
+    return stream.str();
+}
+
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "eclassmgr/AttributeTable.h"
+
+// Entity class trees shared by the entity class tests and benchmarks
+namespace eclasstest
+{
+
+// The lookup of Doom3EntityClass, following the parent classes
+struct TableClass
+{
+    eclass::AttributeTable attributes;
+    const TableClass* parent = nullptr;
+
+    const EntityClassAttribute* find(const std::string& name) const
+    {
+        eclass::AttributeTable::HotKey hotKey = eclass::AttributeTable::getHotKey(name);
+        unsigned int hash = eclass::AttributeTable::hashName(name);
+
+        for (const TableClass* eclass = this; eclass != nullptr; eclass = eclass->parent)
+        {
+            const EntityClassAttribute* attribute = hotKey != eclass::AttributeTable::NO_HOT_KEY ?
+                eclass->attributes.find(hotKey) : eclass->attributes.find(name, hash);
+
+            if (attribute != nullptr)
+            {
+                return attribute;
+            }
+        }
+
+        return nullptr;
+    }
+};
+
+struct Def
+{
+    std::string name;
+    int parent;
+    std::vector<std::pair<std::string, std::string>> spawnargs;
+};
+
+// A tree of entity classes similar to a mod's entityDefs, the deeper
+// classes override some of the keys of their parents
+inline std::vector<Def> generateDefs(std::size_t numClasses)
+{
+    std::mt19937 random(42);
+    std::vector<Def> defs(numClasses);
+
+    const char* const commonKeys[] =
+    {
+        "editor_usage", "editor_color", "health", "team", "snd_idle", "frobable",
+        "editor_mins", "editor_maxs", "model", "spawnclass"
+    };
+
+    for (std::size_t i = 0; i < numClasses; ++i)
+    {
+        Def& def = defs[i];
+
+        def.name = "atdm:Class_" + std::to_string(i);
+        def.parent = i == 0 ? -1 : static_cast<int>((i - 1) / 4);
+
+        if (def.parent >= 0)
+        {
+            def.spawnargs.emplace_back("inherit", defs[def.parent].name);
+        }
+
+        for (const char* key : commonKeys)
+        {
+            if (random() % 3 == 0)
+            {
+                def.spawnargs.emplace_back(key, std::to_string(random() % 20));
+            }
+        }
+
+        for (std::size_t j = 0; j < 15; ++j)
+        {
+            def.spawnargs.emplace_back(
+                "key_" + std::to_string(i % 50) + "_" + std::to_string(j), std::to_string(random() % 100));
+        }
+    }
+
+    return defs;
+}
+
+inline std::vector<std::string> collectKeys(const std::vector<Def>& defs)
+{
+    std::vector<std::string> keys;
+
+    for (const Def& def : defs)
+    {
+        for (const auto& spawnarg : def.spawnargs)
+        {
+            keys.push_back(spawnarg.first);
+        }
+    }
+
+    keys.push_back("not_defined");
+
+    return keys;
+}
+
+// The spawnargs of each class including the inherited ones, the keys are lowercase
+typedef std::map<std::string, std::string> Spawnargs;
+
+inline std::vector<Spawnargs> resolveSpawnargs(const std::vector<Def>& defs)
+{
+    std::vector<Spawnargs> resolved(defs.size());
+
+    for (std::size_t i = 0; i < defs.size(); ++i)
+    {
+        // The parents come first, their inheritance is resolved already
+        if (defs[i].parent >= 0)
+        {
+            resolved[i] = resolved[defs[i].parent];
+        }
+
+        for (const auto& spawnarg : defs[i].spawnargs)
+        {
+            resolved[i][spawnarg.first] = spawnarg.second;
+        }
+    }
+
+    return resolved;
+}
+
+inline std::vector<TableClass> buildTableClasses(const std::vector<Def>& defs)
+{
+    std::vector<TableClass> classes(defs.size());
+
+    for (std::size_t i = 0; i < defs.size(); ++i)
+    {
+        for (const auto& spawnarg : defs[i].spawnargs)
+        {
+            classes[i].attributes.insert(
+                eclass::StringPool::Instance().createAttribute("text", spawnarg.first, spawnarg.second, ""));
+        }
+
+        classes[i].attributes.shrinkToFit();
+
+        if (defs[i].parent >= 0)
+        {
+            classes[i].parent = &classes[defs[i].parent];
+        }
+    }
+
+    return classes;
+}
+
+// Every class holding a copy of the inherited attributes, like the
+// entity classes did before their lookups followed the parents
+inline std::vector<TableClass> buildFlattenedClasses(const std::vector<Def>& defs)
+{
+    std::vector<Spawnargs> resolved = resolveSpawnargs(defs);
+    std::vector<TableClass> classes(defs.size());
+
+    for (std::size_t i = 0; i < defs.size(); ++i)
+    {
+        for (const auto& spawnarg : resolved[i])
+        {
+            classes[i].attributes.insert(
+                eclass::StringPool::Instance().createAttribute("text", spawnarg.first, spawnarg.second, ""));
+        }
+
+        classes[i].attributes.shrinkToFit();
+    }
+
+    return classes;
+}
+
+inline std::size_t getMemoryUsage(const std::vector<TableClass>& classes)
+{
+    std::size_t bytes = 0;
+
+    for (const TableClass& eclass : classes)
+    {
+        bytes += eclass.attributes.getMemoryUsage();
+    }
+
+    return bytes;
+}
+
+}
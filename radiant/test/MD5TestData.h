@@ -0,0 +1,391 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "md5model/MD5Anim.h"
+#include "md5model/MD5PoseCache.h"
+#include "md5model/MD5Skeleton.h"
+#include "md5model/MD5Skinning.h"
+#include "parser/DefTokeniser.h"
+#include "string/convert.h"
+
+// Generates the md5mesh and md5anim text of a tentacle used by the MD5 tests:
+// a chain of joints along the z axis, skinned by two tubes and animated by a
+// wave running along the chain
+namespace md5test
+{
+
+const std::size_t NUM_TENTACLE_JOINTS = 11;
+const double TENTACLE_JOINT_DISTANCE = 8;
+const std::size_t NUM_TUBE_SEGMENTS = 16;
+const std::size_t NUM_TUBE_RINGS = 21;
+const std::size_t NUM_WAVE_FRAMES = 48;
+
+namespace detail
+{
+
+// Writes a tube around the z axis, every vertex weighted between the joints
+// above and below it
+inline void writeTube(std::ostream& str, const std::string& shader, double baseRadius, double tipRadius)
+{
+    const std::size_t columns = NUM_TUBE_SEGMENTS + 1;
+    const double length = TENTACLE_JOINT_DISTANCE * (NUM_TENTACLE_JOINTS - 1);
+
+    std::ostringstream verts;
+    std::ostringstream weights;
+    std::size_t numWeights = 0;
+
+    for (std::size_t ring = 0; ring < NUM_TUBE_RINGS; ++ring)
+    {
+        double height = length * ring / (NUM_TUBE_RINGS - 1);
+        double radius = baseRadius + (tipRadius - baseRadius) * height / length;
+
+        // The joint below the ring, tentacle0 is joint 1
+        std::size_t lower = std::min(static_cast<std::size_t>(height / TENTACLE_JOINT_DISTANCE), NUM_TENTACLE_JOINTS - 1);
+        double fraction = height / TENTACLE_JOINT_DISTANCE - lower;
+
+        for (std::size_t column = 0; column < columns; ++column)
+        {
+            double angle = 2 * M_PI * column / NUM_TUBE_SEGMENTS;
+            double x = radius * cos(angle);
+            double y = radius * sin(angle);
+            std::size_t weightCount = fraction > 0 ? 2 : 1;
+
+            verts << "\tvert " << (ring * columns + column) << " ( "
+                << static_cast<double>(column) / NUM_TUBE_SEGMENTS << " "
+                << 1 - static_cast<double>(ring) / (NUM_TUBE_RINGS - 1) << " ) "
+                << numWeights << " " << weightCount << "\n";
+
+            for (std::size_t k = 0; k < weightCount; ++k)
+            {
+                std::size_t joint = lower + k;
+                double z = height - joint * TENTACLE_JOINT_DISTANCE;
+
+                weights << "\tweight " << numWeights++ << " " << (joint + 1) << " "
+                    << (k == 0 ? 1 - fraction : fraction)
+                    << " ( " << x << " " << y << " " << z << " )\n";
+            }
+        }
+    }
+
+    str << "mesh {\n";
+    str << "\tshader \"" << shader << "\"\n\n";
+    str << "\tnumverts " << NUM_TUBE_RINGS * columns << "\n" << verts.str() << "\n";
+    str << "\tnumtris " << (NUM_TUBE_RINGS - 1) * NUM_TUBE_SEGMENTS * 2 << "\n";
+
+    std::size_t tri = 0;
+
+    for (std::size_t ring = 0; ring + 1 < NUM_TUBE_RINGS; ++ring)
+    {
+        for (std::size_t column = 0; column < NUM_TUBE_SEGMENTS; ++column)
+        {
+            std::size_t a = ring * columns + column;
+            std::size_t b = a + columns;
+
+            str << "\ttri " << tri++ << " " << a << " " << b << " " << a + 1 << "\n";
+            str << "\ttri " << tri++ << " " << a + 1 << " " << b << " " << b + 1 << "\n";
+        }
+    }
+
+    str << "\n\tnumweights " << numWeights << "\n" << weights.str() << "}\n\n";
+}
+
+}
+
+// The bind pose is a straight chain of NUM_TENTACLE_JOINTS joints below an
+// "origin" joint, with two tubes skinned to it
+inline std::string generateTentacleMesh()
+{
+    std::ostringstream str;
+    str << std::fixed;
+
+    str << "MD5Version 10\ncommandline \"generated test mesh\"\n\n";
+    str << "numJoints " << NUM_TENTACLE_JOINTS + 1 << "\nnumMeshes 2\n\n";
+
+    str << "joints {\n\t\"origin\"\t-1 ( 0 0 0 ) ( 0 0 0 )\n";
+
+    for (std::size_t i = 0; i < NUM_TENTACLE_JOINTS; ++i)
+    {
+        str << "\t\"tentacle" << i << "\"\t" << i << " ( 0 0 " << i * TENTACLE_JOINT_DISTANCE << " ) ( 0 0 0 )\n";
+    }
+
+    str << "}\n\n";
+
+    detail::writeTube(str, "models/md5/tentacle_base", 4, 1);
+    detail::writeTube(str, "models/md5/tentacle_tip", 2, 0.5);
+
+    return str.str();
+}
+
+// The origin joint moves in a circle, while the tentacle joints rotate
+// about the x and y axes with a phase shift along the chain
+inline std::string generateTentacleAnim()
+{
+    const std::size_t numJoints = NUM_TENTACLE_JOINTS + 1;
+
+    std::ostringstream str;
+    str << std::fixed;
+
+    str << "MD5Version 10\ncommandline \"generated test animation\"\n\n";
+    str << "numFrames " << NUM_WAVE_FRAMES << "\nnumJoints " << numJoints << "\n";
+    str << "frameRate 24\nnumAnimatedComponents " << numJoints * 3 << "\n\n";
+
+    // Translation of the origin, rotation of the tentacle joints
+    str << "hierarchy {\n\t\"origin\"\t-1 7 0\n";
+
+    for (std::size_t i = 0; i < NUM_TENTACLE_JOINTS; ++i)
+    {
+        str << "\t\"tentacle" << i << "\"\t" << i << " 56 " << (i + 1) * 3 << "\n";
+    }
+
+    str << "}\n\nbounds {\n";
+
+    for (std::size_t frame = 0; frame < NUM_WAVE_FRAMES; ++frame)
+    {
+        str << "\t( -90 -90 -10 ) ( 90 90 90 )\n";
+    }
+
+    str << "}\n\nbaseframe {\n\t( 0 0 0 ) ( 0 0 0 )\n";
+
+    for (std::size_t i = 0; i < NUM_TENTACLE_JOINTS; ++i)
+    {
+        str << "\t( 0 0 " << (i == 0 ? 0 : TENTACLE_JOINT_DISTANCE) << " ) ( 0 0 0 )\n";
+    }
+
+    str << "}\n\n";
+
+    for (std::size_t frame = 0; frame < NUM_WAVE_FRAMES; ++frame)
+    {
+        double phase = 2 * M_PI * frame / NUM_WAVE_FRAMES;
+
+        str << "frame " << frame << " {\n";
+        str << "\t" << 1.5 * sin(phase) << " " << 1.5 * cos(phase) << " 0\n";
+
+        for (std::size_t i = 0; i < NUM_TENTACLE_JOINTS; ++i)
+        {
+            double jointPhase = phase + 0.6 * i;
+
+            str << "\t" << -0.15 * sin(jointPhase) << " " << -0.12 * cos(jointPhase) << " 0\n";
+        }
+
+        str << "}\n\n";
+    }
+
+    return str.str();
+}
+
+// Loading the generated tentacle and comparing skinned vertices
+
+inline Vector3 parseVector3(parser::DefTokeniser& tok)
+{
+    tok.assertNextToken("(");
+
+    float x = string::convert<float>(tok.nextToken());
+    float y = string::convert<float>(tok.nextToken());
+    float z = string::convert<float>(tok.nextToken());
+
+    tok.assertNextToken(")");
+
+    return Vector3(x, y, z);
+}
+
+// The joints and meshes of the md5mesh text, parsed like MD5Model and MD5Surface do
+inline void loadMesh(const std::string& text, md5::MD5Joints& joints, std::vector<md5::MD5Mesh>& meshes)
+{
+    std::istringstream stream(text);
+
+    parser::BasicDefTokeniser<std::istream> tok(stream);
+
+    tok.assertNextToken("MD5Version");
+    tok.assertNextToken("10");
+    tok.assertNextToken("commandline");
+    tok.skipTokens(1);
+    tok.assertNextToken("numJoints");
+    joints.resize(string::convert<std::size_t>(tok.nextToken()));
+    tok.assertNextToken("numMeshes");
+    meshes.resize(string::convert<std::size_t>(tok.nextToken()));
+
+    tok.assertNextToken("joints");
+    tok.assertNextToken("{");
+
+    for (md5::MD5Joint& joint : joints)
+    {
+        tok.skipTokens(1);
+        joint.parent = string::convert<int>(tok.nextToken());
+        joint.position = parseVector3(tok);
+
+        Vector3 rawRotation = parseVector3(tok);
+        double w = -sqrt(std::max(1.0 - rawRotation.getLengthSquared(), 0.0));
+        joint.rotation = Quaternion(rawRotation, w);
+    }
+
+    tok.assertNextToken("}");
+
+    for (md5::MD5Mesh& mesh : meshes)
+    {
+        tok.assertNextToken("mesh");
+        tok.assertNextToken("{");
+        tok.assertNextToken("shader");
+        tok.skipTokens(1);
+
+        tok.assertNextToken("numverts");
+        mesh.vertices.resize(string::convert<std::size_t>(tok.nextToken()));
+
+        for (md5::MD5Vert& vert : mesh.vertices)
+        {
+            tok.assertNextToken("vert");
+            vert.index = string::convert<std::size_t>(tok.nextToken());
+            tok.assertNextToken("(");
+            vert.u = string::convert<float>(tok.nextToken());
+            vert.v = string::convert<float>(tok.nextToken());
+            tok.assertNextToken(")");
+            vert.weight_index = string::convert<std::size_t>(tok.nextToken());
+            vert.weight_count = string::convert<std::size_t>(tok.nextToken());
+        }
+
+        tok.assertNextToken("numtris");
+        mesh.triangles.resize(string::convert<std::size_t>(tok.nextToken()));
+
+        for (md5::MD5Tri& tri : mesh.triangles)
+        {
+            tok.assertNextToken("tri");
+            tri.index = string::convert<std::size_t>(tok.nextToken());
+            tri.a = string::convert<std::size_t>(tok.nextToken());
+            tri.b = string::convert<std::size_t>(tok.nextToken());
+            tri.c = string::convert<std::size_t>(tok.nextToken());
+        }
+
+        tok.assertNextToken("numweights");
+        mesh.weights.resize(string::convert<std::size_t>(tok.nextToken()));
+
+        for (md5::MD5Weight& weight : mesh.weights)
+        {
+            tok.assertNextToken("weight");
+            weight.index = string::convert<std::size_t>(tok.nextToken());
+            weight.joint = string::convert<std::size_t>(tok.nextToken());
+            weight.t = string::convert<float>(tok.nextToken());
+            weight.v = parseVector3(tok);
+        }
+
+        tok.assertNextToken("}");
+    }
+}
+
+inline md5::IMD5AnimPtr loadAnim(const std::string& text)
+{
+    std::istringstream stream(text);
+
+    std::shared_ptr<md5::MD5Anim> anim = std::make_shared<md5::MD5Anim>();
+    anim->parseFromStream(stream);
+
+    return anim;
+}
+
+inline void checkVector(const Vector3& value, const Vector3& expected, double tolerance)
+{
+    BOOST_TEST_REQUIRE(std::abs(value.x() - expected.x()) < tolerance);
+    BOOST_TEST_REQUIRE(std::abs(value.y() - expected.y()) < tolerance);
+    BOOST_TEST_REQUIRE(std::abs(value.z() - expected.z()) < tolerance);
+}
+
+inline void checkVertices(const std::vector<ArbitraryMeshVertex>& vertices, const AABB& bounds,
+                          const std::vector<ArbitraryMeshVertex>& expected, const AABB& expectedBounds)
+{
+    BOOST_TEST_REQUIRE(vertices.size() == expected.size());
+
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+    {
+        // The tentacle is about 80 units long, positions are calculated in float precision
+        checkVector(vertices[i].vertex, expected[i].vertex, 1e-3);
+        checkVector(vertices[i].normal, expected[i].normal, 1e-3);
+        checkVector(vertices[i].tangent, expected[i].tangent, 1e-3);
+        checkVector(vertices[i].bitangent, expected[i].bitangent, 1e-3);
+
+        BOOST_TEST_REQUIRE(vertices[i].texcoord == expected[i].texcoord);
+    }
+
+    checkVector(bounds.getOrigin(), expectedBounds.getOrigin(), 1e-3);
+    checkVector(bounds.getExtents(), expectedBounds.getExtents(), 1e-3);
+}
+
+// Skins the mesh with the unthreaded float implementation, which the other
+// configurations have to match
+inline void skinScalar(const md5::MD5SkinningData& data, const md5::MD5Pose& pose,
+                       std::vector<ArbitraryMeshVertex>& vertices, AABB& bounds)
+{
+    md5::skinning::setVectorised(false);
+    md5::skinning::setTaskScheduler(NULL);
+
+    md5::MD5SkinningBuffers buffers;
+    data.skin(pose, buffers, vertices, bounds);
+
+    md5::skinning::setVectorised(true);
+}
+
+// Time of the given frame of the animation in msec
+inline std::size_t getFrameTime(const md5::IMD5AnimPtr& anim, std::size_t frame)
+{
+    return frame * 1000 / anim->getFrameRate();
+}
+
+struct SkinningFixture
+{
+    md5::MD5Joints joints;
+    std::vector<md5::MD5Mesh> meshes;
+    md5::IMD5AnimPtr anim;
+
+    SkinningFixture()
+    {
+        loadMesh(generateTentacleMesh(), joints, meshes);
+        anim = loadAnim(generateTentacleAnim());
+
+        md5::skinning::setVectorised(true);
+        md5::skinning::setTaskScheduler(NULL);
+    }
+
+    ~SkinningFixture()
+    {
+        md5::skinning::setVectorised(true);
+        md5::skinning::setTaskScheduler(NULL);
+    }
+};
+
+// The generated tentacle animation
+inline std::shared_ptr<md5::MD5Anim> loadTentacleAnim(bool decode)
+{
+    std::istringstream stream(generateTentacleAnim());
+
+    std::shared_ptr<md5::MD5Anim> anim = std::make_shared<md5::MD5Anim>();
+    anim->parseFromStream(stream);
+
+    if (decode)
+    {
+        anim->decodeFrames();
+    }
+
+    return anim;
+}
+
+struct PoseCacheFixture
+{
+    std::size_t oldCapacity;
+
+    PoseCacheFixture() :
+        oldCapacity(md5::MD5PoseCache::Instance().getCapacity())
+    {
+        md5::MD5PoseCache::Instance().clear();
+    }
+
+    ~PoseCacheFixture()
+    {
+        md5::MD5PoseCache::Instance().setCapacity(oldCapacity);
+        md5::MD5PoseCache::Instance().clear();
+    }
+};
+
+}
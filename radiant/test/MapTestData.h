@@ -0,0 +1,340 @@
+#pragma once
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ibrush.h"
+#include "ipatch.h"
+#include "ithread.h"
+#include "math/Plane3.h"
+#include "parser/DefTokeniser.h"
+#include "radiant/map/format/Doom3MapWriter.h"
+#include "radiant/map/format/ParallelMapTokeniser.h"
+#include "radiant/map/format/ParallelMapWriter.h"
+#include "radiant/map/format/primitivewriters/DoubleWriter.h"
+
+// Map texts, writers and tokenising helpers shared by the map tests and benchmarks
+namespace maptest
+{
+
+// Generate a Doom 3 map text with the given number of entities, each
+// carrying a few brushes and patches
+inline std::string generateMap(std::size_t numEntities)
+{
+    std::ostringstream str;
+
+    str << "Version 2" << std::endl;
+
+    for (std::size_t e = 0; e < numEntities; ++e)
+    {
+        str << "// entity " << e << std::endl;
+        str << "{" << std::endl;
+        str << "\"classname\" \"" << (e == 0 ? "worldspawn" : "func_static") << "\"" << std::endl;
+        str << "\"name\" \"entity_" << e << "\"" << std::endl;
+
+        // Braces, comment markers and escaped quotes inside strings
+        str << "\"inv_name\" \"Some {braced} /* text */ with \\\"quotes\\\"\"" << std::endl;
+
+        for (std::size_t p = 0; p < 4; ++p)
+        {
+            str << "// primitive " << p << std::endl;
+            str << "{" << std::endl << "brushDef3" << std::endl << "{" << std::endl;
+
+            // The faces of a cuboid, every brush is placed differently
+            static const char* const normals[6] = { "1 0 0", "-1 0 0", "0 1 0", "0 -1 0", "0 0 1", "0 0 -1" };
+
+            for (std::size_t f = 0; f < 6; ++f)
+            {
+                str << "( " << normals[f] << " -" << (e * 64 + p * 8 + f + 4) << " ) "
+                    << "( ( 0.015625 0 " << f << ".9375 ) ( 0 0.015625 " << p << " ) ) "
+                    << "\"textures/darkmod/stone/brick/blocks_" << (e + f) % 3 << "\" " << p % 2 << " 0 0" << std::endl;
+            }
+
+            str << "}" << std::endl << "}" << std::endl;
+        }
+
+        str << "/* a patch { with braces } in a comment */" << std::endl;
+        str << "{" << std::endl << "patchDef2" << std::endl << "{" << std::endl;
+        str << "\"textures/common/caulk\"" << std::endl << "( 3 3 0 0 0 )" << std::endl << "(" << std::endl;
+
+        for (std::size_t r = 0; r < 3; ++r)
+        {
+            str << "( ( 0 " << e << " " << r << " 0 0 ) ( 1 " << e << " " << r << " 0.5 0 ) ( 2 " << e << " " << r << " 1 0." << r << " ) )" << std::endl;
+        }
+
+        str << ")" << std::endl << "}" << std::endl << "}" << std::endl;
+        str << "}" << std::endl;
+    }
+
+    return str.str();
+}
+
+inline std::vector<std::string> tokeniseSerially(const std::string& mapText)
+{
+    std::vector<std::string> tokens;
+
+    std::istringstream stream(mapText);
+    parser::BasicDefTokeniser<std::istream> tok(stream);
+
+    while (tok.hasMoreTokens())
+    {
+        tokens.push_back(tok.nextToken());
+    }
+
+    return tokens;
+}
+
+inline std::vector<std::string> tokeniseInParallel(const std::string& mapText, TaskScheduler& scheduler,
+                                                   std::size_t& numEntities)
+{
+    std::vector<std::string> tokens;
+    numEntities = 0;
+
+    std::istringstream stream(mapText);
+    map::ParallelMapTokeniser blocks(stream, scheduler);
+
+    auto& header = blocks.getHeaderTokeniser();
+
+    while (header.hasMoreTokens())
+    {
+        tokens.push_back(header.nextToken());
+    }
+
+    while (blocks.hasMoreBlocks())
+    {
+        auto& tok = blocks.nextBlock();
+
+        // Well-formed blocks start with the entity's opening brace
+        if (tok.hasMoreTokens() && tok.peek() == "{")
+        {
+            ++numEntities;
+        }
+
+        while (tok.hasMoreTokens())
+        {
+            tokens.push_back(tok.nextToken());
+        }
+    }
+
+    return tokens;
+}
+
+// Brush node carrying a few planes, which are written by the TestMapWriter
+class TestBrushNode :
+    public IBrushNode
+{
+public:
+    std::vector<Plane3> planes;
+
+    Brush& getBrush() override
+    {
+        throw std::logic_error("not implemented");
+    }
+
+    IBrush& getIBrush() override
+    {
+        throw std::logic_error("not implemented");
+    }
+};
+
+// Writer producing Doom 3 style brush blocks from the TestBrushNodes, the key
+// values of the entities are generated from their number. It's using the
+// counters of the Doom3MapWriter, which are passed on to the part writers.
+class TestMapWriter :
+    public map::Doom3MapWriter
+{
+public:
+    void beginWriteEntity(const IEntityNodePtr& entity, std::ostream& stream) override
+    {
+        std::size_t number = _entityCount++;
+
+        stream << "// entity " << number << "\n";
+        stream << "{\n";
+        stream << "\"classname\" \"" << (number == 0 ? "worldspawn" : "func_static") << "\"\n";
+        stream << "\"name\" \"entity_" << number << "\"\n";
+        stream << "\"origin\" \"";
+        map::writeDoubleSafe(number * 0.125, stream);
+        stream << " 0 -";
+        map::writeDoubleSafe(number * 64.0, stream);
+        stream << "\"\n";
+    }
+
+    void beginWriteBrush(const IBrushNodePtr& brush, std::ostream& stream) override
+    {
+        stream << "// primitive " << _primitiveCount++ << "\n";
+        stream << "{\n" << "brushDef3\n" << "{\n";
+
+        for (const Plane3& plane : std::static_pointer_cast<TestBrushNode>(brush)->planes)
+        {
+            stream << "( ";
+            map::writeDoubleSafe(plane.normal().x(), stream);
+            stream << " ";
+            map::writeDoubleSafe(plane.normal().y(), stream);
+            stream << " ";
+            map::writeDoubleSafe(plane.normal().z(), stream);
+            stream << " ";
+            map::writeDoubleSafe(-plane.dist(), stream);
+            stream << " ) ( ( 0.0078125 0 0 ) ( 0 0.0078125 0 ) ) \"textures/common/caulk\" 0 0 0\n";
+        }
+
+        stream << "}\n}\n";
+    }
+
+    void beginWritePatch(const IPatchNodePtr& patch, std::ostream& stream) override
+    {
+        stream << "// primitive " << _primitiveCount++ << "\n";
+        stream << "{\n" << "patchDef2\n" << "{\n" << "\"textures/common/caulk\"\n" << "}\n}\n";
+    }
+
+    map::IMapWriterPtr createPartWriter(std::size_t entityCount, std::size_t primitiveCount) override
+    {
+        return createPartWriterOfType<TestMapWriter>(entityCount, primitiveCount);
+    }
+};
+
+// A writer which can't be split into parts
+class SerialTestMapWriter :
+    public TestMapWriter
+{
+public:
+    map::IMapWriterPtr createPartWriter(std::size_t entityCount, std::size_t primitiveCount) override
+    {
+        return map::IMapWriterPtr();
+    }
+};
+
+// The calls of a map export, entities are represented by empty pointers
+struct TestMap
+{
+    struct Entity
+    {
+        std::vector<IBrushNodePtr> brushes;
+        std::size_t numPatches;
+    };
+
+    std::vector<Entity> entities;
+};
+
+inline TestMap generateTestMap(std::size_t numEntities, std::size_t worldspawnBrushes)
+{
+    TestMap map;
+    std::mt19937 rng(4711);
+    std::uniform_real_distribution<double> angle(0, 2 * 3.14159265358979);
+
+    for (std::size_t e = 0; e < numEntities; ++e)
+    {
+        TestMap::Entity entity;
+        std::size_t numBrushes = e == 0 ? worldspawnBrushes : 1 + rng() % 8;
+
+        for (std::size_t b = 0; b < numBrushes; ++b)
+        {
+            auto brush = std::make_shared<TestBrushNode>();
+
+            // Axis-aligned brushes with integer coordinates and some rotated ones
+            for (std::size_t axis = 0; axis < 6; ++axis)
+            {
+                Vector3 normal(0, 0, 0);
+
+                if (b % 3 == 0)
+                {
+                    double a = angle(rng);
+                    normal = Vector3(cos(a), sin(a), axis % 2 == 0 ? 0.5 : -0.25).getNormalised();
+                }
+                else
+                {
+                    normal[axis / 2] = axis % 2 == 0 ? 1 : -1;
+                }
+
+                brush->planes.push_back(Plane3(normal, double(int(rng() % 8192)) - 4096 + (b % 5 == 0 ? 0.5 : 0)));
+            }
+
+            entity.brushes.push_back(brush);
+        }
+
+        entity.numPatches = rng() % 3;
+        map.entities.push_back(entity);
+    }
+
+    return map;
+}
+
+// Issues the export calls to the given writer, like the MapExporter traversal did
+template<typename WriterType>
+void writeMap(const TestMap& map, WriterType& writer, std::ostream& stream)
+{
+    for (const TestMap::Entity& entity : map.entities)
+    {
+        writer.beginWriteEntity(IEntityNodePtr(), stream);
+
+        for (const IBrushNodePtr& brush : entity.brushes)
+        {
+            writer.beginWriteBrush(brush, stream);
+            writer.endWriteBrush(brush, stream);
+        }
+
+        for (std::size_t p = 0; p < entity.numPatches; ++p)
+        {
+            writer.beginWritePatch(IPatchNodePtr(), stream);
+            writer.endWritePatch(IPatchNodePtr(), stream);
+        }
+
+        writer.endWriteEntity(IEntityNodePtr(), stream);
+    }
+}
+
+// Adapts the ParallelMapWriter to the calls of writeMap()
+struct QueueingWriter
+{
+    map::ParallelMapWriter& writer;
+
+    void beginWriteEntity(const IEntityNodePtr& entity, std::ostream&) { writer.beginWriteEntity(entity); }
+    void endWriteEntity(const IEntityNodePtr& entity, std::ostream&) { writer.endWriteEntity(entity); }
+    void beginWriteBrush(const IBrushNodePtr& brush, std::ostream&) { writer.beginWriteBrush(brush); }
+    void endWriteBrush(const IBrushNodePtr& brush, std::ostream&) { writer.endWriteBrush(brush); }
+    void beginWritePatch(const IPatchNodePtr& patch, std::ostream&) { writer.beginWritePatch(patch); }
+    void endWritePatch(const IPatchNodePtr& patch, std::ostream&) { writer.endWritePatch(patch); }
+};
+
+inline std::string writeDirectly(const TestMap& map, TestMapWriter& writer)
+{
+    std::ostringstream stream;
+    stream.precision(16);
+
+    writer.beginWriteMap(scene::IMapRootNodePtr(), stream);
+    writeMap(map, writer, stream);
+    writer.endWriteMap(scene::IMapRootNodePtr(), stream);
+
+    return stream.str();
+}
+
+inline std::size_t writeInParallel(const TestMap& map, TestMapWriter& writer, TaskScheduler* scheduler,
+                                   std::ostream& stream)
+{
+    std::size_t numNodes = 0;
+
+    writer.beginWriteMap(scene::IMapRootNodePtr(), stream);
+
+    map::ParallelMapWriter parallelWriter(writer, stream, scheduler);
+    QueueingWriter queue{ parallelWriter };
+
+    writeMap(map, queue, stream);
+    parallelWriter.flush([&](std::size_t count) { numNodes += count; });
+
+    writer.endWriteMap(scene::IMapRootNodePtr(), stream);
+
+    return numNodes;
+}
+
+inline std::string writeInParallel(const TestMap& map, TestMapWriter& writer, TaskScheduler* scheduler)
+{
+    std::ostringstream stream;
+    stream.precision(16);
+
+    writeInParallel(map, writer, scheduler, stream);
+
+    return stream.str();
+}
+
+}
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <map>
+#include <stdexcept>
+
+#include "imodule.h"
+#include "iregistry.h"
+#include "irender.h"
+#include "iscenegraph.h"
+#include "iuimanager.h"
+#include "iundo.h"
+#include "mapfile.h"
+
+#include "radiant/undo/Stack.h"
+#include "radiant/undo/StackFiller.h"
+
+// Minimal module implementations for tests, to be registered in a
+// MockModuleRegistry for the code under test to find them through the
+// usual Global*() accessors.
+
+class MockSceneGraph :
+    public scene::Graph,
+    public RegisterableModule
+{
+    scene::IMapRootNodePtr _root;
+
+public:
+    const std::string& getName() const override
+    {
+        static std::string name(MODULE_SCENEGRAPH);
+        return name;
+    }
+
+    const StringSet& getDependencies() const override
+    {
+        static StringSet dependencies;
+        return dependencies;
+    }
+
+    void initialiseModule(const ApplicationContext& ctx) override {}
+
+    const scene::IMapRootNodePtr& root() const override { return _root; }
+    void setRoot(const scene::IMapRootNodePtr& newRoot) override {}
+    void insert(const scene::INodePtr& node) override {}
+    void erase(const scene::INodePtr& node) override {}
+    void sceneChanged() override {}
+    void addSceneObserver(Observer* observer) override {}
+    void removeSceneObserver(Observer* observer) override {}
+    sigc::signal<void> signal_boundsChanged() const override { return sigc::signal<void>(); }
+    void boundsChanged() override {}
+    void nodeBoundsChanged(const scene::INodePtr& node) override {}
+    void foreachNodeInVolume(const VolumeTest& volume, Walker& walker) override {}
+    void foreachVisibleNodeInVolume(const VolumeTest& volume, Walker& walker) override {}
+    void foreachNode(const scene::INode::VisitorFunc& functor) override {}
+    void foreachVisibleNode(const scene::INode::VisitorFunc& functor) override {}
+    void foreachNodeInVolume(const VolumeTest& volume, const scene::INode::VisitorFunc& functor) override {}
+    void foreachVisibleNodeInVolume(const VolumeTest& volume, const scene::INode::VisitorFunc& functor) override {}
+    void foreachVisibleNodeFrontToBack(const VolumeTest& volume, Walker& walker,
+        const std::function<bool(double)>& continueAtDepth) override {}
+    scene::ISpacePartitionSystemPtr getSpacePartition() override { return scene::ISpacePartitionSystemPtr(); }
+};
+
+class MockRegistry :
+    public Registry
+{
+public:
+    const std::string& getName() const override
+    {
+        static std::string name(MODULE_XMLREGISTRY);
+        return name;
+    }
+
+    const StringSet& getDependencies() const override
+    {
+        static StringSet dependencies;
+        return dependencies;
+    }
+
+    void initialiseModule(const ApplicationContext& ctx) override {}
+
+    void set(const std::string& key, const std::string& value) override {}
+
+    std::string get(const std::string& key) override
+    {
+        return key == "user/ui/textures/defaultTextureScale" ? "0.5" : "";
+    }
+
+    bool keyExists(const std::string& key) override
+    {
+        return !get(key).empty();
+    }
+
+    void import(const std::string& importFilePath, const std::string& parentKey, Tree tree) override {}
+    void dump() const override {}
+    void saveToDisk() override {}
+    void exportToFile(const std::string& key, const std::string& filename) override {}
+    xml::NodeList findXPath(const std::string& path) override { return xml::NodeList(); }
+    xml::Node createKey(const std::string& key) override { throw std::logic_error("not implemented"); }
+    xml::Node createKeyWithName(const std::string& path, const std::string& key,
+                                const std::string& name) override { throw std::logic_error("not implemented"); }
+    void setAttribute(const std::string& path, const std::string& attrName,
+                      const std::string& attrValue) override {}
+    std::string getAttribute(const std::string& path, const std::string& attrName) override { return ""; }
+    void deleteXPath(const std::string& path) override {}
+    sigc::signal<void> signalForKey(const std::string& key) const override { return sigc::signal<void>(); }
+};
+
+class MockLightList :
+    public LightList
+{
+public:
+    void calculateIntersectingLights() const override {}
+    void setDirty() override {}
+    void forEachLight(const RendererLightCallback& callback) const override {}
+};
+
+class MockRenderSystem :
+    public RenderSystem
+{
+    MockLightList _lightList;
+
+public:
+    const std::string& getName() const override
+    {
+        static std::string name(MODULE_RENDERSYSTEM);
+        return name;
+    }
+
+    const StringSet& getDependencies() const override
+    {
+        static StringSet dependencies;
+        return dependencies;
+    }
+
+    void initialiseModule(const ApplicationContext& ctx) override {}
+
+    ShaderPtr capture(const std::string& name) override { return ShaderPtr(); }
+    void render(RenderStateFlags globalFlagsMask, const Matrix4& modelview,
+                const Matrix4& projection, const Vector3& viewer) override {}
+    void realise() override {}
+    void unrealise() override {}
+    std::size_t getTime() const override { return 0; }
+    void setTime(std::size_t milliSeconds) override {}
+    ShaderProgram getCurrentShaderProgram() const override { return SHADER_PROGRAM_NONE; }
+    void setShaderProgram(ShaderProgram prog) override {}
+    LightList& attachLitObject(LitObject& object) override { return _lightList; }
+    void detachLitObject(LitObject& cullable) override {}
+    void litObjectChanged(LitObject& cullable) override {}
+    void attachLight(RendererLight& light) override {}
+    void detachLight(RendererLight& light) override {}
+    void lightChanged(RendererLight& light) override {}
+    void attachRenderable(const Renderable& renderable) override {}
+    void detachRenderable(const Renderable& renderable) override {}
+    void forEachRenderable(const RenderableCallback& callback) const override {}
+    void extensionsInitialised() override {}
+    sigc::signal<void> signal_extensionsInitialised() override { return sigc::signal<void>(); }
+};
+
+class MockUIManager :
+    public IUIManager,
+    public IColourSchemeManager
+{
+public:
+    const std::string& getName() const override
+    {
+        static std::string name(MODULE_UIMANAGER);
+        return name;
+    }
+
+    const StringSet& getDependencies() const override
+    {
+        static StringSet dependencies;
+        return dependencies;
+    }
+
+    void initialiseModule(const ApplicationContext& ctx) override {}
+
+    Vector3 getColour(const std::string& colourName) override { return Vector3(0, 0, 0); }
+
+    IColourSchemeManager& getColourSchemeManager() override { return *this; }
+
+    IMenuManager& getMenuManager() override { throw std::logic_error("not implemented"); }
+    IToolbarManager& getToolbarManager() override { throw std::logic_error("not implemented"); }
+    IGroupDialog& getGroupDialog() override { throw std::logic_error("not implemented"); }
+    IStatusBarManager& getStatusBarManager() override { throw std::logic_error("not implemented"); }
+    ui::IDialogManager& getDialogManager() override { throw std::logic_error("not implemented"); }
+    const std::string& ArtIdPrefix() const override { throw std::logic_error("not implemented"); }
+    ui::IFilterMenuPtr createFilterMenu() override { throw std::logic_error("not implemented"); }
+};
+
+class MockMapFileChangeTracker :
+    public IMapFileChangeTracker
+{
+    std::size_t _changes = 0;
+
+public:
+    void save() override { _changes = 0; }
+    bool saved() const override { return _changes == 0; }
+    void changed() override { ++_changes; }
+    void setChangedCallback(const std::function<void()>& changed) override {}
+    std::size_t changes() const override { return _changes; }
+};
+
+// Records the operations on an UndoStack like the UndoSystem does, without
+// the commands, preferences and map events the UndoSystem module is wired to
+class MockUndoSystem :
+    public IUndoSystem
+{
+    undo::UndoStack _undoStack;
+    std::map<IUndoable*, undo::UndoStackFiller> _undoables;
+    bool _operationStarted = false;
+
+    sigc::signal<void> _signalPostUndo;
+    sigc::signal<void> _signalPostRedo;
+
+    void setActiveUndoStack(undo::UndoStack* stack)
+    {
+        for (auto& pair : _undoables)
+        {
+            pair.second.setStack(stack);
+        }
+    }
+
+public:
+    const std::string& getName() const override
+    {
+        static std::string name(MODULE_UNDOSYSTEM);
+        return name;
+    }
+
+    const StringSet& getDependencies() const override
+    {
+        static StringSet dependencies;
+        return dependencies;
+    }
+
+    void initialiseModule(const ApplicationContext& ctx) override {}
+
+    IUndoStateSaver* getStateSaver(IUndoable& undoable, IMapFileChangeTracker& tracker) override
+    {
+        auto result = _undoables.insert(std::make_pair(&undoable, undo::UndoStackFiller(tracker)));
+
+        if (_operationStarted)
+        {
+            result.first->second.setStack(&_undoStack);
+        }
+
+        return &(result.first->second);
+    }
+
+    void releaseStateSaver(IUndoable& undoable) override
+    {
+        _undoables.erase(&undoable);
+    }
+
+    std::size_t size() const override
+    {
+        return _undoStack.size();
+    }
+
+    // The name of the most recent operation
+    const std::string& getLastOperationName() const
+    {
+        return _undoStack.back()->getName();
+    }
+
+    void start() override
+    {
+        _undoStack.start("unnamedCommand");
+        _operationStarted = true;
+        setActiveUndoStack(&_undoStack);
+    }
+
+    bool operationStarted() const override
+    {
+        return _operationStarted;
+    }
+
+    void finish(const std::string& command) override
+    {
+        _undoStack.finish(command);
+        _operationStarted = false;
+        setActiveUndoStack(nullptr);
+    }
+
+    void undo() override
+    {
+        if (_undoStack.empty()) return;
+
+        _undoStack.back()->restoreSnapshot();
+        _undoStack.pop_back();
+        _signalPostUndo.emit();
+    }
+
+    void redo() override {}
+
+    void clear() override
+    {
+        setActiveUndoStack(nullptr);
+        _undoStack.clear();
+        _operationStarted = false;
+    }
+
+    sigc::signal<void>& signal_postUndo() override { return _signalPostUndo; }
+    sigc::signal<void>& signal_postRedo() override { return _signalPostRedo; }
+
+    void cancel() override
+    {
+        bool filled = _undoStack.finish("$TEMPORARY");
+        _operationStarted = false;
+        setActiveUndoStack(nullptr);
+
+        if (filled)
+        {
+            _undoStack.pop_back();
+        }
+    }
+
+    void attachTracker(Tracker& tracker) override {}
+    void detachTracker(Tracker& tracker) override {}
+};
+
+class MockModuleRegistry :
+    public IModuleRegistry
+{
+    std::map<std::string, RegisterableModulePtr> _modules;
+
+public:
+    void registerModule(const RegisterableModulePtr& module) override
+    {
+        _modules[module->getName()] = module;
+    }
+
+    void loadAndInitialiseModules() override {}
+    void shutdownModules() override {}
+
+    RegisterableModulePtr getModule(const std::string& name) const override
+    {
+        auto found = _modules.find(name);
+        return found != _modules.end() ? found->second : RegisterableModulePtr();
+    }
+
+    bool moduleExists(const std::string& name) const override
+    {
+        return _modules.count(name) > 0;
+    }
+
+    const ApplicationContext& getApplicationContext() const override
+    {
+        throw std::logic_error("not implemented");
+    }
+
+    sigc::signal<void> signal_allModulesInitialised() const override
+    {
+        return sigc::signal<void>();
+    }
+
+    ProgressSignal signal_moduleInitialisationProgress() const override
+    {
+        return ProgressSignal();
+    }
+
+    sigc::signal<void> signal_allModulesUninitialised() const override
+    {
+        return sigc::signal<void>();
+    }
+
+    std::size_t getCompatibilityLevel() const override
+    {
+        return MODULE_COMPATIBILITY_LEVEL;
+    }
+};
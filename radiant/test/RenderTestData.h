@@ -0,0 +1,308 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "math/Matrix4.h"
+#include "render/PolygonBatch.h"
+#include "radiant/render/LightInteractions.h"
+
+// Buffers, geometry and light scenes shared by the render tests and benchmarks
+namespace rendertest
+{
+
+// CPU-side stand-in for the IndexedVertexBuffer
+class TestBuffer
+{
+public:
+    std::vector<render::BatchVertex> vertices;
+    std::vector<RenderIndex> indices;
+    std::vector<std::size_t> batchSizes;
+
+    // Number of vertices written since the last reset
+    std::size_t verticesWritten = 0;
+
+    std::size_t allocateVertices(std::size_t count)
+    {
+        std::size_t first = vertices.size();
+        vertices.resize(first + count);
+        return first;
+    }
+
+    render::BatchVertex* getModifiableVertices(std::size_t first, std::size_t count)
+    {
+        BOOST_TEST_REQUIRE(first + count <= vertices.size());
+        verticesWritten += count;
+        return &vertices[first];
+    }
+
+    std::size_t getNumVertices() const
+    {
+        return vertices.size();
+    }
+
+    void clearVertices()
+    {
+        vertices.clear();
+    }
+
+    template<typename Iter_T>
+    void addIndexBatch(Iter_T begin, std::size_t count)
+    {
+        indices.insert(indices.end(), begin, begin + count);
+        batchSizes.push_back(count);
+    }
+
+    std::size_t getNumBatches() const
+    {
+        return batchSizes.size();
+    }
+
+    void clearBatches()
+    {
+        indices.clear();
+        batchSizes.clear();
+    }
+};
+
+typedef render::PolygonBatch<TestBuffer> TestBatch;
+
+// A regular polygon around the given centre
+class TestPolygon :
+    public render::IBatchablePolygon
+{
+public:
+    std::size_t revision;
+    Vector3 centre;
+    std::size_t numVertices;
+
+    TestPolygon(std::size_t revision_, const Vector3& centre_, std::size_t numVertices_) :
+        revision(revision_),
+        centre(centre_),
+        numVertices(numVertices_)
+    {}
+
+    std::size_t getBatchRevision() const override
+    {
+        return revision;
+    }
+
+    std::size_t getNumBatchVertices() const override
+    {
+        return numVertices;
+    }
+
+    void writeBatchVertices(render::BatchVertex* vertices) const override
+    {
+        for (std::size_t i = 0; i < numVertices; ++i)
+        {
+            double angle = 2 * c_pi * i / numVertices;
+
+            vertices[i].vertex = Vector3f(
+                static_cast<float>(centre.x() + cos(angle)),
+                static_cast<float>(centre.y() + sin(angle)),
+                static_cast<float>(centre.z()));
+            vertices[i].texcoord = BasicVector2<float>(static_cast<float>(i), 0);
+            vertices[i].normal = Vector3f(0, 0, 1);
+        }
+    }
+};
+
+inline std::vector<TestPolygon> createPolygons(std::size_t count)
+{
+    std::vector<TestPolygon> polygons;
+    polygons.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        polygons.emplace_back(i + 1, Vector3(double(i % 100), double(i / 100), 0), 4 + i % 3);
+    }
+
+    return polygons;
+}
+
+// Batches are keyed by the polygon's address, so pass them by pointer
+inline std::vector<const TestPolygon*> getRange(const std::vector<TestPolygon>& polygons,
+                                                       std::size_t first, std::size_t last)
+{
+    std::vector<const TestPolygon*> result;
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        result.push_back(&polygons[i]);
+    }
+
+    return result;
+}
+
+inline void draw(TestBatch& batch, const std::vector<const TestPolygon*>& polygons)
+{
+    batch.begin();
+
+    for (const TestPolygon* polygon : polygons)
+    {
+        batch.addPolygon(*polygon);
+    }
+
+    batch.endBatch();
+}
+
+inline void drawAll(TestBatch& batch, const std::vector<TestPolygon>& polygons)
+{
+    draw(batch, getRange(polygons, 0, polygons.size()));
+}
+
+// A point light with a box-shaped volume
+class TestLight :
+    public RendererLight
+{
+private:
+    AABB _bounds;
+    ShaderPtr _shader;
+
+public:
+    TestLight(const AABB& bounds) :
+        _bounds(bounds)
+    {}
+
+    void setBounds(const AABB& bounds)
+    {
+        _bounds = bounds;
+    }
+
+    float getShaderParm(int parmNum) const override { return 0; }
+    const Vector3& getDirection() const override { return _bounds.origin; }
+    const ShaderPtr& getWireShader() const override { return _shader; }
+    const ShaderPtr& getShader() const override { return _shader; }
+    const Vector3& worldOrigin() const override { return _bounds.origin; }
+    Matrix4 getLightTextureTransformation() const override { return Matrix4::getIdentity(); }
+    Vector3 getLightOrigin() const override { return _bounds.origin; }
+
+    bool intersectsAABB(const AABB& aabb) const override
+    {
+        return _bounds.intersects(aabb);
+    }
+
+    AABB getLightAABB() const override
+    {
+        return _bounds;
+    }
+};
+
+class TestObject :
+    public LitObject
+{
+private:
+    AABB _bounds;
+
+public:
+    std::set<const RendererLight*> lights;
+    std::size_t numCalculations = 0;
+
+    TestObject(const AABB& bounds) :
+        _bounds(bounds)
+    {}
+
+    bool intersectsLight(const RendererLight& light) const override
+    {
+        return light.intersectsAABB(_bounds);
+    }
+
+    const AABB& getLitObjectAABB() const override
+    {
+        return _bounds;
+    }
+
+    void insertLight(const RendererLight& light) override
+    {
+        lights.insert(&light);
+    }
+
+    void clearLights() override
+    {
+        lights.clear();
+        numCalculations++;
+    }
+};
+
+inline AABB randomBox(std::mt19937& random, double mapSize, double maxExtent)
+{
+    std::uniform_real_distribution<double> position(-mapSize, mapSize);
+    std::uniform_real_distribution<double> extent(1, maxExtent);
+
+    return AABB(Vector3(position(random), position(random), position(random)),
+        Vector3(extent(random), extent(random), extent(random)));
+}
+
+// A scene with lights and objects scattered over a map of the given size
+struct Scene
+{
+    std::vector<std::unique_ptr<TestLight>> lights;
+    std::vector<std::unique_ptr<TestObject>> objects;
+    std::vector<LightList*> lists;
+
+    render::LightInteractions interactions;
+
+    Scene(std::size_t numLights, std::size_t numObjects, double mapSize)
+    {
+        std::mt19937 random(42);
+
+        for (std::size_t i = 0; i < numLights; ++i)
+        {
+            lights.emplace_back(new TestLight(randomBox(random, mapSize, 400)));
+            interactions.attachLight(*lights.back());
+        }
+
+        for (std::size_t i = 0; i < numObjects; ++i)
+        {
+            objects.emplace_back(new TestObject(randomBox(random, mapSize, 128)));
+            lists.push_back(&interactions.attachLitObject(*objects.back()));
+        }
+    }
+
+    void calculateAll()
+    {
+        for (LightList* list : lists)
+        {
+            list->calculateIntersectingLights();
+        }
+    }
+
+    std::size_t countCalculations()
+    {
+        std::size_t count = 0;
+
+        for (const auto& object : objects)
+        {
+            count += object->numCalculations;
+            object->numCalculations = 0;
+        }
+
+        return count;
+    }
+
+    // Compare the light lists against testing all light/object pairs
+    void checkLights()
+    {
+        for (std::size_t i = 0; i < objects.size(); ++i)
+        {
+            std::set<const RendererLight*> expected;
+
+            for (const auto& light : lights)
+            {
+                if (objects[i]->intersectsLight(*light))
+                {
+                    expected.insert(light.get());
+                }
+            }
+
+            BOOST_TEST_REQUIRE((objects[i]->lights == expected), "Object " << i);
+        }
+    }
+};
+
+}
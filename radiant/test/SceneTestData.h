@@ -0,0 +1,455 @@
+#pragma once
+
+#include <random>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "radiant/scenegraph/Octree.h"
+#include "radiant/scenegraph/OctreeNode.h"
+#include "radiant/scenegraph/DepthSortedTraversal.h"
+#include "radiant/selection/SelectionTest.h"
+#include "radiant/selection/SelectionPool.h"
+#include "math/AABB.h"
+#include "math/Matrix4.h"
+
+// Scene nodes, brush layouts and camera clicks shared by the scene tests and benchmarks
+namespace scenetest
+{
+
+// Minimal scene node, only providing its world bounds
+class TestNode :
+    public scene::INode
+{
+private:
+    AABB _bounds;
+    Matrix4 _localToWorld;
+    scene::LayerList _layers;
+
+public:
+    TestNode(const AABB& bounds) :
+        _bounds(bounds),
+        _localToWorld(Matrix4::getIdentity())
+    {}
+
+    void setBounds(const AABB& bounds)
+    {
+        _bounds = bounds;
+    }
+
+    const AABB& worldAABB() const override { return _bounds; }
+    const AABB& localAABB() const override { return _bounds; }
+    const Matrix4& localToWorld() const override { return _localToWorld; }
+
+    std::string name() const override { return "TestNode"; }
+    Type getNodeType() const override { return Type::Brush; }
+    void setSceneGraph(const scene::GraphPtr&) override {}
+    bool isRoot() const override { return false; }
+    void setIsRoot(bool) override {}
+    scene::IMapRootNodePtr getRootNode() override { return scene::IMapRootNodePtr(); }
+    void enable(unsigned int) override {}
+    void disable(unsigned int) override {}
+    bool checkStateFlag(unsigned int) const override { return false; }
+    bool visible() const override { return true; }
+    bool excluded() const override { return false; }
+    void setForcedVisibility(bool, bool) override {}
+    void addChildNode(const scene::INodePtr&) override {}
+    void addChildNodeToFront(const scene::INodePtr&) override {}
+    void removeChildNode(const scene::INodePtr&) override {}
+    bool hasChildNodes() const override { return false; }
+    void traverse(scene::NodeVisitor&) override {}
+    void traverseChildren(scene::NodeVisitor&) const override {}
+    bool foreachNode(const VisitorFunc&) const override { return true; }
+    scene::INodePtr getSelf() override { return scene::INodePtr(); }
+    void setParent(const scene::INodePtr&) override {}
+    scene::INodePtr getParent() const override { return scene::INodePtr(); }
+    void onInsertIntoScene(scene::IMapRootNode&) override {}
+    void onRemoveFromScene(scene::IMapRootNode&) override {}
+    bool inScene() const override { return true; }
+    IRenderEntity* getRenderEntity() const override { return nullptr; }
+    void setRenderEntity(IRenderEntity*) override {}
+    void boundsChanged() override {}
+    void transformChanged() override {}
+    void transformChangedLocal() override {}
+
+    bool isFiltered() const override { return false; }
+    void setFiltered(bool) override {}
+
+    void addToLayer(int) override {}
+    void moveToLayer(int) override {}
+    void removeFromLayer(int) override {}
+    const scene::LayerList& getLayers() const override { return _layers; }
+    void assignToLayers(const scene::LayerList&) override {}
+
+    void setRenderSystem(const RenderSystemPtr&) override {}
+    void renderSolid(RenderableCollector&, const VolumeTest&) const override {}
+    void renderWireframe(RenderableCollector&, const VolumeTest&) const override {}
+    std::size_t getHighlightFlags() override { return Highlight::NoHighlight; }
+};
+typedef std::shared_ptr<TestNode> TestNodePtr;
+
+/**
+ * A brush layout resembling a regular map: a grid of rooms with walls,
+ * floor and ceiling, plus some detail brushes in each room.
+ */
+inline std::vector<TestNodePtr> generateMapBrushes(std::size_t roomsPerAxis)
+{
+    std::vector<TestNodePtr> brushes;
+    std::mt19937 rng(1701);
+
+    const double roomSize = 512;
+
+    for (std::size_t x = 0; x < roomsPerAxis; ++x)
+    {
+        for (std::size_t y = 0; y < roomsPerAxis; ++y)
+        {
+            Vector3 centre(x * roomSize - 8192, y * roomSize - 8192, 128);
+
+            // Floor, ceiling and four walls
+            brushes.push_back(std::make_shared<TestNode>(AABB(centre - Vector3(0, 0, 136), Vector3(256, 256, 8))));
+            brushes.push_back(std::make_shared<TestNode>(AABB(centre + Vector3(0, 0, 136), Vector3(256, 256, 8))));
+            brushes.push_back(std::make_shared<TestNode>(AABB(centre + Vector3(248, 0, 0), Vector3(8, 256, 128))));
+            brushes.push_back(std::make_shared<TestNode>(AABB(centre - Vector3(248, 0, 0), Vector3(8, 256, 128))));
+            brushes.push_back(std::make_shared<TestNode>(AABB(centre + Vector3(0, 248, 0), Vector3(256, 8, 128))));
+            brushes.push_back(std::make_shared<TestNode>(AABB(centre - Vector3(0, 248, 0), Vector3(256, 8, 128))));
+
+            // Detail brushes (furniture, trims)
+            for (int d = 0; d < 10; ++d)
+            {
+                Vector3 offset(int(rng() % 400) - 200, int(rng() % 400) - 200, int(rng() % 200) - 100);
+                Vector3 extents(2 + rng() % 24, 2 + rng() % 24, 2 + rng() % 16);
+
+                brushes.push_back(std::make_shared<TestNode>(AABB(centre + offset, extents)));
+            }
+        }
+    }
+
+    return brushes;
+}
+
+inline void countMembers(const scene::ISPNode& node, std::size_t& count)
+{
+    for (const scene::INodePtr& member : node.getMembers())
+    {
+        // Each member must be fully contained in its octant (the root takes all the others)
+        if (node.getParent())
+        {
+            BOOST_TEST_REQUIRE(node.getBounds().contains(member->worldAABB()));
+        }
+
+        ++count;
+    }
+
+    for (const scene::ISPNodePtr& child : node.getChildNodes())
+    {
+        BOOST_TEST_REQUIRE(child->getParent().get() == &node);
+        countMembers(*child, count);
+    }
+}
+
+inline std::size_t countMembers(const scene::Octree& octree)
+{
+    std::size_t count = 0;
+    countMembers(*octree.getRoot(), count);
+    return count;
+}
+
+inline void translate(TestNode& node, const Vector3& delta)
+{
+    node.setBounds(AABB(node.worldAABB().origin + delta, node.worldAABB().extents));
+}
+
+// Box shaped scene node, selectable through its six faces
+class TestBrush :
+    public scene::INode,
+    public SelectionTestable,
+    public ISelectable
+{
+private:
+    AABB _bounds;
+    Matrix4 _localToWorld;
+    scene::LayerList _layers;
+
+    Vector3 _faces[6][4];
+    AABB _faceBounds[6];
+
+    bool _selected;
+
+public:
+    // Reject the brush and its faces by their bounds, like BrushNode does
+    static inline bool rejectByBounds = false;
+
+    // Number of testSelect() calls
+    static inline std::size_t numTested = 0;
+
+    TestBrush(const AABB& bounds) :
+        _bounds(bounds),
+        _localToWorld(Matrix4::getIdentity()),
+        _selected(false)
+    {
+        Vector3 min = bounds.origin - bounds.extents;
+        Vector3 max = bounds.origin + bounds.extents;
+
+        // Two faces per axis, the four corners of each in winding order
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+
+            for (int side = 0; side < 2; ++side)
+            {
+                Vector3 (&face)[4] = _faces[axis * 2 + side];
+
+                for (int corner = 0; corner < 4; ++corner)
+                {
+                    face[corner][axis] = side == 0 ? min[axis] : max[axis];
+                    face[corner][u] = corner == 1 || corner == 2 ? max[u] : min[u];
+                    face[corner][v] = corner >= 2 ? max[v] : min[v];
+                }
+
+                _faceBounds[axis * 2 + side] = AABB::createFromMinMax(face[0], face[2]);
+            }
+        }
+    }
+
+    void testSelect(Selector& selector, SelectionTest& test) override
+    {
+        ++numTested;
+
+        const VolumeTest& volume = test.getVolume();
+
+        if (rejectByBounds && volume.TestAABB(_bounds) == VOLUME_OUTSIDE)
+        {
+            return;
+        }
+
+        test.BeginMesh(_localToWorld, true);
+
+        SelectionIntersection best;
+
+        for (int i = 0; i < 6; ++i)
+        {
+            if (rejectByBounds && volume.TestAABB(_faceBounds[i], _localToWorld) == VOLUME_OUTSIDE)
+            {
+                continue;
+            }
+
+            test.TestPolygon(VertexPointer(_faces[i], sizeof(Vector3)), 4, best);
+        }
+
+        if (best.isValid())
+        {
+            selector.addIntersection(best);
+        }
+    }
+
+    void setSelected(bool select) override { _selected = select; }
+    bool isSelected() const override { return _selected; }
+
+    const AABB& worldAABB() const override { return _bounds; }
+    const AABB& localAABB() const override { return _bounds; }
+    const Matrix4& localToWorld() const override { return _localToWorld; }
+
+    std::string name() const override { return "TestBrush"; }
+    Type getNodeType() const override { return Type::Brush; }
+    void setSceneGraph(const scene::GraphPtr&) override {}
+    bool isRoot() const override { return false; }
+    void setIsRoot(bool) override {}
+    scene::IMapRootNodePtr getRootNode() override { return scene::IMapRootNodePtr(); }
+    void enable(unsigned int) override {}
+    void disable(unsigned int) override {}
+    bool checkStateFlag(unsigned int) const override { return false; }
+    bool visible() const override { return true; }
+    bool excluded() const override { return false; }
+    void setForcedVisibility(bool, bool) override {}
+    void addChildNode(const scene::INodePtr&) override {}
+    void addChildNodeToFront(const scene::INodePtr&) override {}
+    void removeChildNode(const scene::INodePtr&) override {}
+    bool hasChildNodes() const override { return false; }
+    void traverse(scene::NodeVisitor&) override {}
+    void traverseChildren(scene::NodeVisitor&) const override {}
+    bool foreachNode(const VisitorFunc&) const override { return true; }
+    scene::INodePtr getSelf() override { return scene::INodePtr(); }
+    void setParent(const scene::INodePtr&) override {}
+    scene::INodePtr getParent() const override { return scene::INodePtr(); }
+    void onInsertIntoScene(scene::IMapRootNode&) override {}
+    void onRemoveFromScene(scene::IMapRootNode&) override {}
+    bool inScene() const override { return true; }
+    IRenderEntity* getRenderEntity() const override { return nullptr; }
+    void setRenderEntity(IRenderEntity*) override {}
+    void boundsChanged() override {}
+    void transformChanged() override {}
+    void transformChangedLocal() override {}
+
+    bool isFiltered() const override { return false; }
+    void setFiltered(bool) override {}
+
+    void addToLayer(int) override {}
+    void moveToLayer(int) override {}
+    void removeFromLayer(int) override {}
+    const scene::LayerList& getLayers() const override { return _layers; }
+    void assignToLayers(const scene::LayerList&) override {}
+
+    void setRenderSystem(const RenderSystemPtr&) override {}
+    void renderSolid(RenderableCollector&, const VolumeTest&) const override {}
+    void renderWireframe(RenderableCollector&, const VolumeTest&) const override {}
+    std::size_t getHighlightFlags() override { return Highlight::NoHighlight; }
+};
+typedef std::shared_ptr<TestBrush> TestBrushPtr;
+
+const double ROOM_SIZE = 512;
+const Vector3 MAP_ORIGIN(-8192, -8192, 128);
+
+// A grid of rooms with walls, floor and ceiling, plus some detail brushes in each room
+inline std::vector<TestBrushPtr> generateMap(std::size_t roomsPerAxis)
+{
+    std::vector<TestBrushPtr> brushes;
+    std::mt19937 rng(1701);
+
+    for (std::size_t x = 0; x < roomsPerAxis; ++x)
+    {
+        for (std::size_t y = 0; y < roomsPerAxis; ++y)
+        {
+            Vector3 centre = MAP_ORIGIN + Vector3(x * ROOM_SIZE, y * ROOM_SIZE, 0);
+
+            brushes.push_back(std::make_shared<TestBrush>(AABB(centre - Vector3(0, 0, 136), Vector3(256, 256, 8))));
+            brushes.push_back(std::make_shared<TestBrush>(AABB(centre + Vector3(0, 0, 136), Vector3(256, 256, 8))));
+            brushes.push_back(std::make_shared<TestBrush>(AABB(centre + Vector3(248, 0, 0), Vector3(8, 256, 128))));
+            brushes.push_back(std::make_shared<TestBrush>(AABB(centre - Vector3(248, 0, 0), Vector3(8, 256, 128))));
+            brushes.push_back(std::make_shared<TestBrush>(AABB(centre + Vector3(0, 248, 0), Vector3(256, 8, 128))));
+            brushes.push_back(std::make_shared<TestBrush>(AABB(centre - Vector3(0, 248, 0), Vector3(256, 8, 128))));
+
+            for (int d = 0; d < 10; ++d)
+            {
+                Vector3 offset(int(rng() % 400) - 200, int(rng() % 400) - 200, int(rng() % 200) - 100);
+                Vector3 extents(2 + rng() % 24, 2 + rng() % 24, 2 + rng() % 16);
+
+                brushes.push_back(std::make_shared<TestBrush>(AABB(centre + offset, extents)));
+            }
+        }
+    }
+
+    return brushes;
+}
+
+// A click into the camera view
+struct Click
+{
+    Vector3 origin;
+    Vector3 angles; // pitch, yaw, roll in degrees
+    Vector2 devicePoint;
+};
+
+// A session of clicks, each one from a different camera position within the rooms
+inline std::vector<Click> recordClicks(std::size_t roomsPerAxis, std::size_t numClicks)
+{
+    std::vector<Click> clicks;
+    std::mt19937 rng(4711);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    for (std::size_t i = 0; i < numClicks; ++i)
+    {
+        Click click;
+
+        Vector3 room = MAP_ORIGIN + Vector3((rng() % roomsPerAxis) * ROOM_SIZE, (rng() % roomsPerAxis) * ROOM_SIZE, 0);
+
+        click.origin = room + Vector3(unit(rng) * 400 - 200, unit(rng) * 400 - 200, unit(rng) * 160 - 80);
+        click.angles = Vector3(unit(rng) * 60 - 30, unit(rng) * 360, 0);
+        click.devicePoint = Vector2(unit(rng) * 1.8 - 0.9, unit(rng) * 1.8 - 0.9);
+
+        clicks.push_back(click);
+    }
+
+    return clicks;
+}
+
+// The view of the camera, as set up by the Camera class
+inline render::View constructCameraView(const Click& click)
+{
+    const std::size_t width = 1280;
+    const std::size_t height = 720;
+    const double farClip = 32768;
+    const double nearClip = farClip / 4096;
+
+    double halfWidth = nearClip * tan(degrees_to_radians(45.0));
+    double halfHeight = halfWidth * height / width;
+
+    Matrix4 projection = Matrix4::getProjectionForFrustum(-halfWidth, halfWidth,
+        -halfHeight, halfHeight, nearClip, farClip);
+
+    const Matrix4 radiant2opengl = Matrix4::byColumns(
+        0, -1, 0, 0,
+        0, 0, 1, 0,
+        -1, 0, 0, 0,
+        0, 0, 0, 1);
+
+    Matrix4 modelview = Matrix4::getIdentity();
+    modelview.translateBy(click.origin);
+    modelview.rotateByEulerXYZDegrees(Vector3(0, -click.angles[0], click.angles[1]));
+    modelview.multiplyBy(radiant2opengl);
+    modelview.invert();
+
+    render::View view;
+    view.Construct(projection, modelview, width, height);
+
+    return view;
+}
+
+// What SceneGraph::foreachNodeInVolume_r() does
+inline void foreachNodeInVolume(const scene::ISPNode& node, const VolumeTest& volume,
+                                const scene::INode::VisitorFunc& functor)
+{
+    for (const scene::INodePtr& member : node.getMembers())
+    {
+        functor(member);
+    }
+
+    for (const scene::ISPNodePtr& child : node.getChildNodes())
+    {
+        if (volume.TestAABB(child->getBounds()) != VOLUME_OUTSIDE)
+        {
+            foreachNodeInVolume(*child, volume, functor);
+        }
+    }
+}
+
+// Returns the best intersection of the given click, what SelectPoint() would select
+inline SelectionIntersection selectPoint(const scene::Octree& octree, const Click& click, bool accelerated)
+{
+    render::View scissored = constructCameraView(click);
+    ConstructSelectionTest(scissored, selection::Rectangle::ConstructFromPoint(click.devicePoint, Vector2(0.005, 0.005)));
+
+    SelectionVolume test(scissored);
+    SelectionPool pool;
+
+    auto testNode = [&](const scene::INodePtr& node)
+    {
+        TestBrush& brush = static_cast<TestBrush&>(*node);
+
+        pool.pushSelectable(brush);
+        brush.testSelect(pool, test);
+        pool.popSelectable();
+
+        return true;
+    };
+
+    TestBrush::rejectByBounds = accelerated;
+
+    if (accelerated)
+    {
+        scene::DepthSortedTraversal traversal(scissored);
+
+        traversal.traverse(*octree.getRoot(), testNode, [&](double depth)
+        {
+            return !pool.hasBestInFrontOf(depth);
+        }, true);
+    }
+    else
+    {
+        foreachNodeInVolume(*octree.getRoot(), scissored, testNode);
+    }
+
+    return pool.empty() ? SelectionIntersection() : pool.begin()->first;
+}
+
+}
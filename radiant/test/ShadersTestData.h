@@ -0,0 +1,295 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <random>
+#include <set>
+
+#include "iarchive.h"
+#include "itextstream.h"
+#include "RGBAImage.h"
+#include "os/fs.h"
+#include "stream/PointerInputStream.h"
+#include "render/TextureResidency.h"
+#include "radiant/WorkStealingScheduler.h"
+#include "radiant/image/TGALoader.h"
+#include "radiant/shaders/textures/ImageKernels.h"
+#include "radiant/shaders/ShaderFileLoader.h"
+#include "radiant/vfs/Doom3FileSystem.h"
+
+// Shader libraries, material files, images, textures and pixel data shared by the shader tests and benchmarks
+namespace shaderstest
+{
+
+// Library keeping the first definition of a name, like the real ShaderLibrary
+struct RecordingShaderLibrary
+{
+    std::map<std::string, shaders::ShaderDefinition> shaderDefs;
+    std::set<std::string> tables;
+
+    // Names in the order they have been added, including the rejected ones
+    std::vector<std::string> addedNames;
+    std::size_t numRejected = 0;
+
+    bool addTableDefinition(const shaders::TableDefinitionPtr& def)
+    {
+        addedNames.push_back(def->getName());
+
+        if (!tables.insert(def->getName()).second)
+        {
+            ++numRejected;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool addDefinition(const std::string& name, const shaders::ShaderDefinition& def)
+    {
+        addedNames.push_back(name);
+
+        if (!shaderDefs.insert(std::make_pair(name, def)).second)
+        {
+            ++numRejected;
+            return false;
+        }
+
+        return true;
+    }
+};
+
+template<typename Library>
+void parseShadersFromPath(vfs::Doom3FileSystem& fs, const std::string& path,
+                          Library& library, TaskScheduler* scheduler = nullptr,
+                          parser::DeclFileCache* cache = nullptr)
+{
+    // Walk the filesystem and load .mtr files
+    shaders::ShaderFileLoader<Library> loader(fs, library, path, "mtr", scheduler, cache);
+
+    // Instruct the loader to parse MTR files and create ShaderDefinitions
+    loader.parseFiles();
+}
+
+// Creates a VFS root full of generated material files, which is removed at the end of the test
+struct GeneratedMaterialsFixture
+{
+    fs::path root;
+    vfs::Doom3FileSystem fs;
+
+    std::size_t numMaterials;
+
+    GeneratedMaterialsFixture() :
+        root(fs::temp_directory_path() / ("shadersTest" + std::to_string(std::random_device()()))),
+        numMaterials(0)
+    {
+        GlobalOutputStream().setStream(std::cout);
+        GlobalErrorStream().setStream(std::cerr);
+
+        fs::create_directories(root / "materials");
+
+        // 250 files with 100 materials each, every file overrides a few
+        // materials of its predecessor and defines a table
+        for (int f = 0; f < 250; ++f)
+        {
+            std::ofstream file((root / "materials" / ("bench" + std::to_string(f) + ".mtr")).string());
+
+            file << "table benchTable" << f % 200 << " { { 0, 0.5, 1 } }\n\n";
+
+            for (int m = 0; m < 100; ++m)
+            {
+                // The last materials of each file are repeating the first ones of the file before
+                int index = m < 95 ? f * 95 + m : f == 0 ? 250 * 95 + m : (f - 1) * 95 + m - 95;
+                std::string name = "textures/bench/material" + std::to_string(index);
+
+                file << name << "\n"
+                    << "{\n"
+                    << "\tqer_editorimage " << name << "_ed\n"
+                    << "\tsurftype15\n"
+                    << "\tdescription \"generated material " << m << " of file " << f << "\"\n"
+                    << "\tdiffusemap " << name << "_d\n"
+                    << "\tbumpmap addnormals(" << name << "_local, heightmap(" << name << "_h, 3))\n"
+                    << "\tspecularmap " << name << "_s\n"
+                    << "\t{\n"
+                    << "\t\tblend add\n"
+                    << "\t\tmap textures/bench/glow\n"
+                    << "\t\trgb 0.5 * sintable[time * 0.1]\n"
+                    << "\t}\n"
+                    << "}\n\n";
+
+                ++numMaterials;
+            }
+        }
+
+        vfs::VirtualFileSystem::ExtensionSet pakExtensions;
+        pakExtensions.insert("pk4");
+
+        vfs::SearchPaths searchPaths;
+        searchPaths.insertIfNotExists(root.string() + "/");
+
+        fs.initialise(searchPaths, pakExtensions);
+    }
+
+    ~GeneratedMaterialsFixture()
+    {
+        fs.shutdown();
+        fs::remove_all(root);
+    }
+};
+
+typedef std::vector<unsigned char> Buffer;
+
+// An uncompressed 32 bit TGA file with a pattern depending on the seed
+inline Buffer createTGA(std::size_t width, std::size_t height, unsigned char seed)
+{
+    Buffer tga(18, 0);
+
+    tga[2] = 2; // uncompressed true-colour
+    tga[12] = static_cast<unsigned char>(width & 0xff);
+    tga[13] = static_cast<unsigned char>(width >> 8);
+    tga[14] = static_cast<unsigned char>(height & 0xff);
+    tga[15] = static_cast<unsigned char>(height >> 8);
+    tga[16] = 32;
+    tga[17] = 0x28; // top-left origin, 8 alpha bits
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            // BGRA
+            tga.push_back(static_cast<unsigned char>(x + seed));
+            tga.push_back(static_cast<unsigned char>(y));
+            tga.push_back(seed);
+            tga.push_back(255);
+        }
+    }
+
+    return tga;
+}
+
+// ArchiveFile reading from a buffer
+class BufferArchiveFile :
+    public ArchiveFile
+{
+private:
+    std::string _name;
+    const Buffer& _buffer;
+    stream::PointerInputStream _stream;
+
+public:
+    BufferArchiveFile(const Buffer& buffer) :
+        _name("textures/test.tga"),
+        _buffer(buffer),
+        _stream(buffer.data())
+    {}
+
+    std::size_t size() const override { return _buffer.size(); }
+    const std::string& getName() const override { return _name; }
+    InputStream& getInputStream() override { return _stream; }
+};
+
+inline ImagePtr decodeTGA(const Buffer& buffer)
+{
+    BufferArchiveFile file(buffer);
+    return image::TGALoader().load(file);
+}
+
+// Seed of the pattern of a decoded image
+inline int getSeed(const ImagePtr& image)
+{
+    return image ? image->getMipMapPixels(0)[2] : -1;
+}
+
+using render::TextureResidency;
+
+const std::size_t MB = 1 << 20;
+
+// Registers a fully resident 512x512 texture using the given number of bytes
+inline void addTexture(TextureResidency& residency, TextureResidency::TextureId id, std::size_t bytes)
+{
+    residency.setResident(id, bytes, TextureResidency::getNumLevels(512, 512), 0);
+}
+
+// Applies the changes the way the texture manager does once the images are uploaded
+inline void applyChanges(TextureResidency& residency, const std::vector<TextureResidency::Change>& changes)
+{
+    for (const TextureResidency::Change& change : changes)
+    {
+        if (change.firstLevel == TextureResidency::EVICTED)
+        {
+            residency.setEvicted(change.texture);
+        }
+        else
+        {
+            residency.setResident(change.texture, MB, TextureResidency::getNumLevels(512, 512),
+                                  change.firstLevel);
+        }
+    }
+}
+
+namespace kernels = shaders::kernels;
+
+typedef std::vector<byte> Pixels;
+
+inline Pixels createNoise(std::size_t width, std::size_t height, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> value(0, 255);
+
+    Pixels pixels(width * height * 4);
+
+    for (byte& channel : pixels)
+    {
+        channel = static_cast<byte>(value(random));
+    }
+
+    return pixels;
+}
+
+inline std::vector<kernels::InstructionSet> getInstructionSets()
+{
+    std::vector<kernels::InstructionSet> sets;
+
+    for (kernels::InstructionSet set : { kernels::InstructionSet::Scalar,
+                                         kernels::InstructionSet::SSE2,
+                                         kernels::InstructionSet::AVX2 })
+    {
+        if (set <= kernels::getSupportedInstructionSet())
+        {
+            sets.push_back(set);
+        }
+    }
+
+    return sets;
+}
+
+inline const char* getName(kernels::InstructionSet set)
+{
+    switch (set)
+    {
+    case kernels::InstructionSet::SSE2: return "SSE2";
+    case kernels::InstructionSet::AVX2: return "AVX2";
+    default: return "scalar";
+    }
+}
+
+// Runs the check for all instruction sets, with and without threads
+inline void forEachConfiguration(const std::function<void(const std::string&)>& check)
+{
+    radiant::WorkStealingScheduler scheduler(4);
+
+    for (kernels::InstructionSet set : getInstructionSets())
+    {
+        kernels::setInstructionSet(set);
+
+        kernels::setTaskScheduler(NULL);
+        check(getName(set));
+
+        kernels::setTaskScheduler(&scheduler);
+        check(std::string(getName(set)) + " threaded");
+    }
+
+    kernels::setTaskScheduler(NULL);
+    kernels::setInstructionSet(kernels::InstructionSet::AVX2);
+}
+
+}
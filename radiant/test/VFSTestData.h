@@ -0,0 +1,323 @@
+#pragma once
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <zlib.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include "itextstream.h"
+#include "os/fs.h"
+#include "stream/utils.h"
+#include "parser/BufferDefTokeniser.h"
+#include "parser/DeclFileCache.h"
+#include "radiant/vfs/Doom3FileSystem.h"
+#include "radiant/vfs/ZipArchive.h"
+#include "eclassmgr/Doom3ModelDef.h"
+
+// Archives, def files and temporary folders shared by the VFS tests and benchmarks
+namespace vfstest
+{
+
+struct TestFile
+{
+    std::string name;
+    std::string contents;
+    bool deflated;
+};
+
+// Generates declaration-like text which compresses about as well as the real thing
+inline std::vector<TestFile> generateFiles(std::size_t count, std::size_t seed)
+{
+    std::vector<TestFile> files(count);
+    std::mt19937 rng(static_cast<unsigned int>(seed));
+
+    const char* const words[] = { "textures/darkmod/", "stone", "wood", "{", "}", "diffusemap",
+        "bumpmap", "_local", "\n\t", "blend", "add", "qer_editorimage", "metal", "rgb 0.5" };
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        TestFile& file = files[i];
+
+        file.name = "materials/test" + std::to_string(i % 10) + "/file" + std::to_string(i) + ".mtr";
+        file.deflated = i % 8 != 0;
+
+        std::size_t length = 2048 + rng() % 60000;
+
+        while (file.contents.length() < length)
+        {
+            file.contents += words[rng() % (sizeof(words) / sizeof(words[0]))];
+            file.contents += ' ';
+        }
+    }
+
+    return files;
+}
+
+inline std::string deflate(const std::string& input)
+{
+    z_stream zs = z_stream();
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+    std::string output(deflateBound(&zs, static_cast<uLong>(input.length())), '\0');
+
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    zs.avail_in = static_cast<uInt>(input.length());
+    zs.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    zs.avail_out = static_cast<uInt>(output.length());
+
+    deflate(&zs, Z_FINISH);
+    output.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    return output;
+}
+
+// Writes a PK4 with the given files, including the directory entries
+inline void writePk4(const std::string& path, const std::vector<TestFile>& files)
+{
+    std::ofstream stream(path, std::ios::binary);
+    std::ostringstream centralDir;
+    uint16_t numEntries = 0;
+
+    auto writeEntry = [&](const std::string& name, const std::string& data, uint16_t method,
+        uint32_t crc, uint32_t uncompressedSize)
+    {
+        uint32_t offset = static_cast<uint32_t>(stream.tellp());
+
+        stream.write("PK\x03\x04", 4);
+        stream::writeLittleEndian<uint16_t>(stream, 20);
+        stream::writeLittleEndian<uint16_t>(stream, 0);
+        stream::writeLittleEndian<uint16_t>(stream, method);
+        stream::writeLittleEndian<uint32_t>(stream, 0);
+        stream::writeLittleEndian<uint32_t>(stream, crc);
+        stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(data.length()));
+        stream::writeLittleEndian<uint32_t>(stream, uncompressedSize);
+        stream::writeLittleEndian<uint16_t>(stream, static_cast<uint16_t>(name.length()));
+        stream::writeLittleEndian<uint16_t>(stream, 0);
+        stream << name << data;
+
+        centralDir.write("PK\x01\x02", 4);
+        stream::writeLittleEndian<uint16_t>(centralDir, 20);
+        stream::writeLittleEndian<uint16_t>(centralDir, 20);
+        stream::writeLittleEndian<uint16_t>(centralDir, 0);
+        stream::writeLittleEndian<uint16_t>(centralDir, method);
+        stream::writeLittleEndian<uint32_t>(centralDir, 0);
+        stream::writeLittleEndian<uint32_t>(centralDir, crc);
+        stream::writeLittleEndian<uint32_t>(centralDir, static_cast<uint32_t>(data.length()));
+        stream::writeLittleEndian<uint32_t>(centralDir, uncompressedSize);
+        stream::writeLittleEndian<uint16_t>(centralDir, static_cast<uint16_t>(name.length()));
+        stream::writeLittleEndian<uint16_t>(centralDir, 0);
+        stream::writeLittleEndian<uint16_t>(centralDir, 0);
+        stream::writeLittleEndian<uint16_t>(centralDir, 0);
+        stream::writeLittleEndian<uint16_t>(centralDir, 0);
+        stream::writeLittleEndian<uint32_t>(centralDir, 0);
+        stream::writeLittleEndian<uint32_t>(centralDir, offset);
+        centralDir << name;
+
+        ++numEntries;
+    };
+
+    writeEntry("materials/", std::string(), 0, 0, 0);
+
+    for (const TestFile& file : files)
+    {
+        uint32_t crc = crc32(0, reinterpret_cast<const Bytef*>(file.contents.data()),
+            static_cast<uInt>(file.contents.length()));
+
+        writeEntry(file.name, file.deflated ? deflate(file.contents) : file.contents,
+            file.deflated ? Z_DEFLATED : 0, crc, static_cast<uint32_t>(file.contents.length()));
+    }
+
+    std::string dir = centralDir.str();
+    uint32_t dirOffset = static_cast<uint32_t>(stream.tellp());
+    stream << dir;
+
+    stream.write("PK\x05\x06", 4);
+    stream::writeLittleEndian<uint16_t>(stream, 0);
+    stream::writeLittleEndian<uint16_t>(stream, 0);
+    stream::writeLittleEndian<uint16_t>(stream, numEntries);
+    stream::writeLittleEndian<uint16_t>(stream, numEntries);
+    stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(dir.length()));
+    stream::writeLittleEndian<uint32_t>(stream, dirOffset);
+    stream::writeLittleEndian<uint16_t>(stream, 0);
+}
+
+inline std::string readFile(archive::ZipArchive& archive, const std::string& name)
+{
+    ArchiveFilePtr file = archive.openFile(name);
+
+    if (!file)
+    {
+        return std::string();
+    }
+
+    std::string contents(file->size(), '\0');
+    std::size_t numRead = file->getInputStream().read(
+        reinterpret_cast<InputStream::byte_type*>(&contents[0]), contents.size());
+    contents.resize(numRead);
+
+    return contents;
+}
+
+class FileCounter :
+    public Archive::Visitor
+{
+public:
+    std::size_t count = 0;
+
+    void visitFile(const std::string& name) override { ++count; }
+    bool visitDirectory(const std::string& name, std::size_t depth) override { return false; }
+};
+
+inline std::size_t countFiles(archive::ZipArchive& archive)
+{
+    FileCounter counter;
+    archive.traverse(counter, "");
+    return counter.count;
+}
+
+// Creates a temporary folder which is removed again at the end of the test
+struct TempFolderFixture
+{
+    fs::path folder;
+
+    TempFolderFixture() :
+        folder(fs::temp_directory_path() / ("vfsTest" + std::to_string(std::random_device()())))
+    {
+        GlobalOutputStream().setStream(std::cout);
+        GlobalErrorStream().setStream(std::cerr);
+        GlobalWarningStream().setStream(std::cerr);
+
+        fs::create_directories(folder);
+    }
+
+    ~TempFolderFixture()
+    {
+        fs::remove_all(folder);
+    }
+};
+
+using eclass::Doom3ModelDef;
+using eclass::Doom3ModelDefPtr;
+
+typedef std::vector<Doom3ModelDefPtr> ModelDefs;
+
+// Creates a VFS root with a few def files, which is removed at the end of the test
+struct DefFilesFixture
+{
+    fs::path root;
+    std::string cacheFile;
+    vfs::Doom3FileSystem vfs;
+
+    DefFilesFixture() :
+        root(fs::temp_directory_path() / ("declFileCacheTest" + std::to_string(std::random_device()())))
+    {
+        GlobalOutputStream().setStream(std::cout);
+        GlobalErrorStream().setStream(std::cerr);
+        GlobalWarningStream().setStream(std::cerr);
+
+        fs::create_directories(root / "def");
+        cacheFile = (root / "decls.cache").string();
+    }
+
+    ~DefFilesFixture()
+    {
+        vfs.shutdown();
+        fs::remove_all(root);
+    }
+
+    void writeFile(const std::string& name, const std::string& contents)
+    {
+        std::ofstream((root / name).string()) << contents;
+    }
+
+    void initialiseVfs()
+    {
+        vfs::VirtualFileSystem::ExtensionSet pakExtensions;
+        pakExtensions.insert("pk4");
+
+        vfs::SearchPaths searchPaths;
+        searchPaths.insertIfNotExists(root.string() + "/");
+
+        vfs.initialise(searchPaths, pakExtensions);
+    }
+
+    // Parses the model defs of the given VFS file like the EClassManager does,
+    // taking them from the cache if the file is unchanged
+    ModelDefs getModelDefs(parser::DeclFileCache& cache, const std::string& path, bool& cached)
+    {
+        ModelDefs models;
+        std::string data;
+        vfs::FileStamp stamp = vfs.getFileStamp(path);
+
+        cached = cache.lookup(path, stamp, data);
+
+        if (cached)
+        {
+            parser::DeclReader reader(data);
+
+            for (std::size_t i = reader.readCount(4); i > 0; --i)
+            {
+                models.push_back(std::make_shared<Doom3ModelDef>(reader.readString()));
+                models.back()->readFromCache(reader);
+            }
+
+            BOOST_TEST(reader.atEnd());
+            return models;
+        }
+
+        ArchiveTextFilePtr file = vfs.openTextFile(path);
+        std::istream is(&(file->getInputStream()));
+        std::string contents = parser::readStreamContents(is);
+
+        parser::BufferDefTokeniser tok(contents);
+
+        while (tok.hasMoreTokens())
+        {
+            tok.assertNextToken("model");
+
+            models.push_back(std::make_shared<Doom3ModelDef>(tok.nextToken()));
+            models.back()->parseFromTokens(tok);
+        }
+
+        parser::DeclWriter writer;
+        writer.writeSize(models.size());
+
+        for (const Doom3ModelDefPtr& model : models)
+        {
+            writer.writeString(model->name);
+            model->writeToCache(writer);
+        }
+
+        cache.store(path, stamp, writer.getData());
+
+        return models;
+    }
+
+    std::string generateDef(std::size_t index)
+    {
+        std::string def;
+
+        for (std::size_t i = 0; i < 20; ++i)
+        {
+            std::string name = "model_" + std::to_string(index) + "_" + std::to_string(i);
+
+            def += "model " + name + "\n{\n"
+                "\tinherit \"base_model\"\n"
+                "\t// a real comment\n"
+                "\tmesh \"models/md5/" + name + ".md5mesh\"\n"
+                "\tchannel torso ( *Spine_Dummy )\n"
+                "\tanim idle \"models/md5/" + name + "_idle.md5anim\"\n"
+                "\tanim walk \"models/md5/" + name + "_walk.md5anim\" {\n"
+                "\t\tframe 10 sound_body snd_footstep\n"
+                "\t}\n"
+                "}\n\n";
+        }
+
+        return def;
+    }
+};
+
+}
@@ -0,0 +1,1310 @@
+#define BOOST_TEST_MODULE benchmarks
+#include <boost/test/included/unit_test.hpp>
+
+// Timings of the editor's expensive code paths, with the old implementation
+// as reference where there is one. These are not part of the test suite,
+// "make benchmark" runs them and logs the results.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+#include "os/fs.h"
+#include "parser/BufferDefTokeniser.h"
+#include "radiant/WorkStealingScheduler.h"
+#include "radiant/filters/XMLFilter.h"
+#include "radiant/shaders/textures/GLTextureManager.h"
+#include "radiant/shaders/textures/TextureDecodeQueue.h"
+#include "util/RadixSort.h"
+
+#include "BrushTestData.h"
+#include "EClassTestData.h"
+#include "MapTestData.h"
+#include "MD5TestData.h"
+#include "RenderTestData.h"
+#include "SceneTestData.h"
+#include "ShadersTestData.h"
+#include "VFSTestData.h"
+
+namespace shaders
+{
+
+// Provide a local implementation of GetTextureManager since the application
+// version calls the module registry.
+GLTextureManager& GetTextureManager()
+{
+    static GLTextureManager manager;
+    return manager;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(mapTokenising)
+{
+    using namespace maptest;
+
+    std::string mapText = generateMap(4000);
+    radiant::WorkStealingScheduler scheduler;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> serial = tokeniseSerially(mapText);
+    auto serialTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    std::size_t numEntities = 0;
+    std::vector<std::string> parallel = tokeniseInParallel(mapText, scheduler, numEntities);
+    auto parallelTime = std::chrono::steady_clock::now() - start;
+
+    // The loading order and content must be exactly the same
+    BOOST_TEST(numEntities == 4000);
+    BOOST_TEST(parallel == serial);
+
+    BOOST_TEST_MESSAGE("Tokenised " << mapText.size() / 1024 << " KB: serial "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(serialTime).count() << " ms, parallel "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(parallelTime).count() << " ms");
+}
+
+namespace
+{
+    std::string generateMaterials(std::size_t count)
+    {
+        std::ostringstream str;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            str << "// Material " << i << std::endl;
+            str << "textures/darkmod/stone/brick_" << i << std::endl << "{" << std::endl;
+            str << "    qer_editorimage textures/darkmod/stone/brick_ed" << std::endl;
+            str << "    description \"Brick wall \\\"number\\\" " << i << "\"" << std::endl;
+            str << "    /* diffuse stage */" << std::endl;
+            str << "    {" << std::endl;
+            str << "        blend diffusemap" << std::endl;
+            str << "        map textures/darkmod/stone/brick_d" << std::endl;
+            str << "        rgb 0.5 * parm0" << std::endl;
+            str << "        translate time * 0.125, 0.25" << std::endl;
+            str << "    }" << std::endl;
+            str << "    bumpmap addnormals(textures/darkmod/stone/brick_local, heightmap(textures/darkmod/stone/brick_h, 4))" << std::endl;
+            str << "}" << std::endl;
+        }
+
+        return str.str();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tokenisers)
+{
+    std::string input = generateMaterials(20000);
+
+    auto measure = [&](const char* name, const std::function<std::size_t()>& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::size_t numTokens = func();
+        auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+        BOOST_TEST_MESSAGE(name << ": " << numTokens << " tokens, "
+            << static_cast<std::size_t>(numTokens / std::max(duration.count(), 1e-9)) << " tokens/s");
+
+        return numTokens;
+    };
+
+    std::size_t streamTokens = measure("BasicDefTokeniser<std::istream>", [&]()
+    {
+        std::istringstream stream(input);
+        parser::BasicDefTokeniser<std::istream> tok(stream);
+
+        std::size_t count = 0;
+        for (; tok.hasMoreTokens(); ++count) tok.nextToken();
+        return count;
+    });
+
+    std::size_t stringTokens = measure("BasicDefTokeniser<std::string>", [&]()
+    {
+        parser::BasicDefTokeniser<std::string> tok(input);
+
+        std::size_t count = 0;
+        for (; tok.hasMoreTokens(); ++count) tok.nextToken();
+        return count;
+    });
+
+    std::size_t bufferTokens = measure("BufferDefTokeniser", [&]()
+    {
+        parser::BufferDefTokeniser tok(input);
+
+        std::size_t count = 0;
+        for (; tok.hasMoreTokens(); ++count) tok.nextTokenView();
+        return count;
+    });
+
+    BOOST_TEST(stringTokens == streamTokens);
+    BOOST_TEST(bufferTokens == streamTokens);
+}
+
+BOOST_AUTO_TEST_CASE(selectionDrag)
+{
+    using namespace scenetest;
+
+    // A map with 25,600 brushes, of which every fourth one is selected
+    // and dragged through the map in small steps, like the mouse would do.
+    // Each frame a few brushes are deleted and re-created (clone/undo).
+    std::vector<TestNodePtr> brushes = generateMapBrushes(40);
+
+    std::vector<scene::INodePtr> selection;
+
+    for (std::size_t i = 0; i < brushes.size(); i += 4)
+    {
+        selection.push_back(brushes[i]);
+    }
+
+    const int numFrames = 200;
+
+    auto replay = [&](const std::function<void(scene::Octree&)>& relinkSelection)
+    {
+        scene::Octree octree;
+
+        for (const TestNodePtr& brush : brushes)
+        {
+            octree.link(brush);
+        }
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            Vector3 delta(frame < numFrames / 2 ? 8 : -8, 4, 0);
+
+            for (const scene::INodePtr& node : selection)
+            {
+                translate(static_cast<TestNode&>(*node), delta);
+            }
+
+            relinkSelection(octree);
+
+            for (std::size_t i = frame; i < brushes.size(); i += 997)
+            {
+                octree.unlink(brushes[i]);
+                octree.link(brushes[i]);
+            }
+        }
+
+        BOOST_TEST(countMembers(octree) == brushes.size());
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    replay([&](scene::Octree& octree)
+    {
+        // What SceneGraph::nodeBoundsChanged() used to do
+        for (const scene::INodePtr& node : selection)
+        {
+            if (octree.unlink(node))
+            {
+                octree.link(node);
+            }
+        }
+    });
+
+    auto unlinkLinkTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    replay([&](scene::Octree& octree)
+    {
+        octree.relink(selection);
+    });
+
+    auto relinkTime = std::chrono::steady_clock::now() - start;
+
+    BOOST_TEST_MESSAGE("Dragged " << selection.size() << " of " << brushes.size() << " brushes over "
+        << numFrames << " frames: unlink/link "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(unlinkLinkTime).count() << " ms, relink "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(relinkTime).count() << " ms");
+}
+
+BOOST_AUTO_TEST_CASE(brushWindings)
+{
+    using namespace brushtest;
+
+    // A map-sized set of brushes
+    std::vector<TestBrush> serial = generateBrushes(30000);
+    std::vector<TestBrush> parallel = generateBrushes(30000);
+
+    std::size_t numFaces = 0;
+    radiant::WorkStealingScheduler scheduler;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (TestBrush& brush : serial)
+    {
+        numFaces += brush.build();
+    }
+
+    auto serialTime = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+
+    scheduler.parallelFor(parallel.size(), [&](std::size_t i)
+    {
+        parallel[i].build();
+    });
+
+    auto parallelTime = std::chrono::steady_clock::now() - start;
+
+    for (std::size_t i = 0; i < serial.size(); ++i)
+    {
+        checkSameWindings(serial[i].windings, parallel[i].windings);
+    }
+
+    // Drag one face of every brush, like a large face selection being moved
+    for (TestBrush& brush : parallel)
+    {
+        brush.planes[0] = Plane3(brush.planes[0].normal(), brush.planes[0].dist() + 8);
+    }
+
+    std::size_t numClipped = 0;
+    start = std::chrono::steady_clock::now();
+
+    for (TestBrush& brush : parallel)
+    {
+        numClipped += brush.build();
+    }
+
+    auto incrementalTime = std::chrono::steady_clock::now() - start;
+
+    BOOST_TEST(numClipped < numFaces);
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    BOOST_TEST_MESSAGE("Built " << numFaces << " faces of " << serial.size() << " brushes: serial "
+        << duration_cast<milliseconds>(serialTime).count() << " ms, parallel "
+        << duration_cast<milliseconds>(parallelTime).count() << " ms; after dragging one face per brush "
+        << numClipped << " faces clipped in " << duration_cast<milliseconds>(incrementalTime).count() << " ms");
+}
+
+BOOST_FIXTURE_TEST_CASE(decompressAllFiles, vfstest::TempFolderFixture)
+{
+    using namespace vfstest;
+
+    // A PK4 resembling a large texture or materials archive
+    std::vector<TestFile> files = generateFiles(4000, 4);
+    std::string pk4 = (folder / "large.pk4").string();
+    std::string cacheFile = (folder / "pk4index.cache").string();
+    writePk4(pk4, files);
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    using std::chrono::microseconds;
+
+    // Scanning the central directory, then using the cached index
+    archive::ZipIndexCache cache(cacheFile);
+    cache.load();
+
+    auto start = std::chrono::steady_clock::now();
+    archive::ZipArchive archive(pk4, &cache);
+    auto scanTime = std::chrono::steady_clock::now() - start;
+
+    cache.save();
+    cache.load();
+
+    start = std::chrono::steady_clock::now();
+    archive::ZipArchive cachedArchive(pk4, &cache);
+    auto cachedTime = std::chrono::steady_clock::now() - start;
+
+    BOOST_TEST(countFiles(cachedArchive) == files.size());
+
+    auto decompressAll = [&](std::size_t numThreads)
+    {
+        std::vector<std::size_t> bytesRead(numThreads, 0);
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                for (std::size_t i = t; i < files.size(); i += numThreads)
+                {
+                    bytesRead[t] += readFile(archive, files[i].name).length();
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        auto duration = std::chrono::steady_clock::now() - start;
+
+        std::size_t total = 0;
+
+        for (std::size_t bytes : bytesRead)
+        {
+            total += bytes;
+        }
+
+        BOOST_TEST_MESSAGE("Decompressed " << files.size() << " files (" << (total >> 20) << " MiB) using "
+            << numThreads << " thread(s) in " << duration_cast<milliseconds>(duration).count() << " ms");
+
+        return total;
+    };
+
+    std::size_t expectedBytes = 0;
+
+    for (const TestFile& file : files)
+    {
+        expectedBytes += file.contents.length();
+    }
+
+    std::size_t maxThreads = std::max(std::thread::hardware_concurrency(), 4u);
+
+    for (std::size_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        BOOST_TEST(decompressAll(numThreads) == expectedBytes);
+    }
+
+    BOOST_TEST_MESSAGE("Central directory of " << files.size() << " entries: scanned in "
+        << duration_cast<microseconds>(scanTime).count() << " us, loaded from the cache in "
+        << duration_cast<microseconds>(cachedTime).count() << " us");
+}
+
+BOOST_FIXTURE_TEST_CASE(warmStartup, vfstest::DefFilesFixture)
+{
+    using namespace vfstest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    const std::size_t numFiles = 500;
+
+    for (std::size_t i = 0; i < numFiles; ++i)
+    {
+        writeFile("def/file" + std::to_string(i) + ".def", generateDef(i));
+    }
+
+    initialiseVfs();
+
+    std::size_t coldModels = 0;
+    std::size_t warmModels = 0;
+    bool cached = false;
+
+    auto start = steady_clock::now();
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        for (std::size_t i = 0; i < numFiles; ++i)
+        {
+            coldModels += getModelDefs(cache, "def/file" + std::to_string(i) + ".def", cached).size();
+        }
+
+        cache.save();
+    }
+    auto coldTime = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        for (std::size_t i = 0; i < numFiles; ++i)
+        {
+            warmModels += getModelDefs(cache, "def/file" + std::to_string(i) + ".def", cached).size();
+            BOOST_TEST_REQUIRE(cached);
+        }
+    }
+    auto warmTime = steady_clock::now() - start;
+
+    BOOST_TEST(coldModels == warmModels);
+
+    BOOST_TEST_MESSAGE("Parsed " << numFiles << " files (" << coldModels << " model defs) in "
+        << duration_cast<milliseconds>(coldTime).count() << " ms, read them from the cache in "
+        << duration_cast<milliseconds>(warmTime).count() << " ms");
+}
+
+BOOST_AUTO_TEST_CASE(collisionModelExport)
+{
+    using namespace brushtest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    std::vector<cmutil::BrushGeometry> brushes = generateGrid(24);
+
+    auto start = steady_clock::now();
+    std::string output = exportModel(brushes);
+    auto exportTime = steady_clock::now() - start;
+
+    BOOST_TEST_MESSAGE("Exported " << brushes.size() << " brushes (" << output.size() << " bytes) in "
+        << duration_cast<milliseconds>(exportTime).count() << " ms");
+}
+
+BOOST_AUTO_TEST_CASE(mapWriting)
+{
+    using namespace maptest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    TestMap map = generateTestMap(5000, 20000);
+
+    fs::path folder = fs::temp_directory_path() / ("mapWriterTest" + std::to_string(std::random_device()()));
+    fs::create_directories(folder);
+
+    std::string directFile = (folder / "direct.map").string();
+    std::string parallelFile = (folder / "parallel.map").string();
+
+    auto start = steady_clock::now();
+    {
+        std::ofstream stream(directFile);
+        stream.precision(16);
+
+        TestMapWriter writer;
+        writer.beginWriteMap(scene::IMapRootNodePtr(), stream);
+        writeMap(map, writer, stream);
+    }
+    auto directTime = steady_clock::now() - start;
+
+    radiant::WorkStealingScheduler scheduler;
+    std::size_t numNodes = 0;
+
+    start = steady_clock::now();
+    {
+        std::ofstream stream(parallelFile);
+        stream.precision(16);
+
+        TestMapWriter writer;
+        numNodes = writeInParallel(map, writer, &scheduler, stream);
+    }
+    auto parallelTime = steady_clock::now() - start;
+
+    // Read both files back, they must be identical
+    std::ifstream directStream(directFile);
+    std::ifstream parallelStream(parallelFile);
+
+    std::string direct((std::istreambuf_iterator<char>(directStream)), std::istreambuf_iterator<char>());
+    std::string parallel((std::istreambuf_iterator<char>(parallelStream)), std::istreambuf_iterator<char>());
+
+    std::size_t expectedNodes = 0;
+
+    for (const TestMap::Entity& entity : map.entities)
+    {
+        expectedNodes += 1 + entity.brushes.size() + entity.numPatches;
+    }
+
+    BOOST_TEST(numNodes == expectedNodes);
+    BOOST_TEST(direct.size() > 0);
+    BOOST_TEST(parallel == direct);
+
+    directStream.close();
+    parallelStream.close();
+    fs::remove_all(folder);
+
+    BOOST_TEST_MESSAGE("Wrote " << numNodes << " nodes (" << direct.size() << " bytes) in "
+        << duration_cast<milliseconds>(directTime).count() << " ms directly, "
+        << duration_cast<milliseconds>(parallelTime).count() << " ms using "
+        << scheduler.getNumWorkers() << " workers");
+}
+
+namespace
+{
+    // Visibility as determined before the rules were compiled
+    bool isVisibleReference(const FilterRules& rules, FilterRule::Type type, const std::string& name)
+    {
+        bool visible = true;
+
+        for (const FilterRule& rule : rules)
+        {
+            if (rule.type == type && std::regex_match(name, std::regex(rule.match)))
+            {
+                visible = rule.show;
+            }
+        }
+
+        return visible;
+    }
+
+    std::vector<std::string> generateMaterialNames(std::size_t count)
+    {
+        const char* const folders[] = { "common", "darkmod/stone", "darkmod/wood", "editor", "darkmod/metal" };
+
+        std::vector<std::string> names;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            names.push_back(std::string("textures/") + folders[i % 5] + "/material" + std::to_string(i));
+        }
+
+        names.push_back("textures/common/caulk");
+        names.push_back("textures/common/nodraw");
+
+        return names;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(textureFilterRules)
+{
+    using std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    filters::XMLFilter filter("World geometry", true);
+    filter.addRule(FilterRule::TYPE_TEXTURE, "textures/darkmod/.*", false);
+    filter.addRule(FilterRule::TYPE_TEXTURE, "textures/darkmod/wood/material1.*", true);
+    filter.addRule(FilterRule::TYPE_TEXTURE, "textures/common/caulk", false);
+    filter.addRule(FilterRule::TYPE_TEXTURE, "textures/(editor|common)/nodraw", false);
+
+    std::vector<std::string> names = generateMaterialNames(20000);
+
+    auto start = steady_clock::now();
+
+    std::size_t hidden = 0;
+
+    for (const std::string& name : names)
+    {
+        hidden += filter.isVisible(FilterRule::TYPE_TEXTURE, name) ? 0 : 1;
+    }
+
+    auto compiledTime = steady_clock::now() - start;
+
+    start = steady_clock::now();
+
+    std::size_t referenceHidden = 0;
+
+    for (const std::string& name : names)
+    {
+        bool visible = isVisibleReference(filter.getRuleSet(), FilterRule::TYPE_TEXTURE, name);
+        referenceHidden += visible ? 0 : 1;
+
+        BOOST_TEST_REQUIRE(visible == filter.isVisible(FilterRule::TYPE_TEXTURE, name));
+    }
+
+    auto referenceTime = steady_clock::now() - start;
+
+    BOOST_TEST(hidden == referenceHidden);
+
+    BOOST_TEST_MESSAGE("Evaluated " << names.size() << " materials in "
+        << duration_cast<milliseconds>(compiledTime).count() << " ms, constructing the regexes took "
+        << duration_cast<milliseconds>(referenceTime).count() << " ms");
+}
+
+BOOST_AUTO_TEST_CASE(batchBuilding)
+{
+    using namespace rendertest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    TestBatch batch;
+    std::vector<TestPolygon> polygons = createPolygons(100000);
+
+    auto start = steady_clock::now();
+    drawAll(batch, polygons);
+    auto initialTime = steady_clock::now() - start;
+
+    // Typical frame: nothing changed
+    start = steady_clock::now();
+    drawAll(batch, polygons);
+    auto unchangedTime = steady_clock::now() - start;
+
+    // One percent of the polygons changed since the last frame
+    for (std::size_t i = 0; i < polygons.size(); i += 100)
+    {
+        polygons[i].revision += polygons.size();
+    }
+
+    batch.getBuffer().verticesWritten = 0;
+
+    start = steady_clock::now();
+    drawAll(batch, polygons);
+    auto changedTime = steady_clock::now() - start;
+
+    BOOST_TEST(batch.getBuffer().verticesWritten < batch.getBuffer().getNumVertices() / 50);
+
+    BOOST_TEST_MESSAGE("Batching " << polygons.size() << " polygons: initial "
+        << duration_cast<microseconds>(initialTime).count() << " us, unchanged "
+        << duration_cast<microseconds>(unchangedTime).count() << " us, 1% changed "
+        << duration_cast<microseconds>(changedTime).count() << " us");
+}
+
+namespace
+{
+    // Imitates the draw records of a shader pass
+    struct DrawRecord
+    {
+        const void* renderable = nullptr;
+        const void* transform = nullptr;
+        const void* light = nullptr;
+        const int* entity = nullptr;
+    };
+}
+
+BOOST_AUTO_TEST_CASE(entityGrouping)
+{
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    const std::size_t NUM_ENTITIES = 2000;
+    const std::size_t NUM_RECORDS = 200000;
+    const int FRAMES = 10;
+
+    std::vector<int> entities(NUM_ENTITIES);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<std::size_t> distribution(0, NUM_ENTITIES - 1);
+
+    std::vector<DrawRecord> submitted(NUM_RECORDS);
+
+    for (DrawRecord& record : submitted)
+    {
+        record.entity = &entities[distribution(random)];
+    }
+
+    // Grouping by entity through a map which is refilled every frame
+    auto start = steady_clock::now();
+    std::size_t mapGroups = 0;
+
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        std::map<const int*, std::vector<DrawRecord>> byEntity;
+
+        for (const DrawRecord& record : submitted)
+        {
+            byEntity[record.entity].push_back(record);
+        }
+
+        mapGroups = byEntity.size();
+    }
+
+    auto mapTime = steady_clock::now() - start;
+
+    // Flat arrays which keep their capacity, sorted by entity
+    start = steady_clock::now();
+
+    std::vector<DrawRecord> records;
+    std::vector<DrawRecord> scratch;
+    std::size_t sortedGroups = 0;
+
+    for (int frame = 0; frame < FRAMES; ++frame)
+    {
+        records.clear();
+        records.insert(records.end(), submitted.begin(), submitted.end());
+
+        util::radixSort(records, scratch, [](const DrawRecord& r)
+        {
+            return reinterpret_cast<std::uintptr_t>(r.entity);
+        });
+
+        sortedGroups = 1;
+
+        for (std::size_t i = 1; i < records.size(); ++i)
+        {
+            sortedGroups += records[i].entity != records[i - 1].entity ? 1 : 0;
+        }
+    }
+
+    auto sortTime = steady_clock::now() - start;
+
+    BOOST_TEST(sortedGroups == mapGroups);
+
+    BOOST_TEST_MESSAGE("Grouping " << NUM_RECORDS << " records by " << NUM_ENTITIES << " entities per frame: map "
+        << duration_cast<microseconds>(mapTime).count() / FRAMES << " us, radix sort "
+        << duration_cast<microseconds>(sortTime).count() / FRAMES << " us");
+}
+
+BOOST_AUTO_TEST_CASE(interactionUpdates)
+{
+    using namespace rendertest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    for (std::size_t numLights : { 50, 200, 600, 1000 })
+    {
+        // Keep the light density constant, bigger maps have more lights
+        double mapSize = 512 * std::cbrt(static_cast<double>(numLights));
+        Scene scene(numLights, 20 * numLights, mapSize);
+
+        // Initial calculation of all interactions
+        auto start = steady_clock::now();
+        scene.calculateAll();
+        auto indexedTime = steady_clock::now() - start;
+
+        // Reference: test every light against every object
+        start = steady_clock::now();
+        std::size_t numInteractions = 0;
+
+        for (const auto& object : scene.objects)
+        {
+            for (const auto& light : scene.lights)
+            {
+                numInteractions += object->intersectsLight(*light) ? 1 : 0;
+            }
+        }
+
+        auto linearTime = steady_clock::now() - start;
+
+        // Moving a single light, which used to recalculate all pairs
+        std::mt19937 random(11);
+        const std::size_t numMoves = 100;
+
+        start = steady_clock::now();
+
+        for (std::size_t i = 0; i < numMoves; ++i)
+        {
+            TestLight& light = *scene.lights[i % numLights];
+            light.setBounds(randomBox(random, mapSize, 400));
+            scene.interactions.lightChanged(light);
+
+            scene.calculateAll();
+        }
+
+        auto moveTime = steady_clock::now() - start;
+
+        scene.checkLights();
+
+        BOOST_TEST_MESSAGE(numLights << " lights, " << scene.objects.size() << " objects, "
+            << numInteractions << " interactions: all pairs "
+            << duration_cast<microseconds>(linearTime).count() << " us, indexed "
+            << duration_cast<microseconds>(indexedTime).count() << " us, moving one light "
+            << duration_cast<microseconds>(moveTime).count() / numMoves << " us");
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(parallelShaderParsing, shaderstest::GeneratedMaterialsFixture)
+{
+    using namespace shaderstest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    // Redirect the duplicate definition errors, they're expected
+    std::ostringstream errors;
+    GlobalErrorStream().setStream(errors);
+
+    RecordingShaderLibrary serial;
+
+    auto start = steady_clock::now();
+    parseShadersFromPath(fs, "materials/", serial);
+    auto serialTime = steady_clock::now() - start;
+
+    radiant::WorkStealingScheduler scheduler;
+    RecordingShaderLibrary parallel;
+
+    start = steady_clock::now();
+    parseShadersFromPath(fs, "materials/", parallel, &scheduler);
+    auto parallelTime = steady_clock::now() - start;
+
+    GlobalErrorStream().setStream(std::cerr);
+
+    // 249 files are repeating 5 materials of their predecessor, 50 tables are defined twice
+    BOOST_TEST(serial.shaderDefs.size() == numMaterials - 249 * 5);
+    BOOST_TEST(serial.tables.size() == 200);
+    BOOST_TEST(serial.numRejected == 249 * 5 + 50);
+
+    // Both loaders need to add the same definitions in the same order
+    BOOST_TEST_REQUIRE(parallel.addedNames.size() == serial.addedNames.size());
+    BOOST_TEST(parallel.addedNames == serial.addedNames);
+    BOOST_TEST(parallel.numRejected == serial.numRejected);
+
+    // The same file needs to win for the overridden materials
+    for (const auto& pair : serial.shaderDefs)
+    {
+        auto found = parallel.shaderDefs.find(pair.first);
+
+        BOOST_TEST_REQUIRE((found != parallel.shaderDefs.end()));
+        BOOST_TEST_REQUIRE(found->second.file.name == pair.second.file.name);
+    }
+
+    BOOST_TEST_MESSAGE("Parsed " << numMaterials << " materials in "
+        << duration_cast<milliseconds>(serialTime).count() << " ms sequentially, "
+        << duration_cast<milliseconds>(parallelTime).count() << " ms using "
+        << scheduler.getNumWorkers() << " workers");
+}
+
+BOOST_AUTO_TEST_CASE(decodeThroughput)
+{
+    using namespace shaderstest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    using std::chrono::duration_cast;
+
+    std::vector<Buffer> files;
+
+    for (std::size_t i = 0; i < 96; ++i)
+    {
+        files.push_back(createTGA(512, 512, static_cast<unsigned char>(i)));
+    }
+
+    // Reference: decode everything on the calling thread, as the texture
+    // manager did before
+    auto start = steady_clock::now();
+
+    std::size_t checksum = 0;
+
+    for (const Buffer& file : files)
+    {
+        checksum += getSeed(decodeTGA(file));
+    }
+
+    auto serialTime = steady_clock::now() - start;
+
+    radiant::WorkStealingScheduler scheduler;
+    shaders::TextureDecodeQueue queue(64);
+    queue.setTaskScheduler(&scheduler);
+
+    start = steady_clock::now();
+
+    std::size_t queuedChecksum = 0;
+
+    for (const Buffer& file : files)
+    {
+        queue.add([&]() { return decodeTGA(file); },
+                  [&](const ImagePtr& image) { queuedChecksum += getSeed(image); });
+    }
+
+    // Time until the first call returns, which used to block until the texture was loaded
+    auto addTime = steady_clock::now() - start;
+
+    queue.flush();
+
+    auto queuedTime = steady_clock::now() - start;
+
+    BOOST_TEST(queuedChecksum == checksum);
+
+    auto imagesPerSecond = [&](steady_clock::duration time)
+    {
+        return static_cast<long>(files.size() * 1000000 /
+            std::max<long long>(std::chrono::duration_cast<std::chrono::microseconds>(time).count(), 1));
+    };
+
+    BOOST_TEST_MESSAGE("Decoded " << files.size() << " 512x512 images: serial "
+        << duration_cast<milliseconds>(serialTime).count() << " ms ("
+        << imagesPerSecond(serialTime) << " images/s), " << scheduler.getNumWorkers() << " workers "
+        << duration_cast<milliseconds>(queuedTime).count() << " ms ("
+        << imagesPerSecond(queuedTime) << " images/s), queueing took "
+        << duration_cast<milliseconds>(addTime).count() << " ms");
+}
+
+BOOST_AUTO_TEST_CASE(residencyUpdates)
+{
+    using namespace shaderstest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    TextureResidency residency;
+
+    const std::size_t NUM_TEXTURES = 4000;
+
+    for (TextureResidency::TextureId id = 1; id <= NUM_TEXTURES; ++id)
+    {
+        addTexture(residency, id, MB);
+    }
+
+    residency.nextFrame();
+
+    // A camera moving through the map, each frame draws textures from a
+    // window sliding over the texture numbers
+    std::mt19937 random(42);
+
+    const std::size_t NUM_FRAMES = 100;
+    const std::size_t BINDS_PER_FRAME = 5000;
+    const std::size_t TEXTURES_PER_FRAME = 500;
+    const std::size_t WINDOW_STEP = 30;
+
+    residency.setBudget(NUM_TEXTURES * MB / 4);
+
+    auto start = steady_clock::now();
+    auto updateTime = steady_clock::duration::zero();
+
+    for (std::size_t frame = 0; frame < NUM_FRAMES; ++frame)
+    {
+        auto updateStart = steady_clock::now();
+
+        for (TextureResidency::TextureId id : residency.takeReloadRequests())
+        {
+            addTexture(residency, id, MB);
+        }
+
+        applyChanges(residency, residency.selectChanges());
+
+        updateTime += steady_clock::now() - updateStart;
+
+        BOOST_TEST_REQUIRE(residency.getResidentBytes() <= residency.getBudget());
+
+        residency.nextFrame();
+
+        std::uniform_int_distribution<std::size_t> pick(frame * WINDOW_STEP,
+                                                        frame * WINDOW_STEP + TEXTURES_PER_FRAME - 1);
+
+        for (std::size_t i = 0; i < BINDS_PER_FRAME; ++i)
+        {
+            residency.markUsed(static_cast<TextureResidency::TextureId>(pick(random) % NUM_TEXTURES + 1));
+        }
+    }
+
+    auto totalTime = steady_clock::now() - start;
+
+    BOOST_TEST_MESSAGE(NUM_FRAMES << " frames with " << BINDS_PER_FRAME << " binds of "
+        << NUM_TEXTURES << " textures: " << duration_cast<microseconds>(totalTime).count() / NUM_FRAMES
+        << " us per frame, updating the residency " << duration_cast<microseconds>(updateTime).count() / NUM_FRAMES
+        << " us per frame, " << residency.getNumReductions() << " reductions, "
+        << residency.getNumEvictions() << " evictions, " << residency.getNumReloads() << " reloads");
+}
+
+BOOST_AUTO_TEST_CASE(imageKernels)
+{
+    using namespace shaderstest;
+
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    const std::size_t SIZE = 1024;
+
+    Pixels one = createNoise(SIZE, SIZE, 7);
+    Pixels two = createNoise(SIZE, SIZE, 8);
+    Pixels small = createNoise(SIZE / 2, SIZE / 2, 9);
+    Pixels out(one.size());
+
+    auto time = [](const std::function<void()>& func)
+    {
+        auto start = steady_clock::now();
+
+        for (int i = 0; i < 3; ++i)
+        {
+            func();
+        }
+
+        return duration_cast<microseconds>(steady_clock::now() - start).count() / 3;
+    };
+
+    BOOST_TEST_MESSAGE(SIZE << "x" << SIZE << " images, heightmap / addnormals / smoothnormals / resample in us:");
+
+    forEachConfiguration([&](const std::string& config)
+    {
+        auto heightMap = time([&]() { kernels::heightMapToNormals(one.data(), out.data(), SIZE, SIZE, 1.0f); });
+        auto addNormals = time([&]() { kernels::average(one.data(), two.data(), out.data(), SIZE * SIZE, true); });
+        auto smoothNormals = time([&]() { kernels::smoothNormals(one.data(), out.data(), SIZE, SIZE); });
+        auto resample = time([&]() { kernels::resample(small.data(), SIZE / 2, SIZE / 2, out.data(), SIZE, SIZE); });
+
+        BOOST_TEST_MESSAGE(config << " " << heightMap << " / " << addNormals << " / "
+            << smoothNormals << " / " << resample);
+    });
+}
+
+BOOST_FIXTURE_TEST_CASE(animationPlayback, md5test::SkinningFixture)
+{
+    using namespace md5;
+    using namespace md5test;
+
+    using std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    using std::chrono::duration_cast;
+
+    // A number of animated entities using the same model, each with its own surfaces
+    const std::size_t NUM_ENTITIES = 16;
+    const std::size_t NUM_LOOPS = 2;
+
+    std::vector<const MD5Mesh*> surfaces;
+
+    for (std::size_t i = 0; i < NUM_ENTITIES; ++i)
+    {
+        for (const MD5Mesh& mesh : meshes)
+        {
+            surfaces.push_back(&mesh);
+        }
+    }
+
+    std::vector<MD5SkinningData> data;
+    std::vector<MD5SkinningBuffers> buffers(surfaces.size());
+    std::vector<std::vector<ArbitraryMeshVertex>> vertices(surfaces.size());
+    std::vector<AABB> bounds(surfaces.size());
+
+    for (const MD5Mesh* mesh : surfaces)
+    {
+        data.emplace_back(*mesh);
+    }
+
+    std::size_t numVertices = 0;
+
+    for (const MD5Mesh* mesh : surfaces)
+    {
+        numVertices += mesh->vertices.size();
+    }
+
+    std::size_t numUpdates = NUM_LOOPS * anim->getNumFrames();
+
+    MD5Skeleton skeleton;
+    MD5Pose pose;
+
+    // Plays the animation, returning the time per update in microseconds
+    auto play = [&](const std::function<void()>& skinAll)
+    {
+        auto start = steady_clock::now();
+
+        for (std::size_t update = 0; update < numUpdates; ++update)
+        {
+            skeleton.update(anim, getFrameTime(anim, update % anim->getNumFrames()));
+            pose.setFromSkeleton(skeleton);
+
+            skinAll();
+        }
+
+        return duration_cast<microseconds>(steady_clock::now() - start).count() / numUpdates;
+    };
+
+    auto skinSerially = [&]()
+    {
+        for (std::size_t i = 0; i < surfaces.size(); ++i)
+        {
+            data[i].skin(pose, buffers[i], vertices[i], bounds[i]);
+        }
+    };
+
+    skinning::setVectorised(false);
+    auto scalar = play(skinSerially);
+
+    skinning::setVectorised(true);
+    auto vectorised = play(skinSerially);
+
+    // The surfaces spread over the workers, like MD5Model::updateAnim() does
+    radiant::WorkStealingScheduler scheduler;
+    skinning::setTaskScheduler(&scheduler);
+
+    auto threaded = play([&]()
+    {
+        scheduler.parallelFor(surfaces.size(), [&](std::size_t i)
+        {
+            data[i].skin(pose, buffers[i], vertices[i], bounds[i]);
+        });
+    });
+
+    BOOST_TEST_MESSAGE(NUM_ENTITIES << " entities with " << numVertices << " vertices, "
+        << numUpdates << " animation updates, time per update: float " << scalar << " us, SSE2 " << vectorised << " us, SSE2 on "
+        << scheduler.getNumWorkers() << " workers " << threaded << " us");
+
+    // The last frame is still correct
+    std::vector<ArbitraryMeshVertex> expected;
+    AABB expectedBounds;
+    skinScalar(data.back(), pose, expected, expectedBounds);
+
+    checkVertices(vertices.back(), bounds.back(), expected, expectedBounds);
+}
+
+BOOST_FIXTURE_TEST_CASE(crowdPlayback, md5test::PoseCacheFixture)
+{
+    using namespace md5;
+    using namespace md5test;
+
+    // A room full of guards in the same idle animation
+    const std::size_t numSkeletons = 20;
+    const std::size_t numUpdates = 500;
+
+    auto playback = [&](const IMD5AnimPtr& anim)
+    {
+        std::vector<MD5Skeleton> skeletons(numSkeletons);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (std::size_t time = 0; time < numUpdates * 16; time += 16)
+        {
+            for (MD5Skeleton& skeleton : skeletons)
+            {
+                skeleton.update(anim, time);
+            }
+        }
+
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    MD5PoseCache::Instance().setCapacity(0);
+
+    double rawTime = playback(loadTentacleAnim(false));
+    double decodedTime = playback(loadTentacleAnim(true));
+
+    MD5PoseCache::Instance().setCapacity(512);
+
+    double cachedTime = playback(loadTentacleAnim(true));
+
+    BOOST_TEST_MESSAGE(numSkeletons << " skeletons, " << numUpdates << " updates: components "
+        << rawTime << "ms, decoded " << decodedTime << "ms, decoded and shared " << cachedTime << "ms");
+
+    BOOST_TEST(MD5PoseCache::Instance().getNumHits() >= numUpdates * (numSkeletons - 1));
+}
+
+namespace
+{
+    template<typename Func>
+    double measureMsec(Func func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(attributeStorage)
+{
+    using namespace eclass;
+    using namespace eclasstest;
+
+    std::vector<Def> defs = generateDefs(4000);
+    std::vector<std::string> keys = collectKeys(defs);
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+    keys.resize(2000);
+
+    StringPool::Instance().clear();
+
+    std::vector<TableClass> flattened;
+    double flattenedBuildTime = measureMsec([&]() { flattened = buildFlattenedClasses(defs); });
+
+    std::vector<TableClass> tables;
+    double tableBuildTime = measureMsec([&]() { tables = buildTableClasses(defs); });
+
+    std::size_t numCopied = 0;
+    std::size_t numOwn = 0;
+
+    for (std::size_t i = 0; i < defs.size(); ++i)
+    {
+        numCopied += flattened[i].attributes.size();
+        numOwn += tables[i].attributes.size();
+    }
+
+    std::size_t flattenedFound = 0;
+    std::size_t tableFound = 0;
+
+    double flattenedLookupTime = measureMsec([&]()
+    {
+        for (std::size_t i = 0; i < defs.size(); i += 4)
+        {
+            for (const std::string& key : keys)
+            {
+                flattenedFound += flattened[i].find(key) != nullptr ? 1 : 0;
+            }
+        }
+    });
+
+    double tableLookupTime = measureMsec([&]()
+    {
+        for (std::size_t i = 0; i < defs.size(); i += 4)
+        {
+            for (const std::string& key : keys)
+            {
+                tableFound += tables[i].find(key) != nullptr ? 1 : 0;
+            }
+        }
+    });
+
+    BOOST_TEST(tableFound == flattenedFound);
+
+    // Hot keys are queried for every class
+    const std::string hotKeys[] = { "editor_mins", "editor_maxs", "model", "spawnclass", "inherit" };
+
+    double flattenedHotTime = measureMsec([&]()
+    {
+        for (int repeat = 0; repeat < 20; ++repeat)
+        for (const TableClass& eclass : flattened)
+        for (const std::string& key : hotKeys)
+        {
+            flattenedFound += eclass.find(key) != nullptr ? 1 : 0;
+        }
+    });
+
+    double tableHotTime = measureMsec([&]()
+    {
+        for (int repeat = 0; repeat < 20; ++repeat)
+        for (const TableClass& eclass : tables)
+        for (const std::string& key : hotKeys)
+        {
+            tableFound += eclass.find(key) != nullptr ? 1 : 0;
+        }
+    });
+
+    BOOST_TEST(tableFound == flattenedFound);
+
+    BOOST_TEST_MESSAGE(defs.size() << " classes: copied attributes " << numCopied << " using "
+        << getMemoryUsage(flattened) / 1024 << " kB (built in " << flattenedBuildTime << "ms), own attributes "
+        << numOwn << " using " << getMemoryUsage(tables) / 1024 << " kB (built in " << tableBuildTime
+        << "ms), pooled strings " << StringPool::Instance().getMemoryUsage() / 1024 << " kB");
+    BOOST_TEST_MESSAGE("getAttribute: copied " << flattenedLookupTime << "ms, chained " << tableLookupTime
+        << "ms; hot keys: copied " << flattenedHotTime << "ms, chained " << tableHotTime << "ms");
+
+    BOOST_TEST(numOwn < numCopied);
+}
+
+BOOST_AUTO_TEST_CASE(recordedClicks)
+{
+    using namespace scenetest;
+
+    // A map with 25,600 brushes and a session of clicks from all over the place
+    const std::size_t roomsPerAxis = 40;
+
+    std::vector<TestBrushPtr> brushes = generateMap(roomsPerAxis);
+    std::vector<Click> clicks = recordClicks(roomsPerAxis, 2000);
+
+    scene::Octree octree;
+
+    for (const TestBrushPtr& brush : brushes)
+    {
+        octree.link(brush);
+    }
+
+    auto replay = [&](bool accelerated, std::vector<SelectionIntersection>& results)
+    {
+        TestBrush::numTested = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (const Click& click : clicks)
+        {
+            results.push_back(selectPoint(octree, click, accelerated));
+        }
+
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<SelectionIntersection> expected;
+    double fullTime = replay(false, expected);
+    std::size_t fullTested = TestBrush::numTested;
+
+    std::vector<SelectionIntersection> results;
+    double acceleratedTime = replay(true, results);
+    std::size_t acceleratedTested = TestBrush::numTested;
+
+    std::size_t numHits = 0;
+
+    for (std::size_t i = 0; i < clicks.size(); ++i)
+    {
+        // The nearest candidate is the same, regardless of the traversal
+        BOOST_TEST_REQUIRE(results[i].isValid() == expected[i].isValid());
+        BOOST_TEST_REQUIRE(results[i].depth() == expected[i].depth());
+        BOOST_TEST_REQUIRE(results[i].distance() == expected[i].distance());
+
+        if (results[i].isValid())
+        {
+            ++numHits;
+        }
+    }
+
+    BOOST_TEST(numHits > clicks.size() / 2);
+    BOOST_TEST(acceleratedTested < fullTested);
+
+    BOOST_TEST_MESSAGE(clicks.size() << " clicks into " << brushes.size() << " brushes: full traversal "
+        << fullTime << "ms (" << fullTested << " brushes tested), front to back with bounds "
+        << acceleratedTime << "ms (" << acceleratedTested << " brushes tested)");
+}
@@ -0,0 +1,656 @@
+#define BOOST_TEST_MODULE brushTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "MockModules.h"
+#include "BrushTestData.h"
+
+#include "radiant/brush/BrushModule.h"
+#include "radiant/brush/BrushNode.h"
+#include "plugins/script/SceneArrays.h"
+
+// Provide local implementations of the BrushModule accessors, the application
+// version needs the whole brush module. Texture lock is only used by transforms.
+BrushModuleImpl& GlobalBrush()
+{
+    throw std::logic_error("GlobalBrush() is not available in tests");
+}
+
+bool BrushModuleImpl::textureLockEnabled() const
+{
+    return false;
+}
+
+using namespace brushtest;
+
+namespace
+{
+    // The BrushNode attaches itself to the render system, the B-rep looks up the
+    // vertex colour and new faces read the default texture scale from the registry
+    // and notify the scenegraph. The scene arrays are changing the brushes through
+    // the undo system. These are the only modules the brush code is using.
+
+    struct ModuleFixture
+    {
+        MockModuleRegistry registry;
+
+        ModuleFixture()
+        {
+            registry.registerModule(std::make_shared<MockRegistry>());
+            registry.registerModule(std::make_shared<MockRenderSystem>());
+            registry.registerModule(std::make_shared<MockSceneGraph>());
+            registry.registerModule(std::make_shared<MockUIManager>());
+            registry.registerModule(std::make_shared<MockUndoSystem>());
+
+            module::RegistryReference::Instance().setRegistry(registry);
+
+            Brush::m_maxWorldCoord = 65536;
+        }
+    };
+
+    BOOST_GLOBAL_FIXTURE(ModuleFixture);
+
+    Face& findFace(Brush& brush, const Vector3& normal)
+    {
+        for (Brush::const_iterator i = brush.begin(); i != brush.end(); ++i)
+        {
+            if ((*i)->getPlane3().normal() == normal)
+            {
+                return **i;
+            }
+        }
+
+        throw std::logic_error("face not found");
+    }
+
+    std::vector<std::size_t> getRevisions(const Brush& brush)
+    {
+        std::vector<std::size_t> revisions;
+
+        for (Brush::const_iterator i = brush.begin(); i != brush.end(); ++i)
+        {
+            revisions.push_back((*i)->getWinding().getBatchRevision());
+        }
+
+        return revisions;
+    }
+
+    // The windings need to have the same vertices, allowing for a different starting vertex
+    void checkSameWindings(const Brush& brush, const Brush& expected)
+    {
+        BOOST_TEST_REQUIRE(brush.getNumFaces() == expected.getNumFaces());
+
+        for (std::size_t f = 0; f < brush.getNumFaces(); ++f)
+        {
+            const Winding& winding = (*(brush.begin() + f))->getWinding();
+            const Winding& other = (*(expected.begin() + f))->getWinding();
+
+            BOOST_TEST_REQUIRE(winding.size() == other.size());
+
+            for (std::size_t i = 0; i < winding.size(); ++i)
+            {
+                bool found = false;
+
+                for (std::size_t j = 0; j < other.size(); ++j)
+                {
+                    found |= (winding[i].vertex - other[j].vertex).getLength() < 0.001 &&
+                        winding[i].adjacent == other[j].adjacent &&
+                        (winding[i].texcoord - other[j].texcoord).getLength() < 0.001;
+                }
+
+                BOOST_TEST_REQUIRE(found);
+            }
+        }
+
+        BOOST_TEST(brush.localAABB().getOrigin() == expected.localAABB().getOrigin());
+        BOOST_TEST(brush.localAABB().getExtents() == expected.localAABB().getExtents());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unaffectedWindingsKeepTheirRevision)
+{
+    auto node = std::make_shared<BrushNode>();
+    Brush& brush = node->getBrush();
+
+    brush.constructCuboid(AABB(Vector3(0, 0, 0), Vector3(64, 64, 64)), "_default");
+    brush.evaluateBRep();
+
+    BOOST_TEST_REQUIRE(brush.getNumFaces() == 6);
+    BOOST_TEST(brush.localAABB().getExtents() == Vector3(64, 64, 64));
+
+    std::vector<std::size_t> before = getRevisions(brush);
+
+    // Nothing changed, nothing is touched
+    brush.evaluateBRep();
+    BOOST_TEST((getRevisions(brush) == before));
+
+    // Drag the +x face outwards, the -x face is not adjacent to it
+    Face& dragged = findFace(brush, Vector3(1, 0, 0));
+    Face& opposite = findFace(brush, Vector3(-1, 0, 0));
+
+    dragged.setPlane3(Plane3(Vector3(1, 0, 0), 96));
+    brush.evaluateBRep();
+
+    std::vector<std::size_t> after = getRevisions(brush);
+
+    for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
+    {
+        const Face& face = **(brush.begin() + i);
+
+        BOOST_TEST_INFO("face " << i);
+        BOOST_TEST((after[i] == before[i]) == (&face == &opposite));
+        BOOST_TEST(face.getWinding().size() == 4);
+    }
+
+    for (const WindingVertex& vertex : dragged.getWinding())
+    {
+        BOOST_TEST(vertex.vertex.x() == 96);
+    }
+
+    BOOST_TEST(brush.localAABB().getOrigin() == Vector3(16, 0, 0));
+    BOOST_TEST(brush.localAABB().getExtents() == Vector3(80, 64, 64));
+
+    // Shifting a texture only changes the texture coordinates of that face
+    before = after;
+    opposite.shiftTexdef(0.25f, 0);
+    brush.evaluateBRep();
+
+    after = getRevisions(brush);
+
+    for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
+    {
+        BOOST_TEST_INFO("face " << i);
+        BOOST_TEST((after[i] == before[i]) == ((brush.begin() + i)->get() != &opposite));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(incrementalBuildMatchesFullBuild)
+{
+    auto node = std::make_shared<BrushNode>();
+    Brush& brush = node->getBrush();
+
+    brush.constructPrism(AABB(Vector3(10, 20, 30), Vector3(64, 48, 32)), 7, 2, "_default");
+    brush.evaluateBRep();
+
+    BOOST_TEST_REQUIRE(brush.getNumFaces() == 9);
+
+    // Drag the faces in turn, some of them far enough to make others vanish
+    const double distances[] = { 8, -16, 40, -4, 120, -30, 2, -90, 16 };
+
+    for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
+    {
+        Face& face = **(brush.begin() + i);
+        Plane3 plane = face.getPlane3();
+
+        face.setPlane3(Plane3(plane.normal(), plane.dist() + distances[i]));
+        brush.evaluateBRep();
+
+        // The copy builds all of its windings from scratch
+        auto copy = std::make_shared<BrushNode>(*node);
+        copy->getBrush().evaluateBRep();
+
+        BOOST_TEST_INFO("after dragging face " << i);
+        checkSameWindings(brush, copy->getBrush());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(buildCuboidWindings)
+{
+    TestBrush brush;
+    addCuboidPlanes(brush.planes, AABB(Vector3(0, 0, 0), Vector3(64, 32, 16)));
+
+    BOOST_TEST(brush.build() == 6);
+
+    for (std::size_t i = 0; i < 6; ++i)
+    {
+        const IWinding& winding = brush.windings[i];
+        BOOST_TEST(winding.size() == 4);
+
+        // Each edge is adjacent to one of the side faces
+        for (const WindingVertex& vertex : winding)
+        {
+            BOOST_TEST(vertex.adjacent < 6);
+            BOOST_TEST(vertex.adjacent / 2 != i / 2);
+        }
+    }
+
+    // A duplicate plane doesn't contribute, nothing else is affected
+    brush.planes.push_back(brush.planes.front());
+    brush.builder.clear();
+    brush.build();
+
+    BOOST_TEST(brush.windings[0].empty());
+    BOOST_TEST(brush.windings[6].empty());
+    BOOST_TEST(brush.windings[1].size() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(incrementalWindingsMatchFullBuild)
+{
+    std::vector<TestBrush> brushes = generateBrushes(600);
+    std::mt19937 rng(31337);
+
+    std::size_t numReused = 0;
+
+    for (TestBrush& brush : brushes)
+    {
+        brush.build();
+
+        for (int round = 0; round < 10; ++round)
+        {
+            // Drag one of the faces, or move the whole brush now and then
+            if (round % 5 == 4)
+            {
+                Vector3 translation(int(rng() % 64) - 32, int(rng() % 64) - 32, 0);
+
+                for (Plane3& plane : brush.planes)
+                {
+                    plane = Plane3(plane.normal(), plane.dist() + plane.normal().dot(translation));
+                }
+            }
+            else
+            {
+                Plane3& plane = brush.planes[rng() % brush.planes.size()];
+                plane = Plane3(plane.normal(), plane.dist() + int(rng() % 48) - 24);
+            }
+
+            std::size_t numClipped = brush.build();
+            numReused += brush.planes.size() - numClipped;
+
+            TestBrush reference;
+            reference.planes = brush.planes;
+            reference.build();
+
+            checkSameWindings(brush.windings, reference.windings);
+        }
+    }
+
+    // Make sure the incremental path has actually been exercised
+    BOOST_TEST(numReused > 0);
+}
+
+namespace
+{
+    // The value following the given label, like "/* numVertices = */ 147"
+    std::size_t getCount(const std::string& output, const std::string& label)
+    {
+        std::string prefix = "/* " + label + " = */ ";
+        std::size_t pos = output.find(prefix);
+        BOOST_TEST_REQUIRE(pos != std::string::npos);
+
+        return std::stoul(output.substr(pos + prefix.length()));
+    }
+
+    // The edge lists of the exported polygons, like "4 ( 5 6 7 8 )"
+    std::vector<std::string> getPolygonEdges(const std::string& output)
+    {
+        std::vector<std::string> polygons;
+
+        std::size_t start = output.find("\tpolygons {\n");
+        std::size_t end = output.find("\t}\n", start);
+        BOOST_TEST_REQUIRE(end != std::string::npos);
+
+        std::istringstream stream(output.substr(start, end - start));
+        std::string line;
+        std::getline(stream, line);
+
+        while (std::getline(stream, line))
+        {
+            polygons.push_back(line.substr(1, line.find(')')));
+        }
+
+        return polygons;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(touchingCuboids)
+{
+    // Two cuboids on top of each other
+    std::string output = exportModel(generateGrid(1));
+
+    BOOST_TEST(getCount(output, "numVertices") == 12);
+    BOOST_TEST(getCount(output, "numEdges") == 21);
+    BOOST_TEST(getCount(output, "brushMemory") == 280);
+
+    // The shared face is dropped, the edges are referenced in both directions
+    std::vector<std::string> expected =
+    {
+        "4 ( 5 6 7 8 )", "4 ( 9 -3 10 -5 )", "4 ( -10 -2 11 -6 )", "4 ( -11 -1 12 -7 )",
+        "4 ( -12 -4 -9 -8 )", "4 ( 13 14 15 16 )", "4 ( 17 -15 18 3 )", "4 ( -18 -14 19 2 )",
+        "4 ( -19 -13 20 1 )", "4 ( -20 -16 -17 4 )",
+    };
+
+    BOOST_TEST(getPolygonEdges(output) == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(degenerateWindings)
+{
+    // The first brush is the one with the degenerate windings
+    std::string output = exportModel({ generateRandomBrushes(0).front() });
+
+    BOOST_TEST(getCount(output, "numVertices") == 3);
+    BOOST_TEST(getCount(output, "numEdges") == 5);
+
+    // Edges from a vertex to itself are kept, the reversed winding cancels out its twin
+    BOOST_TEST(output.find("\t/* 4 */ ( 0 0 ) 0 2\n") != std::string::npos);
+
+    std::vector<std::string> expected = { "3 ( 1 2 3 )", "4 ( -1 1 -1 1 )" };
+    BOOST_TEST(getPolygonEdges(output) == expected, boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(gridOutput)
+{
+    std::string output = exportModel(generateGrid(6));
+
+    // The faces between the cuboids cancel out, this leaves the outer hull
+    BOOST_TEST(getCount(output, "numVertices") == 147);
+    BOOST_TEST(getCount(output, "numEdges") == 351);
+    BOOST_TEST(getCount(output, "brushMemory") == 10080);
+    BOOST_TEST(getPolygonEdges(output).size() == 120);
+}
+
+BOOST_AUTO_TEST_CASE(randomOutput)
+{
+    std::string output = exportModel(generateRandomBrushes(300));
+
+    BOOST_TEST(getCount(output, "numVertices") == 3811);
+    BOOST_TEST(getCount(output, "numEdges") == 5746);
+    BOOST_TEST(getCount(output, "brushMemory") == 53356);
+    BOOST_TEST(getPolygonEdges(output).size() == 2505);
+}
+
+namespace
+{
+    using namespace script;
+
+    // Two undoable cuboids, with an empty node between them
+    struct BrushesFixture
+    {
+        MockMapFileChangeTracker tracker;
+        std::vector<std::shared_ptr<BrushNode>> brushes;
+        std::vector<scene::INodePtr> nodes;
+
+        BrushesFixture()
+        {
+            GlobalUndoSystem().clear();
+
+            for (double x : { 0, 256 })
+            {
+                auto node = std::make_shared<BrushNode>();
+
+                node->getBrush().constructCuboid(AABB(Vector3(x, 0, 0), Vector3(64, 64, 64)), "_default");
+                node->getBrush().evaluateBRep();
+                node->getBrush().connectUndoSystem(tracker);
+
+                brushes.push_back(node);
+                nodes.push_back(node);
+                nodes.push_back(scene::INodePtr());
+            }
+
+            nodes.pop_back();
+        }
+
+        ~BrushesFixture()
+        {
+            for (const auto& brush : brushes)
+            {
+                brush->getBrush().disconnectUndoSystem(tracker);
+            }
+
+            GlobalUndoSystem().clear();
+        }
+    };
+
+    std::vector<double> getFacePlanes(const std::vector<scene::INodePtr>& nodes)
+    {
+        std::vector<double> planes;
+
+        arrays::foreachFace(nodes, [&](IFace& face, std::size_t)
+        {
+            const Plane3& plane = face.getPlane3();
+            planes.insert(planes.end(), { plane.normal().x(), plane.normal().y(), plane.normal().z(), plane.dist() });
+        });
+
+        return planes;
+    }
+
+    void checkSamePlanes(const std::vector<double>& planes, const std::vector<double>& expected)
+    {
+        BOOST_TEST_REQUIRE(planes.size() == expected.size());
+
+        for (std::size_t i = 0; i < planes.size(); ++i)
+        {
+            BOOST_TEST_INFO("component " << i);
+            BOOST_TEST(std::abs(planes[i] - expected[i]) < 0.001);
+        }
+    }
+
+    // Collects the [V,5] vertices and [F+1] offsets like getWindings()
+    void getWindings(const std::vector<scene::INodePtr>& nodes, std::vector<double>& vertices,
+                     std::vector<std::int64_t>& offsets)
+    {
+        offsets.assign(1, 0);
+
+        for (const scene::INodePtr& node : nodes)
+        {
+            if (node) node->localAABB();
+        }
+
+        arrays::foreachFace(nodes, [&](IFace& face, std::size_t)
+        {
+            for (const WindingVertex& w : face.getWinding())
+            {
+                vertices.insert(vertices.end(), { w.vertex.x(), w.vertex.y(), w.vertex.z(), w.texcoord.x(), w.texcoord.y() });
+            }
+
+            offsets.push_back(vertices.size() / 5);
+        });
+    }
+
+    arrays::DoubleArrayView view(const std::vector<double>& data, std::vector<std::size_t> shape)
+    {
+        return arrays::DoubleArrayView{ data.data(), shape };
+    }
+
+    arrays::IndexArrayView view(const std::vector<std::int64_t>& data)
+    {
+        return arrays::IndexArrayView{ data.data(), { data.size() } };
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(invalidShapesChangeNothing, BrushesFixture)
+{
+    BOOST_TEST_REQUIRE(arrays::countFaces(nodes) == 12);
+
+    std::vector<double> before = getFacePlanes(nodes);
+    std::vector<double> data(12 * 6, 1.0);
+
+    BOOST_CHECK_THROW(arrays::setFacePlanes(nodes, view(data, { 12, 3 })), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setFacePlanes(nodes, view(data, { 11, 4 })), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setFacePlanes(nodes, view(data, { 48 })), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setTexDefMatrices(nodes, view(data, { 12, 3, 2 })), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setTexDefMatrices(nodes, view(data, { 6, 2, 3 })), std::invalid_argument);
+
+    // One entry per node, the empty node included
+    std::vector<arrays::DoubleArrayView> controls(2, arrays::DoubleArrayView{ NULL, {} });
+    BOOST_CHECK_THROW(arrays::setPatchControls(nodes, controls), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setSpawnargs(nodes, "name", { "a", "b" }), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setSpawnargVectors(nodes, "origin", view(data, { 3, 2, 1 })), std::invalid_argument);
+    BOOST_CHECK_THROW(arrays::setSpawnargVectors(nodes, "origin", view(data, { 4, 3 })), std::invalid_argument);
+
+    std::vector<double> vertices;
+    std::vector<std::int64_t> offsets;
+    getWindings(nodes, vertices, offsets);
+
+    std::size_t numVertices = vertices.size() / 5;
+
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices / 2, 10 }), view(offsets)),
+                      std::invalid_argument);
+
+    std::vector<std::int64_t> tooFew(offsets.begin(), offsets.end() - 1);
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(tooFew)),
+                      std::invalid_argument);
+
+    // The offsets need to cover all vertices
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices - 1, 5 }), view(offsets)),
+                      std::invalid_argument);
+
+    // Windings with less than three vertices, or descending offsets
+    std::vector<std::int64_t> broken = offsets;
+    broken[5] = broken[4] + 2;
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(broken)),
+                      std::invalid_argument);
+
+    broken[5] = broken[6] + 4;
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(broken)),
+                      std::invalid_argument);
+
+    // Collapse the last winding onto a line parallel to the x axis
+    std::vector<double> collinear = vertices;
+    for (std::size_t v = offsets[11]; v < numVertices; ++v)
+    {
+        collinear[v * 5 + 1] = collinear[offsets[11] * 5 + 1];
+        collinear[v * 5 + 2] = collinear[offsets[11] * 5 + 2];
+    }
+
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(collinear, { numVertices, 5 }), view(offsets)),
+                      std::invalid_argument);
+
+    checkSamePlanes(getFacePlanes(nodes), before);
+    BOOST_TEST(GlobalUndoSystem().size() == 0);
+    BOOST_TEST(!GlobalUndoSystem().operationStarted());
+    BOOST_TEST(tracker.changes() == 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(invalidWindingOffsetsChangeNothing, BrushesFixture)
+{
+    std::vector<double> before = getFacePlanes(nodes);
+
+    std::vector<double> vertices;
+    std::vector<std::int64_t> offsets;
+    getWindings(nodes, vertices, offsets);
+
+    std::size_t numVertices = vertices.size() / 5;
+
+    // Offsets past the end of the vertex array
+    std::vector<std::int64_t> broken = offsets;
+    broken[1] = numVertices + 100;
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(broken)),
+                      std::invalid_argument);
+
+    // Offsets before the start of the vertex array
+    broken = offsets;
+    broken[6] = -4;
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(broken)),
+                      std::invalid_argument);
+
+    // Decreasing offsets
+    broken = offsets;
+    std::swap(broken[8], broken[9]);
+    BOOST_CHECK_THROW(arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(broken)),
+                      std::invalid_argument);
+
+    checkSamePlanes(getFacePlanes(nodes), before);
+    BOOST_TEST(GlobalUndoSystem().size() == 0);
+    BOOST_TEST(tracker.changes() == 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(setFacePlanesIsOneUndoOperation, BrushesFixture)
+{
+    std::vector<double> before = getFacePlanes(nodes);
+    std::vector<double> planes = before;
+
+    // Push all faces outwards
+    for (std::size_t row = 0; row < 12; ++row)
+    {
+        planes[row * 4 + 3] += 8;
+    }
+
+    arrays::setFacePlanes(nodes, view(planes, { 12, 4 }));
+
+    checkSamePlanes(getFacePlanes(nodes), planes);
+    BOOST_TEST(nodes[0]->localAABB().getExtents() == Vector3(72, 72, 72));
+    BOOST_TEST(GlobalUndoSystem().size() == 1);
+
+    GlobalUndoSystem().undo();
+
+    checkSamePlanes(getFacePlanes(nodes), before);
+    BOOST_TEST(nodes[2]->localAABB().getExtents() == Vector3(64, 64, 64));
+}
+
+BOOST_FIXTURE_TEST_CASE(setWindingsRebuildsThePlanes, BrushesFixture)
+{
+    std::vector<double> before = getFacePlanes(nodes);
+
+    std::vector<double> vertices;
+    std::vector<std::int64_t> offsets;
+    getWindings(nodes, vertices, offsets);
+
+    std::size_t numVertices = vertices.size() / 5;
+
+    // Writing back the unchanged windings keeps the planes
+    arrays::setWindings(nodes, view(vertices, { numVertices, 5 }), view(offsets));
+    checkSamePlanes(getFacePlanes(nodes), before);
+
+    // Move the +x face of the first brush, the vertices only
+    std::vector<double> moved;
+    std::size_t movedFace = 0;
+
+    for (std::size_t v = 0; v < numVertices; ++v)
+    {
+        moved.insert(moved.end(), vertices.begin() + v * 5, vertices.begin() + v * 5 + 3);
+    }
+
+    arrays::foreachFace(nodes, [&](IFace& face, std::size_t row)
+    {
+        if (row < 6 && face.getPlane3().normal() == Vector3(1, 0, 0))
+        {
+            movedFace = row;
+        }
+    });
+
+    for (std::int64_t v = offsets[movedFace]; v < offsets[movedFace + 1]; ++v)
+    {
+        moved[v * 3] += 16;
+    }
+
+    arrays::setWindings(nodes, view(moved, { numVertices, 3 }), view(offsets));
+
+    std::vector<double> expected = before;
+    expected[movedFace * 4 + 3] += 16;
+
+    checkSamePlanes(getFacePlanes(nodes), expected);
+    BOOST_TEST(nodes[0]->localAABB().getExtents() == Vector3(72, 64, 64));
+    BOOST_TEST(GlobalUndoSystem().size() == 2);
+
+    GlobalUndoSystem().undo();
+    checkSamePlanes(getFacePlanes(nodes), before);
+}
+
+BOOST_FIXTURE_TEST_CASE(settersJoinARunningOperation, BrushesFixture)
+{
+    std::vector<double> before = getFacePlanes(nodes);
+    std::vector<double> planes = before;
+    std::vector<double> matrices(12 * 6, 0.5);
+
+    for (std::size_t row = 0; row < 12; ++row)
+    {
+        planes[row * 4 + 3] -= 8;
+    }
+
+    // Like a script run from the script window
+    GlobalUndoSystem().start();
+
+    arrays::setFacePlanes(nodes, view(planes, { 12, 4 }));
+    arrays::setTexDefMatrices(nodes, view(matrices, { 12, 2, 3 }));
+
+    BOOST_TEST(GlobalUndoSystem().operationStarted());
+    GlobalUndoSystem().finish("runScript");
+
+    BOOST_TEST(GlobalUndoSystem().size() == 1);
+
+    GlobalUndoSystem().undo();
+    checkSamePlanes(getFacePlanes(nodes), before);
+}
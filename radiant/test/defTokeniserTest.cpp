@@ -0,0 +1,142 @@
+#define BOOST_TEST_MODULE defTokeniserTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <random>
+#include <sstream>
+
+#include "parser/BufferDefTokeniser.h"
+
+namespace
+{
+    template<typename Tokeniser>
+    std::vector<std::string> collectTokens(Tokeniser& tok)
+    {
+        std::vector<std::string> tokens;
+
+        while (tok.hasMoreTokens())
+        {
+            tokens.push_back(tok.nextToken());
+        }
+
+        return tokens;
+    }
+
+    // Returns the tokens of the BasicDefTokeniser and the BufferDefTokeniser
+    // for the given input, plus the exception messages (if any)
+    void tokeniseBoth(const std::string& input,
+                      std::vector<std::string>& expected, std::string& expectedError,
+                      std::vector<std::string>& actual, std::string& actualError)
+    {
+        try
+        {
+            parser::BasicDefTokeniser<std::string> tok(input);
+            expected = collectTokens(tok);
+        }
+        catch (const parser::ParseException& ex)
+        {
+            expectedError = ex.what();
+        }
+
+        try
+        {
+            parser::BufferDefTokeniser tok(input);
+            actual = collectTokens(tok);
+        }
+        catch (const parser::ParseException& ex)
+        {
+            actualError = ex.what();
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tokeniseLikeBasicDefTokeniser)
+{
+    const char* inputs[] = {
+        "",
+        "   \n\t  ",
+        "textures/common/caulk { map _white }",
+        "\"quoted string\" unquoted\"quote\"",
+        "\"escaped \\\"quotes\\\" \\n and \\t tabs \\x\"",
+        "\"multi\" \\ \"line\" \\\n  \"string\"",
+        "// line comment\ntoken /* delimited ** comment */ another",
+        "token//comment\nnext token/*comment*/next",
+        "a/b/c /",
+        "\"\" \"\"",
+        "\"unterminated",
+        "\"broken\" \\ continuation",
+        "( 0 0 1 -604 ) ( ( 0.015625 0 255.9375 ) )",
+    };
+
+    for (const char* input : inputs)
+    {
+        std::vector<std::string> expected, actual;
+        std::string expectedError, actualError;
+
+        tokeniseBoth(input, expected, expectedError, actual, actualError);
+
+        BOOST_TEST(actual == expected);
+        BOOST_TEST(actualError == expectedError);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tokeniseRandomInput)
+{
+    // Random strings built from the characters with special meaning
+    const std::string alphabet = "ab1. \n\t\"\"\\//**{}()";
+    std::mt19937 rng(4711);
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::string input;
+        std::size_t length = rng() % 32;
+
+        for (std::size_t c = 0; c < length; ++c)
+        {
+            input += alphabet[rng() % alphabet.length()];
+        }
+
+        std::vector<std::string> expected, actual;
+        std::string expectedError, actualError;
+
+        tokeniseBoth(input, expected, expectedError, actual, actualError);
+
+        BOOST_TEST_REQUIRE((actual == expected && actualError == expectedError),
+                           "Mismatch for input: " << input);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(customDelimiters)
+{
+    std::string input = "translate time * 0.125, 0.25";
+
+    parser::BasicDefTokeniser<std::string> expected(input, parser::WHITESPACE, "{}(),");
+    parser::BufferDefTokeniser actual(input, parser::WHITESPACE, "{}(),");
+
+    BOOST_TEST(collectTokens(actual) == collectTokens(expected));
+}
+
+BOOST_AUTO_TEST_CASE(tokenViews)
+{
+    std::string input = "brushDef3 ( -0.5 1e3 abc ) \"esc\\\"aped\"";
+    parser::BufferDefTokeniser tok(input);
+
+    // Unquoted tokens reference the input buffer
+    parser::TokenView keyword = tok.nextTokenView();
+    BOOST_TEST(keyword == "brushDef3");
+    BOOST_TEST(keyword.data == input.data());
+
+    BOOST_TEST(tok.peekView() == std::string("("));
+    tok.assertNextToken("(");
+
+    BOOST_TEST(tok.nextFloat() == -0.5f);
+    BOOST_TEST(tok.nextDouble() == 1000.0);
+    BOOST_TEST(tok.nextFloat() == 0.0f); // not a number, atof semantics
+
+    BOOST_CHECK_THROW(tok.assertNextToken("}"), parser::ParseException);
+
+    // Tokens with escape sequences are assembled, and still valid after the next call
+    parser::TokenView escaped = tok.nextTokenView();
+    BOOST_TEST(escaped == "esc\"aped");
+    BOOST_TEST(!tok.hasMoreTokens());
+    BOOST_CHECK_THROW(tok.nextTokenView(), parser::ParseException);
+}
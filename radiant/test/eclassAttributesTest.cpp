@@ -0,0 +1,148 @@
+#define BOOST_TEST_MODULE eclassAttributesTest
+#include <boost/test/included/unit_test.hpp>
+
+#include "eclassmgr/AttributeTable.h"
+#include "string/case_conv.h"
+#include "string/string.h"
+#include "EClassTestData.h"
+
+using namespace eclass;
+using namespace eclasstest;
+
+BOOST_AUTO_TEST_CASE(attributesIgnoreCase)
+{
+    AttributeTable table;
+
+    BOOST_TEST(table.insert(EntityClassAttribute("text", "Health", "100")).second);
+    BOOST_TEST(table.insert(EntityClassAttribute("text", "acuity", "50")).second);
+    BOOST_TEST(table.insert(EntityClassAttribute("text", "editor_usage", "Guard")).second);
+
+    // The existing attribute is returned for names differing in case only
+    std::pair<EntityClassAttribute*, bool> result = table.insert(EntityClassAttribute("text", "HEALTH", "200"));
+
+    BOOST_TEST(!result.second);
+    BOOST_TEST(result.first->getValue() == "100");
+    BOOST_TEST(table.size() == 3);
+
+    BOOST_TEST(AttributeTable::hashName("Editor_Usage") == AttributeTable::hashName("editor_usage"));
+
+    BOOST_TEST_REQUIRE(table.find("health") != nullptr);
+    BOOST_TEST(table.find("health")->getValue() == "100");
+    BOOST_TEST(table.find("EDITOR_USAGE")->getValue() == "Guard");
+    BOOST_TEST(table.find("editor") == nullptr);
+    BOOST_TEST(table.find("zzz") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(hotKeysFollowInsertions)
+{
+    BOOST_TEST(AttributeTable::getHotKey("Model") == AttributeTable::MODEL);
+    BOOST_TEST(AttributeTable::getHotKey("editor_MAXS") == AttributeTable::EDITOR_MAXS);
+    BOOST_TEST(AttributeTable::getHotKey("models") == AttributeTable::NO_HOT_KEY);
+    BOOST_TEST(AttributeTable::getHotKey("editor_minz") == AttributeTable::NO_HOT_KEY);
+
+    AttributeTable table;
+
+    table.insert(EntityClassAttribute("text", "model", "models/guard.lwo"));
+    table.insert(EntityClassAttribute("text", "inherit", "atdm:ai_base"));
+
+    BOOST_TEST(table.find(AttributeTable::SPAWNCLASS) == nullptr);
+
+    // Insert in front of the hot keys, moving them back
+    table.insert(EntityClassAttribute("text", "acuity", "50"));
+    table.insert(EntityClassAttribute("text", "editor_mins", "-16 -16 0"));
+    table.insert(EntityClassAttribute("text", "spawnclass", "idAI"));
+
+    BOOST_TEST_REQUIRE(table.find(AttributeTable::MODEL) != nullptr);
+    BOOST_TEST(table.find(AttributeTable::MODEL)->getValue() == "models/guard.lwo");
+    BOOST_TEST(table.find(AttributeTable::INHERIT)->getValue() == "atdm:ai_base");
+    BOOST_TEST(table.find(AttributeTable::EDITOR_MINS)->getValue() == "-16 -16 0");
+    BOOST_TEST(table.find(AttributeTable::SPAWNCLASS)->getValue() == "idAI");
+    BOOST_TEST(table.find(AttributeTable::EDITOR_MAXS) == nullptr);
+
+    table.clear();
+
+    BOOST_TEST(table.find(AttributeTable::MODEL) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(stringPoolSharesStrings)
+{
+    StringPool pool;
+
+    EntityClassAttribute first = pool.createAttribute("text", "health", "100", "");
+    EntityClassAttribute second = pool.createAttribute("text", "team", "100", "");
+
+    BOOST_TEST(first.getTypeRef() == second.getTypeRef());
+    BOOST_TEST(first.getValueRef() == second.getValueRef());
+    BOOST_TEST(first.getDescriptionRef() == second.getDescriptionRef());
+    BOOST_TEST(first.getNameRef() != second.getNameRef());
+    BOOST_TEST(pool.size() == 5);
+
+    // Replaced values are dropped
+    second.setValue(pool.intern("1"));
+    second = first;
+
+    pool.removeUnused();
+
+    BOOST_TEST(pool.size() == 4);
+    BOOST_TEST(pool.intern("team").use_count() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(lookupFollowsInheritance)
+{
+    std::vector<Def> defs = generateDefs(500);
+
+    std::vector<Spawnargs> resolved = resolveSpawnargs(defs);
+    std::vector<TableClass> tables = buildTableClasses(defs);
+
+    for (const std::string& key : collectKeys(defs))
+    {
+        for (std::size_t i = 0; i < defs.size(); i += 7)
+        {
+            auto expected = resolved[i].find(key);
+            const EntityClassAttribute* attribute = tables[i].find(string::to_upper_copy(key));
+
+            BOOST_TEST_REQUIRE((attribute != nullptr) == (expected != resolved[i].end()));
+
+            if (attribute != nullptr)
+            {
+                BOOST_TEST(attribute->getValue() == expected->second);
+            }
+        }
+    }
+
+    // Class 5 inherits from class 1, which inherits from the root class
+    BOOST_TEST(tables[5].find("inherit")->getValue() == "atdm:Class_1");
+    BOOST_TEST(tables[1].find("inherit")->getValue() == "atdm:Class_0");
+    BOOST_TEST(tables[0].find("inherit") == nullptr);
+    BOOST_TEST(tables[5].find("key_0_3")->getValue() == tables[0].find("key_0_3")->getValue());
+    BOOST_TEST(tables[5].find("key_5_3") != nullptr);
+    BOOST_TEST(tables[1].find("key_5_3") == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(ownAttributesUseLessMemory)
+{
+    std::vector<Def> defs = generateDefs(100);
+
+    StringPool::Instance().clear();
+
+    std::vector<TableClass> tables = buildTableClasses(defs);
+    std::size_t tableBytes = getMemoryUsage(tables);
+    std::size_t poolBytes = StringPool::Instance().getMemoryUsage();
+
+    // Copying the inherited attributes doesn't add any strings to the pool
+    std::vector<TableClass> flattened = buildFlattenedClasses(defs);
+
+    BOOST_TEST(StringPool::Instance().getMemoryUsage() == poolBytes);
+    BOOST_TEST(getMemoryUsage(flattened) > 2 * tableBytes);
+
+    // A string is pooled only once, no matter how many attributes use it
+    StringPool pool;
+    pool.createAttribute("text", "health", "100", "");
+    std::size_t bytes = pool.getMemoryUsage();
+
+    pool.createAttribute("text", "health", "100", "");
+    BOOST_TEST(pool.getMemoryUsage() == bytes);
+
+    pool.createAttribute("text", "team", "100", "");
+    BOOST_TEST(pool.getMemoryUsage() > bytes);
+}
@@ -0,0 +1,98 @@
+#define BOOST_TEST_MODULE filterRulesTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <regex>
+
+#include "radiant/filters/RuleMatcher.h"
+#include "radiant/filters/XMLFilter.h"
+#include "radiant/filters/FilterMask.h"
+
+namespace
+{
+    const std::vector<std::string> EXPRESSIONS =
+    {
+        "", "caulk", "func_static", "textures/common/caulk", "textures/common/.*", ".*",
+        "light.*", "atdm:ai_.*", "func_.*_door", "textures/(common|editor)/.*", "patch",
+        "models/darkmod/.*\\.lwo", "textures/darkmod/nodraw\\.", "a\\.*", "[a-z]+", "0\\d",
+        "trigger_.*|info_.*", "^light$", "textures/.*/caulk",
+    };
+
+    const std::vector<std::string> VALUES =
+    {
+        "", "caulk", "Caulk", "func_static", "func_static2", "textures/common/caulk",
+        "textures/common/", "textures/common", "textures/editor/clip", "light", "light_moveable",
+        "atdm:ai_builder_guard", "func_rotating_door", "func_door", "patch", "brush",
+        "models/darkmod/chair.lwo", "models/darkmod/chairxlwo", "textures/darkmod/nodraw.",
+        "a", "a...", "abc", "07", "0a", "trigger_once", "info_player_start", "textures/common\\ncaulk",
+        "light\nwith a line break", "textures/darkmod/stone/caulk",
+    };
+}
+
+BOOST_AUTO_TEST_CASE(matcherAgreesWithRegex)
+{
+    for (const std::string& expression : EXPRESSIONS)
+    {
+        filters::RuleMatcher matcher(expression);
+        std::regex regex(expression);
+
+        for (const std::string& value : VALUES)
+        {
+            BOOST_TEST(matcher.matches(value) == std::regex_match(value, regex),
+                "Expression \"" << expression << "\" and value \"" << value << "\"");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(invalidExpressionMatchesNothing)
+{
+    filters::RuleMatcher matcher("textures/(common");
+
+    BOOST_TEST(!matcher.matches("textures/(common"));
+    BOOST_TEST(!matcher.matches("textures/common"));
+}
+
+BOOST_AUTO_TEST_CASE(laterRulesOverrideEarlierOnes)
+{
+    filters::XMLFilter filter("Caulk", true);
+
+    filter.addRule(FilterRule::TYPE_TEXTURE, "textures/common/.*", false);
+    filter.addRule(FilterRule::TYPE_TEXTURE, "textures/common/caulk", true);
+    filter.addRule(FilterRule::TYPE_OBJECT, "patch", false);
+
+    BOOST_TEST(!filter.isVisible(FilterRule::TYPE_TEXTURE, "textures/common/nodraw"));
+    BOOST_TEST(filter.isVisible(FilterRule::TYPE_TEXTURE, "textures/common/caulk"));
+    BOOST_TEST(filter.isVisible(FilterRule::TYPE_TEXTURE, "textures/darkmod/stone"));
+
+    // Rules of other types don't apply
+    BOOST_TEST(filter.isVisible(FilterRule::TYPE_TEXTURE, "patch"));
+    BOOST_TEST(!filter.isVisible(FilterRule::TYPE_OBJECT, "patch"));
+
+    // Replacing the ruleset recompiles the expressions
+    FilterRules rules;
+    rules.push_back(FilterRule::Create(FilterRule::TYPE_TEXTURE, "textures/darkmod/.*", false));
+    filter.setRules(rules);
+
+    BOOST_TEST(filter.isVisible(FilterRule::TYPE_TEXTURE, "textures/common/nodraw"));
+    BOOST_TEST(!filter.isVisible(FilterRule::TYPE_TEXTURE, "textures/darkmod/stone"));
+    BOOST_TEST(filter.isVisible(FilterRule::TYPE_OBJECT, "patch"));
+}
+
+BOOST_AUTO_TEST_CASE(filterMaskIntersection)
+{
+    filters::FilterMask hiding;
+    hiding.set(3);
+    hiding.set(70);
+
+    filters::FilterMask active;
+    BOOST_TEST(!hiding.intersects(active));
+
+    active.set(4);
+    active.set(100);
+    BOOST_TEST(!hiding.intersects(active));
+
+    active.set(70);
+    BOOST_TEST(hiding.intersects(active));
+    BOOST_TEST(active.test(70));
+    BOOST_TEST(!active.test(3));
+    BOOST_TEST(!active.test(1000));
+}
@@ -0,0 +1,708 @@
+#define BOOST_TEST_MODULE mapTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <fstream>
+#include <future>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "MockModules.h"
+#include "MapTestData.h"
+
+#include "ibrush.h"
+#include "ieclass.h"
+#include "ientity.h"
+#include "ipatch.h"
+#include "scene/Node.h"
+
+#include "radiant/brush/BrushModule.h"
+#include "radiant/brush/BrushNode.h"
+#include "radiant/map/AutoSaveWriter.h"
+#include "radiant/map/format/Doom3MapReader.h"
+#include "radiant/map/format/ParallelMapTokeniser.h"
+#include "radiant/map/format/ParallelMapWriter.h"
+#include "radiant/map/format/primitivewriters/DoubleWriter.h"
+#include "radiant/WorkStealingScheduler.h"
+
+// Provide local implementations of the BrushModule accessors, the application
+// version needs the whole brush module. Texture lock is only used by transforms.
+BrushModuleImpl& GlobalBrush()
+{
+    throw std::logic_error("GlobalBrush() is not available in tests");
+}
+
+bool BrushModuleImpl::textureLockEnabled() const
+{
+    return false;
+}
+
+using namespace maptest;
+
+namespace
+{
+    // Entity storing its spawnargs in the order they have been set
+    class RecordingEntity :
+        public Entity
+    {
+        KeyValuePairs _keyValues;
+
+    public:
+        IEntityClassPtr getEntityClass() const override { return IEntityClassPtr(); }
+
+        void forEachKeyValue(const KeyValueVisitFunctor& visitor) const override
+        {
+            for (const auto& pair : _keyValues)
+            {
+                visitor(pair.first, pair.second);
+            }
+        }
+
+        void forEachEntityKeyValue(const EntityKeyValueVisitFunctor& visitor) override {}
+
+        void setKeyValue(const std::string& key, const std::string& value) override
+        {
+            _keyValues.push_back(std::make_pair(key, value));
+        }
+
+        std::string getKeyValue(const std::string& key) const override
+        {
+            for (const auto& pair : _keyValues)
+            {
+                if (pair.first == key) return pair.second;
+            }
+
+            return std::string();
+        }
+
+        bool isInherited(const std::string& key) const override { return false; }
+        KeyValuePairs getKeyValuePairs(const std::string& prefix) const override { return _keyValues; }
+        bool isModel() const override { return false; }
+        bool isWorldspawn() const override { return getKeyValue("classname") == "worldspawn"; }
+        bool isContainer() const override { return true; }
+        void attachObserver(Observer* observer) override {}
+        void detachObserver(Observer* observer) override {}
+        bool isOfType(const std::string& className) override { return getKeyValue("classname") == className; }
+    };
+
+    class RecordingEntityNode :
+        public scene::Node,
+        public IEntityNode
+    {
+        RecordingEntity _entity;
+        AABB _bounds;
+        Vector3 _direction;
+        ShaderPtr _wireShader;
+
+    public:
+        Entity& getEntity() override { return _entity; }
+        void refreshModel() override {}
+
+        float getShaderParm(int parmNum) const override { return 0; }
+        const Vector3& getDirection() const override { return _direction; }
+        const ShaderPtr& getWireShader() const override { return _wireShader; }
+
+        std::string name() const override { return _entity.getKeyValue("name"); }
+        Type getNodeType() const override { return Type::Entity; }
+        const AABB& localAABB() const override { return _bounds; }
+        void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const override {}
+        void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const override {}
+        std::size_t getHighlightFlags() override { return Highlight::NoHighlight; }
+    };
+
+    // Patch storing what the parsers assigned to it
+    class RecordingPatchNode :
+        public scene::Node,
+        public IPatchNode,
+        public IPatch
+    {
+        std::string _shader;
+        std::size_t _width = 0;
+        std::size_t _height = 0;
+        std::vector<PatchControl> _controls;
+        Subdivisions _subdivisions;
+        AABB _bounds;
+
+    public:
+        Patch& getPatchInternal() override { throw std::logic_error("not implemented"); }
+        IPatch& getPatch() override { return *this; }
+
+        void attachObserver(Observer* observer) override {}
+        void detachObserver(Observer* observer) override {}
+
+        void setDims(std::size_t width, std::size_t height) override
+        {
+            _width = width;
+            _height = height;
+            _controls.assign(width * height, PatchControl());
+        }
+
+        std::size_t getWidth() const override { return _width; }
+        std::size_t getHeight() const override { return _height; }
+
+        PatchControl& ctrlAt(std::size_t row, std::size_t col) override { return _controls.at(row * _width + col); }
+        const PatchControl& ctrlAt(std::size_t row, std::size_t col) const override { return _controls.at(row * _width + col); }
+
+        PatchMesh getTesselatedPatchMesh() const override { return PatchMesh(); }
+        void insertColumns(std::size_t colIndex) override {}
+        void insertRows(std::size_t rowIndex) override {}
+        void removePoints(bool columns, std::size_t index) override {}
+        void appendPoints(bool columns, bool beginning) override {}
+        void controlPointsChanged() override {}
+        void undoSave() override {}
+        bool isValid() const override { return true; }
+        bool isDegenerate() const override { return false; }
+        const std::string& getShader() const override { return _shader; }
+        void setShader(const std::string& name) override { _shader = name; }
+        bool hasVisibleMaterial() const override { return true; }
+        bool subdivisionsFixed() const override { return false; }
+        const Subdivisions& getSubdivisions() const override { return _subdivisions; }
+        void setFixedSubdivisions(bool isFixed, const Subdivisions& divisions) override {}
+
+        std::string name() const override { return "Patch"; }
+        Type getNodeType() const override { return Type::Patch; }
+        const AABB& localAABB() const override { return _bounds; }
+        void renderSolid(RenderableCollector& collector, const VolumeTest& volume) const override {}
+        void renderWireframe(RenderableCollector& collector, const VolumeTest& volume) const override {}
+        std::size_t getHighlightFlags() override { return Highlight::NoHighlight; }
+    };
+
+    class MockBrushCreator :
+        public BrushCreator
+    {
+    public:
+        const std::string& getName() const override { return MODULE_BRUSHCREATOR; }
+
+        const StringSet& getDependencies() const override
+        {
+            static StringSet dependencies;
+            return dependencies;
+        }
+
+        void initialiseModule(const ApplicationContext& ctx) override {}
+
+        scene::INodePtr createBrush() override { return std::make_shared<BrushNode>(); }
+    };
+
+    class MockPatchCreator :
+        public PatchCreator
+    {
+        std::string _name;
+
+    public:
+        MockPatchCreator(const std::string& name) :
+            _name(name)
+        {}
+
+        const std::string& getName() const override { return _name; }
+
+        const StringSet& getDependencies() const override
+        {
+            static StringSet dependencies;
+            return dependencies;
+        }
+
+        void initialiseModule(const ApplicationContext& ctx) override {}
+
+        scene::INodePtr createPatch() override { return std::make_shared<RecordingPatchNode>(); }
+    };
+
+    class MockEntityCreator :
+        public EntityCreator
+    {
+    public:
+        const std::string& getName() const override { return MODULE_ENTITYCREATOR; }
+
+        const StringSet& getDependencies() const override
+        {
+            static StringSet dependencies;
+            return dependencies;
+        }
+
+        void initialiseModule(const ApplicationContext& ctx) override {}
+
+        IEntityNodePtr createEntity(const IEntityClassPtr& eclass) override
+        {
+            return std::make_shared<RecordingEntityNode>();
+        }
+
+        void connectEntities(const scene::INodePtr& source, const scene::INodePtr& target) override {}
+        ITargetManagerPtr createTargetManager() override { return ITargetManagerPtr(); }
+    };
+
+    // No entity classes are known, the reader falls back to findOrInsert()
+    class MockEntityClassManager :
+        public IEntityClassManager
+    {
+    public:
+        const std::string& getName() const override
+        {
+            static std::string name(MODULE_ECLASSMANAGER);
+            return name;
+        }
+
+        const StringSet& getDependencies() const override
+        {
+            static StringSet dependencies;
+            return dependencies;
+        }
+
+        void initialiseModule(const ApplicationContext& ctx) override {}
+
+        sigc::signal<void> defsReloadedSignal() const override { return sigc::signal<void>(); }
+        IEntityClassPtr findOrInsert(const std::string& name, bool has_brushes) override { return IEntityClassPtr(); }
+        IEntityClassPtr findClass(const std::string& name) override { return IEntityClassPtr(); }
+        void forEachEntityClass(EntityClassVisitor& visitor) override {}
+        void realise() override {}
+        void unrealise() override {}
+        void reloadDefs() override {}
+        IModelDefPtr findModel(const std::string& name) override { return IModelDefPtr(); }
+        void forEachModelDef(ModelDefVisitor& visitor) override {}
+    };
+
+    struct ModuleFixture
+    {
+        MockModuleRegistry registry;
+
+        ModuleFixture()
+        {
+            registry.registerModule(std::make_shared<MockRegistry>());
+            registry.registerModule(std::make_shared<MockRenderSystem>());
+            registry.registerModule(std::make_shared<MockSceneGraph>());
+            registry.registerModule(std::make_shared<MockUIManager>());
+            registry.registerModule(std::make_shared<MockBrushCreator>());
+            registry.registerModule(std::make_shared<MockPatchCreator>(MODULE_PATCHDEF2));
+            registry.registerModule(std::make_shared<MockPatchCreator>(MODULE_PATCHDEF3));
+            registry.registerModule(std::make_shared<MockEntityCreator>());
+            registry.registerModule(std::make_shared<MockEntityClassManager>());
+
+            module::RegistryReference::Instance().setRegistry(registry);
+
+            Brush::m_maxWorldCoord = 65536;
+
+            // The unknown entity classes are reported for every entity
+            GlobalErrorStream().setStream(_errors);
+        }
+
+        std::ostringstream _errors;
+    };
+
+    BOOST_GLOBAL_FIXTURE(ModuleFixture);
+
+    std::string describeEntity(const scene::INodePtr& node)
+    {
+        std::ostringstream str;
+        str << "entity";
+
+        Node_getEntity(node)->forEachKeyValue([&](const std::string& key, const std::string& value)
+        {
+            str << " \"" << key << "\" \"" << value << "\"";
+        });
+
+        return str.str();
+    }
+
+    std::string describePrimitive(const scene::INodePtr& node)
+    {
+        std::ostringstream str;
+
+        if (Node_isBrush(node))
+        {
+            IBrush& brush = *Node_getIBrush(node);
+            str << "brush " << brush.getDetailFlag();
+
+            for (std::size_t i = 0; i < brush.getNumFaces(); ++i)
+            {
+                const IFace& face = brush.getFace(i);
+                const Plane3& plane = face.getPlane3();
+                Matrix4 texdef = face.getTexDefMatrix();
+
+                str << " ( " << plane.normal() << " " << plane.dist() << " ) ( "
+                    << texdef.xx() << " " << texdef.yx() << " " << texdef.tx() << " "
+                    << texdef.xy() << " " << texdef.yy() << " " << texdef.ty() << " ) "
+                    << face.getShader();
+            }
+        }
+        else if (Node_isPatch(node))
+        {
+            IPatch& patch = std::dynamic_pointer_cast<IPatchNode>(node)->getPatch();
+            str << "patch " << patch.getShader() << " " << patch.getWidth() << "x" << patch.getHeight();
+
+            for (std::size_t r = 0; r < patch.getHeight(); ++r)
+            {
+                for (std::size_t c = 0; c < patch.getWidth(); ++c)
+                {
+                    const PatchControl& control = patch.ctrlAt(r, c);
+                    str << " ( " << control.vertex << " " << control.texcoord << " )";
+                }
+            }
+        }
+        else
+        {
+            str << "unknown primitive";
+        }
+
+        return str.str();
+    }
+
+    // Records the nodes passed by the map reader, in the order they arrive
+    class RecordingImportFilter :
+        public map::IMapImportFilter
+    {
+        scene::IMapRootNodePtr _root;
+
+    public:
+        std::vector<std::string> nodes;
+
+        const scene::IMapRootNodePtr& getRootNode() const override
+        {
+            return _root;
+        }
+
+        bool addEntity(const scene::INodePtr& entity) override
+        {
+            nodes.push_back(describeEntity(entity));
+            return true;
+        }
+
+        bool addPrimitiveToEntity(const scene::INodePtr& primitive, const scene::INodePtr& entity) override
+        {
+            nodes.push_back(describePrimitive(primitive) + " of " + describeEntity(entity));
+            return true;
+        }
+    };
+
+    // Exposes the two loading paths of the reader
+    class TestMapReader :
+        public map::Doom3MapReader
+    {
+    public:
+        TestMapReader(map::IMapImportFilter& importFilter) :
+            Doom3MapReader(importFilter)
+        {
+            initPrimitiveParsers();
+        }
+
+        using Doom3MapReader::readFromStreamSerial;
+        using Doom3MapReader::readFromStreamParallel;
+    };
+
+    // Loads the map text, using the given scheduler or the serial path if it is NULL
+    std::vector<std::string> readNodes(const std::string& mapText, TaskScheduler* scheduler)
+    {
+        RecordingImportFilter filter;
+        TestMapReader reader(filter);
+
+        std::istringstream stream(mapText);
+
+        if (scheduler != nullptr)
+        {
+            reader.readFromStreamParallel(stream, *scheduler);
+        }
+        else
+        {
+            reader.readFromStreamSerial(stream);
+        }
+
+        return filter.nodes;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(splitIntoEntityBlocks)
+{
+    std::string mapText = generateMap(3);
+
+    std::vector<std::pair<std::size_t, std::size_t>> blocks;
+    std::size_t headerEnd = map::ParallelMapTokeniser::findBlocks(mapText, blocks);
+
+    // The header ends at the opening brace of the first entity
+    BOOST_TEST(mapText[headerEnd] == '{');
+    BOOST_TEST(blocks.size() == 4); // three entities plus the trailing line break
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        BOOST_TEST(mapText[blocks[i].second - 1] == '}');
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unbalancedAndEmptyInput)
+{
+    radiant::WorkStealingScheduler scheduler(2);
+    std::size_t numEntities = 0;
+
+    // No entities at all
+    BOOST_TEST(tokeniseInParallel("Version 2", scheduler, numEntities) == tokeniseSerially("Version 2"));
+    BOOST_TEST(tokeniseInParallel("", scheduler, numEntities).empty());
+
+    // Missing closing brace and stray closing brace
+    std::string broken = "Version 2\n{ \"classname\" \"worldspawn\" { brushDef3 {";
+    BOOST_TEST(tokeniseInParallel(broken, scheduler, numEntities) == tokeniseSerially(broken));
+
+    std::string stray = "Version 2\n} { \"classname\" \"worldspawn\" } } trailing";
+    BOOST_TEST(tokeniseInParallel(stray, scheduler, numEntities) == tokeniseSerially(stray));
+}
+
+BOOST_AUTO_TEST_CASE(parallelMatchesSerialTokens)
+{
+    std::string mapText = generateMap(50);
+
+    std::vector<std::string> serial = tokeniseSerially(mapText);
+
+    for (std::size_t workers : { 1, 2, 8 })
+    {
+        radiant::WorkStealingScheduler scheduler(workers);
+
+        std::size_t numEntities = 0;
+        std::vector<std::string> parallel = tokeniseInParallel(mapText, scheduler, numEntities);
+
+        BOOST_TEST(numEntities == 50);
+        BOOST_TEST(parallel == serial);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallelMatchesSerialNodes)
+{
+    std::string mapText = generateMap(50);
+
+    // Every entity has four brushes and a patch
+    std::vector<std::string> serial = readNodes(mapText, nullptr);
+    BOOST_TEST_REQUIRE(serial.size() == 50 * 6);
+
+    for (std::size_t workers : { 1, 2, 8 })
+    {
+        radiant::WorkStealingScheduler scheduler(workers);
+
+        // The nodes need to be created with the same content and passed in the same order
+        std::vector<std::string> parallel = readNodes(mapText, &scheduler);
+
+        BOOST_TEST_INFO(workers << " workers");
+        BOOST_TEST_REQUIRE(parallel.size() == serial.size());
+
+        for (std::size_t i = 0; i < serial.size(); ++i)
+        {
+            BOOST_TEST_INFO("node " << i);
+            BOOST_TEST(parallel[i] == serial[i]);
+        }
+    }
+}
+
+namespace
+{
+    // The way the writers formatted their numbers before writeDoubleSafe()
+    void writeDoubleThroughStream(const double d, std::ostream& os)
+    {
+        if (isValid(d))
+        {
+            if (d == -0.0)
+            {
+                os << 0;
+            }
+            else
+            {
+                os << d;
+            }
+        }
+        else
+        {
+            os << "0";
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(writeDoubleMatchesStreamOutput)
+{
+    std::vector<double> values = {
+        0.0, -0.0, 1.0, -1.0, 0.5, -0.5, 0.1, 1.0 / 3, 1e15, -1e15, 1e15 - 1, 1e16, 123456789012345.0,
+        1e-5, 1e-4, 0.0078125, 255.9375, -4096.0, 1e300, -1e-300, 5e-324,
+        std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN(),
+    };
+
+    std::mt19937 rng(1234);
+
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::uniform_real_distribution<double> distribution(-65536, 65536);
+        double value = distribution(rng);
+
+        values.push_back(value);
+        values.push_back(std::floor(value));
+        values.push_back(std::floor(value * 64) / 64);
+        values.push_back(value * 1e-6);
+        values.push_back(std::ldexp(value, int(rng() % 100)));
+    }
+
+    for (int precision : { 16, 15, 6, 0 })
+    {
+        std::ostringstream expected;
+        std::ostringstream written;
+        expected.precision(precision);
+        written.precision(precision);
+
+        for (double value : values)
+        {
+            writeDoubleThroughStream(value, expected);
+            expected << " ";
+
+            map::writeDoubleSafe(value, written);
+            written << " ";
+        }
+
+        BOOST_TEST_REQUIRE(written.str() == expected.str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallelOutputMatchesWriter)
+{
+    // The worldspawn is split into several parts
+    TestMap map = generateTestMap(300, 2000);
+
+    TestMapWriter directWriter;
+    std::string expected = writeDirectly(map, directWriter);
+
+    radiant::WorkStealingScheduler scheduler(4);
+
+    TestMapWriter writer;
+    BOOST_TEST(writeInParallel(map, writer, &scheduler) == expected);
+
+    TestMapWriter serialWriter;
+    BOOST_TEST(writeInParallel(map, serialWriter, nullptr) == expected);
+
+    // Writers not supporting parts are called directly
+    SerialTestMapWriter unsplittableWriter;
+    BOOST_TEST(writeInParallel(map, unsplittableWriter, &scheduler) == expected);
+
+    // Nothing to write
+    TestMapWriter emptyWriter;
+    BOOST_TEST(writeInParallel(TestMap(), emptyWriter, &scheduler) == writeDirectly(TestMap(), directWriter));
+}
+
+namespace
+{
+    const char* const INFO_FILE_EXT = ".darkradiant";
+
+    // A temporary map folder, which is removed at the end of the test
+    struct MapFolderFixture
+    {
+        fs::path root;
+
+        MapFolderFixture() :
+            root(fs::temp_directory_path() / ("autoSaveWriterTest" + std::to_string(std::random_device()())))
+        {
+            GlobalOutputStream().setStream(std::cout);
+            GlobalErrorStream().setStream(std::cerr);
+            GlobalWarningStream().setStream(std::cerr);
+
+            fs::create_directories(root);
+        }
+
+        ~MapFolderFixture()
+        {
+            fs::remove_all(root);
+        }
+
+        std::string readFile(const fs::path& path)
+        {
+            std::ifstream stream(path.string());
+            std::stringstream contents;
+            contents << stream.rdbuf();
+
+            return contents.str();
+        }
+
+        std::size_t countFiles()
+        {
+            std::size_t count = 0;
+
+            for (fs::recursive_directory_iterator i(root); i != fs::recursive_directory_iterator(); ++i)
+            {
+                if (fs::is_regular_file(i->path()))
+                {
+                    count++;
+                }
+            }
+
+            return count;
+        }
+    };
+
+    map::AutoSaveBuffer createBuffer(const std::string& contents, bool hasInfoFile)
+    {
+        map::AutoSaveBuffer buffer;
+
+        buffer.mapData = "Version 2\n// entity 0\n{\n\"classname\" \"worldspawn\"\n\"comment\" \"" + contents + "\"\n}\n";
+        buffer.hasInfoFile = hasInfoFile;
+
+        if (hasInfoFile)
+        {
+            buffer.infoFileData = "DarkRadiant Map Information File Version 2\n{\n}\n";
+        }
+
+        return buffer;
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(writeMapAndInfoFile, MapFolderFixture)
+{
+    map::AutoSaveBuffer buffer = createBuffer("first", true);
+    fs::path mapFile = root / "test_autosave.map";
+
+    BOOST_TEST(map::AutoSaveWriter::write(buffer, mapFile, INFO_FILE_EXT));
+
+    BOOST_TEST(readFile(mapFile) == buffer.mapData);
+    BOOST_TEST(readFile(root / "test_autosave.darkradiant") == buffer.infoFileData);
+
+    // Overwriting the previous autosave leaves no temporary files behind
+    map::AutoSaveBuffer second = createBuffer("second", false);
+
+    BOOST_TEST(map::AutoSaveWriter::write(second, mapFile, INFO_FILE_EXT));
+
+    BOOST_TEST(readFile(mapFile) == second.mapData);
+    BOOST_TEST(countFiles() == 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(writeToMissingFolderFails, MapFolderFixture)
+{
+    map::AutoSaveBuffer buffer = createBuffer("first", true);
+
+    BOOST_TEST(!map::AutoSaveWriter::write(buffer, root / "missing" / "test.map", INFO_FILE_EXT));
+    BOOST_TEST(countFiles() == 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(snapshotsAreNumbered, MapFolderFixture)
+{
+    fs::path snapshotPath = root / "snapshots";
+    std::size_t expectedFolderSize = 0;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        map::AutoSaveBuffer buffer = createBuffer("snapshot " + std::to_string(i), false);
+
+        // Snapshots are written on a worker thread by the autosaver
+        auto result = std::async(std::launch::async, [&]()
+        {
+            return map::AutoSaveWriter::writeSnapshot(buffer, snapshotPath, "test.map", "map", INFO_FILE_EXT);
+        }).get();
+
+        BOOST_TEST(result.success);
+        BOOST_TEST(result.filename == map::AutoSaveWriter::constructSnapshotName(snapshotPath, "test.map", i, "map"));
+        BOOST_TEST(readFile(result.filename) == buffer.mapData);
+
+        // The size reported is the one of the previous snapshots
+        BOOST_TEST(result.folderSize == expectedFolderSize);
+        expectedFolderSize += fs::file_size(result.filename);
+    }
+
+    auto existing = map::AutoSaveWriter::collectExistingSnapshots(snapshotPath, "test.map", "map");
+
+    BOOST_TEST(existing.size() == 3);
+    BOOST_TEST(existing.rbegin()->first == 2);
+
+    // A gap in the numbering ends the sequence, the next snapshot fills it
+    fs::remove(existing[1]);
+
+    map::AutoSaveBuffer buffer = createBuffer("refill", false);
+    auto result = map::AutoSaveWriter::writeSnapshot(buffer, snapshotPath, "test.map", "map", INFO_FILE_EXT);
+
+    BOOST_TEST(result.filename == existing[1]);
+}
@@ -0,0 +1,344 @@
+#define BOOST_TEST_MODULE md5Test
+#include <boost/test/included/unit_test.hpp>
+
+#include "WorkStealingScheduler.h"
+#include "MD5TestData.h"
+
+using namespace md5;
+using namespace md5test;
+
+namespace
+{
+    // The given mesh repeated a number of times, to get large meshes
+    MD5Mesh repeatMesh(const MD5Mesh& mesh, std::size_t count)
+    {
+        MD5Mesh result;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t vertexOffset = result.vertices.size();
+            std::size_t weightOffset = result.weights.size();
+
+            for (MD5Vert vert : mesh.vertices)
+            {
+                vert.weight_index += weightOffset;
+                result.vertices.push_back(vert);
+            }
+
+            for (MD5Tri tri : mesh.triangles)
+            {
+                tri.a += vertexOffset;
+                tri.b += vertexOffset;
+                tri.c += vertexOffset;
+                result.triangles.push_back(tri);
+            }
+
+            result.weights.insert(result.weights.end(), mesh.weights.begin(), mesh.weights.end());
+        }
+
+        return result;
+    }
+
+    void checkKey(const IMD5Anim::Key& key, const IMD5Anim::Key& expected)
+    {
+        // The quantised orientations add up along the joint chain, the tip
+        // of the tentacle is off by less than a hundredth of a unit
+        BOOST_TEST((key.origin - expected.origin).getLength() < 1e-2);
+
+        // q and -q are the same rotation
+        double dot = key.orientation.w() * expected.orientation.w() +
+            key.orientation.x() * expected.orientation.x() +
+            key.orientation.y() * expected.orientation.y() +
+            key.orientation.z() * expected.orientation.z();
+
+        BOOST_TEST(std::abs(dot) > 1 - 1e-4);
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(loadTestData, SkinningFixture)
+{
+    BOOST_TEST(joints.size() == 12);
+    BOOST_TEST(meshes.size() == 2);
+    BOOST_TEST(anim->getNumJoints() == joints.size());
+    BOOST_TEST(anim->getNumFrames() == 48);
+
+    MD5SkinningData data(meshes[0]);
+
+    BOOST_TEST(data.getNumVertices() == meshes[0].vertices.size());
+    BOOST_TEST(data.getNumTriangles() == meshes[0].triangles.size());
+    BOOST_TEST(data.getNumWeights() == meshes[0].weights.size());
+}
+
+BOOST_FIXTURE_TEST_CASE(defaultPoseMatchesReference, SkinningFixture)
+{
+    // The default pose is the skeleton of the mesh file
+    MD5Pose pose;
+    pose.setFromJoints(joints);
+
+    BOOST_TEST_REQUIRE(pose.getNumJoints() == joints.size());
+
+    for (const MD5Mesh& mesh : meshes)
+    {
+        std::vector<ArbitraryMeshVertex> vertices;
+        AABB bounds;
+        MD5SkinningBuffers buffers;
+
+        MD5SkinningData(mesh).skin(pose, buffers, vertices, bounds);
+
+        BOOST_TEST_REQUIRE(vertices.size() == mesh.vertices.size());
+        BOOST_TEST(bounds.isValid());
+
+        // The bind pose is a straight tube along the z axis
+        for (const ArbitraryMeshVertex& vertex : vertices)
+        {
+            BOOST_TEST_REQUIRE(std::abs(vertex.normal.z()) < 0.5);
+            BOOST_TEST_REQUIRE(std::abs(vertex.normal.getLength() - 1) < 1e-5);
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(animationMatchesReference, SkinningFixture)
+{
+    radiant::WorkStealingScheduler scheduler(4);
+
+    // Halfway between the frames 20 and 21
+    MD5Skeleton skeleton;
+    skeleton.update(anim, getFrameTime(anim, 20) + 500 / anim->getFrameRate());
+
+    MD5Pose pose;
+    pose.setFromSkeleton(skeleton);
+
+    for (const MD5Mesh& mesh : meshes)
+    {
+        // Positions and bounds calculated in double precision, like MD5Surface used to
+        std::vector<Vector3> expected;
+        AABB expectedBounds;
+
+        for (const MD5Vert& vert : mesh.vertices)
+        {
+            Vector3 position(0, 0, 0);
+
+            for (std::size_t k = 0; k < vert.weight_count; ++k)
+            {
+                const MD5Weight& weight = mesh.weights[vert.weight_index + k];
+                const IMD5Anim::Key& key = skeleton.getKey(weight.joint);
+
+                position += (key.orientation.transformPoint(weight.v) + key.origin) * weight.t;
+            }
+
+            expected.push_back(position);
+            expectedBounds.includePoint(position);
+        }
+
+        MD5SkinningData data(mesh);
+        MD5SkinningBuffers buffers;
+
+        for (bool vectorised : { false, true })
+        {
+            for (TaskScheduler* taskScheduler : { static_cast<TaskScheduler*>(NULL), static_cast<TaskScheduler*>(&scheduler) })
+            {
+                skinning::setVectorised(vectorised);
+                skinning::setTaskScheduler(taskScheduler);
+
+                std::vector<ArbitraryMeshVertex> vertices;
+                AABB bounds;
+
+                data.skin(pose, buffers, vertices, bounds);
+
+                BOOST_TEST_REQUIRE(vertices.size() == expected.size());
+
+                for (std::size_t i = 0; i < vertices.size(); ++i)
+                {
+                    checkVector(vertices[i].vertex, expected[i], 1e-3);
+                    BOOST_TEST_REQUIRE(std::abs(vertices[i].normal.getLength() - 1) < 1e-4);
+                }
+
+                checkVector(bounds.getOrigin(), expectedBounds.getOrigin(), 1e-3);
+                checkVector(bounds.getExtents(), expectedBounds.getExtents(), 1e-3);
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(configurationsMatchScalar, SkinningFixture)
+{
+    radiant::WorkStealingScheduler scheduler(4);
+
+    // Skin a large mesh too, such that it is split into blocks
+    std::vector<MD5Mesh> testMeshes = meshes;
+    testMeshes.push_back(repeatMesh(meshes[0], 32));
+
+    BOOST_TEST_REQUIRE(testMeshes.back().vertices.size() > 2 * skinning::MIN_PARALLEL_VERTICES);
+
+    MD5Skeleton skeleton;
+    MD5Pose pose;
+
+    for (const MD5Mesh& mesh : testMeshes)
+    {
+        MD5SkinningData data(mesh);
+        MD5SkinningBuffers buffers;
+
+        for (std::size_t frame = 0; frame < anim->getNumFrames(); frame += 5)
+        {
+            // Halfway between two frames, testing the interpolation as well
+            skeleton.update(anim, getFrameTime(anim, frame) + 500 / anim->getFrameRate());
+            pose.setFromSkeleton(skeleton);
+
+            std::vector<ArbitraryMeshVertex> expected;
+            AABB expectedBounds;
+            skinScalar(data, pose, expected, expectedBounds);
+
+            for (bool vectorised : { false, true })
+            {
+                for (TaskScheduler* taskScheduler : { static_cast<TaskScheduler*>(NULL), static_cast<TaskScheduler*>(&scheduler) })
+                {
+                    skinning::setVectorised(vectorised);
+                    skinning::setTaskScheduler(taskScheduler);
+
+                    std::vector<ArbitraryMeshVertex> vertices;
+                    AABB bounds;
+
+                    data.skin(pose, buffers, vertices, bounds);
+
+                    checkVertices(vertices, bounds, expected, expectedBounds);
+                }
+            }
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(missingJointsAreIgnored, SkinningFixture)
+{
+    MD5Mesh mesh = meshes[0];
+
+    // The first vertex is attached to a joint which doesn't exist
+    mesh.weights[mesh.vertices[0].weight_index].joint = 99;
+
+    MD5Pose pose;
+    pose.setFromJoints(joints);
+
+    for (bool vectorised : { false, true })
+    {
+        skinning::setVectorised(vectorised);
+
+        std::vector<ArbitraryMeshVertex> vertices;
+        AABB bounds;
+        MD5SkinningBuffers buffers;
+
+        MD5SkinningData(mesh).skin(pose, buffers, vertices, bounds);
+
+        BOOST_TEST_REQUIRE(vertices.size() == mesh.vertices.size());
+
+        // Only the remaining weights contribute
+        Vector3 expected(0, 0, 0);
+
+        for (std::size_t k = 1; k < mesh.vertices[0].weight_count; ++k)
+        {
+            const MD5Weight& weight = mesh.weights[mesh.vertices[0].weight_index + k];
+            const MD5Joint& joint = joints[weight.joint];
+
+            expected += (joint.rotation.transformPoint(weight.v) + joint.position) * weight.t;
+        }
+
+        checkVector(vertices[0].vertex, expected, 1e-4);
+    }
+
+    // An empty mesh gives an invalid AABB
+    std::vector<ArbitraryMeshVertex> vertices(5);
+    AABB bounds;
+    MD5SkinningBuffers buffers;
+
+    MD5SkinningData(MD5Mesh()).skin(pose, buffers, vertices, bounds);
+
+    BOOST_TEST(vertices.empty());
+    BOOST_TEST(!bounds.isValid());
+}
+
+BOOST_FIXTURE_TEST_CASE(decodedFramesMatchComponents, PoseCacheFixture)
+{
+    std::shared_ptr<MD5Anim> raw = loadTentacleAnim(false);
+    std::shared_ptr<MD5Anim> decoded = loadTentacleAnim(true);
+
+    BOOST_TEST(!raw->hasDecodedFrames());
+    BOOST_TEST_REQUIRE(decoded->hasDecodedFrames());
+
+    BOOST_TEST_MESSAGE("Decoded frames use " << decoded->getMemoryUsage() << " bytes, raw frames "
+        << raw->getMemoryUsage() << " bytes");
+
+    MD5Skeleton rawSkeleton;
+    MD5Skeleton decodedSkeleton;
+
+    // Every frame and the points in between
+    std::size_t duration = getFrameTime(raw, raw->getNumFrames());
+
+    for (std::size_t time = 0; time < duration; time += 7)
+    {
+        rawSkeleton.update(raw, time);
+        decodedSkeleton.update(decoded, time);
+
+        BOOST_TEST_REQUIRE(decodedSkeleton.size() == rawSkeleton.size());
+
+        for (std::size_t i = 0; i < rawSkeleton.size(); ++i)
+        {
+            checkKey(decodedSkeleton.getKey(i), rawSkeleton.getKey(i));
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(skeletonsShareTheirPose, PoseCacheFixture)
+{
+    IMD5AnimPtr anim = loadTentacleAnim(true);
+
+    MD5Skeleton first;
+    MD5Skeleton second;
+
+    first.update(anim, 100);
+    second.update(anim, 100);
+
+    // The second skeleton got the pose evaluated for the first one
+    BOOST_TEST(&first.getPose() == &second.getPose());
+    BOOST_TEST(MD5PoseCache::Instance().getNumHits() >= 1);
+
+    second.update(anim, 200);
+
+    BOOST_TEST(&first.getPose() != &second.getPose());
+    BOOST_TEST(MD5PoseCache::Instance().size() == 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(poseCacheDropsLeastRecentlyUsed, PoseCacheFixture)
+{
+    IMD5AnimPtr anim = loadTentacleAnim(true);
+
+    MD5PoseCache& cache = MD5PoseCache::Instance();
+    cache.setCapacity(2);
+
+    std::size_t evaluated = 0;
+
+    auto evaluate = [&]()
+    {
+        ++evaluated;
+        return std::make_shared<MD5AnimPose>();
+    };
+
+    MD5AnimPosePtr a = cache.get(anim, 0, 1, 0.5f, evaluate);
+    MD5AnimPosePtr b = cache.get(anim, 1, 2, 0.5f, evaluate);
+
+    // Use the first pose again, such that the second one is dropped
+    BOOST_TEST(cache.get(anim, 0, 1, 0.5f, evaluate) == a);
+    cache.get(anim, 2, 3, 0.5f, evaluate);
+
+    BOOST_TEST(evaluated == 3);
+    BOOST_TEST(cache.size() == 2);
+
+    BOOST_TEST(cache.get(anim, 0, 1, 0.5f, evaluate) == a);
+    BOOST_TEST(cache.get(anim, 1, 2, 0.5f, evaluate) != b);
+    BOOST_TEST(evaluated == 4);
+
+    // Without capacity every pose is evaluated
+    cache.setCapacity(0);
+
+    BOOST_TEST(cache.size() == 0);
+    BOOST_TEST(cache.get(anim, 0, 1, 0.5f, evaluate) != a);
+    BOOST_TEST(cache.size() == 0);
+    BOOST_TEST(evaluated == 5);
+}
@@ -0,0 +1,528 @@
+#define BOOST_TEST_MODULE renderTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <cstdint>
+#include <random>
+
+#include "render/MeshBufferAllocator.h"
+#include "util/RadixSort.h"
+#include "RenderTestData.h"
+
+using namespace rendertest;
+
+BOOST_AUTO_TEST_CASE(polygonsAreTriangulatedAsFans)
+{
+    TestBatch batch;
+    TestPolygon quad(1, Vector3(0, 0, 0), 4);
+    TestPolygon pentagon(2, Vector3(10, 0, 0), 5);
+    TestPolygon line(3, Vector3(20, 0, 0), 2);
+
+    batch.begin();
+    batch.addPolygon(quad);
+    batch.addPolygon(line);
+    BOOST_TEST(batch.endBatch());
+
+    batch.addPolygon(pentagon);
+    BOOST_TEST(batch.endBatch());
+
+    // Nothing added since the last batch
+    BOOST_TEST(!batch.endBatch());
+
+    const TestBuffer& buffer = batch.getBuffer();
+
+    BOOST_TEST(buffer.getNumBatches() == 2);
+    BOOST_TEST(buffer.batchSizes[0] == 6);
+    BOOST_TEST(buffer.batchSizes[1] == 9);
+
+    // Degenerate polygons don't get a slot
+    BOOST_TEST(buffer.getNumVertices() == 9);
+    BOOST_TEST(batch.getNumSlots() == 2);
+
+    std::vector<RenderIndex> expected = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7, 4, 7, 8 };
+    BOOST_TEST(buffer.indices == expected, boost::test_tools::per_element());
+
+    BOOST_TEST(buffer.vertices[4].vertex.x() == 11.0f);
+}
+
+BOOST_AUTO_TEST_CASE(onlyChangedPolygonsAreRewritten)
+{
+    TestBatch batch;
+    std::vector<TestPolygon> polygons = createPolygons(100);
+
+    drawAll(batch, polygons);
+
+    std::size_t numVertices = batch.getBuffer().getNumVertices();
+    BOOST_TEST(batch.getBuffer().verticesWritten == numVertices);
+
+    // The second frame doesn't touch the vertices
+    batch.getBuffer().verticesWritten = 0;
+    drawAll(batch, polygons);
+
+    BOOST_TEST(batch.getBuffer().verticesWritten == 0);
+    BOOST_TEST(batch.getBuffer().getNumBatches() == 1);
+
+    // A new revision is written to the same slot
+    polygons[10].revision = 1000;
+    polygons[10].centre = Vector3(500, 0, 0);
+    drawAll(batch, polygons);
+
+    BOOST_TEST(batch.getBuffer().verticesWritten == polygons[10].numVertices);
+    BOOST_TEST(batch.getBuffer().getNumVertices() == numVertices);
+
+    // Changing the vertex count moves the polygon to a new slot
+    batch.getBuffer().verticesWritten = 0;
+    polygons[20].revision = 1001;
+    polygons[20].numVertices = 8;
+    drawAll(batch, polygons);
+
+    BOOST_TEST(batch.getBuffer().verticesWritten == 8);
+    BOOST_TEST(batch.getBuffer().getNumVertices() == numVertices + 8);
+    BOOST_TEST(batch.getNumFreeVertices() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(unusedSlotsAreReused)
+{
+    TestBatch batch;
+    std::vector<TestPolygon> polygons = createPolygons(30);
+
+    drawAll(batch, polygons);
+    std::size_t numVertices = batch.getBuffer().getNumVertices();
+
+    // Stop drawing the first half until their slots are released
+    std::vector<const TestPolygon*> drawn = getRange(polygons, 15, 30);
+
+    for (std::size_t i = 0; i < 2 * TestBatch::MAX_UNUSED_GENERATIONS; ++i)
+    {
+        draw(batch, drawn);
+    }
+
+    BOOST_TEST(batch.getNumSlots() == 15);
+    BOOST_TEST(batch.getNumFreeVertices() == numVertices / 2);
+
+    // New polygons of the same sizes take the released slots
+    std::vector<TestPolygon> replacements(polygons.begin(), polygons.begin() + 15);
+
+    for (TestPolygon& polygon : replacements)
+    {
+        polygon.revision += 1000;
+        drawn.push_back(&polygon);
+    }
+
+    draw(batch, drawn);
+
+    BOOST_TEST(batch.getNumSlots() == 30);
+    BOOST_TEST(batch.getNumFreeVertices() == 0);
+    BOOST_TEST(batch.getBuffer().getNumVertices() == numVertices);
+}
+
+BOOST_AUTO_TEST_CASE(fragmentedBufferIsCompacted)
+{
+    TestBatch batch;
+    std::vector<TestPolygon> polygons = createPolygons(5000);
+
+    drawAll(batch, polygons);
+
+    // Keep drawing a few polygons only, the others are released eventually
+    std::vector<const TestPolygon*> drawn = getRange(polygons, 0, 10);
+
+    for (std::size_t i = 0; i < 2 * TestBatch::MAX_UNUSED_GENERATIONS; ++i)
+    {
+        draw(batch, drawn);
+    }
+
+    BOOST_TEST(batch.getNumSlots() == 10);
+    BOOST_TEST(batch.getBuffer().getNumVertices() < 100);
+    BOOST_TEST(batch.getNumFreeVertices() == 0);
+    BOOST_TEST(batch.getBuffer().batchSizes.size() == 1);
+}
+
+namespace
+{
+    struct Record
+    {
+        uint32_t key = 0;
+        std::size_t order = 0;
+    };
+
+    std::vector<Record> createRecords(std::size_t count, uint32_t maxKey)
+    {
+        std::mt19937 random(1234);
+        std::uniform_int_distribution<uint32_t> distribution(0, maxKey);
+
+        std::vector<Record> records(count);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            records[i].key = distribution(random);
+            records[i].order = i;
+        }
+
+        return records;
+    }
+
+    void checkSorted(const std::vector<Record>& records, std::size_t count)
+    {
+        BOOST_TEST_REQUIRE(records.size() == count);
+
+        for (std::size_t i = 1; i < records.size(); ++i)
+        {
+            BOOST_TEST_REQUIRE(records[i - 1].key <= records[i].key);
+
+            // Ties keep their original order
+            if (records[i - 1].key == records[i].key)
+            {
+                BOOST_TEST_REQUIRE(records[i - 1].order < records[i].order);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sortIsStable)
+{
+    std::vector<Record> scratch;
+
+    for (uint32_t maxKey : { 0u, 1u, 255u, 256u, 70000u, 0xffffffffu })
+    {
+        std::vector<Record> records = createRecords(5000, maxKey);
+
+        util::radixSort(records, scratch, [](const Record& r) { return r.key; });
+
+        checkSorted(records, 5000);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(highBytesOnly)
+{
+    std::vector<Record> records = createRecords(1000, 0xff);
+    std::vector<Record> scratch;
+
+    // Only the highest byte varies
+    for (Record& record : records)
+    {
+        record.key <<= 24;
+    }
+
+    util::radixSort(records, scratch, [](const Record& r) { return r.key; });
+
+    checkSorted(records, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(smallInputs)
+{
+    std::vector<Record> records;
+    std::vector<Record> scratch;
+
+    util::radixSort(records, scratch, [](const Record& r) { return r.key; });
+    BOOST_TEST(records.empty());
+
+    records = createRecords(1, 100);
+    util::radixSort(records, scratch, [](const Record& r) { return r.key; });
+    BOOST_TEST(records.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(indexFindsIntersectingLights)
+{
+    std::mt19937 random(7);
+    std::vector<std::unique_ptr<TestLight>> lights;
+
+    render::LightIndex index;
+
+    for (std::size_t i = 0; i < 500; ++i)
+    {
+        lights.emplace_back(new TestLight(randomBox(random, 4096, 512)));
+        index.insert(*lights.back(), lights.back()->getLightAABB());
+    }
+
+    // Moving some lights and removing others invalidates the hierarchy
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        lights[i]->setBounds(randomBox(random, 4096, 512));
+        index.update(*lights[i], lights[i]->getLightAABB());
+    }
+
+    for (std::size_t i = 100; i < 150; ++i)
+    {
+        index.remove(*lights[i]);
+    }
+
+    BOOST_TEST(index.size() == 450);
+
+    for (std::size_t i = 0; i < 200; ++i)
+    {
+        AABB query = randomBox(random, 4096, 256);
+
+        std::set<RendererLight*> found;
+        index.forEachIntersectingLight(query, [&](RendererLight& light)
+        {
+            BOOST_TEST_REQUIRE(found.insert(&light).second);
+        });
+
+        std::set<RendererLight*> expected;
+
+        for (std::size_t l = 0; l < lights.size(); ++l)
+        {
+            if ((l < 100 || l >= 150) && lights[l]->intersectsAABB(query))
+            {
+                expected.insert(lights[l].get());
+            }
+        }
+
+        BOOST_TEST_REQUIRE((found == expected));
+    }
+
+    // Nothing is found with an invalid query
+    std::size_t count = 0;
+    index.forEachIntersectingLight(AABB(), [&](RendererLight&) { count++; });
+    BOOST_TEST(count == 0);
+}
+
+BOOST_AUTO_TEST_CASE(lightChangesUpdateTouchedObjects)
+{
+    Scene scene(100, 2000, 4096);
+
+    scene.calculateAll();
+    scene.checkLights();
+    BOOST_TEST(scene.countCalculations() == scene.objects.size());
+
+    // Nothing changed, nothing is recalculated
+    scene.calculateAll();
+    BOOST_TEST(scene.countCalculations() == 0);
+
+    // Move a light, only the objects near its old and new position are updated
+    TestLight& light = *scene.lights[0];
+    AABB oldBounds = light.getLightAABB();
+    light.setBounds(AABB(Vector3(-2000, -2000, -2000), Vector3(300, 300, 300)));
+    scene.interactions.lightChanged(light);
+
+    std::size_t touched = 0;
+
+    for (const auto& object : scene.objects)
+    {
+        const AABB& bounds = object->getLitObjectAABB();
+        touched += bounds.intersects(oldBounds) || bounds.intersects(light.getLightAABB()) ? 1 : 0;
+    }
+
+    scene.calculateAll();
+    scene.checkLights();
+    BOOST_TEST(scene.countCalculations() == touched);
+
+    // Removing a light updates the objects it touched
+    scene.interactions.detachLight(*scene.lights[1]);
+    std::unique_ptr<TestLight> removed = std::move(scene.lights[1]);
+    scene.lights.erase(scene.lights.begin() + 1);
+
+    scene.calculateAll();
+    scene.checkLights();
+
+    // Changes of lights not attached to the renderer are ignored
+    removed->setBounds(AABB(Vector3(0, 0, 0), Vector3(5000, 5000, 5000)));
+    scene.interactions.lightChanged(*removed);
+    BOOST_TEST(!scene.interactions.containsLight(*removed));
+
+    scene.calculateAll();
+    BOOST_TEST(scene.countCalculations() == 0);
+
+    // Re-adding it touches everything
+    scene.interactions.attachLight(*removed);
+    scene.lights.push_back(std::move(removed));
+
+    scene.calculateAll();
+    scene.checkLights();
+    BOOST_TEST(scene.countCalculations() == scene.objects.size());
+
+    // An object changing only updates itself
+    scene.interactions.litObjectChanged(*scene.objects[5]);
+    scene.calculateAll();
+    BOOST_TEST(scene.countCalculations() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(manyChangedLightsUpdateEverything)
+{
+    Scene scene(200, 500, 4096);
+    scene.calculateAll();
+    scene.countCalculations();
+
+    std::mt19937 random(3);
+
+    for (const auto& light : scene.lights)
+    {
+        light->setBounds(randomBox(random, 4096, 400));
+        scene.interactions.lightChanged(*light);
+    }
+
+    scene.calculateAll();
+    scene.checkLights();
+    BOOST_TEST(scene.countCalculations() == scene.objects.size());
+}
+
+namespace
+{
+    // A grid of quads with the given number of vertices per side
+    void createGrid(std::size_t size, std::vector<ArbitraryMeshVertex>& vertices,
+                    std::vector<unsigned int>& indices)
+    {
+        vertices.clear();
+        indices.clear();
+
+        for (std::size_t y = 0; y < size; ++y)
+        {
+            for (std::size_t x = 0; x < size; ++x)
+            {
+                ArbitraryMeshVertex v(Vertex3f(x * 8.0, y * 8.0, 0), Normal3f(0, 0, 1),
+                    TexCoord2f(x / 4.0, y / 4.0));
+                v.tangent = Normal3f(1, 0, 0);
+                v.bitangent = Normal3f(0, 1, 0);
+                v.colour = Vector3(0.5, x % 2, 1);
+
+                vertices.push_back(v);
+            }
+        }
+
+        for (std::size_t y = 0; y + 1 < size; ++y)
+        {
+            for (std::size_t x = 0; x + 1 < size; ++x)
+            {
+                unsigned int i = static_cast<unsigned int>(y * size + x);
+                unsigned int s = static_cast<unsigned int>(size);
+
+                indices.insert(indices.end(), { i, i + 1, i + s, i + 1, i + s + 1, i + s });
+            }
+        }
+    }
+
+    void checkMesh(const render::MeshBufferAllocator& pool, render::MeshBufferAllocator::Handle handle,
+                   const std::vector<ArbitraryMeshVertex>& vertices, const std::vector<unsigned int>& indices)
+    {
+        const render::MeshBufferAllocator::Mesh& mesh = pool.getMesh(handle);
+
+        BOOST_TEST_REQUIRE(mesh.numVertices == vertices.size());
+        BOOST_TEST_REQUIRE(mesh.numIndices == indices.size());
+
+        const render::MeshVertex* stored = pool.getVertices(handle);
+
+        for (std::size_t i = 0; i < vertices.size(); ++i)
+        {
+            BOOST_TEST_REQUIRE(stored[i].vertex.x() == vertices[i].vertex.x());
+            BOOST_TEST_REQUIRE(stored[i].vertex.y() == vertices[i].vertex.y());
+            BOOST_TEST_REQUIRE(stored[i].texcoord.x() == vertices[i].texcoord.x());
+        }
+
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            BOOST_TEST_REQUIRE(pool.getIndex(handle, i) == indices[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(normalPacking)
+{
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> component(-1, 1);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        Vector3 normal(component(random), component(random), component(random));
+
+        if (normal.getLengthSquared() < 0.01) continue;
+
+        normal.normalise();
+
+        int8_t packed[4];
+        render::packNormal(normal, packed);
+
+        // One step of a signed byte is below a degree
+        BOOST_TEST_REQUIRE((render::unpackNormal(packed) - normal).getLength() < 0.01);
+    }
+
+    int8_t packed[4];
+    render::packNormal(Vector3(1, -1, 0), packed);
+    BOOST_TEST(packed[0] == 127);
+    BOOST_TEST(packed[1] == -127);
+    BOOST_TEST(packed[2] == 0);
+}
+
+BOOST_AUTO_TEST_CASE(vertexIsCompact)
+{
+    BOOST_TEST(sizeof(render::MeshVertex) == 36);
+    BOOST_TEST(sizeof(render::MeshVertex) * 3 < sizeof(ArbitraryMeshVertex));
+}
+
+BOOST_AUTO_TEST_CASE(indexSizeDependsOnVertexCount)
+{
+    render::MeshBufferAllocator pool;
+
+    std::vector<ArbitraryMeshVertex> vertices;
+    std::vector<unsigned int> indices;
+
+    createGrid(256, vertices, indices);
+    render::MeshBufferAllocator::Handle small = pool.allocate(vertices, indices, true);
+
+    BOOST_TEST(pool.getMesh(small).shortIndices);
+    BOOST_TEST(pool.getMemoryUsage(small) == vertices.size() * 36 + indices.size() * 2);
+    checkMesh(pool, small, vertices, indices);
+
+    std::vector<ArbitraryMeshVertex> largeVertices;
+    std::vector<unsigned int> largeIndices;
+
+    createGrid(257, largeVertices, largeIndices);
+    render::MeshBufferAllocator::Handle large = pool.allocate(largeVertices, largeIndices, false);
+
+    BOOST_TEST(!pool.getMesh(large).shortIndices);
+    BOOST_TEST(!pool.getMesh(large).hasColours);
+    BOOST_TEST(pool.getMemoryUsage(large) == largeVertices.size() * 36 + largeIndices.size() * 4);
+    checkMesh(pool, large, largeVertices, largeIndices);
+
+    // The first mesh is unaffected
+    checkMesh(pool, small, vertices, indices);
+}
+
+BOOST_AUTO_TEST_CASE(releasedRangesAreReused)
+{
+    render::MeshBufferAllocator pool;
+
+    std::vector<ArbitraryMeshVertex> vertices;
+    std::vector<unsigned int> indices;
+    createGrid(10, vertices, indices);
+
+    std::vector<render::MeshBufferAllocator::Handle> handles;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        handles.push_back(pool.allocate(vertices, indices, true));
+    }
+
+    BOOST_TEST(pool.getNumVertices() == 500);
+
+    // Releasing two neighbours gives a gap for a larger mesh
+    pool.release(handles[1]);
+    pool.release(handles[2]);
+    BOOST_TEST(pool.getNumFreeVertices() == 200);
+
+    std::vector<ArbitraryMeshVertex> largerVertices;
+    std::vector<unsigned int> largerIndices;
+    createGrid(14, largerVertices, largerIndices);
+
+    render::MeshBufferAllocator::Handle larger = pool.allocate(largerVertices, largerIndices, true);
+
+    BOOST_TEST(pool.getMesh(larger).firstVertex == 100);
+    BOOST_TEST(pool.getNumVertices() == 500);
+    BOOST_TEST(pool.getNumFreeVertices() == 4);
+
+    checkMesh(pool, larger, largerVertices, largerIndices);
+    checkMesh(pool, handles[0], vertices, indices);
+    checkMesh(pool, handles[3], vertices, indices);
+
+    // Releasing the last mesh shrinks the arrays
+    pool.release(handles[4]);
+    BOOST_TEST(pool.getNumVertices() == 400);
+
+    // Updating vertices in place
+    for (ArbitraryMeshVertex& v : vertices)
+    {
+        v.vertex += Vector3(0, 0, 64);
+    }
+
+    pool.updateVertices(handles[3], vertices);
+    BOOST_TEST(pool.getVertices(handles[3])[0].vertex.z() == 64);
+    BOOST_TEST(pool.getVertices(handles[0])[0].vertex.z() == 0);
+}
@@ -0,0 +1,181 @@
+#define BOOST_TEST_MODULE sceneTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+#include "SceneTestData.h"
+
+using namespace scenetest;
+
+BOOST_AUTO_TEST_CASE(linkAndUnlink)
+{
+    std::vector<TestNodePtr> brushes = generateMapBrushes(8);
+    scene::Octree octree;
+
+    for (const TestNodePtr& brush : brushes)
+    {
+        octree.link(brush);
+    }
+
+    BOOST_TEST(countMembers(octree) == brushes.size());
+    BOOST_TEST(!octree.getRoot()->isLeaf());
+
+    // Remove every other node, the swap-remove must keep the lookup intact
+    for (std::size_t i = 0; i < brushes.size(); i += 2)
+    {
+        BOOST_TEST(octree.unlink(brushes[i]));
+        BOOST_TEST(!octree.unlink(brushes[i]));
+    }
+
+    BOOST_TEST(countMembers(octree) == brushes.size() / 2);
+
+    for (std::size_t i = 1; i < brushes.size(); i += 2)
+    {
+        BOOST_TEST(octree.unlink(brushes[i]));
+    }
+
+    BOOST_TEST(countMembers(octree) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(relinkChangedBounds)
+{
+    std::vector<TestNodePtr> brushes = generateMapBrushes(8);
+    scene::Octree octree;
+
+    for (const TestNodePtr& brush : brushes)
+    {
+        octree.link(brush);
+    }
+
+    // Unlinked nodes are ignored
+    TestNodePtr unlinked = std::make_shared<TestNode>(AABB(Vector3(0, 0, 0), Vector3(8, 8, 8)));
+    BOOST_TEST(!octree.relink(unlinked));
+
+    // Move the nodes around, some of them far outside of the current root
+    std::mt19937 rng(42);
+
+    for (int round = 0; round < 20; ++round)
+    {
+        std::vector<scene::INodePtr> changed;
+
+        for (std::size_t i = rng() % 7; i < brushes.size(); i += 7)
+        {
+            Vector3 delta(int(rng() % 2049) - 1024, int(rng() % 2049) - 1024, int(rng() % 129) - 64);
+            translate(*brushes[i], round == 10 ? delta * 16 : delta);
+            changed.push_back(brushes[i]);
+        }
+
+        octree.relink(changed);
+
+        BOOST_TEST_REQUIRE(countMembers(octree) == brushes.size());
+    }
+
+    // Invalid bounds end up in the root node
+    brushes[0]->setBounds(AABB());
+    BOOST_TEST(octree.relink(brushes[0]));
+
+    const auto& rootMembers = octree.getRoot()->getMembers();
+    BOOST_TEST((std::find(rootMembers.begin(), rootMembers.end(), brushes[0]) != rootMembers.end()));
+    BOOST_TEST(countMembers(octree) == brushes.size());
+}
+
+BOOST_AUTO_TEST_CASE(nearestDepthOfBounds)
+{
+    Click click;
+    click.origin = Vector3(0, 0, 0);
+    click.angles = Vector3(0, 0, 0); // looking down the x axis
+
+    render::View view = constructCameraView(click);
+    Matrix4 viewProjection = view.GetProjection().getMultipliedBy(view.GetModelview());
+
+    AABB box(Vector3(512, 0, 0), Vector3(16, 16, 16));
+    double nearest = scene::DepthSortedTraversal::getNearestDepth(viewProjection, box);
+
+    // No point within the box is in front of the nearest depth
+    for (double x = -16; x <= 16; x += 8)
+    {
+        Vector4 clipped = viewProjection.transform(Vector4(box.origin + Vector3(x, x / 2, -x), 1));
+        BOOST_TEST(nearest <= clipped.z() / clipped.w());
+    }
+
+    // The front face is at the nearest depth
+    Vector4 front = viewProjection.transform(Vector4(box.origin - Vector3(16, 0, 0), 1));
+    BOOST_TEST(std::abs(nearest - front.z() / front.w()) < 1e-9);
+
+    // Boxes reaching behind the viewer and invalid ones can be anywhere
+    BOOST_TEST(scene::DepthSortedTraversal::getNearestDepth(viewProjection, AABB(Vector3(0, 0, 0), Vector3(64, 64, 64))) == -1);
+    BOOST_TEST(scene::DepthSortedTraversal::getNearestDepth(viewProjection, AABB()) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(traversalIsFrontToBack)
+{
+    std::vector<TestBrushPtr> brushes = generateMap(8);
+    scene::Octree octree;
+
+    for (const TestBrushPtr& brush : brushes)
+    {
+        octree.link(brush);
+    }
+
+    Click click;
+    click.origin = MAP_ORIGIN + Vector3(100, 50, 20);
+    click.angles = Vector3(-10, 30, 0);
+
+    render::View view = constructCameraView(click);
+    Matrix4 viewProjection = view.GetProjection().getMultipliedBy(view.GetModelview());
+
+    // Members outside the volume are left out as well
+    std::set<scene::INode*> expected;
+    foreachNodeInVolume(*octree.getRoot(), view, [&](const scene::INodePtr& node)
+    {
+        if (view.TestAABB(node->worldAABB()) != VOLUME_OUTSIDE)
+        {
+            expected.insert(node.get());
+        }
+        return true;
+    });
+
+    std::set<scene::INode*> visited;
+    double lastDepth = -1;
+    double lastContinueDepth = -1;
+
+    scene::DepthSortedTraversal traversal(view);
+
+    bool completed = traversal.traverse(*octree.getRoot(), [&](const scene::INodePtr& node)
+    {
+        double depth = scene::DepthSortedTraversal::getNearestDepth(viewProjection, node->worldAABB());
+
+        BOOST_TEST_REQUIRE(depth >= lastDepth);
+        lastDepth = depth;
+
+        visited.insert(node.get());
+        return true;
+    },
+    [&](double depth)
+    {
+        BOOST_TEST_REQUIRE(depth >= lastContinueDepth);
+        lastContinueDepth = depth;
+        return true;
+    }, true);
+
+    BOOST_TEST(completed);
+    BOOST_TEST((visited == expected));
+
+    // Stopping at some depth leaves out everything behind
+    std::size_t numVisited = 0;
+
+    completed = traversal.traverse(*octree.getRoot(), [&](const scene::INodePtr& node)
+    {
+        ++numVisited;
+        return true;
+    },
+    [&](double depth)
+    {
+        return depth < 0.9;
+    }, true);
+
+    BOOST_TEST(!completed);
+    BOOST_TEST(numVisited < visited.size());
+}
@@ -2,9 +2,22 @@
 #include <boost/test/included/unit_test.hpp>
 
 #include "VFSFixture.h"
+#include "ShadersTestData.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#include "os/fs.h"
+#include "radiant/WorkStealingScheduler.h"
 #include "radiant/shaders/ShaderFileLoader.h"
 #include "radiant/shaders/textures/GLTextureManager.h"
+#include "radiant/shaders/textures/ImageKernels.h"
+#include "radiant/shaders/textures/TextureDecodeQueue.h"
 
 namespace shaders
 {
@@ -20,6 +33,7 @@ GLTextureManager& GetTextureManager()
 }
 
 using namespace shaders;
+using namespace shaderstest;
 
 // Replacement for ShaderLibrary used in tests
 struct MockShaderLibrary
@@ -38,16 +52,6 @@ struct MockShaderLibrary
     }
 };
 
-void parseShadersFromPath(vfs::Doom3FileSystem& fs, const std::string& path,
-                          MockShaderLibrary& library)
-{
-    // Walk the filesystem and load .mtr files
-    ShaderFileLoader<MockShaderLibrary> loader(fs, library, path);
-
-    // Instruct the loader to parse MTR files and create ShaderDefinitions
-    loader.parseFiles();
-}
-
 BOOST_FIXTURE_TEST_CASE(loadShaderFiles, VFSFixture)
 {
     static const char* MATERIALS_PATH = "materials/";
@@ -102,3 +106,674 @@ BOOST_FIXTURE_TEST_CASE(loadShaderFiles, VFSFixture)
     BOOST_TEST(hiddenTex2.file.name == "hidden.mtr");
     BOOST_TEST(hiddenTex2.file.visibility == vfs::Visibility::HIDDEN);
 }
+
+namespace
+{
+    // A VFS root holding a single material file, which is removed at the end of the test
+    struct MaterialFileFixture
+    {
+        fs::path root;
+        vfs::Doom3FileSystem fs;
+
+        MaterialFileFixture() :
+            root(fs::temp_directory_path() / ("shadersTest" + std::to_string(std::random_device()())))
+        {
+            fs::create_directories(root / "materials");
+        }
+
+        void writeFile(const std::string& contents)
+        {
+            std::ofstream((root / "materials" / "test.mtr").string()) << contents;
+
+            vfs::VirtualFileSystem::ExtensionSet pakExtensions;
+            vfs::SearchPaths searchPaths;
+            searchPaths.insertIfNotExists(root.string() + "/");
+
+            fs.initialise(searchPaths, pakExtensions);
+        }
+
+        ~MaterialFileFixture()
+        {
+            fs.shutdown();
+            fs::remove_all(root);
+        }
+    };
+}
+
+BOOST_FIXTURE_TEST_CASE(splitMaterialBlocks, MaterialFileFixture)
+{
+    writeFile(
+        "// leading comment { with a brace\n"
+        "/* delimited\n"
+        "   comment */ textures/test/first // trailing comment\n"
+        "{\n"
+        "\tdiffusemap textures/test/first_d // a comment inside\n"
+        "\t{\n"
+        "\t\tblend add\n"
+        "\t\tmap \"textures/test/glow\"\n"
+        "\t}\n"
+        "}\n"
+        "\n"
+        "table   sinTable { { 0, 1 } }\n"
+        "\n"
+        "textures/test/second { qer_editorimage textures/test/second_ed }\n"
+        "particle sparks { { count 10 } }\n"
+        "textures/test/unterminated { diffusemap _white\n"
+    );
+
+    RecordingShaderLibrary library;
+    parseShadersFromPath(fs, "materials/", library);
+
+    std::vector<std::string> expectedNames = { "sinTable", "textures/test/first",
+                                               "textures/test/second", "textures/test/unterminated" };
+    std::sort(library.addedNames.begin(), library.addedNames.end());
+    BOOST_TEST(library.addedNames == expectedNames);
+
+    // The block contents are passed on verbatim, excluding the outer braces
+    BOOST_TEST(library.shaderDefs.at("textures/test/first").shaderTemplate->getBlockContents() ==
+        "\n"
+        "\tdiffusemap textures/test/first_d // a comment inside\n"
+        "\t{\n"
+        "\t\tblend add\n"
+        "\t\tmap \"textures/test/glow\"\n"
+        "\t}\n");
+    BOOST_TEST(library.shaderDefs.at("textures/test/second").shaderTemplate->getBlockContents() ==
+        " qer_editorimage textures/test/second_ed ");
+    BOOST_TEST(library.shaderDefs.at("textures/test/unterminated").shaderTemplate->getBlockContents() ==
+        " diffusemap _white\n");
+}
+
+BOOST_FIXTURE_TEST_CASE(splitMaterialBlocksVerbatim, MaterialFileFixture)
+{
+    // Parentheses and quotes are part of the names, braces within quoted
+    // strings are counted like any other brace
+    writeFile(
+        "textures/test/foo(1)\n"
+        "{\n"
+        "\tdescription \"open { brace\"\n"
+        "\tdiffusemap textures/test/foo_d\n"
+        "\t}\n"
+        "}\n"
+        "\"textures/test/quoted\" { diffusemap _white }\n"
+    );
+
+    RecordingShaderLibrary library;
+    parseShadersFromPath(fs, "materials/", library);
+
+    std::vector<std::string> expectedNames = { "textures/test/foo(1)", "\"textures/test/quoted\"" };
+    BOOST_TEST(library.addedNames == expectedNames);
+
+    BOOST_TEST(library.shaderDefs.at("textures/test/foo(1)").shaderTemplate->getBlockContents() ==
+        "\n"
+        "\tdescription \"open { brace\"\n"
+        "\tdiffusemap textures/test/foo_d\n"
+        "\t}\n");
+    BOOST_TEST(library.shaderDefs.at("\"textures/test/quoted\"").shaderTemplate->getBlockContents() ==
+        " diffusemap _white ");
+}
+
+BOOST_FIXTURE_TEST_CASE(cachedMaterialsMatchParsedOnes, MaterialFileFixture)
+{
+    writeFile(
+        "table sinTable { { 0, 1 } }\n"
+        "textures/test/first { diffusemap textures/test/first_d { blend add } }\n"
+        "skin some_skin { textures/test/first textures/test/second }\n"
+        "textures/test/second { qer_editorimage textures/test/second_ed }\n"
+    );
+
+    std::string cacheFile = (root / "materials.cache").string();
+
+    RecordingShaderLibrary parsed;
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        parseShadersFromPath(fs, "materials/", parsed, nullptr, &cache);
+        cache.save();
+    }
+
+    // The next session gets the same declarations from the cache
+    RecordingShaderLibrary cached;
+    parser::DeclFileCache cache(cacheFile);
+    cache.load();
+
+    parseShadersFromPath(fs, "materials/", cached, nullptr, &cache);
+
+    std::vector<std::string> expectedNames = { "sinTable", "textures/test/first", "textures/test/second" };
+    BOOST_TEST(parsed.addedNames == expectedNames);
+    BOOST_TEST(cached.addedNames == expectedNames);
+    BOOST_TEST(cached.tables == parsed.tables);
+
+    for (const auto& pair : parsed.shaderDefs)
+    {
+        const ShaderDefinition& def = cached.shaderDefs.at(pair.first);
+
+        BOOST_TEST(def.shaderTemplate->getBlockContents() == pair.second.shaderTemplate->getBlockContents());
+        BOOST_TEST(def.file.name == "test.mtr");
+    }
+
+    // The loader uses the cached record as long as the file is unchanged
+    parser::DeclWriter writer;
+    writer.writeSize(1);
+    writer.writeBool(false);
+    writer.writeString("textures/test/from_cache");
+    writer.writeString(" diffusemap _white ");
+
+    cache.store("materials/test.mtr", fs.getFileStamp("materials/test.mtr"), writer.getData());
+    cache.save();
+
+    parser::DeclFileCache injectedCache(cacheFile);
+    injectedCache.load();
+
+    RecordingShaderLibrary injected;
+    parseShadersFromPath(fs, "materials/", injected, nullptr, &injectedCache);
+
+    BOOST_TEST(injected.addedNames == std::vector<std::string>{ "textures/test/from_cache" });
+}
+
+BOOST_AUTO_TEST_CASE(decodeWithoutScheduler)
+{
+    shaders::TextureDecodeQueue queue(4);
+    BOOST_TEST(!queue.hasTaskScheduler());
+
+    Buffer tga = createTGA(16, 8, 7);
+    int uploadedSeed = -1;
+
+    queue.add([&]() { return decodeTGA(tga); },
+              [&](const ImagePtr& image) { uploadedSeed = getSeed(image); });
+
+    // Uploaded before add() returns
+    BOOST_TEST(uploadedSeed == 7);
+    BOOST_TEST(queue.getNumPendingImages() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(queueIsBounded)
+{
+    radiant::WorkStealingScheduler scheduler(4);
+
+    const std::size_t MAX_QUEUED = 6;
+    shaders::TextureDecodeQueue queue(MAX_QUEUED);
+    queue.setTaskScheduler(&scheduler);
+
+    std::atomic<std::size_t> numCallbacks(0);
+    queue.setImagesAvailableCallback([&]() { numCallbacks++; });
+
+    std::vector<Buffer> files;
+
+    for (std::size_t i = 0; i < 50; ++i)
+    {
+        files.push_back(createTGA(32, 32, static_cast<unsigned char>(i)));
+    }
+
+    std::vector<int> uploaded;
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        queue.add([&, i]() { return decodeTGA(files[i]); },
+                  [&, i](const ImagePtr& image)
+        {
+            BOOST_TEST_REQUIRE(getSeed(image) == static_cast<int>(i));
+            uploaded.push_back(static_cast<int>(i));
+        });
+    }
+
+    BOOST_TEST(queue.getNumPendingImages() == files.size());
+
+    // Upload a few images per "frame", the queue never grows beyond its limit
+    while (queue.getNumPendingImages() > 0)
+    {
+        BOOST_TEST_REQUIRE(queue.getNumQueuedImages() <= MAX_QUEUED);
+        BOOST_TEST_REQUIRE(queue.processDecodedImages(2) <= 2);
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    BOOST_TEST(uploaded.size() == files.size());
+    BOOST_TEST(numCallbacks > 0);
+}
+
+BOOST_AUTO_TEST_CASE(failedDecodesAreUploadedEmpty)
+{
+    radiant::WorkStealingScheduler scheduler(2);
+
+    shaders::TextureDecodeQueue queue(4);
+    queue.setTaskScheduler(&scheduler);
+
+    std::size_t numEmpty = 0;
+
+    queue.add([]() -> ImagePtr { throw std::runtime_error("Corrupt file"); },
+              [&](const ImagePtr& image) { numEmpty += image ? 0 : 1; });
+    queue.add([]() { return ImagePtr(); },
+              [&](const ImagePtr& image) { numEmpty += image ? 0 : 1; });
+
+    queue.flush();
+
+    BOOST_TEST(numEmpty == 2);
+    BOOST_TEST(queue.getNumPendingImages() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(levelSizes)
+{
+    BOOST_TEST(TextureResidency::getNumLevels(1, 1) == 1);
+    BOOST_TEST(TextureResidency::getNumLevels(512, 512) == 10);
+    BOOST_TEST(TextureResidency::getNumLevels(256, 1024) == 11);
+
+    BOOST_TEST(TextureResidency::getLevelBytes(16 * MB, 0) == 16 * MB);
+    BOOST_TEST(TextureResidency::getLevelBytes(16 * MB, 2) == MB);
+    BOOST_TEST(TextureResidency::getLevelBytes(16 * MB, TextureResidency::EVICTED) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(noChangesWithinBudget)
+{
+    TextureResidency residency;
+    residency.setBudget(10 * MB);
+
+    for (TextureResidency::TextureId id = 1; id <= 10; ++id)
+    {
+        addTexture(residency, id, MB);
+    }
+
+    residency.nextFrame();
+
+    BOOST_TEST(residency.getResidentBytes() == 10 * MB);
+    BOOST_TEST(residency.selectChanges().empty());
+
+    // No limit at all
+    residency.setBudget(0);
+    addTexture(residency, 11, 100 * MB);
+    residency.nextFrame();
+
+    BOOST_TEST(residency.selectChanges().empty());
+}
+
+BOOST_AUTO_TEST_CASE(leastRecentlyUsedAreReducedFirst)
+{
+    TextureResidency residency;
+
+    for (TextureResidency::TextureId id = 1; id <= 8; ++id)
+    {
+        addTexture(residency, id, MB);
+    }
+
+    // Draw the textures in reverse order over a few frames
+    for (TextureResidency::TextureId id = 8; id >= 1; --id)
+    {
+        residency.nextFrame();
+        residency.markUsed(id);
+    }
+
+    residency.nextFrame();
+
+    // Reducing two textures frees 2 * 15/16 MB
+    residency.setBudget(6 * MB + MB / 2);
+
+    auto changes = residency.selectChanges();
+
+    BOOST_TEST_REQUIRE(changes.size() == 2);
+    BOOST_TEST(changes[0].texture == 8);
+    BOOST_TEST(changes[1].texture == 7);
+    BOOST_TEST(changes[0].firstLevel == std::size_t(TextureResidency::REDUCED_LEVEL));
+    BOOST_TEST(residency.getResidentBytes() <= residency.getBudget());
+    BOOST_TEST(residency.getNumReductions() == 2);
+    BOOST_TEST(residency.getNumEvictions() == 0);
+
+    // Pending changes are not selected again
+    BOOST_TEST(residency.selectChanges().empty());
+}
+
+BOOST_AUTO_TEST_CASE(evictWhenReducingIsNotEnough)
+{
+    TextureResidency residency;
+
+    for (TextureResidency::TextureId id = 1; id <= 4; ++id)
+    {
+        addTexture(residency, id, MB);
+    }
+
+    residency.nextFrame();
+    residency.markUsed(4);
+
+    // Texture 4 has been drawn in this frame, the other ones have to go
+    residency.setBudget(MB);
+
+    auto changes = residency.selectChanges();
+    applyChanges(residency, changes);
+
+    BOOST_TEST(changes.size() == 3);
+    BOOST_TEST(residency.getResidentBytes() == MB);
+    BOOST_TEST(residency.getNumEvictions() == 3);
+    BOOST_TEST(residency.getNumReductions() == 0);
+
+    for (const auto& change : changes)
+    {
+        BOOST_TEST(change.texture != 4);
+        BOOST_TEST(change.firstLevel == std::size_t(TextureResidency::EVICTED));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reloadWhenDrawnAgain)
+{
+    TextureResidency residency;
+
+    addTexture(residency, 1, MB);
+    addTexture(residency, 2, MB);
+
+    residency.nextFrame();
+    residency.setBudget(MB + MB / 2);
+
+    applyChanges(residency, residency.selectChanges());
+
+    BOOST_TEST(residency.getNumReductions() == 1);
+    BOOST_TEST(residency.takeReloadRequests().empty());
+
+    // Drawing both textures requests a reload of the reduced one, once
+    residency.nextFrame();
+    residency.markUsed(1);
+    residency.markUsed(2);
+    residency.markUsed(1);
+    residency.markUsed(2);
+
+    auto requests = residency.takeReloadRequests();
+
+    BOOST_TEST_REQUIRE(requests.size() == 1);
+    BOOST_TEST(residency.getNumReloads() == 1);
+
+    residency.setResident(requests.front(), MB, TextureResidency::getNumLevels(512, 512), 0);
+
+    // Both have been drawn in this frame, nothing is changed
+    BOOST_TEST(residency.getResidentBytes() == 2 * MB);
+    BOOST_TEST(residency.selectChanges().empty());
+
+    // Removed textures are no longer accounted
+    residency.remove(1);
+    residency.markUsed(1);
+
+    BOOST_TEST(residency.getResidentBytes() == MB);
+    BOOST_TEST(residency.takeReloadRequests().empty());
+}
+
+namespace
+{
+    // The outputs of the per-pixel implementations the map expressions used
+    // before the kernels were introduced, for a 3x2 input
+
+    const Pixels INPUT =
+    {
+        106, 255, 184, 238, 0, 32, 77, 255, 37, 60, 23, 101, 47, 99, 88, 171,
+        101, 239, 137, 216, 107, 80, 175, 134
+    };
+
+    const Pixels SECOND_INPUT =
+    {
+        111, 47, 6, 238, 140, 242, 111, 124, 107, 82, 84, 39, 52, 178, 158, 30,
+        76, 124, 68, 161, 159, 209, 135, 174
+    };
+
+    const Pixels HEIGHTMAP =
+    {
+        231, 128, 202, 255, 22, 128, 200, 255, 135, 128, 255, 255, 244, 127, 179, 255,
+        244, 127, 180, 255, 3, 127, 155, 255
+    };
+
+    const Pixels ADDNORMALS =
+    {
+        108, 151, 95, 255, 70, 137, 94, 255, 72, 71, 54, 255, 50, 138, 123, 255,
+        88, 182, 102, 255, 133, 144, 155, 255
+    };
+
+    const Pixels ADD =
+    {
+        108, 151, 95, 238, 70, 137, 94, 190, 72, 71, 54, 70, 50, 138, 123, 100,
+        88, 182, 102, 188, 133, 144, 155, 154
+    };
+
+    const Pixels SMOOTHNORMALS =
+    {
+        73, 131, 120, 255, 73, 131, 120, 255, 73, 131, 120, 255, 60, 124, 108, 255,
+        60, 124, 108, 255, 60, 124, 108, 255
+    };
+
+    const Pixels SCALE =
+    {
+        53, 255, 55, 255, 0, 64, 23, 255, 18, 120, 7, 172, 24, 198, 26, 255,
+        50, 255, 41, 255, 54, 160, 53, 228
+    };
+
+    const Pixels MAKEALPHA =
+    {
+        255, 255, 255, 181, 255, 255, 255, 36, 255, 255, 255, 40, 255, 255, 255, 78,
+        255, 255, 255, 159, 255, 255, 255, 120
+    };
+
+    const Pixels RESAMPLE =
+    {
+        106, 255, 184, 238, 42, 121, 119, 248, 7, 37, 66, 224, 29, 54, 33, 131,
+        37, 60, 23, 101, 66, 151, 120, 193, 66, 161, 117, 214, 70, 150, 117, 207,
+        79, 91, 122, 143, 83, 73, 124, 122, 47, 99, 88, 171, 79, 182, 117, 197,
+        102, 207, 144, 199, 105, 111, 167, 150, 107, 80, 175, 134
+    };
+
+    struct Size { std::size_t width, height; };
+
+    // Odd sizes exercise the remainders of the vectorised loops, the large
+    // one is split across threads
+    const Size SIZES[] = { { 1, 1 }, { 1, 7 }, { 9, 1 }, { 2, 2 }, { 37, 23 }, { 64, 64 }, { 613, 401 } };
+
+    void checkEqual(const Pixels& result, const Pixels& expected, const std::string& what, const Size& size)
+    {
+        BOOST_TEST_INFO(what << " " << size.width << "x" << size.height);
+        BOOST_TEST_REQUIRE(result.size() == expected.size());
+        BOOST_TEST(std::memcmp(result.data(), expected.data(), result.size()) == 0);
+    }
+
+    // Runs the kernel with the unthreaded scalar implementation, which the
+    // other configurations have to match exactly
+    Pixels computeScalar(std::size_t size, const std::function<void(byte*)>& kernel)
+    {
+        kernels::setInstructionSet(kernels::InstructionSet::Scalar);
+
+        Pixels out(size);
+        kernel(out.data());
+
+        kernels::setInstructionSet(kernels::InstructionSet::AVX2);
+
+        return out;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kernelsMatchReference)
+{
+    const std::size_t width = 3, height = 2, numPixels = width * height;
+    const float factors[4] = { 0.5f, 2.0f, 0.3f, 1.7f };
+
+    forEachConfiguration([&](const std::string& config)
+    {
+        const Size size = { width, height };
+        Pixels out(INPUT.size());
+
+        kernels::heightMapToNormals(INPUT.data(), out.data(), width, height, 7.3f);
+        checkEqual(out, HEIGHTMAP, "heightmap " + config, size);
+
+        kernels::average(INPUT.data(), SECOND_INPUT.data(), out.data(), numPixels, true);
+        checkEqual(out, ADDNORMALS, "addnormals " + config, size);
+
+        kernels::average(INPUT.data(), SECOND_INPUT.data(), out.data(), numPixels, false);
+        checkEqual(out, ADD, "add " + config, size);
+
+        kernels::smoothNormals(INPUT.data(), out.data(), width, height);
+        checkEqual(out, SMOOTHNORMALS, "smoothnormals " + config, size);
+
+        kernels::scale(INPUT.data(), out.data(), numPixels, factors);
+        checkEqual(out, SCALE, "scale " + config, size);
+
+        kernels::makeAlpha(INPUT.data(), out.data(), numPixels);
+        checkEqual(out, MAKEALPHA, "makealpha " + config, size);
+
+        Pixels resampled(RESAMPLE.size());
+        kernels::resample(INPUT.data(), width, height, resampled.data(), 5, 3);
+        checkEqual(resampled, RESAMPLE, "resample " + config, { 5, 3 });
+    });
+}
+
+BOOST_AUTO_TEST_CASE(heightMapMatchesScalar)
+{
+    for (const Size& size : SIZES)
+    {
+        Pixels in = createNoise(size.width, size.height, 1);
+
+        for (float scale : { 0.5f, 1.0f, 7.3f })
+        {
+            Pixels expected = computeScalar(in.size(), [&](byte* out)
+            {
+                kernels::heightMapToNormals(in.data(), out, size.width, size.height, scale);
+            });
+
+            forEachConfiguration([&](const std::string& config)
+            {
+                Pixels out(in.size());
+                kernels::heightMapToNormals(in.data(), out.data(), size.width, size.height, scale);
+                checkEqual(out, expected, "heightmap " + config, size);
+            });
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(averagesMatchScalar)
+{
+    for (const Size& size : SIZES)
+    {
+        Pixels one = createNoise(size.width, size.height, 2);
+        Pixels two = createNoise(size.width, size.height, 3);
+        std::size_t numPixels = size.width * size.height;
+
+        Pixels expectedNormals = computeScalar(one.size(), [&](byte* out)
+        {
+            kernels::average(one.data(), two.data(), out, numPixels, true);
+        });
+        Pixels expectedAdd = computeScalar(one.size(), [&](byte* out)
+        {
+            kernels::average(one.data(), two.data(), out, numPixels, false);
+        });
+
+        forEachConfiguration([&](const std::string& config)
+        {
+            Pixels out(one.size());
+
+            kernels::average(one.data(), two.data(), out.data(), numPixels, true);
+            checkEqual(out, expectedNormals, "addnormals " + config, size);
+
+            kernels::average(one.data(), two.data(), out.data(), numPixels, false);
+            checkEqual(out, expectedAdd, "add " + config, size);
+        });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(smoothNormalsMatchesScalar)
+{
+    for (const Size& size : SIZES)
+    {
+        Pixels in = createNoise(size.width, size.height, 4);
+        Pixels expected = computeScalar(in.size(), [&](byte* out)
+        {
+            kernels::smoothNormals(in.data(), out, size.width, size.height);
+        });
+
+        forEachConfiguration([&](const std::string& config)
+        {
+            Pixels out(in.size());
+            kernels::smoothNormals(in.data(), out.data(), size.width, size.height);
+            checkEqual(out, expected, "smoothnormals " + config, size);
+        });
+    }
+
+    // Saturated neighbourhoods
+    Pixels white(16 * 4 * 4, 255);
+    Pixels out(white.size());
+    kernels::smoothNormals(white.data(), out.data(), 16, 4);
+    BOOST_TEST((out == white));
+}
+
+BOOST_AUTO_TEST_CASE(pixelKernelsMatchScalar)
+{
+    const float factors[][4] = { { 1, 1, 1, 1 }, { 0.5f, 2.0f, 0.3f, 1.7f }, { 0, 0.25f, 3, 1000 } };
+
+    for (const Size& size : SIZES)
+    {
+        Pixels in = createNoise(size.width, size.height, 5);
+        std::size_t numPixels = size.width * size.height;
+
+        Pixels expectedInvertColour(in), expectedInvertAlpha(in), expectedIntensity(in.size());
+
+        for (std::size_t i = 0; i < in.size(); i += 4)
+        {
+            for (std::size_t c = 0; c < 3; ++c) expectedInvertColour[i + c] = 255 - in[i + c];
+            expectedInvertAlpha[i + 3] = 255 - in[i + 3];
+            std::memset(&expectedIntensity[i], in[i], 4);
+        }
+
+        std::vector<Pixels> expectedScale;
+
+        for (const auto& factor : factors)
+        {
+            expectedScale.push_back(computeScalar(in.size(), [&](byte* out)
+            {
+                kernels::scale(in.data(), out, numPixels, factor);
+            }));
+        }
+
+        Pixels expectedAlpha = computeScalar(in.size(), [&](byte* out)
+        {
+            kernels::makeAlpha(in.data(), out, numPixels);
+        });
+
+        forEachConfiguration([&](const std::string& config)
+        {
+            Pixels out(in.size());
+
+            for (std::size_t i = 0; i < expectedScale.size(); ++i)
+            {
+                kernels::scale(in.data(), out.data(), numPixels, factors[i]);
+                checkEqual(out, expectedScale[i], "scale " + config, size);
+            }
+
+            kernels::invert(in.data(), out.data(), numPixels, true, false);
+            checkEqual(out, expectedInvertColour, "invertcolor " + config, size);
+
+            kernels::invert(in.data(), out.data(), numPixels, false, true);
+            checkEqual(out, expectedInvertAlpha, "invertalpha " + config, size);
+
+            kernels::makeIntensity(in.data(), out.data(), numPixels);
+            checkEqual(out, expectedIntensity, "makeintensity " + config, size);
+
+            kernels::makeAlpha(in.data(), out.data(), numPixels);
+            checkEqual(out, expectedAlpha, "makealpha " + config, size);
+        });
+    }
+}
+
+BOOST_AUTO_TEST_CASE(resampleMatchesScalar)
+{
+    const Size inputs[] = { { 1, 1 }, { 5, 3 }, { 64, 64 }, { 300, 200 } };
+    const Size outputs[] = { { 1, 1 }, { 3, 9 }, { 64, 32 }, { 128, 128 }, { 517, 301 } };
+
+    for (const Size& input : inputs)
+    {
+        Pixels in = createNoise(input.width, input.height, 6);
+
+        for (const Size& output : outputs)
+        {
+            Pixels expected = computeScalar(output.width * output.height * 4, [&](byte* out)
+            {
+                kernels::resample(in.data(), input.width, input.height, out, output.width, output.height);
+            });
+
+            forEachConfiguration([&](const std::string& config)
+            {
+                Pixels out(expected.size());
+                kernels::resample(in.data(), input.width, input.height, out.data(), output.width, output.height);
+                checkEqual(out, expected, "resample from " + std::to_string(input.width) + "x" +
+                    std::to_string(input.height) + " " + config, output);
+            });
+        }
+    }
+}
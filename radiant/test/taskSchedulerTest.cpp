@@ -0,0 +1,150 @@
+#define BOOST_TEST_MODULE taskSchedulerTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <set>
+
+#include "radiant/WorkStealingScheduler.h"
+#include "ThreadedDefLoader.h"
+
+BOOST_AUTO_TEST_CASE(parallelForVisitsEachIndexOnce)
+{
+    radiant::WorkStealingScheduler scheduler(4);
+    BOOST_TEST(scheduler.getNumWorkers() == 4);
+
+    std::vector<std::atomic<int>> visits(10000);
+
+    for (std::atomic<int>& count : visits)
+    {
+        count = 0;
+    }
+
+    scheduler.parallelFor(visits.size(), [&](std::size_t i)
+    {
+        ++visits[i];
+    });
+
+    for (std::atomic<int>& count : visits)
+    {
+        BOOST_TEST_REQUIRE(count == 1);
+    }
+
+    // Nothing to do
+    scheduler.parallelFor(0, [&](std::size_t) { BOOST_FAIL("no index expected"); });
+
+    // Exceptions are passed on to the caller
+    BOOST_CHECK_THROW(scheduler.parallelFor(100, [](std::size_t i)
+    {
+        if (i == 57) throw std::runtime_error("57");
+    }), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(nestedTasksDontStarveThePool)
+{
+    // With two workers, the outer tasks would block all workers if waiting
+    // didn't execute the inner tasks
+    radiant::WorkStealingScheduler scheduler(2);
+
+    std::atomic<std::size_t> innerCalls(0);
+    std::vector<std::shared_future<std::size_t>> outer;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        outer.push_back(scheduler.submit(std::function<std::size_t()>([&]()
+        {
+            std::shared_future<void> inner = scheduler.submit(std::function<void()>([&]()
+            {
+                scheduler.parallelFor(50, [&](std::size_t) { ++innerCalls; });
+            }));
+
+            scheduler.waitFor(inner);
+
+            return std::size_t(1);
+        })));
+    }
+
+    std::size_t sum = 0;
+
+    for (const std::shared_future<std::size_t>& result : outer)
+    {
+        scheduler.waitFor(result);
+        sum += result.get();
+    }
+
+    BOOST_TEST(sum == 8);
+    BOOST_TEST(innerCalls == 8 * 50);
+
+    // Exceptions end up in the future
+    std::shared_future<void> failing = scheduler.submit(std::function<void()>([]()
+    {
+        throw std::runtime_error("failed");
+    }));
+
+    BOOST_CHECK_THROW(failing.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(pendingTasksAreFinishedOnDestruction)
+{
+    std::atomic<int> executed(0);
+
+    {
+        radiant::WorkStealingScheduler scheduler(1);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            scheduler.enqueue([&]()
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                ++executed;
+            });
+        }
+
+        BOOST_TEST(scheduler.getStatistics().queueDepth > 0);
+        BOOST_TEST(!scheduler.isWorkerThread());
+    }
+
+    BOOST_TEST(executed == 100);
+}
+
+BOOST_AUTO_TEST_CASE(parseFilesInParallelMergesInOrder)
+{
+    radiant::WorkStealingScheduler scheduler(4);
+
+    std::vector<std::string> files;
+
+    for (int i = 0; i < 500; ++i)
+    {
+        files.push_back("file" + std::to_string(i));
+    }
+
+    std::vector<std::string> merged;
+
+    util::parseFilesInParallel<std::string, std::string>(scheduler, files,
+        [](const std::string& file)
+        {
+            // Parse times differ a lot between files
+            std::this_thread::sleep_for(std::chrono::microseconds(file.length() % 3 * 50));
+            return file + ".parsed";
+        },
+        [&](const std::string& file, std::string& result)
+        {
+            merged.push_back(result);
+        });
+
+    BOOST_TEST_REQUIRE(merged.size() == files.size());
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        BOOST_TEST_REQUIRE(merged[i] == files[i] + ".parsed");
+    }
+
+    TaskStatistics stats = scheduler.getStatistics();
+
+    BOOST_TEST(stats.numWorkers == 4);
+    BOOST_TEST(stats.tasksExecuted > 0);
+
+    BOOST_TEST_MESSAGE("Executed " << stats.tasksExecuted << " tasks in " << stats.totalTaskTime.count()
+        << " us, the longest took " << stats.longestTaskTime.count() << " us, queue depth "
+        << stats.queueDepth);
+}
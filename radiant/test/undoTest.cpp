@@ -0,0 +1,303 @@
+#define BOOST_TEST_MODULE undoTest
+#include <boost/test/included/unit_test.hpp>
+
+#include <vector>
+
+#include "MockModules.h"
+#include "BasicUndoMemento.h"
+#include "radiant/undo/Stack.h"
+
+namespace
+{
+    typedef std::vector<int> Values;
+    typedef undo::BasicUndoMemento<Values> ValuesMemento;
+
+    // Memento holding the values changed by an operation
+    struct ChangedValues :
+        public IUndoMemento
+    {
+        std::vector<std::pair<std::size_t, int>> changes;
+
+        std::size_t getMemoryUsage() const override
+        {
+            return sizeof(*this) + changes.capacity() * sizeof(changes[0]);
+        }
+    };
+
+    // Undoable saving its full state, compacting it into the changed values
+    struct UndoableValues :
+        public IUndoable
+    {
+        Values values;
+        undo::UndoStack* stack = nullptr;
+
+        UndoableValues(std::size_t count) :
+            values(count, 0)
+        {}
+
+        void set(std::size_t index, int value)
+        {
+            if (stack)
+            {
+                stack->save(*this);
+                stack = nullptr; // save once per operation, like the UndoStackFiller
+            }
+
+            values[index] = value;
+        }
+
+        IUndoMementoPtr exportState() const override
+        {
+            return std::make_shared<ValuesMemento>(values);
+        }
+
+        void importState(const IUndoMementoPtr& state) override
+        {
+            auto changed = std::dynamic_pointer_cast<ChangedValues>(state);
+
+            if (changed)
+            {
+                for (const auto& pair : changed->changes)
+                {
+                    values[pair.first] = pair.second;
+                }
+                return;
+            }
+
+            values = std::static_pointer_cast<ValuesMemento>(state)->data();
+        }
+
+        IUndoMementoPtr compactState(const IUndoMementoPtr& state) const override
+        {
+            const Values& saved = std::static_pointer_cast<ValuesMemento>(state)->data();
+            auto changed = std::make_shared<ChangedValues>();
+
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                if (saved[i] != values[i])
+                {
+                    changed->changes.push_back(std::make_pair(i, saved[i]));
+                }
+            }
+
+            return changed->changes.empty() ? IUndoMementoPtr() : changed;
+        }
+    };
+}
+
+BOOST_AUTO_TEST_CASE(operationsAreReducedToChanges)
+{
+    undo::UndoStack stack;
+    UndoableValues undoable(10000);
+
+    stack.start("change");
+    undoable.stack = &stack;
+    undoable.set(5, 1);
+    undoable.set(6, 2);
+    BOOST_TEST(stack.finish("change"));
+
+    // The full copy of 10000 values should be gone
+    BOOST_TEST(stack.size() == 1);
+    BOOST_TEST(stack.getMemoryUsage() > 0);
+    BOOST_TEST(stack.getMemoryUsage() < 1000);
+
+    // Restoring the delta reverts the changed values
+    stack.back()->restoreSnapshot();
+    BOOST_TEST(undoable.values[5] == 0);
+    BOOST_TEST(undoable.values[6] == 0);
+
+    // An operation leaving the values as they were doesn't keep any state
+    stack.start("noop");
+    undoable.stack = &stack;
+    undoable.set(7, 0);
+    BOOST_TEST(stack.finish("noop"));
+    BOOST_TEST(stack.size() == 2);
+
+    stack.pop_back();
+    stack.pop_front();
+    BOOST_TEST(stack.getMemoryUsage() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(memoryBudgetDropsOldestOperations)
+{
+    undo::UndoStack stack;
+    UndoableValues undoable(1000);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        stack.start("op");
+        undoable.stack = &stack;
+
+        for (std::size_t v = 0; v < 100; ++v)
+        {
+            undoable.set(v * 10, i + 1);
+        }
+
+        stack.finish("op");
+    }
+
+    BOOST_TEST(stack.size() == 100);
+
+    std::size_t perOperation = stack.getMemoryUsage() / 100;
+    stack.limitMemoryUsage(perOperation * 10);
+
+    BOOST_TEST(stack.size() == 10);
+    BOOST_TEST(stack.getMemoryUsage() <= perOperation * 10);
+
+    // Undoing the remaining operations goes back to the state after the 90th
+    while (!stack.empty())
+    {
+        stack.back()->restoreSnapshot();
+        stack.pop_back();
+    }
+
+    BOOST_TEST(undoable.values[0] == 90);
+    BOOST_TEST(stack.getMemoryUsage() == 0);
+
+    // The latest operation is kept even if it exceeds the budget
+    stack.start("op");
+    undoable.stack = &stack;
+    undoable.set(0, 1);
+    stack.finish("op");
+    stack.limitMemoryUsage(0);
+    BOOST_TEST(stack.size() == 1);
+}
+
+namespace
+{
+    struct ModuleFixture
+    {
+        MockModuleRegistry registry;
+
+        ModuleFixture()
+        {
+            registry.registerModule(std::make_shared<MockUndoSystem>());
+
+            module::RegistryReference::Instance().setRegistry(registry);
+        }
+    };
+
+    BOOST_GLOBAL_FIXTURE(ModuleFixture);
+
+    MockUndoSystem& getUndoSystem()
+    {
+        return static_cast<MockUndoSystem&>(GlobalUndoSystem());
+    }
+
+    // Single value saving its state before each change, like the scene nodes
+    class UndoableValue :
+        public IUndoable
+    {
+        MockMapFileChangeTracker _tracker;
+        IUndoStateSaver* _undoStateSaver;
+
+    public:
+        int value;
+
+        UndoableValue() :
+            _undoStateSaver(GlobalUndoSystem().getStateSaver(*this, _tracker)),
+            value(0)
+        {}
+
+        ~UndoableValue()
+        {
+            GlobalUndoSystem().releaseStateSaver(*this);
+        }
+
+        void set(int newValue)
+        {
+            _undoStateSaver->save(*this);
+            value = newValue;
+        }
+
+        IUndoMementoPtr exportState() const override
+        {
+            return std::make_shared<undo::BasicUndoMemento<int>>(value);
+        }
+
+        void importState(const IUndoMementoPtr& state) override
+        {
+            value = std::static_pointer_cast<undo::BasicUndoMemento<int>>(state)->data();
+        }
+    };
+
+    // A command changing a value, as an undoable editor function would
+    void setValue(UndoableValue& undoable, int value)
+    {
+        UndoableCommand cmd("setValue");
+        undoable.set(value);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(nestedCommandsFormOneOperation)
+{
+    GlobalUndoSystem().clear();
+
+    UndoableValue first;
+    UndoableValue second;
+
+    {
+        UndoableCommand outer("outer");
+
+        first.set(1);
+        setValue(second, 2);
+
+        // The nested command must not finish the outer operation
+        BOOST_TEST(GlobalUndoSystem().operationStarted());
+
+        setValue(first, 3);
+    }
+
+    BOOST_TEST(!GlobalUndoSystem().operationStarted());
+    BOOST_TEST(GlobalUndoSystem().size() == 1);
+    BOOST_TEST(getUndoSystem().getLastOperationName() == "outer");
+
+    // A single undo reverts the changes of all nested commands
+    GlobalUndoSystem().undo();
+
+    BOOST_TEST(first.value == 0);
+    BOOST_TEST(second.value == 0);
+    BOOST_TEST(GlobalUndoSystem().size() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(commandsJoinAStartedOperation)
+{
+    GlobalUndoSystem().clear();
+
+    UndoableValue undoable;
+
+    // Operations started without an UndoableCommand, like a running script
+    GlobalUndoSystem().start();
+
+    setValue(undoable, 1);
+    setValue(undoable, 2);
+
+    BOOST_TEST(GlobalUndoSystem().operationStarted());
+
+    GlobalUndoSystem().finish("runScript");
+
+    BOOST_TEST(GlobalUndoSystem().size() == 1);
+    BOOST_TEST(getUndoSystem().getLastOperationName() == "runScript");
+
+    GlobalUndoSystem().undo();
+    BOOST_TEST(undoable.value == 0);
+}
+
+BOOST_AUTO_TEST_CASE(sequentialCommandsAreSeparateOperations)
+{
+    GlobalUndoSystem().clear();
+
+    UndoableValue undoable;
+
+    setValue(undoable, 1);
+    setValue(undoable, 2);
+
+    BOOST_TEST(!GlobalUndoSystem().operationStarted());
+    BOOST_TEST(GlobalUndoSystem().size() == 2);
+
+    GlobalUndoSystem().undo();
+    BOOST_TEST(undoable.value == 1);
+
+    GlobalUndoSystem().undo();
+    BOOST_TEST(undoable.value == 0);
+}
@@ -1,7 +1,14 @@
 #define BOOST_TEST_MODULE vfsTest
 #include <boost/test/included/unit_test.hpp>
 
+#include <functional>
+#include <thread>
+
 #include "VFSFixture.h"
+#include "VFSTestData.h"
+#include "os/fs.h"
+
+using namespace vfstest;
 
 BOOST_FIXTURE_TEST_CASE(constructFileSystemModule, VFSFixture)
 {
@@ -88,3 +95,410 @@ BOOST_FIXTURE_TEST_CASE(handleAssetsLst, VFSFixture)
     // returned as an actual file to the calling code.
     BOOST_TEST(fileVis.count("assets.lst") == 0);
 }
+
+BOOST_FIXTURE_TEST_CASE(getFileStamps, VFSFixture)
+{
+    // Loose files are stamped with their own path on disk
+    vfs::FileStamp stamp = fs.getFileStamp("materials/example.mtr");
+
+    BOOST_TEST(!stamp.empty());
+    BOOST_TEST(stamp.physicalPath == srcdir() + "/test/data/vfs_root/materials/example.mtr");
+    BOOST_TEST(stamp.size == fs::file_size(stamp.physicalPath));
+    BOOST_TEST((stamp == fs.getFileStamp("materials/example.mtr")));
+    BOOST_TEST((stamp != fs.getFileStamp("materials/tdm_ai_nobles.mtr")));
+
+    BOOST_TEST(fs.getFileStamp("nothere").empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(readFilesConcurrently, TempFolderFixture)
+{
+    std::vector<TestFile> files = generateFiles(300, 1);
+    std::string pk4 = (folder / "test.pk4").string();
+    writePk4(pk4, files);
+
+    archive::ZipArchive archive(pk4);
+    BOOST_TEST(countFiles(archive) == files.size());
+
+    // Each thread reads every file, interleaving the reads of the others
+    const std::size_t numThreads = 4;
+    std::vector<std::size_t> numMatching(numThreads, 0);
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (std::size_t i = 0; i < files.size(); ++i)
+            {
+                const TestFile& file = files[(i + t * 37) % files.size()];
+
+                if (readFile(archive, file.name) == file.contents)
+                {
+                    ++numMatching[t];
+                }
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (std::size_t count : numMatching)
+    {
+        BOOST_TEST(count == files.size());
+    }
+
+    // Text files are using their own streams too
+    ArchiveTextFilePtr textFile = archive.openTextFile(files[1].name);
+    BOOST_TEST_REQUIRE(textFile);
+
+    std::istream textStream(&textFile->getInputStream());
+    std::string firstWord;
+    textStream >> firstWord;
+    BOOST_TEST(firstWord == files[1].contents.substr(0, firstWord.length()));
+}
+
+BOOST_FIXTURE_TEST_CASE(centralDirectoryCache, TempFolderFixture)
+{
+    std::vector<TestFile> files = generateFiles(50, 2);
+    std::string pk4 = (folder / "cached.pk4").string();
+    std::string cacheFile = (folder / "pk4index.cache").string();
+    writePk4(pk4, files);
+
+    {
+        archive::ZipIndexCache cache(cacheFile);
+        cache.load();
+
+        archive::ZipArchive archive(pk4, &cache);
+        BOOST_TEST(countFiles(archive) == files.size());
+
+        cache.save();
+    }
+
+    BOOST_TEST(fs::exists(cacheFile));
+
+    {
+        archive::ZipIndexCache cache(cacheFile);
+        cache.load();
+
+        // The directory entry is included
+        archive::ZipIndexCache::Records records;
+        BOOST_TEST(cache.lookup(pk4, records));
+        BOOST_TEST(records.size() == files.size() + 1);
+
+        // An archive constructed from the cached index is fully functional
+        archive::ZipArchive archive(pk4, &cache);
+        BOOST_TEST(countFiles(archive) == files.size());
+        BOOST_TEST(readFile(archive, files[3].name) == files[3].contents);
+        BOOST_TEST(readFile(archive, files[8].name) == files[8].contents);
+    }
+
+    // Replace the archive, the cached index is outdated now
+    files = generateFiles(60, 3);
+    writePk4(pk4, files);
+
+    {
+        archive::ZipIndexCache cache(cacheFile);
+        cache.load();
+
+        archive::ZipIndexCache::Records records;
+        BOOST_TEST(!cache.lookup(pk4, records));
+
+        archive::ZipArchive archive(pk4, &cache);
+        BOOST_TEST(countFiles(archive) == files.size());
+        BOOST_TEST(readFile(archive, files[5].name) == files[5].contents);
+
+        cache.save();
+    }
+
+    // A cache referring to a missing archive doesn't produce any hits
+    {
+        archive::ZipIndexCache cache(cacheFile);
+        cache.load();
+
+        archive::ZipIndexCache::Records records;
+        BOOST_TEST(cache.lookup(pk4, records));
+        BOOST_TEST(!cache.lookup((folder / "missing.pk4").string(), records));
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(corruptCentralDirectoryCache, TempFolderFixture)
+{
+    std::vector<TestFile> files = generateFiles(20, 5);
+    std::string pk4 = (folder / "cached.pk4").string();
+    std::string cacheFile = (folder / "pk4index.cache").string();
+    writePk4(pk4, files);
+
+    {
+        archive::ZipIndexCache cache(cacheFile);
+        archive::ZipArchive archive(pk4, &cache);
+        cache.save();
+    }
+
+    // Keep the valid archive entry following the header (magic, version, archive count)
+    std::string validEntry;
+    {
+        std::ifstream stream(cacheFile, std::ios::binary);
+        validEntry.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        BOOST_TEST_REQUIRE(validEntry.length() > 12);
+        validEntry.erase(0, 12);
+    }
+
+    // Writes a cache with a valid header and archive entry, followed by the given entry
+    auto writeCache = [&](const std::function<void(std::ostream&)>& writeEntry)
+    {
+        std::ofstream stream(cacheFile, std::ios::binary);
+        stream.write("DRZI", 4);
+        stream::writeLittleEndian<uint32_t>(stream, 1);
+        stream::writeLittleEndian<uint32_t>(stream, 2);
+        stream.write(validEntry.data(), validEntry.length());
+        writeEntry(stream);
+    };
+
+    auto checkCacheIsDiscarded = [&]()
+    {
+        archive::ZipIndexCache cache(cacheFile);
+        cache.load();
+
+        archive::ZipIndexCache::Records records;
+        BOOST_TEST(!cache.lookup(pk4, records));
+
+        // The archive falls back to reading its central directory
+        archive::ZipArchive archive(pk4, &cache);
+        BOOST_TEST(countFiles(archive) == files.size());
+        BOOST_TEST(readFile(archive, files[2].name) == files[2].contents);
+    };
+
+    // A record count far beyond the size of the file
+    writeCache([](std::ostream& stream)
+    {
+        stream::writeLittleEndian<uint32_t>(stream, 5);
+        stream.write("other", 5);
+        stream::writeLittleEndian<uint64_t>(stream, 1000);
+        stream::writeLittleEndian<int64_t>(stream, 0);
+        stream::writeLittleEndian<uint32_t>(stream, 0xffffffff);
+    });
+    checkCacheIsDiscarded();
+
+    // A string length far beyond the size of the file
+    writeCache([](std::ostream& stream)
+    {
+        stream::writeLittleEndian<uint32_t>(stream, 0xfffffff0);
+        stream.write("other", 5);
+    });
+    checkCacheIsDiscarded();
+
+    // An archive count far beyond the size of the file
+    {
+        std::ofstream stream(cacheFile, std::ios::binary);
+        stream.write("DRZI", 4);
+        stream::writeLittleEndian<uint32_t>(stream, 1);
+        stream::writeLittleEndian<uint32_t>(stream, 0xffffffff);
+        stream.write(validEntry.data(), validEntry.length());
+    }
+    checkCacheIsDiscarded();
+}
+
+namespace
+{
+    void checkModelDefs(const ModelDefs& models, const ModelDefs& expected)
+    {
+        BOOST_TEST_REQUIRE(models.size() == expected.size());
+
+        for (std::size_t i = 0; i < models.size(); ++i)
+        {
+            BOOST_TEST(models[i]->name == expected[i]->name);
+            BOOST_TEST(models[i]->mesh == expected[i]->mesh);
+            BOOST_TEST(models[i]->skin == expected[i]->skin);
+            BOOST_TEST(models[i]->parent == expected[i]->parent);
+            BOOST_TEST((models[i]->anims == expected[i]->anims));
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(unchangedFilesAreTakenFromCache, DefFilesFixture)
+{
+    writeFile("def/a.def", "model a { mesh \"models/a mesh.md5mesh\" anim idle a_idle.md5anim { frame 1 sound snd } }");
+    writeFile("def/b.def", "model b { inherit a skin b_skin }");
+    writeFile("def/c.def", "model c { }");
+    initialiseVfs();
+
+    bool cached = false;
+    ModelDefs parsedA;
+
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        parsedA = getModelDefs(cache, "def/a.def", cached);
+        BOOST_TEST(!cached);
+
+        for (const char* path : { "def/b.def", "def/c.def" })
+        {
+            getModelDefs(cache, path, cached);
+            BOOST_TEST(!cached);
+        }
+
+        cache.save();
+    }
+
+    BOOST_TEST(fs::exists(cacheFile));
+
+    // Change one file, the others are still valid in the next session
+    writeFile("def/b.def", "model b { inherit c mesh b.md5mesh } model b2 { }");
+
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        // The model def is restored without parsing the file again
+        ModelDefs models = getModelDefs(cache, "def/a.def", cached);
+        BOOST_TEST(cached);
+        checkModelDefs(models, parsedA);
+
+        BOOST_TEST_REQUIRE(models.size() == 1);
+        BOOST_TEST(models[0]->mesh == "models/a mesh.md5mesh");
+        BOOST_TEST(models[0]->anims["idle"] == "a_idle.md5anim");
+
+        models = getModelDefs(cache, "def/b.def", cached);
+        BOOST_TEST(!cached);
+        BOOST_TEST_REQUIRE(models.size() == 2);
+        BOOST_TEST(models[0]->parent == "c");
+
+        // c.def is not used in this session, it is dropped on save
+        cache.save();
+    }
+
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        ModelDefs models = getModelDefs(cache, "def/b.def", cached);
+        BOOST_TEST(cached);
+        BOOST_TEST(models.size() == 2);
+
+        getModelDefs(cache, "def/c.def", cached);
+        BOOST_TEST(!cached);
+    }
+
+    // A corrupt cache file is ignored
+    std::ofstream(cacheFile) << "garbage";
+
+    parser::DeclFileCache cache(cacheFile);
+    cache.load();
+
+    getModelDefs(cache, "def/a.def", cached);
+    BOOST_TEST(!cached);
+}
+
+BOOST_FIXTURE_TEST_CASE(oversizedCountsInvalidateCache, DefFilesFixture)
+{
+    writeFile("def/a.def", "model a { mesh a.md5mesh }");
+    initialiseVfs();
+
+    bool cached = false;
+
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+        getModelDefs(cache, "def/a.def", cached);
+        cache.save();
+    }
+
+    // Keep the valid entry following the header (magic, version, entry count)
+    std::string validEntry;
+    uint32_t version = 0;
+    {
+        std::ifstream stream(cacheFile, std::ios::binary);
+        validEntry.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        BOOST_TEST_REQUIRE(validEntry.length() > 12);
+
+        version = static_cast<unsigned char>(validEntry[4]);
+        validEntry.erase(0, 12);
+    }
+
+    // Writes a valid header and entry, followed by an entry with the given record length
+    auto writeCache = [&](uint32_t numEntries, uint32_t dataLength)
+    {
+        std::ofstream stream(cacheFile, std::ios::binary);
+        stream.write("DRDC", 4);
+        stream::writeLittleEndian<uint32_t>(stream, version);
+        stream::writeLittleEndian<uint32_t>(stream, numEntries);
+        stream.write(validEntry.data(), validEntry.length());
+
+        stream::writeLittleEndian<uint32_t>(stream, 9);
+        stream.write("def/b.def", 9);
+        stream::writeLittleEndian<uint32_t>(stream, 0);
+        stream::writeLittleEndian<uint64_t>(stream, 100);
+        stream::writeLittleEndian<int64_t>(stream, 0);
+        stream::writeLittleEndian<uint32_t>(stream, dataLength);
+        stream.write("model", 5);
+    };
+
+    auto isCached = [&]()
+    {
+        parser::DeclFileCache cache(cacheFile);
+        cache.load();
+
+        getModelDefs(cache, "def/a.def", cached);
+        return cached;
+    };
+
+    // The written layout is accepted as long as the counts are sane
+    writeCache(2, 5);
+    BOOST_TEST(isCached());
+
+    // A record length far beyond the size of the file
+    writeCache(2, 0xfffffff0);
+    BOOST_TEST(!isCached());
+
+    // An entry count far beyond the size of the file
+    writeCache(0xffffffff, 5);
+    BOOST_TEST(!isCached());
+}
+
+BOOST_AUTO_TEST_CASE(declReaderReadsWrittenValues)
+{
+    parser::DeclWriter writer;
+    writer.writeUInt32(0xdeadbeef);
+    writer.writeInt32(-5);
+    writer.writeBool(true);
+    writer.writeFloat(1.5f);
+    writer.writeDouble(-0.1);
+    writer.writeString("");
+    writer.writeString(std::string("with\0zero", 9));
+    writer.writeSize(2);
+
+    parser::DeclReader reader(writer.getData());
+    BOOST_TEST(reader.readUInt32() == 0xdeadbeef);
+    BOOST_TEST(reader.readInt32() == -5);
+    BOOST_TEST(reader.readBool());
+    BOOST_TEST(reader.readFloat() == 1.5f);
+    BOOST_TEST(reader.readDouble() == -0.1);
+    BOOST_TEST(reader.readString().empty());
+    BOOST_TEST(reader.readString() == std::string("with\0zero", 9));
+    BOOST_TEST(!reader.atEnd());
+
+    // Two elements of at least four bytes don't fit into the rest of the record
+    BOOST_CHECK_THROW(reader.readCount(4), parser::ParseException);
+
+    // A truncated record throws instead of reading beyond its end
+    std::string truncated = writer.getData().substr(0, 20);
+    parser::DeclReader truncatedReader(truncated);
+
+    truncatedReader.readUInt32();
+    truncatedReader.readInt32();
+    truncatedReader.readBool();
+    truncatedReader.readFloat();
+    BOOST_CHECK_THROW(truncatedReader.readDouble(), parser::ParseException);
+
+    // As does a string longer than the record
+    parser::DeclWriter lengthWriter;
+    lengthWriter.writeSize(100);
+    lengthWriter.writeString("short");
+
+    parser::DeclReader lengthReader(lengthWriter.getData());
+    BOOST_CHECK_THROW(lengthReader.readString(), parser::ParseException);
+}
@@ -109,10 +109,12 @@ std::string EClassTreeBuilder::getInheritancePathRecursive(const IEntityClassPtr
 
 	try 
 	{
-		EntityClassAttribute attribute = eclass->getAttribute(INHERIT_KEY);
+		const EntityClassAttribute& attribute = eclass->getAttribute(INHERIT_KEY);
+		const IEntityClass* eclassParent = eclass->getParent();
 
-		// Don't use empty or derived "inherit" keys
-		if (!attribute.getValue().empty() && !attribute.inherited)
+		// Don't use empty or derived "inherit" keys, the latter are owned by the parent
+		if (!attribute.getValue().empty() && !attribute.inherited &&
+			(eclassParent == nullptr || &eclassParent->getAttribute(INHERIT_KEY) != &attribute))
 		{
 			// Get the inherited eclass first and resolve the path
 			IEntityClassPtr parent = GlobalEntityClassManager().findClass(
@@ -256,11 +256,14 @@ void ModelSelector::preSelectModel()
 // Show the dialog and enter recursive main loop
 ModelSelectorResult ModelSelector::showAndBlock(const std::string& curModel,
                                                 bool showOptions,
-                                                bool showSkins)
+                                                bool showSkins,
+                                                const std::string& title)
 {
     _showSkins = showSkins;
     _preselectedModel = curModel;
 
+    SetTitle(title.empty() ? _(MODELSELECTOR_TITLE) : title);
+
     if (!_populated)
     {
         // Populate the tree of models
@@ -316,10 +319,11 @@ ModelSelectorResult ModelSelector::showAndBlock(const std::string& curModel,
 // calling function
 ModelSelectorResult ModelSelector::chooseModel(const std::string& curModel,
                                                bool showOptions,
-                                               bool showSkins)
+                                               bool showSkins,
+                                               const std::string& title)
 {
     // Use the instance to select a model.
-    return Instance().showAndBlock(curModel, showOptions, showSkins);
+    return Instance().showAndBlock(curModel, showOptions, showSkins, title);
 }
 
 void ModelSelector::onIdleReloadTree(wxIdleEvent& ev)
@@ -357,6 +361,7 @@ void ModelSelector::onModelLoaded(const model::ModelNodePtr& modelNode)
 	_infoTable->Append(_("Total vertices"), string::to_string(model.getVertexCount()));
 	_infoTable->Append(_("Total polys"), string::to_string(model.getPolyCount()));
 	_infoTable->Append(_("Material surfaces"), string::to_string(model.getSurfaceCount()));
+	_infoTable->Append(_("Buffer memory"), string::to_string((model.getRenderMemoryUsage() + 1023) / 1024) + " KiB");
 
 	// Add the list of active materials
 	_materialsList->clear();
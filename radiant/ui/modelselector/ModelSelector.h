@@ -131,7 +131,8 @@ private:
 	// Show the dialog, called internally by chooseModel(). Return the selected model path
 	ModelSelectorResult showAndBlock(const std::string& curModel,
                                      bool showOptions,
-                                     bool showSkins);
+                                     bool showSkins,
+                                     const std::string& title);
 
 	// Helper functions to configure GUI components
     void setupAdvancedPanel(wxWindow* parent);
@@ -181,9 +182,12 @@ public:
 	 *            the dialog was closed.
 	 *
 	 * @showOptions: whether to show the advanced options tab.
+	 *
+	 * @title: the dialog title, leave this empty to use the default one.
 	 */
 	static ModelSelectorResult chooseModel(
-			const std::string& curModel = "", bool showOptions = true, bool showSkins = true);
+			const std::string& curModel = "", bool showOptions = true, bool showSkins = true,
+			const std::string& title = "");
 
 	// Starts the background population thread
     static void Populate();
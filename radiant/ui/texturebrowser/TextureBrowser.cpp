@@ -17,6 +17,7 @@
 
 #include "registry/registry.h"
 #include "shaderlib.h"
+#include "render/TextureResidency.h"
 #include "selection/algorithm/Shader.h"
 #include "selection/shaderclipboard/ShaderClipboard.h"
 
@@ -162,6 +163,9 @@ private:
 
     void drawTextureQuad(GLuint num)
     {
+        // Reloads the texture if it has been evicted to stay within the budget
+        render::TextureResidency::Instance().markUsed(num);
+
         glBindTexture(GL_TEXTURE_2D, num);
         debug::assertNoGlErrors();
         glColor3f(1, 1, 1);
@@ -256,6 +260,8 @@ TextureBrowser::TextureBrowser(wxWindow* parent) :
 
     GlobalMaterialManager().signal_activeShadersChanged().connect(
         sigc::mem_fun(this, &TextureBrowser::onActiveShadersChanged));
+    GlobalMaterialManager().signal_texturesPending().connect(
+        sigc::mem_fun(this, &TextureBrowser::queueDraw));
 
     Connect(wxEVT_IDLE, wxIdleEventHandler(TextureBrowser::onIdle), nullptr, this);
 
@@ -952,6 +958,9 @@ void TextureBrowser::onRender()
         performUpdate();
     }
 
+    // Replace the placeholders of textures loaded in the meantime
+    GlobalMaterialManager().uploadPendingTextures();
+
     draw();
 
     debug::assertNoGlErrors();
@@ -36,6 +36,19 @@ private:
 		{
 			_undoable.importState(_data);
 		}
+
+		// Lets the undoable replace the data with a smaller one,
+		// returns false if the data is not needed at all
+		bool compact()
+		{
+			_data = _undoable.compactState(_data);
+			return static_cast<bool>(_data);
+		}
+
+		std::size_t getMemoryUsage() const
+		{
+			return _data->getMemoryUsage();
+		}
 	};
 
 	// The Snapshot (the list of structs containing Undoable+Data)
@@ -44,10 +57,14 @@ private:
 	// The name of the UndoOperaton
 	std::string _command;
 
+	// Size of this operation in bytes, calculated by compact()
+	std::size_t _memoryUsage;
+
 public:
 	// Constructor
 	Operation(const std::string& command) :
-		_command(command)
+		_command(command),
+		_memoryUsage(0)
 	{}
 
 	const std::string& getName() const
@@ -67,6 +84,31 @@ public:
 		_snapshot.push_front(UndoableState(undoable));
 	}
 
+	// Called when the operation is finished, all the undoables are
+	// still in the state the operation left them in.
+	void compact()
+	{
+		_memoryUsage = sizeof(Operation) + _command.capacity();
+
+		for (auto i = _snapshot.begin(); i != _snapshot.end();)
+		{
+			if (!i->compact())
+			{
+				_snapshot.erase(i++);
+				continue;
+			}
+
+			// Account for the list node too
+			_memoryUsage += sizeof(UndoableState) + 2 * sizeof(void*) + i->getMemoryUsage();
+			++i;
+		}
+	}
+
+	std::size_t getMemoryUsage() const
+	{
+		return _memoryUsage;
+	}
+
 	void restoreSnapshot()
 	{
 		for (auto& undoablePlusMemento : _snapshot)
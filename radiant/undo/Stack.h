@@ -31,7 +31,13 @@ class UndoStack
 	// undoable saves its data to the stack)
 	OperationPtr _pending;
 
+	// Sum of the memory used by the finished operations
+	std::size_t _memoryUsage;
+
 public:
+	UndoStack() :
+		_memoryUsage(0)
+	{}
 
 	bool empty() const
 	{
@@ -55,17 +61,36 @@ public:
 
 	void pop_front()
 	{
+		_memoryUsage -= _stack.front()->getMemoryUsage();
 		_stack.pop_front();
 	}
 
 	void pop_back()
 	{
+		_memoryUsage -= _stack.back()->getMemoryUsage();
 		_stack.pop_back();
 	}
 
 	void clear()
 	{
 		_stack.clear();
+		_memoryUsage = 0;
+	}
+
+	// Returns the number of bytes used by the finished operations
+	std::size_t getMemoryUsage() const
+	{
+		return _memoryUsage;
+	}
+
+	// Discards the oldest operations until the memory usage is within the
+	// given number of bytes. The most recent operation is always kept.
+	void limitMemoryUsage(std::size_t maxBytes)
+	{
+		while (_memoryUsage > maxBytes && _stack.size() > 1)
+		{
+			pop_front();
+		}
 	}
 
 	// Allocate a new Operation to work with
@@ -97,6 +122,11 @@ public:
 
 		// Rename the last undo operation (it may be "unnamed" till now)
 		_stack.back()->setName(command);
+
+		// Now that the operation is complete, its states can be reduced to the changes
+		_stack.back()->compact();
+		_memoryUsage += _stack.back()->getMemoryUsage();
+
 		return true;
 	}
 
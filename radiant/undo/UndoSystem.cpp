@@ -20,13 +20,15 @@ namespace undo
 namespace
 {
 	const std::string RKEY_UNDO_QUEUE_SIZE = "user/ui/undo/queueSize";
+	const std::string RKEY_UNDO_MEMORY_BUDGET = "user/ui/undo/memoryBudget";
 	const std::size_t MAX_UNDO_LEVELS = 16384;
 }
 
 // Constructor
 UndoSystem::UndoSystem() :
 	_activeUndoStack(nullptr),
-	_undoLevels(64)
+	_undoLevels(64),
+	_memoryBudget(0)
 {}
 
 UndoSystem::~UndoSystem()
@@ -37,6 +39,14 @@ UndoSystem::~UndoSystem()
 void UndoSystem::keyChanged()
 {
 	_undoLevels = registry::getValue<int>(RKEY_UNDO_QUEUE_SIZE);
+
+	// The budget is specified in MB, 0 is unlimited
+	_memoryBudget = static_cast<std::size_t>(registry::getValue<int>(RKEY_UNDO_MEMORY_BUDGET)) * 1024 * 1024;
+
+	if (_memoryBudget > 0)
+	{
+		_undoStack.limitMemoryUsage(_memoryBudget);
+	}
 }
 
 IUndoStateSaver* UndoSystem::getStateSaver(IUndoable& undoable, IMapFileChangeTracker& tracker)
@@ -73,6 +83,11 @@ void UndoSystem::start()
 	trackersBegin();
 }
 
+bool UndoSystem::operationStarted() const
+{
+	return _activeUndoStack != nullptr;
+}
+
 void UndoSystem::cancel()
 {
 	// Try to add the last operation as "temp"
@@ -217,12 +232,15 @@ void UndoSystem::initialiseModule(const ApplicationContext& ctx)
 	GlobalEventManager().addCommand("Undo", "Undo");
 	GlobalEventManager().addCommand("Redo", "Redo");
 
-	_undoLevels = registry::getValue<int>(RKEY_UNDO_QUEUE_SIZE);
+	keyChanged();
 
 	// Add self to the key observers to get notified on change
 	GlobalRegistry().signalForKey(RKEY_UNDO_QUEUE_SIZE).connect(
         sigc::mem_fun(this, &UndoSystem::keyChanged)
     );
+	GlobalRegistry().signalForKey(RKEY_UNDO_MEMORY_BUDGET).connect(
+        sigc::mem_fun(this, &UndoSystem::keyChanged)
+    );
 
 	// add the preference settings
 	constructPreferences();
@@ -280,6 +298,13 @@ bool UndoSystem::finishUndo(const std::string& command)
 {
 	bool changed = _undoStack.finish(command);
 	setActiveUndoStack(nullptr);
+
+	// Drop the oldest operations if the new one exceeds the budget
+	if (changed && _memoryBudget > 0)
+	{
+		_undoStack.limitMemoryUsage(_memoryBudget);
+	}
+
 	return changed;
 }
 
@@ -339,6 +364,7 @@ void UndoSystem::constructPreferences()
 {
 	IPreferencePage& page = GlobalPreferenceSystem().getPage(_("Settings/Undo System"));
 	page.appendSpinner(_("Undo Queue Size"), RKEY_UNDO_QUEUE_SIZE, 0, 1024, 1);
+	page.appendSpinner(_("Undo Memory Budget (MB, 0 = unlimited)"), RKEY_UNDO_MEMORY_BUDGET, 0, 4096, 1);
 }
 
 // Static module instance
@@ -47,6 +47,9 @@ private:
 
 	std::size_t _undoLevels;
 
+	// Maximum number of bytes used by the undo stack, 0 is unlimited
+	std::size_t _memoryBudget;
+
 	typedef std::set<Tracker*> Trackers;
 	Trackers _trackers;
 
@@ -67,6 +70,8 @@ public:
 
 	void start() override;
 
+	bool operationStarted() const override;
+
 	// greebo: This finishes the current operation and
 	// removes it instantly from the stack
 	void cancel() override;
@@ -3,6 +3,7 @@
 #include "iarchive.h"
 #include "stream/FileInputStream.h"
 #include "DeflatedInputStream.h"
+#include <memory>
 
 namespace archive
 {
@@ -12,7 +13,7 @@ class DeflatedArchiveFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _istream;
+	std::unique_ptr<stream::FileInputStream> _istream;
 	stream::SubFileInputStream _substream;	// provides a subset of _istream
 	DeflatedInputStream _zipstream; // inflates data from _subStream
 	stream::FileInputStream::size_type _size;
@@ -22,13 +23,12 @@ public:
 	typedef stream::FileInputStream::position_type position_type;
 
 	DeflatedArchiveFile(const std::string& name,
-						const std::string& archiveName, // path to the ZIP file
-						position_type position,
+						std::unique_ptr<stream::FileInputStream>&& istream, // positioned at the file data
 						size_type stream_size,
 						size_type file_size) :
 		_name(name),
-		_istream(archiveName),
-		_substream(_istream, position, stream_size),
+		_istream(std::move(istream)),
+		_substream(*_istream, _istream->tell(), stream_size),
 		_zipstream(_substream), 
 		_size(file_size)
 	{}
@@ -3,6 +3,8 @@
 #include "iarchive.h"
 #include "iregistry.h"
 #include "stream/BinaryToTextInputStream.h"
+#include "stream/FileInputStream.h"
+#include <memory>
 
 namespace archive
 {
@@ -15,7 +17,7 @@ class DeflatedArchiveTextFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _istream;
+	std::unique_ptr<stream::FileInputStream> _istream;
 	stream::SubFileInputStream _substream;	// reads subset of _istream
 	DeflatedInputStream _zipstream;	// inflates data from _substream
 	stream::BinaryToTextInputStream<DeflatedInputStream> _textStream; // converts data from _zipstream
@@ -34,13 +36,12 @@ public:
      * The name of the mod directory this file's archive is located in.
      */
     DeflatedArchiveTextFile(const std::string& name,
-                            const std::string& archiveName, // full path to ZIP file
+                            std::unique_ptr<stream::FileInputStream>&& istream, // positioned at the file data
                             const std::string& modRoot,
-                            position_type position,
                             size_type stream_size) : 
 		_name(name),
-		_istream(archiveName),
-		_substream(_istream, position, stream_size),
+		_istream(std::move(istream)),
+		_substream(*_istream, _istream->tell(), stream_size),
 		_zipstream(_substream),
 		_textStream(_zipstream),
 		_modRoot(modRoot)
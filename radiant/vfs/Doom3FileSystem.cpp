@@ -30,6 +30,7 @@
 #include "string/encoding.h"
 #include "os/path.h"
 #include "os/dir.h"
+#include "os/file.h"
 
 #include "string/split.h"
 #include "debugging/ScopedDebugTimer.h"
@@ -47,6 +48,8 @@ namespace vfs
 namespace
 {
 
+const char* const ZIP_INDEX_CACHE_FILE = "pk4index.cache";
+
 // Representation of an assets.lst file, containing visibility information for
 // assets within a particular folder.
 class AssetsList
@@ -324,12 +327,22 @@ void Doom3FileSystem::initialise(const SearchPaths& vfsSearchPaths, const Extens
         _allowedExtensionsDir.insert(allowedExtension + "dir");
     }
 
+    if (_zipIndexCache)
+    {
+        _zipIndexCache->load();
+    }
+
     // Initialise the paths, in the given order
     for (const std::string& path : _vfsSearchPaths)
     {
         initDirectory(path);
     }
 
+    if (_zipIndexCache)
+    {
+        _zipIndexCache->save();
+    }
+
     for (Observer* observer : _observers)
     {
         observer->onFileSystemInitialise();
@@ -492,6 +505,31 @@ std::string Doom3FileSystem::findFile(const std::string& name)
     return std::string();
 }
 
+FileStamp Doom3FileSystem::getFileStamp(const std::string& filename)
+{
+    FileStamp stamp;
+
+    // Same search order as openFile()
+    for (const ArchiveDescriptor& descriptor : _archives)
+    {
+        if (!descriptor.archive->containsFile(filename))
+        {
+            continue;
+        }
+
+        std::string physicalPath = descriptor.is_pakfile ? descriptor.name : descriptor.name + filename;
+
+        if (os::getFileSizeAndTime(physicalPath, stamp.size, stamp.modificationTime))
+        {
+            stamp.physicalPath = physicalPath;
+        }
+
+        break;
+    }
+
+    return stamp;
+}
+
 std::string Doom3FileSystem::findRoot(const std::string& name)
 {
     for (const ArchiveDescriptor& descriptor : _archives)
@@ -515,7 +553,7 @@ void Doom3FileSystem::initPakFile(const std::string& filename)
         ArchiveDescriptor entry;
 
         entry.name = filename;
-        entry.archive = std::make_shared<archive::ZipArchive>(filename);
+        entry.archive = std::make_shared<archive::ZipArchive>(filename, _zipIndexCache.get());
         entry.is_pakfile = true;
         _archives.push_back(entry);
 
@@ -563,6 +601,8 @@ const StringSet& Doom3FileSystem::getDependencies() const
 void Doom3FileSystem::initialiseModule(const ApplicationContext& ctx)
 {
     rMessage() << getName() << "::initialiseModule called" << std::endl;
+
+    _zipIndexCache.reset(new archive::ZipIndexCache(ctx.getSettingsPath() + ZIP_INDEX_CACHE_FILE));
 }
 
 void Doom3FileSystem::shutdownModule()
@@ -2,6 +2,8 @@
 
 #include "Archive.h"
 #include "ifilesystem.h"
+#include "ZipIndexCache.h"
+#include <memory>
 
 namespace vfs
 {
@@ -30,6 +32,9 @@ private:
 	typedef std::set<Observer*> ObserverList;
 	ObserverList _observers;
 
+	// Central directories of the PK4s seen in the previous session
+	std::unique_ptr<archive::ZipIndexCache> _zipIndexCache;
+
 public:
 	void initialise(const SearchPaths& vfsSearchPaths, const ExtensionSet& allowedExtensions) override;
 	void shutdown() override;
@@ -52,6 +57,7 @@ public:
 		std::size_t depth = 1) override;
 
 	std::string findFile(const std::string& name) override;
+	FileStamp getFileStamp(const std::string& filename) override;
 	std::string findRoot(const std::string& name) override;
 
 	void addObserver(Observer& observer) override;
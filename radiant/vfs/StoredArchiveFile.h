@@ -1,6 +1,8 @@
 #pragma once
 
 #include "iarchive.h"
+#include "stream/FileInputStream.h"
+#include <memory>
 
 namespace archive
 {
@@ -11,7 +13,7 @@ class StoredArchiveFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _filestream;
+	std::unique_ptr<stream::FileInputStream> _filestream;
 	stream::SubFileInputStream _substream;	// provides a subset of _filestream
 	stream::FileInputStream::size_type _size;
 
@@ -20,13 +22,12 @@ public:
 	typedef stream::FileInputStream::position_type position_type;
 
 	StoredArchiveFile(const std::string& name,
-					  const std::string& archiveName, // full path to the archive file
-					  position_type position,
+					  std::unique_ptr<stream::FileInputStream>&& filestream, // positioned at the file data
 					  size_type stream_size,
 					  size_type file_size) : 
 		_name(name),
-		_filestream(archiveName),
-		_substream(_filestream, position, stream_size),
+		_filestream(std::move(filestream)),
+		_substream(*_filestream, _filestream->tell(), stream_size),
 		_size(file_size)
 	{}
 
@@ -2,6 +2,8 @@
 
 #include "iarchive.h"
 #include "stream/BinaryToTextInputStream.h"
+#include "stream/FileInputStream.h"
+#include <memory>
 
 namespace archive
 {
@@ -12,7 +14,7 @@ class StoredArchiveTextFile :
 {
 private:
 	std::string _name;
-	stream::FileInputStream _filestream;
+	std::unique_ptr<stream::FileInputStream> _filestream;
 	stream::SubFileInputStream _substream; // provides a subset of _filestream
 	stream::BinaryToTextInputStream<stream::SubFileInputStream> _textStream; // converts data from _substream
 
@@ -29,13 +31,12 @@ public:
 	* Name of the mod directory containing this file.
 	*/
 	StoredArchiveTextFile(const std::string& name,
-						  const std::string& archiveName,
+						  std::unique_ptr<stream::FileInputStream>&& filestream, // positioned at the file data
 						  const std::string& modRoot,
-						  position_type position,
 						  size_type stream_size) : 
 		_name(name),
-		_filestream(archiveName),
-		_substream(_filestream, position, stream_size),
+		_filestream(std::move(filestream)),
+		_substream(*_filestream, _filestream->tell(), stream_size),
 		_textStream(_substream),
 		_modRoot(modRoot)
 	{}
@@ -29,25 +29,53 @@ public:
 };
 
 
-ZipArchive::ZipArchive(const std::string& fullPath) :
+ZipArchive::ZipArchive(const std::string& fullPath, ZipIndexCache* indexCache) :
 	_fullPath(fullPath),
-	_containingFolder(os::standardPathWithSlash(fs::path(_fullPath).remove_filename())),
-	_istream(_fullPath)
+	_containingFolder(os::standardPathWithSlash(fs::path(_fullPath).remove_filename()))
 {
-	if (_istream.failed())
+	ZipIndexCache::Records records;
+
+	// The archive didn't change since the last run, no need to scan it
+	if (indexCache != nullptr && indexCache->lookup(_fullPath, records))
+	{
+		for (const ZipIndexCache::Record& record : records)
+		{
+			insertRecord(record);
+		}
+
+		return;
+	}
+
+	stream::FileInputStream istream(_fullPath);
+
+	if (istream.failed())
 	{
 		rError() << "Cannot open Zip file stream: " << _fullPath << std::endl;
 		return;
 	}
 
+	bool success = true;
+
 	try
 	{
 		// Try loading the zip file, this will throw exceptoions on any problem
-		loadZipFile();
+		loadZipFile(istream, records);
 	}
 	catch (ZipFailureException& ex)
 	{
 		rError() << "Cannot read Zip file " << _fullPath << ": " << ex.what() << std::endl;
+		success = false;
+	}
+
+	// Keep the records which could be read before any failure
+	for (const ZipIndexCache::Record& record : records)
+	{
+		insertRecord(record);
+	}
+
+	if (success && indexCache != nullptr)
+	{
+		indexCache->store(_fullPath, records);
 	}
 }
 
@@ -56,6 +84,32 @@ ZipArchive::~ZipArchive()
 	_filesystem.clear();
 }
 
+std::unique_ptr<stream::FileInputStream> ZipArchive::openDataStream(const ZipRecord& file)
+{
+	// Every file gets its own handle, concurrent reads don't need to share a stream position
+	std::unique_ptr<stream::FileInputStream> istream(new stream::FileInputStream(_fullPath));
+
+	if (istream->failed())
+	{
+		rError() << "Cannot open Zip file stream: " << _fullPath << std::endl;
+		return std::unique_ptr<stream::FileInputStream>();
+	}
+
+	istream->seek(file.position);
+
+	// Skip the local file header, the stream is then positioned at the data
+	ZipFileHeader header;
+	stream::readZipFileHeader(*istream, header);
+
+	if (header.magic != ZIP_MAGIC_FILE_HEADER)
+	{
+		rError() << "Error reading zip file " << _fullPath << std::endl;
+		return std::unique_ptr<stream::FileInputStream>();
+	}
+
+	return istream;
+}
+
 ArchiveFilePtr ZipArchive::openFile(const std::string& name)
 {
 	ZipFileSystem::iterator i = _filesystem.find(name);
@@ -64,32 +118,19 @@ ArchiveFilePtr ZipArchive::openFile(const std::string& name)
 	{
 		const std::shared_ptr<ZipRecord>& file = i->second.getRecord();
 
-		stream::FileInputStream::size_type position = 0;
+		std::unique_ptr<stream::FileInputStream> istream = openDataStream(*file);
 
+		if (!istream)
 		{
-			// Guard against concurrent access
-			std::lock_guard<std::mutex> lock(_streamLock);
-
-			_istream.seek(file->position);
-
-			ZipFileHeader header;
-			stream::readZipFileHeader(_istream, header);
-
-			position = _istream.tell();
-
-			if (header.magic != ZIP_MAGIC_FILE_HEADER)
-			{
-				rError() << "Error reading zip file " << _fullPath << std::endl;
-				return ArchiveFilePtr();
-			}
+			return ArchiveFilePtr();
 		}
 
 		switch (file->mode)
 		{
 		case ZipRecord::eStored:
-			return std::make_shared<StoredArchiveFile>(name, _fullPath, position, file->stream_size, file->file_size);
+			return std::make_shared<StoredArchiveFile>(name, std::move(istream), file->stream_size, file->file_size);
 		case ZipRecord::eDeflated:
-			return std::make_shared<DeflatedArchiveFile>(name, _fullPath, position, file->stream_size, file->file_size);
+			return std::make_shared<DeflatedArchiveFile>(name, std::move(istream), file->stream_size, file->file_size);
 		}
 	}
 
@@ -104,17 +145,10 @@ ArchiveTextFilePtr ZipArchive::openTextFile(const std::string& name)
 	{
 		const std::shared_ptr<ZipRecord>& file = i->second.getRecord();
 
-		// Guard against concurrent access
-		std::lock_guard<std::mutex> lock(_streamLock);
-
-		_istream.seek(file->position);
-
-		ZipFileHeader header;
-		stream::readZipFileHeader(_istream, header);
+		std::unique_ptr<stream::FileInputStream> istream = openDataStream(*file);
 
-		if (header.magic != ZIP_MAGIC_FILE_HEADER)
+		if (!istream)
 		{
-			rError() << "Error reading zip file " << _fullPath << std::endl;
 			return ArchiveTextFilePtr();
 		}
 
@@ -122,12 +156,12 @@ ArchiveTextFilePtr ZipArchive::openTextFile(const std::string& name)
 		{
 		case ZipRecord::eStored:
 			return std::make_shared<StoredArchiveTextFile>(
-                name, _fullPath, _containingFolder, _istream.tell(), file->stream_size
+                name, std::move(istream), _containingFolder, file->stream_size
             );
 
 		case ZipRecord::eDeflated:
 			return std::make_shared<DeflatedArchiveTextFile>(
-                name, _fullPath, _containingFolder, _istream.tell(), file->stream_size
+                name, std::move(istream), _containingFolder, file->stream_size
             );
 		}
 	}
@@ -146,10 +180,10 @@ void ZipArchive::traverse(Visitor& visitor, const std::string& root)
 	_filesystem.traverse(visitor, root);
 }
 
-void ZipArchive::readZipRecord()
+void ZipArchive::readZipRecord(stream::FileInputStream& istream, ZipIndexCache::Record& record)
 {
 	ZipMagic magic;
-	stream::readZipMagic(_istream, magic);
+	stream::readZipMagic(istream, magic);
 
 	if (magic != ZIP_MAGIC_ROOT_DIR_ENTRY)
 	{
@@ -157,40 +191,40 @@ void ZipArchive::readZipRecord()
 	}
 
 	ZipVersion version_encoder;
-	stream::readZipVersion(_istream, version_encoder);
+	stream::readZipVersion(istream, version_encoder);
 	ZipVersion version_extract;
-	stream::readZipVersion(_istream, version_extract);
+	stream::readZipVersion(istream, version_extract);
 
 	//unsigned short flags =
-	stream::readLittleEndian<int16_t>(_istream);
+	stream::readLittleEndian<int16_t>(istream);
 	
-	uint16_t compression_mode = stream::readLittleEndian<uint16_t>(_istream);
+	record.compressionMode = stream::readLittleEndian<uint16_t>(istream);
 
-	if (compression_mode != Z_DEFLATED && compression_mode != 0)
+	if (record.compressionMode != Z_DEFLATED && record.compressionMode != 0)
 	{
 		throw ZipFailureException("Unsupported compression mode");
 	}
 
 	ZipDosTime dostime;
-	stream::readZipDosTime(_istream, dostime);
+	stream::readZipDosTime(istream, dostime);
 
 	//unsigned int crc32 =
-	stream::readLittleEndian<uint32_t>(_istream);
+	stream::readLittleEndian<uint32_t>(istream);
 	
-	uint32_t compressed_size = stream::readLittleEndian<uint32_t>(_istream);
-	uint32_t uncompressed_size = stream::readLittleEndian<uint32_t>(_istream);
-	uint16_t namelength = stream::readLittleEndian<uint16_t>(_istream);
-	uint16_t extras = stream::readLittleEndian<uint16_t>(_istream);
-	uint16_t comment = stream::readLittleEndian<uint16_t>(_istream);
+	record.compressedSize = stream::readLittleEndian<uint32_t>(istream);
+	record.uncompressedSize = stream::readLittleEndian<uint32_t>(istream);
+	uint16_t namelength = stream::readLittleEndian<uint16_t>(istream);
+	uint16_t extras = stream::readLittleEndian<uint16_t>(istream);
+	uint16_t comment = stream::readLittleEndian<uint16_t>(istream);
 
 	//unsigned short diskstart =
-	stream::readLittleEndian<uint16_t>(_istream);
+	stream::readLittleEndian<uint16_t>(istream);
 	//unsigned short filetype =
-	stream::readLittleEndian<uint16_t>(_istream);
+	stream::readLittleEndian<uint16_t>(istream);
 	//unsigned int filemode =
-	stream::readLittleEndian<uint32_t>(_istream);
+	stream::readLittleEndian<uint32_t>(istream);
 
-	uint32_t position = stream::readLittleEndian<uint32_t>(_istream);
+	record.position = stream::readLittleEndian<uint32_t>(istream);
 
 	// greebo: Read the filename directly into a newly constructed std::string.
 
@@ -199,60 +233,68 @@ void ZipArchive::readZipRecord()
 	// only to let its contents end up being copied by the std::string anyway.
 	// Alternative: use a static std::shared_array here, resized to fit?
 
-	std::string path(namelength, '\0');
+	record.path.assign(namelength, '\0');
 
-	_istream.read(
-		reinterpret_cast<stream::FileInputStream::byte_type*>(const_cast<char*>(path.data())),
+	istream.read(
+		reinterpret_cast<stream::FileInputStream::byte_type*>(const_cast<char*>(record.path.data())),
 		namelength);
 
-	_istream.seek(extras + comment, stream::FileInputStream::cur);
+	istream.seek(extras + comment, stream::FileInputStream::cur);
+}
 
-	if (os::isDirectory(path))
+void ZipArchive::insertRecord(const ZipIndexCache::Record& record)
+{
+	if (os::isDirectory(record.path))
 	{
-		_filesystem[path].getRecord().reset();
+		_filesystem[record.path].getRecord().reset();
 	}
 	else
 	{
-		ZipFileSystem::entry_type& entry = _filesystem[path];
+		ZipFileSystem::entry_type& entry = _filesystem[record.path];
 
 		if (!entry.isDirectory())
 		{
-			rWarning() << "Zip archive " << _fullPath << " contains duplicated file: " << path << std::endl;
+			rWarning() << "Zip archive " << _fullPath << " contains duplicated file: " << record.path << std::endl;
 		}
 		else
 		{
-			entry.getRecord().reset(new ZipRecord(position,
-				compressed_size,
-				uncompressed_size,
-				(compression_mode == Z_DEFLATED) ? ZipRecord::eDeflated : ZipRecord::eStored));
+			entry.getRecord().reset(new ZipRecord(record.position,
+				record.compressedSize,
+				record.uncompressedSize,
+				(record.compressionMode == Z_DEFLATED) ? ZipRecord::eDeflated : ZipRecord::eStored));
 		}
 	}
 }
 
-void ZipArchive::loadZipFile()
+void ZipArchive::loadZipFile(stream::FileInputStream& istream, ZipIndexCache::Records& records)
 {
-	SeekableStream::position_type pos = findZipDiskTrailerPosition(_istream);
+	SeekableStream::position_type pos = findZipDiskTrailerPosition(istream);
 
 	if (pos == 0)
 	{
 		throw ZipFailureException("Unable to locate Zip disk trailer");
 	}
 
-	_istream.seek(pos);
+	istream.seek(pos);
 
 	ZipDiskTrailer trailer;
-	stream::readZipDiskTrailer(_istream, trailer);
+	stream::readZipDiskTrailer(istream, trailer);
 
 	if (trailer.magic != ZIP_MAGIC_DISK_TRAILER)
 	{
 		throw ZipFailureException("Invalid Zip Magic, maybe this is not a zip file?");
 	}
 
-	_istream.seek(trailer.rootseek);
+	istream.seek(trailer.rootseek);
+
+	records.reserve(trailer.entries);
 
 	for (unsigned short i = 0; i < trailer.entries; ++i)
 	{
-		readZipRecord();
+		ZipIndexCache::Record record;
+		readZipRecord(istream, record);
+
+		records.push_back(record);
 	}
 }
 
@@ -3,7 +3,8 @@
 #include "iarchive.h"
 #include "GenericFileSystem.h"
 #include "stream/FileInputStream.h"
-#include <mutex>
+#include "ZipIndexCache.h"
+#include <memory>
 
 namespace archive
 {
@@ -16,6 +17,10 @@ namespace archive
  * physical directories.
  *
  * Archives are owned and instantiated by the GlobalFileSystem instance.
+ *
+ * The archive doesn't keep a shared file handle, every opened file gets
+ * its own stream. Files can therefore be opened and read concurrently
+ * without any locking.
  */
 class ZipArchive :
 	public Archive
@@ -51,11 +56,10 @@ private:
 	std::string _fullPath;			// the full path to the Zip file
 	std::string _containingFolder;  // the folder this Zip is located in
 	mutable std::string _modName;	// mod name, calculated based on the containing folder
-	stream::FileInputStream _istream;
-    std::mutex _streamLock;
 
 public:
-	ZipArchive(const std::string& fullPath);
+	// Pass an index cache to re-use the central directory of a previous run
+	ZipArchive(const std::string& fullPath, ZipIndexCache* indexCache = nullptr);
 	virtual ~ZipArchive();
 
 	// Archive implementation
@@ -65,8 +69,12 @@ public:
 	void traverse(Visitor& visitor, const std::string& root) override;
 
 private:
-	void readZipRecord();
-	void loadZipFile();
+	// Opens a new stream, positioned at the data of the given file (or returns an empty pointer)
+	std::unique_ptr<stream::FileInputStream> openDataStream(const ZipRecord& file);
+
+	void readZipRecord(stream::FileInputStream& istream, ZipIndexCache::Record& record);
+	void loadZipFile(stream::FileInputStream& istream, ZipIndexCache::Records& records);
+	void insertRecord(const ZipIndexCache::Record& record);
 };
 
 }
@@ -0,0 +1,273 @@
+#include "ZipIndexCache.h"
+
+#include <fstream>
+#include "itextstream.h"
+#include "os/fs.h"
+#include "os/file.h"
+#include "stream/utils.h"
+
+namespace archive
+{
+
+namespace
+{
+	const char* const CACHE_MAGIC = "DRZI";
+	const uint32_t CACHE_VERSION = 1;
+
+	// Reads a little endian value, returns false if the stream ran out of data
+	template<typename ValueType>
+	bool readValue(std::istream& stream, ValueType& value)
+	{
+		stream.read(reinterpret_cast<char*>(&value), sizeof(ValueType));
+
+#ifdef __BIG_ENDIAN__
+		std::reverse(reinterpret_cast<char*>(&value), reinterpret_cast<char*>(&value) + sizeof(ValueType));
+#endif
+
+		return !stream.fail();
+	}
+
+	// The smallest possible sizes of the serialised structures, used to reject
+	// counts which cannot be satisfied by the rest of the file
+	const std::size_t MIN_RECORD_SIZE = 4 + 4 + 4 + 4 + 2;
+	const std::size_t MIN_ARCHIVE_SIZE = 4 + 8 + 8 + 4;
+
+	// The number of bytes left in the given stream, 0 if the stream is in a failed state
+	std::size_t getRemainingBytes(std::istream& stream)
+	{
+		std::istream::pos_type position = stream.tellg();
+
+		if (position == std::istream::pos_type(-1))
+		{
+			return 0;
+		}
+
+		stream.seekg(0, std::ios::end);
+		std::istream::pos_type end = stream.tellg();
+		stream.seekg(position);
+
+		return end > position ? static_cast<std::size_t>(end - position) : 0;
+	}
+
+	// Checks that the stream holds at least count elements of the given minimum size,
+	// the stream is put into a failed state otherwise
+	bool checkRemainingBytes(std::istream& stream, std::size_t count, std::size_t elementSize)
+	{
+		if (count > getRemainingBytes(stream) / elementSize)
+		{
+			stream.setstate(std::ios::failbit);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool readString(std::istream& stream, std::string& str)
+	{
+		uint32_t length = 0;
+
+		if (!readValue(stream, length) || !checkRemainingBytes(stream, length, 1))
+		{
+			return false;
+		}
+
+		str.resize(length);
+		stream.read(&str[0], length);
+
+		return !stream.fail();
+	}
+
+	void writeString(std::ostream& stream, const std::string& str)
+	{
+		stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(str.length()));
+		stream.write(str.data(), str.length());
+	}
+}
+
+ZipIndexCache::ZipIndexCache(const std::string& cacheFile) :
+	_cacheFile(cacheFile),
+	_changed(false)
+{}
+
+void ZipIndexCache::load()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_loadedIndices.clear();
+	_usedIndices.clear();
+	_changed = false;
+
+	std::ifstream stream(_cacheFile, std::ios::binary);
+
+	if (!stream)
+	{
+		return; // no cache yet
+	}
+
+	char magic[4];
+	stream.read(magic, sizeof(magic));
+
+	uint32_t version = 0;
+	uint32_t numArchives = 0;
+
+	if (!stream || std::string(magic, sizeof(magic)) != CACHE_MAGIC ||
+		!readValue(stream, version) || version != CACHE_VERSION ||
+		!readValue(stream, numArchives) || !checkRemainingBytes(stream, numArchives, MIN_ARCHIVE_SIZE))
+	{
+		rWarning() << "Ignoring incompatible PK4 index cache " << _cacheFile << std::endl;
+		return;
+	}
+
+	for (uint32_t i = 0; i < numArchives; ++i)
+	{
+		std::string archivePath;
+		ArchiveIndex index;
+		uint32_t numRecords = 0;
+
+		if (!readString(stream, archivePath) || !readValue(stream, index.fileSize) ||
+			!readValue(stream, index.modificationTime) || !readValue(stream, numRecords) ||
+			!checkRemainingBytes(stream, numRecords, MIN_RECORD_SIZE))
+		{
+			break;
+		}
+
+		index.records.resize(numRecords);
+
+		for (Record& record : index.records)
+		{
+			if (!readString(stream, record.path) || !readValue(stream, record.position) ||
+				!readValue(stream, record.compressedSize) || !readValue(stream, record.uncompressedSize) ||
+				!readValue(stream, record.compressionMode))
+			{
+				break;
+			}
+		}
+
+		if (!stream)
+		{
+			break;
+		}
+
+		_loadedIndices[archivePath] = std::move(index);
+	}
+
+	if (!stream)
+	{
+		rWarning() << "PK4 index cache " << _cacheFile << " is truncated, discarding it" << std::endl;
+		_loadedIndices.clear();
+	}
+}
+
+void ZipIndexCache::save()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	// Archives which have been removed since the last run need to be dropped too
+	if (!_changed && _usedIndices.size() == _loadedIndices.size())
+	{
+		return;
+	}
+
+	// Write to a temporary file first, a crash must not leave a corrupt cache behind
+	std::string tempFile = _cacheFile + ".tmp";
+
+	{
+		std::ofstream stream(tempFile, std::ios::binary);
+
+		if (!stream)
+		{
+			rError() << "Cannot write PK4 index cache " << tempFile << std::endl;
+			return;
+		}
+
+		stream.write(CACHE_MAGIC, 4);
+		stream::writeLittleEndian<uint32_t>(stream, CACHE_VERSION);
+		stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(_usedIndices.size()));
+
+		for (const ArchiveIndices::value_type& pair : _usedIndices)
+		{
+			writeString(stream, pair.first);
+			stream::writeLittleEndian<uint64_t>(stream, pair.second.fileSize);
+			stream::writeLittleEndian<int64_t>(stream, pair.second.modificationTime);
+			stream::writeLittleEndian<uint32_t>(stream, static_cast<uint32_t>(pair.second.records.size()));
+
+			for (const Record& record : pair.second.records)
+			{
+				writeString(stream, record.path);
+				stream::writeLittleEndian<uint32_t>(stream, record.position);
+				stream::writeLittleEndian<uint32_t>(stream, record.compressedSize);
+				stream::writeLittleEndian<uint32_t>(stream, record.uncompressedSize);
+				stream::writeLittleEndian<uint16_t>(stream, record.compressionMode);
+			}
+		}
+
+		if (!stream)
+		{
+			rError() << "Failed to write PK4 index cache " << tempFile << std::endl;
+			return;
+		}
+	}
+
+	try
+	{
+		if (fs::exists(_cacheFile))
+		{
+			fs::remove(_cacheFile);
+		}
+
+		fs::rename(tempFile, _cacheFile);
+	}
+	catch (fs::filesystem_error& ex)
+	{
+		rError() << "Cannot replace PK4 index cache " << _cacheFile << ": " << ex.what() << std::endl;
+		return;
+	}
+
+	_loadedIndices = _usedIndices;
+	_changed = false;
+}
+
+bool ZipIndexCache::lookup(const std::string& archivePath, Records& records)
+{
+	uint64_t fileSize = 0;
+	int64_t modificationTime = 0;
+
+	if (!os::getFileSizeAndTime(archivePath, fileSize, modificationTime))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	ArchiveIndices::const_iterator found = _loadedIndices.find(archivePath);
+
+	if (found == _loadedIndices.end() || found->second.fileSize != fileSize ||
+		found->second.modificationTime != modificationTime)
+	{
+		return false;
+	}
+
+	records = found->second.records;
+	_usedIndices[archivePath] = found->second;
+
+	return true;
+}
+
+void ZipIndexCache::store(const std::string& archivePath, const Records& records)
+{
+	ArchiveIndex index;
+
+	if (!os::getFileSizeAndTime(archivePath, index.fileSize, index.modificationTime))
+	{
+		return;
+	}
+
+	index.records = records;
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_usedIndices[archivePath] = index;
+	_changed = true;
+}
+
+}
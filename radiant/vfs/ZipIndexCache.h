@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace archive
+{
+
+/**
+ * Persistent cache of the central directories of PK4 archives, to avoid
+ * scanning every archive on each startup. The index of an archive is keyed
+ * on its full path and is considered up to date as long as the size and
+ * the modification time of the archive file don't change.
+ *
+ * Indices of archives which haven't been looked up or stored since load()
+ * are dropped when the cache is saved.
+ */
+class ZipIndexCache
+{
+public:
+	// A file or directory entry as listed in the central directory
+	struct Record
+	{
+		std::string path;
+		uint32_t position;
+		uint32_t compressedSize;
+		uint32_t uncompressedSize;
+		uint16_t compressionMode;
+	};
+	typedef std::vector<Record> Records;
+
+private:
+	struct ArchiveIndex
+	{
+		uint64_t fileSize;
+		int64_t modificationTime;
+		Records records;
+	};
+	typedef std::map<std::string, ArchiveIndex> ArchiveIndices;
+
+	std::string _cacheFile;
+
+	// The indices read from the cache file
+	ArchiveIndices _loadedIndices;
+
+	// The indices which have been used since load()
+	ArchiveIndices _usedIndices;
+
+	bool _changed;
+
+	std::mutex _lock;
+
+public:
+	ZipIndexCache(const std::string& cacheFile);
+
+	// Reads the cache file, a missing or invalid file results in an empty cache
+	void load();
+
+	// Writes all indices used since load() back to the cache file, if anything changed
+	void save();
+
+	// Fills in the records of the given archive and returns true if the cached index is up to date
+	bool lookup(const std::string& archivePath, Records& records);
+
+	// Stores the index of the given archive, to be written on save()
+	void store(const std::string& archivePath, const Records& records);
+};
+
+}